@@ -37,6 +37,11 @@ endif()
 if("bq25713" IN_LIST DRIVERS_PICKED_COMPONENTS)
     list(APPEND TeufelDrivers_SOURCES ${DRIVERS_PATH}/bq25713/bq25713.c)
     list(APPEND TeufelDrivers_INCLUDE_DIR ${DRIVERS_PATH}/bq25713)
+    if (TEUFEL_TESTS_ENABLED)
+        file(GLOB BQ25713_TESTS ${DRIVERS_PATH}/bq25713/tests/*.c)
+        list(APPEND TeufelDrivers_SOURCES ${BQ25713_TESTS})
+        list(APPEND TeufelDrivers_INCLUDE_DIR ${DRIVERS_PATH}/bq25713/tests)
+    endif()
 endif()
 
 if("button" IN_LIST DRIVERS_PICKED_COMPONENTS)
@@ -55,6 +60,11 @@ if("STM32_vEEPROM" IN_LIST DRIVERS_PICKED_COMPONENTS)
     list(APPEND TeufelDrivers_SOURCES ${DRIVERS_PATH}/STM32_vEEPROM/eeprom.c)
     list(APPEND TeufelDrivers_SOURCES ${DRIVERS_PATH}/STM32_vEEPROM/virtual_eeprom.c)
     list(APPEND TeufelDrivers_INCLUDE_DIR ${DRIVERS_PATH}/STM32_vEEPROM)
+    if (TEUFEL_TESTS_ENABLED)
+        file(GLOB VEEPROM_TESTS ${DRIVERS_PATH}/STM32_vEEPROM/tests/*.c)
+        list(APPEND TeufelDrivers_SOURCES ${VEEPROM_TESTS})
+        list(APPEND TeufelDrivers_INCLUDE_DIR ${DRIVERS_PATH}/STM32_vEEPROM/tests)
+    endif()
 endif()
 
 if("tas5805m" IN_LIST DRIVERS_PICKED_COMPONENTS)
@@ -74,6 +84,11 @@ endif()
 if("tps25751" IN_LIST DRIVERS_PICKED_COMPONENTS)
     list(APPEND TeufelDrivers_SOURCES ${DRIVERS_PATH}/tps25751/tps25751.c)
     list(APPEND TeufelDrivers_INCLUDE_DIR ${DRIVERS_PATH}/tps25751)
+    if (TEUFEL_TESTS_ENABLED)
+        file(GLOB TPS25751_TESTS ${DRIVERS_PATH}/tps25751/tests/*.c)
+        list(APPEND TeufelDrivers_SOURCES ${TPS25751_TESTS})
+        list(APPEND TeufelDrivers_INCLUDE_DIR ${DRIVERS_PATH}/tps25751/tests)
+    endif()
 endif()
 
 
@@ -44,309 +44,96 @@
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
+
+/* Offsets of the ring page header halfwords */
+#define HEADER_STATUS         ((uint32_t)0) /* RING_PAGE, programmed last when the page is opened */
+#define HEADER_ERASE_COUNT    ((uint32_t)2) /* Programmed right after the page erase */
+#define HEADER_SEQUENCE       ((uint32_t)4) /* Incremented for every opened page */
+#define HEADER_OBSOLETE       ((uint32_t)6) /* OBSOLETE_PAGE before the page erase */
+
+/* Number of records fitting into one page */
+#define PAGE_RECORDS          ((PAGE_SIZE - PAGE_HEADER_SIZE) / 4)
+
 /* Private macro -------------------------------------------------------------*/
-/* Private variables ---------------------------------------------------------*/
+#define PAGE_ADDRESS(page)    ((uint32_t)(EEPROM_START_ADDRESS + ((uint32_t)(page) * PAGE_SIZE)))
+#define PAGE_HEADER(page, offset) (*(__IO uint16_t*)(PAGE_ADDRESS(page) + (offset)))
+#define NEXT_PAGE(page)       ((uint16_t)(((page) + 1) % EEPROM_PAGES))
+#define PREVIOUS_PAGE(page)   ((uint16_t)(((page) + EEPROM_PAGES - 1) % EEPROM_PAGES))
 
-/* Global variable used to store variable value in read sequence */
-uint16_t DataVar = 0;
+/* Private variables ---------------------------------------------------------*/
 
 /* Virtual address defined by the user: 0xFFFF value is prohibited */
 extern uint16_t VirtAddVarTab[NB_OF_VAR];
 
+/* Ring state, rebuilt from the page headers by EE_Init.
+   The used pages are the head page and the UsedPages - 1 pages before it. */
+static uint16_t HeadPage = 0;
+static uint16_t HeadSequence = 0;
+static uint16_t UsedPages = 0;
+
+/* First free record of the head page */
+static uint32_t WriteAddress = 0;
+
+/* Next VirtAddVarTab entry checked by the transfer of the tail page */
+static uint16_t TransferIndex = 0;
+
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
-static HAL_StatusTypeDef EE_Format(void);
-static uint16_t EE_FindValidPage(uint8_t Operation);
-static uint16_t EE_VerifyPageFullWriteVariable(uint16_t VirtAddress, uint16_t Data);
-static uint16_t EE_PageTransfer(uint16_t VirtAddress, uint16_t Data);
-static uint16_t EE_VerifyPageFullyErased(uint32_t Address);
+static uint16_t EE_Migrate(void);
+static uint16_t EE_FinishLegacyTransfer(uint16_t ValidPage, uint16_t ReceivePage);
+static uint16_t EE_ScanRing(void);
+static uint16_t EE_ErasePage(uint16_t Page);
+static uint16_t EE_OpenPage(uint16_t Page);
+static uint16_t EE_Reserve(uint16_t Records);
+static uint16_t EE_TransferStep(void);
+static uint16_t EE_ProgramRecord(uint16_t VirtAddress, uint16_t Data);
+static uint16_t EE_LocateVariable(uint16_t VirtAddress, uint16_t* Data);
+static uint16_t EE_VerifyRangeErased(uint32_t Address, uint32_t EndAddress);
+static uint16_t EE_MaxEraseCount(void);
+static uint32_t EE_FindFreeRecord(uint32_t Address, uint32_t EndAddress);
+static uint32_t EE_FindOpenBatch(uint32_t Address, uint32_t EndAddress);
+static uint16_t EE_RecoverBatch(void);
+static void EE_ScanRecords(uint32_t StartAddress, uint32_t EndAddress, const uint16_t* VirtAddress,
+                           uint16_t* Data, uint16_t Count, uint32_t* Found);
 
 /**
   * @brief  Restore the pages to a known good state in case of page's status
-  *   corruption after a power loss.
+  *   corruption after a power loss. Pages in the legacy two page layout are
+  *   migrated to the ring layout.
   * @param  None.
   * @retval - Flash error code: on write Flash error
   *         - FLASH_COMPLETE: on success
   */
 uint16_t EE_Init(void)
 {
-  uint16_t pagestatus0 = 6, pagestatus1 = 6;
-  uint16_t varidx = 0;
-  uint16_t eepromstatus = 0, readstatus = 0;
-  int16_t x = -1;
-  HAL_StatusTypeDef  flashstatus;
-  uint32_t page_error = 0;
-  FLASH_EraseInitTypeDef s_eraseinit;
+  uint16_t status = HAL_OK;
 
-
-  /* Get Page0 status */
-  pagestatus0 = (*(__IO uint16_t*)PAGE0_BASE_ADDRESS);
-  /* Get Page1 status */
-  pagestatus1 = (*(__IO uint16_t*)PAGE1_BASE_ADDRESS);
-
-  /* Fill EraseInit structure*/
-  s_eraseinit.TypeErase   = FLASH_TYPEERASE_PAGES;
-  s_eraseinit.PageAddress = PAGE0_BASE_ADDRESS;
-  s_eraseinit.NbPages     = 1;
-  
-  /* Check for invalid header states and repair if necessary */
-  switch (pagestatus0)
+  /* Convert the pages of the legacy two page layout */
+  status = EE_Migrate();
+  if (status != HAL_OK)
   {
-    case ERASED:
-      if (pagestatus1 == VALID_PAGE) /* Page0 erased, Page1 valid */
-      {
-          /* Erase Page0 */
-        if(!EE_VerifyPageFullyErased(PAGE0_BASE_ADDRESS))
-        {
-          flashstatus = HAL_FLASHEx_Erase(&s_eraseinit, &page_error);
-          /* If erase operation was failed, a Flash error code is returned */
-          if (flashstatus != HAL_OK)
-          {
-            return flashstatus;
-          }
-        }
-      }
-      else if (pagestatus1 == RECEIVE_DATA) /* Page0 erased, Page1 receive */
-      {
-        /* Erase Page0 */
-        if(!EE_VerifyPageFullyErased(PAGE0_BASE_ADDRESS))
-        { 
-          flashstatus = HAL_FLASHEx_Erase(&s_eraseinit, &page_error);
-          /* If erase operation was failed, a Flash error code is returned */
-          if (flashstatus != HAL_OK)
-          {
-            return flashstatus;
-          }
-        }
-        /* Mark Page1 as valid */
-        flashstatus = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, PAGE1_BASE_ADDRESS, VALID_PAGE);
-        /* If program operation was failed, a Flash error code is returned */
-        if (flashstatus != HAL_OK)
-        {
-          return flashstatus;
-        }
-      }
-      else /* First EEPROM access (Page0&1 are erased) or invalid state -> format EEPROM */
-      {
-        /* Erase both Page0 and Page1 and set Page0 as valid page */
-        flashstatus = EE_Format();
-        /* If erase/program operation was failed, a Flash error code is returned */
-        if (flashstatus != HAL_OK)
-        {
-          return flashstatus;
-        }
-      }
-      break;
-
-    case RECEIVE_DATA:
-      if (pagestatus1 == VALID_PAGE) /* Page0 receive, Page1 valid */
-      {
-        /* Transfer data from Page1 to Page0 */
-        for (varidx = 0; varidx < NB_OF_VAR; varidx++)
-        {
-          if (( *(__IO uint16_t*)(PAGE0_BASE_ADDRESS + 6)) == VirtAddVarTab[varidx])
-          {
-            x = varidx;
-          }
-          if (varidx != x)
-          {
-            /* Read the last variables' updates */
-            readstatus = EE_ReadVariable(VirtAddVarTab[varidx], &DataVar);
-            /* In case variable corresponding to the virtual address was found */
-            if (readstatus != 0x1)
-            {
-              /* Transfer the variable to the Page0 */
-              eepromstatus = EE_VerifyPageFullWriteVariable(VirtAddVarTab[varidx], DataVar);
-              /* If program operation was failed, a Flash error code is returned */
-              if (eepromstatus != HAL_OK)
-              {
-                return eepromstatus;
-              }
-            }
-          }
-        }
-        /* Mark Page0 as valid */
-        flashstatus = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, PAGE0_BASE_ADDRESS, VALID_PAGE);
-        /* If program operation was failed, a Flash error code is returned */
-        if (flashstatus != HAL_OK)
-        {
-          return flashstatus;
-        }
-        s_eraseinit.TypeErase   = FLASH_TYPEERASE_PAGES;
-        s_eraseinit.PageAddress = PAGE1_BASE_ADDRESS;
-        s_eraseinit.NbPages     = 1;
-        /* Erase Page1 */
-        if(!EE_VerifyPageFullyErased(PAGE1_BASE_ADDRESS))
-        { 
-          flashstatus = HAL_FLASHEx_Erase(&s_eraseinit, &page_error);
-          /* If erase operation was failed, a Flash error code is returned */
-          if (flashstatus != HAL_OK)
-          {
-            return flashstatus;
-          }
-        }
-      }
-      else if (pagestatus1 == ERASED) /* Page0 receive, Page1 erased */
-      {
-        s_eraseinit.TypeErase   = FLASH_TYPEERASE_PAGES;
-        s_eraseinit.PageAddress = PAGE1_BASE_ADDRESS;
-        s_eraseinit.NbPages     = 1;
-        /* Erase Page1 */
-        if(!EE_VerifyPageFullyErased(PAGE1_BASE_ADDRESS))
-        { 
-          flashstatus = HAL_FLASHEx_Erase(&s_eraseinit, &page_error);
-          /* If erase operation was failed, a Flash error code is returned */
-          if (flashstatus != HAL_OK)
-          {
-            return flashstatus;
-          }
-        }
-        /* Mark Page0 as valid */
-        flashstatus = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, PAGE0_BASE_ADDRESS, VALID_PAGE);
-        /* If program operation was failed, a Flash error code is returned */
-        if (flashstatus != HAL_OK)
-        {
-          return flashstatus;
-        }
-      }
-      else /* Invalid state -> format eeprom */
-      {
-        /* Erase both Page0 and Page1 and set Page0 as valid page */
-        flashstatus = EE_Format();
-        /* If erase/program operation was failed, a Flash error code is returned */
-        if (flashstatus != HAL_OK)
-        {
-          return flashstatus;
-        }
-      }
-      break;
-
-    case VALID_PAGE:
-      if (pagestatus1 == VALID_PAGE) /* Invalid state -> format eeprom */
-      {
-        /* Erase both Page0 and Page1 and set Page0 as valid page */
-        flashstatus = EE_Format();
-        /* If erase/program operation was failed, a Flash error code is returned */
-        if (flashstatus != HAL_OK)
-        {
-          return flashstatus;
-        }
-      }
-      else if (pagestatus1 == ERASED) /* Page0 valid, Page1 erased */
-      {
-        s_eraseinit.TypeErase   = FLASH_TYPEERASE_PAGES;
-        s_eraseinit.PageAddress = PAGE1_BASE_ADDRESS;
-        s_eraseinit.NbPages     = 1;
-        /* Erase Page1 */
-        if(!EE_VerifyPageFullyErased(PAGE1_BASE_ADDRESS))
-        { 
-          flashstatus = HAL_FLASHEx_Erase(&s_eraseinit, &page_error);
-          /* If erase operation was failed, a Flash error code is returned */
-          if (flashstatus != HAL_OK)
-          {
-            return flashstatus;
-          }
-        }
-      }
-      else /* Page0 valid, Page1 receive */
-      {
-        /* Transfer data from Page0 to Page1 */
-        for (varidx = 0; varidx < NB_OF_VAR; varidx++)
-        {
-          if ((*(__IO uint16_t*)(PAGE1_BASE_ADDRESS + 6)) == VirtAddVarTab[varidx])
-          {
-            x = varidx;
-          }
-          if (varidx != x)
-          {
-            /* Read the last variables' updates */
-            readstatus = EE_ReadVariable(VirtAddVarTab[varidx], &DataVar);
-            /* In case variable corresponding to the virtual address was found */
-            if (readstatus != 0x1)
-            {
-              /* Transfer the variable to the Page1 */
-              eepromstatus = EE_VerifyPageFullWriteVariable(VirtAddVarTab[varidx], DataVar);
-              /* If program operation was failed, a Flash error code is returned */
-              if (eepromstatus != HAL_OK)
-              {
-                return eepromstatus;
-              }
-            }
-          }
-        }
-        /* Mark Page1 as valid */
-        flashstatus = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, PAGE1_BASE_ADDRESS, VALID_PAGE);        
-        /* If program operation was failed, a Flash error code is returned */
-        if (flashstatus != HAL_OK)
-        {
-          return flashstatus;
-        }
-        s_eraseinit.TypeErase   = FLASH_TYPEERASE_PAGES;
-        s_eraseinit.PageAddress = PAGE0_BASE_ADDRESS;
-        s_eraseinit.NbPages     = 1;
-        /* Erase Page0 */
-        if(!EE_VerifyPageFullyErased(PAGE0_BASE_ADDRESS))
-        { 
-          flashstatus = HAL_FLASHEx_Erase(&s_eraseinit, &page_error);
-          /* If erase operation was failed, a Flash error code is returned */
-          if (flashstatus != HAL_OK)
-          {
-            return flashstatus;
-          }
-        }
-      }
-      break;
-
-    default:  /* Any other state -> format eeprom */
-      /* Erase both Page0 and Page1 and set Page0 as valid page */
-      flashstatus = EE_Format();
-      /* If erase/program operation was failed, a Flash error code is returned */
-      if (flashstatus != HAL_OK)
-      {
-        return flashstatus;
-      }
-      break;
+    return status;
   }
 
-  return HAL_OK;
-}
-
-/**
-  * @brief  Verify if specified page is fully erased.
-  * @param  Address: page address
-  *   This parameter can be one of the following values:
-  *     @arg PAGE0_BASE_ADDRESS: Page0 base address
-  *     @arg PAGE1_BASE_ADDRESS: Page1 base address
-  * @retval page fully erased status:
-  *           - 0: if Page not erased
-  *           - 1: if Page erased
-  */
-uint16_t EE_VerifyPageFullyErased(uint32_t Address)
-{
-  uint32_t readstatus = 1;
-  uint16_t addressvalue = 0x5555;
-    
-  /* Check each active page address starting from end */
-  while (Address <= PAGE0_END_ADDRESS)
+  /* Find the head page and erase every page not part of the ring */
+  status = EE_ScanRing();
+  if (status != HAL_OK)
   {
-    /* Get the current location content to be compared with virtual address */
-    addressvalue = (*(__IO uint16_t*)Address);
+    return status;
+  }
 
-    /* Compare the read address with the virtual address */
-    if (addressvalue != ERASED)
+  /* First EEPROM access: open the first page of the ring */
+  if (UsedPages == 0)
+  {
+    status = EE_OpenPage(PAGE0);
+    if (status != HAL_OK)
     {
-      
-      /* In case variable value is read, reset readstatus flag */
-      readstatus = 0;
-
-      break;
+      return status;
     }
-    /* Next address location */
-    Address = Address + 4;
   }
-  
-  /* Return readstatus value: (0: Page not erased, 1: Page erased) */
-  return readstatus;
+
+  /* Roll back a batch interrupted by a power loss */
+  return EE_RecoverBatch();
 }
 
 /**
@@ -361,51 +148,122 @@ uint16_t EE_VerifyPageFullyErased(uint32_t Address)
   */
 uint16_t EE_ReadVariable(uint16_t VirtAddress, uint16_t* Data)
 {
-  uint16_t validpage = PAGE0;
-  uint16_t addressvalue = 0x5555, readstatus = 1;
-  uint32_t address = EEPROM_START_ADDRESS, PageStartAddress = EEPROM_START_ADDRESS;
+  uint16_t readstatus = 1;
+  uint32_t found = 0;
 
-  /* Get active Page for read operation */
-  validpage = EE_FindValidPage(READ_FROM_VALID_PAGE);
+  readstatus = EE_ReadVariables(&VirtAddress, Data, 1, &found);
 
   /* Check if there is no valid page */
-  if (validpage == NO_VALID_PAGE)
+  if (readstatus == NO_VALID_PAGE)
   {
-    return  NO_VALID_PAGE;
+    return NO_VALID_PAGE;
   }
 
-  /* Get the valid Page start Address */
-  PageStartAddress = (uint32_t)(EEPROM_START_ADDRESS + (uint32_t)(validpage * PAGE_SIZE));
+  /* Return readstatus value: (0: variable exist, 1: variable doesn't exist) */
+  return (found != 0) ? 0 : 1;
+}
 
-  /* Get the valid Page end Address */
-  address = (uint32_t)((EEPROM_START_ADDRESS - 2) + (uint32_t)((1 + validpage) * PAGE_SIZE));
+/**
+  * @brief  Returns the last stored data of several variables in a single
+  *   backward scan of the used pages, starting with the head page. Variables
+  *   written by an aborted batch are skipped.
+  * @param  VirtAddress: Variables virtual addresses
+  * @param  Data: Variables values, only entries flagged in Found are updated
+  * @param  Count: Number of variables, at most EE_BATCH_MAX_SIZE
+  * @param  Found: Bit n is set if VirtAddress[n] was found
+  * @retval Success or error status:
+  *           - 0: on success
+  *           - NO_VALID_PAGE: if no valid page was found
+  *           - BATCH_TOO_LARGE: if Count exceeds EE_BATCH_MAX_SIZE
+  */
+uint16_t EE_ReadVariables(const uint16_t* VirtAddress, uint16_t* Data, uint16_t Count, uint32_t* Found)
+{
+  uint16_t page = HeadPage, pageidx = 0;
+  uint32_t endaddress = WriteAddress;
 
-  /* Check each active page address starting from end */
-  while (address > (PageStartAddress + 2))
+  *Found = 0;
+
+  if (Count > EE_BATCH_MAX_SIZE)
   {
-    /* Get the current location content to be compared with virtual address */
-    addressvalue = (*(__IO uint16_t*)address);
+    return BATCH_TOO_LARGE;
+  }
 
-    /* Compare the read address with the virtual address */
-    if (addressvalue == VirtAddress)
-    {
-      /* Get content of Address-2 which is variable value */
-      *Data = (*(__IO uint16_t*)(address - 2));
+  /* Check if there is no valid page */
+  if (UsedPages == 0)
+  {
+    return NO_VALID_PAGE;
+  }
 
-      /* In case variable value is read, reset readstatus flag */
-      readstatus = 0;
+  for (pageidx = 0; pageidx < UsedPages; pageidx++)
+  {
+    EE_ScanRecords(PAGE_ADDRESS(page) + PAGE_HEADER_SIZE, endaddress, VirtAddress, Data, Count, Found);
 
-      break;
-    }
-    else
-    {
-      /* Next address location */
-      address = address - 4;
-    }
+    /* Continue with the next older page */
+    page = PREVIOUS_PAGE(page);
+    endaddress = PAGE_ADDRESS(page) + PAGE_SIZE;
   }
 
-  /* Return readstatus value: (0: variable exist, 1: variable doesn't exist) */
-  return readstatus;
+  return 0;
+}
+
+/**
+  * @brief  Writes several variables as one transaction. The records are
+  *   framed by EE_BATCH_BEGIN and EE_BATCH_COMMIT markers and written in a
+  *   single pass into the head page. A batch interrupted by a power loss
+  *   is rolled back by EE_Init.
+  * @param  VirtAddress: Variables virtual addresses
+  * @param  Data: 16 bit data to be written
+  * @param  Count: Number of variables, at most EE_BATCH_MAX_SIZE
+  * @retval Success or error status:
+  *           - FLASH_COMPLETE: on success
+  *           - PAGE_FULL: if the batch does not fit into an empty page
+  *           - BATCH_TOO_LARGE: if Count exceeds EE_BATCH_MAX_SIZE
+  *           - NO_VALID_PAGE: if no valid page was found
+  *           - Flash error code: on write Flash error
+  */
+uint16_t EE_WriteBatch(const uint16_t* VirtAddress, const uint16_t* Data, uint16_t Count)
+{
+  uint16_t Status = 0;
+  uint16_t varidx = 0;
+
+  if (Count > EE_BATCH_MAX_SIZE)
+  {
+    return BATCH_TOO_LARGE;
+  }
+
+  /* A single variable update is atomic on its own */
+  if (Count <= 1)
+  {
+    return (Count == 1) ? EE_WriteVariable(VirtAddress[0], Data[0]) : HAL_OK;
+  }
+
+  /* The batch, its markers and a possible abort marker must fit into the
+     head page, so that the abort marker always follows its batch */
+  Status = EE_Reserve(Count + 3);
+  if (Status != HAL_OK)
+  {
+    return Status;
+  }
+
+  Status = EE_ProgramRecord(EE_BATCH_BEGIN, Count);
+
+  for (varidx = 0; (varidx < Count) && (Status == HAL_OK); varidx++)
+  {
+    Status = EE_ProgramRecord(VirtAddress[varidx], Data[varidx]);
+  }
+
+  if (Status == HAL_OK)
+  {
+    Status = EE_ProgramRecord(EE_BATCH_COMMIT, Count);
+  }
+
+  if (Status != HAL_OK)
+  {
+    /* Terminate the partially written batch so that it is ignored */
+    (void)EE_ProgramRecord(EE_BATCH_ABORT, Count);
+  }
+
+  return Status;
 }
 
 /**
@@ -414,7 +272,6 @@ uint16_t EE_ReadVariable(uint16_t VirtAddress, uint16_t* Data)
   * @param  Data: 16 bit data to be written
   * @retval Success or error status:
   *           - FLASH_COMPLETE: on success
-  *           - PAGE_FULL: if valid page is full
   *           - NO_VALID_PAGE: if no valid page was found
   *           - Flash error code: on write Flash error
   */
@@ -422,307 +279,772 @@ uint16_t EE_WriteVariable(uint16_t VirtAddress, uint16_t Data)
 {
   uint16_t Status = 0;
 
-  /* Write the variable virtual address and value in the EEPROM */
-  Status = EE_VerifyPageFullWriteVariable(VirtAddress, Data);
-
-  /* In case the EEPROM active page is full */
-  if (Status == PAGE_FULL)
+  /* Make room in the head page, opens the next page if needed */
+  Status = EE_Reserve(1);
+  if (Status != HAL_OK)
   {
-    /* Perform Page transfer */
-    Status = EE_PageTransfer(VirtAddress, Data);
+    return Status;
   }
 
-  /* Return last operation status */
-  return Status;
+  /* Write the variable virtual address and value in the EEPROM */
+  return EE_ProgramRecord(VirtAddress, Data);
 }
 
 /**
-  * @brief  Erases PAGE and PAGE1 and writes VALID_PAGE header to PAGE
+  * @brief  Performs one step of the transfer of the tail page: either moves
+  *   one variable to the head page or erases the transferred tail page.
+  *   Meant to be called from a low priority context, so that writes do not
+  *   have to wait for a page erase.
   * @param  None
-  * @retval Status of the last operation (Flash write or erase) done during
-  *         EEPROM formating
+  * @retval Success or error status:
+  *           - FLASH_COMPLETE: if there is nothing left to transfer
+  *           - TRANSFER_PENDING: if more steps are pending
+  *           - Flash error code: on write Flash error
   */
-static HAL_StatusTypeDef EE_Format(void)
+uint16_t EE_Maintain(void)
 {
-  HAL_StatusTypeDef flashstatus = HAL_OK;
-  uint32_t page_error = 0;
-  FLASH_EraseInitTypeDef s_eraseinit;
+  uint16_t Status = HAL_OK;
 
-  s_eraseinit.TypeErase   = FLASH_TYPEERASE_PAGES;
-  s_eraseinit.PageAddress = PAGE0_BASE_ADDRESS;
-  s_eraseinit.NbPages     = 1;
-  /* Erase Page0 */
-  if(!EE_VerifyPageFullyErased(PAGE0_BASE_ADDRESS))
+  /* A transfer is pending as long as no page is left to open */
+  if (UsedPages < EEPROM_PAGES)
   {
-    flashstatus = HAL_FLASHEx_Erase(&s_eraseinit, &page_error); 
-    /* If erase operation was failed, a Flash error code is returned */
-    if (flashstatus != HAL_OK)
-    {
-      return flashstatus;
-    }
+    return HAL_OK;
   }
-  /* Set Page0 as valid page: Write VALID_PAGE at Page0 base address */
-  flashstatus = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, PAGE0_BASE_ADDRESS, VALID_PAGE); 
-  /* If program operation was failed, a Flash error code is returned */
-  if (flashstatus != HAL_OK)
+
+  Status = EE_TransferStep();
+  if (Status != HAL_OK)
   {
-    return flashstatus;
+    return Status;
   }
 
-  s_eraseinit.PageAddress = PAGE1_BASE_ADDRESS;
-  /* Erase Page1 */
-  if(!EE_VerifyPageFullyErased(PAGE1_BASE_ADDRESS))
-  {  
-    flashstatus = HAL_FLASHEx_Erase(&s_eraseinit, &page_error); 
-    /* If erase operation was failed, a Flash error code is returned */
-    if (flashstatus != HAL_OK)
-    {
-      return flashstatus;
-    }
+  return (UsedPages < EEPROM_PAGES) ? HAL_OK : TRANSFER_PENDING;
+}
+
+/**
+  * @brief  Returns the number of erase cycles of a page.
+  * @param  Page: Page number within the ring, 0 to EEPROM_PAGES - 1
+  * @retval Erase count or ERASED if unknown
+  */
+uint16_t EE_GetEraseCount(uint16_t Page)
+{
+  uint16_t pagestatus = ERASED;
+
+  if (Page >= EEPROM_PAGES)
+  {
+    return ERASED;
   }
-  
-  return HAL_OK;
+
+  /* Only ring pages and erased pages carry an erase count */
+  pagestatus = PAGE_HEADER(Page, HEADER_STATUS);
+  if ((pagestatus != RING_PAGE) && (pagestatus != ERASED))
+  {
+    return ERASED;
+  }
+
+  return PAGE_HEADER(Page, HEADER_ERASE_COUNT);
 }
 
 /**
-  * @brief  Find valid Page for write or read operation
-  * @param  Operation: operation to achieve on the valid page.
-  *   This parameter can be one of the following values:
-  *     @arg READ_FROM_VALID_PAGE: read operation from valid page
-  *     @arg WRITE_IN_VALID_PAGE: write operation from valid page
-  * @retval Valid page number (PAGE or PAGE1) or NO_VALID_PAGE in case
-  *   of no valid page was found
+  * @brief  Converts the legacy two page layout into the ring layout. The
+  *   legacy page holding the data stays untouched until all variables are
+  *   copied, so an interrupted migration is restarted from scratch.
+  * @param  None
+  * @retval Success or error status:
+  *           - FLASH_COMPLETE: on success or if there is nothing to migrate
+  *           - Flash error code: on write Flash error
   */
-static uint16_t EE_FindValidPage(uint8_t Operation)
+static uint16_t EE_Migrate(void)
 {
+  uint16_t Status = HAL_OK;
   uint16_t pagestatus0 = 6, pagestatus1 = 6;
+  uint16_t sourcepage = PAGE0, page = PAGE0, varidx = 0;
+  uint16_t data = 0;
+  uint32_t found = 0;
+  uint32_t address = 0, endaddress = 0;
 
-  /* Get Page0 actual status */
+  /* Get Page0 status */
   pagestatus0 = (*(__IO uint16_t*)PAGE0_BASE_ADDRESS);
-
-  /* Get Page1 actual status */
+  /* Get Page1 status */
   pagestatus1 = (*(__IO uint16_t*)PAGE1_BASE_ADDRESS);
 
-  /* Write or read operation */
-  switch (Operation)
+  /* A valid and a receiving page are the result of an interrupted transfer:
+     the receiving page holds the newest writes, finish the transfer into it */
+  if ((pagestatus0 == VALID_PAGE) && (pagestatus1 == RECEIVE_DATA))
   {
-    case WRITE_IN_VALID_PAGE:   /* ---- Write operation ---- */
-      if (pagestatus1 == VALID_PAGE)
-      {
-        /* Page0 receiving data */
-        if (pagestatus0 == RECEIVE_DATA)
-        {
-          return PAGE0;         /* Page0 valid */
-        }
-        else
-        {
-          return PAGE1;         /* Page1 valid */
-        }
-      }
-      else if (pagestatus0 == VALID_PAGE)
+    Status = EE_FinishLegacyTransfer(PAGE0, PAGE1);
+    pagestatus0 = ERASED;
+  }
+  else if ((pagestatus1 == VALID_PAGE) && (pagestatus0 == RECEIVE_DATA))
+  {
+    Status = EE_FinishLegacyTransfer(PAGE1, PAGE0);
+    pagestatus1 = ERASED;
+  }
+  if (Status != HAL_OK)
+  {
+    return Status;
+  }
+
+  /* The valid page holds the data. A receiving page without valid page
+     is the result of a transfer whose source was already erased */
+  if ((pagestatus0 == VALID_PAGE) && (pagestatus1 != VALID_PAGE))
+  {
+    sourcepage = PAGE0;
+  }
+  else if ((pagestatus1 == VALID_PAGE) && (pagestatus0 != VALID_PAGE))
+  {
+    sourcepage = PAGE1;
+  }
+  else if ((pagestatus0 == RECEIVE_DATA) && (pagestatus1 != RECEIVE_DATA))
+  {
+    sourcepage = PAGE0;
+  }
+  else if ((pagestatus1 == RECEIVE_DATA) && (pagestatus0 != RECEIVE_DATA))
+  {
+    sourcepage = PAGE1;
+  }
+  else if ((pagestatus0 == VALID_PAGE) || (pagestatus0 == RECEIVE_DATA))
+  {
+    /* Invalid state -> format eeprom */
+    Status = EE_ErasePage(PAGE0);
+    if (Status == HAL_OK)
+    {
+      Status = EE_ErasePage(PAGE1);
+    }
+    return Status;
+  }
+  else
+  {
+    /* No legacy page */
+    return HAL_OK;
+  }
+
+  /* Start a new ring in the other pages */
+  for (page = 0; page < EEPROM_PAGES; page++)
+  {
+    if (page != sourcepage)
+    {
+      Status = EE_ErasePage(page);
+      if (Status != HAL_OK)
       {
-        /* Page1 receiving data */
-        if (pagestatus1 == RECEIVE_DATA)
-        {
-          return PAGE1;         /* Page1 valid */
-        }
-        else
-        {
-          return PAGE0;         /* Page0 valid */
-        }
+        return Status;
       }
-      else
+    }
+  }
+
+  UsedPages = 0;
+  HeadSequence = 0;
+  Status = EE_OpenPage((sourcepage == PAGE0) ? PAGE1 : PAGE0);
+  if (Status != HAL_OK)
+  {
+    return Status;
+  }
+
+  /* Legacy records follow the page status, records of a batch interrupted
+     by a power loss are left behind */
+  address = PAGE_ADDRESS(sourcepage) + 4;
+  endaddress = EE_FindFreeRecord(address, PAGE_ADDRESS(sourcepage) + PAGE_SIZE);
+  if (EE_FindOpenBatch(address, endaddress) != 0xFFFFFFFF)
+  {
+    endaddress = EE_FindOpenBatch(address, endaddress);
+  }
+
+  for (varidx = 0; varidx < NB_OF_VAR; varidx++)
+  {
+    found = 0;
+    EE_ScanRecords(address, endaddress, &VirtAddVarTab[varidx], &data, 1, &found);
+    if (found != 0)
+    {
+      Status = EE_ProgramRecord(VirtAddVarTab[varidx], data);
+      if (Status != HAL_OK)
       {
-        return NO_VALID_PAGE;   /* No valid Page */
+        return Status;
       }
+    }
+  }
+
+  /* All variables are in the ring, drop the legacy page */
+  return EE_ErasePage(sourcepage);
+}
+
+/**
+  * @brief  Completes a page transfer of the legacy two page layout the way
+  *   the two page firmware does: the variables not written to the receiving
+  *   page yet are copied from the valid page, then the valid page is erased.
+  *   An interrupted completion is simply repeated.
+  * @param  ValidPage: Legacy page with VALID_PAGE status
+  * @param  ReceivePage: Legacy page with RECEIVE_DATA status
+  * @retval Success or error status:
+  *           - FLASH_COMPLETE: on success
+  *           - PAGE_FULL: if the receiving page has no room left
+  *           - Flash error code: on write Flash error
+  */
+static uint16_t EE_FinishLegacyTransfer(uint16_t ValidPage, uint16_t ReceivePage)
+{
+  uint16_t Status = HAL_OK;
+  uint16_t varidx = 0;
+  uint16_t data = 0;
+  uint32_t found = 0;
+  uint32_t address = PAGE_ADDRESS(ReceivePage) + 4;
+  uint32_t endaddress = PAGE_ADDRESS(ReceivePage) + PAGE_SIZE;
+  uint32_t validaddress = PAGE_ADDRESS(ValidPage) + 4;
+  uint32_t validendaddress = 0;
+
+  /* Copied records are appended to the receiving page */
+  WriteAddress = EE_FindFreeRecord(address, endaddress);
+
+  /* A batch interrupted in the receiving page is aborted first, so the
+     copied records do not count as part of it */
+  if (EE_FindOpenBatch(address, WriteAddress) != 0xFFFFFFFF)
+  {
+    if (WriteAddress >= endaddress)
+    {
+      return PAGE_FULL;
+    }
+    Status = EE_ProgramRecord(EE_BATCH_ABORT, 0);
+    if (Status != HAL_OK)
+    {
+      return Status;
+    }
+  }
+
+  /* Records of a batch interrupted in the valid page are left behind */
+  validendaddress = EE_FindFreeRecord(validaddress, PAGE_ADDRESS(ValidPage) + PAGE_SIZE);
+  if (EE_FindOpenBatch(validaddress, validendaddress) != 0xFFFFFFFF)
+  {
+    validendaddress = EE_FindOpenBatch(validaddress, validendaddress);
+  }
+
+  for (varidx = 0; varidx < NB_OF_VAR; varidx++)
+  {
+    found = 0;
+    EE_ScanRecords(address, WriteAddress, &VirtAddVarTab[varidx], &data, 1, &found);
+    if (found != 0)
+    {
+      continue;
+    }
 
-    case READ_FROM_VALID_PAGE:  /* ---- Read operation ---- */
-      if (pagestatus0 == VALID_PAGE)
+    EE_ScanRecords(validaddress, validendaddress, &VirtAddVarTab[varidx], &data, 1, &found);
+    if (found != 0)
+    {
+      if (WriteAddress >= endaddress)
       {
-        return PAGE0;           /* Page0 valid */
+        return PAGE_FULL;
       }
-      else if (pagestatus1 == VALID_PAGE)
+      Status = EE_ProgramRecord(VirtAddVarTab[varidx], data);
+      if (Status != HAL_OK)
       {
-        return PAGE1;           /* Page1 valid */
+        return Status;
       }
-      else
+    }
+  }
+
+  /* All variables are in the receiving page, drop the valid page */
+  return EE_ErasePage(ValidPage);
+}
+
+/**
+  * @brief  Rebuilds the ring state from the page headers. The head page is
+  *   the ring page with the highest sequence number, the used pages are the
+  *   ring pages preceding it with consecutive sequence numbers. Any other
+  *   page is erased.
+  * @param  None
+  * @retval Success or error status:
+  *           - FLASH_COMPLETE: on success
+  *           - Flash error code: on write Flash error
+  */
+static uint16_t EE_ScanRing(void)
+{
+  uint16_t Status = HAL_OK;
+  uint16_t page = 0, sequence = 0;
+
+  UsedPages = 0;
+  TransferIndex = 0;
+
+  /* Find the newest page */
+  for (page = 0; page < EEPROM_PAGES; page++)
+  {
+    if ((PAGE_HEADER(page, HEADER_STATUS) == RING_PAGE) && (PAGE_HEADER(page, HEADER_OBSOLETE) != OBSOLETE_PAGE))
+    {
+      sequence = PAGE_HEADER(page, HEADER_SEQUENCE);
+      if ((UsedPages == 0) || ((int16_t)(sequence - HeadSequence) > 0))
       {
-        return NO_VALID_PAGE ;  /* No valid Page */
+        HeadPage = page;
+        HeadSequence = sequence;
       }
+      UsedPages = 1;
+    }
+  }
 
-    default:
-      return PAGE0;             /* Page0 valid */
+  if (UsedPages == 0)
+  {
+    HeadSequence = 0;
   }
+  else
+  {
+    /* Walk back while the pages continue the sequence */
+    page = PREVIOUS_PAGE(HeadPage);
+    while ((UsedPages < EEPROM_PAGES) &&
+           (PAGE_HEADER(page, HEADER_STATUS) == RING_PAGE) &&
+           (PAGE_HEADER(page, HEADER_OBSOLETE) != OBSOLETE_PAGE) &&
+           (PAGE_HEADER(page, HEADER_SEQUENCE) == (uint16_t)(HeadSequence - UsedPages)))
+    {
+      UsedPages++;
+      page = PREVIOUS_PAGE(page);
+    }
+  }
+
+  /* Every other page has to be erased: obsolete pages, pages whose erase or
+     opening was interrupted and pages which never were part of the ring */
+  page = (UsedPages == 0) ? PAGE0 : NEXT_PAGE(HeadPage);
+  for (sequence = UsedPages; sequence < EEPROM_PAGES; sequence++)
+  {
+    Status = EE_ErasePage(page);
+    if (Status != HAL_OK)
+    {
+      return Status;
+    }
+    page = NEXT_PAGE(page);
+  }
+
+  if (UsedPages != 0)
+  {
+    WriteAddress = EE_FindFreeRecord(PAGE_ADDRESS(HeadPage) + PAGE_HEADER_SIZE, PAGE_ADDRESS(HeadPage) + PAGE_SIZE);
+  }
+
+  return HAL_OK;
 }
 
 /**
-  * @brief  Verify if active page is full and Writes variable in EEPROM.
-  * @param  VirtAddress: 16 bit virtual address of the variable
-  * @param  Data: 16 bit data to be written as variable value
+  * @brief  Erases a page unless it is erased already and stores its erase
+  *   count in the page header.
+  * @param  Page: Page number within the ring
   * @retval Success or error status:
   *           - FLASH_COMPLETE: on success
-  *           - PAGE_FULL: if valid page is full
-  *           - NO_VALID_PAGE: if no valid page was found
-  *           - Flash error code: on write Flash error
+  *           - Flash error code: on write or erase Flash error
   */
-static uint16_t EE_VerifyPageFullWriteVariable(uint16_t VirtAddress, uint16_t Data)
+static uint16_t EE_ErasePage(uint16_t Page)
 {
   HAL_StatusTypeDef flashstatus = HAL_OK;
-  uint16_t validpage = PAGE0;
-  uint32_t address = EEPROM_START_ADDRESS, pageendaddress = EEPROM_START_ADDRESS+PAGE_SIZE;
+  uint32_t page_error = 0;
+  uint32_t erasecount = EE_GetEraseCount(Page);
+  FLASH_EraseInitTypeDef s_eraseinit;
 
-  /* Get valid Page for write operation */
-  validpage = EE_FindValidPage(WRITE_IN_VALID_PAGE);
-  
-  /* Check if there is no valid page */
-  if (validpage == NO_VALID_PAGE)
+  /* Pages without erase count continue with the highest count of the ring */
+  if (erasecount == ERASED)
   {
-    return  NO_VALID_PAGE;
+    erasecount = EE_MaxEraseCount();
   }
 
-  /* Get the valid Page start address */
-  address = (uint32_t)(EEPROM_START_ADDRESS + (uint32_t)(validpage * PAGE_SIZE));
-
-  /* Get the valid Page end address */
-  pageendaddress = (uint32_t)((EEPROM_START_ADDRESS - 1) + (uint32_t)((validpage + 1) * PAGE_SIZE));
-
-  /* Check each active page address starting from begining */
-  while (address < pageendaddress)
+  if ((PAGE_HEADER(Page, HEADER_STATUS) == ERASED) &&
+      EE_VerifyRangeErased(PAGE_ADDRESS(Page) + 4, PAGE_ADDRESS(Page) + PAGE_SIZE))
   {
-    /* Verify if address and address+2 contents are 0xFFFFFFFF */
-    if ((*(__IO uint32_t*)address) == 0xFFFFFFFF)
+    /* Page is free already */
+    if (PAGE_HEADER(Page, HEADER_ERASE_COUNT) != ERASED)
+    {
+      return HAL_OK;
+    }
+  }
+  else
+  {
+    s_eraseinit.TypeErase   = FLASH_TYPEERASE_PAGES;
+    s_eraseinit.PageAddress = PAGE_ADDRESS(Page);
+    s_eraseinit.NbPages     = 1;
+
+    flashstatus = HAL_FLASHEx_Erase(&s_eraseinit, &page_error);
+    /* If erase operation was failed, a Flash error code is returned */
+    if (flashstatus != HAL_OK)
     {
-      /* Set variable data */
-      flashstatus = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, address, Data);       
-      /* If program operation was failed, a Flash error code is returned */
-      if (flashstatus != HAL_OK)
-      {
-        return flashstatus;
-      }
-      /* Set variable virtual address */
-      flashstatus = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, address + 2, VirtAddress);       
-      /* Return program operation status */
       return flashstatus;
     }
-    else
+
+    erasecount++;
+  }
+
+  if (erasecount > ERASE_COUNT_MAX)
+  {
+    erasecount = ERASE_COUNT_MAX;
+  }
+
+  /* Set the erase count, the page is free afterwards */
+  return HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, PAGE_ADDRESS(Page) + HEADER_ERASE_COUNT, erasecount);
+}
+
+/**
+  * @brief  Makes a free page the new head page.
+  * @param  Page: Page number within the ring
+  * @retval Success or error status:
+  *           - FLASH_COMPLETE: on success
+  *           - Flash error code: on write or erase Flash error
+  */
+static uint16_t EE_OpenPage(uint16_t Page)
+{
+  HAL_StatusTypeDef flashstatus = HAL_OK;
+
+  /* An erase during a previous transfer may have failed */
+  if ((PAGE_HEADER(Page, HEADER_STATUS) != ERASED) || (PAGE_HEADER(Page, HEADER_SEQUENCE) != ERASED) ||
+      (PAGE_HEADER(Page, HEADER_OBSOLETE) != ERASED) || (PAGE_HEADER(Page, HEADER_ERASE_COUNT) == ERASED))
+  {
+    flashstatus = EE_ErasePage(Page);
+    if (flashstatus != HAL_OK)
     {
-      /* Next address location */
-      address = address + 4;
+      return flashstatus;
     }
   }
 
-  /* Return PAGE_FULL in case the valid page is full */
-  return PAGE_FULL;
+  /* The page becomes part of the ring with its status, a page with sequence
+     number but without status is erased by EE_Init */
+  flashstatus = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, PAGE_ADDRESS(Page) + HEADER_SEQUENCE,
+                                  (uint16_t)(HeadSequence + 1));
+  if (flashstatus != HAL_OK)
+  {
+    return flashstatus;
+  }
+
+  flashstatus = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, PAGE_ADDRESS(Page) + HEADER_STATUS, RING_PAGE);
+  if (flashstatus != HAL_OK)
+  {
+    return flashstatus;
+  }
+
+  HeadPage = Page;
+  HeadSequence++;
+  UsedPages++;
+  WriteAddress = PAGE_ADDRESS(Page) + PAGE_HEADER_SIZE;
+
+  return HAL_OK;
 }
 
 /**
-  * @brief  Transfers last updated variables data from the full Page to
-  *   an empty one.
-  * @param  VirtAddress: 16 bit virtual address of the variable
-  * @param  Data: 16 bit data to be written as variable value
+  * @brief  Makes sure that the head page has room for the given number of
+  *   records. While all pages are used, room for the pending transfer of the
+  *   tail page is kept on top. Opens the next page or finishes the transfer
+  *   if the background did not keep up.
+  * @param  Records: Number of records to be written
   * @retval Success or error status:
   *           - FLASH_COMPLETE: on success
-  *           - PAGE_FULL: if valid page is full
+  *           - PAGE_FULL: if the records do not fit into an empty page
   *           - NO_VALID_PAGE: if no valid page was found
-  *           - Flash error code: on write Flash error
+  *           - Flash error code: on write or erase Flash error
   */
-static uint16_t EE_PageTransfer(uint16_t VirtAddress, uint16_t Data)
+static uint16_t EE_Reserve(uint16_t Records)
 {
-  HAL_StatusTypeDef flashstatus = HAL_OK;
-  uint32_t newpageaddress = EEPROM_START_ADDRESS;
-  uint32_t oldpageid = 0;
-  uint16_t validpage = PAGE0, varidx = 0;
-  uint16_t eepromstatus = 0, readstatus = 0;
-  uint32_t page_error = 0;
-  FLASH_EraseInitTypeDef s_eraseinit;
+  uint16_t Status = HAL_OK;
+  uint32_t needed = 0;
 
-  /* Get active Page for read operation */
-  validpage = EE_FindValidPage(READ_FROM_VALID_PAGE);
+  if (UsedPages == 0)
+  {
+    return NO_VALID_PAGE;
+  }
 
-  if (validpage == PAGE1)       /* Page1 valid */
+  if ((uint32_t)(Records + NB_OF_VAR) > PAGE_RECORDS)
   {
-    /* New page address where variable will be moved to */
-    newpageaddress = PAGE0_BASE_ADDRESS;
+    return PAGE_FULL;
+  }
+
+  while (Status == HAL_OK)
+  {
+    needed = Records;
+    if (UsedPages == EEPROM_PAGES)
+    {
+      needed += NB_OF_VAR - TransferIndex;
+    }
+
+    if (((PAGE_ADDRESS(HeadPage) + PAGE_SIZE - WriteAddress) / 4) >= needed)
+    {
+      break;
+    }
 
-    /* Old page ID where variable will be taken from */
-    oldpageid = PAGE1_BASE_ADDRESS;
+    if (UsedPages == EEPROM_PAGES)
+    {
+      Status = EE_TransferStep();
+    }
+    else
+    {
+      Status = EE_OpenPage(NEXT_PAGE(HeadPage));
+    }
   }
-  else if (validpage == PAGE0)  /* Page0 valid */
+
+  return Status;
+}
+
+/**
+  * @brief  Transfers one variable from the tail page to the head page, or
+  *   retires the tail page once all variables were checked.
+  * @param  None
+  * @retval Success or error status:
+  *           - FLASH_COMPLETE: on success
+  *           - PAGE_FULL: if the head page is full
+  *           - Flash error code: on write or erase Flash error
+  */
+static uint16_t EE_TransferStep(void)
+{
+  uint16_t Status = HAL_OK;
+  uint16_t tailpage = 0;
+  uint16_t data = 0;
+
+  if (TransferIndex < NB_OF_VAR)
   {
-    /* New page address  where variable will be moved to */
-    newpageaddress = PAGE1_BASE_ADDRESS;
+    /* Only variables whose last update lives in the tail page are moved */
+    if (EE_LocateVariable(VirtAddVarTab[TransferIndex], &data) == (UsedPages - 1))
+    {
+      if (WriteAddress >= (PAGE_ADDRESS(HeadPage) + PAGE_SIZE))
+      {
+        return PAGE_FULL;
+      }
+
+      Status = EE_ProgramRecord(VirtAddVarTab[TransferIndex], data);
+      if (Status != HAL_OK)
+      {
+        return Status;
+      }
+    }
 
-    /* Old page ID where variable will be taken from */
-    oldpageid = PAGE0_BASE_ADDRESS;
+    TransferIndex++;
+    return HAL_OK;
   }
-  else
+
+  tailpage = (uint16_t)((HeadPage + EEPROM_PAGES + 1 - UsedPages) % EEPROM_PAGES);
+
+  /* Readers stop using the tail page before it is erased */
+  Status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, PAGE_ADDRESS(tailpage) + HEADER_OBSOLETE, OBSOLETE_PAGE);
+  if (Status != HAL_OK)
   {
-    return NO_VALID_PAGE;       /* No valid Page */
+    return Status;
   }
 
-  /* Set the new Page status to RECEIVE_DATA status */
-  flashstatus = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, newpageaddress, RECEIVE_DATA);  
+  UsedPages--;
+  TransferIndex = 0;
+
+  return EE_ErasePage(tailpage);
+}
+
+/**
+  * @brief  Programs a record at the first free record of the head page.
+  * @param  VirtAddress: 16 bit virtual address of the variable
+  * @param  Data: 16 bit data to be written as variable value
+  * @retval Success or error status:
+  *           - FLASH_COMPLETE: on success
+  *           - Flash error code: on write Flash error
+  */
+static uint16_t EE_ProgramRecord(uint16_t VirtAddress, uint16_t Data)
+{
+  HAL_StatusTypeDef flashstatus = HAL_OK;
+  uint32_t address = WriteAddress;
+
+  /* The record is used up even if programming fails */
+  WriteAddress = WriteAddress + 4;
+
+  /* Set variable data */
+  flashstatus = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, address, Data);
   /* If program operation was failed, a Flash error code is returned */
   if (flashstatus != HAL_OK)
   {
     return flashstatus;
   }
-  
-  /* Write the variable passed as parameter in the new active page */
-  eepromstatus = EE_VerifyPageFullWriteVariable(VirtAddress, Data);
-  /* If program operation was failed, a Flash error code is returned */
-  if (eepromstatus != HAL_OK)
+
+  /* Set variable virtual address */
+  return HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, address + 2, VirtAddress);
+}
+
+/**
+  * @brief  Finds the page holding the last update of a variable.
+  * @param  VirtAddress: Variable virtual address
+  * @param  Data: Variable value, updated if found
+  * @retval Age of the page, 0 for the head page, or UsedPages if the
+  *   variable was not found
+  */
+static uint16_t EE_LocateVariable(uint16_t VirtAddress, uint16_t* Data)
+{
+  uint16_t page = HeadPage, pageidx = 0;
+  uint32_t endaddress = WriteAddress;
+  uint32_t found = 0;
+
+  for (pageidx = 0; pageidx < UsedPages; pageidx++)
   {
-    return eepromstatus;
+    EE_ScanRecords(PAGE_ADDRESS(page) + PAGE_HEADER_SIZE, endaddress, &VirtAddress, Data, 1, &found);
+    if (found != 0)
+    {
+      break;
+    }
+
+    page = PREVIOUS_PAGE(page);
+    endaddress = PAGE_ADDRESS(page) + PAGE_SIZE;
   }
 
-  /* Transfer process: transfer variables from old to the new active page */
-  for (varidx = 0; varidx < NB_OF_VAR; varidx++)
+  return pageidx;
+}
+
+/**
+  * @brief  Scans the records of a page backward and returns the last stored
+  *   data of the variables not found yet. Batches never span pages, records
+  *   between an abort marker and its batch begin marker are skipped.
+  * @param  StartAddress: First record of the page
+  * @param  EndAddress: End address (exclusive) of the records to scan
+  * @param  VirtAddress: Variables virtual addresses
+  * @param  Data: Variables values, only entries newly flagged in Found are updated
+  * @param  Count: Number of variables, at most EE_BATCH_MAX_SIZE
+  * @param  Found: Bit n is set if VirtAddress[n] was found
+  * @retval None
+  */
+static void EE_ScanRecords(uint32_t StartAddress, uint32_t EndAddress, const uint16_t* VirtAddress,
+                           uint16_t* Data, uint16_t Count, uint32_t* Found)
+{
+  uint16_t varidx = 0;
+  uint16_t addressvalue = 0x5555;
+  uint8_t aborted = 0;
+  uint32_t all = (Count == 32) ? 0xFFFFFFFF : ((1UL << Count) - 1);
+  uint32_t address = EndAddress;
+
+  /* Check each record starting from end */
+  while ((address > StartAddress) && (*Found != all))
   {
-    if (VirtAddVarTab[varidx] != VirtAddress)  /* Check each variable except the one passed as parameter */
+    /* Previous record */
+    address = address - 4;
+
+    /* Get the current location content to be compared with virtual address */
+    addressvalue = (*(__IO uint16_t*)(address + 2));
+
+    if (addressvalue == EE_BATCH_ABORT)
+    {
+      /* Skip everything back to the start of the aborted batch */
+      aborted = 1;
+    }
+    else if (addressvalue == EE_BATCH_BEGIN)
     {
-      /* Read the other last variable updates */
-      readstatus = EE_ReadVariable(VirtAddVarTab[varidx], &DataVar);
-      /* In case variable corresponding to the virtual address was found */
-      if (readstatus != 0x1)
+      aborted = 0;
+    }
+    else if (!aborted)
+    {
+      for (varidx = 0; varidx < Count; varidx++)
       {
-        /* Transfer the variable to the new active page */
-        eepromstatus = EE_VerifyPageFullWriteVariable(VirtAddVarTab[varidx], DataVar);
-        /* If program operation was failed, a Flash error code is returned */
-        if (eepromstatus != HAL_OK)
+        /* Compare the read address with the virtual address */
+        if (((*Found & (1UL << varidx)) == 0) && (addressvalue == VirtAddress[varidx]))
         {
-          return eepromstatus;
+          /* Get content of the record which is variable value */
+          Data[varidx] = (*(__IO uint16_t*)address);
+          *Found |= (1UL << varidx);
         }
       }
     }
   }
+}
 
-  s_eraseinit.TypeErase   = FLASH_TYPEERASE_PAGES;
-  s_eraseinit.PageAddress = oldpageid;
-  s_eraseinit.NbPages     = 1;
-  
-  /* Erase the old Page: Set old Page status to ERASED status */
-  flashstatus = HAL_FLASHEx_Erase(&s_eraseinit, &page_error);  
-  /* If erase operation was failed, a Flash error code is returned */
-  if (flashstatus != HAL_OK)
+/**
+  * @brief  Verify if specified address range is fully erased.
+  * @param  Address: start address, word aligned
+  * @param  EndAddress: end address (exclusive)
+  * @retval range erased status:
+  *           - 0: if range not erased
+  *           - 1: if range erased
+  */
+static uint16_t EE_VerifyRangeErased(uint32_t Address, uint32_t EndAddress)
+{
+  while (Address < EndAddress)
   {
-    return flashstatus;
+    if ((*(__IO uint32_t*)Address) != 0xFFFFFFFF)
+    {
+      return 0;
+    }
+    /* Next address location */
+    Address = Address + 4;
   }
 
-  /* Set new Page status to VALID_PAGE status */
-  flashstatus = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, newpageaddress, VALID_PAGE);   
-  /* If program operation was failed, a Flash error code is returned */
-  if (flashstatus != HAL_OK)
+  return 1;
+}
+
+/**
+  * @brief  Returns the highest erase count of the ring pages.
+  * @param  None
+  * @retval Highest erase count, 0 if no page has one
+  */
+static uint16_t EE_MaxEraseCount(void)
+{
+  uint16_t page = 0, erasecount = 0, maxcount = 0;
+
+  for (page = 0; page < EEPROM_PAGES; page++)
   {
-    return flashstatus;
+    erasecount = EE_GetEraseCount(page);
+    if ((erasecount != ERASED) && (erasecount > maxcount))
+    {
+      maxcount = erasecount;
+    }
   }
-  
-  
 
-  /* Return last operation flash status */
-  return flashstatus;
+  return maxcount;
 }
 
+/**
+  * @brief  Find the first free record of a page.
+  * @param  Address: first record of the page
+  * @param  EndAddress: end address (exclusive) of the page
+  * @retval First free record address, EndAddress if the page is full
+  */
+static uint32_t EE_FindFreeRecord(uint32_t Address, uint32_t EndAddress)
+{
+  /* Check each page address starting from begining */
+  while ((Address < EndAddress) && ((*(__IO uint32_t*)Address) != 0xFFFFFFFF))
+  {
+    Address = Address + 4;
+  }
+
+  return Address;
+}
+
+/**
+  * @brief  Find a batch which was started but neither committed nor aborted.
+  * @param  Address: first record of the page
+  * @param  EndAddress: end address (exclusive) of the written records
+  * @retval Address of the EE_BATCH_BEGIN record of the unterminated batch or
+  *   0xFFFFFFFF if there is none
+  */
+static uint32_t EE_FindOpenBatch(uint32_t Address, uint32_t EndAddress)
+{
+  uint16_t addressvalue = 0x5555;
+  uint32_t beginaddress = 0xFFFFFFFF;
+
+  while (Address < EndAddress)
+  {
+    addressvalue = (*(__IO uint16_t*)(Address + 2));
+    if (addressvalue == EE_BATCH_BEGIN)
+    {
+      beginaddress = Address;
+    }
+    else if ((addressvalue == EE_BATCH_COMMIT) || (addressvalue == EE_BATCH_ABORT))
+    {
+      beginaddress = 0xFFFFFFFF;
+    }
+
+    Address = Address + 4;
+  }
+
+  return beginaddress;
+}
+
+/**
+  * @brief  Terminate a batch interrupted by a power loss with an abort
+  *   marker, so that all its records are ignored. The batch reserved room
+  *   for the marker in the head page.
+  * @param  None
+  * @retval Success or error status:
+  *           - FLASH_COMPLETE: on success
+  *           - Flash error code: on write Flash error
+  */
+static uint16_t EE_RecoverBatch(void)
+{
+  if (EE_FindOpenBatch(PAGE_ADDRESS(HeadPage) + PAGE_HEADER_SIZE, WriteAddress) == 0xFFFFFFFF)
+  {
+    return HAL_OK;
+  }
+
+  if (WriteAddress >= (PAGE_ADDRESS(HeadPage) + PAGE_SIZE))
+  {
+    return PAGE_FULL;
+  }
+
+  return EE_ProgramRecord(EE_BATCH_ABORT, 0);
+}
+
+
 /**
   * @}
   */ 
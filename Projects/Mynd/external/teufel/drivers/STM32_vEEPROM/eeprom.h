@@ -183,12 +183,21 @@
 /* EEPROM start address in Flash */
 #define EEPROM_START_ADDRESS  ((uint32_t)EEPROM_FLASH_PAGE0) /* EEPROM emulation start address */
 
-/* Pages 0 and 1 base and end addresses */
+/* Number of consecutive Flash pages used as a ring, starting at EEPROM_FLASH_PAGE0 */
+#ifndef EEPROM_PAGES
+#define EEPROM_PAGES          2
+#endif
+
+#if (EEPROM_PAGES < 2)
+#error "The EEPROM emulation needs at least two pages"
+#endif
+
+/* Pages 0 and 1 base and end addresses, the pages of the legacy two page layout */
 #define PAGE0_BASE_ADDRESS    ((uint32_t)(EEPROM_START_ADDRESS + 0x0000))
 #define PAGE0_END_ADDRESS     ((uint32_t)(EEPROM_START_ADDRESS + (PAGE_SIZE - 1)))
 
-#define PAGE1_BASE_ADDRESS    ((uint32_t)(EEPROM_FLASH_PAGE1))
-#define PAGE1_END_ADDRESS     ((uint32_t)(EEPROM_FLASH_PAGE1 + PAGE_SIZE - 1))
+#define PAGE1_BASE_ADDRESS    ((uint32_t)(EEPROM_START_ADDRESS + PAGE_SIZE))
+#define PAGE1_END_ADDRESS     ((uint32_t)(EEPROM_START_ADDRESS + (2 * PAGE_SIZE) - 1))
 
 /* Used Flash pages for EEPROM emulation */
 #define PAGE0                 ((uint16_t)0x0000)
@@ -197,18 +206,37 @@
 /* No valid page define */
 #define NO_VALID_PAGE         ((uint16_t)0x00AB)
 
-/* Page status definitions */
+/* Legacy page status definitions */
 #define ERASED                ((uint16_t)0xFFFF)     /* Page is empty */
 #define RECEIVE_DATA          ((uint16_t)0xEEEE)     /* Page is marked to receive data */
 #define VALID_PAGE            ((uint16_t)0x0000)     /* Page containing valid data */
 
-/* Valid pages in read and write defines */
-#define READ_FROM_VALID_PAGE  ((uint8_t)0x00)
-#define WRITE_IN_VALID_PAGE   ((uint8_t)0x01)
+/* Ring page header: status, erase count, sequence number and obsolete flag halfwords */
+#define RING_PAGE             ((uint16_t)0xA55A)     /* Page is part of the ring */
+#define OBSOLETE_PAGE         ((uint16_t)0x0000)     /* Page content was transferred, page may be erased */
+#define PAGE_HEADER_SIZE      ((uint32_t)8)
+
+/* Highest erase count stored in a page header */
+#define ERASE_COUNT_MAX       ((uint16_t)0xFFFE)
 
 /* Page full define */
 #define PAGE_FULL             ((uint8_t)0x80)
 
+/* Batch larger than EE_BATCH_MAX_SIZE define */
+#define BATCH_TOO_LARGE       ((uint8_t)0x81)
+
+/* More background transfer steps are pending define */
+#define TRANSFER_PENDING      ((uint8_t)0x82)
+
+/* Reserved virtual addresses framing a batch of variables, must not be used in VirtAddVarTab.
+ * Records between EE_BATCH_BEGIN and EE_BATCH_ABORT are ignored by readers. */
+#define EE_BATCH_BEGIN        ((uint16_t)0xFFF0)
+#define EE_BATCH_COMMIT       ((uint16_t)0xFFF1)
+#define EE_BATCH_ABORT        ((uint16_t)0xFFF2)
+
+/* Maximum number of variables in one batch (width of the found mask of EE_ReadVariables) */
+#define EE_BATCH_MAX_SIZE     ((uint16_t)32)
+
 /* Variables' number */
 #define NB_OF_VAR             ((uint8_t)EEPROM_ELEMENTS)
 
@@ -218,6 +246,10 @@
 uint16_t EE_Init(void);
 uint16_t EE_ReadVariable(uint16_t VirtAddress, uint16_t* Data);
 uint16_t EE_WriteVariable(uint16_t VirtAddress, uint16_t Data);
+uint16_t EE_ReadVariables(const uint16_t* VirtAddress, uint16_t* Data, uint16_t Count, uint32_t* Found);
+uint16_t EE_WriteBatch(const uint16_t* VirtAddress, const uint16_t* Data, uint16_t Count);
+uint16_t EE_Maintain(void);
+uint16_t EE_GetEraseCount(uint16_t Page);
 
 #endif /* __EEPROM_H */
 
@@ -3,7 +3,8 @@
 #define __EEPROM_CONFIG_H
 
 #define EEPROM_FLASH_PAGE0 ((uint32_t) ADDR_FLASH_PAGE_14)
-#define EEPROM_FLASH_PAGE1 ((uint32_t) ADDR_FLASH_PAGE_14)
+/* Number of consecutive pages from EEPROM_FLASH_PAGE0 on, more pages spread the erase cycles */
+#define EEPROM_PAGES 4
 
 #define EEPROM_ELEMENTS 34
 
@@ -0,0 +1,10 @@
+#pragma once
+
+#define EEPROM_FLASH_PAGE0 ((uint32_t) ADDR_FLASH_PAGE_60)
+
+/* Mynd uses two pages, build with -DEEPROM_PAGES=2 to test that layout */
+#ifndef EEPROM_PAGES
+#define EEPROM_PAGES 4
+#endif
+
+#define EEPROM_ELEMENTS 8
@@ -0,0 +1,124 @@
+#include <string.h>
+#include <sys/mman.h>
+
+#include "stm32f0xx_hal.h"
+
+flash_sim_stats_t flash_sim_stats;
+jmp_buf           flash_sim_power_cut;
+
+static uint32_t s_ops_until_cut = 0;
+static uint8_t *s_flash         = NULL;
+static uint32_t s_tick          = 0;
+
+static void flash_sim_tick(void)
+{
+    if (s_ops_until_cut == 0)
+    {
+        return;
+    }
+
+    if (--s_ops_until_cut == 0)
+    {
+        longjmp(flash_sim_power_cut, 1);
+    }
+}
+
+void flash_sim_init(void)
+{
+    if (s_flash == NULL)
+    {
+        // The EEPROM emulation addresses the flash by absolute addresses, map it where it is on target
+        s_flash = mmap((void *) FLASH_SIM_BASE, FLASH_SIM_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+    }
+
+    flash_sim_erase_all();
+    flash_sim_reset_stats();
+    s_ops_until_cut = 0;
+    s_tick          = 0;
+}
+
+void flash_sim_erase_all(void)
+{
+    memset(s_flash, 0xFF, FLASH_SIM_SIZE);
+}
+
+void flash_sim_reset_stats(void)
+{
+    memset(&flash_sim_stats, 0, sizeof(flash_sim_stats));
+}
+
+void flash_sim_cut_power_after(uint32_t n)
+{
+    s_ops_until_cut = n;
+}
+
+void flash_sim_advance_ms(uint32_t ms)
+{
+    s_tick += ms;
+}
+
+uint32_t flash_sim_get_tick_ms(void)
+{
+    return s_tick;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+    volatile uint16_t *cell = (volatile uint16_t *) (uintptr_t) Address;
+
+    if ((TypeProgram != FLASH_TYPEPROGRAM_HALFWORD) || (Address < FLASH_SIM_BASE) ||
+        (Address >= FLASH_SIM_BASE + FLASH_SIM_SIZE) || (Address & 1U))
+    {
+        return HAL_ERROR;
+    }
+
+    flash_sim_tick();
+
+    // STM32F0: only an erased halfword can be programmed, except with 0x0000
+    if ((*cell != 0xFFFF) && ((uint16_t) Data != 0x0000))
+    {
+        return HAL_ERROR;
+    }
+
+    *cell = (uint16_t) Data;
+    flash_sim_stats.programs++;
+    flash_sim_stats.busy_ns += FLASH_SIM_PROGRAM_TIME_NS;
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError)
+{
+    for (uint32_t i = 0; i < pEraseInit->NbPages; i++)
+    {
+        uint32_t address = pEraseInit->PageAddress + i * FLASH_PAGE_SIZE;
+
+        if ((address < FLASH_SIM_BASE) || (address >= FLASH_SIM_BASE + FLASH_SIM_SIZE))
+        {
+            *PageError = address;
+            return HAL_ERROR;
+        }
+
+        flash_sim_tick();
+
+        memset((void *) (uintptr_t) address, 0xFF, FLASH_PAGE_SIZE);
+        flash_sim_stats.erases++;
+        flash_sim_stats.busy_ns += FLASH_SIM_ERASE_TIME_NS;
+        flash_sim_stats.erases_per_page[(address - FLASH_SIM_BASE) / FLASH_PAGE_SIZE]++;
+    }
+
+    *PageError = 0xFFFFFFFF;
+
+    return HAL_OK;
+}
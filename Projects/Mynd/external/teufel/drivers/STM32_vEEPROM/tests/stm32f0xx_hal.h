@@ -0,0 +1,65 @@
+#pragma once
+
+/* Host replacement of the STM32F0 HAL flash API, backed by flash_sim.c */
+
+#include <stdint.h>
+#include <setjmp.h>
+
+#define __IO volatile
+
+typedef enum
+{
+    HAL_OK      = 0x00U,
+    HAL_ERROR   = 0x01U,
+    HAL_BUSY    = 0x02U,
+    HAL_TIMEOUT = 0x03U
+} HAL_StatusTypeDef;
+
+typedef struct
+{
+    uint32_t TypeErase;
+    uint32_t PageAddress;
+    uint32_t NbPages;
+} FLASH_EraseInitTypeDef;
+
+#define FLASH_TYPEERASE_PAGES      (0x00U)
+#define FLASH_TYPEPROGRAM_HALFWORD (0x01U)
+#define FLASH_PAGE_SIZE            (0x800U)
+
+#define FLASH_SIM_BASE             (0x08000000U)
+#define FLASH_SIM_SIZE             (128U * 1024U)
+
+/* STM32F072 datasheet: 16 bit programming time 53.5 us, page erase time up to 40 ms */
+#define FLASH_SIM_PROGRAM_TIME_NS  (53500U)
+#define FLASH_SIM_ERASE_TIME_NS    (40000000U)
+
+typedef struct
+{
+    uint32_t programs;
+    uint32_t erases;
+    uint64_t busy_ns;
+    uint32_t erases_per_page[FLASH_SIM_SIZE / FLASH_PAGE_SIZE];
+} flash_sim_stats_t;
+
+extern flash_sim_stats_t flash_sim_stats;
+
+/* Target of the longjmp performed when an injected power cut hits */
+extern jmp_buf flash_sim_power_cut;
+
+/* Maps the simulated flash at FLASH_SIM_BASE and erases it */
+void flash_sim_init(void);
+void flash_sim_erase_all(void);
+void flash_sim_reset_stats(void);
+
+/* The flash operation number n (counted from now, starting at 1) does not
+ * happen and a longjmp to flash_sim_power_cut is performed instead. 0 disarms. */
+void flash_sim_cut_power_after(uint32_t n);
+
+/* Moves the simulated millisecond clock, the one given to vEEPROM_Init, forward */
+void     flash_sim_advance_ms(uint32_t ms);
+uint32_t flash_sim_get_tick_ms(void);
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data);
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *pEraseInit, uint32_t *PageError);
@@ -0,0 +1,232 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "eeprom.h"
+#include "virtual_eeprom.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#define BATCH_SIZE 6
+
+uint16_t VirtAddVarTab[NB_OF_VAR] = {0x00, 0x01, 0x02, 0x03, 0x70, 0x71, 0x72, 0x73};
+
+static const uint16_t s_batch_addr[BATCH_SIZE] = {0x01, 0x02, 0x70, 0x71, 0x72, 0x73};
+
+static void fill_batch(uint16_t *data, uint16_t seed)
+{
+    for (uint16_t i = 0; i < BATCH_SIZE; i++)
+    {
+        data[i] = (uint16_t) (seed * 31u + i);
+    }
+}
+
+static int read_batch(uint16_t *data)
+{
+    for (uint16_t i = 0; i < BATCH_SIZE; i++)
+    {
+        if (vEEPROM_AddressRead(s_batch_addr[i], &data[i]) != 0)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* Queues the batch and writes it to the flash right away */
+static int write_batch(const uint16_t *data)
+{
+    int err = vEEPROM_AddressWriteBatch(s_batch_addr, data, BATCH_SIZE);
+
+    return (err == 0) ? vEEPROM_Flush() : err;
+}
+
+/* Powers the device back up, which performs the batch recovery */
+static void reboot(void)
+{
+    flash_sim_cut_power_after(0);
+    TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+}
+
+TEST_GROUP(vEepromBatch);
+
+TEST_SETUP(vEepromBatch)
+{
+    flash_sim_init();
+    TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+}
+
+TEST_TEAR_DOWN(vEepromBatch)
+{
+    flash_sim_cut_power_after(0);
+}
+
+TEST(vEepromBatch, test_commit_and_read_back)
+{
+    uint16_t in[BATCH_SIZE], out[BATCH_SIZE];
+
+    fill_batch(in, 1);
+    TEST_ASSERT_EQUAL(0, write_batch(in));
+    TEST_ASSERT_EQUAL(0, read_batch(out));
+    TEST_ASSERT_EQUAL_MEMORY(in, out, sizeof(in));
+
+    reboot();
+    TEST_ASSERT_EQUAL(0, read_batch(out));
+    TEST_ASSERT_EQUAL_MEMORY(in, out, sizeof(in));
+}
+
+TEST(vEepromBatch, test_flash_operations_per_batch)
+{
+    uint16_t in[BATCH_SIZE];
+    uint32_t single_programs;
+
+    // One record per variable plus the begin and commit markers, two halfwords each
+    fill_batch(in, 2);
+    flash_sim_reset_stats();
+    TEST_ASSERT_EQUAL(0, write_batch(in));
+    TEST_ASSERT_EQUAL(2 * (BATCH_SIZE + 2), flash_sim_stats.programs);
+    TEST_ASSERT_EQUAL(0, flash_sim_stats.erases);
+
+    // Unchanged values are not written at all
+    flash_sim_reset_stats();
+    TEST_ASSERT_EQUAL(0, write_batch(in));
+    TEST_ASSERT_EQUAL(0, flash_sim_stats.programs);
+
+    // Only the changed cells are part of the batch
+    in[1] ^= 0x5A5A;
+    in[4] ^= 0x5A5A;
+    flash_sim_reset_stats();
+    TEST_ASSERT_EQUAL(0, write_batch(in));
+    TEST_ASSERT_EQUAL(2 * (2 + 2), flash_sim_stats.programs);
+
+    // Same amount of data written one by one
+    fill_batch(in, 3);
+    flash_sim_reset_stats();
+    for (uint16_t i = 0; i < BATCH_SIZE; i++)
+    {
+        TEST_ASSERT_EQUAL(0, vEEPROM_AddressWrite(s_batch_addr[i], in[i]));
+        TEST_ASSERT_EQUAL(0, vEEPROM_Flush());
+    }
+    single_programs = flash_sim_stats.programs;
+    printf("flash programs for %u variables: batch %u, single %u\r\n", BATCH_SIZE, 2 * (BATCH_SIZE + 2),
+           single_programs);
+}
+
+TEST(vEepromBatch, test_batch_survives_page_transfers)
+{
+    uint16_t in[BATCH_SIZE], out[BATCH_SIZE], other;
+
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressWrite(0x00, 0x1234));
+
+    // Enough batches to wrap both pages several times
+    for (uint16_t round = 0; round < 400; round++)
+    {
+        fill_batch(in, round);
+        TEST_ASSERT_EQUAL(0, write_batch(in));
+        TEST_ASSERT_EQUAL(0, read_batch(out));
+        TEST_ASSERT_EQUAL_MEMORY(in, out, sizeof(in));
+    }
+
+    TEST_ASSERT_GREATER_THAN(2, flash_sim_stats.erases);
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(0x00, &other));
+    TEST_ASSERT_EQUAL_HEX16(0x1234, other);
+}
+
+TEST(vEepromBatch, test_power_cut_at_every_operation)
+{
+    uint16_t old_data[BATCH_SIZE], new_data[BATCH_SIZE], out[BATCH_SIZE];
+    uint32_t ops;
+
+    fill_batch(old_data, 10);
+    fill_batch(new_data, 11);
+
+    // Count the flash operations of an uninterrupted batch
+    TEST_ASSERT_EQUAL(0, write_batch(old_data));
+    flash_sim_reset_stats();
+    TEST_ASSERT_EQUAL(0, write_batch(new_data));
+    ops = flash_sim_stats.programs + flash_sim_stats.erases;
+
+    for (uint32_t cut = 1; cut <= ops; cut++)
+    {
+        flash_sim_erase_all();
+        reboot();
+        TEST_ASSERT_EQUAL(0, write_batch(old_data));
+
+        if (setjmp(flash_sim_power_cut) == 0)
+        {
+            flash_sim_cut_power_after(cut);
+            write_batch(new_data);
+        }
+
+        reboot();
+        TEST_ASSERT_EQUAL(0, read_batch(out));
+
+        // The commit record is the last operation, everything before it must roll back
+        if (cut < ops)
+        {
+            TEST_ASSERT_EQUAL_MEMORY(old_data, out, sizeof(out));
+        }
+    }
+}
+
+TEST(vEepromBatch, test_random_power_cuts)
+{
+    uint16_t committed[BATCH_SIZE], pending[BATCH_SIZE], out[BATCH_SIZE];
+    uint32_t cuts = 0;
+
+    srand(0x5EED);
+
+    fill_batch(committed, 0);
+    TEST_ASSERT_EQUAL(0, write_batch(committed));
+
+    for (uint16_t round = 1; round < 2000; round++)
+    {
+        fill_batch(pending, round);
+        pending[rand() % BATCH_SIZE] ^= (uint16_t) rand();
+
+        if (setjmp(flash_sim_power_cut) == 0)
+        {
+            // Cuts also hit page transfers and the recovery itself
+            flash_sim_cut_power_after((rand() % 4 == 0) ? (uint32_t) (1 + rand() % 40) : 0);
+            if (write_batch(pending) == 0)
+            {
+                memcpy(committed, pending, sizeof(committed));
+            }
+            flash_sim_cut_power_after(0);
+            continue;
+        }
+
+        cuts++;
+        if (setjmp(flash_sim_power_cut) == 0)
+        {
+            flash_sim_cut_power_after((rand() % 8 == 0) ? (uint32_t) (1 + rand() % 4) : 0);
+            vEEPROM_Init(flash_sim_get_tick_ms);
+        }
+        reboot();
+
+        TEST_ASSERT_EQUAL(0, read_batch(out));
+        if (memcmp(out, committed, sizeof(out)) != 0)
+        {
+            // The interrupted batch may only have completed as a whole
+            TEST_ASSERT_EQUAL_MEMORY(pending, out, sizeof(out));
+            memcpy(committed, pending, sizeof(committed));
+        }
+    }
+
+    printf("power cuts injected: %u, erases: %u\r\n", cuts, flash_sim_stats.erases);
+    TEST_ASSERT_GREATER_THAN(0, cuts);
+}
+
+TEST_GROUP_RUNNER(vEepromBatch)
+{
+    RUN_TEST_CASE(vEepromBatch, test_commit_and_read_back);
+
+    RUN_TEST_CASE(vEepromBatch, test_flash_operations_per_batch);
+
+    RUN_TEST_CASE(vEepromBatch, test_batch_survives_page_transfers);
+
+    RUN_TEST_CASE(vEepromBatch, test_power_cut_at_every_operation);
+
+    RUN_TEST_CASE(vEepromBatch, test_random_power_cuts);
+}
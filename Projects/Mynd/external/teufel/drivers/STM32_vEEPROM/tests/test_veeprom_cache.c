@@ -0,0 +1,273 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "eeprom.h"
+#include "virtual_eeprom.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#define SETTINGS_SIZE 4
+
+static const uint16_t s_settings_addr[SETTINGS_SIZE] = {0x00, 0x01, 0x02, 0x03};
+
+static void read_settings(uint16_t *data)
+{
+    for (uint16_t i = 0; i < SETTINGS_SIZE; i++)
+    {
+        TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(s_settings_addr[i], &data[i]));
+    }
+}
+
+/* Halfword of the n-th record of the first page: 0 is the data, 1 the virtual address */
+static uint16_t record(uint16_t n, uint16_t half)
+{
+    return *(__IO uint16_t *) (EEPROM_START_ADDRESS + PAGE_HEADER_SIZE + n * 4u + half * 2u);
+}
+
+/* Powers the device back up, cached writes are lost */
+static void reboot(void)
+{
+    flash_sim_cut_power_after(0);
+    TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+}
+
+TEST_GROUP(vEepromCache);
+
+TEST_SETUP(vEepromCache)
+{
+    flash_sim_init();
+    TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+}
+
+TEST_TEAR_DOWN(vEepromCache)
+{
+    flash_sim_cut_power_after(0);
+}
+
+TEST(vEepromCache, test_writes_do_not_touch_the_flash)
+{
+    uint16_t value;
+
+    flash_sim_reset_stats();
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressWrite(0x70, 0x1234));
+    TEST_ASSERT_EQUAL(0, flash_sim_stats.programs);
+
+    // Reads are served from the cache before the flush
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(0x70, &value));
+    TEST_ASSERT_EQUAL_HEX16(0x1234, value);
+
+    // Not flushed yet
+    flash_sim_advance_ms(VEEPROM_CACHE_FLUSH_DELAY_MS - 1);
+    TEST_ASSERT_EQUAL(1, vEEPROM_Maintain());
+    TEST_ASSERT_EQUAL(0, flash_sim_stats.programs);
+
+    flash_sim_advance_ms(1);
+    TEST_ASSERT_EQUAL(0, vEEPROM_Maintain());
+    TEST_ASSERT_EQUAL(2, flash_sim_stats.programs);
+
+    reboot();
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(0x70, &value));
+    TEST_ASSERT_EQUAL_HEX16(0x1234, value);
+}
+
+TEST(vEepromCache, test_no_clock_flushes_on_maintain)
+{
+    uint16_t value;
+
+    TEST_ASSERT_EQUAL(0, vEEPROM_Init(NULL));
+    flash_sim_reset_stats();
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressWrite(0x70, 0x1234));
+    TEST_ASSERT_EQUAL(0, flash_sim_stats.programs);
+
+    // Nothing waits for a clock that is not there
+    TEST_ASSERT_EQUAL(0, vEEPROM_Maintain());
+    TEST_ASSERT_EQUAL(2, flash_sim_stats.programs);
+
+    reboot();
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(0x70, &value));
+    TEST_ASSERT_EQUAL_HEX16(0x1234, value);
+}
+
+TEST(vEepromCache, test_coalescing_ratio)
+{
+    const uint32_t writes = 600;
+    uint32_t       cached_programs;
+    uint16_t       value;
+
+    // SOC saved every 100 ms, flushed by the idle loop once a second
+    flash_sim_reset_stats();
+    for (uint32_t i = 0; i < writes; i++)
+    {
+        TEST_ASSERT_EQUAL(0, vEEPROM_AddressWrite(0x70, (uint16_t) i));
+        flash_sim_advance_ms(100);
+        TEST_ASSERT_GREATER_OR_EQUAL(0, vEEPROM_Maintain());
+    }
+    TEST_ASSERT_EQUAL(0, vEEPROM_Flush());
+    cached_programs = flash_sim_stats.programs;
+
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(0x70, &value));
+    TEST_ASSERT_EQUAL_HEX16(writes - 1, value);
+
+    // Same writes flushed one by one, as without the cache
+    flash_sim_reset_stats();
+    for (uint32_t i = 0; i < writes; i++)
+    {
+        TEST_ASSERT_EQUAL(0, vEEPROM_AddressWrite(0x70, (uint16_t) (i + 1)));
+        TEST_ASSERT_EQUAL(0, vEEPROM_Flush());
+    }
+
+    printf("flash programs for %u writes: cached %u, direct %u (%u writes per flash record)\r\n", writes,
+           cached_programs, flash_sim_stats.programs, writes / (cached_programs / 2));
+    TEST_ASSERT_LESS_OR_EQUAL(flash_sim_stats.programs / 9, cached_programs);
+}
+
+TEST(vEepromCache, test_flush_order_and_last_write_wins)
+{
+    uint16_t value;
+    uint16_t addr[3] = {0x01, 0x02, 0x01};
+    uint16_t data[3] = {0x1111, 0x2222, 0x3333};
+
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressWrite(0x03, 0xAAAA));
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressWriteBatch(addr, data, 3));
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressWrite(0x03, 0xBBBB));
+
+    flash_sim_reset_stats();
+    TEST_ASSERT_EQUAL(0, vEEPROM_Flush());
+
+    // Three cells in one transaction: begin, the cells in the order of their first write, commit
+    TEST_ASSERT_EQUAL(2 * (3 + 2), flash_sim_stats.programs);
+    TEST_ASSERT_EQUAL_HEX16(EE_BATCH_BEGIN, record(0, 1));
+    TEST_ASSERT_EQUAL_HEX16(0x0003, record(1, 1));
+    TEST_ASSERT_EQUAL_HEX16(0xBBBB, record(1, 0));
+    TEST_ASSERT_EQUAL_HEX16(0x0001, record(2, 1));
+    TEST_ASSERT_EQUAL_HEX16(0x3333, record(2, 0));
+    TEST_ASSERT_EQUAL_HEX16(0x0002, record(3, 1));
+    TEST_ASSERT_EQUAL_HEX16(EE_BATCH_COMMIT, record(4, 1));
+
+    // Nothing left to write
+    flash_sim_reset_stats();
+    TEST_ASSERT_EQUAL(0, vEEPROM_Flush());
+    TEST_ASSERT_EQUAL(0, vEEPROM_Maintain());
+    TEST_ASSERT_EQUAL(0, flash_sim_stats.programs);
+
+    reboot();
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(0x01, &value));
+    TEST_ASSERT_EQUAL_HEX16(0x3333, value);
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(0x02, &value));
+    TEST_ASSERT_EQUAL_HEX16(0x2222, value);
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(0x03, &value));
+    TEST_ASSERT_EQUAL_HEX16(0xBBBB, value);
+}
+
+TEST(vEepromCache, test_full_cache_flushes_on_write)
+{
+    uint16_t value;
+
+    // More cells than the cache holds
+    for (uint16_t i = 0; i < VEEPROM_CACHE_SIZE + 1; i++)
+    {
+        TEST_ASSERT_EQUAL(0, vEEPROM_AddressWrite(0x100 + i, i));
+    }
+
+    reboot();
+    for (uint16_t i = 0; i < VEEPROM_CACHE_SIZE; i++)
+    {
+        TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(0x100 + i, &value));
+        TEST_ASSERT_EQUAL_HEX16(i, value);
+    }
+    TEST_ASSERT_NOT_EQUAL(0, vEEPROM_AddressRead(0x100 + VEEPROM_CACHE_SIZE, &value));
+}
+
+TEST(vEepromCache, test_reset_loses_only_unflushed_writes)
+{
+    uint16_t flushed[SETTINGS_SIZE] = {0x10, 0x11, 0x12, 0x13};
+    uint16_t out[SETTINGS_SIZE];
+
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressWriteBatch(s_settings_addr, flushed, SETTINGS_SIZE));
+    TEST_ASSERT_EQUAL(0, vEEPROM_Flush());
+
+    for (uint16_t round = 0; round < 200; round++)
+    {
+        uint16_t pending[SETTINGS_SIZE];
+
+        for (uint16_t i = 0; i < SETTINGS_SIZE; i++)
+        {
+            pending[i] = (uint16_t) (round * 4u + i);
+        }
+        TEST_ASSERT_EQUAL(0, vEEPROM_AddressWriteBatch(s_settings_addr, pending, SETTINGS_SIZE));
+
+        // Every other round the power is lost before the flush
+        if (round & 1)
+        {
+            TEST_ASSERT_EQUAL(0, vEEPROM_Flush());
+            memcpy(flushed, pending, sizeof(flushed));
+        }
+
+        reboot();
+        read_settings(out);
+        TEST_ASSERT_EQUAL_HEX16_ARRAY(flushed, out, SETTINGS_SIZE);
+    }
+}
+
+TEST(vEepromCache, test_power_cut_at_every_flush_operation)
+{
+    uint16_t old_data[SETTINGS_SIZE] = {0x20, 0x21, 0x22, 0x23};
+    uint16_t new_data[SETTINGS_SIZE] = {0x30, 0x21, 0x32, 0x33};
+    uint16_t out[SETTINGS_SIZE];
+    uint32_t ops;
+
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressWriteBatch(s_settings_addr, old_data, SETTINGS_SIZE));
+    TEST_ASSERT_EQUAL(0, vEEPROM_Flush());
+
+    // Single writes to the same cells end up in one flush transaction
+    flash_sim_reset_stats();
+    for (uint16_t i = 0; i < SETTINGS_SIZE; i++)
+    {
+        TEST_ASSERT_EQUAL(0, vEEPROM_AddressWrite(s_settings_addr[i], new_data[i]));
+    }
+    TEST_ASSERT_EQUAL(0, vEEPROM_Flush());
+    ops = flash_sim_stats.programs + flash_sim_stats.erases;
+
+    for (uint32_t cut = 1; cut <= ops; cut++)
+    {
+        flash_sim_erase_all();
+        reboot();
+        TEST_ASSERT_EQUAL(0, vEEPROM_AddressWriteBatch(s_settings_addr, old_data, SETTINGS_SIZE));
+        TEST_ASSERT_EQUAL(0, vEEPROM_Flush());
+
+        for (uint16_t i = 0; i < SETTINGS_SIZE; i++)
+        {
+            TEST_ASSERT_EQUAL(0, vEEPROM_AddressWrite(s_settings_addr[i], new_data[i]));
+        }
+
+        if (setjmp(flash_sim_power_cut) == 0)
+        {
+            flash_sim_cut_power_after(cut);
+            vEEPROM_Flush();
+        }
+
+        reboot();
+        read_settings(out);
+
+        // The flush ends with the commit record, an interrupted flush rolls back as a whole
+        TEST_ASSERT_EQUAL_HEX16_ARRAY(old_data, out, SETTINGS_SIZE);
+    }
+}
+
+TEST_GROUP_RUNNER(vEepromCache)
+{
+    RUN_TEST_CASE(vEepromCache, test_writes_do_not_touch_the_flash);
+
+    RUN_TEST_CASE(vEepromCache, test_no_clock_flushes_on_maintain);
+
+    RUN_TEST_CASE(vEepromCache, test_coalescing_ratio);
+
+    RUN_TEST_CASE(vEepromCache, test_flush_order_and_last_write_wins);
+
+    RUN_TEST_CASE(vEepromCache, test_full_cache_flushes_on_write);
+
+    RUN_TEST_CASE(vEepromCache, test_reset_loses_only_unflushed_writes);
+
+    RUN_TEST_CASE(vEepromCache, test_power_cut_at_every_flush_operation);
+}
@@ -0,0 +1,375 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "eeprom.h"
+#include "virtual_eeprom.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+/* Endurance of the STM32F0 flash, see datasheet */
+#define FLASH_ENDURANCE_CYCLES 10000u
+
+#define SIM_YEARS              5u
+#define SOC_SAVES_PER_DAY      240u /* Every minute during four hours of charging */
+#define POWER_CYCLES_PER_DAY   2u
+#define IDLE_STEPS_PER_SAVE    40u /* System task idle calls between two saves, far less than in reality */
+
+static const uint16_t s_settings_addr[4] = {0x00, 0x01, 0x02, 0x03};
+static const uint16_t s_soc_addr[4]      = {0x70, 0x71, 0x72, 0x73};
+
+static uint32_t s_legacy_address;
+
+typedef struct
+{
+    uint32_t writes;
+    uint64_t worst_write_ns;
+    uint64_t total_write_ns;
+    uint32_t maintain_steps;
+    uint64_t worst_maintain_ns;
+} usage_report_t;
+
+static void legacy_page(uint32_t page_address, uint16_t status)
+{
+    TEST_ASSERT_EQUAL(HAL_OK, HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, page_address, status));
+    s_legacy_address = page_address + 4;
+}
+
+static void legacy_record(uint16_t addr, uint16_t data)
+{
+    TEST_ASSERT_EQUAL(HAL_OK, HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, s_legacy_address, data));
+    TEST_ASSERT_EQUAL(HAL_OK, HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, s_legacy_address + 2, addr));
+    s_legacy_address += 4;
+}
+
+/* Image written by the two page firmware: settings, a committed and an interrupted batch */
+static void legacy_image(void)
+{
+    flash_sim_erase_all();
+    legacy_page(PAGE1_BASE_ADDRESS, VALID_PAGE);
+    legacy_record(0x00, 0x1111);
+    legacy_record(0x01, 0x2222);
+    legacy_record(0x00, 0x1112);
+    legacy_record(EE_BATCH_BEGIN, 2);
+    legacy_record(0x70, 0x7070);
+    legacy_record(0x71, 0x7171);
+    legacy_record(EE_BATCH_COMMIT, 2);
+    legacy_record(EE_BATCH_BEGIN, 2);
+    legacy_record(0x70, 0xDEAD);
+}
+
+/* Page transfer of the two page firmware interrupted: the receiving page holds a newer value of 0x00 */
+static void legacy_interrupted_transfer_image(void)
+{
+    legacy_image();
+    legacy_page(PAGE0_BASE_ADDRESS, RECEIVE_DATA);
+    legacy_record(0x00, 0x1113);
+}
+
+static void check_values(uint16_t value_0x00)
+{
+    uint16_t value;
+
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(0x00, &value));
+    TEST_ASSERT_EQUAL_HEX16(value_0x00, value);
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(0x01, &value));
+    TEST_ASSERT_EQUAL_HEX16(0x2222, value);
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(0x70, &value));
+    TEST_ASSERT_EQUAL_HEX16(0x7070, value);
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(0x71, &value));
+    TEST_ASSERT_EQUAL_HEX16(0x7171, value);
+}
+
+static void check_legacy_values(void)
+{
+    check_values(0x1112);
+}
+
+static void maintain_until_idle(usage_report_t *report, uint32_t max_steps)
+{
+    for (uint32_t i = 0; i < max_steps; i++)
+    {
+        uint64_t start = flash_sim_stats.busy_ns;
+        int      ret   = vEEPROM_Maintain();
+
+        TEST_ASSERT_GREATER_OR_EQUAL(0, ret);
+        if (report)
+        {
+            report->maintain_steps++;
+            if (flash_sim_stats.busy_ns - start > report->worst_maintain_ns)
+                report->worst_maintain_ns = flash_sim_stats.busy_ns - start;
+        }
+
+        if (ret == 0)
+        {
+            break;
+        }
+    }
+}
+
+static void timed_batch(usage_report_t *report, const uint16_t *addr, const uint16_t *data, uint16_t size)
+{
+    uint64_t start = flash_sim_stats.busy_ns;
+
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressWriteBatch(addr, data, size));
+    TEST_ASSERT_EQUAL(0, vEEPROM_Flush());
+
+    report->writes++;
+    report->total_write_ns += flash_sim_stats.busy_ns - start;
+    if (flash_sim_stats.busy_ns - start > report->worst_write_ns)
+        report->worst_write_ns = flash_sim_stats.busy_ns - start;
+}
+
+/* Days of use: SOC saves every minute while charging, settings saved on every power off */
+static void simulate_usage(usage_report_t *report, uint32_t days, uint32_t idle_steps)
+{
+    uint16_t soc[4] = {0}, settings[4] = {0}, out[4];
+
+    memset(report, 0, sizeof(*report));
+
+    for (uint32_t day = 0; day < days; day++)
+    {
+        for (uint32_t cycle = 0; cycle < POWER_CYCLES_PER_DAY; cycle++)
+        {
+            settings[cycle % 4] = (uint16_t) (day + cycle);
+            settings[3]         = (uint16_t) (day * 7u + cycle);
+            timed_batch(report, s_settings_addr, settings, 4);
+            maintain_until_idle(report, idle_steps);
+        }
+
+        for (uint32_t save = 0; save < SOC_SAVES_PER_DAY; save++)
+        {
+            // Accumulated charge changes on every save, capacity and algorithm state only once a day
+            soc[0] = (uint16_t) (save * 13u);
+            soc[1] = (uint16_t) (day ^ save);
+            soc[2] = (uint16_t) (day / 30u);
+            soc[3] = (uint16_t) (day & 3u);
+            timed_batch(report, s_soc_addr, soc, 4);
+            maintain_until_idle(report, idle_steps);
+        }
+    }
+
+    for (uint16_t i = 0; i < 4; i++)
+    {
+        TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(s_soc_addr[i], &out[i]));
+    }
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(soc, out, 4);
+
+    for (uint16_t i = 0; i < 4; i++)
+    {
+        TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(s_settings_addr[i], &out[i]));
+    }
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(settings, out, 4);
+}
+
+static void print_report(const char *name, const usage_report_t *report)
+{
+    uint16_t count, min_count = 0xFFFF, max_count = 0;
+
+    for (uint16_t page = 0; page < EEPROM_PAGES; page++)
+    {
+        TEST_ASSERT_EQUAL(0, vEEPROM_GetEraseCount(page, &count));
+        min_count = (count < min_count) ? count : min_count;
+        max_count = (count > max_count) ? count : max_count;
+    }
+
+    printf("%s: %u pages, %u years, %u writes, %u erases, erase count per page %u..%u (%u%% of endurance)\r\n", name,
+           EEPROM_PAGES, SIM_YEARS, report->writes, flash_sim_stats.erases, min_count, max_count,
+           (unsigned) (max_count * 100u / FLASH_ENDURANCE_CYCLES));
+    printf("%s: write latency worst %.2f ms, mean %.3f ms; %u transfer steps, worst %.2f ms\r\n", name,
+           report->worst_write_ns / 1e6, (report->total_write_ns / (double) report->writes) / 1e6,
+           report->maintain_steps, report->worst_maintain_ns / 1e6);
+}
+
+TEST_GROUP(vEepromRing);
+
+TEST_SETUP(vEepromRing)
+{
+    flash_sim_init();
+}
+
+TEST_TEAR_DOWN(vEepromRing)
+{
+    flash_sim_cut_power_after(0);
+}
+
+TEST(vEepromRing, test_migrates_legacy_layout)
+{
+    uint16_t value;
+
+    legacy_image();
+    TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+    check_legacy_values();
+    TEST_ASSERT_NOT_EQUAL(0, vEEPROM_AddressRead(0x02, &value));
+
+    // The legacy page is gone, the ring continues in the other page
+    TEST_ASSERT_NOT_EQUAL(VALID_PAGE, *(__IO uint16_t *) PAGE0_BASE_ADDRESS);
+    TEST_ASSERT_NOT_EQUAL(VALID_PAGE, *(__IO uint16_t *) PAGE1_BASE_ADDRESS);
+
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressWrite(0x02, 0x3333));
+    TEST_ASSERT_EQUAL(0, vEEPROM_Flush());
+    TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+    check_legacy_values();
+    TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(0x02, &value));
+    TEST_ASSERT_EQUAL_HEX16(0x3333, value);
+}
+
+TEST(vEepromRing, test_migrates_interrupted_legacy_transfer)
+{
+    // The newest write is in the receiving page, the other values still are in the valid page
+    legacy_interrupted_transfer_image();
+
+    TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+    check_values(0x1113);
+
+    TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+    check_values(0x1113);
+}
+
+TEST(vEepromRing, test_interrupted_legacy_transfer_power_cut_at_every_operation)
+{
+    uint32_t ops;
+
+    legacy_interrupted_transfer_image();
+    flash_sim_reset_stats();
+    TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+    ops = flash_sim_stats.programs + flash_sim_stats.erases;
+
+    for (uint32_t cut = 1; cut <= ops; cut++)
+    {
+        legacy_interrupted_transfer_image();
+
+        if (setjmp(flash_sim_power_cut) == 0)
+        {
+            flash_sim_cut_power_after(cut);
+            vEEPROM_Init(flash_sim_get_tick_ms);
+        }
+
+        flash_sim_cut_power_after(0);
+        TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+        check_values(0x1113);
+    }
+}
+
+TEST(vEepromRing, test_migration_power_cut_at_every_operation)
+{
+    uint32_t ops;
+
+    legacy_image();
+    flash_sim_reset_stats();
+    TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+    ops = flash_sim_stats.programs + flash_sim_stats.erases;
+
+    for (uint32_t cut = 1; cut <= ops; cut++)
+    {
+        legacy_image();
+
+        if (setjmp(flash_sim_power_cut) == 0)
+        {
+            flash_sim_cut_power_after(cut);
+            vEEPROM_Init(flash_sim_get_tick_ms);
+        }
+
+        flash_sim_cut_power_after(0);
+        TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+        check_legacy_values();
+    }
+}
+
+TEST(vEepromRing, test_background_transfer_keeps_erases_out_of_writes)
+{
+    usage_report_t report;
+
+    TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+    flash_sim_reset_stats();
+    simulate_usage(&report, 30, IDLE_STEPS_PER_SAVE);
+
+    TEST_ASSERT_GREATER_THAN(EEPROM_PAGES, flash_sim_stats.erases);
+    TEST_ASSERT_LESS_THAN(FLASH_SIM_ERASE_TIME_NS, report.worst_write_ns);
+}
+
+TEST(vEepromRing, test_power_cuts_during_background_transfer)
+{
+    uint16_t expected[4] = {0}, value;
+    uint32_t cuts = 0;
+
+    srand(0xC0FE);
+    TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+
+    for (uint32_t round = 0; round < 20000; round++)
+    {
+        uint16_t idx = (uint16_t) (rand() % 4);
+
+        expected[idx] = (uint16_t) rand();
+        TEST_ASSERT_EQUAL(0, vEEPROM_AddressWrite(s_soc_addr[idx], expected[idx]));
+        TEST_ASSERT_EQUAL(0, vEEPROM_Flush());
+
+        if (setjmp(flash_sim_power_cut) == 0)
+        {
+            flash_sim_cut_power_after((rand() % 4 == 0) ? (uint32_t) (1 + rand() % 4) : 0);
+            maintain_until_idle(NULL, 2);
+            flash_sim_cut_power_after(0);
+            continue;
+        }
+
+        cuts++;
+        flash_sim_cut_power_after(0);
+        TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+
+        for (uint16_t i = 0; i < 4; i++)
+        {
+            TEST_ASSERT_EQUAL(0, vEEPROM_AddressRead(s_soc_addr[i], &value));
+            TEST_ASSERT_EQUAL_HEX16(expected[i], value);
+        }
+    }
+
+    TEST_ASSERT_GREATER_THAN(0, cuts);
+}
+
+TEST(vEepromRing, test_endurance_report)
+{
+    usage_report_t background, foreground;
+    uint16_t       count, min_count = 0xFFFF, max_count = 0;
+
+    // Transfers done by the system task while idle
+    TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+    flash_sim_reset_stats();
+    simulate_usage(&background, SIM_YEARS * 365u, IDLE_STEPS_PER_SAVE);
+    print_report("background transfer", &background);
+
+    for (uint16_t page = 0; page < EEPROM_PAGES; page++)
+    {
+        TEST_ASSERT_EQUAL(0, vEEPROM_GetEraseCount(page, &count));
+        min_count = (count < min_count) ? count : min_count;
+        max_count = (count > max_count) ? count : max_count;
+    }
+
+    // The ring wears all pages evenly
+    TEST_ASSERT_LESS_OR_EQUAL(min_count + 1u, max_count);
+    TEST_ASSERT_LESS_THAN(FLASH_SIM_ERASE_TIME_NS, background.worst_write_ns);
+
+    // Same usage without background steps, every transfer is done by a write
+    flash_sim_init();
+    TEST_ASSERT_EQUAL(0, vEEPROM_Init(flash_sim_get_tick_ms));
+    simulate_usage(&foreground, SIM_YEARS * 365u, 0);
+    print_report("write-time transfer", &foreground);
+
+    TEST_ASSERT_GREATER_OR_EQUAL(FLASH_SIM_ERASE_TIME_NS, foreground.worst_write_ns);
+}
+
+TEST_GROUP_RUNNER(vEepromRing)
+{
+    RUN_TEST_CASE(vEepromRing, test_migrates_legacy_layout);
+
+    RUN_TEST_CASE(vEepromRing, test_migrates_interrupted_legacy_transfer);
+
+    RUN_TEST_CASE(vEepromRing, test_interrupted_legacy_transfer_power_cut_at_every_operation);
+
+    RUN_TEST_CASE(vEepromRing, test_migration_power_cut_at_every_operation);
+
+    RUN_TEST_CASE(vEepromRing, test_background_transfer_keeps_erases_out_of_writes);
+
+    RUN_TEST_CASE(vEepromRing, test_power_cuts_during_background_transfer);
+
+    RUN_TEST_CASE(vEepromRing, test_endurance_report);
+}
@@ -10,6 +10,9 @@
 #endif
 
 #include "eeprom.h"
+#include "virtual_eeprom.h"
+
+_Static_assert(VEEPROM_CACHE_SIZE <= EE_BATCH_MAX_SIZE, "the cache is flushed as one batch");
 
 #ifdef FreeRTOS
 static SemaphoreHandle_t xSemaphore = NULL;
@@ -18,9 +21,34 @@ static StaticSemaphore_t sem_buffer;
 #endif
 #endif
 
+typedef struct
+{
+    uint16_t addr;
+    uint16_t value;
+} vEEPROM_CacheEntry;
+
+// Write-behind cache: writes are accepted here and reach the flash with the next flush
+static struct
+{
+    vEEPROM_CacheEntry entries[VEEPROM_CACHE_SIZE];
+    uint16_t           count;
+    uint32_t           first_write_tick;
+} s_cache;
+
+static vEEPROM_GetTickFn s_get_tick_ms = NULL;
+
 static void vEEPROM_LockInit(void);
 static void vEEPROM_Lock(void);
 static void vEEPROM_Unlock(void);
+static void vEEPROM_CacheLock(void);
+static void vEEPROM_CacheUnlock(void);
+static int  vEEPROM_CacheFind(uint16_t addr);
+static int  vEEPROM_CacheLoad(uint16_t addr, uint16_t *value);
+static int  vEEPROM_CacheStore(const uint16_t *addr, const uint16_t *data, uint16_t size);
+static void vEEPROM_CacheRelease(const uint16_t *addr, const uint16_t *data, uint16_t size);
+static uint16_t vEEPROM_CacheCount(uint32_t *first_write_tick);
+static int  vEEPROM_Store(const uint16_t *addr, const uint16_t *data, uint16_t size);
+static uint32_t vEEPROM_GetTick(void);
 
 static void vEEPROM_LockInit(void)
 {
@@ -64,10 +92,176 @@ static void vEEPROM_Unlock(void)
 #endif
 }
 
-int vEEPROM_Init(void)
+// The cache lock is only held for a few RAM accesses, unlike the flash lock which is held during
+// flash programming and page erases
+static void vEEPROM_CacheLock(void)
+{
+#ifdef FreeRTOS
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)
+    {
+        return;
+    }
+
+    taskENTER_CRITICAL();
+#endif
+}
+
+static void vEEPROM_CacheUnlock(void)
+{
+#ifdef FreeRTOS
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)
+    {
+        return;
+    }
+
+    taskEXIT_CRITICAL();
+#endif
+}
+
+static int vEEPROM_CacheFind(uint16_t addr)
+{
+    for (uint16_t i = 0U; i < s_cache.count; ++i)
+    {
+        if (s_cache.entries[i].addr == addr)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static int vEEPROM_CacheLoad(uint16_t addr, uint16_t *value)
+{
+    int idx;
+
+    vEEPROM_CacheLock();
+    idx = vEEPROM_CacheFind(addr);
+    if (idx >= 0)
+    {
+        *value = s_cache.entries[idx].value;
+    }
+    vEEPROM_CacheUnlock();
+
+    return idx >= 0;
+}
+
+// Stores all cells or none of them, repeated writes to a cached cell only update its value
+static int vEEPROM_CacheStore(const uint16_t *addr, const uint16_t *data, uint16_t size)
+{
+    int      stored  = 0;
+    uint16_t missing = 0U;
+
+    vEEPROM_CacheLock();
+
+    for (uint16_t i = 0U; i < size; ++i)
+    {
+        if (vEEPROM_CacheFind(addr[i]) < 0)
+        {
+            ++missing;
+        }
+    }
+
+    if (s_cache.count + missing <= VEEPROM_CACHE_SIZE)
+    {
+        if (s_cache.count == 0U)
+        {
+            s_cache.first_write_tick = vEEPROM_GetTick();
+        }
+
+        for (uint16_t i = 0U; i < size; ++i)
+        {
+            int idx = vEEPROM_CacheFind(addr[i]);
+            if (idx < 0)
+            {
+                idx                        = s_cache.count++;
+                s_cache.entries[idx].addr = addr[i];
+            }
+            s_cache.entries[idx].value = data[i];
+        }
+
+        stored = 1;
+    }
+
+    vEEPROM_CacheUnlock();
+
+    return stored;
+}
+
+// Drops the flushed entries, cells written again during the flush stay cached
+static void vEEPROM_CacheRelease(const uint16_t *addr, const uint16_t *data, uint16_t size)
+{
+    vEEPROM_CacheLock();
+
+    for (uint16_t i = 0U; i < size; ++i)
+    {
+        int idx = vEEPROM_CacheFind(addr[i]);
+        if ((idx >= 0) && (s_cache.entries[idx].value == data[i]))
+        {
+            // Keep the order of the remaining entries
+            for (uint16_t j = idx; j + 1U < s_cache.count; ++j)
+            {
+                s_cache.entries[j] = s_cache.entries[j + 1U];
+            }
+            --s_cache.count;
+        }
+    }
+
+    if (s_cache.count > 0U)
+    {
+        s_cache.first_write_tick = vEEPROM_GetTick();
+    }
+
+    vEEPROM_CacheUnlock();
+}
+
+static uint16_t vEEPROM_CacheCount(uint32_t *first_write_tick)
+{
+    uint16_t count;
+
+    vEEPROM_CacheLock();
+    count             = s_cache.count;
+    *first_write_tick = s_cache.first_write_tick;
+    vEEPROM_CacheUnlock();
+
+    return count;
+}
+
+static int vEEPROM_Store(const uint16_t *addr, const uint16_t *data, uint16_t size)
+{
+    if (size > VEEPROM_CACHE_SIZE)
+    {
+        return -1;
+    }
+
+    // Only a full cache makes the writer wait for the flash
+    while (!vEEPROM_CacheStore(addr, data, size))
+    {
+        int err = vEEPROM_Flush();
+        if (err)
+        {
+            return err;
+        }
+    }
+
+    return 0;
+}
+
+// The HAL tick is not advanced while FreeRTOS owns the SysTick, so the cache is timed with the clock given
+static uint32_t vEEPROM_GetTick(void)
+{
+    return (s_get_tick_ms != NULL) ? s_get_tick_ms() : 0U;
+}
+
+int vEEPROM_Init(vEEPROM_GetTickFn get_tick_ms)
 {
     vEEPROM_LockInit();
 
+    s_get_tick_ms = get_tick_ms;
+
+    // Cached writes do not survive a reset
+    s_cache.count = 0U;
+
     HAL_FLASH_Lock();
     HAL_FLASH_Unlock();
 
@@ -86,76 +280,170 @@ int vEEPROM_Init(void)
 
 int vEEPROM_AddressWrite(uint16_t addr, uint16_t value)
 {
-    int      err = 0;
-    uint16_t tmp;
-    uint8_t  update = 1;
+    return vEEPROM_Store(&addr, &value, 1);
+}
+
+int vEEPROM_AddressWriteBuffer(uint16_t addr, const uint16_t *data, uint16_t size)
+{
+    int err = 0;
+
+    for (uint16_t i = 0U; (i < size) && (err == 0); ++i)
+    {
+        uint16_t cell = addr + i;
+        err           = vEEPROM_Store(&cell, &data[i], 1);
+    }
+
+    return err;
+}
+
+int vEEPROM_AddressWriteBatch(const uint16_t *addr, const uint16_t *data, uint16_t size)
+{
+    if (size > VEEPROM_BATCH_MAX_SIZE)
+    {
+        dev_err("[vEEprom] Batch too large: %u", size);
+        return -1;
+    }
+
+    // The cache is flushed as a single transaction, so the batch stays atomic
+    return vEEPROM_Store(addr, data, size);
+}
+
+int vEEPROM_Flush(void)
+{
+    int      err     = 0;
+    uint16_t count   = 0U;
+    uint16_t changed = 0U;
+    uint32_t found   = 0U;
+    uint16_t addr[VEEPROM_CACHE_SIZE];
+    uint16_t data[VEEPROM_CACHE_SIZE];
+    uint16_t current[VEEPROM_CACHE_SIZE];
+    uint16_t changed_addr[VEEPROM_CACHE_SIZE];
+    uint16_t changed_data[VEEPROM_CACHE_SIZE];
+
+    vEEPROM_CacheLock();
+    count = s_cache.count;
+    for (uint16_t i = 0U; i < count; ++i)
+    {
+        addr[i] = s_cache.entries[i].addr;
+        data[i] = s_cache.entries[i].value;
+    }
+    vEEPROM_CacheUnlock();
+
+    if (count == 0U)
+    {
+        return 0;
+    }
 
     vEEPROM_Lock();
 
-    if (EE_ReadVariable(addr, &tmp) == 0)
+    // A single scan of the used pages resolves the current values of all cells
+    if (EE_ReadVariables(addr, current, count, &found) != 0)
+    {
+        found = 0U;
+    }
+
+    for (uint16_t i = 0U; i < count; ++i)
     {
-        if (tmp == value)
+        if ((found & (1UL << i)) && (current[i] == data[i]))
         {
-            update = 0;
+            continue;
         }
+
+        dev_dbg("[vEEprom] W 0x%04x: 0x%04x", addr[i], data[i]);
+        changed_addr[changed] = addr[i];
+        changed_data[changed] = data[i];
+        ++changed;
     }
 
-    if (update)
+    if (changed > 0U)
     {
-        dev_dbg("[vEEprom] W 0x%04x: 0x%04x", addr, value);
         HAL_FLASH_Unlock();
-        err = EE_WriteVariable(addr, value);
+        // A single cell is atomic on its own and does not need the batch markers
+        if (changed == 1U)
+        {
+            err = EE_WriteVariable(changed_addr[0], changed_data[0]);
+        }
+        else
+        {
+            err = EE_WriteBatch(changed_addr, changed_data, changed);
+        }
         HAL_FLASH_Lock();
         if (err)
         {
-            dev_err("[vEEprom] W Failed: 0x%04x", addr);
+            dev_err("[vEEprom] Flush Failed: %d", err);
         }
     }
 
     vEEPROM_Unlock();
 
+    if (err == 0)
+    {
+        vEEPROM_CacheRelease(addr, data, count);
+    }
+
     return err;
 }
 
-int vEEPROM_AddressWriteBuffer(uint16_t addr, const uint16_t *data, uint16_t size)
+int vEEPROM_Maintain(void)
 {
-    int err = 0;
+    uint16_t status;
+    uint32_t first_write_tick = 0U;
+    int      pending          = 0;
 
-    vEEPROM_Lock();
-    for (uint16_t i = 0U; i < size; ++i)
+    // Cached writes are held back for a while, so that bursts to the same cells end up in one flash write
+    if (vEEPROM_CacheCount(&first_write_tick) > 0U)
     {
-        uint16_t tmp = 0U;
-        int      update = 1;
-        if (EE_ReadVariable(addr + i, &tmp) == 0)
+        if ((s_get_tick_ms == NULL) || ((vEEPROM_GetTick() - first_write_tick) >= VEEPROM_CACHE_FLUSH_DELAY_MS))
         {
-            if (tmp == data[i])
+            if (vEEPROM_Flush() != 0)
             {
-                update = 0;
+                return -1;
             }
         }
 
-        if (update)
-        {
-            dev_dbg("[vEEprom] W 0x%04x: 0x%04x", addr + i, tmp);
-            HAL_FLASH_Unlock();
-            err = EE_WriteVariable(addr + i, data[i]);
-            HAL_FLASH_Lock();
-            if (err)
-            {
-                dev_err("[vEEprom] W Failed: 0x%04x", addr + i);
-                break;
-            }
-        }
+        pending = (vEEPROM_CacheCount(&first_write_tick) > 0U);
     }
+
+    vEEPROM_Lock();
+
+    HAL_FLASH_Unlock();
+    status = EE_Maintain();
+    HAL_FLASH_Lock();
+
     vEEPROM_Unlock();
 
-    return err;
+    if (status == TRANSFER_PENDING)
+    {
+        return 1;
+    }
+
+    if (status != 0)
+    {
+        dev_err("[vEEprom] Transfer Failed: %d", status);
+        return -1;
+    }
+
+    return pending;
+}
+
+int vEEPROM_GetEraseCount(uint16_t page, uint16_t *count)
+{
+    vEEPROM_Lock();
+    *count = EE_GetEraseCount(page);
+    vEEPROM_Unlock();
+
+    return (*count == ERASED) ? -1 : 0;
 }
 
 int vEEPROM_AddressRead(uint16_t addr, uint16_t *value)
 {
     int err = 0;
 
+    if (vEEPROM_CacheLoad(addr, value))
+    {
+        return 0;
+    }
+
     vEEPROM_Lock();
 
     err = EE_ReadVariable(addr, value);
@@ -175,6 +463,11 @@ int vEEPROM_AddressReadBuffer(uint16_t addr, uint16_t *target, uint16_t size)
     vEEPROM_Lock();
     for (uint16_t i = 0U; i < size; ++i)
     {
+        if (vEEPROM_CacheLoad(addr + i, &target[i]))
+        {
+            continue;
+        }
+
         err = EE_ReadVariable(addr + i, &target[i]);
         if (err)
         {
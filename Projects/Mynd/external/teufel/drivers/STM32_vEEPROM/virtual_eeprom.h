@@ -1,16 +1,50 @@
 #pragma once
 #include <stdint.h>
 
+/* Maximum number of cells committed by one vEEPROM_AddressWriteBatch call */
+#define VEEPROM_BATCH_MAX_SIZE 16
+
+/* Number of cells held by the write-behind cache, at most EE_BATCH_MAX_SIZE */
+#ifndef VEEPROM_CACHE_SIZE
+#define VEEPROM_CACHE_SIZE VEEPROM_BATCH_MAX_SIZE
+#endif
+
+/* Time a cached write waits for further writes before vEEPROM_Maintain flushes it */
+#ifndef VEEPROM_CACHE_FLUSH_DELAY_MS
+#define VEEPROM_CACHE_FLUSH_DELAY_MS 1000
+#endif
+
 #if defined(__cplusplus)
 extern "C"
 {
 #endif
 
-int vEEPROM_Init(void);
+/* Millisecond clock the write-behind cache is timed with, e.g. the scheduler tick */
+typedef uint32_t (*vEEPROM_GetTickFn)(void);
 
+/* Without a clock, vEEPROM_Maintain flushes cached writes right away */
+int vEEPROM_Init(vEEPROM_GetTickFn get_tick_ms);
+
+/* Writes are accepted into a RAM cache and return without waiting for the flash. Repeated writes
+ * to a cached cell are coalesced. Reads return cached values. */
 int vEEPROM_AddressWrite(uint16_t addr, uint16_t value);
 int vEEPROM_AddressWriteBuffer(uint16_t addr, const uint16_t *data, uint16_t size);
 
+/* Writes the cells addr[i] = data[i] as one transaction: after a power loss either all or none
+ * of the changed cells are updated. Unchanged cells are skipped. */
+int vEEPROM_AddressWriteBatch(const uint16_t *addr, const uint16_t *data, uint16_t size);
+
+/* Writes all cached cells to the flash as one transaction, e.g. before the power is cut */
+int vEEPROM_Flush(void);
+
+/* Flushes the cache once VEEPROM_CACHE_FLUSH_DELAY_MS passed since the first cached write and
+ * performs one step of the background page transfer, so that writes do not have to wait for a
+ * page erase. Returns 1 if more work is pending, 0 if there is nothing to do, negative on error. */
+int vEEPROM_Maintain(void);
+
+/* Number of erase cycles of the EEPROM emulation page with the given index */
+int vEEPROM_GetEraseCount(uint16_t page, uint16_t *count);
+
 int vEEPROM_AddressRead(uint16_t addr, uint16_t *value);
 int vEEPROM_AddressReadBuffer(uint16_t addr, uint16_t *target, uint16_t size);
 
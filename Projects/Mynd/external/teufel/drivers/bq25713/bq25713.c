@@ -7,22 +7,38 @@
 #include <stdlib.h>
 #endif
 
+// Copy of a control register, so that changing a few bits doesn't need a read first
+typedef struct
+{
+    uint8_t data[2];
+    bool    is_valid;
+} register_shadow_t;
+
 struct bq25713_handler
 {
     bq25713_i2c_read_fn  i2c_read_fn;
     bq25713_i2c_write_fn i2c_write_fn;
     uint8_t              i2c_device_address;
+    register_shadow_t    charge_option0;
 };
 
-static int rmw_reg(const struct bq25713_handler *h, uint8_t reg, uint8_t *mask, uint8_t *data)
+static int rmw_reg(struct bq25713_handler *h, uint8_t reg, register_shadow_t *p_shadow, uint8_t *mask, uint8_t *data)
 {
     uint8_t reg_data[2];
-    int            ret;
+    int     ret;
 
-    ret = h->i2c_read_fn(h->i2c_device_address, reg, reg_data, 2);
-    if (ret < 0)
+    if (p_shadow->is_valid)
     {
-        return -1;
+        reg_data[0] = p_shadow->data[0];
+        reg_data[1] = p_shadow->data[1];
+    }
+    else
+    {
+        ret = h->i2c_read_fn(h->i2c_device_address, reg, reg_data, 2);
+        if (ret < 0)
+        {
+            return -1;
+        }
     }
 
     reg_data[0] &= ~mask[0];
@@ -30,15 +46,66 @@ static int rmw_reg(const struct bq25713_handler *h, uint8_t reg, uint8_t *mask,
     reg_data[0] |= data[0];
     reg_data[1] |= data[1];
 
+    // Unknown what the register holds after a failed write, the next change reads it again
+    p_shadow->is_valid = false;
+
     ret = h->i2c_write_fn(h->i2c_device_address, reg, reg_data, 2);
     if (ret < 0)
     {
         return -1;
     }
 
+    p_shadow->data[0]  = reg_data[0];
+    p_shadow->data[1]  = reg_data[1];
+    p_shadow->is_valid = true;
     return 0;
 }
 
+static uint16_t decode_vbus_mv(uint8_t raw)
+{
+    // Input voltage measurement range starts at 3200 mV
+    // LSB is 64 mV
+    return 3200 + (raw * 64);
+}
+
+static uint16_t decode_vsys_mv(uint8_t raw)
+{
+    // System voltage measurement range starts at 2.88 V
+    // LSB is 64 mV
+    return 2880 + (raw * 64);
+}
+
+static uint16_t decode_vbat_mv(uint8_t raw)
+{
+    // Battery voltage measurement range starts at 2.88 V
+    // LSB is 64 mV
+    return 2880 + (raw * 64);
+}
+
+static uint16_t decode_iin_ma(uint8_t raw)
+{
+    // LSB is 50 mA
+    return raw * 50;
+}
+
+static uint16_t decode_ichg_ma(uint8_t raw)
+{
+    // LSB is 64 mA
+    return raw * 64;
+}
+
+static uint16_t decode_idchg_ma(uint8_t raw)
+{
+    // LSB is 256 mA
+    return raw * 256;
+}
+
+static uint16_t decode_psys_mv(uint8_t raw)
+{
+    // LSB is 12 mV
+    return raw * 12;
+}
+
 
 bq25713_handler_t *bq25713_init(const bq25713_config_t *p_config)
 {
@@ -66,6 +133,8 @@ bq25713_handler_t *bq25713_init(const bq25713_config_t *p_config)
     h->i2c_read_fn        = p_config->i2c_read_fn;
     h->i2c_write_fn       = p_config->i2c_write_fn;
     h->i2c_device_address = p_config->i2c_device_address;
+
+    h->charge_option0.is_valid = false;
     return h;
 }
 
@@ -143,9 +212,7 @@ int bq25713_get_battery_voltage_mv(const bq25713_handler_t *h, uint16_t *p_vbat)
         return -1;
     }
 
-    // Battery voltage measurement range starts at 2.88 V
-    // LSB is 64 mV
-    *p_vbat = 2880 + (data * 64);
+    *p_vbat = decode_vbat_mv(data);
     return 0;
 }
 
@@ -157,9 +224,7 @@ int bq25713_get_system_voltage_mv(const bq25713_handler_t *h, uint16_t *p_vsys)
         return -1;
     }
 
-    // System voltage measurement range starts at 2.88 V
-    // LSB is 64 mV
-    *p_vsys = 2880 + (data * 64);
+    *p_vsys = decode_vsys_mv(data);
     return 0;
 }
 
@@ -171,9 +236,7 @@ int bq25713_get_input_voltage_mv(const bq25713_handler_t *h, uint16_t *p_vbus)
         return -1;
     }
 
-    // Input voltage measurement range starts at 3200 mV
-    // LSB is 64 mV
-    *p_vbus = 3200 + (data * 64);
+    *p_vbus = decode_vbus_mv(data);
     return 0;
 }
 
@@ -185,8 +248,7 @@ int bq25713_get_input_current_ma(const bq25713_handler_t *h, uint16_t *p_iin)
         return -1;
     }
 
-    // LSB is 50 mA
-    *p_iin = data * 50;
+    *p_iin = decode_iin_ma(data);
     return 0;
 }
 
@@ -198,8 +260,7 @@ int bq25713_get_adc_charge_current_ma(const bq25713_handler_t *h, uint16_t *p_cu
         return -1;
     }
 
-    // LSB is 64 mA
-    *p_current = data * 64;
+    *p_current = decode_ichg_ma(data);
     return 0;
 }
 
@@ -211,8 +272,7 @@ int bq25713_get_adc_discharge_current_ma(const bq25713_handler_t *h, uint16_t *p
         return -1;
     }
 
-    // LSB is 256 mA
-    *p_current = data * 256;
+    *p_current = decode_idchg_ma(data);
     return 0;
 }
 
@@ -224,12 +284,36 @@ int bq25713_get_system_power_mv(const bq25713_handler_t *h, uint16_t *p_system_p
         return -1;
     }
 
-    // LSB is 12 mV
-    *p_system_power = data * 12;
+    *p_system_power = decode_psys_mv(data);
     return 0;
 }
 
-int bq25713_set_charge_inhibit(const bq25713_handler_t *h, uint8_t charge_inhibit)
+int bq25713_get_telemetry(const bq25713_handler_t *h, bq25713_telemetry_t *p_telemetry)
+{
+    uint8_t adc[BQ25713_REG_ADC_VSYS - BQ25713_REG_ADC_PSYS + 1];
+
+    if (bq25713_get_charger_status(h, &p_telemetry->charger_status, &p_telemetry->fault_status) != 0)
+    {
+        return -1;
+    }
+
+    // The ADC results are contiguous, one read gets them all
+    if (bq25713_read_register(h, BQ25713_REG_ADC_PSYS, adc, sizeof(adc)) != 0)
+    {
+        return -1;
+    }
+
+    p_telemetry->system_power_mv      = decode_psys_mv(adc[BQ25713_REG_ADC_PSYS - BQ25713_REG_ADC_PSYS]);
+    p_telemetry->input_voltage_mv     = decode_vbus_mv(adc[BQ25713_REG_ADC_VBUS - BQ25713_REG_ADC_PSYS]);
+    p_telemetry->discharge_current_ma = decode_idchg_ma(adc[BQ25713_REG_ADC_IDCHG - BQ25713_REG_ADC_PSYS]);
+    p_telemetry->charge_current_ma    = decode_ichg_ma(adc[BQ25713_REG_ADC_ICHG - BQ25713_REG_ADC_PSYS]);
+    p_telemetry->input_current_ma     = decode_iin_ma(adc[BQ25713_REG_ADC_IIN - BQ25713_REG_ADC_PSYS]);
+    p_telemetry->battery_voltage_mv   = decode_vbat_mv(adc[BQ25713_REG_ADC_VBAT - BQ25713_REG_ADC_PSYS]);
+    p_telemetry->system_voltage_mv    = decode_vsys_mv(adc[BQ25713_REG_ADC_VSYS - BQ25713_REG_ADC_PSYS]);
+    return 0;
+}
+
+int bq25713_set_charge_inhibit(bq25713_handler_t *h, uint8_t charge_inhibit)
 {
     uint8_t data[2];
     data[0] = charge_inhibit;
@@ -239,10 +323,10 @@ int bq25713_set_charge_inhibit(const bq25713_handler_t *h, uint8_t charge_inhibi
     mask[0] = 0x01;
     mask[1] = 0x00;
 
-    return rmw_reg(h, BQ25713_REG_CHARGE_OPTION0, mask, data);
+    return rmw_reg(h, BQ25713_REG_CHARGE_OPTION0, &h->charge_option0, mask, data);
 }
 
-int bq25713_set_low_power_mode(const bq25713_handler_t *h, bool enable)
+int bq25713_set_low_power_mode(bq25713_handler_t *h, bool enable)
 {
     uint8_t data[2];
     data[0] = 0x00;
@@ -250,7 +334,12 @@ int bq25713_set_low_power_mode(const bq25713_handler_t *h, bool enable)
 
     uint8_t mask[2] = {0x00, 0x80};
 
-    return rmw_reg(h, BQ25713_REG_CHARGE_OPTION0, mask, data);
+    return rmw_reg(h, BQ25713_REG_CHARGE_OPTION0, &h->charge_option0, mask, data);
+}
+
+void bq25713_invalidate_shadow(bq25713_handler_t *h)
+{
+    h->charge_option0.is_valid = false;
 }
 
 int bq25713_read_register(const bq25713_handler_t *h, uint8_t register_address, uint8_t *p_data, uint32_t length)
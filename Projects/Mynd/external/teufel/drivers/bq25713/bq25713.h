@@ -74,6 +74,19 @@ typedef struct __attribute__((__packed__))
     uint8_t input_overvoltage_fault : 1;
 } bq25713_fault_status_t;
 
+typedef struct
+{
+    bq25713_charger_status_t charger_status;
+    bq25713_fault_status_t   fault_status;
+    uint16_t                 input_voltage_mv;
+    uint16_t                 system_voltage_mv;
+    uint16_t                 battery_voltage_mv;
+    uint16_t                 input_current_ma;
+    uint16_t                 charge_current_ma;
+    uint16_t                 discharge_current_ma;
+    uint16_t                 system_power_mv;
+} bq25713_telemetry_t;
+
 /**
  * @brief Initializes the BQ25713 driver.
  *
@@ -231,6 +244,19 @@ int bq25713_get_adc_discharge_current_ma(const bq25713_handler_t *h, uint16_t *p
  */
 int bq25713_get_system_power_mv(const bq25713_handler_t *h, uint16_t *p_system_power);
 
+/**
+ * @brief Gets the charger status and all ADC results at once.
+ *
+ * @details Two reads instead of one per value: the status registers and the contiguous block of ADC registers.
+ *          Only the ADC channels enabled in ADCOption hold current values.
+ *
+ * @param[in]  h                        pointer to handler
+ * @param[out] p_telemetry              pointer to where the telemetry will be written to
+ *
+ * @return 0 if successful, -1 otherwise
+ */
+int bq25713_get_telemetry(const bq25713_handler_t *h, bq25713_telemetry_t *p_telemetry);
+
 /**
  * @brief Inhibits or enables battery charging by setting the CHRG_INHIBIT register to 1 or 0, respectively.
  *
@@ -243,7 +269,7 @@ int bq25713_get_system_power_mv(const bq25713_handler_t *h, uint16_t *p_system_p
  *
  * @return 0 if successful, -1 otherwise
  */
-int bq25713_set_charge_inhibit(const bq25713_handler_t *h, uint8_t charge_inhibit);
+int bq25713_set_charge_inhibit(bq25713_handler_t *h, uint8_t charge_inhibit);
 
 /**
  * @brief Sets the low power mode.
@@ -253,7 +279,16 @@ int bq25713_set_charge_inhibit(const bq25713_handler_t *h, uint8_t charge_inhibi
  *
  * @return 0 if successful, -1 otherwise
  */
-int bq25713_set_low_power_mode(const bq25713_handler_t *h, bool enable);
+int bq25713_set_low_power_mode(bq25713_handler_t *h, bool enable);
+
+/**
+ * @brief Drops the copy of ChargeOption0 kept by the driver, the next change reads the register again.
+ *
+ * @details Needed if the charger may have been reset or ChargeOption0 was written with bq25713_write_register().
+ *
+ * @param[in] h                         pointer to handler
+ */
+void bq25713_invalidate_shadow(bq25713_handler_t *h);
 
 /**
  * @brief Reads a given register.
@@ -0,0 +1,81 @@
+#include <string.h>
+
+#include "bq25713_sim.h"
+
+#define REGISTER_COUNT 0x40
+/* Longest transfer of the I2Cr/I2Cw 4CC commands of the TPS25751 */
+#define TUNNEL_MAX_LENGTH 10
+
+bq25713_sim_stats_t bq25713_sim_stats;
+
+static struct
+{
+    uint8_t registers[REGISTER_COUNT];
+    bool    fail_next_write;
+} s_sim;
+
+void bq25713_sim_init(void)
+{
+    memset(&s_sim, 0, sizeof(s_sim));
+    /* ChargeOption0 0xE20E, ManufacturerID 0x40, DeviceID 0x88 */
+    s_sim.registers[0x00] = 0x0E;
+    s_sim.registers[0x01] = 0xE2;
+    s_sim.registers[0x2E] = 0x40;
+    s_sim.registers[0x2F] = 0x88;
+    bq25713_sim_reset_stats();
+}
+
+void bq25713_sim_reset_stats(void)
+{
+    memset(&bq25713_sim_stats, 0, sizeof(bq25713_sim_stats));
+}
+
+void bq25713_sim_set_register(uint8_t register_address, uint8_t value)
+{
+    s_sim.registers[register_address] = value;
+}
+
+uint8_t bq25713_sim_get_register(uint8_t register_address)
+{
+    return s_sim.registers[register_address];
+}
+
+void bq25713_sim_fail_next_write(void)
+{
+    s_sim.fail_next_write = true;
+}
+
+int bq25713_sim_i2c_read(uint8_t i2c_address, uint8_t register_address, uint8_t *p_data, uint32_t length)
+{
+    (void) i2c_address;
+    bq25713_sim_stats.reads++;
+
+    if (length > TUNNEL_MAX_LENGTH || register_address + length > REGISTER_COUNT)
+    {
+        return -1;
+    }
+
+    /* The register address increments within a transfer */
+    memcpy(p_data, &s_sim.registers[register_address], length);
+    return 0;
+}
+
+int bq25713_sim_i2c_write(uint8_t i2c_address, uint8_t register_address, const uint8_t *p_data, uint32_t length)
+{
+    (void) i2c_address;
+    bq25713_sim_stats.writes++;
+
+    if (s_sim.fail_next_write)
+    {
+        s_sim.fail_next_write = false;
+        return -1;
+    }
+
+    if (length > TUNNEL_MAX_LENGTH || register_address + length > REGISTER_COUNT)
+    {
+        return -1;
+    }
+
+    memcpy(&s_sim.registers[register_address], p_data, length);
+    return 0;
+}
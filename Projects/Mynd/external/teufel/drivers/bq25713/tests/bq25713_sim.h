@@ -0,0 +1,29 @@
+#pragma once
+
+/* Host model of the BQ25713 register map. On the board it's reached through the I2Cr/I2Cw tunnel of the PD
+   controller, which limits the length of a transfer. */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct
+{
+    uint32_t reads;
+    uint32_t writes;
+} bq25713_sim_stats_t;
+
+extern bq25713_sim_stats_t bq25713_sim_stats;
+
+/* Registers at their power-on defaults */
+void bq25713_sim_init(void);
+void bq25713_sim_reset_stats(void);
+
+void    bq25713_sim_set_register(uint8_t register_address, uint8_t value);
+uint8_t bq25713_sim_get_register(uint8_t register_address);
+
+/* The next write fails on the bus */
+void bq25713_sim_fail_next_write(void);
+
+/* I2C functions for bq25713_config_t, limited to the 10 bytes the tunnel takes */
+int bq25713_sim_i2c_read(uint8_t i2c_address, uint8_t register_address, uint8_t *p_data, uint32_t length);
+int bq25713_sim_i2c_write(uint8_t i2c_address, uint8_t register_address, const uint8_t *p_data, uint32_t length);
@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bq25713.h"
+#include "bq25713_sim.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+/* An I2Cr or I2Cw 4CC command of the PD controller: DATA1 write, CMD1 write, at least one CMD1 read and a DATA1 read */
+#define PD_TRANSACTIONS_PER_TUNNEL 4u
+
+static const bq25713_config_t s_config = {
+    .i2c_read_fn        = bq25713_sim_i2c_read,
+    .i2c_write_fn       = bq25713_sim_i2c_write,
+    .i2c_device_address = 0x6B,
+};
+
+static bq25713_handler_t *s_h;
+
+/* Status and ADC results of a 15 V USB PD charger charging a 2S battery */
+static void set_charging(void)
+{
+    bq25713_sim_set_register(BQ25713_REG_CHARGER_STATUS, 0x00);
+    bq25713_sim_set_register(BQ25713_REG_CHARGER_STATUS + 1, 0x84);
+    bq25713_sim_set_register(BQ25713_REG_ADC_PSYS, 0x20);
+    bq25713_sim_set_register(BQ25713_REG_ADC_VBUS, 0xB8);
+    bq25713_sim_set_register(BQ25713_REG_ADC_IDCHG, 0x00);
+    bq25713_sim_set_register(BQ25713_REG_ADC_ICHG, 0x1F);
+    bq25713_sim_set_register(BQ25713_REG_ADC_IIN, 0x1A);
+    bq25713_sim_set_register(BQ25713_REG_ADC_VBAT, 0x50);
+    bq25713_sim_set_register(BQ25713_REG_ADC_VSYS, 0x52);
+}
+
+static uint32_t pd_transactions(void)
+{
+    return (bq25713_sim_stats.reads + bq25713_sim_stats.writes) * PD_TRANSACTIONS_PER_TUNNEL;
+}
+
+TEST_GROUP(Bq25713Telemetry);
+
+TEST_SETUP(Bq25713Telemetry)
+{
+    bq25713_sim_init();
+    s_h = bq25713_init(&s_config);
+    TEST_ASSERT_NOT_NULL(s_h);
+    set_charging();
+    bq25713_sim_reset_stats();
+}
+
+TEST_TEAR_DOWN(Bq25713Telemetry)
+{
+    free(s_h);
+}
+
+TEST(Bq25713Telemetry, test_telemetry_matches_single_reads)
+{
+    bq25713_telemetry_t      telemetry;
+    bq25713_charger_status_t charger_status;
+    bq25713_fault_status_t   fault_status;
+    uint16_t                 value;
+
+    TEST_ASSERT_EQUAL(0, bq25713_get_telemetry(s_h, &telemetry));
+    TEST_ASSERT_EQUAL(2, bq25713_sim_stats.reads);
+
+    TEST_ASSERT_EQUAL(1, telemetry.charger_status.is_input_present);
+    TEST_ASSERT_EQUAL(1, telemetry.charger_status.in_fast_charge);
+    TEST_ASSERT_EQUAL(14976, telemetry.input_voltage_mv);
+    TEST_ASSERT_EQUAL(8128, telemetry.system_voltage_mv);
+    TEST_ASSERT_EQUAL(8000, telemetry.battery_voltage_mv);
+    TEST_ASSERT_EQUAL(1300, telemetry.input_current_ma);
+    TEST_ASSERT_EQUAL(1984, telemetry.charge_current_ma);
+    TEST_ASSERT_EQUAL(0, telemetry.discharge_current_ma);
+    TEST_ASSERT_EQUAL(384, telemetry.system_power_mv);
+
+    bq25713_sim_reset_stats();
+    TEST_ASSERT_EQUAL(0, bq25713_get_charger_status(s_h, &charger_status, &fault_status));
+    TEST_ASSERT_EQUAL_MEMORY(&telemetry.charger_status, &charger_status, sizeof(charger_status));
+    TEST_ASSERT_EQUAL_MEMORY(&telemetry.fault_status, &fault_status, sizeof(fault_status));
+    TEST_ASSERT_EQUAL(0, bq25713_get_input_voltage_mv(s_h, &value));
+    TEST_ASSERT_EQUAL(telemetry.input_voltage_mv, value);
+    TEST_ASSERT_EQUAL(0, bq25713_get_system_voltage_mv(s_h, &value));
+    TEST_ASSERT_EQUAL(telemetry.system_voltage_mv, value);
+    TEST_ASSERT_EQUAL(0, bq25713_get_battery_voltage_mv(s_h, &value));
+    TEST_ASSERT_EQUAL(telemetry.battery_voltage_mv, value);
+    TEST_ASSERT_EQUAL(0, bq25713_get_input_current_ma(s_h, &value));
+    TEST_ASSERT_EQUAL(telemetry.input_current_ma, value);
+    TEST_ASSERT_EQUAL(0, bq25713_get_adc_charge_current_ma(s_h, &value));
+    TEST_ASSERT_EQUAL(telemetry.charge_current_ma, value);
+    TEST_ASSERT_EQUAL(0, bq25713_get_adc_discharge_current_ma(s_h, &value));
+    TEST_ASSERT_EQUAL(telemetry.discharge_current_ma, value);
+    TEST_ASSERT_EQUAL(0, bq25713_get_system_power_mv(s_h, &value));
+    TEST_ASSERT_EQUAL(telemetry.system_power_mv, value);
+    TEST_ASSERT_EQUAL(8, bq25713_sim_stats.reads);
+}
+
+TEST(Bq25713Telemetry, test_charge_option0_is_changed_from_the_shadow)
+{
+    // The first change reads the register, the others only write it
+    TEST_ASSERT_EQUAL(0, bq25713_set_low_power_mode(s_h, false));
+    TEST_ASSERT_EQUAL(0, bq25713_set_charge_inhibit(s_h, 1));
+    TEST_ASSERT_EQUAL(0, bq25713_set_charge_inhibit(s_h, 0));
+    TEST_ASSERT_EQUAL(1, bq25713_sim_stats.reads);
+    TEST_ASSERT_EQUAL(3, bq25713_sim_stats.writes);
+    TEST_ASSERT_EQUAL_HEX8(0x0E, bq25713_sim_get_register(BQ25713_REG_CHARGE_OPTION0));
+    TEST_ASSERT_EQUAL_HEX8(0x62, bq25713_sim_get_register(BQ25713_REG_CHARGE_OPTION0 + 1));
+
+    // After a failed write the register is read again
+    bq25713_sim_reset_stats();
+    bq25713_sim_fail_next_write();
+    TEST_ASSERT_EQUAL(-1, bq25713_set_charge_inhibit(s_h, 1));
+    TEST_ASSERT_EQUAL(0, bq25713_set_charge_inhibit(s_h, 1));
+    TEST_ASSERT_EQUAL(1, bq25713_sim_stats.reads);
+    TEST_ASSERT_EQUAL_HEX8(0x0F, bq25713_sim_get_register(BQ25713_REG_CHARGE_OPTION0));
+    TEST_ASSERT_EQUAL_HEX8(0x62, bq25713_sim_get_register(BQ25713_REG_CHARGE_OPTION0 + 1));
+
+    // The charger lost its settings, e.g. on a power role swap
+    bq25713_sim_init();
+    bq25713_invalidate_shadow(s_h);
+    TEST_ASSERT_EQUAL(0, bq25713_set_low_power_mode(s_h, false));
+    TEST_ASSERT_EQUAL(1, bq25713_sim_stats.reads);
+    TEST_ASSERT_EQUAL_HEX8(0x0E, bq25713_sim_get_register(BQ25713_REG_CHARGE_OPTION0));
+    TEST_ASSERT_EQUAL_HEX8(0x62, bq25713_sim_get_register(BQ25713_REG_CHARGE_OPTION0 + 1));
+}
+
+TEST(Bq25713Telemetry, test_bus_load)
+{
+    bq25713_telemetry_t      telemetry;
+    bq25713_charger_status_t charger_status;
+    bq25713_fault_status_t   fault_status;
+    uint16_t                 value;
+    uint32_t                 before[3];
+    uint32_t                 after[3];
+
+    // One second of the battery task: the charger status was read for the sound icons and the charger monitor
+    TEST_ASSERT_EQUAL(0, bq25713_get_charger_status(s_h, &charger_status, &fault_status));
+    TEST_ASSERT_EQUAL(0, bq25713_get_charger_status(s_h, &charger_status, &fault_status));
+    before[0] = pd_transactions();
+    bq25713_sim_reset_stats();
+    TEST_ASSERT_EQUAL(0, bq25713_get_charger_status(s_h, &charger_status, &fault_status));
+    after[0] = pd_transactions();
+
+    // The status and every ADC result
+    bq25713_sim_reset_stats();
+    TEST_ASSERT_EQUAL(0, bq25713_get_charger_status(s_h, &charger_status, &fault_status));
+    TEST_ASSERT_EQUAL(0, bq25713_get_input_voltage_mv(s_h, &value));
+    TEST_ASSERT_EQUAL(0, bq25713_get_system_voltage_mv(s_h, &value));
+    TEST_ASSERT_EQUAL(0, bq25713_get_battery_voltage_mv(s_h, &value));
+    TEST_ASSERT_EQUAL(0, bq25713_get_input_current_ma(s_h, &value));
+    TEST_ASSERT_EQUAL(0, bq25713_get_adc_charge_current_ma(s_h, &value));
+    TEST_ASSERT_EQUAL(0, bq25713_get_adc_discharge_current_ma(s_h, &value));
+    TEST_ASSERT_EQUAL(0, bq25713_get_system_power_mv(s_h, &value));
+    before[1] = pd_transactions();
+    bq25713_sim_reset_stats();
+    TEST_ASSERT_EQUAL(0, bq25713_get_telemetry(s_h, &telemetry));
+    after[1] = pd_transactions();
+
+    // Entering and leaving the power bank mode, every change used to read the register first
+    bq25713_sim_reset_stats();
+    TEST_ASSERT_EQUAL(0, bq25713_set_low_power_mode(s_h, false));
+    TEST_ASSERT_EQUAL(0, bq25713_set_charge_inhibit(s_h, 1));
+    TEST_ASSERT_EQUAL(0, bq25713_set_charge_inhibit(s_h, 0));
+    TEST_ASSERT_EQUAL(0, bq25713_set_low_power_mode(s_h, true));
+    after[2]  = pd_transactions();
+    before[2] = after[2] + 3 * PD_TRANSACTIONS_PER_TUNNEL;
+
+    printf("%-28s %8s %8s\n", "PD controller transactions", "before", "after");
+    printf("%-28s %8u %8u\n", "charger status per second", (unsigned) before[0], (unsigned) after[0]);
+    printf("%-28s %8u %8u\n", "status and ADC results", (unsigned) before[1], (unsigned) after[1]);
+    printf("%-28s %8u %8u\n", "power bank on and off", (unsigned) before[2], (unsigned) after[2]);
+
+    TEST_ASSERT_EQUAL(before[0] / 2, after[0]);
+    TEST_ASSERT_EQUAL(before[1] / 4, after[1]);
+    TEST_ASSERT_EQUAL(5 * PD_TRANSACTIONS_PER_TUNNEL, after[2]);
+}
+
+TEST_GROUP_RUNNER(Bq25713Telemetry)
+{
+    RUN_TEST_CASE(Bq25713Telemetry, test_telemetry_matches_single_reads);
+
+    RUN_TEST_CASE(Bq25713Telemetry, test_charge_option0_is_changed_from_the_shadow);
+
+    RUN_TEST_CASE(Bq25713Telemetry, test_bus_load);
+}
@@ -129,6 +129,31 @@ void button_handler_process(button_handler_t *p_handler, uint32_t button_state)
     }
 }
 
+bool button_handler_is_idle(const button_handler_t *p_handler)
+{
+    if (!p_handler)
+    {
+        return true;
+    }
+
+    for (uint8_t i = 0; i < p_handler->p_config->buttons_num; ++i)
+    {
+        const struct single_button_ctx *button_ctx = &p_handler->button_ctx[i];
+
+        if (button_ctx->state != BUTTON_STATE_RELEASED)
+        {
+            return false;
+        }
+
+        if ((button_ctx->last_press_event_sent == INPUT_EVENT_ID_RELEASE) && (button_ctx->consecutive_press_count > 0))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 //----------------------------------------------------------------------------------
 // FSM state functions
 //----------------------------------------------------------------------------------
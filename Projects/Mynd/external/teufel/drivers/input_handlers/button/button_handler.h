@@ -76,6 +76,19 @@ extern "C"
      */
     void button_handler_process(button_handler_t *p_handler, uint32_t button_state);
 
+    /**
+     * @brief Checks if the handler has nothing left to process.
+     *
+     * @details True while all buttons are released and no deferred press event is waiting for the repeated press
+     *          threshold. Until then button_handler_process() has to be called periodically, afterwards only
+     *          when the button state changes.
+     *
+     * @param[in] p_handler     pointer to the handler instance
+     *
+     * @return true if the handler is idle
+     */
+    bool button_handler_is_idle(const button_handler_t *p_handler);
+
 #if defined(__cplusplus)
 }
 #endif
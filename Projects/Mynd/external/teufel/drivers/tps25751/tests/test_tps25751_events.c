@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "tps25751.h"
+#include "tps25751_sim.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+/* Schedule of the audio task */
+#define POLL_MS             500u
+#define FOLLOW_UP_MS        100u
+#define WATCHDOG_MS         500u
+#define FULL_POLL_MS        10000u
+
+static const tps25751_config_t s_config = {
+    .i2c_device_address = 0x42,
+    .i2c_read_fn        = tps25751_sim_i2c_read,
+    .i2c_write_fn       = tps25751_sim_i2c_write,
+    .thread_sleep_fn    = tps25751_sim_sleep,
+};
+
+static tps25751_handler_t *s_h;
+
+static tps25751_port_t s_port;
+static uint32_t        s_pd_role_changes;
+
+static void pd_role_change_cb(bool source)
+{
+    (void) source;
+    s_pd_role_changes++;
+}
+
+static const tps25751_port_callbacks_t s_callbacks = {
+    .pd_role_change_cb = pd_role_change_cb,
+};
+
+static bool is_in_sync(void)
+{
+    return s_port.is_plug_connected == tps25751_sim_is_plug_connected() &&
+           s_port.is_power_connected == tps25751_sim_is_power_connected() && s_port.is_source == tps25751_sim_is_source();
+}
+
+typedef enum
+{
+    STEP_ATTACH_SOURCE,
+    STEP_ATTACH_SINK,
+    STEP_CONTRACT,
+    STEP_PR_SWAP,
+    STEP_DETACH,
+    STEP_RESET,
+} step_t;
+
+typedef struct
+{
+    uint32_t    at_ms;
+    step_t      step;
+    bool        vbus_edge; /* AC OK of the charger toggles */
+    const char *name;
+} scenario_step_t;
+
+/* Charger plugged, contract, the speaker turns into a power bank, unplugged, then a phone to charge */
+static const scenario_step_t s_scenario[] = {
+    {5000, STEP_ATTACH_SOURCE, true, "attach charger"},
+    {5150, STEP_CONTRACT, false, "power contract"},
+    {20000, STEP_PR_SWAP, true, "swap to source"},
+    {31300, STEP_DETACH, false, "detach while sourcing"},
+    {35000, STEP_ATTACH_SINK, false, "attach phone"},
+    {35200, STEP_CONTRACT, false, "power contract"},
+    {41000, STEP_RESET, false, "PD controller reset"},
+    {45000, STEP_PR_SWAP, true, "swap to sink"},
+    {52000, STEP_DETACH, true, "detach charger"},
+};
+
+#define SCENARIO_STEPS (sizeof(s_scenario) / sizeof(s_scenario[0]))
+#define SCENARIO_MS    60000u
+
+static bool after_reset(uint32_t step)
+{
+    for (uint32_t i = 0; i < step; i++)
+    {
+        if (s_scenario[i].step == STEP_RESET && s_scenario[step].at_ms - s_scenario[i].at_ms < FULL_POLL_MS)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+typedef struct
+{
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t bytes;
+    uint32_t latency_ms[SCENARIO_STEPS];
+} report_t;
+
+static bool apply(const scenario_step_t *p_step)
+{
+    switch (p_step->step)
+    {
+        case STEP_ATTACH_SOURCE:
+            tps25751_sim_attach(true);
+            break;
+        case STEP_ATTACH_SINK:
+            tps25751_sim_attach(false);
+            break;
+        case STEP_CONTRACT:
+            tps25751_sim_power_contract();
+            break;
+        case STEP_PR_SWAP:
+            tps25751_sim_pr_swap();
+            break;
+        case STEP_DETACH:
+            tps25751_sim_detach();
+            break;
+        case STEP_RESET:
+            tps25751_sim_reset();
+            return false;
+    }
+    return true;
+}
+
+/* Runs the scenario in 1 ms steps, the board either polls the complete status or reacts on events */
+static void run_scenario(bool event_driven, report_t *p_report)
+{
+    bool     pending[SCENARIO_STEPS] = {false};
+    uint32_t next_step               = 0;
+    bool     follow_up               = false;
+    uint32_t events_ts               = 0;
+    uint32_t full_poll_ts            = 0;
+
+    memset(p_report, 0, sizeof(*p_report));
+    memset(&s_port, 0, sizeof(s_port));
+    tps25751_sim_init();
+
+    if (event_driven)
+    {
+        TEST_ASSERT_EQUAL(0, tps25751_port_poll(s_h, &s_port, &s_callbacks));
+    }
+
+    for (uint32_t t = 1; t <= SCENARIO_MS; t++)
+    {
+        bool interrupt = false;
+
+        while (next_step < SCENARIO_STEPS && s_scenario[next_step].at_ms == t)
+        {
+            pending[next_step] = apply(&s_scenario[next_step]);
+            interrupt |= s_scenario[next_step].vbus_edge;
+            next_step++;
+        }
+
+        if (!event_driven)
+        {
+            if (t % POLL_MS == 0)
+            {
+                TEST_ASSERT_EQUAL(0, tps25751_port_read_status(s_h, &s_port, &s_callbacks, TPS25751_PORT_EVENTS));
+            }
+        }
+        else if (t - full_poll_ts >= FULL_POLL_MS)
+        {
+            full_poll_ts = t;
+            events_ts    = t;
+            TEST_ASSERT_EQUAL(0, tps25751_port_poll(s_h, &s_port, &s_callbacks));
+        }
+        else if (interrupt || t - events_ts >= (follow_up ? FOLLOW_UP_MS : WATCHDOG_MS))
+        {
+            events_ts = t;
+            follow_up = tps25751_port_process_events(s_h, &s_port, &s_callbacks, interrupt);
+        }
+
+        // A change counts as seen once the board is in sync with the port, later changes included
+        for (uint32_t i = 0; i < next_step && is_in_sync(); i++)
+        {
+            if (pending[i])
+            {
+                pending[i]              = false;
+                p_report->latency_ms[i] = t - s_scenario[i].at_ms;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < SCENARIO_STEPS; i++)
+    {
+        TEST_ASSERT_FALSE(pending[i]);
+    }
+    TEST_ASSERT_TRUE(is_in_sync());
+
+    p_report->reads  = tps25751_sim_stats.reads;
+    p_report->writes = tps25751_sim_stats.writes;
+    p_report->bytes  = tps25751_sim_stats.bytes;
+}
+
+TEST_GROUP(Tps25751Events);
+
+TEST_SETUP(Tps25751Events)
+{
+    tps25751_sim_init();
+    memset(&s_port, 0, sizeof(s_port));
+    s_pd_role_changes = 0;
+    s_h = tps25751_init(&s_config);
+    TEST_ASSERT_NOT_NULL(s_h);
+}
+
+TEST_TEAR_DOWN(Tps25751Events)
+{
+}
+
+TEST(Tps25751Events, test_events_are_masked_and_cleared_selectively)
+{
+    uint32_t events;
+
+    // The power status update isn't enabled after a reset
+    tps25751_sim_attach(true);
+    tps25751_sim_power_contract();
+    TEST_ASSERT_EQUAL(0, tps25751_get_events(s_h, &events));
+    TEST_ASSERT_EQUAL_HEX32(TPS25751_EVENT_PLUG_INSERT_OR_REMOVAL, events);
+
+    TEST_ASSERT_EQUAL(0, tps25751_set_event_mask(s_h, TPS25751_PORT_EVENTS));
+    tps25751_sim_pr_swap();
+    TEST_ASSERT_EQUAL(0, tps25751_get_events(s_h, &events));
+    TEST_ASSERT_EQUAL_HEX32(TPS25751_EVENT_PLUG_INSERT_OR_REMOVAL | TPS25751_EVENT_PR_SWAP_COMPLETE |
+                                TPS25751_EVENT_POWER_STATUS_UPDATE,
+                            events);
+
+    // An event raised between the read and the clear stays pending
+    tps25751_sim_detach();
+    TEST_ASSERT_EQUAL(0, tps25751_clear_events(s_h, events));
+    TEST_ASSERT_EQUAL_HEX32(TPS25751_EVENT_STATUS_UPDATE, tps25751_sim_pending_events());
+}
+
+TEST(Tps25751Events, test_no_event_costs_a_single_read)
+{
+    TEST_ASSERT_EQUAL(0, tps25751_port_poll(s_h, &s_port, &s_callbacks));
+    tps25751_sim_reset_stats();
+
+    TEST_ASSERT_FALSE(tps25751_port_process_events(s_h, &s_port, &s_callbacks, false));
+    TEST_ASSERT_EQUAL(1, tps25751_sim_stats.reads);
+    TEST_ASSERT_EQUAL(0, tps25751_sim_stats.writes);
+
+    // Only the flagged status is read
+    tps25751_sim_reset_stats();
+    tps25751_sim_pr_swap();
+    TEST_ASSERT_TRUE(tps25751_port_process_events(s_h, &s_port, &s_callbacks, false));
+    TEST_ASSERT_EQUAL(2, tps25751_sim_stats.reads);
+    TEST_ASSERT_EQUAL(1, tps25751_sim_stats.writes);
+    TEST_ASSERT_TRUE(s_port.is_source);
+    TEST_ASSERT_EQUAL(1, s_pd_role_changes);
+}
+
+TEST(Tps25751Events, test_scenario_latency_and_bus_load)
+{
+    report_t polled;
+    report_t event_driven;
+
+    run_scenario(false, &polled);
+    run_scenario(true, &event_driven);
+
+    printf("%-24s %12s %12s\n", "latency [ms]", "poll 500 ms", "events");
+    for (uint32_t i = 0; i < SCENARIO_STEPS; i++)
+    {
+        if (s_scenario[i].step == STEP_RESET)
+        {
+            continue;
+        }
+        printf("%-24s %12u %12u\n", s_scenario[i].name, (unsigned) polled.latency_ms[i],
+               (unsigned) event_driven.latency_ms[i]);
+
+        // Changes with a VBUS edge are seen right away, also after a reset of the PD controller. The others are seen
+        // within the watchdog period, so no later than with the poll, after a reset only once the events are enabled
+        // again by a VBUS edge or the next full poll.
+        if (s_scenario[i].vbus_edge)
+        {
+            TEST_ASSERT_LESS_OR_EQUAL(1, event_driven.latency_ms[i]);
+        }
+        else if (after_reset(i))
+        {
+            TEST_ASSERT_LESS_OR_EQUAL(FULL_POLL_MS, event_driven.latency_ms[i]);
+        }
+        else
+        {
+            TEST_ASSERT_LESS_OR_EQUAL(WATCHDOG_MS, event_driven.latency_ms[i]);
+            TEST_ASSERT_LESS_OR_EQUAL(POLL_MS, event_driven.latency_ms[i]);
+        }
+    }
+    printf("%-24s %12u %12u\n", "I2C reads", (unsigned) polled.reads, (unsigned) event_driven.reads);
+    printf("%-24s %12u %12u\n", "I2C writes", (unsigned) polled.writes, (unsigned) event_driven.writes);
+    printf("%-24s %12u %12u\n", "I2C bytes", (unsigned) polled.bytes, (unsigned) event_driven.bytes);
+
+    // The watchdog reads as often as the poll did, but only the events register while nothing changes
+    TEST_ASSERT_LESS_THAN(polled.reads, event_driven.reads);
+    TEST_ASSERT_LESS_THAN(polled.bytes, event_driven.bytes);
+}
+
+TEST_GROUP_RUNNER(Tps25751Events)
+{
+    RUN_TEST_CASE(Tps25751Events, test_events_are_masked_and_cleared_selectively);
+
+    RUN_TEST_CASE(Tps25751Events, test_no_event_costs_a_single_read);
+
+    RUN_TEST_CASE(Tps25751Events, test_scenario_latency_and_bus_load);
+}
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "tps25751.h"
+#include "tps25751_sim.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+/* About the size of a patch bundle without the configuration */
+#define PATCH_LENGTH   12000u
+#define BURST_LENGTH   256u
+/* 4CC commands of a patch download: GO2P, PBMs and PBMc */
+#define PATCH_COMMANDS 3u
+
+static uint8_t s_patch[PATCH_LENGTH];
+
+static tps25751_config_t s_config = {
+    .i2c_device_address = 0x42,
+    .i2c_read_fn        = tps25751_sim_i2c_read,
+    .i2c_write_fn       = tps25751_sim_i2c_write,
+    .thread_sleep_fn    = tps25751_sim_sleep,
+};
+
+static const tps25751_sim_timing_t s_normal = {
+    .command_us     = 800,
+    .patch_mode_us  = 5000,
+    .patch_apply_us = 30000,
+};
+
+/* A device which takes longer than the fixed 3 x 10 ms the loader used to wait for the patch mode */
+static const tps25751_sim_timing_t s_slow = {
+    .command_us     = 3000,
+    .patch_mode_us  = 40000,
+    .patch_apply_us = 80000,
+};
+
+typedef struct
+{
+    int      result;
+    uint32_t total_us;
+    uint32_t overhead_us; /* on top of the patch transfer and what the device takes */
+} load_report_t;
+
+/* The least a download takes: the patch on the bus, the commands and the mode changes of the device in a row */
+static uint32_t least_load_us(const tps25751_sim_timing_t *p_timing, uint32_t max_write_length)
+{
+    uint32_t burst_length = (max_write_length != 0) ? max_write_length : PATCH_LENGTH;
+    uint32_t bursts       = (PATCH_LENGTH + burst_length - 1) / burst_length;
+    uint32_t transfer_us  = (bursts - 1) * tps25751_sim_transfer_us(burst_length) +
+                           tps25751_sim_transfer_us(PATCH_LENGTH - (bursts - 1) * burst_length);
+
+    return transfer_us + PATCH_COMMANDS * p_timing->command_us + p_timing->patch_mode_us + p_timing->patch_apply_us;
+}
+
+static load_report_t load(const tps25751_sim_timing_t *p_timing, uint32_t max_write_length, bool is_corrupt)
+{
+    load_report_t report;
+
+    tps25751_sim_init();
+    tps25751_sim_set_timing(p_timing);
+    if (is_corrupt)
+    {
+        tps25751_sim_corrupt_patch();
+    }
+
+    s_config.max_write_length = max_write_length;
+    tps25751_handler_t *h     = tps25751_init(&s_config);
+    TEST_ASSERT_NOT_NULL(h);
+
+    report.result      = tps25751_load_patch_bundle(h, s_patch, PATCH_LENGTH);
+    report.total_us    = (uint32_t) tps25751_sim_now_us();
+    report.overhead_us = report.total_us - least_load_us(p_timing, max_write_length);
+
+    return report;
+}
+
+TEST_GROUP(Tps25751Patch);
+
+TEST_SETUP(Tps25751Patch)
+{
+    for (uint32_t i = 0; i < PATCH_LENGTH; i++)
+    {
+        s_patch[i] = (uint8_t) (i * 7 + (i >> 8));
+    }
+}
+
+TEST_TEAR_DOWN(Tps25751Patch)
+{
+    s_config.max_write_length = 0;
+}
+
+TEST(Tps25751Patch, test_patch_is_streamed_in_longest_bursts)
+{
+    uint32_t hash;
+
+    TEST_ASSERT_EQUAL(0, load(&s_normal, BURST_LENGTH, false).result);
+    TEST_ASSERT_TRUE(tps25751_sim_is_patched(&hash));
+    TEST_ASSERT_EQUAL_HEX32(tps25751_sim_patch_hash(s_patch, PATCH_LENGTH), hash);
+    TEST_ASSERT_EQUAL(BURST_LENGTH, tps25751_sim_longest_patch_write());
+
+    // Without a limit the patch goes in one write
+    TEST_ASSERT_EQUAL(0, load(&s_normal, 0, false).result);
+    TEST_ASSERT_TRUE(tps25751_sim_is_patched(&hash));
+    TEST_ASSERT_EQUAL_HEX32(tps25751_sim_patch_hash(s_patch, PATCH_LENGTH), hash);
+    TEST_ASSERT_EQUAL(PATCH_LENGTH, tps25751_sim_longest_patch_write());
+}
+
+TEST(Tps25751Patch, test_load_times)
+{
+    uint32_t hash;
+
+    load_report_t normal = load(&s_normal, BURST_LENGTH, false);
+    TEST_ASSERT_EQUAL(0, normal.result);
+    TEST_ASSERT_TRUE(tps25751_sim_is_patched(&hash));
+
+    load_report_t slow = load(&s_slow, BURST_LENGTH, false);
+    TEST_ASSERT_EQUAL(0, slow.result);
+    TEST_ASSERT_TRUE(tps25751_sim_is_patched(&hash));
+
+    load_report_t failed = load(&s_normal, BURST_LENGTH, true);
+    TEST_ASSERT_EQUAL(-E_TPS25751_STATE, failed.result);
+    TEST_ASSERT_FALSE(tps25751_sim_is_patched(&hash));
+
+    printf("%-8s %10s %12s\n", "patch", "total [ms]", "overhead [ms]");
+    printf("%-8s %10.1f %12.1f\n", "normal", normal.total_us / 1000.0, normal.overhead_us / 1000.0);
+    printf("%-8s %10.1f %12.1f\n", "slow", slow.total_us / 1000.0, slow.overhead_us / 1000.0);
+    printf("%-8s %10.1f\n", "failed", failed.total_us / 1000.0);
+
+    // What's left besides the bus and the device are the delays of the reference manual and the last poll intervals
+    TEST_ASSERT_LESS_THAN(20000, normal.overhead_us);
+    TEST_ASSERT_LESS_THAN(30000, slow.overhead_us);
+}
+
+TEST_GROUP_RUNNER(Tps25751Patch)
+{
+    RUN_TEST_CASE(Tps25751Patch, test_patch_is_streamed_in_longest_bursts);
+
+    RUN_TEST_CASE(Tps25751Patch, test_load_times);
+}
@@ -0,0 +1,394 @@
+#include <string.h>
+
+#include "tps25751.h"
+#include "tps25751_sim.h"
+
+#define REG_MODE         0x03
+#define REG_CMD1         0x08
+#define REG_DATA1        0x09
+#define REG_INT_EVENT1   0x14
+#define REG_INT_MASK1    0x16
+#define REG_INT_CLEAR1   0x18
+#define REG_STATUS       0x1A
+#define REG_BOOT_FLAGS   0x2D
+#define REG_POWER_STATUS 0x3F
+#define INT_REG_SIZE     11
+#define DATA1_SIZE       64
+
+/* Of the events handled by the driver only the plug event is enabled after a reset */
+#define DEFAULT_EVENT_MASK (TPS25751_EVENT_PLUG_INSERT_OR_REMOVAL)
+
+/* Byte 10 of INT_EVENT1, the patch events aren't maskable */
+#define PATCH_LOADED    0x01
+#define READY_FOR_PATCH 0x02
+
+/* 9 clocks per byte at 100 kHz, see USB_PD_I2C_TIMING */
+#define BUS_US_PER_BYTE 90u
+
+/* Task return code of PBMc if the bundle doesn't match what PBMs announced */
+#define PBMC_DOWNLOAD_ERROR 0x04
+
+tps25751_sim_stats_t tps25751_sim_stats;
+
+static const tps25751_sim_timing_t s_default_timing = {
+    .command_us     = 800,
+    .patch_mode_us  = 5000,
+    .patch_apply_us = 30000,
+};
+
+static struct
+{
+    uint8_t  status[5];
+    uint8_t  power_status[2];
+    uint32_t int_event;
+    uint32_t int_mask;
+
+    uint64_t              now_us;
+    tps25751_sim_timing_t timing;
+    bool                  is_patch_corrupt;
+
+    char     mode[4];
+    uint8_t  patch_events;
+    uint64_t mode_change_at_us;
+    char     next_mode[4];
+    uint8_t  next_patch_events;
+
+    char     command[4];
+    uint64_t command_done_at_us;
+    bool     is_command_pending;
+    uint8_t  data1_in[DATA1_SIZE];
+    uint8_t  data1_out[DATA1_SIZE];
+
+    bool     is_downloading;
+    uint32_t patch_expected;
+    uint32_t patch_received;
+    uint32_t patch_hash;
+    uint32_t longest_patch_write;
+    uint8_t  boot_flags[5];
+} s_sim;
+
+static void raise(uint32_t events)
+{
+    s_sim.int_event |= events & s_sim.int_mask;
+}
+
+static void put_u32(uint8_t *p_register, uint32_t value)
+{
+    memset(p_register, 0, INT_REG_SIZE);
+    for (int i = 0; i < 4; i++)
+    {
+        p_register[i] = (uint8_t) (value >> (8 * i));
+    }
+}
+
+static uint32_t get_u32(const uint8_t *p_register)
+{
+    return (uint32_t) p_register[0] | ((uint32_t) p_register[1] << 8) | ((uint32_t) p_register[2] << 16) |
+           ((uint32_t) p_register[3] << 24);
+}
+
+static void schedule_mode(const char *mode, uint8_t patch_events, uint64_t after_us)
+{
+    memcpy(s_sim.next_mode, mode, 4);
+    s_sim.next_patch_events = patch_events;
+    s_sim.mode_change_at_us = s_sim.now_us + after_us;
+}
+
+static uint32_t hash(uint32_t h, const uint8_t *p_data, uint32_t length)
+{
+    for (uint32_t i = 0; i < length; i++)
+    {
+        h = (h ^ p_data[i]) * 16777619u;
+    }
+    return h;
+}
+
+static void execute(void)
+{
+    memset(s_sim.data1_out, 0, sizeof(s_sim.data1_out));
+
+    if (memcmp(s_sim.command, "GO2P", 4) == 0)
+    {
+        schedule_mode("PTCH", READY_FOR_PATCH, s_sim.timing.patch_mode_us);
+    }
+    else if (memcmp(s_sim.command, "PBMs", 4) == 0 && memcmp(s_sim.mode, "PTCH", 4) == 0)
+    {
+        s_sim.is_downloading      = true;
+        s_sim.patch_expected      = get_u32(s_sim.data1_in);
+        s_sim.patch_received      = 0;
+        s_sim.patch_hash          = 2166136261u;
+        s_sim.longest_patch_write = 0;
+    }
+    else if (memcmp(s_sim.command, "PBMc", 4) == 0 && s_sim.is_downloading)
+    {
+        s_sim.is_downloading = false;
+        if (s_sim.is_patch_corrupt || s_sim.patch_received != s_sim.patch_expected)
+        {
+            s_sim.data1_out[0]  = PBMC_DOWNLOAD_ERROR;
+            s_sim.boot_flags[1] |= 0x04;
+        }
+        else
+        {
+            schedule_mode("APP ", PATCH_LOADED, s_sim.timing.patch_apply_us);
+        }
+    }
+    else if (memcmp(s_sim.command, "PBMe", 4) == 0)
+    {
+        s_sim.is_downloading = false;
+    }
+    else
+    {
+        memcpy(s_sim.command, "!CMD", 4);
+        return;
+    }
+
+    memset(s_sim.command, 0, sizeof(s_sim.command));
+}
+
+/* Catches up with everything due by now */
+static void update(void)
+{
+    if (s_sim.is_command_pending && s_sim.now_us >= s_sim.command_done_at_us)
+    {
+        s_sim.is_command_pending = false;
+        execute();
+    }
+
+    if (s_sim.mode_change_at_us != 0 && s_sim.now_us >= s_sim.mode_change_at_us)
+    {
+        s_sim.mode_change_at_us = 0;
+        memcpy(s_sim.mode, s_sim.next_mode, 4);
+        s_sim.patch_events |= s_sim.next_patch_events;
+    }
+}
+
+uint32_t tps25751_sim_transfer_us(uint32_t length)
+{
+    /* Device address and register address come on top */
+    return (2 + length) * BUS_US_PER_BYTE;
+}
+
+static void bus_transfer(uint32_t length)
+{
+    s_sim.now_us += tps25751_sim_transfer_us(length);
+    tps25751_sim_stats.bytes += 1 + length;
+    update();
+}
+
+void tps25751_sim_init(void)
+{
+    memset(&s_sim, 0, sizeof(s_sim));
+    s_sim.int_mask = DEFAULT_EVENT_MASK;
+    s_sim.timing   = s_default_timing;
+    memcpy(s_sim.mode, "APP ", 4);
+    tps25751_sim_reset_stats();
+}
+
+void tps25751_sim_reset_stats(void)
+{
+    memset(&tps25751_sim_stats, 0, sizeof(tps25751_sim_stats));
+}
+
+void tps25751_sim_attach(bool partner_is_source)
+{
+    s_sim.status[0] |= 0x01;
+    /* Without a power contract the port takes the role opposite to the partner */
+    s_sim.power_status[0] = partner_is_source ? 0x00 : 0x02;
+    raise(TPS25751_EVENT_PLUG_INSERT_OR_REMOVAL | TPS25751_EVENT_STATUS_UPDATE);
+}
+
+void tps25751_sim_detach(void)
+{
+    s_sim.status[0] &= (uint8_t) ~0x01;
+    s_sim.power_status[0] = 0x00;
+    raise(TPS25751_EVENT_PLUG_INSERT_OR_REMOVAL | TPS25751_EVENT_STATUS_UPDATE |
+          TPS25751_EVENT_POWER_STATUS_UPDATE);
+}
+
+void tps25751_sim_power_contract(void)
+{
+    s_sim.power_status[0] |= 0x01;
+    raise(TPS25751_EVENT_POWER_STATUS_UPDATE);
+}
+
+void tps25751_sim_pr_swap(void)
+{
+    s_sim.power_status[0] ^= 0x02;
+    raise(TPS25751_EVENT_PR_SWAP_COMPLETE | TPS25751_EVENT_POWER_STATUS_UPDATE);
+}
+
+void tps25751_sim_reset(void)
+{
+    s_sim.int_event = 0;
+    s_sim.int_mask  = DEFAULT_EVENT_MASK;
+}
+
+void tps25751_sim_set_timing(const tps25751_sim_timing_t *p_timing)
+{
+    s_sim.timing = *p_timing;
+}
+
+void tps25751_sim_corrupt_patch(void)
+{
+    s_sim.is_patch_corrupt = true;
+}
+
+bool tps25751_sim_is_plug_connected(void)
+{
+    return (s_sim.status[0] & 0x01) != 0;
+}
+
+bool tps25751_sim_is_power_connected(void)
+{
+    return (s_sim.power_status[0] & 0x01) != 0;
+}
+
+bool tps25751_sim_is_source(void)
+{
+    return (s_sim.power_status[0] & 0x02) != 0;
+}
+
+uint32_t tps25751_sim_pending_events(void)
+{
+    return s_sim.int_event;
+}
+
+bool tps25751_sim_is_patched(uint32_t *p_hash)
+{
+    update();
+    *p_hash = s_sim.patch_hash;
+    return (s_sim.patch_events & PATCH_LOADED) != 0 && memcmp(s_sim.mode, "APP ", 4) == 0;
+}
+
+uint32_t tps25751_sim_patch_hash(const uint8_t *p_patch, uint32_t length)
+{
+    return hash(2166136261u, p_patch, length);
+}
+
+uint32_t tps25751_sim_longest_patch_write(void)
+{
+    return s_sim.longest_patch_write;
+}
+
+uint64_t tps25751_sim_now_us(void)
+{
+    return s_sim.now_us;
+}
+
+int tps25751_sim_i2c_read(uint8_t i2c_address, uint8_t register_address, uint8_t *p_data, uint32_t length)
+{
+    uint8_t register_data[DATA1_SIZE] = {0};
+    uint8_t size;
+
+    (void) i2c_address;
+    tps25751_sim_stats.reads++;
+    bus_transfer(length);
+
+    switch (register_address)
+    {
+        case REG_MODE:
+            memcpy(register_data, s_sim.mode, 4);
+            size = 4;
+            break;
+        case REG_CMD1:
+            memcpy(register_data, s_sim.command, 4);
+            size = 4;
+            break;
+        case REG_DATA1:
+            memcpy(register_data, s_sim.data1_out, DATA1_SIZE);
+            size = DATA1_SIZE;
+            break;
+        case REG_INT_EVENT1:
+            put_u32(register_data, s_sim.int_event);
+            register_data[10] = s_sim.patch_events;
+            size              = INT_REG_SIZE;
+            break;
+        case REG_INT_MASK1:
+            put_u32(register_data, s_sim.int_mask);
+            size = INT_REG_SIZE;
+            break;
+        case REG_STATUS:
+            memcpy(register_data, s_sim.status, sizeof(s_sim.status));
+            size = sizeof(s_sim.status);
+            break;
+        case REG_BOOT_FLAGS:
+            memcpy(register_data, s_sim.boot_flags, sizeof(s_sim.boot_flags));
+            size = sizeof(s_sim.boot_flags);
+            break;
+        case REG_POWER_STATUS:
+            memcpy(register_data, s_sim.power_status, sizeof(s_sim.power_status));
+            size = sizeof(s_sim.power_status);
+            break;
+        default:
+            return -1;
+    }
+
+    /* The first byte is the register size, shorter reads return the beginning of the register */
+    p_data[0] = size;
+    for (uint32_t i = 1; i < length; i++)
+    {
+        p_data[i] = i - 1 < size ? register_data[i - 1] : 0;
+    }
+    return 0;
+}
+
+int tps25751_sim_i2c_write(uint8_t i2c_address, uint8_t register_address, const uint8_t *p_data, uint32_t length)
+{
+    (void) i2c_address;
+    tps25751_sim_stats.writes++;
+    bus_transfer(length);
+
+    switch (register_address)
+    {
+        case REG_CMD1:
+            if (length != 5 || p_data[0] != 4)
+            {
+                return -1;
+            }
+            memcpy(s_sim.command, &p_data[1], 4);
+            s_sim.is_command_pending = true;
+            s_sim.command_done_at_us = s_sim.now_us + s_sim.timing.command_us;
+            return 0;
+        case REG_DATA1:
+            /* While downloading everything written is patch data */
+            if (s_sim.is_downloading)
+            {
+                s_sim.patch_hash = hash(s_sim.patch_hash, p_data, length);
+                s_sim.patch_received += length;
+                if (length > s_sim.longest_patch_write)
+                {
+                    s_sim.longest_patch_write = length;
+                }
+                return 0;
+            }
+            if (length < 1 || length > DATA1_SIZE + 1 || p_data[0] != length - 1)
+            {
+                return -1;
+            }
+            memcpy(s_sim.data1_in, &p_data[1], length - 1);
+            return 0;
+        case REG_INT_CLEAR1:
+        case REG_INT_MASK1:
+            if (length < 5 || p_data[0] != INT_REG_SIZE)
+            {
+                return -1;
+            }
+            if (register_address == REG_INT_CLEAR1)
+            {
+                s_sim.int_event &= ~get_u32(&p_data[1]);
+            }
+            else
+            {
+                s_sim.int_mask = get_u32(&p_data[1]);
+            }
+            return 0;
+        default:
+            return -1;
+    }
+}
+
+void tps25751_sim_sleep(uint32_t ms)
+{
+    s_sim.now_us += (uint64_t) ms * 1000;
+    update();
+}
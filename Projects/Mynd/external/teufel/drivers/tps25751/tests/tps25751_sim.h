@@ -0,0 +1,57 @@
+#pragma once
+
+/* Host model of the TPS25751 registers used by the status, event and patch functions of the driver. Time passes with
+   the bytes on the bus and with the sleeps of the driver. */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct
+{
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t bytes; /* on the bus, including the register address */
+} tps25751_sim_stats_t;
+
+extern tps25751_sim_stats_t tps25751_sim_stats;
+
+typedef struct
+{
+    uint32_t command_us;     /* until a 4CC command is done */
+    uint32_t patch_mode_us;  /* from GO2P until the device is ready for the patch */
+    uint32_t patch_apply_us; /* from PBMc until the patch is loaded and the device is back in app mode */
+} tps25751_sim_timing_t;
+
+void tps25751_sim_init(void);
+void tps25751_sim_reset_stats(void);
+
+/* Port state changes, raising the events the datasheet lists for them if they are enabled in INT_MASK1 */
+void tps25751_sim_attach(bool partner_is_source);
+void tps25751_sim_detach(void);
+void tps25751_sim_power_contract(void);
+void tps25751_sim_pr_swap(void);
+
+/* Reset of the PD controller, the event mask returns to its default */
+void tps25751_sim_reset(void);
+
+void tps25751_sim_set_timing(const tps25751_sim_timing_t *p_timing);
+
+/* The device rejects the next patch bundle at PBMc and flags the download error */
+void tps25751_sim_corrupt_patch(void);
+
+bool     tps25751_sim_is_plug_connected(void);
+bool     tps25751_sim_is_power_connected(void);
+bool     tps25751_sim_is_source(void);
+uint32_t tps25751_sim_pending_events(void);
+bool     tps25751_sim_is_patched(uint32_t *p_hash);
+uint32_t tps25751_sim_patch_hash(const uint8_t *p_patch, uint32_t length);
+uint32_t tps25751_sim_longest_patch_write(void);
+uint64_t tps25751_sim_now_us(void);
+
+/* Time on the bus for a write or read of length bytes */
+uint32_t tps25751_sim_transfer_us(uint32_t length);
+
+/* I2C functions for tps25751_config_t */
+int tps25751_sim_i2c_read(uint8_t i2c_address, uint8_t register_address, uint8_t *p_data, uint32_t length);
+int tps25751_sim_i2c_write(uint8_t i2c_address, uint8_t register_address, const uint8_t *p_data, uint32_t length);
+void tps25751_sim_sleep(uint32_t ms);
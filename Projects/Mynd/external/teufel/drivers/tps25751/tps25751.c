@@ -38,18 +38,33 @@
 #define TPS25751_REG_GPIO_STATUS         (0x72)
 #define TPS25751_REG_MOISTURE_DETECTION  (0x98)
 
+// Byte 10 of INT_EVENT1
+#define TPS25751_PATCH_EVENT_PATCH_LOADED    (0x01)
+#define TPS25751_PATCH_EVENT_READY_FOR_PATCH (0x02)
+
+// Polling starts at 1 ms and backs off to this interval
+#define TPS25751_POLL_INTERVAL_MAX_MS  (8)
+#define TPS25751_PATCH_MODE_TIMEOUT_MS (250)
+#define TPS25751_PATCH_LOAD_TIMEOUT_MS (500)
+
 struct tps25751_handler
 {
     tps25751_i2c_read_fn     i2c_read_fn;
     tps25751_i2c_write_fn    i2c_write_fn;
     tps25751_thread_sleep_fn thread_sleep_fn;
     uint8_t                  i2c_device_address;
+    uint32_t                 max_write_length;
 };
 
+// Returns 1 once the condition is met, 0 while it isn't yet and a negative error to stop polling
+typedef int (*tps25751_poll_check_fn)(const tps25751_handler_t *h, const void *p_arg);
+
 static int tps25751_read_register(const tps25751_handler_t *h, uint8_t register_address, uint8_t *p_data,
                                   uint32_t length);
 static int tps25751_write_register(const tps25751_handler_t *h, uint8_t register_address, const uint8_t *p_data,
                                    uint32_t length);
+static int tps25751_poll(const tps25751_handler_t *h, tps25751_poll_check_fn check, const void *p_arg,
+                         uint32_t timeout_ms);
 
 tps25751_handler_t *tps25751_init(const tps25751_config_t *p_config)
 {
@@ -78,6 +93,7 @@ tps25751_handler_t *tps25751_init(const tps25751_config_t *p_config)
     h->i2c_write_fn       = p_config->i2c_write_fn;
     h->thread_sleep_fn    = p_config->thread_sleep_fn;
     h->i2c_device_address = p_config->i2c_device_address;
+    h->max_write_length   = p_config->max_write_length;
     return h;
 }
 
@@ -189,10 +205,217 @@ int tps25751_get_power_status(const tps25751_handler_t *h, tps25751_power_status
     return E_TPS25751_OK;
 }
 
-int tps25751_load_patch_bundle(const tps25751_handler_t *h, const uint8_t *p_patch_data, uint32_t patch_length)
+int tps25751_get_events(const tps25751_handler_t *h, uint32_t *p_events)
+{
+    // 1 byte for byte count, only the first 4 of the 11 bytes of the register
+    uint8_t data[5] = {0};
+
+    if (tps25751_read_register(h, TPS25751_REG_INT_EVENT1, data, 5) != 0)
+    {
+        return -E_TPS25751_IO;
+    }
+
+    *p_events =
+        (uint32_t) data[1] | ((uint32_t) data[2] << 8) | ((uint32_t) data[3] << 16) | ((uint32_t) data[4] << 24);
+
+    log_debug("Events: 0x%08lX", (unsigned long) *p_events);
+
+    return E_TPS25751_OK;
+}
+
+int tps25751_clear_events(const tps25751_handler_t *h, uint32_t events)
+{
+    // 1 byte for byte count, 11 bytes for register
+    uint8_t data[12] = {11,
+                        (uint8_t) (events & 0xFF),
+                        (uint8_t) ((events >> 8) & 0xFF),
+                        (uint8_t) ((events >> 16) & 0xFF),
+                        (uint8_t) ((events >> 24) & 0xFF)};
+
+    if (tps25751_write_register(h, TPS25751_REG_INT_CLEAR1, data, 12) != 0)
+    {
+        return -E_TPS25751_IO;
+    }
+
+    return E_TPS25751_OK;
+}
+
+int tps25751_set_event_mask(const tps25751_handler_t *h, uint32_t events)
+{
+    // 1 byte for byte count, 11 bytes for register
+    uint8_t data[12] = {0};
+
+    // The upper bytes hold the patch events, they are kept as they are
+    if (tps25751_read_register(h, TPS25751_REG_INT_MASK1, data, 12) != 0)
+    {
+        return -E_TPS25751_IO;
+    }
+
+    data[0] = 11;
+    data[1] = (uint8_t) (events & 0xFF);
+    data[2] = (uint8_t) ((events >> 8) & 0xFF);
+    data[3] = (uint8_t) ((events >> 16) & 0xFF);
+    data[4] = (uint8_t) ((events >> 24) & 0xFF);
+
+    if (tps25751_write_register(h, TPS25751_REG_INT_MASK1, data, 12) != 0)
+    {
+        return -E_TPS25751_IO;
+    }
+
+    return E_TPS25751_OK;
+}
+
+int tps25751_port_read_status(const tps25751_handler_t *h, tps25751_port_t *p_port,
+                              const tps25751_port_callbacks_t *p_callbacks, uint32_t events)
+{
+    int ret = E_TPS25751_OK;
+
+    if (events & TPS25751_PORT_STATUS_EVENTS)
+    {
+        tps25751_status_t status;
+        if (tps25751_get_device_status(h, &status) == 0)
+        {
+            if (p_port->is_plug_connected != status.is_plug_connected)
+            {
+                p_port->is_plug_connected = status.is_plug_connected;
+                if (p_callbacks->plug_connection_change_cb)
+                {
+                    p_callbacks->plug_connection_change_cb(p_port->is_plug_connected);
+                }
+            }
+        }
+        else
+        {
+            log_error("Failed to get status");
+            ret = -E_TPS25751_IO;
+        }
+    }
+
+    if (events & TPS25751_PORT_POWER_STATUS_EVENTS)
+    {
+        tps25751_power_status_t power_status;
+        if (tps25751_get_power_status(h, &power_status) == 0)
+        {
+            if (p_port->is_power_connected != power_status.connection_present)
+            {
+                p_port->is_power_connected = power_status.connection_present;
+                if (p_callbacks->power_connection_change_cb)
+                {
+                    p_callbacks->power_connection_change_cb(p_port->is_power_connected);
+                }
+            }
+
+            // The power status carries the PD role as well, no need for the PD status register
+            if (p_port->is_source != (power_status.pd_role == TPS25751_PD_ROLE_SOURCE))
+            {
+                p_port->is_source = (power_status.pd_role == TPS25751_PD_ROLE_SOURCE);
+                if (p_callbacks->pd_role_change_cb)
+                {
+                    p_callbacks->pd_role_change_cb(p_port->is_source);
+                }
+            }
+        }
+        else
+        {
+            log_error("Failed to get power status");
+            ret = -E_TPS25751_IO;
+        }
+    }
+
+    return ret;
+}
+
+int tps25751_port_poll(const tps25751_handler_t *h, tps25751_port_t *p_port,
+                       const tps25751_port_callbacks_t *p_callbacks)
+{
+    // Enabled on every poll, the PD controller forgets the mask when it's reset
+    p_port->are_events_enabled = tps25751_set_event_mask(h, TPS25751_PORT_EVENTS) == 0;
+    if (!p_port->are_events_enabled)
+    {
+        log_error("Failed to enable events");
+    }
+
+    if (tps25751_port_read_status(h, p_port, p_callbacks, TPS25751_PORT_EVENTS) != 0 || !p_port->are_events_enabled)
+    {
+        return -E_TPS25751_IO;
+    }
+
+    return E_TPS25751_OK;
+}
+
+bool tps25751_port_process_events(const tps25751_handler_t *h, tps25751_port_t *p_port,
+                                  const tps25751_port_callbacks_t *p_callbacks, bool is_vbus_edge)
+{
+    if (!p_port->are_events_enabled)
+    {
+        tps25751_port_poll(h, p_port, p_callbacks);
+        return p_port->are_events_enabled;
+    }
+
+    uint32_t events;
+    if (tps25751_get_events(h, &events) != 0)
+    {
+        log_error("Failed to get events");
+        return false;
+    }
+
+    events &= TPS25751_PORT_EVENTS;
+    if (events == 0)
+    {
+        // Any change of VBUS raises an event, none means the events are masked again after a reset
+        if (is_vbus_edge)
+        {
+            log_warning("VBUS changed without events, polling");
+            tps25751_port_poll(h, p_port, p_callbacks);
+            return true;
+        }
+        return false;
+    }
+
+    // Cleared before reading the status, a change in between raises the event again instead of getting lost
+    if (tps25751_clear_events(h, events) != 0)
+    {
+        log_error("Failed to clear events");
+    }
+
+    tps25751_port_read_status(h, p_port, p_callbacks, events);
+    return true;
+}
+
+static int tps25751_check_patch_event(const tps25751_handler_t *h, const void *p_arg)
 {
     uint8_t data[12] = {0};
-    int     retries;
+
+    // A failed read is retried with the next poll
+    if (tps25751_read_register(h, TPS25751_REG_INT_EVENT1, data, 12) != 0)
+    {
+        return 0;
+    }
+
+    return (data[11] & *(const uint8_t *) p_arg) != 0;
+}
+
+static int tps25751_check_device_mode(const tps25751_handler_t *h, const void *p_arg)
+{
+    tps25751_device_mode_t mode;
+
+    if (tps25751_get_device_mode(h, &mode) != 0)
+    {
+        return 0;
+    }
+
+    return mode == *(const tps25751_device_mode_t *) p_arg;
+}
+
+int tps25751_load_patch_bundle(const tps25751_handler_t *h, const uint8_t *p_patch_data, uint32_t patch_length)
+{
+    static const uint8_t                ready_for_patch = TPS25751_PATCH_EVENT_READY_FOR_PATCH;
+    static const uint8_t                patch_loaded    = TPS25751_PATCH_EVENT_PATCH_LOADED;
+    static const tps25751_device_mode_t patch_mode      = TPS25751_DEVICE_MODE_PATCH;
+    static const tps25751_device_mode_t app_mode        = TPS25751_DEVICE_MODE_APP;
+
+    uint8_t               data[12] = {0};
+    tps25751_boot_flags_t boot_flags;
 
     // Send 'GO2P' 4CC command
     if (tps25751_send_4cc_command(h, "GO2P", 5000) != 0)
@@ -215,44 +438,14 @@ int tps25751_load_patch_bundle(const tps25751_handler_t *h, const uint8_t *p_pat
     }
 
     // Wait until the PD controller is ready to be patched
-    retries = 3;
-    do
-    {
-        if (tps25751_read_register(h, TPS25751_REG_INT_EVENT1, data, 12) == 0)
-        {
-            bool ready_for_patch = ((data[11] >> 1) & 0x01) == 1;
-            if (ready_for_patch)
-            {
-                break;
-            }
-        }
-        h->thread_sleep_fn(10);
-        retries--;
-    } while (retries > 0);
-
-    if (retries == 0)
+    if (tps25751_poll(h, tps25751_check_patch_event, &ready_for_patch, TPS25751_PATCH_MODE_TIMEOUT_MS) != 0)
     {
         log_error("PD controller is not ready for patch");
         return -E_TPS25751_STATE;
     }
 
     // Make sure the device is in patch mode
-    retries = 3;
-    do
-    {
-        tps25751_device_mode_t mode;
-        if (tps25751_get_device_mode(h, &mode) == 0)
-        {
-            if (mode == TPS25751_DEVICE_MODE_PATCH)
-            {
-                break;
-            }
-        }
-        h->thread_sleep_fn(10);
-        retries--;
-    } while (retries > 0);
-
-    if (retries == 0)
+    if (tps25751_poll(h, tps25751_check_device_mode, &patch_mode, TPS25751_PATCH_MODE_TIMEOUT_MS) != 0)
     {
         log_error("PD controller is not in patch mode");
         return -E_TPS25751_STATE;
@@ -292,17 +485,24 @@ int tps25751_load_patch_bundle(const tps25751_handler_t *h, const uint8_t *p_pat
         return -E_TPS25751_STATE;
     }
 
-    if (tps25751_write_register(h, TPS25751_REG_DATA1, p_patch_data, patch_length) != 0)
+    // Stream the patch in the longest writes the transport takes, each write costs the addressing on top
+    uint32_t burst_length = (h->max_write_length != 0) ? h->max_write_length : patch_length;
+    for (uint32_t offset = 0; offset < patch_length; offset += burst_length)
     {
-        log_error("Failed to write patch data");
+        uint32_t length = (patch_length - offset < burst_length) ? patch_length - offset : burst_length;
 
-        // End the download sequence
-        tps25751_send_4cc_command(h, "PBMe", 5000);
-        return -E_TPS25751_IO;
+        if (tps25751_write_register(h, TPS25751_REG_DATA1, &p_patch_data[offset], length) != 0)
+        {
+            log_error("Failed to write patch data at offset %lu", (unsigned long) offset);
+
+            // End the download sequence
+            tps25751_send_4cc_command(h, "PBMe", 5000);
+            return -E_TPS25751_IO;
+        }
     }
 
-    // Delay at least 500 us according to reference manual
-    h->thread_sleep_fn(10);
+    // Delay at least 500 us according to reference manual, a 1 ms sleep may end with the next tick already
+    h->thread_sleep_fn(2);
 
     if (tps25751_send_4cc_command(h, "PBMc", 5000) != 0)
     {
@@ -329,49 +529,33 @@ int tps25751_load_patch_bundle(const tps25751_handler_t *h, const uint8_t *p_pat
     }
 
     // Make sure the patch is loaded
-    retries = 3;
-    do
-    {
-        if (tps25751_read_register(h, TPS25751_REG_INT_EVENT1, data, 12) == 0)
-        {
-            bool patch_loaded = (data[11] & 0x01) == 1;
-            if (patch_loaded)
-            {
-                break;
-            }
-        }
-        h->thread_sleep_fn(10);
-        retries--;
-    } while (retries > 0);
-
-    if (retries == 0)
+    if (tps25751_poll(h, tps25751_check_patch_event, &patch_loaded, TPS25751_PATCH_LOAD_TIMEOUT_MS) != 0)
     {
         log_error("Patch loading timed out");
         return -E_TPS25751_TIMEOUT;
     }
 
     // Make sure the device is in app mode
-    retries = 3;
-    do
-    {
-        tps25751_device_mode_t mode;
-        if (tps25751_get_device_mode(h, &mode) == 0)
-        {
-            if (mode == TPS25751_DEVICE_MODE_APP)
-            {
-                break;
-            }
-        }
-        h->thread_sleep_fn(10);
-        retries--;
-    } while (retries > 0);
-
-    if (retries == 0)
+    if (tps25751_poll(h, tps25751_check_device_mode, &app_mode, TPS25751_PATCH_LOAD_TIMEOUT_MS) != 0)
     {
         log_error("Switching to app mode timed out");
         return -E_TPS25751_TIMEOUT;
     }
 
+    // The device checks the bundle itself, a damaged one is only reported in the boot flags
+    if (tps25751_get_boot_flags(h, &boot_flags) != 0)
+    {
+        log_error("Failed to read boot flags");
+        return -E_TPS25751_IO;
+    }
+
+    if (boot_flags.patch_header_error_detected || boot_flags.patch_download_error_detected)
+    {
+        log_error("Patch rejected (header error: %d, download error: %d)", boot_flags.patch_header_error_detected,
+                  boot_flags.patch_download_error_detected);
+        return -E_TPS25751_STATE;
+    }
+
     log_info("PD controller patch downloaded successfully");
     return 0;
 }
@@ -381,6 +565,33 @@ int tps25751_clear_dead_battery_flag(const tps25751_handler_t *h)
     return tps25751_send_4cc_command(h, "DBfg", 1000);
 }
 
+static int tps25751_check_command_done(const tps25751_handler_t *h, const void *p_arg)
+{
+    uint8_t data[5] = {0};
+
+    (void) p_arg;
+
+    if (tps25751_read_register(h, TPS25751_REG_CMD1, data, 5) != 0)
+    {
+        log_error("Failed to read CMD1 register");
+        return -E_TPS25751_IO;
+    }
+
+    uint8_t zeroed_buffer[4] = {0, 0, 0, 0};
+    if (memcmp(&data[1], zeroed_buffer, 4) == 0)
+    {
+        return 1;
+    }
+
+    if (memcmp(&data[1], "!CMD", 4) == 0)
+    {
+        log_error("Command rejected");
+        return -E_TPS25751_IO;
+    }
+
+    return 0;
+}
+
 int tps25751_send_4cc_command(const tps25751_handler_t *h, const char *command, uint32_t timeout_ms)
 {
     uint8_t data[5] = {4, command[0], command[1], command[2], command[3]};
@@ -388,36 +599,15 @@ int tps25751_send_4cc_command(const tps25751_handler_t *h, const char *command,
     if (tps25751_write_register(h, TPS25751_REG_CMD1, data, 5) == 0)
     {
         // It takes around 500-800 us for the command to be processed
-        h->thread_sleep_fn(2);
+        h->thread_sleep_fn(1);
 
-        // Divided by 4 because we wait 4 ms between retries
-        uint32_t retries_left = timeout_ms / 4;
-        do
+        int error = tps25751_poll(h, tps25751_check_command_done, NULL, timeout_ms);
+        if (error == E_TPS25751_OK)
         {
-            if (tps25751_read_register(h, TPS25751_REG_CMD1, data, 5) != 0)
-            {
-                log_error("Failed to read CMD1 register");
-                break;
-            }
-
-            uint8_t zeroed_buffer[4] = {0, 0, 0, 0};
-            if (memcmp(&data[1], zeroed_buffer, 4) == 0)
-            {
-                return E_TPS25751_OK;
-            }
-
-            if (memcmp(&data[1], "!CMD", 4) == 0)
-            {
-                log_error("Command rejected");
-                break;
-            }
-
-            // Wait 4 ms before retrying
-            h->thread_sleep_fn(4);
-            retries_left--;
-        } while (retries_left > 0);
+            return E_TPS25751_OK;
+        }
 
-        if (retries_left == 0)
+        if (error == -E_TPS25751_TIMEOUT)
         {
             log_error("Command timed out");
             return -E_TPS25751_TIMEOUT;
@@ -809,6 +999,35 @@ static int tps25751_write_register(const tps25751_handler_t *h, uint8_t register
                                                                                            : -E_TPS25751_IO;
 }
 
+static int tps25751_poll(const tps25751_handler_t *h, tps25751_poll_check_fn check, const void *p_arg,
+                         uint32_t timeout_ms)
+{
+    uint32_t interval_ms = 1;
+    uint32_t waited_ms   = 0;
+
+    for (;;)
+    {
+        int result = check(h, p_arg);
+        if (result != 0)
+        {
+            return (result > 0) ? E_TPS25751_OK : result;
+        }
+
+        if (waited_ms >= timeout_ms)
+        {
+            return -E_TPS25751_TIMEOUT;
+        }
+
+        // Quick responses are seen after a millisecond, slow ones don't keep the bus busy
+        h->thread_sleep_fn(interval_ms);
+        waited_ms += interval_ms;
+        if (interval_ms < TPS25751_POLL_INTERVAL_MAX_MS)
+        {
+            interval_ms *= 2;
+        }
+    }
+}
+
 int tps25751_swap_pd_role_to_source(const tps25751_handler_t *h)
 {
     if (tps25751_send_4cc_command(h, "SWSr", 5000) != 0)
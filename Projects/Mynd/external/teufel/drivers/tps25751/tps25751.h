@@ -16,12 +16,29 @@ typedef void (*tps25751_thread_sleep_fn)(uint32_t ms);
 
 typedef struct tps25751_handler tps25751_handler_t;
 
+// Bits of the INT_EVENT1, INT_MASK1 and INT_CLEAR1 registers. Only the lower 32 of the 88 bits are handled here, the
+// patch related ones above are used by tps25751_load_patch_bundle() alone.
+#define TPS25751_EVENT_PLUG_INSERT_OR_REMOVAL (1UL << 3)
+#define TPS25751_EVENT_PR_SWAP_COMPLETE       (1UL << 4)
+#define TPS25751_EVENT_DR_SWAP_COMPLETE       (1UL << 5)
+#define TPS25751_EVENT_STATUS_UPDATE          (1UL << 26)
+#define TPS25751_EVENT_DATA_STATUS_UPDATE     (1UL << 27)
+#define TPS25751_EVENT_POWER_STATUS_UPDATE    (1UL << 28)
+#define TPS25751_EVENT_PD_STATUS_UPDATE       (1UL << 29)
+
+// Events which flag a change of the device status and of the power status respectively, see tps25751_port_t
+#define TPS25751_PORT_STATUS_EVENTS (TPS25751_EVENT_PLUG_INSERT_OR_REMOVAL | TPS25751_EVENT_STATUS_UPDATE)
+#define TPS25751_PORT_POWER_STATUS_EVENTS                                                                              \
+    (TPS25751_EVENT_PLUG_INSERT_OR_REMOVAL | TPS25751_EVENT_POWER_STATUS_UPDATE | TPS25751_EVENT_PR_SWAP_COMPLETE)
+#define TPS25751_PORT_EVENTS (TPS25751_PORT_STATUS_EVENTS | TPS25751_PORT_POWER_STATUS_EVENTS)
+
 typedef struct
 {
     tps25751_i2c_read_fn     i2c_read_fn;
     tps25751_i2c_write_fn    i2c_write_fn;
     tps25751_thread_sleep_fn thread_sleep_fn;
     uint8_t                  i2c_device_address;
+    uint32_t                 max_write_length; // Longest write the I2C transport takes, 0 if it has no limit
 } tps25751_config_t;
 
 typedef enum
@@ -196,6 +213,22 @@ typedef struct
     tps25751_charger_advertise_status_t charger_advertise_status;
 } tps25751_power_status_t;
 
+// What is known about the port, kept up to date by tps25751_port_poll() and tps25751_port_process_events()
+typedef struct
+{
+    bool is_plug_connected;
+    bool is_power_connected;
+    bool is_source; // PD role, false = sink, true = source
+    bool are_events_enabled;
+} tps25751_port_t;
+
+typedef struct
+{
+    void (*plug_connection_change_cb)(bool connected);
+    void (*power_connection_change_cb)(bool connected);
+    void (*pd_role_change_cb)(bool source);
+} tps25751_port_callbacks_t;
+
 /**
  * @brief Initializes the TPS25751 driver.
  *
@@ -245,11 +278,94 @@ int tps25751_get_boot_flags(const tps25751_handler_t *h, tps25751_boot_flags_t *
  */
 int tps25751_get_power_status(const tps25751_handler_t *h, tps25751_power_status_t *p_status);
 
+/**
+ * @brief Reads the pending events, see TPS25751_EVENT_*.
+ *
+ * @details The events stay pending until they are cleared with tps25751_clear_events().
+ *
+ * @param[in]  h            pointer to handler
+ * @param[out] p_events     pointer to variable where the events will be written to
+ *
+ * @return 0 if successful, -1 otherwise
+ */
+int tps25751_get_events(const tps25751_handler_t *h, uint32_t *p_events);
+
+/**
+ * @brief Clears the given events in a single register write.
+ *
+ * @details Only the events which were read are to be cleared, an event raised after the read stays pending.
+ *
+ * @param[in] h             pointer to handler
+ * @param[in] events        events to clear, see TPS25751_EVENT_*
+ *
+ * @return 0 if successful, -1 otherwise
+ */
+int tps25751_clear_events(const tps25751_handler_t *h, uint32_t events);
+
+/**
+ * @brief Selects the events which are latched and assert the interrupt line, see TPS25751_EVENT_*.
+ *
+ * @param[in] h             pointer to handler
+ * @param[in] events        events to enable, all others of the lower 32 bits are disabled
+ *
+ * @return 0 if successful, -1 otherwise
+ */
+int tps25751_set_event_mask(const tps25751_handler_t *h, uint32_t events);
+
+/**
+ * @brief Reads the status registers flagged in events and updates the port.
+ *
+ * @details The callbacks are called for every change, a NULL callback is skipped.
+ *
+ * @param[in]     h             pointer to handler
+ * @param[in,out] p_port        pointer to port
+ * @param[in]     p_callbacks   pointer to callbacks struct
+ * @param[in]     events        events to read the status for, see TPS25751_PORT_*_EVENTS
+ *
+ * @return 0 if successful, -1 otherwise
+ */
+int tps25751_port_read_status(const tps25751_handler_t *h, tps25751_port_t *p_port,
+                              const tps25751_port_callbacks_t *p_callbacks, uint32_t events);
+
+/**
+ * @brief Enables the port events and reads the complete status.
+ *
+ * @details Meant to be called periodically as a slow safety net for tps25751_port_process_events(), the PD controller
+ *          forgets the event mask when it's reset.
+ *
+ * @param[in]     h             pointer to handler
+ * @param[in,out] p_port        pointer to port
+ * @param[in]     p_callbacks   pointer to callbacks struct
+ *
+ * @return 0 if successful, -1 otherwise
+ */
+int tps25751_port_poll(const tps25751_handler_t *h, tps25751_port_t *p_port,
+                       const tps25751_port_callbacks_t *p_callbacks);
+
+/**
+ * @brief Reads the pending port events and only the status they flag.
+ *
+ * @details Meant to be called when the USB connection may have changed. Without pending events this is a single
+ *          register read. A VBUS edge without any pending event means the PD controller was reset and forgot the
+ *          event mask, the port is polled then, as it is while the events aren't enabled.
+ *
+ * @param[in]     h             pointer to handler
+ * @param[in,out] p_port        pointer to port
+ * @param[in]     p_callbacks   pointer to callbacks struct
+ * @param[in]     is_vbus_edge  true if called for a VBUS edge, e.g. the AC OK interrupt of the charger
+ *
+ * @return true if events were pending, more are likely to follow (e.g. the power contract after a plug)
+ */
+bool tps25751_port_process_events(const tps25751_handler_t *h, tps25751_port_t *p_port,
+                                  const tps25751_port_callbacks_t *p_callbacks, bool is_vbus_edge);
+
 /**
  * @brief Loads a patch bundle to the PD controller.
  *
  * @details This is a long running blocking call. It will put the current thread to sleep
- *          while waiting for the PD controller to process the patch update.
+ *          while waiting for the PD controller to process the patch update. The patch is written in
+ *          bursts of max_write_length bytes, in one go if there's no limit. Once the device is back in
+ *          app mode its boot flags are checked for a patch header or download error.
  *
  * @param[in] h                 pointer to handler
  * @param[in] p_patch_data      pointer to patch data
@@ -10,6 +10,8 @@ if(NOT (TARGET Actionslink))
             "${Actionslink_PATH}/src/api/actionslink.c"
             "${Actionslink_PATH}/src/api/actionslink.h"
             "${Actionslink_PATH}/src/api/actionslink_types.h"
+            "${Actionslink_PATH}/src/bringup/actionslink_bringup.c"
+            "${Actionslink_PATH}/src/bringup/actionslink_bringup.h"
             "${Actionslink_PATH}/src/decoders/actionslink_decoders.c"
             "${Actionslink_PATH}/src/decoders/actionslink_decoders.h"
             "${Actionslink_PATH}/src/encoders/actionslink_encoders.c"
@@ -18,8 +20,12 @@ if(NOT (TARGET Actionslink))
             "${Actionslink_PATH}/src/events/actionslink_events.h"
             "${Actionslink_PATH}/src/requests/actionslink_requests.c"
             "${Actionslink_PATH}/src/requests/actionslink_requests.h"
+            "${Actionslink_PATH}/src/sound_icons/actionslink_sound_icons.c"
+            "${Actionslink_PATH}/src/sound_icons/actionslink_sound_icons.h"
             "${Actionslink_PATH}/src/log/actionslink_log.c"
             "${Actionslink_PATH}/src/log/actionslink_log.h"
+            "${Actionslink_PATH}/src/notifications/actionslink_notifications.c"
+            "${Actionslink_PATH}/src/notifications/actionslink_notifications.h"
             "${Actionslink_PATH}/src/transport/actionslink_bt_ll.c"
             "${Actionslink_PATH}/src/transport/actionslink_bt_ll.h"
             "${Actionslink_PATH}/src/transport/actionslink_bt_ul.c"
@@ -27,15 +33,40 @@ if(NOT (TARGET Actionslink))
             "${Actionslink_PATH}/src/utils/actionslink_utils.c"
             "${Actionslink_PATH}/src/utils/actionslink_utils.h")
     target_include_directories(Actionslink INTERFACE "${Actionslink_PATH}/src/api")
+    target_include_directories(Actionslink INTERFACE "${Actionslink_PATH}/src/bringup")
     target_include_directories(Actionslink INTERFACE "${Actionslink_PATH}/src/decoders")
     target_include_directories(Actionslink INTERFACE "${Actionslink_PATH}/src/encoders")
     target_include_directories(Actionslink INTERFACE "${Actionslink_PATH}/src/events")
     target_include_directories(Actionslink INTERFACE "${Actionslink_PATH}/src/requests")
     target_include_directories(Actionslink INTERFACE "${Actionslink_PATH}/src/log")
+    target_include_directories(Actionslink INTERFACE "${Actionslink_PATH}/src/notifications")
+    target_include_directories(Actionslink INTERFACE "${Actionslink_PATH}/src/sound_icons")
     target_include_directories(Actionslink INTERFACE "${Actionslink_PATH}/src/transport")
     target_include_directories(Actionslink INTERFACE "${Actionslink_PATH}/src/utils")
 endif()
 
+if(NOT (TARGET Actionslink::Tests))
+    add_library(Actionslink::Tests INTERFACE IMPORTED)
+    target_sources(Actionslink::Tests INTERFACE
+            "${Actionslink_PATH}/tests/test_actionslink_bringup.cpp"
+            "${Actionslink_PATH}/tests/test_actionslink_bt_ll.cpp"
+            "${Actionslink_PATH}/tests/test_actionslink_encoders.cpp"
+            "${Actionslink_PATH}/tests/test_actionslink_notifications.cpp"
+            "${Actionslink_PATH}/tests/test_actionslink_protocol.cpp"
+            "${Actionslink_PATH}/tests/test_actionslink_rx_wakeup.cpp"
+            "${Actionslink_PATH}/tests/test_actionslink_sound_icons.cpp"
+            "${Actionslink_PATH}/tests/actionslink_chip_sim.cpp"
+            "${Actionslink_PATH}/tests/actionslink_chip_sim.h")
+    target_include_directories(Actionslink::Tests INTERFACE "${Actionslink_PATH}/tests")
+    target_link_libraries(Actionslink::Tests INTERFACE Actionslink)
+endif()
+
+if(NOT (TARGET Actionslink::Crc8SliceBy2))
+    add_library(Actionslink::Crc8SliceBy2 INTERFACE IMPORTED)
+    target_compile_definitions(Actionslink::Crc8SliceBy2 INTERFACE "-DACTIONSLINK_CRC8_SLICE_BY_2=1")
+    target_link_libraries(Actionslink::Crc8SliceBy2 INTERFACE Actionslink)
+endif()
+
 if(NOT (TARGET Actionslink::LogLevelOff))
     add_library(Actionslink::LogLevelOff INTERFACE IMPORTED)
     target_compile_definitions(Actionslink::LogLevelOff INTERFACE "-DACTIONSLINK_LOG_LEVEL=0")
@@ -18,6 +18,10 @@ if(NOT (TARGET Logger))
     target_sources(Logger INTERFACE
         "${Logger_PATH}/logger.h"
         "${Logger_PATH}/logger.c"
+        "${Logger_PATH}/logger_drain.h"
+        "${Logger_PATH}/logger_drain.c"
+        "${Logger_PATH}/logger_ring.h"
+        "${Logger_PATH}/logger_ring.c"
         "${Logger_PATH}/implementations/logger_weak_implementation.c"
     )
 endif()
@@ -28,6 +32,15 @@ if(NOT (TARGET Logger::Syscalls))
     target_link_libraries(Logger::Syscalls INTERFACE Logger)
 endif()
 
+if(NOT (TARGET Logger::Tests))
+    add_library(Logger::Tests INTERFACE IMPORTED)
+    target_sources(Logger::Tests INTERFACE
+        "${Logger_PATH}/tests/test_logger_drain.cpp"
+        "${Logger_PATH}/tests/test_logger_ring.cpp"
+    )
+    target_link_libraries(Logger::Tests INTERFACE Logger)
+endif()
+
 ###### Pre-defined Configs ######
 
 if(NOT (TARGET Logger::Config1))
@@ -1,5 +1,5 @@
 SET(LIBRARIES_COMPONENTS app_assert audio buffer cbuf circ_batch_buf circ_contiguous_buf cli core_utils crc8
-         dwt_profiler greeting hashmap_string llist menu power property sysaudio syscalls tshell util)
+         dwt_profiler greeting hashmap_string llist low_power menu power property sysaudio syscalls tshell util)
 
 
 set(LIBRARIES_PICKED_COMPONENTS "")
@@ -26,6 +26,7 @@ endforeach()
 
 set(TeufelLibraries_SOURCES "")
 set(TeufelLibraries_INCLUDE_DIR "")
+set(LIBRARIES_TEST_SOURCES "")
 
 # Add basic include
 list(APPEND TeufelLibraries_INCLUDE_DIR ${LIBRARIES_PATH})
@@ -51,6 +52,12 @@ if("circ_contiguous_buf" IN_LIST LIBRARIES_PICKED_COMPONENTS)
 endif()
 
 
+if("core_utils" IN_LIST LIBRARIES_PICKED_COMPONENTS)
+    # Header only, host tests
+    list(APPEND LIBRARIES_TEST_SOURCES ${LIBRARIES_PATH}/core_utils/tests/test_hysteresis.cpp)
+    list(APPEND LIBRARIES_TEST_SOURCES ${LIBRARIES_PATH}/core_utils/tests/test_startup_graph.cpp)
+endif()
+
 if("crc8" IN_LIST LIBRARIES_PICKED_COMPONENTS)
     list(APPEND TeufelLibraries_SOURCES ${LIBRARIES_PATH}/crc8/crc8.c)
 endif()
@@ -71,6 +78,12 @@ if("llist" IN_LIST LIBRARIES_PICKED_COMPONENTS)
     list(APPEND TeufelLibraries_SOURCES ${LIBRARIES_PATH}/llist/llist.c)
 endif()
 
+if("low_power" IN_LIST LIBRARIES_PICKED_COMPONENTS)
+    list(APPEND TeufelLibraries_SOURCES ${LIBRARIES_PATH}/low_power/low_power.c)
+    list(APPEND LIBRARIES_TEST_SOURCES ${LIBRARIES_PATH}/low_power/low_power.c)
+    list(APPEND LIBRARIES_TEST_SOURCES ${LIBRARIES_PATH}/low_power/tests/test_low_power_sim.cpp)
+endif()
+
 if("menu" IN_LIST LIBRARIES_PICKED_COMPONENTS)
     list(APPEND TeufelLibraries_SOURCES ${LIBRARIES_PATH}/menu/menu.c)
 endif()
@@ -89,6 +102,14 @@ if("tshell" IN_LIST LIBRARIES_PICKED_COMPONENTS)
     list(APPEND TeufelLibraries_SOURCES ${LIBRARIES_PATH}/tshell/tshell_printf.c)
 endif()
 
+# Host tests of the picked components, test_startup_graph.cpp includes the startup steps of the application from the
+# include directories of the test executable
+if(LIBRARIES_TEST_SOURCES AND NOT (TARGET TeufelLibraries::Tests))
+    add_library(TeufelLibraries::Tests INTERFACE IMPORTED)
+    target_sources(TeufelLibraries::Tests INTERFACE ${LIBRARIES_TEST_SOURCES})
+    target_include_directories(TeufelLibraries::Tests INTERFACE ${LIBRARIES_PATH} ${LIBRARIES_PATH}/low_power)
+endif()
+
 include(FindPackageHandleStandardArgs)
 
 FIND_PACKAGE_HANDLE_STANDARD_ARGS(TeufelLibraries DEFAULT_MSG TeufelLibraries_INCLUDE_DIR TeufelLibraries_SOURCES)
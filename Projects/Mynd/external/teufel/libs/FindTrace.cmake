@@ -0,0 +1,47 @@
+if (NOT TeufelLibsPath)
+    set(Trace_PATH ${CMAKE_CURRENT_SOURCE_DIR}/external/teufel/libs/trace)
+else()
+    set(Trace_PATH ${TeufelLibsPath}/trace)
+endif()
+
+find_path(Trace_COMMON_INCLUDE
+    NAMES "trace.h"
+    PATHS "${Trace_PATH}"
+    CMAKE_FIND_ROOT_PATH_BOTH
+)
+list(APPEND Trace_INCLUDE_DIRS "${Trace_COMMON_INCLUDE}")
+
+if(NOT (TARGET Trace))
+    add_library(Trace INTERFACE IMPORTED)
+    target_include_directories(Trace INTERFACE "${Trace_PATH}")
+    target_sources(Trace INTERFACE
+        "${Trace_PATH}/trace.h"
+        "${Trace_PATH}/trace.c"
+    )
+endif()
+
+# Host side decoder of the dumps, see README.md
+if(NOT (TARGET Trace::Decoder))
+    add_library(Trace::Decoder INTERFACE IMPORTED)
+    target_include_directories(Trace::Decoder INTERFACE "${Trace_PATH}")
+    target_sources(Trace::Decoder INTERFACE
+        "${Trace_PATH}/trace_decode.h"
+        "${Trace_PATH}/trace_decode.c"
+    )
+endif()
+
+if(NOT (TARGET Trace::Tests))
+    add_library(Trace::Tests INTERFACE IMPORTED)
+    target_sources(Trace::Tests INTERFACE
+        "${Trace_PATH}/tests/test_trace.cpp"
+        "${Trace_PATH}/tests/test_trace_decode.cpp"
+    )
+    target_link_libraries(Trace::Tests INTERFACE Trace Trace::Decoder)
+endif()
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Trace
+    REQUIRED_VARS Trace_INCLUDE_DIRS
+    FOUND_VAR Trace_FOUND
+    HANDLE_COMPONENTS
+)
@@ -18,6 +18,9 @@
 namespace Teufel::GenericThread
 {
 
+// Idle period of a thread without periodic work, it only wakes up for messages
+constexpr uint32_t IdleNever = UINT32_MAX;
+
 template <typename T>
 struct QueueMessage
 {
@@ -95,7 +98,7 @@ template <typename T>
     {
         while (true)
         {
-            vTaskDelay(pdMS_TO_TICKS(gthread->idle_ms));
+            vTaskDelay(gthread->idle_ms == IdleNever ? portMAX_DELAY : pdMS_TO_TICKS(gthread->idle_ms));
             if (config->Callback_Idle)
             {
                 config->Callback_Idle();
@@ -108,7 +111,8 @@ template <typename T>
 
         while (true)
         {
-            if (xQueueReceive(gthread->queue, (void *) &(msg), pdMS_TO_TICKS(gthread->idle_ms)))
+            TickType_t timeout = gthread->idle_ms == IdleNever ? portMAX_DELAY : pdMS_TO_TICKS(gthread->idle_ms);
+            if (xQueueReceive(gthread->queue, (void *) &(msg), timeout))
             {
                 config->Callback(msg.mid, msg.payload);
             }
@@ -183,6 +187,18 @@ GenericThread<T> *create(const Config<T> *config)
     return gthread;
 }
 
+/**
+ * @brief Changes the idle period of a thread, takes effect with the next wait for a message.
+ * @details Meant to be called by the thread itself, e.g. from its idle callback, to wake up less often while there is
+ *          no periodic work. IdleNever disables the idle callback until the period is changed again.
+ */
+template <typename T>
+void SetIdleMs(GenericThread<T> *gthread, uint32_t idle_ms)
+{
+    if (gthread)
+        gthread->idle_ms = idle_ms;
+}
+
 template <typename T>
 int PostMsg(GenericThread<T> *gthread, uint8_t mid, T msg)
 {
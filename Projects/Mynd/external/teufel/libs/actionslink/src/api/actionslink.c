@@ -1,10 +1,13 @@
 #include "actionslink.h"
+#include "actionslink_bringup.h"
 #include "actionslink_bt_ul.h"
 #include "actionslink_decoders.h"
 #include "actionslink_encoders.h"
 #include "actionslink_events.h"
 #include "actionslink_requests.h"
 #include "actionslink_log.h"
+#include "actionslink_notifications.h"
+#include "actionslink_sound_icons.h"
 #include "actionslink_utils.h"
 #include "actionslink_version.h"
 #include "common.pb.h"
@@ -16,12 +19,17 @@ typedef struct
     const actionslink_event_handlers_t   *p_event_handlers;
     const actionslink_request_handlers_t *p_request_handlers;
     uint8_t                               next_sequence_id;
+    actionslink_firmware_version_t       *p_bringup_version;
 } actionslink_driver_t;
 
 static actionslink_driver_t m_actionslink;
 
 // Helper functions
 static bool        is_driver_ready(void);
+static int         tx_rx(ActionsLink_FromMcu *p_message, ActionsLink_ToMcu *p_response);
+static int         tx_rx_encoded(const actionslink_encoded_message_t *p_message, ActionsLink_ToMcu *p_response);
+static int         send_notification(actionslink_notification_t kind, uint32_t value);
+static int         probe_firmware_version(void);
 static const char *get_error_desc(ActionsLink_Error_Code error_code);
 static ActionsLink_Eco_Device_Color to_pb_color(actionslink_device_color_t color);
 
@@ -69,6 +77,9 @@ int actionslink_init(const actionslink_config_t *p_config, const actionslink_eve
 
     actionslink_utils_init(p_config);
     actionslink_bt_ul_init(p_config, actionslink_event_handler, actionslink_request_handler);
+    actionslink_notifications_init(p_config->notification_window_ms, send_notification);
+    actionslink_sound_icons_init(p_config->p_sound_icons_config, actionslink_play_sound_icon,
+                                 actionslink_stop_sound_icon);
 
     m_actionslink.is_initialized   = true;
     m_actionslink.next_sequence_id = 0;
@@ -99,7 +110,7 @@ int actionslink_deinit(void)
 
 void actionslink_force_stop(void)
 {
-    actionslink_bt_ul_stop();
+    actionslink_bt_ul_stop_communication();
 }
 
 void actionslink_tick(void)
@@ -113,6 +124,14 @@ void actionslink_tick(void)
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
     // Nothing to do with the response, we just need to pass the buffer to the function
     actionslink_bt_ul_rx(&response);
+
+    actionslink_notifications_process();
+    actionslink_sound_icons_process();
+}
+
+bool actionslink_needs_tick(void)
+{
+    return actionslink_notifications_is_pending() || actionslink_bt_ul_is_receiving();
 }
 
 bool actionslink_is_ready(void)
@@ -125,6 +144,46 @@ bool actionslink_is_busy(void)
     return actionslink_bt_ul_is_busy();
 }
 
+int actionslink_start_bringup(const actionslink_bringup_config_t *p_config, actionslink_firmware_version_t *p_version)
+{
+    if (m_actionslink.is_initialized == false)
+    {
+        log_error("actionslink driver is not initialized yet");
+        return -1;
+    }
+
+    if ((p_config == NULL) || (p_version == NULL) || (p_version->p_build_string == NULL))
+    {
+        return -1;
+    }
+
+    m_actionslink.p_bringup_version = p_version;
+    actionslink_bringup_start(p_config, probe_firmware_version);
+    return 0;
+}
+
+actionslink_bringup_state_t actionslink_process_bringup(void)
+{
+    actionslink_tick();
+    actionslink_bringup_state_t state =
+        actionslink_bringup_process(actionslink_bt_ul_has_received_frame(), actionslink_is_ready());
+
+    // The caller's version may go out of scope once the bring up is done
+    if (state != ACTIONSLINK_BRINGUP_STATE_WAITING)
+    {
+        m_actionslink.p_bringup_version = NULL;
+    }
+    return state;
+}
+
+void actionslink_get_bringup_stats(actionslink_bringup_stats_t *p_stats)
+{
+    if (p_stats != NULL)
+    {
+        actionslink_bringup_get_stats(p_stats);
+    }
+}
+
 int actionslink_get_firmware_version(actionslink_firmware_version_t *p_version)
 {
     if (!is_driver_ready())
@@ -140,7 +199,7 @@ int actionslink_get_firmware_version(actionslink_firmware_version_t *p_version)
     ActionsLink_ToMcu response       = ActionsLink_ToMcu_init_zero;
     response.cb_Payload.arg          = p_version->p_build_string;
     response.cb_Payload.funcs.decode = actionslink_decode_to_mcu_message;
-    if (actionslink_bt_ul_tx_rx(&message, &response) != 0)
+    if (tx_rx(&message, &response) != 0)
     {
         log_error("failed to get firmware version");
         return -1;
@@ -176,14 +235,16 @@ int actionslink_set_power_state(actionslink_power_state_t power_state)
             return -1;
     }
 
-    ActionsLink_FromMcu message                          = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                                = ActionsLink_FromMcu_request_tag;
-    message.Payload.request.seq                          = m_actionslink.next_sequence_id++;
-    message.Payload.request.which_Request                = ActionsLink_FromMcuRequest_set_power_state_tag;
-    message.Payload.request.Request.set_power_state.mode = power_mode;
+    const uint32_t                fields[] = {power_mode};
+    actionslink_encoded_message_t message;
+    if (actionslink_encode_request_varints(&message, m_actionslink.next_sequence_id++,
+                                           ActionsLink_FromMcuRequest_set_power_state_tag, fields, 1) != 0)
+    {
+        return -1;
+    }
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx_encoded(&message, &response) != 0) ||
         (response.Payload.response.Response.set_power_state.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to set power mode [%s]",
@@ -206,7 +267,7 @@ int actionslink_enter_dfu_mode(void)
     message.Payload.request.which_Request = ActionsLink_FromMcuRequest_enter_dfu_mode_tag;
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx(&message, &response) != 0) ||
         (response.Payload.response.Response.enter_dfu_mode.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to enter dfu mode [%s]",
@@ -231,7 +292,7 @@ int actionslink_get_this_device_name(actionslink_buffer_dsc_t *p_buffer_dsc)
     ActionsLink_ToMcu response       = ActionsLink_ToMcu_init_zero;
     response.cb_Payload.arg          = p_buffer_dsc;
     response.cb_Payload.funcs.decode = actionslink_decode_to_mcu_message;
-    if (actionslink_bt_ul_tx_rx(&message, &response) != 0)
+    if (tx_rx(&message, &response) != 0)
     {
         log_error("failed to get this device name");
         return -1;
@@ -259,7 +320,7 @@ int actionslink_get_bt_mac_address(uint64_t *p_bt_mac_address)
     message.Payload.request.which_Request = ActionsLink_FromMcuRequest_get_bt_mac_address_tag;
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if (actionslink_bt_ul_tx_rx(&message, &response) != 0)
+    if (tx_rx(&message, &response) != 0)
     {
         log_error("failed to get bt mac addr");
         return -1;
@@ -282,7 +343,7 @@ int actionslink_get_ble_mac_address(uint64_t *p_ble_mac_address)
     message.Payload.request.which_Request = ActionsLink_FromMcuRequest_get_ble_mac_address_tag;
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if (actionslink_bt_ul_tx_rx(&message, &response) != 0)
+    if (tx_rx(&message, &response) != 0)
     {
         log_error("failed to get ble mac addr");
         return -1;
@@ -305,7 +366,7 @@ int actionslink_get_bt_rssi_value(int8_t *p_bt_rssi_val)
     message.Payload.request.which_Request = ActionsLink_FromMcuRequest_get_bt_rssi_value_tag;
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if (actionslink_bt_ul_tx_rx(&message, &response) != 0)
+    if (tx_rx(&message, &response) != 0)
     {
         log_error("failed to get bt rssi value");
         return -1;
@@ -334,7 +395,7 @@ int actionslink_clear_bt_paired_device_list(void)
     message.Payload.request.which_Request = ActionsLink_FromMcuRequest_clear_bt_paired_device_list_tag;
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx(&message, &response) != 0) ||
         (response.Payload.response.Response.clear_bt_paired_device_list.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to clear paired device list [%s]",
@@ -357,7 +418,7 @@ int actionslink_disconnect_all_bt_devices(void)
     message.Payload.request.which_Request = ActionsLink_FromMcuRequest_disconnect_all_bt_devices_tag;
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx(&message, &response) != 0) ||
         (response.Payload.response.Response.disconnect_all_bt_devices.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to disconnect all devices [%s]",
@@ -374,14 +435,16 @@ static int control_volume(ActionsLink_Audio_VolumeControl_VolumeControlAction ac
 
     log_debug("sending volume command: %d", action);
 
-    ActionsLink_FromMcu message                       = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                             = ActionsLink_FromMcu_request_tag;
-    message.Payload.request.seq                       = m_actionslink.next_sequence_id++;
-    message.Payload.request.which_Request             = ActionsLink_FromMcuRequest_set_volume_tag;
-    message.Payload.request.Request.set_volume.action = action;
+    const uint32_t                fields[] = {action};
+    actionslink_encoded_message_t message;
+    if (actionslink_encode_request_varints(&message, m_actionslink.next_sequence_id++,
+                                           ActionsLink_FromMcuRequest_set_volume_tag, fields, 1) != 0)
+    {
+        return -1;
+    }
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx_encoded(&message, &response) != 0) ||
         (response.Payload.response.Response.set_volume.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to set volume [%s]",
@@ -408,14 +471,17 @@ int actionslink_set_bt_absolute_avrcp_volume(uint8_t avrcp_volume)
 
     log_debug("sending absolute avrcp volume command: %d", avrcp_volume);
 
-    ActionsLink_FromMcu message           = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                 = ActionsLink_FromMcu_request_tag;
-    message.Payload.request.seq           = m_actionslink.next_sequence_id++;
-    message.Payload.request.which_Request = ActionsLink_FromMcuRequest_set_absolute_avrcp_volume_tag;
-    message.Payload.request.Request.set_absolute_avrcp_volume.volume = avrcp_volume;
+    // The volume is field 2 of AbsoluteAvrcpVolume
+    const uint32_t                fields[] = {0, avrcp_volume};
+    actionslink_encoded_message_t message;
+    if (actionslink_encode_request_varints(&message, m_actionslink.next_sequence_id++,
+                                           ActionsLink_FromMcuRequest_set_absolute_avrcp_volume_tag, fields, 2) != 0)
+    {
+        return -1;
+    }
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx_encoded(&message, &response) != 0) ||
         (response.Payload.response.Response.set_volume.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to set absolute avrcp volume [%s]",
@@ -432,14 +498,16 @@ static int send_avrcp_command(ActionsLink_Bluetooth_AvrcpAction_Action action)
 
     log_debug("sending avrcp action command: %d", action);
 
-    ActionsLink_FromMcu message                              = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                                    = ActionsLink_FromMcu_request_tag;
-    message.Payload.request.seq                              = m_actionslink.next_sequence_id++;
-    message.Payload.request.which_Request                    = ActionsLink_FromMcuRequest_send_avrcp_action_tag;
-    message.Payload.request.Request.send_avrcp_action.action = action;
+    const uint32_t                fields[] = {action};
+    actionslink_encoded_message_t message;
+    if (actionslink_encode_request_varints(&message, m_actionslink.next_sequence_id++,
+                                           ActionsLink_FromMcuRequest_send_avrcp_action_tag, fields, 1) != 0)
+    {
+        return -1;
+    }
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx_encoded(&message, &response) != 0) ||
         (response.Payload.response.Response.send_avrcp_action.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to send avrcp action [%s]",
@@ -481,14 +549,16 @@ static int set_pairing_state(ActionsLink_Bluetooth_PairingState_PairingType pair
 
     log_debug("sending set pairing state command: %d", pairing_state);
 
-    ActionsLink_FromMcu message                                = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                                      = ActionsLink_FromMcu_request_tag;
-    message.Payload.request.seq                                = m_actionslink.next_sequence_id++;
-    message.Payload.request.which_Request                      = ActionsLink_FromMcuRequest_set_bt_pairing_state_tag;
-    message.Payload.request.Request.set_bt_pairing_state.state = pairing_state;
+    const uint32_t                fields[] = {pairing_state};
+    actionslink_encoded_message_t message;
+    if (actionslink_encode_request_varints(&message, m_actionslink.next_sequence_id++,
+                                           ActionsLink_FromMcuRequest_set_bt_pairing_state_tag, fields, 1) != 0)
+    {
+        return -1;
+    }
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx_encoded(&message, &response) != 0) ||
         (response.Payload.response.Response.set_bt_pairing_state.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to set bt pairing state [%s]",
@@ -565,14 +635,16 @@ int actionslink_exit_csb_mode(actionslink_csb_master_exit_reason_t reason)
             break;
     }
 
-    ActionsLink_FromMcu message                               = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                                     = ActionsLink_FromMcu_request_tag;
-    message.Payload.request.seq                               = m_actionslink.next_sequence_id++;
-    message.Payload.request.which_Request                     = ActionsLink_FromMcuRequest_exit_csb_mode_tag;
-    message.Payload.request.Request.exit_csb_mode.exit_reason = r;
+    const uint32_t                fields[] = {r};
+    actionslink_encoded_message_t message;
+    if (actionslink_encode_request_varints(&message, m_actionslink.next_sequence_id++,
+                                           ActionsLink_FromMcuRequest_exit_csb_mode_tag, fields, 1) != 0)
+    {
+        return -1;
+    }
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx_encoded(&message, &response) != 0) ||
         (response.Payload.response.Response.exit_csb_mode.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to exit csb mode [%s]",
@@ -596,7 +668,7 @@ int actionslink_exit_tws_mode(void)
     message.Payload.request.which_Request                  = ActionsLink_FromMcuRequest_exit_tws_mode_tag;
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx(&message, &response) != 0) ||
         (response.Payload.response.Response.exit_tws_mode.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to exit tws mode [%s]",
@@ -621,7 +693,7 @@ int actionslink_enable_bt_reconnection(bool enable)
     message.Payload.request.Request.enable_bt_reconnection = enable;
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx(&message, &response) != 0) ||
         (response.Payload.response.Response.enable_bt_reconnection.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to enable/disable reconnection [%s]",
@@ -638,19 +710,7 @@ int actionslink_send_aux_connection_notification(bool is_connected)
 
     log_debug("sending aux connection notification: %d", is_connected);
 
-    ActionsLink_FromMcu message                      = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                            = ActionsLink_FromMcu_event_tag;
-    message.Payload.event.which_Event                = ActionsLink_FromMcuEvent_notify_aux_connected_tag;
-    message.Payload.event.Event.notify_aux_connected = is_connected;
-
-    // Nothing to do with the response, we just need to pass the buffer to the function
-    ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if (actionslink_bt_ul_tx_rx(&message, &response) != 0)
-    {
-        log_error("failed to send aux connection notification");
-        return -1;
-    }
-    return 0;
+    return actionslink_notifications_post(ACTIONSLINK_NOTIFICATION_AUX_CONNECTED, is_connected);
 }
 
 int actionslink_send_usb_connection_notification(bool is_connected)
@@ -660,19 +720,7 @@ int actionslink_send_usb_connection_notification(bool is_connected)
 
     log_debug("sending usb connection notification: %d", is_connected);
 
-    ActionsLink_FromMcu message                      = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                            = ActionsLink_FromMcu_event_tag;
-    message.Payload.event.which_Event                = ActionsLink_FromMcuEvent_notify_usb_connected_tag;
-    message.Payload.event.Event.notify_usb_connected = is_connected;
-
-    // Nothing to do with the response, we just need to pass the buffer to the function
-    ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if (actionslink_bt_ul_tx_rx(&message, &response) != 0)
-    {
-        log_error("failed to send usb connection notification");
-        return -1;
-    }
-    return 0;
+    return actionslink_notifications_post(ACTIONSLINK_NOTIFICATION_USB_CONNECTED, is_connected);
 }
 
 int actionslink_send_battery_level(uint8_t battery_level)
@@ -682,19 +730,7 @@ int actionslink_send_battery_level(uint8_t battery_level)
 
     log_debug("sending battery level: %d", battery_level);
 
-    ActionsLink_FromMcu message                      = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                            = ActionsLink_FromMcu_event_tag;
-    message.Payload.event.which_Event                = ActionsLink_FromMcuEvent_notify_battery_level_tag;
-    message.Payload.event.Event.notify_battery_level = battery_level;
-
-    // Nothing to do with the response, we just need to pass the buffer to the function
-    ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if (actionslink_bt_ul_tx_rx(&message, &response) != 0)
-    {
-        log_error("failed to send battery level");
-        return -1;
-    }
-    return 0;
+    return actionslink_notifications_post(ACTIONSLINK_NOTIFICATION_BATTERY_LEVEL, battery_level);
 }
 
 int actionslink_send_charger_status(actionslink_charger_status_t status)
@@ -724,19 +760,7 @@ int actionslink_send_charger_status(actionslink_charger_status_t status)
             return -1;
     }
 
-    ActionsLink_FromMcu message                       = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                             = ActionsLink_FromMcu_event_tag;
-    message.Payload.event.which_Event                 = ActionsLink_FromMcuEvent_notify_charger_status_tag;
-    message.Payload.event.Event.notify_charger_status = charger_status;
-
-    // Nothing to do with the response, we just need to pass the buffer to the function
-    ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if (actionslink_bt_ul_tx_rx(&message, &response) != 0)
-    {
-        log_error("failed to send battery level");
-        return -1;
-    }
-    return 0;
+    return actionslink_notifications_post(ACTIONSLINK_NOTIFICATION_CHARGER_STATUS, charger_status);
 }
 
 int actionslink_send_battery_friendly_charging_notification(bool status)
@@ -746,20 +770,7 @@ int actionslink_send_battery_friendly_charging_notification(bool status)
 
     log_debug("sending battery friendly charging notification: %d", status);
 
-    ActionsLink_FromMcu message                                  = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                                        = ActionsLink_FromMcu_event_tag;
-    message.Payload.event.which_Event                            = ActionsLink_FromMcuEvent_notify_battery_friendly_charging_tag;
-    message.Payload.event.Event.notify_battery_friendly_charging = status;
-
-    // Nothing to do with the response, we just need to pass the buffer to the function
-    ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if (actionslink_bt_ul_tx_rx(&message, &response) != 0)
-    {
-        log_error("failed to send battery friendly charging notification");
-        return -1;
-    }
-    return 0;
-
+    return actionslink_notifications_post(ACTIONSLINK_NOTIFICATION_BATTERY_FRIENDLY_CHARGING, status);
 }
 
 int actionslink_send_eco_mode_state(bool state)
@@ -769,19 +780,7 @@ int actionslink_send_eco_mode_state(bool state)
 
     log_debug("sending eco mode state: %d", state);
 
-    ActionsLink_FromMcu message                 = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                       = ActionsLink_FromMcu_event_tag;
-    message.Payload.event.which_Event           = ActionsLink_FromMcuEvent_notify_eco_mode_tag;
-    message.Payload.event.Event.notify_eco_mode = state;
-
-    // Nothing to do with the response, we just need to pass the buffer to the function
-    ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if (actionslink_bt_ul_tx_rx(&message, &response) != 0)
-    {
-        log_error("failed to send eco mode state");
-        return -1;
-    }
-    return 0;
+    return actionslink_notifications_post(ACTIONSLINK_NOTIFICATION_ECO_MODE, state);
 }
 
 int actionslink_send_color_id(actionslink_device_color_t color)
@@ -791,19 +790,7 @@ int actionslink_send_color_id(actionslink_device_color_t color)
 
     log_debug("sending device color: %d", color);
 
-    ActionsLink_FromMcu message              = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                    = ActionsLink_FromMcu_event_tag;
-    message.Payload.event.which_Event        = ActionsLink_FromMcuEvent_notify_color_tag;
-    message.Payload.event.Event.notify_color = to_pb_color(color);
-
-    // Nothing to do with the response, we just need to pass the buffer to the function
-    ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if (actionslink_bt_ul_tx_rx(&message, &response) != 0)
-    {
-        log_error("failed to send device color");
-        return -1;
-    }
-    return 0;
+    return actionslink_notifications_post(ACTIONSLINK_NOTIFICATION_COLOR, to_pb_color(color));
 }
 
 static int send_usb_hid_command(ActionsLink_Usb_HidAction_Action action)
@@ -813,14 +800,16 @@ static int send_usb_hid_command(ActionsLink_Usb_HidAction_Action action)
 
     log_debug("sending usb hid action command: %d", action);
 
-    ActionsLink_FromMcu message                                = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                                      = ActionsLink_FromMcu_request_tag;
-    message.Payload.request.seq                                = m_actionslink.next_sequence_id++;
-    message.Payload.request.which_Request                      = ActionsLink_FromMcuRequest_send_usb_hid_action_tag;
-    message.Payload.request.Request.send_usb_hid_action.action = action;
+    const uint32_t                fields[] = {action};
+    actionslink_encoded_message_t message;
+    if (actionslink_encode_request_varints(&message, m_actionslink.next_sequence_id++,
+                                           ActionsLink_FromMcuRequest_send_usb_hid_action_tag, fields, 1) != 0)
+    {
+        return -1;
+    }
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx_encoded(&message, &response) != 0) ||
         (response.Payload.response.Response.send_usb_hid_action.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to send usb hid action [%s]",
@@ -872,14 +861,16 @@ int actionslink_set_audio_source(actionslink_audio_source_t source)
 
     log_debug("sending set audio source command: %d", source);
 
-    ActionsLink_FromMcu message                             = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                                   = ActionsLink_FromMcu_request_tag;
-    message.Payload.request.seq                             = m_actionslink.next_sequence_id++;
-    message.Payload.request.which_Request                   = ActionsLink_FromMcuRequest_set_audio_source_tag;
-    message.Payload.request.Request.set_audio_source.source = source_type;
+    const uint32_t                fields[] = {source_type};
+    actionslink_encoded_message_t message;
+    if (actionslink_encode_request_varints(&message, m_actionslink.next_sequence_id++,
+                                           ActionsLink_FromMcuRequest_set_audio_source_tag, fields, 1) != 0)
+    {
+        return -1;
+    }
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx_encoded(&message, &response) != 0) ||
         (response.Payload.response.Response.set_audio_source.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to set audio source [%s]",
@@ -976,16 +967,16 @@ int actionslink_play_sound_icon(actionslink_sound_icon_t               sound_ico
 
     log_debug("sending play sound icon command: %d", sound_icon_id);
 
-    ActionsLink_FromMcu message                                   = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                                         = ActionsLink_FromMcu_request_tag;
-    message.Payload.request.seq                                   = m_actionslink.next_sequence_id++;
-    message.Payload.request.which_Request                         = ActionsLink_FromMcuRequest_play_sound_icon_tag;
-    message.Payload.request.Request.play_sound_icon.sound_icon    = sound_icon_id;
-    message.Payload.request.Request.play_sound_icon.playback_mode = mode;
-    message.Payload.request.Request.play_sound_icon.loop_forever  = loop_forever;
+    const uint32_t                fields[] = {sound_icon_id, mode, loop_forever};
+    actionslink_encoded_message_t message;
+    if (actionslink_encode_request_varints(&message, m_actionslink.next_sequence_id++,
+                                           ActionsLink_FromMcuRequest_play_sound_icon_tag, fields, 3) != 0)
+    {
+        return -1;
+    }
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx_encoded(&message, &response) != 0) ||
         (response.Payload.response.Response.play_sound_icon.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to play sound icon [%s]",
@@ -995,6 +986,46 @@ int actionslink_play_sound_icon(actionslink_sound_icon_t               sound_ico
     return 0;
 }
 
+int actionslink_request_sound_icon(actionslink_sound_icon_t               sound_icon,
+                                   actionslink_sound_icon_playback_mode_t playback_mode, bool loop_forever)
+{
+    if (!is_driver_ready())
+        return -1;
+
+    return actionslink_sound_icons_request(sound_icon, playback_mode, loop_forever);
+}
+
+int actionslink_cancel_sound_icon(actionslink_sound_icon_t sound_icon)
+{
+    if (!is_driver_ready())
+        return -1;
+
+    return actionslink_sound_icons_cancel(sound_icon);
+}
+
+actionslink_sound_icon_t actionslink_get_current_sound_icon(uint32_t *p_played_ms)
+{
+    return actionslink_sound_icons_get_current(p_played_ms);
+}
+
+bool actionslink_is_sound_icon_scheduled(actionslink_sound_icon_t sound_icon)
+{
+    return actionslink_sound_icons_is_scheduled(sound_icon);
+}
+
+uint32_t actionslink_get_sound_icons_due_ms(void)
+{
+    return actionslink_sound_icons_get_due_ms();
+}
+
+void actionslink_get_sound_icons_stats(actionslink_sound_icons_stats_t *p_stats)
+{
+    if (p_stats != NULL)
+    {
+        actionslink_sound_icons_get_stats(p_stats);
+    }
+}
+
 int actionslink_stop_sound_icon(actionslink_sound_icon_t sound_icon)
 {
     if (!is_driver_ready())
@@ -1008,14 +1039,16 @@ int actionslink_stop_sound_icon(actionslink_sound_icon_t sound_icon)
 
     log_debug("sending stop sound icon command: %d", sound_icon_id);
 
-    ActionsLink_FromMcu message                                = ActionsLink_FromMcu_init_zero;
-    message.which_Payload                                      = ActionsLink_FromMcu_request_tag;
-    message.Payload.request.seq                                = m_actionslink.next_sequence_id++;
-    message.Payload.request.which_Request                      = ActionsLink_FromMcuRequest_stop_sound_icon_tag;
-    message.Payload.request.Request.stop_sound_icon.sound_icon = sound_icon_id;
+    const uint32_t                fields[] = {sound_icon_id};
+    actionslink_encoded_message_t message;
+    if (actionslink_encode_request_varints(&message, m_actionslink.next_sequence_id++,
+                                           ActionsLink_FromMcuRequest_stop_sound_icon_tag, fields, 1) != 0)
+    {
+        return -1;
+    }
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx_encoded(&message, &response) != 0) ||
         (response.Payload.response.Response.stop_sound_icon.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to stop sound icon [%s]",
@@ -1343,7 +1376,7 @@ int actionslink_write_key_value(uint32_t key, uint32_t value)
     message.Payload.request.Request.write_key_value.el.value = value;
 
     ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx(&message, &response) != 0) ||
         (response.Payload.response.Response.write_key_value.status.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to write kv element [%s]",
@@ -1369,7 +1402,7 @@ int actionslink_read_key_value(uint32_t key, uint32_t *p_value)
 
     ActionsLink_ToMcu response       = ActionsLink_ToMcu_init_zero;
     message.Payload.request.Request.read_key_value.key = key;
-    if ((actionslink_bt_ul_tx_rx(&message, &response) != 0) ||
+    if ((tx_rx(&message, &response) != 0) ||
         (response.Payload.response.Response.read_key_value.Result.error.code != ActionsLink_Error_Code_Success))
     {
         log_error("failed to read kv element [%s]",
@@ -1421,3 +1454,62 @@ static bool is_driver_ready(void)
 
     return true;
 }
+
+// Pending notifications go out ahead of a request, so the Actions module sees the state changes in the order the
+// application reported them
+static int tx_rx(ActionsLink_FromMcu *p_message, ActionsLink_ToMcu *p_response)
+{
+    actionslink_notifications_flush();
+    return actionslink_bt_ul_tx_rx(p_message, p_response);
+}
+
+static int tx_rx_encoded(const actionslink_encoded_message_t *p_message, ActionsLink_ToMcu *p_response)
+{
+    actionslink_notifications_flush();
+    return actionslink_bt_ul_tx_rx_encoded(p_message, p_response);
+}
+
+static int probe_firmware_version(void)
+{
+    if (m_actionslink.p_bringup_version == NULL)
+    {
+        return -1;
+    }
+    return actionslink_get_firmware_version(m_actionslink.p_bringup_version);
+}
+
+static int send_notification(actionslink_notification_t kind, uint32_t value)
+{
+    static const struct
+    {
+        uint16_t    tag;
+        const char *name;
+    } notifications[ACTIONSLINK_NOTIFICATION_COUNT] = {
+        [ACTIONSLINK_NOTIFICATION_AUX_CONNECTED] =
+            {ActionsLink_FromMcuEvent_notify_aux_connected_tag, "aux connection"},
+        [ACTIONSLINK_NOTIFICATION_USB_CONNECTED] =
+            {ActionsLink_FromMcuEvent_notify_usb_connected_tag, "usb connection"},
+        [ACTIONSLINK_NOTIFICATION_BATTERY_LEVEL] =
+            {ActionsLink_FromMcuEvent_notify_battery_level_tag, "battery level"},
+        [ACTIONSLINK_NOTIFICATION_CHARGER_STATUS] =
+            {ActionsLink_FromMcuEvent_notify_charger_status_tag, "charger status"},
+        [ACTIONSLINK_NOTIFICATION_BATTERY_FRIENDLY_CHARGING] =
+            {ActionsLink_FromMcuEvent_notify_battery_friendly_charging_tag, "battery friendly charging"},
+        [ACTIONSLINK_NOTIFICATION_ECO_MODE] =
+            {ActionsLink_FromMcuEvent_notify_eco_mode_tag, "eco mode state"},
+        [ACTIONSLINK_NOTIFICATION_COLOR] =
+            {ActionsLink_FromMcuEvent_notify_color_tag, "device color"},
+    };
+
+    actionslink_encoded_message_t message;
+    actionslink_encode_event_varint(&message, notifications[kind].tag, value);
+
+    // Nothing to do with the response, we just need to pass the buffer to the function
+    ActionsLink_ToMcu response = ActionsLink_ToMcu_init_zero;
+    if (actionslink_bt_ul_tx_rx_encoded(&message, &response) != 0)
+    {
+        log_error("failed to send %s notification", notifications[kind].name);
+        return -1;
+    }
+    return 0;
+}
@@ -37,9 +37,19 @@ extern "C"
 
     /**
      * @brief Reads from the buffers and generates events, if any.
+     * @note  It also sends the notifications held back for longer than `notification_window_ms`.
      */
     void actionslink_tick(void);
 
+    /**
+     * @brief Checks if `actionslink_tick()` has to be called periodically.
+     * @note  This is the case while notifications are held back or a frame is partly received. Otherwise it is
+     *        enough to call `actionslink_tick()` once a complete frame has been received.
+     *
+     * @return true if periodic ticks are needed, false otherwise
+     */
+    bool actionslink_needs_tick(void);
+
     /**
      * @brief Checks if the Actionslink library is ready to use (handshake done, etc).
      *
@@ -56,6 +66,35 @@ extern "C"
      */
     bool actionslink_is_busy(void);
 
+    /**
+     * @brief Starts bringing up the Actions module after it was powered and the library initialized.
+     * @note  The bring up waits for the first valid frame, the system ready event and a firmware version request
+     *        answered, each step with its own timeout. Firmware version requests are repeated with a backoff.
+     *
+     * @param[in] p_config      step timeouts and probe backoff, must stay valid until the bring up is done
+     * @param[out] p_version    where the firmware version will be written to, must stay valid until the bring up is
+     *                          done
+     *
+     * @return 0 if successful, -1 otherwise
+     */
+    int actionslink_start_bringup(const actionslink_bringup_config_t *p_config,
+                                  actionslink_firmware_version_t     *p_version);
+
+    /**
+     * @brief Reads from the buffers and advances the bring up.
+     * @note  This function must be called periodically until the bring up is done, instead of `actionslink_tick()`.
+     *
+     * @return state of the bring up
+     */
+    actionslink_bringup_state_t actionslink_process_bringup(void);
+
+    /**
+     * @brief Gets the time each step of the last bring up took and the counters of all bring ups.
+     *
+     * @param[out] p_stats      pointer to where the statistics will be written to
+     */
+    void actionslink_get_bringup_stats(actionslink_bringup_stats_t *p_stats);
+
     /**
      * @brief Gets the firmware version of the Actions module.
      *
@@ -350,6 +389,12 @@ extern "C"
      */
     int actionslink_set_audio_source(actionslink_audio_source_t source);
 
+    /*
+     * The notifications below are held back for up to `notification_window_ms` of the configuration and sent from
+     * `actionslink_tick()`. Only the latest value of each kind is sent, and any pending notification is sent before
+     * the next request. With a window, 0 is returned once the notification is queued and send failures are logged.
+     */
+
     /**
      * @brief Sends a notification to the Actions module regarding the state of the aux connection.
      *
@@ -434,6 +479,68 @@ extern "C"
      */
     int actionslink_stop_sound_icon(actionslink_sound_icon_t sound_icon);
 
+    /*
+     * Sound icons requested below are scheduled by the priorities and lengths of `p_sound_icons_config` of the
+     * configuration: a sound icon interrupts a playing one of lower priority and otherwise waits until that one is
+     * done, from `actionslink_tick()`. Requests for a sound icon already playing or waiting are merged, and only
+     * sound icons that start or are stopped while playing are sent to the Actions module. Without a sound icons
+     * configuration requests are sent right away.
+     */
+
+    /**
+     * @brief Requests a sound icon to be played as soon as its priority allows.
+     *
+     * @param[in] sound_icon        sound icon to play
+     * @param[in] playback_mode     PLAY_AFTER_CURRENT never interrupts a playing sound icon, unless that one loops
+     * @param[in] loop_forever      true if the sound icon should be looped forever, false otherwise
+     *
+     * @return 0 if played or queued successfully, -1 otherwise
+     */
+    int actionslink_request_sound_icon(actionslink_sound_icon_t               sound_icon,
+                                       actionslink_sound_icon_playback_mode_t playback_mode, bool loop_forever);
+
+    /**
+     * @brief Cancels a requested sound icon, stopping it if it plays, and plays the next one waiting.
+     *
+     * @param[in] sound_icon        sound icon to cancel, ACTIONSLINK_SOUND_ICON_NONE for all of them
+     *
+     * @return 0 if successful, -1 otherwise
+     */
+    int actionslink_cancel_sound_icon(actionslink_sound_icon_t sound_icon);
+
+    /**
+     * @brief Gets the requested sound icon that is playing, as far as its length tells.
+     *
+     * @param[out] p_played_ms      optional, where the time since it was started will be written to
+     *
+     * @return sound icon playing, ACTIONSLINK_SOUND_ICON_NONE if none
+     */
+    actionslink_sound_icon_t actionslink_get_current_sound_icon(uint32_t *p_played_ms);
+
+    /**
+     * @brief Checks if a requested sound icon is playing or waiting to be played.
+     *
+     * @param[in] sound_icon        sound icon to check
+     *
+     * @return true if playing or waiting, false otherwise
+     */
+    bool actionslink_is_sound_icon_scheduled(actionslink_sound_icon_t sound_icon);
+
+    /**
+     * @brief Gets the time until `actionslink_tick()` has to play the next waiting sound icon.
+     *
+     * @return milliseconds until due, 0 if due already, UINT32_MAX if no sound icon is waiting for a playing one to
+     *         end
+     */
+    uint32_t actionslink_get_sound_icons_due_ms(void);
+
+    /**
+     * @brief Gets the sound icon counters since the library was initialized.
+     *
+     * @param[out] p_stats      pointer to where the counters will be written to
+     */
+    void actionslink_get_sound_icons_stats(actionslink_sound_icons_stats_t *p_stats);
+
     /**
      * @brief Gets the version of the Actionslink library.
      *
@@ -95,6 +95,9 @@ typedef struct actionslink_config
     uint8_t                      *p_tx_buffer;
     uint16_t                      rx_buffer_size;
     uint16_t                      tx_buffer_size;
+    uint16_t                      notification_window_ms; // Optional, 0 sends notifications right away
+    // Optional, NULL sends sound icon requests right away
+    const struct actionslink_sound_icons_config *p_sound_icons_config;
 } actionslink_config_t;
 
 typedef enum
@@ -237,6 +240,41 @@ typedef enum
     ACTIONSLINK_SOUND_ICON_PLAYBACK_MODE_PLAY_AFTER_CURRENT,
 } actionslink_sound_icon_playback_mode_t;
 
+// A sound icon interrupts a playing one of lower priority, otherwise it waits until the playing one is done
+typedef enum
+{
+    ACTIONSLINK_SOUND_ICON_PRIORITY_LOW,      // Looping sound icons, e.g. pairing, which any other one interrupts
+    ACTIONSLINK_SOUND_ICON_PRIORITY_NORMAL,   // Feedback on user input and connection changes
+    ACTIONSLINK_SOUND_ICON_PRIORITY_HIGH,     // Warnings, e.g. battery low
+    ACTIONSLINK_SOUND_ICON_PRIORITY_CRITICAL, // Power transitions
+} actionslink_sound_icon_priority_t;
+
+typedef struct
+{
+    actionslink_sound_icon_t          sound_icon;
+    actionslink_sound_icon_priority_t priority;
+    uint16_t                          length_ms; // 0 if not known
+} actionslink_sound_icon_info_t;
+
+typedef struct actionslink_sound_icons_config
+{
+    const actionslink_sound_icon_info_t *p_sound_icons;    // Sound icons not listed are of normal priority
+    uint8_t                              sound_icons_count;
+    uint16_t                             default_length_ms; // Assumed for sound icons of unknown length
+} actionslink_sound_icons_config_t;
+
+typedef struct
+{
+    uint32_t requested; // Sound icons requested by the application
+    uint32_t merged;    // Requests for a sound icon already playing or pending
+    uint32_t dropped;   // Requests that didn't fit into the queue
+    uint32_t cancelled; // Pending sound icons cancelled before they were played
+    uint32_t played;    // Play requests sent to the Actions module
+    uint32_t preempted; // Playing sound icons interrupted by one of higher priority
+    uint32_t stopped;   // Stop requests sent to the Actions module
+    uint32_t failed;    // Play and stop requests that failed
+} actionslink_sound_icons_stats_t;
+
 typedef enum
 {
     ACTIONSLINK_DEVICE_COLOR_BLACK,
@@ -274,6 +312,39 @@ typedef struct
     actionslink_buffer_dsc_t * p_build_string;
 } actionslink_firmware_version_t;
 
+// Steps of bringing up the Actions module after it was powered, in order
+typedef enum
+{
+    ACTIONSLINK_BRINGUP_STEP_FIRST_FRAME,  // Any valid frame received, the UART of the module is up
+    ACTIONSLINK_BRINGUP_STEP_SYSTEM_READY, // System ready event received
+    ACTIONSLINK_BRINGUP_STEP_RESPONDING,   // Firmware version request answered, the module takes requests
+    ACTIONSLINK_BRINGUP_STEP_COUNT,
+} actionslink_bringup_step_t;
+
+typedef enum
+{
+    ACTIONSLINK_BRINGUP_STATE_IDLE,
+    ACTIONSLINK_BRINGUP_STATE_WAITING,
+    ACTIONSLINK_BRINGUP_STATE_READY,
+    ACTIONSLINK_BRINGUP_STATE_TIMED_OUT,
+} actionslink_bringup_state_t;
+
+typedef struct
+{
+    uint16_t step_timeout_ms[ACTIONSLINK_BRINGUP_STEP_COUNT]; // Longest wait per step, from the end of the last one
+    uint16_t probe_delay_ms;     // Delay after the first failed firmware version probe, doubled after each one
+    uint16_t max_probe_delay_ms; // Longest delay between probes
+} actionslink_bringup_config_t;
+
+typedef struct
+{
+    uint32_t step_ms[ACTIONSLINK_BRINGUP_STEP_COUNT];  // Time each step took in the last bring up
+    uint32_t total_ms;                                 // Last bring up, until ready or timed out
+    uint8_t  probes;                                   // Firmware version requests in the last bring up
+    uint16_t bringups;                                 // Bring ups started
+    uint16_t timeouts[ACTIONSLINK_BRINGUP_STEP_COUNT]; // Bring ups that timed out, by step
+} actionslink_bringup_stats_t;
+
 /**
  * @brief Handler for system ready notifications.
  */
@@ -0,0 +1,130 @@
+#include "actionslink_bringup.h"
+#include "actionslink_log.h"
+#include "actionslink_utils.h"
+
+static struct
+{
+    const actionslink_bringup_config_t *p_config;
+    actionslink_bringup_probe_fn_t      probe_fn;
+    actionslink_bringup_state_t         state;
+    actionslink_bringup_step_t          step;
+    uint32_t                            start_ts;
+    uint32_t                            step_start_ts;
+    uint32_t                            last_probe_ts;
+    uint32_t                            probe_delay_ms; // Until the next probe, 0 before the first one
+    actionslink_bringup_stats_t         stats;
+} m_bringup;
+
+static bool is_step_signaled(bool has_received_frame, bool is_system_ready);
+static bool probe(void);
+
+void actionslink_bringup_start(const actionslink_bringup_config_t *p_config, actionslink_bringup_probe_fn_t probe_fn)
+{
+    uint32_t now = actionslink_utils_get_ms();
+
+    m_bringup.p_config       = p_config;
+    m_bringup.probe_fn       = probe_fn;
+    m_bringup.state          = ACTIONSLINK_BRINGUP_STATE_WAITING;
+    m_bringup.step           = ACTIONSLINK_BRINGUP_STEP_FIRST_FRAME;
+    m_bringup.start_ts       = now;
+    m_bringup.step_start_ts  = now;
+    m_bringup.probe_delay_ms = 0;
+
+    // Counters of the last bring up start over, the totals are kept
+    for (uint8_t i = 0; i < ACTIONSLINK_BRINGUP_STEP_COUNT; i++)
+    {
+        m_bringup.stats.step_ms[i] = 0;
+    }
+    m_bringup.stats.total_ms = 0;
+    m_bringup.stats.probes   = 0;
+    m_bringup.stats.bringups++;
+}
+
+actionslink_bringup_state_t actionslink_bringup_process(bool has_received_frame, bool is_system_ready)
+{
+    if (m_bringup.state != ACTIONSLINK_BRINGUP_STATE_WAITING)
+    {
+        return m_bringup.state;
+    }
+
+    // Signals often come together, e.g. the system ready event is the first frame, so several steps may complete
+    while (is_step_signaled(has_received_frame, is_system_ready))
+    {
+        uint32_t now = actionslink_utils_get_ms();
+
+        m_bringup.stats.step_ms[m_bringup.step] = now - m_bringup.step_start_ts;
+        m_bringup.step_start_ts                 = now;
+        m_bringup.step++;
+
+        if (m_bringup.step == ACTIONSLINK_BRINGUP_STEP_COUNT)
+        {
+            m_bringup.stats.total_ms = now - m_bringup.start_ts;
+            m_bringup.state          = ACTIONSLINK_BRINGUP_STATE_READY;
+            log_info("bringup: ready after %d ms (%d probes)", m_bringup.stats.total_ms, m_bringup.stats.probes);
+            return m_bringup.state;
+        }
+    }
+
+    uint32_t step_ms = actionslink_utils_get_ms_since(m_bringup.step_start_ts);
+    if (step_ms >= m_bringup.p_config->step_timeout_ms[m_bringup.step])
+    {
+        m_bringup.stats.step_ms[m_bringup.step] = step_ms;
+        m_bringup.stats.total_ms                = actionslink_utils_get_ms_since(m_bringup.start_ts);
+        m_bringup.stats.timeouts[m_bringup.step]++;
+        m_bringup.state = ACTIONSLINK_BRINGUP_STATE_TIMED_OUT;
+        log_error("bringup: step %d timed out after %d ms", m_bringup.step, step_ms);
+    }
+    return m_bringup.state;
+}
+
+void actionslink_bringup_get_stats(actionslink_bringup_stats_t *p_stats)
+{
+    *p_stats = m_bringup.stats;
+}
+
+static bool is_step_signaled(bool has_received_frame, bool is_system_ready)
+{
+    switch (m_bringup.step)
+    {
+        case ACTIONSLINK_BRINGUP_STEP_FIRST_FRAME:
+            return has_received_frame;
+        case ACTIONSLINK_BRINGUP_STEP_SYSTEM_READY:
+            return is_system_ready;
+        case ACTIONSLINK_BRINGUP_STEP_RESPONDING:
+            return probe();
+        default:
+            return false;
+    }
+}
+
+// Probes right away once the module is ready, then backs off exponentially while it doesn't answer
+static bool probe(void)
+{
+    if ((m_bringup.probe_delay_ms > 0) &&
+        (actionslink_utils_get_ms_since(m_bringup.last_probe_ts) < m_bringup.probe_delay_ms))
+    {
+        return false;
+    }
+
+    m_bringup.stats.probes++;
+    if (m_bringup.probe_fn() == 0)
+    {
+        return true;
+    }
+
+    m_bringup.last_probe_ts = actionslink_utils_get_ms();
+    if (m_bringup.probe_delay_ms == 0)
+    {
+        m_bringup.probe_delay_ms = m_bringup.p_config->probe_delay_ms;
+    }
+    else if (m_bringup.probe_delay_ms < m_bringup.p_config->max_probe_delay_ms / 2)
+    {
+        m_bringup.probe_delay_ms *= 2;
+    }
+    else
+    {
+        m_bringup.probe_delay_ms = m_bringup.p_config->max_probe_delay_ms;
+    }
+    log_debug("bringup: probe %d failed, next one in %d ms", m_bringup.stats.probes, m_bringup.probe_delay_ms);
+    return false;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "actionslink_types.h"
+
+/**
+ * @brief Function to probe if the Actions module answers requests.
+ *
+ * @return 0 if the module answered, -1 otherwise
+ */
+typedef int (*actionslink_bringup_probe_fn_t)(void);
+
+/**
+ * @brief Starts a bring up, the steps are timed from now on.
+ *
+ * @param[in] p_config      step timeouts and probe backoff, must stay valid until the bring up is done
+ * @param[in] probe_fn      function to probe the module with once it's ready
+ */
+void actionslink_bringup_start(const actionslink_bringup_config_t *p_config, actionslink_bringup_probe_fn_t probe_fn);
+
+/**
+ * @brief Advances the bring up with the signals seen so far and probes the module when due.
+ * @note  This function must be called periodically until the bring up is done.
+ *
+ * @param[in] has_received_frame    true once any valid frame was received from the module
+ * @param[in] is_system_ready       true once the system ready event was received
+ *
+ * @return state of the bring up
+ */
+actionslink_bringup_state_t actionslink_bringup_process(bool has_received_frame, bool is_system_ready);
+
+/**
+ * @brief Gets the bring up counters, which are kept across bring ups.
+ *
+ * @param[out] p_stats      pointer to where the counters will be written to
+ */
+void actionslink_bringup_get_stats(actionslink_bringup_stats_t *p_stats);
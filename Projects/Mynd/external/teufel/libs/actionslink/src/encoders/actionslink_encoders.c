@@ -1,5 +1,11 @@
 #include "actionslink_encoders.h"
 #include "actionslink_log.h"
+#include "message.pb.h"
+
+#define WIRE_TYPE_VARINT           (0u)
+#define WIRE_TYPE_LENGTH_DELIMITED (2u)
+
+#define MAX_REQUEST_VARINTS        (3u)
 
 // Check the following link for a very nice encoding/decoding example with nested repeated messages
 // https://github.com/BlockWorksCo/Playground/tree/c968e22cd923ee184fe9362905a4d58e9f69cb27/ProtobufTest
@@ -50,3 +56,99 @@ bool actionslink_encode_bytes(pb_ostream_t* stream, const pb_field_t* field, voi
 
     return pb_encode_string(stream, data->p_buffer, data->size);
 }
+
+static uint8_t varint_size(uint32_t value)
+{
+    uint8_t size = 1;
+    while (value >= 0x80)
+    {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+static uint8_t *write_varint(uint8_t *p_out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        *p_out++ = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+    *p_out++ = (uint8_t) value;
+    return p_out;
+}
+
+static uint32_t key(uint16_t field_number, uint8_t wire_type)
+{
+    return ((uint32_t) field_number << 3) | wire_type;
+}
+
+// All the nested messages are shorter than 128 bytes, so every length fits into a single byte
+void actionslink_encode_event_varint(actionslink_encoded_message_t *p_message, uint16_t event_tag, uint32_t value)
+{
+    uint8_t *p_out   = p_message->buffer;
+    uint32_t tag_key = key(event_tag, WIRE_TYPE_VARINT);
+
+    // A oneof member is encoded even if it holds the default value
+    *p_out++ = (uint8_t) key(ActionsLink_FromMcu_event_tag, WIRE_TYPE_LENGTH_DELIMITED);
+    *p_out++ = varint_size(tag_key) + varint_size(value);
+    p_out    = write_varint(p_out, tag_key);
+    p_out    = write_varint(p_out, value);
+
+    p_message->length        = p_out - p_message->buffer;
+    p_message->which_payload = ActionsLink_FromMcu_event_tag;
+    p_message->tag           = event_tag;
+    p_message->seq           = 0;
+}
+
+int actionslink_encode_request_varints(actionslink_encoded_message_t *p_message, uint8_t seq, uint16_t request_tag,
+                                       const uint32_t *p_values, uint8_t count)
+{
+    if (count > MAX_REQUEST_VARINTS)
+    {
+        log_error("encoder: too many fields (%d)", count);
+        return -1;
+    }
+
+    uint8_t fields_size = 0;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (p_values[i] != 0)
+        {
+            fields_size += varint_size(key(i + 1, WIRE_TYPE_VARINT)) + varint_size(p_values[i]);
+        }
+    }
+
+    uint32_t tag_key      = key(request_tag, WIRE_TYPE_LENGTH_DELIMITED);
+    uint8_t  request_size = varint_size(tag_key) + 1 + fields_size;
+    if (seq != 0)
+    {
+        request_size += varint_size(key(1, WIRE_TYPE_VARINT)) + varint_size(seq);
+    }
+
+    uint8_t *p_out = p_message->buffer;
+    *p_out++       = (uint8_t) key(ActionsLink_FromMcu_request_tag, WIRE_TYPE_LENGTH_DELIMITED);
+    *p_out++       = request_size;
+    if (seq != 0)
+    {
+        p_out = write_varint(p_out, key(1, WIRE_TYPE_VARINT));
+        p_out = write_varint(p_out, seq);
+    }
+    p_out    = write_varint(p_out, tag_key);
+    *p_out++ = fields_size;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (p_values[i] != 0)
+        {
+            p_out = write_varint(p_out, key(i + 1, WIRE_TYPE_VARINT));
+            p_out = write_varint(p_out, p_values[i]);
+        }
+    }
+
+    p_message->length        = p_out - p_message->buffer;
+    p_message->which_payload = ActionsLink_FromMcu_request_tag;
+    p_message->tag           = request_tag;
+    p_message->seq           = seq;
+    return 0;
+}
@@ -16,3 +16,43 @@ typedef struct {
 bool actionslink_encode_string(pb_ostream_t* stream, const pb_field_t* field, void* const* arg);
 
 bool actionslink_encode_bytes(pb_ostream_t* stream, const pb_field_t* field, void* const* arg);
+
+// Longest FromMcu message the direct encoders produce: a request with a sequence number and three 5-byte varints
+#define ACTIONSLINK_ENCODED_MESSAGE_MAX_SIZE (26u)
+
+/**
+ * @brief FromMcu message encoded straight into the protobuf wire format, without building the nanopb struct.
+ */
+typedef struct
+{
+    uint8_t  buffer[ACTIONSLINK_ENCODED_MESSAGE_MAX_SIZE];
+    uint8_t  length;
+    uint8_t  which_payload; // ActionsLink_FromMcu_request_tag or ActionsLink_FromMcu_event_tag
+    uint16_t tag;           // Tag of the request or event
+    uint8_t  seq;           // Sequence number of a request
+} actionslink_encoded_message_t;
+
+/**
+ * @brief Encodes a FromMcu event whose payload is a single bool, enum or uint32.
+ * @note  The output is byte-identical to what nanopb encodes for the same message.
+ *
+ * @param[out] p_message        pointer to where the encoded message will be written to
+ * @param[in]  event_tag        tag of the event in FromMcuEvent
+ * @param[in]  value            value of the event
+ */
+void actionslink_encode_event_varint(actionslink_encoded_message_t *p_message, uint16_t event_tag, uint32_t value);
+
+/**
+ * @brief Encodes a FromMcu request whose payload is a message made of varint fields only, numbered from 1.
+ * @note  Fields with a value of 0 are left out, like nanopb does for proto3 scalars.
+ *
+ * @param[out] p_message        pointer to where the encoded message will be written to
+ * @param[in]  seq              sequence number of the request
+ * @param[in]  request_tag      tag of the request in FromMcuRequest
+ * @param[in]  p_values         values of the fields 1 to count
+ * @param[in]  count            number of fields, 3 at most
+ *
+ * @return 0 if successful, -1 otherwise
+ */
+int actionslink_encode_request_varints(actionslink_encoded_message_t *p_message, uint8_t seq, uint16_t request_tag,
+                                       const uint32_t *p_values, uint8_t count);
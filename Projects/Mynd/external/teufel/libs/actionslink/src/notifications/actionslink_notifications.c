@@ -0,0 +1,124 @@
+#include "actionslink_notifications.h"
+#include "actionslink_log.h"
+#include "actionslink_utils.h"
+#include <string.h>
+
+static struct
+{
+    actionslink_notification_send_fn_t send_fn;
+    uint32_t                           window_ms;
+    uint32_t                           first_pending_ts;
+    uint32_t                           values[ACTIONSLINK_NOTIFICATION_COUNT];
+    uint8_t                            order[ACTIONSLINK_NOTIFICATION_COUNT]; // Pending kinds, oldest first
+    uint8_t                            pending_count;
+    actionslink_notifications_stats_t  stats;
+} m_notifications;
+
+static bool is_pending(actionslink_notification_t kind);
+
+void actionslink_notifications_init(uint32_t window_ms, actionslink_notification_send_fn_t send_fn)
+{
+    m_notifications.send_fn       = send_fn;
+    m_notifications.window_ms     = window_ms;
+    m_notifications.pending_count = 0;
+    m_notifications.stats         = (actionslink_notifications_stats_t){0};
+}
+
+int actionslink_notifications_post(actionslink_notification_t kind, uint32_t value)
+{
+    if (kind >= ACTIONSLINK_NOTIFICATION_COUNT)
+    {
+        log_error("notifications: invalid kind %d", kind);
+        return -1;
+    }
+
+    m_notifications.stats.posted++;
+
+    if (is_pending(kind))
+    {
+        // Last value wins, the kind keeps its place in the order
+        m_notifications.values[kind] = value;
+        m_notifications.stats.replaced++;
+        return 0;
+    }
+
+    if (m_notifications.pending_count == 0)
+    {
+        m_notifications.first_pending_ts = actionslink_utils_get_ms();
+    }
+    m_notifications.values[kind]                           = value;
+    m_notifications.order[m_notifications.pending_count++] = kind;
+
+    if (m_notifications.window_ms == 0)
+    {
+        return actionslink_notifications_flush();
+    }
+    return 0;
+}
+
+int actionslink_notifications_process(void)
+{
+    if (m_notifications.pending_count == 0)
+    {
+        return 0;
+    }
+
+    if (actionslink_utils_get_ms_since(m_notifications.first_pending_ts) < m_notifications.window_ms)
+    {
+        return 0;
+    }
+
+    return actionslink_notifications_flush();
+}
+
+int actionslink_notifications_flush(void)
+{
+    int      ret_val = 0;
+    uint8_t  count   = m_notifications.pending_count;
+    uint8_t  order[ACTIONSLINK_NOTIFICATION_COUNT];
+    uint32_t values[ACTIONSLINK_NOTIFICATION_COUNT];
+
+    // Take the pending notifications out first, anything posted while they are sent waits for the next window
+    memcpy(order, m_notifications.order, count);
+    memcpy(values, m_notifications.values, sizeof(values));
+    m_notifications.pending_count = 0;
+
+    // Notifications that fail are dropped, the transport has retried them already and the next value will follow
+    for (uint8_t i = 0; i < count; i++)
+    {
+        actionslink_notification_t kind = (actionslink_notification_t) order[i];
+        if (m_notifications.send_fn(kind, values[kind]) == 0)
+        {
+            m_notifications.stats.sent++;
+        }
+        else
+        {
+            m_notifications.stats.failed++;
+            ret_val = -1;
+        }
+    }
+
+    return ret_val;
+}
+
+bool actionslink_notifications_is_pending(void)
+{
+    return m_notifications.pending_count > 0;
+}
+
+void actionslink_notifications_get_stats(actionslink_notifications_stats_t *p_stats)
+{
+    *p_stats = m_notifications.stats;
+}
+
+static bool is_pending(actionslink_notification_t kind)
+{
+    for (uint8_t i = 0; i < m_notifications.pending_count; i++)
+    {
+        if (m_notifications.order[i] == kind)
+        {
+            return true;
+        }
+    }
+    return false;
+}
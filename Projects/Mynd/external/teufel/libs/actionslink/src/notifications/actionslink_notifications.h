@@ -0,0 +1,80 @@
+#pragma once
+
+#include "actionslink_types.h"
+
+typedef enum
+{
+    ACTIONSLINK_NOTIFICATION_AUX_CONNECTED,
+    ACTIONSLINK_NOTIFICATION_USB_CONNECTED,
+    ACTIONSLINK_NOTIFICATION_BATTERY_LEVEL,
+    ACTIONSLINK_NOTIFICATION_CHARGER_STATUS,
+    ACTIONSLINK_NOTIFICATION_BATTERY_FRIENDLY_CHARGING,
+    ACTIONSLINK_NOTIFICATION_ECO_MODE,
+    ACTIONSLINK_NOTIFICATION_COLOR,
+    ACTIONSLINK_NOTIFICATION_COUNT,
+} actionslink_notification_t;
+
+typedef struct
+{
+    uint32_t posted;   // Notifications handed in by the application
+    uint32_t replaced; // Pending values overwritten by a newer value of the same kind before being sent
+    uint32_t sent;     // Notifications confirmed by the Actions module
+    uint32_t failed;   // Notifications that could not be sent
+} actionslink_notifications_stats_t;
+
+/**
+ * @brief Function to send a single notification to the Actions module and wait for its ACK.
+ *
+ * @param[in] kind          notification kind
+ * @param[in] value         value of the notification, as encoded on the wire
+ *
+ * @return 0 if successful, -1 otherwise
+ */
+typedef int (*actionslink_notification_send_fn_t)(actionslink_notification_t kind, uint32_t value);
+
+/**
+ * @brief Initializes the notification batching and drops anything pending.
+ *
+ * @param[in] window_ms     time a notification may be held back to collect others, 0 sends right away
+ * @param[in] send_fn       function to send a notification with
+ */
+void actionslink_notifications_init(uint32_t window_ms, actionslink_notification_send_fn_t send_fn);
+
+/**
+ * @brief Posts a notification. Only the latest value per kind is sent, in the order the kinds were first posted.
+ *
+ * @param[in] kind          notification kind
+ * @param[in] value         value of the notification, as encoded on the wire
+ *
+ * @return 0 if sent or held back successfully, -1 otherwise
+ */
+int actionslink_notifications_post(actionslink_notification_t kind, uint32_t value);
+
+/**
+ * @brief Sends the pending notifications once the oldest of them has waited for the whole window.
+ * @note  This function must be called periodically, e.g. from actionslink_tick().
+ *
+ * @return 0 if successful or nothing was due, -1 if any notification failed
+ */
+int actionslink_notifications_process(void);
+
+/**
+ * @brief Sends the pending notifications right away.
+ *
+ * @return 0 if successful or nothing was pending, -1 if any notification failed
+ */
+int actionslink_notifications_flush(void);
+
+/**
+ * @brief Checks if any notification is waiting to be sent.
+ *
+ * @return true if pending, false otherwise
+ */
+bool actionslink_notifications_is_pending(void);
+
+/**
+ * @brief Gets the notification counters since the last initialization.
+ *
+ * @param[out] p_stats      pointer to where the counters will be written to
+ */
+void actionslink_notifications_get_stats(actionslink_notifications_stats_t *p_stats);
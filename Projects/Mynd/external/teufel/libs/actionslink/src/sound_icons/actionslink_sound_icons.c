@@ -0,0 +1,333 @@
+#include "actionslink_sound_icons.h"
+#include "actionslink_log.h"
+#include "actionslink_utils.h"
+
+typedef struct
+{
+    actionslink_sound_icon_t          sound_icon;
+    actionslink_sound_icon_priority_t priority;
+    bool                              may_preempt; // Requested to play immediately
+    bool                              loop_forever;
+} entry_t;
+
+static struct
+{
+    const actionslink_sound_icons_config_t *p_config;
+    actionslink_sound_icon_play_fn_t        play_fn;
+    actionslink_sound_icon_stop_fn_t        stop_fn;
+    entry_t                                 pending[ACTIONSLINK_SOUND_ICONS_QUEUE_SIZE]; // By priority, then in order
+    uint8_t                                 pending_count;
+    entry_t                                 current; // ACTIONSLINK_SOUND_ICON_NONE while nothing plays
+    uint32_t                                current_begin_ts;
+    uint32_t                                current_length_ms;
+    actionslink_sound_icons_stats_t         stats;
+} m_sound_icons;
+
+static const actionslink_sound_icon_info_t *find_info(actionslink_sound_icon_t sound_icon);
+static actionslink_sound_icon_priority_t    get_priority(actionslink_sound_icon_t sound_icon);
+static uint32_t                             get_length_ms(actionslink_sound_icon_t sound_icon);
+static int                                  find_pending(actionslink_sound_icon_t sound_icon);
+static bool                                 enqueue(const entry_t *p_entry);
+static void                                 expire_current(void);
+static bool                                 is_preempted_by(const entry_t *p_next);
+static int                                  play(const entry_t *p_entry, actionslink_sound_icon_playback_mode_t mode);
+static int                                  stop(actionslink_sound_icon_t sound_icon);
+
+void actionslink_sound_icons_init(const actionslink_sound_icons_config_t *p_config,
+                                  actionslink_sound_icon_play_fn_t play_fn, actionslink_sound_icon_stop_fn_t stop_fn)
+{
+    m_sound_icons.p_config           = p_config;
+    m_sound_icons.play_fn            = play_fn;
+    m_sound_icons.stop_fn            = stop_fn;
+    m_sound_icons.pending_count      = 0;
+    m_sound_icons.current.sound_icon = ACTIONSLINK_SOUND_ICON_NONE;
+    m_sound_icons.stats              = (actionslink_sound_icons_stats_t){0};
+}
+
+int actionslink_sound_icons_request(actionslink_sound_icon_t               sound_icon,
+                                    actionslink_sound_icon_playback_mode_t playback_mode, bool loop_forever)
+{
+    if (sound_icon == ACTIONSLINK_SOUND_ICON_NONE)
+    {
+        log_error("sound icons: invalid sound icon %d", sound_icon);
+        return -1;
+    }
+
+    m_sound_icons.stats.requested++;
+
+    entry_t entry = {
+        .sound_icon   = sound_icon,
+        .priority     = get_priority(sound_icon),
+        .may_preempt  = playback_mode == ACTIONSLINK_SOUND_ICON_PLAYBACK_MODE_PLAY_IMMEDIATELY,
+        .loop_forever = loop_forever,
+    };
+
+    if (m_sound_icons.p_config == NULL)
+    {
+        return play(&entry, playback_mode);
+    }
+
+    // The sound icon is heard already, unless a looping one was asked for
+    expire_current();
+    if ((m_sound_icons.current.sound_icon == sound_icon) && (m_sound_icons.current.loop_forever || !loop_forever))
+    {
+        m_sound_icons.stats.merged++;
+        return 0;
+    }
+
+    int index = find_pending(sound_icon);
+    if (index >= 0)
+    {
+        // Last request wins, the sound icon keeps its place in the queue
+        m_sound_icons.pending[index] = entry;
+        m_sound_icons.stats.merged++;
+        return actionslink_sound_icons_process();
+    }
+
+    if (!enqueue(&entry))
+    {
+        log_warning("sound icons: queue full, sound icon %d dropped", sound_icon);
+        m_sound_icons.stats.dropped++;
+        return -1;
+    }
+
+    return actionslink_sound_icons_process();
+}
+
+int actionslink_sound_icons_cancel(actionslink_sound_icon_t sound_icon)
+{
+    if (m_sound_icons.p_config == NULL)
+    {
+        return stop(sound_icon);
+    }
+
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < m_sound_icons.pending_count; i++)
+    {
+        if ((sound_icon == ACTIONSLINK_SOUND_ICON_NONE) || (m_sound_icons.pending[i].sound_icon == sound_icon))
+        {
+            m_sound_icons.stats.cancelled++;
+        }
+        else
+        {
+            m_sound_icons.pending[kept++] = m_sound_icons.pending[i];
+        }
+    }
+    m_sound_icons.pending_count = kept;
+
+    // Only a sound icon that is still playing needs a request, the Actions module ignores stopping any other one
+    expire_current();
+    if ((m_sound_icons.current.sound_icon == ACTIONSLINK_SOUND_ICON_NONE) ||
+        ((sound_icon != ACTIONSLINK_SOUND_ICON_NONE) && (m_sound_icons.current.sound_icon != sound_icon)))
+    {
+        return 0;
+    }
+
+    int ret_val                      = stop(sound_icon);
+    m_sound_icons.current.sound_icon = ACTIONSLINK_SOUND_ICON_NONE;
+    if (actionslink_sound_icons_process() != 0)
+    {
+        ret_val = -1;
+    }
+    return ret_val;
+}
+
+int actionslink_sound_icons_process(void)
+{
+    int ret_val = 0;
+
+    if (m_sound_icons.p_config == NULL)
+    {
+        return 0;
+    }
+
+    expire_current();
+    while (m_sound_icons.pending_count > 0)
+    {
+        entry_t next    = m_sound_icons.pending[0];
+        bool    preempt = m_sound_icons.current.sound_icon != ACTIONSLINK_SOUND_ICON_NONE;
+        if (preempt && !is_preempted_by(&next))
+        {
+            break;
+        }
+
+        m_sound_icons.pending_count--;
+        for (uint8_t i = 0; i < m_sound_icons.pending_count; i++)
+        {
+            m_sound_icons.pending[i] = m_sound_icons.pending[i + 1];
+        }
+
+        // A looping sound icon interrupted by a more important one carries on afterwards, one interrupted by an
+        // equally important one is replaced by it
+        if (preempt)
+        {
+            m_sound_icons.stats.preempted++;
+            if (m_sound_icons.current.loop_forever && (next.priority > m_sound_icons.current.priority))
+            {
+                enqueue(&m_sound_icons.current);
+            }
+        }
+
+        // The Actions module interrupts the playing sound icon only when asked to, so one that plays a bit longer
+        // than its length isn't cut off by the next one
+        if (play(&next, preempt ? ACTIONSLINK_SOUND_ICON_PLAYBACK_MODE_PLAY_IMMEDIATELY
+                                : ACTIONSLINK_SOUND_ICON_PLAYBACK_MODE_PLAY_AFTER_CURRENT) != 0)
+        {
+            m_sound_icons.current.sound_icon = ACTIONSLINK_SOUND_ICON_NONE;
+            ret_val                          = -1;
+            continue;
+        }
+
+        m_sound_icons.current           = next;
+        m_sound_icons.current_begin_ts  = actionslink_utils_get_ms();
+        m_sound_icons.current_length_ms = get_length_ms(next.sound_icon);
+    }
+
+    return ret_val;
+}
+
+actionslink_sound_icon_t actionslink_sound_icons_get_current(uint32_t *p_played_ms)
+{
+    expire_current();
+    if (p_played_ms)
+    {
+        *p_played_ms = actionslink_utils_get_ms_since(m_sound_icons.current_begin_ts);
+    }
+    return m_sound_icons.current.sound_icon;
+}
+
+bool actionslink_sound_icons_is_scheduled(actionslink_sound_icon_t sound_icon)
+{
+    return (actionslink_sound_icons_get_current(NULL) == sound_icon) || (find_pending(sound_icon) >= 0);
+}
+
+uint32_t actionslink_sound_icons_get_due_ms(void)
+{
+    expire_current();
+    if (m_sound_icons.pending_count == 0)
+    {
+        return UINT32_MAX;
+    }
+    if (m_sound_icons.current.sound_icon == ACTIONSLINK_SOUND_ICON_NONE)
+    {
+        return 0;
+    }
+    if (m_sound_icons.current.loop_forever)
+    {
+        return UINT32_MAX;
+    }
+    return m_sound_icons.current_length_ms - actionslink_utils_get_ms_since(m_sound_icons.current_begin_ts);
+}
+
+void actionslink_sound_icons_get_stats(actionslink_sound_icons_stats_t *p_stats)
+{
+    *p_stats = m_sound_icons.stats;
+}
+
+static const actionslink_sound_icon_info_t *find_info(actionslink_sound_icon_t sound_icon)
+{
+    if (m_sound_icons.p_config == NULL)
+    {
+        return NULL;
+    }
+
+    for (uint8_t i = 0; i < m_sound_icons.p_config->sound_icons_count; i++)
+    {
+        if (m_sound_icons.p_config->p_sound_icons[i].sound_icon == sound_icon)
+        {
+            return &m_sound_icons.p_config->p_sound_icons[i];
+        }
+    }
+    return NULL;
+}
+
+static actionslink_sound_icon_priority_t get_priority(actionslink_sound_icon_t sound_icon)
+{
+    const actionslink_sound_icon_info_t *p_info = find_info(sound_icon);
+    return p_info ? p_info->priority : ACTIONSLINK_SOUND_ICON_PRIORITY_NORMAL;
+}
+
+static uint32_t get_length_ms(actionslink_sound_icon_t sound_icon)
+{
+    const actionslink_sound_icon_info_t *p_info = find_info(sound_icon);
+    return (p_info && p_info->length_ms) ? p_info->length_ms : m_sound_icons.p_config->default_length_ms;
+}
+
+static int find_pending(actionslink_sound_icon_t sound_icon)
+{
+    for (uint8_t i = 0; i < m_sound_icons.pending_count; i++)
+    {
+        if (m_sound_icons.pending[i].sound_icon == sound_icon)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// A full queue makes room by dropping its least important sound icon, if that's less important than the new one
+static bool enqueue(const entry_t *p_entry)
+{
+    if (m_sound_icons.pending_count == ACTIONSLINK_SOUND_ICONS_QUEUE_SIZE)
+    {
+        if (m_sound_icons.pending[m_sound_icons.pending_count - 1].priority >= p_entry->priority)
+        {
+            return false;
+        }
+        log_warning("sound icons: queue full, sound icon %d dropped",
+                    m_sound_icons.pending[m_sound_icons.pending_count - 1].sound_icon);
+        m_sound_icons.pending_count--;
+        m_sound_icons.stats.dropped++;
+    }
+
+    uint8_t index = m_sound_icons.pending_count;
+    while ((index > 0) && (m_sound_icons.pending[index - 1].priority < p_entry->priority))
+    {
+        m_sound_icons.pending[index] = m_sound_icons.pending[index - 1];
+        index--;
+    }
+    m_sound_icons.pending[index] = *p_entry;
+    m_sound_icons.pending_count++;
+    return true;
+}
+
+static void expire_current(void)
+{
+    if ((m_sound_icons.current.sound_icon != ACTIONSLINK_SOUND_ICON_NONE) && !m_sound_icons.current.loop_forever &&
+        (actionslink_utils_get_ms_since(m_sound_icons.current_begin_ts) >= m_sound_icons.current_length_ms))
+    {
+        m_sound_icons.current.sound_icon = ACTIONSLINK_SOUND_ICON_NONE;
+    }
+}
+
+// A looping sound icon never ends on its own, so it gives way to anything at least as important
+static bool is_preempted_by(const entry_t *p_next)
+{
+    if (m_sound_icons.current.loop_forever)
+    {
+        return p_next->priority >= m_sound_icons.current.priority;
+    }
+    return p_next->may_preempt && (p_next->priority > m_sound_icons.current.priority);
+}
+
+static int play(const entry_t *p_entry, actionslink_sound_icon_playback_mode_t mode)
+{
+    if (m_sound_icons.play_fn(p_entry->sound_icon, mode, p_entry->loop_forever) != 0)
+    {
+        m_sound_icons.stats.failed++;
+        return -1;
+    }
+    m_sound_icons.stats.played++;
+    return 0;
+}
+
+static int stop(actionslink_sound_icon_t sound_icon)
+{
+    if (m_sound_icons.stop_fn(sound_icon) != 0)
+    {
+        m_sound_icons.stats.failed++;
+        return -1;
+    }
+    m_sound_icons.stats.stopped++;
+    return 0;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "actionslink_types.h"
+
+#ifndef ACTIONSLINK_SOUND_ICONS_QUEUE_SIZE
+#define ACTIONSLINK_SOUND_ICONS_QUEUE_SIZE 4
+#endif
+
+/**
+ * @brief Function to send a play sound icon request to the Actions module and wait for its response.
+ *
+ * @param[in] sound_icon        sound icon to play
+ * @param[in] playback_mode     playback mode of the sound icon
+ * @param[in] loop_forever      true if the sound icon should be looped forever, false otherwise
+ *
+ * @return 0 if successful, -1 otherwise
+ */
+typedef int (*actionslink_sound_icon_play_fn_t)(actionslink_sound_icon_t               sound_icon,
+                                                actionslink_sound_icon_playback_mode_t playback_mode,
+                                                bool                                   loop_forever);
+
+/**
+ * @brief Function to send a stop sound icon request to the Actions module and wait for its response.
+ *
+ * @param[in] sound_icon        sound icon to stop, ACTIONSLINK_SOUND_ICON_NONE for any
+ *
+ * @return 0 if successful, -1 otherwise
+ */
+typedef int (*actionslink_sound_icon_stop_fn_t)(actionslink_sound_icon_t sound_icon);
+
+/**
+ * @brief Initializes the sound icon scheduling and drops anything pending or playing.
+ *
+ * @param[in] p_config      priorities and lengths of the sound icons, NULL sends requests right away
+ * @param[in] play_fn       function to play a sound icon with
+ * @param[in] stop_fn       function to stop a sound icon with
+ */
+void actionslink_sound_icons_init(const actionslink_sound_icons_config_t *p_config,
+                                  actionslink_sound_icon_play_fn_t play_fn, actionslink_sound_icon_stop_fn_t stop_fn);
+
+/**
+ * @brief Requests a sound icon. It's played right away if nothing plays or it may interrupt the playing one,
+ *        otherwise it waits by priority, then in the order requested. A request for the sound icon playing is
+ *        merged into it, one for a sound icon already waiting replaces the earlier one, which keeps its place.
+ *
+ * @param[in] sound_icon        sound icon to play
+ * @param[in] playback_mode     PLAY_AFTER_CURRENT never interrupts a playing sound icon unless that one loops
+ * @param[in] loop_forever      true if the sound icon should be looped forever, false otherwise
+ *
+ * @return 0 if played or queued successfully, -1 otherwise
+ */
+int actionslink_sound_icons_request(actionslink_sound_icon_t               sound_icon,
+                                    actionslink_sound_icon_playback_mode_t playback_mode, bool loop_forever);
+
+/**
+ * @brief Cancels a sound icon: it's taken out of the queue, and stopped if it plays. The next one waiting is
+ *        played then.
+ *
+ * @param[in] sound_icon        sound icon to cancel, ACTIONSLINK_SOUND_ICON_NONE for all of them
+ *
+ * @return 0 if successful or there was nothing to stop, -1 otherwise
+ */
+int actionslink_sound_icons_cancel(actionslink_sound_icon_t sound_icon);
+
+/**
+ * @brief Plays the next sound icon once the playing one is done.
+ * @note  This function must be called periodically, e.g. from actionslink_tick().
+ *
+ * @return 0 if successful or nothing was due, -1 if any sound icon failed to play
+ */
+int actionslink_sound_icons_process(void);
+
+/**
+ * @brief Gets the sound icon that is playing, as far as its length tells.
+ *
+ * @param[out] p_played_ms      optional, where the time since it was started will be written to
+ *
+ * @return sound icon playing, ACTIONSLINK_SOUND_ICON_NONE if none
+ */
+actionslink_sound_icon_t actionslink_sound_icons_get_current(uint32_t *p_played_ms);
+
+/**
+ * @brief Checks if a sound icon is playing or waiting to be played.
+ *
+ * @param[in] sound_icon        sound icon to check
+ *
+ * @return true if playing or waiting, false otherwise
+ */
+bool actionslink_sound_icons_is_scheduled(actionslink_sound_icon_t sound_icon);
+
+/**
+ * @brief Gets the time until the next waiting sound icon is due to be played.
+ *
+ * @return milliseconds until due, 0 if due already, UINT32_MAX if none is waiting for a playing one to end
+ */
+uint32_t actionslink_sound_icons_get_due_ms(void);
+
+/**
+ * @brief Gets the sound icon counters since the last initialization.
+ *
+ * @param[out] p_stats      pointer to where the counters will be written to
+ */
+void actionslink_sound_icons_get_stats(actionslink_sound_icons_stats_t *p_stats);
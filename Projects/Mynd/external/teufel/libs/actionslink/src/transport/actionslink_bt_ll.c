@@ -13,6 +13,11 @@
 
 #define INITIAL_CRC8_VALUE              (0x00u)
 
+// Set to 1 to take the CRC of whole buffers two bytes at a time, for another 256 bytes of flash
+#ifndef ACTIONSLINK_CRC8_SLICE_BY_2
+#define ACTIONSLINK_CRC8_SLICE_BY_2     0
+#endif
+
 #define PACKET_HEADER_SIZE              (8u)
 #define PACKET_START_MAGIC_BYTE         (0x55u)
 
@@ -51,11 +56,25 @@ static struct
     size_t                  received_data_length;
     size_t                  buffered_data_length;
     uint32_t                last_rx_timestamp;
+    uint8_t                 crc;        // CRC of the header or the payload received so far
+    uint8_t                 header_crc; // CRC of the header, once the payload has started
+    bool                    has_received_frame;
 } m_bt_ll;
 
+typedef struct
+{
+    uint8_t *p_next;
+    uint8_t  crc;
+} crc_stream_state_t;
+
+static int     encode_payload(const ActionsLink_FromMcu *p_message, const uint8_t **pp_payload,
+                              uint16_t *p_payload_length, uint8_t *p_payload_crc);
+static bool    write_with_crc(pb_ostream_t *p_stream, const pb_byte_t *p_buffer, size_t count);
+static bool    append_escaped(uint8_t *p_frame, size_t *p_frame_length, size_t *p_spare, const uint8_t *p_data,
+                              size_t length);
 static void    reset_transport_state(void);
-static size_t  get_number_of_escaped_chars(const uint8_t *p_buffer, size_t length);
 static bool    is_escape_required(uint8_t byte);
+static uint8_t update_crc8(uint8_t crc, uint8_t byte);
 static uint8_t calculate_crc8(uint8_t crc, const uint8_t *p_buffer, size_t length);
 static int     process_received_byte(uint8_t byte, actionslink_bt_ll_rx_packet_t *p_packet);
 static int     validate_received_data(actionslink_bt_ll_rx_packet_t *p_packet);
@@ -64,7 +83,8 @@ static int     send_nack(uint8_t transaction_id, uint8_t nack_reason);
 
 void actionslink_bt_ll_init(const actionslink_config_t *p_config)
 {
-    m_bt_ll.p_config = p_config;
+    m_bt_ll.p_config           = p_config;
+    m_bt_ll.has_received_frame = false;
     actionslink_bt_ll_reset();
 }
 
@@ -76,93 +96,50 @@ void actionslink_bt_ll_reset(void)
 
 int actionslink_bt_ll_tx(const actionslink_bt_ll_tx_packet_t *p_packet)
 {
-    uint8_t *p_tx_buffer                     = m_bt_ll.p_config->p_tx_buffer;
-    uint16_t tx_buffer_size                  = m_bt_ll.p_config->tx_buffer_size;
-    p_tx_buffer[PACKET_INDEX_START_BYTE]     = PACKET_START_MAGIC_BYTE;
-    p_tx_buffer[PACKET_INDEX_PACKET_TYPE]    = (p_packet->value << 3) | p_packet->packet_type;
-    p_tx_buffer[PACKET_INDEX_TRANSACTION_ID] = p_packet->transaction_id;
-    p_tx_buffer[PACKET_INDEX_RESERVED]       = 0x00;
+    const uint8_t *p_payload;
+    uint16_t       payload_length;
+    uint8_t        payload_crc;
 
-    size_t payload_length;
-    if (p_packet->p_payload != NULL)
+    if (p_packet->p_payload == NULL)
     {
-        if (!pb_get_encoded_size(&payload_length, ActionsLink_FromMcu_fields, p_packet->p_payload))
-        {
-            log_error("bt_ll: failed to calculate encoded payload size");
-            return -1;
-        }
-
-        pb_ostream_t stream_out = pb_ostream_from_buffer(&p_tx_buffer[PACKET_INDEX_PAYLOAD_START], tx_buffer_size - PACKET_HEADER_SIZE);
-        if (!pb_encode(&stream_out, ActionsLink_FromMcu_fields, p_packet->p_payload))
-        {
-            log_error("bt_ll: failed to encode payload");
-            return -1;
-        }
-
-        uint8_t payload_crc = calculate_crc8(INITIAL_CRC8_VALUE, &p_tx_buffer[PACKET_INDEX_PAYLOAD_START], payload_length);
-        p_tx_buffer[PACKET_INDEX_PAYLOAD_LENGTH_LSB] = payload_length & 0xFF;
-        p_tx_buffer[PACKET_INDEX_PAYLOAD_LENGTH_MSB] = (payload_length >> 8) & 0xFF;
-        p_tx_buffer[PACKET_INDEX_PAYLOAD_CRC] = payload_crc;
+        p_payload      = p_packet->p_encoded_payload;
+        payload_length = p_packet->encoded_payload_length;
+        payload_crc    = calculate_crc8(INITIAL_CRC8_VALUE, p_payload, payload_length);
     }
-    else
+    else if (encode_payload(p_packet->p_payload, &p_payload, &payload_length, &payload_crc) != 0)
     {
-        payload_length = 0;
-        p_tx_buffer[PACKET_INDEX_PAYLOAD_LENGTH_LSB] = 0;
-        p_tx_buffer[PACKET_INDEX_PAYLOAD_LENGTH_MSB] = 0;
-        p_tx_buffer[PACKET_INDEX_PAYLOAD_CRC] = INITIAL_CRC8_VALUE;
-    }
-
-    uint8_t header_crc = calculate_crc8(INITIAL_CRC8_VALUE, p_tx_buffer, PACKET_HEADER_SIZE - 1);
-    p_tx_buffer[PACKET_INDEX_HEADER_CRC] = header_crc;
-
-    size_t escaped_chars_in_header  = get_number_of_escaped_chars(p_tx_buffer, PACKET_HEADER_SIZE);
-    size_t escaped_chars_in_payload = get_number_of_escaped_chars(&p_tx_buffer[PACKET_INDEX_PAYLOAD_START], payload_length);
-
-    // The amount of data to send is header + payload,
-    // plus one extra byte per escaped byte
-    // plus 2 bytes for start/end frame delimiters,
-    size_t total_length = PACKET_HEADER_SIZE + payload_length + escaped_chars_in_header + escaped_chars_in_payload + 2;
-    if (total_length > tx_buffer_size)
-    {
-        log_error("bt_ll: tx buffer is not large enough for tx (%d required)", total_length);
         return -1;
     }
 
-    // We reuse the same buffer to build the HDLC frame
-    // We start writing to the end of the buffer,
-    // moving the bytes from the end of the original payload
-    // to their final positions in the tx frame.
-    // The index of any given byte in the original payload is always
-    // lower than its index in the final tx frame, so this is safe
-    // i.e. payload[0] is always frame[1], payload[1] is always frame[2] or frame[3], ...
-    size_t index_in_escaped_array         = total_length - 1;
-    p_tx_buffer[index_in_escaped_array--] = HDLC_FRAME_DELIMITER;
-
-    uint32_t length_before_escaping_data = PACKET_HEADER_SIZE + payload_length;
-    for (int i = length_before_escaping_data - 1; i >= 0; i--)
-    {
-        if (is_escape_required(p_tx_buffer[i]))
-        {
-            p_tx_buffer[index_in_escaped_array--] = p_tx_buffer[i] ^ HDLC_ESCAPE_MASK;
-            p_tx_buffer[index_in_escaped_array--] = HDLC_ESCAPE_CHARACTER;
-        }
-        else
-        {
-            p_tx_buffer[index_in_escaped_array--] = p_tx_buffer[i];
-        }
-    }
-
-    // After moving each byte in the payload to its respective index,
-    // we should have ended with index 0, where the frame delimiter goes
-    if (index_in_escaped_array != 0)
+    uint8_t header[PACKET_HEADER_SIZE];
+    header[PACKET_INDEX_START_BYTE]         = PACKET_START_MAGIC_BYTE;
+    header[PACKET_INDEX_PACKET_TYPE]        = (p_packet->value << 3) | p_packet->packet_type;
+    header[PACKET_INDEX_TRANSACTION_ID]     = p_packet->transaction_id;
+    header[PACKET_INDEX_PAYLOAD_LENGTH_LSB] = payload_length & 0xFF;
+    header[PACKET_INDEX_PAYLOAD_LENGTH_MSB] = (payload_length >> 8) & 0xFF;
+    header[PACKET_INDEX_PAYLOAD_CRC]        = payload_crc;
+    header[PACKET_INDEX_RESERVED]           = 0x00;
+    header[PACKET_INDEX_HEADER_CRC]         = calculate_crc8(INITIAL_CRC8_VALUE, header, PACKET_HEADER_SIZE - 1);
+
+    // The frame is the header and the payload between two delimiters,
+    // the bytes to spare in the buffer are used up by escape characters
+    uint8_t *p_tx_buffer      = m_bt_ll.p_config->p_tx_buffer;
+    uint16_t tx_buffer_size   = m_bt_ll.p_config->tx_buffer_size;
+    size_t   unescaped_length = PACKET_HEADER_SIZE + payload_length + 2;
+    size_t   spare            = (unescaped_length <= tx_buffer_size) ? (tx_buffer_size - unescaped_length) : 0;
+    size_t   frame_length     = 0;
+
+    p_tx_buffer[frame_length++] = HDLC_FRAME_DELIMITER;
+    if ((unescaped_length > tx_buffer_size) ||
+        !append_escaped(p_tx_buffer, &frame_length, &spare, header, PACKET_HEADER_SIZE) ||
+        !append_escaped(p_tx_buffer, &frame_length, &spare, p_payload, payload_length))
     {
-        log_error("bt_ll: failed to construct tx frame");
+        log_error("bt_ll: tx buffer is not large enough for tx (%d bytes payload)", payload_length);
         return -1;
     }
+    p_tx_buffer[frame_length++] = HDLC_FRAME_DELIMITER;
 
-    p_tx_buffer[0] = HDLC_FRAME_DELIMITER;
-
-    int ret_val = m_bt_ll.p_config->write_buffer_fn(p_tx_buffer, total_length, UART_TX_TIMEOUT_MS);
+    int ret_val = m_bt_ll.p_config->write_buffer_fn(p_tx_buffer, frame_length, UART_TX_TIMEOUT_MS);
     if (ret_val != 0)
     {
         log_error("bt_ll: failed to send data over UART");
@@ -182,6 +159,7 @@ int actionslink_bt_ll_rx(actionslink_bt_ll_rx_packet_t *p_packet)
         int rx_result = process_received_byte(byte, p_packet);
         if (rx_result >= 0)
         {
+            m_bt_ll.has_received_frame = true;
             reset_transport_state();
             return 1;
         }
@@ -209,11 +187,109 @@ int actionslink_bt_ll_rx(actionslink_bt_ll_rx_packet_t *p_packet)
     return 0;
 }
 
+bool actionslink_bt_ll_is_receiving(void)
+{
+    return m_bt_ll.received_data_length > 0;
+}
+
+bool actionslink_bt_ll_has_received_frame(void)
+{
+    return m_bt_ll.has_received_frame;
+}
+
+/**
+ * @brief This function encodes a message with nanopb into the end of the TX buffer, taking its CRC on the way.
+ * @note  The frame is escaped into the same buffer afterwards, front to back. The payload sits where its last
+ *        byte would be if nothing needed escaping, so each byte is read before the frame grows over it.
+ *
+ * @param[in]  p_message           message to encode
+ * @param[out] pp_payload          where the encoded payload starts in the TX buffer
+ * @param[out] p_payload_length    length of the encoded payload
+ * @param[out] p_payload_crc       CRC of the encoded payload
+ *
+ * @return 0 if successful, -1 otherwise
+ */
+static int encode_payload(const ActionsLink_FromMcu *p_message, const uint8_t **pp_payload,
+                          uint16_t *p_payload_length, uint8_t *p_payload_crc)
+{
+    uint8_t *p_tx_buffer    = m_bt_ll.p_config->p_tx_buffer;
+    uint16_t tx_buffer_size = m_bt_ll.p_config->tx_buffer_size;
+
+    size_t payload_length;
+    if (!pb_get_encoded_size(&payload_length, ActionsLink_FromMcu_fields, p_message))
+    {
+        log_error("bt_ll: failed to calculate encoded payload size");
+        return -1;
+    }
+
+    if (PACKET_HEADER_SIZE + payload_length + 2 > tx_buffer_size)
+    {
+        log_error("bt_ll: tx buffer is not large enough for tx (%d bytes payload)", payload_length);
+        return -1;
+    }
+
+    crc_stream_state_t state      = {&p_tx_buffer[tx_buffer_size - payload_length], INITIAL_CRC8_VALUE};
+    pb_ostream_t       stream_out = {.callback = write_with_crc, .state = &state, .max_size = payload_length};
+    if (!pb_encode(&stream_out, ActionsLink_FromMcu_fields, p_message))
+    {
+        log_error("bt_ll: failed to encode payload");
+        return -1;
+    }
+
+    *pp_payload       = &p_tx_buffer[tx_buffer_size - payload_length];
+    *p_payload_length = payload_length;
+    *p_payload_crc    = state.crc;
+    return 0;
+}
+
+static bool write_with_crc(pb_ostream_t *p_stream, const pb_byte_t *p_buffer, size_t count)
+{
+    crc_stream_state_t *p_state = p_stream->state;
+    memcpy(p_state->p_next, p_buffer, count);
+    p_state->p_next += count;
+    p_state->crc = calculate_crc8(p_state->crc, p_buffer, count);
+    return true;
+}
+
+/**
+ * @brief This function appends escaped data to a frame.
+ * @note  Every escaped byte takes one of the spare bytes. As long as there are any left, the rest of the data and
+ *        the closing delimiter still fit behind the frame, also when the data is at the end of the same buffer.
+ *
+ * @return true if the data fit into the frame, false otherwise
+ */
+static bool append_escaped(uint8_t *p_frame, size_t *p_frame_length, size_t *p_spare, const uint8_t *p_data,
+                           size_t length)
+{
+    size_t frame_length = *p_frame_length;
+    for (size_t i = 0; i < length; i++)
+    {
+        uint8_t byte = p_data[i];
+        if (is_escape_required(byte))
+        {
+            if (*p_spare == 0)
+            {
+                return false;
+            }
+            (*p_spare)--;
+            p_frame[frame_length++] = HDLC_ESCAPE_CHARACTER;
+            p_frame[frame_length++] = byte ^ HDLC_ESCAPE_MASK;
+        }
+        else
+        {
+            p_frame[frame_length++] = byte;
+        }
+    }
+    *p_frame_length = frame_length;
+    return true;
+}
+
 static void reset_transport_state(void)
 {
     m_bt_ll.received_data_length = 0;
     m_bt_ll.buffered_data_length = 0;
     m_bt_ll.state                = TRANSPORT_STATE_DATA;
+    m_bt_ll.crc                  = INITIAL_CRC8_VALUE;
 }
 
 /**
@@ -274,6 +350,19 @@ static int process_received_byte(uint8_t byte, actionslink_bt_ll_rx_packet_t *p_
                 // Next byte should be normal data again
                 m_bt_ll.state = TRANSPORT_STATE_DATA;
             }
+
+            // The CRCs are taken while unescaping, one over the bytes before the header CRC
+            // and one over the bytes after it
+            if (m_bt_ll.buffered_data_length == PACKET_INDEX_HEADER_CRC)
+            {
+                m_bt_ll.header_crc = m_bt_ll.crc;
+                m_bt_ll.crc        = INITIAL_CRC8_VALUE;
+            }
+            else
+            {
+                m_bt_ll.crc = update_crc8(m_bt_ll.crc, byte);
+            }
+
             m_bt_ll.p_config->p_rx_buffer[m_bt_ll.buffered_data_length] = byte;
             m_bt_ll.buffered_data_length++;
         }
@@ -296,7 +385,7 @@ static int process_received_byte(uint8_t byte, actionslink_bt_ll_rx_packet_t *p_
 static int validate_received_data(actionslink_bt_ll_rx_packet_t *p_packet) {
     const uint8_t *p_rx_data = m_bt_ll.p_config->p_rx_buffer;
 
-    uint8_t calculated_header_crc = calculate_crc8(INITIAL_CRC8_VALUE, p_rx_data, PACKET_HEADER_SIZE - 1);
+    uint8_t calculated_header_crc = m_bt_ll.header_crc;
     if (calculated_header_crc != p_rx_data[PACKET_INDEX_HEADER_CRC])
     {
         log_error("bt_ll: invalid header crc (exp 0x%08X, recv 0x%08X)",
@@ -324,7 +413,15 @@ static int validate_received_data(actionslink_bt_ll_rx_packet_t *p_packet) {
     uint8_t transaction_id = p_rx_data[PACKET_INDEX_TRANSACTION_ID];
     uint16_t payload_length = (p_rx_data[PACKET_INDEX_PAYLOAD_LENGTH_MSB] << 8) | p_rx_data[PACKET_INDEX_PAYLOAD_LENGTH_LSB];
 
-    uint8_t calculated_payload_crc = calculate_crc8(INITIAL_CRC8_VALUE, &p_rx_data[PACKET_INDEX_PAYLOAD_START], payload_length);
+    if (payload_length != m_bt_ll.buffered_data_length - PACKET_HEADER_SIZE)
+    {
+        log_error("bt_ll: invalid payload length (header %d, received %d)",
+                        payload_length, m_bt_ll.buffered_data_length - PACKET_HEADER_SIZE);
+        send_nack(0, NACK_REASON_INVALID_LENGTH);
+        return PROCESS_FRAME_ERROR;
+    }
+
+    uint8_t calculated_payload_crc = m_bt_ll.crc;
     if (calculated_payload_crc != p_rx_data[PACKET_INDEX_PAYLOAD_CRC])
     {
         log_error("bt_ll: invalid payload crc (exp 0x%08X, recv 0x%08X)",
@@ -378,24 +475,6 @@ static int validate_received_data(actionslink_bt_ll_rx_packet_t *p_packet) {
     return 0;
 }
 
-static size_t get_number_of_escaped_chars(const uint8_t *p_buffer, size_t length)
-{
-    if (!p_buffer || length == 0)
-    {
-        return 0;
-    }
-
-    size_t escaped_chars = 0;
-    for (size_t i = 0; i < length; ++i)
-    {
-        if (p_buffer[i] == HDLC_FRAME_DELIMITER || p_buffer[i] == HDLC_ESCAPE_CHARACTER)
-        {
-            escaped_chars++;
-        }
-    }
-    return escaped_chars;
-}
-
 static bool is_escape_required(uint8_t byte)
 {
     return (byte == HDLC_FRAME_DELIMITER || byte == HDLC_ESCAPE_CHARACTER);
@@ -442,7 +521,57 @@ static const uint8_t crc8_table[] = {
     0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3,
 };
 
+#if ACTIONSLINK_CRC8_SLICE_BY_2
+// crc8_table applied twice: the CRC of a byte followed by a zero byte. As the CRC is linear,
+// the CRC after two bytes is crc8_table_2[crc ^ first] ^ crc8_table[second].
+static const uint8_t crc8_table_2[] = {
+    0x00, 0x15, 0x2a, 0x3f, 0x54, 0x41, 0x7e, 0x6b,
+    0xa8, 0xbd, 0x82, 0x97, 0xfc, 0xe9, 0xd6, 0xc3,
+    0x57, 0x42, 0x7d, 0x68, 0x03, 0x16, 0x29, 0x3c,
+    0xff, 0xea, 0xd5, 0xc0, 0xab, 0xbe, 0x81, 0x94,
+    0xae, 0xbb, 0x84, 0x91, 0xfa, 0xef, 0xd0, 0xc5,
+    0x06, 0x13, 0x2c, 0x39, 0x52, 0x47, 0x78, 0x6d,
+    0xf9, 0xec, 0xd3, 0xc6, 0xad, 0xb8, 0x87, 0x92,
+    0x51, 0x44, 0x7b, 0x6e, 0x05, 0x10, 0x2f, 0x3a,
+    0x5b, 0x4e, 0x71, 0x64, 0x0f, 0x1a, 0x25, 0x30,
+    0xf3, 0xe6, 0xd9, 0xcc, 0xa7, 0xb2, 0x8d, 0x98,
+    0x0c, 0x19, 0x26, 0x33, 0x58, 0x4d, 0x72, 0x67,
+    0xa4, 0xb1, 0x8e, 0x9b, 0xf0, 0xe5, 0xda, 0xcf,
+    0xf5, 0xe0, 0xdf, 0xca, 0xa1, 0xb4, 0x8b, 0x9e,
+    0x5d, 0x48, 0x77, 0x62, 0x09, 0x1c, 0x23, 0x36,
+    0xa2, 0xb7, 0x88, 0x9d, 0xf6, 0xe3, 0xdc, 0xc9,
+    0x0a, 0x1f, 0x20, 0x35, 0x5e, 0x4b, 0x74, 0x61,
+    0xb6, 0xa3, 0x9c, 0x89, 0xe2, 0xf7, 0xc8, 0xdd,
+    0x1e, 0x0b, 0x34, 0x21, 0x4a, 0x5f, 0x60, 0x75,
+    0xe1, 0xf4, 0xcb, 0xde, 0xb5, 0xa0, 0x9f, 0x8a,
+    0x49, 0x5c, 0x63, 0x76, 0x1d, 0x08, 0x37, 0x22,
+    0x18, 0x0d, 0x32, 0x27, 0x4c, 0x59, 0x66, 0x73,
+    0xb0, 0xa5, 0x9a, 0x8f, 0xe4, 0xf1, 0xce, 0xdb,
+    0x4f, 0x5a, 0x65, 0x70, 0x1b, 0x0e, 0x31, 0x24,
+    0xe7, 0xf2, 0xcd, 0xd8, 0xb3, 0xa6, 0x99, 0x8c,
+    0xed, 0xf8, 0xc7, 0xd2, 0xb9, 0xac, 0x93, 0x86,
+    0x45, 0x50, 0x6f, 0x7a, 0x11, 0x04, 0x3b, 0x2e,
+    0xba, 0xaf, 0x90, 0x85, 0xee, 0xfb, 0xc4, 0xd1,
+    0x12, 0x07, 0x38, 0x2d, 0x46, 0x53, 0x6c, 0x79,
+    0x43, 0x56, 0x69, 0x7c, 0x17, 0x02, 0x3d, 0x28,
+    0xeb, 0xfe, 0xc1, 0xd4, 0xbf, 0xaa, 0x95, 0x80,
+    0x14, 0x01, 0x3e, 0x2b, 0x40, 0x55, 0x6a, 0x7f,
+    0xbc, 0xa9, 0x96, 0x83, 0xe8, 0xfd, 0xc2, 0xd7,
+};
+#endif
+
+static uint8_t update_crc8(uint8_t crc, uint8_t byte)
+{
+    return crc8_table[crc ^ byte];
+}
+
 static uint8_t calculate_crc8(uint8_t crc, const uint8_t *p_buffer, size_t length) {
+#if ACTIONSLINK_CRC8_SLICE_BY_2
+    for (; length >= 2; length -= 2, p_buffer += 2)
+    {
+        crc = crc8_table_2[crc ^ p_buffer[0]] ^ crc8_table[p_buffer[1]];
+    }
+#endif
     while (length--)
     {
         crc = crc8_table[crc ^ *p_buffer++];
@@ -14,6 +14,8 @@ typedef struct
     uint8_t value;
     uint8_t transaction_id;
     const ActionsLink_FromMcu *p_payload;
+    const uint8_t *p_encoded_payload;   // Payload encoded already, sent if p_payload is NULL
+    uint16_t encoded_payload_length;    // Length of the encoded payload
 } actionslink_bt_ll_tx_packet_t;
 
 typedef struct
@@ -48,6 +50,8 @@ void actionslink_bt_ll_reset(void);
  * @note  This function reuses the buffer passed to it to build a frame around
  *        the payload. If the buffer is not big enough to construct the frame,
  *        this function will return error.
+ *        A payload encoded already is escaped while it is copied into the frame,
+ *        without going through nanopb.
  *
  * @param[in] p_packet          pointer to packet to send
  * @param[in] p_tx_buffer       pointer to buffer to use for constructing the frame
@@ -67,3 +71,17 @@ int actionslink_bt_ll_tx(const actionslink_bt_ll_tx_packet_t *p_packet);
  *         -1 if a communication error occurred
  */
 int actionslink_bt_ll_rx(actionslink_bt_ll_rx_packet_t *p_packet);
+
+/**
+ * @brief Checks if part of a frame has been received, which is discarded if the rest doesn't follow in time.
+ *
+ * @return true if a frame is partly received, false otherwise
+ */
+bool actionslink_bt_ll_is_receiving(void);
+
+/**
+ * @brief Checks if any valid frame has been received since the initialization.
+ *
+ * @return true if a frame was received, false otherwise
+ */
+bool actionslink_bt_ll_has_received_frame(void);
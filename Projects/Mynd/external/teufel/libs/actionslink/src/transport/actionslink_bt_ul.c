@@ -36,6 +36,15 @@ static struct
     bool                                within_event_handler;
 } m_bt_ul;
 
+// A message to send, either as nanopb struct or encoded already
+typedef struct
+{
+    const ActionsLink_FromMcu           *p_message;
+    const actionslink_encoded_message_t *p_encoded;
+} outgoing_message_t;
+
+static int               tx_rx(const outgoing_message_t *p_outgoing, ActionsLink_ToMcu *p_response);
+static int               tx(const outgoing_message_t *p_outgoing);
 static transport_state_t transport_state_idle(const actionslink_bt_ll_rx_packet_t *p_packet);
 static transport_state_t transport_state_ack(const actionslink_bt_ll_rx_packet_t *p_packet);
 static transport_state_t transport_state_response(const actionslink_bt_ll_rx_packet_t *p_packet);
@@ -59,6 +68,16 @@ bool actionslink_bt_ul_is_busy(void)
     return m_bt_ul.state != TRANSPORT_STATE_IDLE;
 }
 
+bool actionslink_bt_ul_is_receiving(void)
+{
+    return actionslink_bt_ll_is_receiving();
+}
+
+bool actionslink_bt_ul_has_received_frame(void)
+{
+    return actionslink_bt_ll_has_received_frame();
+}
+
 void actionslink_bt_ul_stop_communication(void)
 {
     log_debug("bt_ul: stopping communication");
@@ -76,6 +95,24 @@ bool actionslink_bt_ul_is_communication_allowed(void) {
 }
 
 int actionslink_bt_ul_tx_rx(ActionsLink_FromMcu *p_message, ActionsLink_ToMcu *p_response)
+{
+    outgoing_message_t outgoing = {.p_message = p_message, .p_encoded = NULL};
+    return tx_rx(&outgoing, p_response);
+}
+
+int actionslink_bt_ul_tx_rx_encoded(const actionslink_encoded_message_t *p_message, ActionsLink_ToMcu *p_response)
+{
+    outgoing_message_t outgoing = {.p_message = NULL, .p_encoded = p_message};
+    return tx_rx(&outgoing, p_response);
+}
+
+int actionslink_bt_ul_tx(ActionsLink_FromMcu *p_message)
+{
+    outgoing_message_t outgoing = {.p_message = p_message, .p_encoded = NULL};
+    return tx(&outgoing);
+}
+
+static int tx_rx(const outgoing_message_t *p_outgoing, ActionsLink_ToMcu *p_response)
 {
     // Do not process commands if a protocol stop was requested
     if (m_bt_ul.stop_requested)
@@ -96,7 +133,7 @@ int actionslink_bt_ul_tx_rx(ActionsLink_FromMcu *p_message, ActionsLink_ToMcu *p
     m_bt_ul.tx_retries = 0;
     do
     {
-        if (actionslink_bt_ul_tx(p_message) == 0)
+        if (tx(p_outgoing) == 0)
         {
             do
             {
@@ -138,7 +175,7 @@ int actionslink_bt_ul_tx_rx(ActionsLink_FromMcu *p_message, ActionsLink_ToMcu *p
     return -1;
 }
 
-int actionslink_bt_ul_tx(ActionsLink_FromMcu *p_message)
+static int tx(const outgoing_message_t *p_outgoing)
 {
     // Do not process commands if a protocol stop was requested
     if (m_bt_ul.stop_requested)
@@ -156,27 +193,39 @@ int actionslink_bt_ul_tx(ActionsLink_FromMcu *p_message)
     m_bt_ul.state                 = TRANSPORT_STATE_ACK;
     m_message.timestamp           = actionslink_utils_get_ms();
 
+    const ActionsLink_FromMcu           *p_message = p_outgoing->p_message;
+    const actionslink_encoded_message_t *p_encoded = p_outgoing->p_encoded;
+
     uint8_t sequence_number = 0;
-    switch (p_message->which_Payload)
+    if (p_encoded != NULL)
     {
-        case ActionsLink_FromMcu_request_tag:
-            m_message.tag             = p_message->Payload.request.which_Request;
-            sequence_number           = p_message->Payload.request.seq;
-            m_message.expect_response = true;
-            break;
-        case ActionsLink_FromMcu_response_tag:
-            m_message.tag             = p_message->Payload.response.which_Response;
-            sequence_number           = p_message->Payload.response.seq;
-            m_message.expect_response = false;
-            break;
-        case ActionsLink_FromMcu_event_tag:
-            m_message.tag             = p_message->Payload.event.which_Event;
-            sequence_number           = 0;
-            m_message.expect_response = false;
-            break;
-        default:
-            log_error("bt_ul: invalid message type %d", p_message->which_Payload);
-            return -1;
+        m_message.tag             = p_encoded->tag;
+        sequence_number           = p_encoded->seq;
+        m_message.expect_response = p_encoded->which_payload == ActionsLink_FromMcu_request_tag;
+    }
+    else
+    {
+        switch (p_message->which_Payload)
+        {
+            case ActionsLink_FromMcu_request_tag:
+                m_message.tag             = p_message->Payload.request.which_Request;
+                sequence_number           = p_message->Payload.request.seq;
+                m_message.expect_response = true;
+                break;
+            case ActionsLink_FromMcu_response_tag:
+                m_message.tag             = p_message->Payload.response.which_Response;
+                sequence_number           = p_message->Payload.response.seq;
+                m_message.expect_response = false;
+                break;
+            case ActionsLink_FromMcu_event_tag:
+                m_message.tag             = p_message->Payload.event.which_Event;
+                sequence_number           = 0;
+                m_message.expect_response = false;
+                break;
+            default:
+                log_error("bt_ul: invalid message type %d", p_message->which_Payload);
+                return -1;
+        }
     }
 
     actionslink_bt_ll_tx_packet_t packet = {
@@ -184,6 +233,8 @@ int actionslink_bt_ul_tx(ActionsLink_FromMcu *p_message)
         .value = 0,
         .transaction_id = m_bt_ul.next_tx_transaction_id++,
         .p_payload = p_message,
+        .p_encoded_payload = (p_encoded != NULL) ? p_encoded->buffer : NULL,
+        .encoded_payload_length = (p_encoded != NULL) ? p_encoded->length : 0,
     };
 
     m_message.transaction_id = packet.transaction_id;
@@ -324,6 +375,13 @@ static transport_state_t transport_state_ack(const actionslink_bt_ll_rx_packet_t
     switch (p_packet->packet_type)
     {
         case ACTIONSLINK_BT_LL_PACKET_TYPE_ACK:
+            // A NACK carries the reason in the value and transaction ID 0, as the chip can't tell the ID of a broken
+            // frame, so it must not be taken for the ACK of transaction 0
+            if (p_packet->value != 0)
+            {
+                log_warning("bt_ul: received NACK (reason %d) while waiting for ACK", p_packet->value);
+                return TRANSPORT_STATE_ERROR;
+            }
 
             if (p_packet->transaction_id == m_message.transaction_id)
             {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "actionslink_encoders.h"
 #include "actionslink_types.h"
 #include "message.pb.h"
 
@@ -37,10 +38,24 @@ void actionslink_bt_ul_init(const actionslink_config_t *p_config, actionslink_bt
  */
 bool actionslink_bt_ul_is_busy(void);
 
+/**
+ * @brief Checks if the lower transport layer is in the middle of receiving a frame.
+ *
+ * @return true if a frame is partly received, false otherwise
+ */
+bool actionslink_bt_ul_is_receiving(void);
+
+/**
+ * @brief Checks if the lower transport layer has received any valid frame since the initialization.
+ *
+ * @return true if a frame was received, false otherwise
+ */
+bool actionslink_bt_ul_has_received_frame(void);
+
 /**
  * @brief Requests the Actions upper transport layer to stop processing TX/RX.
  */
-void actionslink_bt_ul_stop(void);
+void actionslink_bt_ul_stop_communication(void);
 
 /**
  * @brief Sends a message and waits for the Actions module to send the ACK/confirmation response.
@@ -62,6 +77,17 @@ int actionslink_bt_ul_tx_rx(ActionsLink_FromMcu *p_message, ActionsLink_ToMcu *p
  */
 int actionslink_bt_ul_tx(ActionsLink_FromMcu *p_message);
 
+/**
+ * @brief Sends a message encoded already and waits for the Actions module to send the ACK/confirmation response.
+ * @note  Same as actionslink_bt_ul_tx_rx(), without the nanopb struct and encoding.
+ *
+ * @param[in]  p_message        pointer to encoded message to send
+ * @param[out] p_response       pointer to struct where the response should be written to
+ *
+ * @return 0 if successful, -1 otherwise
+ */
+int actionslink_bt_ul_tx_rx_encoded(const actionslink_encoded_message_t *p_message, ActionsLink_ToMcu *p_response);
+
 /**
  * @brief Processes received data and gets a response, if any.
  * @note  This function must be called periodically.
@@ -0,0 +1,501 @@
+#include "actionslink_chip_sim.h"
+
+#include <algorithm>
+
+#include "message.pb.h"
+
+namespace actionslink_sim
+{
+
+namespace
+{
+
+constexpr uint8_t HDLC_FRAME_DELIMITER  = 0x7E;
+constexpr uint8_t HDLC_ESCAPE_CHARACTER = 0x7D;
+constexpr uint8_t HDLC_ESCAPE_MASK      = 0x20;
+
+constexpr size_t  HEADER_SIZE      = 8;
+constexpr uint8_t START_MAGIC_BYTE = 0x55;
+constexpr uint8_t PACKET_TYPE_ACK  = 0;
+constexpr uint8_t PACKET_TYPE_PB   = 1;
+constexpr uint8_t NACK_BAD_CRC     = 2;
+
+// Payload fields of ToMcu and FromMcu
+constexpr uint32_t FIELD_REQUEST  = 1;
+constexpr uint32_t FIELD_RESPONSE = 2;
+constexpr uint32_t FIELD_EVENT    = 3;
+constexpr uint32_t FIELD_SEQ      = 1;
+
+ChipSim *p_active_chip = nullptr;
+
+uint8_t rx_buffer[64];
+uint8_t tx_buffer[32];
+
+uint8_t crc8(const uint8_t *p_data, size_t length)
+{
+    uint8_t crc = 0;
+    while (length--)
+    {
+        crc ^= *p_data++;
+        for (int i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x80) ? (uint8_t) ((crc << 1) ^ 0x07) : (uint8_t) (crc << 1);
+        }
+    }
+    return crc;
+}
+
+void put_varint(std::vector<uint8_t> &out, uint64_t value)
+{
+    do
+    {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        out.push_back(value ? (byte | 0x80) : byte);
+    } while (value);
+}
+
+// Protobuf reader for the few things the chip needs to know about a message
+struct WireReader
+{
+    const uint8_t *p_data;
+    const uint8_t *p_end;
+
+    bool read_varint(uint64_t &value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64 && p_data < p_end; shift += 7)
+        {
+            uint8_t byte = *p_data++;
+            value |= (uint64_t) (byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Reads the next field, varints go to value, length delimited fields to the inner reader
+    bool read_field(uint32_t &field, uint64_t &value, WireReader &inner)
+    {
+        uint64_t key;
+        if (!read_varint(key))
+        {
+            return false;
+        }
+        field = (uint32_t) (key >> 3);
+        switch (key & 0x07)
+        {
+            case 0:
+                return read_varint(value);
+            case 2:
+                if (!read_varint(value) || value > (uint64_t) (p_end - p_data))
+                {
+                    return false;
+                }
+                inner = {p_data, p_data + value};
+                p_data += value;
+                return true;
+            default:
+                return false;
+        }
+    }
+};
+
+} // namespace
+
+ChipSim::ChipSim(const ChipConfig &config) : m_config(config), m_rng(config.seed)
+{
+    p_active_chip = this;
+}
+
+ChipSim::~ChipSim()
+{
+    if (p_active_chip == this)
+    {
+        p_active_chip = nullptr;
+    }
+}
+
+int ChipSim::write_buffer(const uint8_t *p_data, uint8_t length, uint32_t)
+{
+    // The UART transmits blocking, the MCU is done once the last byte is out
+    p_active_chip->m_now_us += length * BYTE_US;
+    p_active_chip->receive(p_data, length);
+    return 0;
+}
+
+int ChipSim::read_buffer(uint8_t *p_data, uint8_t, uint32_t)
+{
+    ChipSim &chip = *p_active_chip;
+    chip.service(chip.m_now_us);
+    if (chip.m_to_mcu.empty() || chip.m_to_mcu.front().first > chip.m_now_us)
+    {
+        return -1;
+    }
+    *p_data = chip.m_to_mcu.front().second;
+    chip.m_to_mcu.pop_front();
+    return 0;
+}
+
+uint32_t ChipSim::get_tick_ms(void)
+{
+    return (uint32_t) (p_active_chip->m_now_us / 1000);
+}
+
+void ChipSim::task_yield(void)
+{
+    p_active_chip->m_now_us += p_active_chip->m_config.yield_us;
+}
+
+void ChipSim::advance_us(uint64_t us)
+{
+    m_now_us += us;
+    service(m_now_us);
+}
+
+void ChipSim::set_response_body(uint32_t request_tag, const std::vector<uint8_t> &body)
+{
+    m_response_bodies[request_tag] = body;
+}
+
+void ChipSim::emit_event(const std::vector<uint8_t> &event, uint64_t at_us)
+{
+    m_outbox.emplace(at_us, bytes_field(FIELD_EVENT, event));
+}
+
+bool ChipSim::is_idle() const
+{
+    return m_outbox.empty() && !m_in_flight.active && m_to_mcu.empty();
+}
+
+size_t ChipSim::rx_available() const
+{
+    size_t available = 0;
+    for (auto it = m_to_mcu.begin(); (it != m_to_mcu.end()) && (it->first <= m_now_us); ++it)
+    {
+        available++;
+    }
+    return available;
+}
+
+std::vector<uint8_t> ChipSim::rx_interrupts()
+{
+    service(m_now_us);
+    std::vector<uint8_t> bytes;
+    while (!m_rx_interrupts.empty() && (m_rx_interrupts.front().first <= m_now_us))
+    {
+        bytes.push_back(m_rx_interrupts.front().second);
+        m_rx_interrupts.pop_front();
+    }
+    return bytes;
+}
+
+std::vector<uint8_t> ChipSim::varint_field(uint32_t field, uint64_t value)
+{
+    std::vector<uint8_t> out;
+    put_varint(out, (uint64_t) field << 3);
+    put_varint(out, value);
+    return out;
+}
+
+std::vector<uint8_t> ChipSim::bytes_field(uint32_t field, const std::vector<uint8_t> &bytes)
+{
+    std::vector<uint8_t> out;
+    put_varint(out, ((uint64_t) field << 3) | 2);
+    put_varint(out, bytes.size());
+    out.insert(out.end(), bytes.begin(), bytes.end());
+    return out;
+}
+
+// Runs whatever the chip would have done on its own up to the given time, in order
+void ChipSim::service(uint64_t until_us)
+{
+    for (;;)
+    {
+        if (m_in_flight.active)
+        {
+            uint64_t timeout_us = m_in_flight.sent_us + m_config.ack_timeout_us;
+            if (timeout_us > until_us)
+            {
+                return;
+            }
+            send_in_flight(timeout_us);
+        }
+        else if (!m_outbox.empty() && (m_outbox.begin()->first <= until_us))
+        {
+            m_in_flight = {true, std::move(m_outbox.begin()->second), m_next_transaction_id++, 0, 0};
+            uint64_t due_us = m_outbox.begin()->first;
+            m_outbox.erase(m_outbox.begin());
+            m_in_flight.sent_us = transmit(PACKET_TYPE_PB, 0, m_in_flight.transaction_id, m_in_flight.payload, due_us);
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+// Sends the frame waiting for its ACK again, or gives up on it
+void ChipSim::send_in_flight(uint64_t at_us)
+{
+    if (m_in_flight.retries >= m_config.max_retries)
+    {
+        m_stats.lost++;
+        m_in_flight.active = false;
+        return;
+    }
+    m_in_flight.retries++;
+    m_stats.retransmissions++;
+    m_in_flight.sent_us = transmit(PACKET_TYPE_PB, 0, m_in_flight.transaction_id, m_in_flight.payload, at_us);
+}
+
+void ChipSim::receive(const uint8_t *p_data, size_t length)
+{
+    service(m_now_us);
+
+    std::vector<uint8_t> frame;
+    for (size_t i = 1; i + 1 < length; i++)
+    {
+        frame.push_back((p_data[i] == HDLC_ESCAPE_CHARACTER) ? (p_data[++i] ^ HDLC_ESCAPE_MASK) : p_data[i]);
+    }
+
+    m_stats.frames_from_mcu++;
+    if ((frame.size() > 1) && ((frame[1] & 0x07) == PACKET_TYPE_PB))
+    {
+        m_stats.messages_from_mcu++;
+    }
+
+    if (m_now_us < m_config.boot_us)
+    {
+        m_stats.ignored++;
+        return;
+    }
+
+    if (chance(m_config.drop_rate))
+    {
+        m_stats.dropped++;
+        return;
+    }
+
+    if (!frame.empty() && (m_corrupt_next_frame || chance(m_config.crc_error_rate)))
+    {
+        m_corrupt_next_frame = false;
+        m_stats.corrupted++;
+        frame[m_rng() % frame.size()] ^= 1u << (m_rng() % 8);
+    }
+
+    size_t payload_length = (frame.size() >= HEADER_SIZE) ? (frame[3] | (frame[4] << 8)) : 0;
+    if ((frame.size() < HEADER_SIZE) || (crc8(frame.data(), HEADER_SIZE - 1) != frame[7]) ||
+        (frame[0] != START_MAGIC_BYTE) || (frame.size() != HEADER_SIZE + payload_length) ||
+        (crc8(frame.data() + HEADER_SIZE, payload_length) != frame[5]))
+    {
+        m_stats.nacks_to_mcu++;
+        transmit(PACKET_TYPE_ACK, NACK_BAD_CRC, 0, {}, m_now_us + m_config.ack_delay_us);
+        return;
+    }
+
+    uint8_t packet_type    = frame[1] & 0x07;
+    uint8_t value          = frame[1] >> 3;
+    uint8_t transaction_id = frame[2];
+
+    if (packet_type == PACKET_TYPE_ACK)
+    {
+        if (value != 0)
+        {
+            m_stats.nacks_from_mcu++;
+            if (m_in_flight.active)
+            {
+                send_in_flight(m_now_us);
+            }
+        }
+        else
+        {
+            m_stats.acks_from_mcu++;
+            if (m_in_flight.active && (m_in_flight.transaction_id == transaction_id))
+            {
+                m_in_flight.active = false;
+                service(m_now_us);
+            }
+        }
+        return;
+    }
+
+    transmit(PACKET_TYPE_ACK, 0, transaction_id, {}, m_now_us + m_config.ack_delay_us);
+    handle_payload(std::vector<uint8_t>(frame.begin() + HEADER_SIZE, frame.end()));
+}
+
+void ChipSim::handle_payload(const std::vector<uint8_t> &payload)
+{
+    WireReader outer = {payload.data(), payload.data() + payload.size()};
+    WireReader inner = {};
+    uint32_t   payload_tag;
+    uint64_t   length;
+    if (!outer.read_field(payload_tag, length, inner))
+    {
+        return;
+    }
+
+    McuMessage message = {m_now_us, payload_tag, 0, 0, 0};
+    uint32_t   field;
+    uint64_t   value;
+    WireReader body = {};
+    while ((inner.p_data < inner.p_end) && inner.read_field(field, value, body))
+    {
+        if ((field == FIELD_SEQ) && (payload_tag != FIELD_EVENT))
+        {
+            message.seq = (uint32_t) value;
+            continue;
+        }
+        message.tag = field;
+        if (body.p_data == nullptr)
+        {
+            message.value = (uint32_t) value;
+        }
+        else
+        {
+            // Requests carry a message, the first varint in it is all the tests look at
+            WireReader unused = {};
+            uint32_t   inner_field;
+            if (body.read_field(inner_field, value, unused))
+            {
+                message.value = (uint32_t) value;
+            }
+        }
+        body = {};
+    }
+    m_received.push_back(message);
+
+    if (payload_tag == FIELD_EVENT)
+    {
+        m_stats.events_from_mcu++;
+        return;
+    }
+    if (payload_tag != FIELD_REQUEST)
+    {
+        return;
+    }
+
+    int64_t request_key = ((int64_t) message.tag << 8) | (message.seq & 0xFF);
+    if (request_key == m_last_request_key)
+    {
+        m_stats.repeated_requests++;
+    }
+    m_last_request_key = request_key;
+
+    uint64_t answer_from_us = m_now_us;
+    if (m_now_us < m_config.requests_from_us)
+    {
+        if (m_config.ignore_early_requests)
+        {
+            m_stats.ignored++;
+            return;
+        }
+        answer_from_us = m_config.requests_from_us;
+    }
+    m_stats.requests++;
+
+    std::vector<uint8_t> response;
+    if (message.seq != 0)
+    {
+        response = varint_field(FIELD_SEQ, message.seq);
+    }
+    std::vector<uint8_t> result = bytes_field(message.tag, m_response_bodies[message.tag]);
+    response.insert(response.end(), result.begin(), result.end());
+
+    uint64_t delay_us = m_config.response_delay_us;
+    if (m_config.response_jitter_us > 0)
+    {
+        delay_us += m_rng() % (m_config.response_jitter_us + 1);
+    }
+    m_outbox.emplace(answer_from_us + delay_us, bytes_field(FIELD_RESPONSE, response));
+}
+
+// Puts a frame on the wire once it is free, returns when its last byte has been sent
+uint64_t ChipSim::transmit(uint8_t packet_type, uint8_t value, uint8_t transaction_id,
+                           const std::vector<uint8_t> &payload, uint64_t at_us)
+{
+    std::vector<uint8_t> frame = {START_MAGIC_BYTE,
+                                  (uint8_t) ((value << 3) | packet_type),
+                                  transaction_id,
+                                  (uint8_t) (payload.size() & 0xFF),
+                                  (uint8_t) (payload.size() >> 8),
+                                  crc8(payload.data(), payload.size()),
+                                  0x00};
+    frame.push_back(crc8(frame.data(), frame.size()));
+    frame.insert(frame.end(), payload.begin(), payload.end());
+
+    if (chance(m_config.drop_rate))
+    {
+        m_stats.dropped++;
+        return at_us;
+    }
+    if (chance(m_config.crc_error_rate))
+    {
+        m_stats.corrupted++;
+        frame[m_rng() % frame.size()] ^= 1u << (m_rng() % 8);
+    }
+
+    uint64_t byte_us = std::max(at_us, m_line_free_us);
+    size_t   queued  = m_to_mcu.size();
+    m_to_mcu.emplace_back(byte_us += BYTE_US, HDLC_FRAME_DELIMITER);
+    for (uint8_t byte : frame)
+    {
+        if ((byte == HDLC_FRAME_DELIMITER) || (byte == HDLC_ESCAPE_CHARACTER))
+        {
+            m_to_mcu.emplace_back(byte_us += BYTE_US, HDLC_ESCAPE_CHARACTER);
+            byte ^= HDLC_ESCAPE_MASK;
+        }
+        m_to_mcu.emplace_back(byte_us += BYTE_US, byte);
+    }
+    m_to_mcu.emplace_back(byte_us += BYTE_US, HDLC_FRAME_DELIMITER);
+    m_rx_interrupts.insert(m_rx_interrupts.end(), m_to_mcu.begin() + queued, m_to_mcu.end());
+
+    m_line_free_us = byte_us;
+    m_stats.frames_to_mcu++;
+    return byte_us;
+}
+
+bool ChipSim::chance(double rate)
+{
+    return (rate > 0.0) && (std::uniform_real_distribution<double>(0.0, 1.0)(m_rng) < rate);
+}
+
+actionslink_config_t make_config(uint16_t notification_window_ms)
+{
+    return {
+        .write_buffer_fn        = ChipSim::write_buffer,
+        .read_buffer_fn         = ChipSim::read_buffer,
+        .get_tick_ms_fn         = ChipSim::get_tick_ms,
+        .msp_init_fn            = nullptr,
+        .msp_deinit_fn          = nullptr,
+        .task_yield_fn          = ChipSim::task_yield,
+        .log_fn                 = nullptr,
+        .p_rx_buffer            = rx_buffer,
+        .p_tx_buffer            = tx_buffer,
+        .rx_buffer_size         = sizeof(rx_buffer),
+        .tx_buffer_size         = sizeof(tx_buffer),
+        .notification_window_ms = notification_window_ms,
+    };
+}
+
+bool start(ChipSim &chip, const actionslink_config_t *p_config, const actionslink_event_handlers_t *p_event_handlers,
+           const actionslink_request_handlers_t *p_request_handlers)
+{
+    if (actionslink_init(p_config, p_event_handlers, p_request_handlers) != 0)
+    {
+        return false;
+    }
+
+    uint64_t settle_until_us = chip.now_us() + SETTLE_US;
+    chip.emit_event(ChipSim::bytes_field(ActionsLink_ToMcuEvent_notify_system_ready_tag, {}), chip.now_us());
+    while (!actionslink_is_ready() && (chip.now_us() < settle_until_us))
+    {
+        chip.advance_us(IDLE_US);
+        actionslink_tick();
+    }
+    return actionslink_is_ready();
+}
+
+} // namespace actionslink_sim
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "actionslink.h"
+
+// Simulated Actions Bluetooth chip for host tests. It sits on the other end of the UART callbacks of
+// actionslink_config_t: it takes the HDLC frames written by the MCU, ACKs them, answers requests and sends
+// events back, with configurable turnaround times and injected CRC errors and frame drops. Time is simulated:
+// writing to the UART and yielding the task advance the clock, so results don't depend on the host.
+//
+// The chip encodes and parses the protobuf wire format on its own, it doesn't share any code with the library.
+
+namespace actionslink_sim
+{
+
+constexpr uint32_t BYTE_US = 87; // 10 bits at 115200 baud
+
+struct ChipConfig
+{
+    uint32_t ack_delay_us       = 500;    // Frame received until the chip starts sending the ACK
+    uint32_t response_delay_us  = 3000;   // Request received until the chip starts sending the response
+    uint32_t response_jitter_us = 0;      // Random extra response delay, up to this much
+    uint32_t ack_timeout_us     = 300000; // Chip waiting for the ACK of a frame before sending it again
+    uint8_t  max_retries        = 2;      // Times the chip sends a frame again before giving up on it
+    uint32_t yield_us           = 2000;   // task_yield_fn of the Bluetooth task
+    double   crc_error_rate     = 0.0;    // Share of frames, in either direction, with a flipped bit
+    double   drop_rate          = 0.0;    // Share of frames, in either direction, lost entirely
+    uint32_t seed               = 1;
+
+    // Boot after power on, the chip is powered when it's created
+    uint64_t boot_us               = 0;     // The chip ignores everything from the MCU until then
+    uint64_t requests_from_us      = 0;     // Requests received earlier are answered from then on
+    bool     ignore_early_requests = false; // Requests received earlier aren't answered at all
+};
+
+struct ChipStats
+{
+    uint32_t frames_from_mcu;   // Frames written by the MCU, including broken ones
+    uint32_t messages_from_mcu; // Protobuf frames written by the MCU, including the ones it sent again
+    uint32_t frames_to_mcu;     // Frames put on the wire by the chip, including ACKs and broken ones
+    uint32_t requests;          // Requests answered, repeated ones included
+    uint32_t repeated_requests; // Requests the MCU sent again with the same sequence number
+    uint32_t events_from_mcu;
+    uint32_t acks_from_mcu;
+    uint32_t nacks_from_mcu;
+    uint32_t nacks_to_mcu;      // Frames from the MCU that failed validation
+    uint32_t retransmissions;   // Frames the chip sent again after a NACK or a missing ACK
+    uint32_t lost;              // Frames the chip gave up on
+    uint32_t corrupted;         // Frames given a CRC error on purpose
+    uint32_t dropped;           // Frames dropped on purpose
+    uint32_t ignored;           // Frames and requests from the MCU ignored while booting
+};
+
+struct McuMessage
+{
+    uint64_t at_us;
+    uint32_t payload_tag; // ActionsLink_FromMcu_*_tag
+    uint32_t tag;         // Tag of the request, response or event
+    uint32_t seq;
+    uint32_t value;       // First varint field of the request, or the value of the event
+};
+
+class ChipSim
+{
+  public:
+    explicit ChipSim(const ChipConfig &config);
+    ~ChipSim();
+
+    // Callbacks for actionslink_config_t, they forward to the most recently created chip
+    static int      write_buffer(const uint8_t *p_data, uint8_t length, uint32_t timeout);
+    static int      read_buffer(uint8_t *p_data, uint8_t length, uint32_t timeout);
+    static uint32_t get_tick_ms(void);
+    static void     task_yield(void);
+
+    uint64_t now_us() const { return m_now_us; }
+    void     advance_us(uint64_t us);
+
+    // Body of the response to a request, the default empty body decodes as Common.Command or a successful
+    // Common.Result
+    void set_response_body(uint32_t request_tag, const std::vector<uint8_t> &body);
+
+    // Sends an event, the encoded fields of a ToMcuEvent, once the wire and the chip are free but not before at_us
+    void emit_event(const std::vector<uint8_t> &event, uint64_t at_us);
+
+    bool is_idle() const;
+
+    // Gives the next frame written by the MCU a CRC error, the chip NACKs it
+    void corrupt_next_frame_from_mcu() { m_corrupt_next_frame = true; }
+
+    // UART receive side as the MCU sees it: the bytes waiting to be read, and the bytes received since the last call,
+    // one RX interrupt each
+    size_t               rx_available() const;
+    std::vector<uint8_t> rx_interrupts();
+
+    const ChipStats               &stats() const { return m_stats; }
+    const std::vector<McuMessage> &received() const { return m_received; }
+
+    // Protobuf wire format helpers to build bodies with
+    static std::vector<uint8_t> varint_field(uint32_t field, uint64_t value);
+    static std::vector<uint8_t> bytes_field(uint32_t field, const std::vector<uint8_t> &bytes);
+
+  private:
+    // The chip sends one protobuf frame at a time and waits for its ACK before the next one
+    struct InFlight
+    {
+        bool                 active;
+        std::vector<uint8_t> payload;
+        uint8_t              transaction_id;
+        uint64_t             sent_us;
+        uint8_t              retries;
+    };
+
+    void     service(uint64_t until_us);
+    void     receive(const uint8_t *p_data, size_t length);
+    void     handle_payload(const std::vector<uint8_t> &payload);
+    void     send_in_flight(uint64_t at_us);
+    uint64_t transmit(uint8_t packet_type, uint8_t value, uint8_t transaction_id, const std::vector<uint8_t> &payload,
+                      uint64_t at_us);
+    bool     chance(double rate);
+
+    ChipConfig                                    m_config;
+    ChipStats                                     m_stats = {};
+    std::mt19937                                  m_rng;
+    uint64_t                                      m_now_us       = 0;
+    uint64_t                                      m_line_free_us = 0;
+    std::deque<std::pair<uint64_t, uint8_t>>      m_to_mcu; // Bytes with the time they are available at
+    std::deque<std::pair<uint64_t, uint8_t>>      m_rx_interrupts; // Bytes on the wire not taken by rx_interrupts()
+    std::multimap<uint64_t, std::vector<uint8_t>> m_outbox; // Protobuf payloads waiting to be sent, by due time
+    InFlight                                      m_in_flight = {};
+    std::map<uint32_t, std::vector<uint8_t>>      m_response_bodies;
+    std::vector<McuMessage>                       m_received;
+    uint8_t                                       m_next_transaction_id = 0;
+    int64_t                                       m_last_request_key    = -1;
+    bool                                          m_corrupt_next_frame  = false;
+};
+
+constexpr uint64_t IDLE_US   = 10000;   // Bluetooth task calling actionslink_tick() when it has nothing to do
+constexpr uint64_t SETTLE_US = 1000000; // Enough for the chip to send its ready event three times
+
+// Configuration of the library on the UART callbacks of the chip, with buffers the size of the Bluetooth task's. The
+// buffers are shared, a test runs one library instance at a time.
+actionslink_config_t make_config(uint16_t notification_window_ms = 0);
+
+// Initializes the library, has the chip report that it's ready and ticks like the idle Bluetooth task until the
+// library is ready too. False if it isn't within SETTLE_US.
+bool start(ChipSim &chip, const actionslink_config_t *p_config, const actionslink_event_handlers_t *p_event_handlers,
+           const actionslink_request_handlers_t *p_request_handlers);
+
+// Value at the share p of the sorted values, 0.5 for the median
+template <typename T>
+T percentile(const std::vector<T> &sorted, double p)
+{
+    return sorted[(size_t) (p * (sorted.size() - 1))];
+}
+
+} // namespace actionslink_sim
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "actionslink.h"
+#include "actionslink_chip_sim.h"
+#include "message.pb.h"
+
+// Power on of the Actions chip against the simulated chip with random boot times: its UART comes up, it reports a
+// power state, then it's ready and a little later it takes requests. The bring up waits for these signals, the
+// previous sequence waited for the ready event and then a fixed 200 ms before requesting power on.
+
+namespace
+{
+
+using actionslink_sim::ChipConfig;
+using actionslink_sim::ChipSim;
+using actionslink_sim::make_config;
+
+constexpr uint32_t BOOTS          = 200;
+constexpr uint64_t POLL_US        = 10000;   // Startup::wait_for() period of the Bluetooth task
+constexpr uint64_t LEGACY_WAIT_US = 200000;  // Ready until power on, before the bring up
+constexpr uint64_t GIVE_UP_US     = 5000000; // Any sequence is done by then
+
+// Same as the Bluetooth task
+const actionslink_bringup_config_t bringup_config = {
+    .step_timeout_ms    = {1800, 400, 800},
+    .probe_delay_ms     = 10,
+    .max_probe_delay_ms = 160,
+};
+
+const actionslink_event_handlers_t   event_handlers   = {};
+const actionslink_request_handlers_t request_handlers = {};
+
+const actionslink_config_t config = make_config();
+
+struct Boot
+{
+    uint64_t uart_up_us;   // First frame, a power state event
+    uint64_t ready_us;     // System ready event
+    uint64_t responding_us;
+    bool     ignore_early_requests;
+};
+
+struct Outcome
+{
+    bool                        powered_on;
+    uint64_t                    power_on_us; // Power on request confirmed
+    actionslink_bringup_state_t state;
+    actionslink_bringup_stats_t stats;
+};
+
+ChipConfig chip_config(const Boot &boot)
+{
+    ChipConfig chip_config            = {};
+    chip_config.boot_us               = boot.uart_up_us;
+    chip_config.requests_from_us      = boot.responding_us;
+    chip_config.ignore_early_requests = boot.ignore_early_requests;
+    return chip_config;
+}
+
+void emit_boot_events(ChipSim &chip, const Boot &boot)
+{
+    if (boot.uart_up_us < GIVE_UP_US)
+    {
+        auto standby = ChipSim::varint_field(1, ActionsLink_System_PowerState_SystemPowerMode_STANDBY);
+        chip.emit_event(ChipSim::bytes_field(ActionsLink_ToMcuEvent_notify_power_state_tag, standby), boot.uart_up_us);
+    }
+    if (boot.ready_us < GIVE_UP_US)
+    {
+        chip.emit_event(ChipSim::bytes_field(ActionsLink_ToMcuEvent_notify_system_ready_tag, {}), boot.ready_us);
+    }
+}
+
+Outcome power_on(ChipSim &chip)
+{
+    Outcome outcome     = {};
+    outcome.powered_on  = actionslink_set_power_state(ACTIONSLINK_POWER_STATE_ON) == 0;
+    outcome.power_on_us = chip.now_us();
+    return outcome;
+}
+
+Outcome run_bringup(const Boot &boot)
+{
+    ChipSim chip(chip_config(boot));
+    emit_boot_events(chip, boot);
+    EXPECT_EQ(actionslink_init(&config, &event_handlers, &request_handlers), 0);
+
+    uint8_t                        build[16] = {};
+    actionslink_buffer_dsc_t       build_dsc = {build, sizeof(build)};
+    actionslink_firmware_version_t version   = {0, 0, 0, &build_dsc};
+    EXPECT_EQ(actionslink_start_bringup(&bringup_config, &version), 0);
+
+    actionslink_bringup_state_t state;
+    while ((state = actionslink_process_bringup()) == ACTIONSLINK_BRINGUP_STATE_WAITING)
+    {
+        chip.advance_us(POLL_US);
+    }
+
+    Outcome outcome = {};
+    if (state == ACTIONSLINK_BRINGUP_STATE_READY)
+    {
+        outcome = power_on(chip);
+    }
+    outcome.state = state;
+    actionslink_get_bringup_stats(&outcome.stats);
+    return outcome;
+}
+
+// The sequence before the bring up
+Outcome run_legacy(const Boot &boot)
+{
+    ChipSim chip(chip_config(boot));
+    emit_boot_events(chip, boot);
+    EXPECT_EQ(actionslink_init(&config, &event_handlers, &request_handlers), 0);
+
+    for (;;)
+    {
+        actionslink_tick();
+        if (actionslink_is_ready() || (chip.now_us() >= GIVE_UP_US))
+        {
+            break;
+        }
+        chip.advance_us(POLL_US);
+    }
+    if (!actionslink_is_ready())
+    {
+        return {};
+    }
+
+    uint64_t                       ready_us  = chip.now_us();
+    uint8_t                        build[16] = {};
+    actionslink_buffer_dsc_t       build_dsc = {build, sizeof(build)};
+    actionslink_firmware_version_t version   = {0, 0, 0, &build_dsc};
+    actionslink_get_firmware_version(&version);
+
+    if (chip.now_us() < ready_us + LEGACY_WAIT_US)
+    {
+        chip.advance_us(ready_us + LEGACY_WAIT_US - chip.now_us());
+    }
+    return power_on(chip);
+}
+
+std::vector<Boot> random_boots(uint32_t seed, uint64_t max_settle_us, bool ignore_early_requests)
+{
+    std::mt19937                            rng(seed);
+    std::uniform_int_distribution<uint64_t> uart_up(300000, 1400000);
+    std::uniform_int_distribution<uint64_t> ready(20000, 300000);
+    std::uniform_int_distribution<uint64_t> settle(0, max_settle_us);
+
+    std::vector<Boot> boots(BOOTS);
+    for (Boot &boot : boots)
+    {
+        boot.uart_up_us            = uart_up(rng);
+        boot.ready_us              = boot.uart_up_us + ready(rng);
+        boot.responding_us         = boot.ready_us + settle(rng);
+        boot.ignore_early_requests = ignore_early_requests;
+    }
+    return boots;
+}
+
+uint64_t median(std::vector<uint64_t> values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+TEST(ActionslinkBringup, SavesTimeOnEveryBoot)
+{
+    // The chip takes requests up to 150 ms after it's ready, answering any earlier ones late
+    std::vector<uint64_t> bringup_us, legacy_us, saved_us;
+    uint32_t              failed = 0;
+    for (const Boot &boot : random_boots(49, 150000, false))
+    {
+        Outcome bringup = run_bringup(boot);
+        Outcome legacy  = run_legacy(boot);
+        ASSERT_TRUE(legacy.powered_on);
+        if (!bringup.powered_on)
+        {
+            failed++;
+            continue;
+        }
+        EXPECT_EQ(bringup.stats.probes, 1u);
+        bringup_us.push_back(bringup.power_on_us);
+        legacy_us.push_back(legacy.power_on_us);
+        saved_us.push_back(legacy.power_on_us - std::min(legacy.power_on_us, bringup.power_on_us));
+    }
+
+    printf("power on [ms] median %4.0f, before %4.0f, saved median %4.0f (min %4.0f, max %4.0f) over %u boots\r\n",
+           median(bringup_us) / 1e3, median(legacy_us) / 1e3, median(saved_us) / 1e3,
+           *std::min_element(saved_us.begin(), saved_us.end()) / 1e3,
+           *std::max_element(saved_us.begin(), saved_us.end()) / 1e3, BOOTS);
+
+    EXPECT_EQ(failed, 0u);
+    EXPECT_GT(median(saved_us), 40000u);
+}
+
+TEST(ActionslinkBringup, ProbesUntilTheChipAnswers)
+{
+    // Requests before the chip takes them get lost, for up to 400 ms after it's ready. The bring up is only done
+    // once a probe got through, the power on request before relied on its retransmission for this.
+    uint32_t bringup_failed = 0, legacy_failed = 0, max_probes = 0;
+    for (const Boot &boot : random_boots(50, 400000, true))
+    {
+        Outcome bringup = run_bringup(boot);
+        Outcome legacy  = run_legacy(boot);
+        bringup_failed += bringup.powered_on ? 0 : 1;
+        legacy_failed += legacy.powered_on ? 0 : 1;
+        max_probes = std::max<uint32_t>(max_probes, bringup.stats.probes);
+    }
+
+    printf("power on failed %u/%u, before %u/%u, at most %u probes\r\n", bringup_failed, BOOTS, legacy_failed,
+           BOOTS, max_probes);
+
+    EXPECT_EQ(bringup_failed, 0u);
+    EXPECT_GT(max_probes, 1u);
+}
+
+TEST(ActionslinkBringup, TimesOutInTheStepThatHangs)
+{
+    // Silent chip
+    Boot    boot    = {UINT64_MAX, UINT64_MAX, UINT64_MAX, false};
+    Outcome outcome = run_bringup(boot);
+    EXPECT_EQ(outcome.state, ACTIONSLINK_BRINGUP_STATE_TIMED_OUT);
+    EXPECT_EQ(outcome.stats.timeouts[ACTIONSLINK_BRINGUP_STEP_FIRST_FRAME], 1u);
+    EXPECT_GE(outcome.stats.step_ms[ACTIONSLINK_BRINGUP_STEP_FIRST_FRAME], 1800u);
+    EXPECT_LT(outcome.stats.total_ms, 1800u + POLL_US / 1000);
+
+    // UART up, but never ready
+    boot    = {500000, UINT64_MAX, UINT64_MAX, false};
+    outcome = run_bringup(boot);
+    EXPECT_EQ(outcome.state, ACTIONSLINK_BRINGUP_STATE_TIMED_OUT);
+    EXPECT_EQ(outcome.stats.timeouts[ACTIONSLINK_BRINGUP_STEP_SYSTEM_READY], 1u);
+    EXPECT_LT(outcome.stats.total_ms, 500u + 400u + 2 * POLL_US / 1000);
+
+    // Ready, but never answering
+    boot    = {500000, 600000, UINT64_MAX, true};
+    outcome = run_bringup(boot);
+    EXPECT_EQ(outcome.state, ACTIONSLINK_BRINGUP_STATE_TIMED_OUT);
+    EXPECT_EQ(outcome.stats.timeouts[ACTIONSLINK_BRINGUP_STEP_RESPONDING], 1u);
+    EXPECT_GT(outcome.stats.probes, 1u);
+    EXPECT_LT(outcome.stats.total_ms, 600u + 800u + 2 * 300u * 2);
+}
+
+} // namespace
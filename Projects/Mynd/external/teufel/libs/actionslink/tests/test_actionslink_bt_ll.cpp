@@ -0,0 +1,470 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// The internal headers of the library have no C++ guards of their own
+extern "C"
+{
+#include "actionslink_bt_ll.h"
+#include "actionslink_utils.h"
+#include "pb_encode.h"
+}
+
+// The low layer escapes and unescapes the frames and takes their CRCs in the same pass. These tests hold it against
+// a plain reference of the frame format, with every byte value in every position that matters: the header, the last
+// header byte before the payload and the last payload byte before the closing delimiter.
+
+namespace
+{
+
+constexpr uint16_t BUFFER_SIZE       = 160;
+constexpr uint8_t  FLAG              = 0x7E;
+constexpr uint8_t  ESCAPE            = 0x7D;
+constexpr uint8_t  TYPE_ACK          = ACTIONSLINK_BT_LL_PACKET_TYPE_ACK;
+constexpr uint8_t  TYPE_PROTOBUF     = ACTIONSLINK_BT_LL_PACKET_TYPE_PROTOBUF;
+constexpr uint8_t  NACK_INVALID_SIZE = 3;
+
+uint8_t                           tx_buffer[BUFFER_SIZE];
+uint8_t                           rx_buffer[BUFFER_SIZE];
+std::vector<std::vector<uint8_t>> written;
+std::vector<uint8_t>              line;
+size_t                            line_position;
+
+int capture_write(const uint8_t *p_data, uint8_t length, uint32_t)
+{
+    written.emplace_back(p_data, p_data + length);
+    return 0;
+}
+
+int discard_write(const uint8_t *, uint8_t, uint32_t)
+{
+    return 0;
+}
+
+int read_line(uint8_t *p_data, uint8_t, uint32_t)
+{
+    if (line_position >= line.size())
+    {
+        return -1;
+    }
+    *p_data = line[line_position++];
+    return 0;
+}
+
+uint32_t get_tick_ms()
+{
+    return 0;
+}
+
+actionslink_config_t config = {
+    .write_buffer_fn = capture_write,
+    .read_buffer_fn  = read_line,
+    .get_tick_ms_fn  = get_tick_ms,
+    .msp_init_fn     = nullptr,
+    .msp_deinit_fn   = nullptr,
+    .task_yield_fn   = nullptr,
+    .log_fn          = nullptr,
+    .p_rx_buffer     = rx_buffer,
+    .p_tx_buffer     = tx_buffer,
+    .rx_buffer_size  = BUFFER_SIZE,
+    .tx_buffer_size  = BUFFER_SIZE,
+};
+
+// CRC-8 with polynomial 0x07, bit by bit rather than through a table
+uint8_t reference_crc8(const uint8_t *p_data, size_t length)
+{
+    uint8_t crc = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= p_data[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80) ? (uint8_t) ((crc << 1) ^ 0x07) : (uint8_t) (crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Header and payload before escaping
+std::vector<uint8_t> reference_packet(uint8_t type, uint8_t value, uint8_t transaction_id,
+                                      const std::vector<uint8_t> &payload)
+{
+    std::vector<uint8_t> packet = {0x55,
+                                   (uint8_t) ((value << 3) | type),
+                                   transaction_id,
+                                   (uint8_t) (payload.size() & 0xFF),
+                                   (uint8_t) (payload.size() >> 8),
+                                   reference_crc8(payload.data(), payload.size()),
+                                   0x00};
+    packet.push_back(reference_crc8(packet.data(), packet.size()));
+    packet.insert(packet.end(), payload.begin(), payload.end());
+    return packet;
+}
+
+std::vector<uint8_t> escape(const std::vector<uint8_t> &packet)
+{
+    std::vector<uint8_t> frame = {FLAG};
+    for (uint8_t byte : packet)
+    {
+        if ((byte == FLAG) || (byte == ESCAPE))
+        {
+            frame.push_back(ESCAPE);
+            frame.push_back(byte ^ 0x20);
+        }
+        else
+        {
+            frame.push_back(byte);
+        }
+    }
+    frame.push_back(FLAG);
+    return frame;
+}
+
+std::vector<uint8_t> reference_frame(uint8_t type, uint8_t value, uint8_t transaction_id,
+                                     const std::vector<uint8_t> &payload)
+{
+    return escape(reference_packet(type, value, transaction_id, payload));
+}
+
+// A ToMcu message made of a single unknown length-delimited field, which the decoder skips, so that the payload can
+// carry any bytes
+std::vector<uint8_t> protobuf_payload(const std::vector<uint8_t> &bytes)
+{
+    std::vector<uint8_t> payload = {(15 << 3) | 2};
+    for (size_t length = bytes.size(); true; length >>= 7)
+    {
+        payload.push_back((length >= 0x80) ? (uint8_t) (0x80 | (length & 0x7F)) : (uint8_t) length);
+        if (length < 0x80)
+        {
+            break;
+        }
+    }
+    payload.insert(payload.end(), bytes.begin(), bytes.end());
+    return payload;
+}
+
+actionslink_bt_ll_tx_packet_t encoded_packet(uint8_t type, uint8_t value, uint8_t transaction_id,
+                                             const std::vector<uint8_t> &payload)
+{
+    return {(actionslink_bt_ll_packet_type_t) type, value, transaction_id, nullptr, payload.data(),
+            (uint16_t) payload.size()};
+}
+
+std::vector<uint8_t> transmit(const actionslink_bt_ll_tx_packet_t &packet)
+{
+    written.clear();
+    EXPECT_EQ(actionslink_bt_ll_tx(&packet), 0);
+    return written.empty() ? std::vector<uint8_t>() : written.front();
+}
+
+class ActionslinkBtLl : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        config.write_buffer_fn = capture_write;
+        config.tx_buffer_size  = BUFFER_SIZE;
+        config.rx_buffer_size  = BUFFER_SIZE;
+        actionslink_utils_init(&config);
+        actionslink_bt_ll_init(&config);
+        written.clear();
+        line.clear();
+        line_position = 0;
+    }
+
+    // Puts bytes on the line and receives the next packet from them
+    int receive(const std::vector<uint8_t> &bytes)
+    {
+        line.insert(line.end(), bytes.begin(), bytes.end());
+        return receive_next();
+    }
+
+    int receive_next()
+    {
+        message                  = ActionsLink_ToMcu_init_zero;
+        packet                   = {};
+        packet.payload.p_message = &message;
+        return actionslink_bt_ll_rx(&packet);
+    }
+
+    std::vector<uint8_t> received_payload() const
+    {
+        return std::vector<uint8_t>(packet.payload.p_raw_data,
+                                    packet.payload.p_raw_data + packet.payload.raw_data_length);
+    }
+
+    ActionsLink_ToMcu             message;
+    actionslink_bt_ll_rx_packet_t packet;
+};
+
+TEST_F(ActionslinkBtLl, TxEveryByteValue)
+{
+    for (uint32_t b = 0; b <= 0xFF; b++)
+    {
+        const uint8_t byte = (uint8_t) b;
+
+        // Ends with the byte, right before the closing delimiter
+        const std::vector<std::vector<uint8_t>> payloads = {{byte}, {byte, byte}, {0x00, byte}, {byte, 0x00}};
+        for (const auto &payload : payloads)
+        {
+            EXPECT_EQ(transmit(encoded_packet(TYPE_PROTOBUF, 0, byte, payload)),
+                      reference_frame(TYPE_PROTOBUF, 0, byte, payload))
+                << "byte 0x" << std::hex << b << ", " << std::dec << payload.size() << " bytes";
+        }
+
+        // ACKs end with the header CRC, which takes every value over the transaction IDs
+        const uint8_t value = byte & 0x1F;
+        EXPECT_EQ(transmit(encoded_packet(TYPE_ACK, value, byte, {})), reference_frame(TYPE_ACK, value, byte, {}))
+            << "transaction ID " << b;
+    }
+}
+
+TEST_F(ActionslinkBtLl, TxAllByteValuesInOnePayload)
+{
+    for (uint32_t first = 0; first <= 0x80; first += 0x80)
+    {
+        std::vector<uint8_t> payload;
+        for (uint32_t b = first; b < first + 0x80; b++)
+        {
+            payload.push_back((uint8_t) b);
+        }
+        payload.push_back(FLAG);
+
+        EXPECT_EQ(transmit(encoded_packet(TYPE_PROTOBUF, 0, FLAG, payload)),
+                  reference_frame(TYPE_PROTOBUF, 0, FLAG, payload));
+    }
+}
+
+TEST_F(ActionslinkBtLl, TxFillsTheBufferExactly)
+{
+    // Nothing but characters to escape, the frame is twice as long as the packet
+    const std::vector<uint8_t>          payload(20, FLAG);
+    const actionslink_bt_ll_tx_packet_t packet   = encoded_packet(TYPE_PROTOBUF, 0, ESCAPE, payload);
+    const auto                          expected = reference_frame(TYPE_PROTOBUF, 0, ESCAPE, payload);
+
+    config.tx_buffer_size = expected.size() - 1;
+    written.clear();
+    EXPECT_EQ(actionslink_bt_ll_tx(&packet), -1);
+    EXPECT_TRUE(written.empty());
+
+    config.tx_buffer_size = expected.size();
+    EXPECT_EQ(transmit(packet), expected);
+}
+
+TEST_F(ActionslinkBtLl, TxNanopbInPlace)
+{
+    // Sequence number and volume put characters to escape into the payload, which nanopb encodes into the end of the
+    // same buffer the frame is built in
+    ActionsLink_FromMcu message           = ActionsLink_FromMcu_init_zero;
+    message.which_Payload                 = ActionsLink_FromMcu_request_tag;
+    message.Payload.request.seq           = FLAG;
+    message.Payload.request.which_Request = ActionsLink_FromMcuRequest_set_absolute_avrcp_volume_tag;
+    message.Payload.request.Request.set_absolute_avrcp_volume.volume = ESCAPE;
+
+    uint8_t      encoded[BUFFER_SIZE];
+    pb_ostream_t stream = pb_ostream_from_buffer(encoded, sizeof(encoded));
+    ASSERT_TRUE(pb_encode(&stream, ActionsLink_FromMcu_fields, &message));
+    const std::vector<uint8_t> payload(encoded, encoded + stream.bytes_written);
+
+    const actionslink_bt_ll_tx_packet_t packet   = {ACTIONSLINK_BT_LL_PACKET_TYPE_PROTOBUF, 0, FLAG, &message, nullptr, 0};
+    const auto                          expected = reference_frame(TYPE_PROTOBUF, 0, FLAG, payload);
+
+    EXPECT_EQ(transmit(packet), expected);
+
+    // Without a byte to spare the frame ends up right where the payload was encoded
+    config.tx_buffer_size = expected.size();
+    EXPECT_EQ(transmit(packet), expected);
+
+    config.tx_buffer_size = expected.size() - 1;
+    written.clear();
+    EXPECT_EQ(actionslink_bt_ll_tx(&packet), -1);
+    EXPECT_TRUE(written.empty());
+}
+
+TEST_F(ActionslinkBtLl, RxEveryByteValue)
+{
+    for (uint32_t b = 0; b <= 0xFF; b++)
+    {
+        const uint8_t byte    = (uint8_t) b;
+        const auto    payload = protobuf_payload({byte, byte});
+
+        written.clear();
+        ASSERT_EQ(receive(reference_frame(TYPE_PROTOBUF, 0, byte, payload)), 1) << "byte 0x" << std::hex << b;
+        EXPECT_EQ(packet.packet_type, ACTIONSLINK_BT_LL_PACKET_TYPE_PROTOBUF);
+        EXPECT_EQ(packet.transaction_id, byte);
+        EXPECT_EQ(received_payload(), payload);
+
+        // Every protobuf packet is acknowledged with its transaction ID
+        ASSERT_EQ(written.size(), 1u);
+        EXPECT_EQ(written.front(), reference_frame(TYPE_ACK, 0, byte, {}));
+
+        const uint8_t value = byte & 0x1F;
+        ASSERT_EQ(receive(reference_frame(TYPE_ACK, value, byte, {})), 1) << "transaction ID " << b;
+        EXPECT_EQ(packet.packet_type, ACTIONSLINK_BT_LL_PACKET_TYPE_ACK);
+        EXPECT_EQ(packet.value, value);
+        EXPECT_EQ(packet.transaction_id, byte);
+        EXPECT_EQ(packet.payload.raw_data_length, 0u);
+    }
+}
+
+TEST_F(ActionslinkBtLl, RxAllByteValuesInOnePayload)
+{
+    for (uint32_t first = 0; first <= 0x80; first += 0x80)
+    {
+        std::vector<uint8_t> bytes;
+        for (uint32_t b = first; b < first + 0x80; b++)
+        {
+            bytes.push_back((uint8_t) b);
+        }
+        bytes.push_back(ESCAPE);
+        const auto payload = protobuf_payload(bytes);
+
+        ASSERT_EQ(receive(reference_frame(TYPE_PROTOBUF, 0, ESCAPE, payload)), 1);
+        EXPECT_EQ(received_payload(), payload);
+    }
+}
+
+TEST_F(ActionslinkBtLl, RxRoundTrip)
+{
+    for (uint32_t b = 0; b <= 0xFF; b++)
+    {
+        const auto payload = protobuf_payload({(uint8_t) b, FLAG, ESCAPE, (uint8_t) b});
+        const auto frame   = transmit(encoded_packet(TYPE_PROTOBUF, 0, (uint8_t) b, payload));
+
+        ASSERT_EQ(receive(frame), 1);
+        EXPECT_EQ(packet.transaction_id, b);
+        EXPECT_EQ(received_payload(), payload);
+    }
+}
+
+TEST_F(ActionslinkBtLl, RxRejectsEveryBitError)
+{
+    const auto payload = protobuf_payload({FLAG, ESCAPE, 0x00, 0xFF});
+    const auto packet  = reference_packet(TYPE_PROTOBUF, 0, FLAG, payload);
+
+    for (size_t bit = 0; bit < packet.size() * 8; bit++)
+    {
+        auto corrupted = packet;
+        corrupted[bit / 8] ^= (uint8_t) (1u << (bit % 8));
+
+        written.clear();
+        EXPECT_EQ(receive(escape(corrupted)), -1) << "bit " << bit;
+
+        // Answered with a NACK, never with an ACK
+        ASSERT_EQ(written.size(), 1u) << "bit " << bit;
+        EXPECT_NE(written.front()[2] >> 3, 0) << "bit " << bit;
+    }
+
+    // A good frame still gets through afterwards
+    EXPECT_EQ(receive(escape(packet)), 1);
+}
+
+TEST_F(ActionslinkBtLl, RxRejectsWrongPayloadLength)
+{
+    // The length in the header leaves out the last byte, the payload CRC matches that length
+    const auto payload = protobuf_payload({0x01, 0x02, 0x03});
+    auto       packet  = reference_packet(TYPE_PROTOBUF, 0, 1, std::vector<uint8_t>(payload.begin(), payload.end() - 1));
+    packet.push_back(payload.back());
+
+    written.clear();
+    EXPECT_EQ(receive(escape(packet)), -1);
+    ASSERT_EQ(written.size(), 1u);
+    EXPECT_EQ(written.front(), reference_frame(TYPE_ACK, NACK_INVALID_SIZE, 0, {}));
+}
+
+TEST_F(ActionslinkBtLl, RxEscapeBeforeClosingDelimiter)
+{
+    // An escape character with nothing left to escape is dropped with the delimiter
+    auto frame = reference_frame(TYPE_ACK, 0, 1, {});
+    frame.insert(frame.end() - 1, ESCAPE);
+
+    EXPECT_EQ(receive(frame), 1);
+    EXPECT_EQ(packet.transaction_id, 1);
+
+    // and doesn't carry over into the next frame
+    EXPECT_EQ(receive(reference_frame(TYPE_ACK, 0, 2, {})), 1);
+    EXPECT_EQ(packet.transaction_id, 2);
+}
+
+TEST_F(ActionslinkBtLl, RxBackToBackFrames)
+{
+    // Frames sharing nothing but delimiters, noise in front of them
+    std::vector<uint8_t> bytes = {0x11, 0x22};
+    for (uint8_t transaction_id : {FLAG, ESCAPE, (uint8_t) 0x00})
+    {
+        const auto frame = reference_frame(TYPE_PROTOBUF, 0, transaction_id, protobuf_payload({transaction_id}));
+        bytes.insert(bytes.end(), frame.begin(), frame.end());
+    }
+    line = bytes;
+
+    // The noise ends up as a frame too short to be one
+    EXPECT_EQ(receive_next(), -1);
+    for (uint8_t transaction_id : {FLAG, ESCAPE, (uint8_t) 0x00})
+    {
+        ASSERT_EQ(receive_next(), 1);
+        EXPECT_EQ(packet.transaction_id, transaction_id);
+    }
+    EXPECT_EQ(receive_next(), 0);
+}
+
+TEST_F(ActionslinkBtLl, Benchmark)
+{
+    constexpr uint32_t ITERATIONS = 200000;
+
+    // Typical request from the direct encoders, with a character to escape
+    const std::vector<uint8_t>          request = {0x0A, 0x08, 0x08, 0x7E, 0xA2, 0x01, 0x03, 0x08, 0x01, 0x10};
+    const actionslink_bt_ll_tx_packet_t encoded = encoded_packet(TYPE_PROTOBUF, 0, 1, request);
+
+    ActionsLink_FromMcu message           = ActionsLink_FromMcu_init_zero;
+    message.which_Payload                 = ActionsLink_FromMcu_request_tag;
+    message.Payload.request.seq           = FLAG;
+    message.Payload.request.which_Request = ActionsLink_FromMcuRequest_set_absolute_avrcp_volume_tag;
+    message.Payload.request.Request.set_absolute_avrcp_volume.volume = 50;
+    const actionslink_bt_ll_tx_packet_t nanopb = {ACTIONSLINK_BT_LL_PACKET_TYPE_PROTOBUF, 0, 1, &message, nullptr, 0};
+
+    // Response sized like a firmware version, which gets ACKed, and an ACK
+    const auto response = reference_frame(TYPE_PROTOBUF, 0, ESCAPE, protobuf_payload(std::vector<uint8_t>(32, 0x5A)));
+    const auto ack      = reference_frame(TYPE_ACK, 0, FLAG, {});
+
+    const size_t encoded_size = transmit(encoded).size();
+    const size_t nanopb_size  = transmit(nanopb).size();
+    config.write_buffer_fn    = discard_write;
+
+    auto measure = [](const char *name, size_t frame_size, auto &&fn)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < ITERATIONS; i++)
+        {
+            fn();
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                    ITERATIONS;
+        printf("%-18s %3zu bytes %7.1f ns/frame %6.2f ns/byte\r\n", name, frame_size, ns, ns / frame_size);
+    };
+
+    measure("tx encoded", encoded_size, [&] { actionslink_bt_ll_tx(&encoded); });
+    measure("tx nanopb", nanopb_size, [&] { actionslink_bt_ll_tx(&nanopb); });
+
+    line = response;
+    measure("rx protobuf + ack", response.size(),
+            [&]
+            {
+                line_position = 0;
+                receive_next();
+            });
+    EXPECT_EQ(received_payload(), protobuf_payload(std::vector<uint8_t>(32, 0x5A)));
+
+    line = ack;
+    measure("rx ack", ack.size(),
+            [&]
+            {
+                line_position = 0;
+                receive_next();
+            });
+    EXPECT_EQ(packet.transaction_id, FLAG);
+}
+
+} // namespace
@@ -0,0 +1,429 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include <pthread.h>
+
+#include <gtest/gtest.h>
+
+// The internal headers of the library have no C++ guards of their own
+extern "C"
+{
+#include "actionslink_bt_ll.h"
+#include "actionslink_encoders.h"
+#include "pb_encode.h"
+}
+
+// The direct encoders must put the same bytes on the wire as nanopb does for the same message,
+// both for the payload alone and for the whole HDLC frame built by the low layer.
+
+namespace
+{
+
+constexpr uint16_t BUFFER_SIZE = 64;
+constexpr uint16_t APP_TX_SIZE = 32; // ACTIONSLINK_TX_BUFFER_SIZE in the Bluetooth task
+
+uint8_t              tx_buffer[BUFFER_SIZE];
+uint8_t              rx_buffer[BUFFER_SIZE];
+std::vector<uint8_t> written;
+
+int capture_write(const uint8_t *p_data, uint8_t length, uint32_t)
+{
+    written.assign(p_data, p_data + length);
+    return 0;
+}
+
+int discard_write(const uint8_t *, uint8_t, uint32_t)
+{
+    return 0;
+}
+
+int nothing_to_read(uint8_t *, uint8_t, uint32_t)
+{
+    return -1;
+}
+
+uint32_t get_tick_ms()
+{
+    return 0;
+}
+
+actionslink_config_t config = {
+    .write_buffer_fn = capture_write,
+    .read_buffer_fn  = nothing_to_read,
+    .get_tick_ms_fn  = get_tick_ms,
+    .msp_init_fn     = nullptr,
+    .msp_deinit_fn   = nullptr,
+    .task_yield_fn   = nullptr,
+    .log_fn          = nullptr,
+    .p_rx_buffer     = rx_buffer,
+    .p_tx_buffer     = tx_buffer,
+    .rx_buffer_size  = BUFFER_SIZE,
+    .tx_buffer_size  = APP_TX_SIZE,
+};
+
+struct EventCase
+{
+    const char                                                *name;
+    uint16_t                                                   tag;
+    std::function<void(ActionsLink_FromMcuEvent &, uint32_t)> set;
+    std::vector<uint32_t>                                      values;
+};
+
+struct RequestCase
+{
+    const char                                                          *name;
+    uint16_t                                                             tag;
+    std::function<void(ActionsLink_FromMcuRequest &, const uint32_t *)> set;
+    std::vector<std::vector<uint32_t>>                                   values;
+};
+
+// Same values as the API functions pass in, including the ones that need escaping on the wire (0x7D, 0x7E)
+const std::vector<uint32_t> BOOLS       = {0, 1};
+const std::vector<uint32_t> PERCENTAGES = {0, 1, 50, 100, 125, 126, 127, 128, 255, 0xFFFFFFFFu};
+const std::vector<uint32_t> ENUMS       = {0, 1, 2, 3, 4};
+const std::vector<uint8_t>  SEQS        = {0, 1, 125, 126, 127, 128, 255};
+
+#define EVENT(field, values)                                                                                           \
+    {#field, ActionsLink_FromMcuEvent_##field##_tag,                                                                   \
+     [](ActionsLink_FromMcuEvent &e, uint32_t v) { e.Event.field = (decltype(e.Event.field)) v; }, values}
+
+const std::vector<EventCase> EVENTS = {
+    EVENT(notify_aux_connected, BOOLS),
+    EVENT(notify_usb_connected, BOOLS),
+    EVENT(notify_battery_level, PERCENTAGES),
+    EVENT(notify_charger_status, ENUMS),
+    EVENT(notify_battery_friendly_charging, BOOLS),
+    EVENT(notify_eco_mode, BOOLS),
+    EVENT(notify_color, ENUMS),
+};
+
+const std::vector<RequestCase> REQUESTS = {
+    {"set_power_state", ActionsLink_FromMcuRequest_set_power_state_tag,
+     [](ActionsLink_FromMcuRequest &r, const uint32_t *v)
+     { r.Request.set_power_state.mode = (decltype(r.Request.set_power_state.mode)) v[0]; },
+     {{0}, {1}, {2}}},
+    {"set_volume", ActionsLink_FromMcuRequest_set_volume_tag,
+     [](ActionsLink_FromMcuRequest &r, const uint32_t *v)
+     { r.Request.set_volume.action = (decltype(r.Request.set_volume.action)) v[0]; },
+     {{0}, {1}}},
+    // The volume is field 2 of the message, field 1 is always left out
+    {"set_absolute_avrcp_volume", ActionsLink_FromMcuRequest_set_absolute_avrcp_volume_tag,
+     [](ActionsLink_FromMcuRequest &r, const uint32_t *v) { r.Request.set_absolute_avrcp_volume.volume = v[1]; },
+     {{0, 0}, {0, 1}, {0, 64}, {0, 125}, {0, 126}, {0, 127}}},
+    {"send_avrcp_action", ActionsLink_FromMcuRequest_send_avrcp_action_tag,
+     [](ActionsLink_FromMcuRequest &r, const uint32_t *v)
+     { r.Request.send_avrcp_action.action = (decltype(r.Request.send_avrcp_action.action)) v[0]; },
+     {{0}, {1}, {2}, {3}, {4}}},
+    {"set_bt_pairing_state", ActionsLink_FromMcuRequest_set_bt_pairing_state_tag,
+     [](ActionsLink_FromMcuRequest &r, const uint32_t *v)
+     { r.Request.set_bt_pairing_state.state = (decltype(r.Request.set_bt_pairing_state.state)) v[0]; },
+     {{0}, {1}, {4}, {5}, {6}}},
+    {"exit_csb_mode", ActionsLink_FromMcuRequest_exit_csb_mode_tag,
+     [](ActionsLink_FromMcuRequest &r, const uint32_t *v)
+     { r.Request.exit_csb_mode.exit_reason = (decltype(r.Request.exit_csb_mode.exit_reason)) v[0]; },
+     {{0}, {1}, {2}}},
+    {"send_usb_hid_action", ActionsLink_FromMcuRequest_send_usb_hid_action_tag,
+     [](ActionsLink_FromMcuRequest &r, const uint32_t *v)
+     { r.Request.send_usb_hid_action.action = (decltype(r.Request.send_usb_hid_action.action)) v[0]; },
+     {{0}, {1}, {2}}},
+    {"set_audio_source", ActionsLink_FromMcuRequest_set_audio_source_tag,
+     [](ActionsLink_FromMcuRequest &r, const uint32_t *v)
+     { r.Request.set_audio_source.source = (decltype(r.Request.set_audio_source.source)) v[0]; },
+     {{0}, {1}, {2}, {3}}},
+    {"play_sound_icon", ActionsLink_FromMcuRequest_play_sound_icon_tag,
+     [](ActionsLink_FromMcuRequest &r, const uint32_t *v)
+     {
+         r.Request.play_sound_icon.sound_icon    = (decltype(r.Request.play_sound_icon.sound_icon)) v[0];
+         r.Request.play_sound_icon.playback_mode = (decltype(r.Request.play_sound_icon.playback_mode)) v[1];
+         r.Request.play_sound_icon.loop_forever  = v[2] != 0;
+     },
+     {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}, {7, 1, 1}, {20, 2, 1}}},
+    {"stop_sound_icon", ActionsLink_FromMcuRequest_stop_sound_icon_tag,
+     [](ActionsLink_FromMcuRequest &r, const uint32_t *v)
+     { r.Request.stop_sound_icon.sound_icon = (decltype(r.Request.stop_sound_icon.sound_icon)) v[0]; },
+     {{0}, {1}, {20}}},
+};
+
+ActionsLink_FromMcu make_event(const EventCase &c, uint32_t value)
+{
+    ActionsLink_FromMcu message       = ActionsLink_FromMcu_init_zero;
+    message.which_Payload             = ActionsLink_FromMcu_event_tag;
+    message.Payload.event.which_Event = c.tag;
+    c.set(message.Payload.event, value);
+    return message;
+}
+
+ActionsLink_FromMcu make_request(const RequestCase &c, uint8_t seq, const std::vector<uint32_t> &values)
+{
+    ActionsLink_FromMcu message           = ActionsLink_FromMcu_init_zero;
+    message.which_Payload                 = ActionsLink_FromMcu_request_tag;
+    message.Payload.request.seq           = seq;
+    message.Payload.request.which_Request = c.tag;
+    c.set(message.Payload.request, values.data());
+    return message;
+}
+
+std::vector<uint8_t> nanopb_encode(const ActionsLink_FromMcu &message)
+{
+    uint8_t      buffer[BUFFER_SIZE];
+    pb_ostream_t stream = pb_ostream_from_buffer(buffer, sizeof(buffer));
+    EXPECT_TRUE(pb_encode(&stream, ActionsLink_FromMcu_fields, &message));
+    return std::vector<uint8_t>(buffer, buffer + stream.bytes_written);
+}
+
+std::vector<uint8_t> bytes_of(const actionslink_encoded_message_t &message)
+{
+    return std::vector<uint8_t>(message.buffer, message.buffer + message.length);
+}
+
+std::vector<uint8_t> frame_of(const actionslink_bt_ll_tx_packet_t &packet)
+{
+    written.clear();
+    EXPECT_EQ(actionslink_bt_ll_tx(&packet), 0);
+    return written;
+}
+
+actionslink_bt_ll_tx_packet_t nanopb_packet(uint8_t transaction_id, const ActionsLink_FromMcu *p_message)
+{
+    return {ACTIONSLINK_BT_LL_PACKET_TYPE_PROTOBUF, 0, transaction_id, p_message, nullptr, 0};
+}
+
+actionslink_bt_ll_tx_packet_t encoded_packet(uint8_t transaction_id, const actionslink_encoded_message_t *p_message)
+{
+    return {ACTIONSLINK_BT_LL_PACKET_TYPE_PROTOBUF, 0, transaction_id, nullptr, p_message->buffer, p_message->length};
+}
+
+class ActionslinkEncoders : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        config.write_buffer_fn = capture_write;
+        config.tx_buffer_size  = APP_TX_SIZE;
+        actionslink_bt_ll_init(&config);
+    }
+};
+
+TEST_F(ActionslinkEncoders, EventsMatchNanopb)
+{
+    for (const auto &c : EVENTS)
+    {
+        for (uint32_t value : c.values)
+        {
+            actionslink_encoded_message_t encoded;
+            actionslink_encode_event_varint(&encoded, c.tag, value);
+
+            EXPECT_EQ(bytes_of(encoded), nanopb_encode(make_event(c, value))) << c.name << " = " << value;
+            EXPECT_EQ(encoded.which_payload, ActionsLink_FromMcu_event_tag);
+            EXPECT_EQ(encoded.tag, c.tag);
+        }
+    }
+}
+
+TEST_F(ActionslinkEncoders, RequestsMatchNanopb)
+{
+    for (const auto &c : REQUESTS)
+    {
+        for (const auto &values : c.values)
+        {
+            for (uint8_t seq : SEQS)
+            {
+                actionslink_encoded_message_t encoded;
+                ASSERT_EQ(
+                    actionslink_encode_request_varints(&encoded, seq, c.tag, values.data(), (uint8_t) values.size()), 0);
+
+                EXPECT_EQ(bytes_of(encoded), nanopb_encode(make_request(c, seq, values)))
+                    << c.name << " #" << (values.empty() ? 0 : values.back()) << " seq " << (int) seq;
+                EXPECT_EQ(encoded.which_payload, ActionsLink_FromMcu_request_tag);
+                EXPECT_EQ(encoded.tag, c.tag);
+                EXPECT_EQ(encoded.seq, seq);
+            }
+        }
+    }
+}
+
+TEST_F(ActionslinkEncoders, RejectsTooManyFields)
+{
+    const uint32_t                values[] = {1, 2, 3, 4};
+    actionslink_encoded_message_t encoded;
+    EXPECT_EQ(actionslink_encode_request_varints(&encoded, 1, ActionsLink_FromMcuRequest_play_sound_icon_tag, values, 4),
+              -1);
+}
+
+TEST_F(ActionslinkEncoders, LongestRequestFitsTheBuffer)
+{
+    const uint32_t                values[] = {0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu};
+    actionslink_encoded_message_t encoded;
+    ASSERT_EQ(actionslink_encode_request_varints(&encoded, 255, ActionsLink_FromMcuRequest_send_usb_hid_action_tag,
+                                                 values, 3),
+              0);
+    EXPECT_LE(encoded.length, ACTIONSLINK_ENCODED_MESSAGE_MAX_SIZE);
+}
+
+TEST_F(ActionslinkEncoders, FramesMatchNanopbPath)
+{
+    // Transaction IDs that put the HDLC delimiter and escape characters into the header
+    const uint8_t transaction_ids[] = {0, 1, 0x7D, 0x7E, 0xFF};
+
+    for (uint8_t transaction_id : transaction_ids)
+    {
+        for (const auto &c : EVENTS)
+        {
+            for (uint32_t value : c.values)
+            {
+                const ActionsLink_FromMcu     message = make_event(c, value);
+                actionslink_encoded_message_t encoded;
+                actionslink_encode_event_varint(&encoded, c.tag, value);
+
+                EXPECT_EQ(frame_of(encoded_packet(transaction_id, &encoded)),
+                          frame_of(nanopb_packet(transaction_id, &message)))
+                    << c.name << " = " << value << " txid " << (int) transaction_id;
+            }
+        }
+
+        for (const auto &c : REQUESTS)
+        {
+            for (const auto &values : c.values)
+            {
+                for (uint8_t seq : SEQS)
+                {
+                    const ActionsLink_FromMcu     message = make_request(c, seq, values);
+                    actionslink_encoded_message_t encoded;
+                    actionslink_encode_request_varints(&encoded, seq, c.tag, values.data(), (uint8_t) values.size());
+
+                    EXPECT_EQ(frame_of(encoded_packet(transaction_id, &encoded)),
+                              frame_of(nanopb_packet(transaction_id, &message)))
+                        << c.name << " seq " << (int) seq << " txid " << (int) transaction_id;
+                }
+            }
+        }
+    }
+}
+
+TEST_F(ActionslinkEncoders, AckFrame)
+{
+    const actionslink_bt_ll_tx_packet_t ack = {ACTIONSLINK_BT_LL_PACKET_TYPE_ACK, 0, 0x7E, nullptr, nullptr, 0};
+
+    // Header CRC of 55 00 7E 00 00 00 00 is 0xF0, the transaction ID gets escaped
+    const std::vector<uint8_t> expected = {0x7E, 0x55, 0x00, 0x7D, 0x5E, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x7E};
+    EXPECT_EQ(frame_of(ack), expected);
+}
+
+TEST_F(ActionslinkEncoders, FrameTooLargeForBuffer)
+{
+    const uint32_t                values[] = {0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu};
+    actionslink_encoded_message_t encoded;
+    ASSERT_EQ(actionslink_encode_request_varints(&encoded, 255, ActionsLink_FromMcuRequest_play_sound_icon_tag,
+                                                 values, 3),
+              0);
+
+    // One byte short of the frame, then just large enough
+    const size_t frame_length = 2 + 8 + encoded.length;
+    const actionslink_bt_ll_tx_packet_t packet = encoded_packet(1, &encoded);
+    config.tx_buffer_size                      = frame_length - 1;
+    written.clear();
+    EXPECT_EQ(actionslink_bt_ll_tx(&packet), -1);
+    EXPECT_TRUE(written.empty());
+
+    config.tx_buffer_size = frame_length;
+    EXPECT_EQ(frame_of(packet).size(), frame_length);
+}
+
+// Sending the same notification through both paths, as the API functions did before and do now
+void send_battery_level_nanopb(uint32_t level)
+{
+    ActionsLink_FromMcu message                      = ActionsLink_FromMcu_init_zero;
+    message.which_Payload                            = ActionsLink_FromMcu_event_tag;
+    message.Payload.event.which_Event                = ActionsLink_FromMcuEvent_notify_battery_level_tag;
+    message.Payload.event.Event.notify_battery_level = level;
+    const actionslink_bt_ll_tx_packet_t packet = nanopb_packet(1, &message);
+    actionslink_bt_ll_tx(&packet);
+}
+
+void send_battery_level_encoded(uint32_t level)
+{
+    actionslink_encoded_message_t message;
+    actionslink_encode_event_varint(&message, ActionsLink_FromMcuEvent_notify_battery_level_tag, level);
+    const actionslink_bt_ll_tx_packet_t packet = encoded_packet(1, &message);
+    actionslink_bt_ll_tx(&packet);
+}
+
+double ns_per_send(void (*send)(uint32_t))
+{
+    constexpr uint32_t ITERATIONS = 200000;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < ITERATIONS; i++)
+    {
+        send(i % 101);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+}
+
+// Runs a send on a thread with a painted stack and returns how deep it went below the thread's entry
+constexpr size_t  STACK_SIZE  = 256 * 1024;
+constexpr uint8_t STACK_PAINT = 0xA5;
+
+struct StackProbe
+{
+    void (*send)(uint32_t);
+};
+
+void *run_probe(void *p_arg)
+{
+    auto *p_probe = static_cast<StackProbe *>(p_arg);
+    if (p_probe->send != nullptr)
+    {
+        p_probe->send(100);
+    }
+    return nullptr;
+}
+
+size_t stack_used(void (*send)(uint32_t))
+{
+    uint8_t *p_stack = static_cast<uint8_t *>(aligned_alloc(4096, STACK_SIZE));
+    memset(p_stack, STACK_PAINT, STACK_SIZE);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, p_stack, STACK_SIZE);
+
+    StackProbe probe = {send};
+    pthread_t  thread;
+    EXPECT_EQ(pthread_create(&thread, &attr, run_probe, &probe), 0);
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attr);
+
+    size_t untouched = 0;
+    while (untouched < STACK_SIZE && p_stack[untouched] == STACK_PAINT)
+    {
+        untouched++;
+    }
+    free(p_stack);
+    return STACK_SIZE - untouched;
+}
+
+TEST_F(ActionslinkEncoders, CostPerSend)
+{
+    config.write_buffer_fn = discard_write;
+
+    // The thread start-up itself uses some of the stack, subtract it from both
+    const size_t baseline      = stack_used(nullptr);
+    const size_t nanopb_stack  = stack_used(send_battery_level_nanopb) - baseline;
+    const size_t encoded_stack = stack_used(send_battery_level_encoded) - baseline;
+
+    const double nanopb_ns  = ns_per_send(send_battery_level_nanopb);
+    const double encoded_ns = ns_per_send(send_battery_level_encoded);
+
+    printf("notify_battery_level via nanopb:  %6.1f ns, %4zu bytes of stack\r\n", nanopb_ns, nanopb_stack);
+    printf("notify_battery_level via encoder: %6.1f ns, %4zu bytes of stack\r\n", encoded_ns, encoded_stack);
+
+    EXPECT_LT(encoded_stack, nanopb_stack);
+}
+
+} // namespace
@@ -0,0 +1,370 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "actionslink.h"
+#include "actionslink_chip_sim.h"
+#include "message.pb.h"
+
+// The internal headers of the library have no C++ guards of their own
+extern "C"
+{
+#include "actionslink_notifications.h"
+}
+
+// The Bluetooth task sending notifications to the simulated Actions chip through the API, with and without a batching
+// window. The chip ACKs every frame after a turnaround time.
+
+namespace
+{
+
+using actionslink_sim::ChipConfig;
+using actionslink_sim::ChipSim;
+using actionslink_sim::IDLE_US;
+using actionslink_sim::make_config;
+using actionslink_sim::McuMessage;
+using actionslink_sim::percentile;
+
+constexpr uint32_t TURNAROUND_US = 3000; // Actions chip receiving a frame until it starts sending the ACK
+constexpr uint16_t WINDOW_MS     = 20;
+
+const ChipConfig chip_config = {.ack_delay_us = TURNAROUND_US};
+
+struct Received
+{
+    uint64_t                   at_us;
+    actionslink_notification_t kind;
+    uint32_t                   value;
+};
+
+ChipSim *p_chip = nullptr;
+
+const actionslink_event_handlers_t   event_handlers   = {};
+const actionslink_request_handlers_t request_handlers = {};
+
+// Kept by actionslink_init(), only the window differs between the runs
+actionslink_config_t config;
+
+actionslink_notification_t kind_of(uint32_t tag)
+{
+    switch (tag)
+    {
+        case ActionsLink_FromMcuEvent_notify_aux_connected_tag:
+            return ACTIONSLINK_NOTIFICATION_AUX_CONNECTED;
+        case ActionsLink_FromMcuEvent_notify_usb_connected_tag:
+            return ACTIONSLINK_NOTIFICATION_USB_CONNECTED;
+        case ActionsLink_FromMcuEvent_notify_battery_level_tag:
+            return ACTIONSLINK_NOTIFICATION_BATTERY_LEVEL;
+        case ActionsLink_FromMcuEvent_notify_charger_status_tag:
+            return ACTIONSLINK_NOTIFICATION_CHARGER_STATUS;
+        case ActionsLink_FromMcuEvent_notify_battery_friendly_charging_tag:
+            return ACTIONSLINK_NOTIFICATION_BATTERY_FRIENDLY_CHARGING;
+        case ActionsLink_FromMcuEvent_notify_eco_mode_tag:
+            return ACTIONSLINK_NOTIFICATION_ECO_MODE;
+        case ActionsLink_FromMcuEvent_notify_color_tag:
+            return ACTIONSLINK_NOTIFICATION_COLOR;
+        default:
+            return ACTIONSLINK_NOTIFICATION_COUNT;
+    }
+}
+
+// The notifications as the chip received them
+std::vector<Received> received()
+{
+    std::vector<Received> notifications;
+    for (const McuMessage &message : p_chip->received())
+    {
+        if (message.payload_tag == ActionsLink_FromMcu_event_tag)
+        {
+            notifications.push_back({message.at_us, kind_of(message.tag), message.value});
+        }
+    }
+    return notifications;
+}
+
+int post(actionslink_notification_t kind, uint32_t value)
+{
+    switch (kind)
+    {
+        case ACTIONSLINK_NOTIFICATION_AUX_CONNECTED:
+            return actionslink_send_aux_connection_notification(value);
+        case ACTIONSLINK_NOTIFICATION_USB_CONNECTED:
+            return actionslink_send_usb_connection_notification(value);
+        case ACTIONSLINK_NOTIFICATION_BATTERY_LEVEL:
+            return actionslink_send_battery_level(value);
+        case ACTIONSLINK_NOTIFICATION_CHARGER_STATUS:
+            return actionslink_send_charger_status((actionslink_charger_status_t) value);
+        case ACTIONSLINK_NOTIFICATION_BATTERY_FRIENDLY_CHARGING:
+            return actionslink_send_battery_friendly_charging_notification(value);
+        case ACTIONSLINK_NOTIFICATION_ECO_MODE:
+            return actionslink_send_eco_mode_state(value);
+        case ACTIONSLINK_NOTIFICATION_COLOR:
+            return actionslink_send_color_id((actionslink_device_color_t) value);
+        default:
+            return -1;
+    }
+}
+
+// Creates the chip and waits for it to report that it's ready, the API doesn't send anything before
+void start(ChipSim &chip, uint16_t window_ms)
+{
+    p_chip = &chip;
+    config = make_config(window_ms);
+    ASSERT_TRUE(actionslink_sim::start(chip, &config, &event_handlers, &request_handlers));
+}
+
+struct Post
+{
+    uint64_t                   at_us;
+    actionslink_notification_t kind;
+    uint32_t                   value;
+};
+
+// Bursts as they happen on the speaker, a few hundred ms apart
+std::vector<Post> make_bursts(uint32_t count)
+{
+    std::mt19937                            rng(45);
+    std::uniform_int_distribution<uint32_t> gap_ms(300, 1000);
+    std::uniform_int_distribution<uint32_t> jitter_us(0, 5000);
+    std::uniform_int_distribution<uint32_t> scenario(0, 3);
+
+    std::vector<Post> posts;
+    uint64_t          t_us  = 0;
+    uint32_t          level = 50;
+    bool              eco   = false;
+
+    auto add = [&](uint64_t at_us, actionslink_notification_t kind, uint32_t value)
+    { posts.push_back({at_us, kind, value}); };
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        t_us += gap_ms(rng) * 1000ull;
+        switch (scenario(rng))
+        {
+            case 0: // Power on, the whole state is reported at once
+                for (int kind = 0; kind < ACTIONSLINK_NOTIFICATION_COUNT; kind++)
+                {
+                    add(t_us + jitter_us(rng), (actionslink_notification_t) kind,
+                        kind == ACTIONSLINK_NOTIFICATION_BATTERY_LEVEL ? level : 1);
+                }
+                break;
+            case 1: // Charger plugged in, the charger status settles after a few ms
+                add(t_us, ACTIONSLINK_NOTIFICATION_USB_CONNECTED, 1);
+                add(t_us + jitter_us(rng), ACTIONSLINK_NOTIFICATION_CHARGER_STATUS, 2);
+                add(t_us + 8000 + jitter_us(rng), ACTIONSLINK_NOTIFICATION_CHARGER_STATUS, 1);
+                add(t_us + 9000 + jitter_us(rng), ACTIONSLINK_NOTIFICATION_BATTERY_FRIENDLY_CHARGING, 1);
+                add(t_us + 10000 + jitter_us(rng), ACTIONSLINK_NOTIFICATION_BATTERY_LEVEL, level);
+                break;
+            case 2: // Battery level flapping under a load step
+                for (int j = 0; j < 3; j++)
+                {
+                    level = (j % 2) ? level + 1 : level - 1;
+                    add(t_us + j * 6000 + jitter_us(rng), ACTIONSLINK_NOTIFICATION_BATTERY_LEVEL, level);
+                }
+                break;
+            default: // Eco mode toggled with the button, slower than the window
+                for (int j = 0; j < 2; j++)
+                {
+                    eco = !eco;
+                    add(t_us + j * 150000 + jitter_us(rng), ACTIONSLINK_NOTIFICATION_ECO_MODE, eco);
+                }
+                break;
+        }
+    }
+
+    std::stable_sort(posts.begin(), posts.end(), [](const Post &a, const Post &b) { return a.at_us < b.at_us; });
+    return posts;
+}
+
+struct Result
+{
+    uint32_t              frames;
+    std::vector<uint32_t> latencies_us;
+    uint32_t              final_values[ACTIONSLINK_NOTIFICATION_COUNT];
+};
+
+// Runs the posts through the Bluetooth task: a message is handled as soon as the task is free, the idle callback
+// (actionslink_tick) runs after the task has been without messages for the idle period. Post times are counted from
+// the chip being ready.
+Result run(ChipSim &chip, uint16_t window_ms, const std::vector<Post> &posts)
+{
+    start(chip, window_ms);
+    const uint64_t begin_us = chip.now_us();
+
+    std::vector<uint64_t> posted_us;
+    size_t                next    = 0;
+    uint64_t              idle_us = chip.now_us() + IDLE_US;
+    while (next < posts.size() || actionslink_needs_tick())
+    {
+        if (next < posts.size() && begin_us + posts[next].at_us <= chip.now_us())
+        {
+            posted_us.push_back(chip.now_us());
+            EXPECT_EQ(post(posts[next].kind, posts[next].value), 0);
+            next++;
+            idle_us = chip.now_us() + IDLE_US;
+            continue;
+        }
+
+        uint64_t wake_us = idle_us;
+        if (next < posts.size())
+        {
+            wake_us = std::min(wake_us, begin_us + posts[next].at_us);
+        }
+        if (wake_us > chip.now_us())
+        {
+            chip.advance_us(wake_us - chip.now_us());
+        }
+
+        if (chip.now_us() >= idle_us)
+        {
+            actionslink_tick();
+            idle_us = chip.now_us() + IDLE_US;
+        }
+    }
+
+    // A notification has arrived once the chip has received a frame of its kind that was sent after it was posted
+    const auto notifications = received();
+    Result     result        = {chip.stats().events_from_mcu, {}, {}};
+    for (size_t i = 0; i < posts.size(); i++)
+    {
+        auto it = std::find_if(notifications.begin(), notifications.end(),
+                               [&](const Received &r) { return r.kind == posts[i].kind && r.at_us > posted_us[i]; });
+        EXPECT_NE(it, notifications.end());
+        if (it != notifications.end())
+        {
+            result.latencies_us.push_back((uint32_t) (it->at_us - (begin_us + posts[i].at_us)));
+        }
+    }
+    for (const auto &r : notifications)
+    {
+        result.final_values[r.kind] = r.value;
+    }
+    std::sort(result.latencies_us.begin(), result.latencies_us.end());
+    return result;
+}
+
+TEST(ActionslinkNotifications, LastValueWinsWithinWindow)
+{
+    const std::vector<Post> posts = {
+        {0, ACTIONSLINK_NOTIFICATION_BATTERY_LEVEL, 40},
+        {1000, ACTIONSLINK_NOTIFICATION_CHARGER_STATUS, ACTIONSLINK_CHARGER_STATUS_INACTIVE},
+        {2000, ACTIONSLINK_NOTIFICATION_BATTERY_LEVEL, 41},
+        {3000, ACTIONSLINK_NOTIFICATION_ECO_MODE, 1},
+        {4000, ACTIONSLINK_NOTIFICATION_BATTERY_LEVEL, 42},
+    };
+    ChipSim chip(chip_config);
+    run(chip, WINDOW_MS, posts);
+
+    // One frame per kind, in the order the kinds were first posted, with the latest values
+    const auto notifications = received();
+    ASSERT_EQ(notifications.size(), 3u);
+    EXPECT_EQ(notifications[0].kind, ACTIONSLINK_NOTIFICATION_BATTERY_LEVEL);
+    EXPECT_EQ(notifications[0].value, 42u);
+    EXPECT_EQ(notifications[1].kind, ACTIONSLINK_NOTIFICATION_CHARGER_STATUS);
+    EXPECT_EQ(notifications[1].value, (uint32_t) ActionsLink_Battery_ChargerStatus_Inactive);
+    EXPECT_EQ(notifications[2].kind, ACTIONSLINK_NOTIFICATION_ECO_MODE);
+
+    actionslink_notifications_stats_t stats;
+    actionslink_notifications_get_stats(&stats);
+    EXPECT_EQ(stats.posted, 5u);
+    EXPECT_EQ(stats.replaced, 2u);
+    EXPECT_EQ(stats.sent, 3u);
+    EXPECT_EQ(stats.failed, 0u);
+    EXPECT_TRUE(chip.is_idle());
+}
+
+TEST(ActionslinkNotifications, NoWindowSendsEveryPost)
+{
+    const std::vector<Post> posts = {
+        {0, ACTIONSLINK_NOTIFICATION_BATTERY_LEVEL, 40},
+        {0, ACTIONSLINK_NOTIFICATION_BATTERY_LEVEL, 41},
+    };
+    ChipSim chip(chip_config);
+    run(chip, 0, posts);
+
+    const auto notifications = received();
+    ASSERT_EQ(notifications.size(), 2u);
+    EXPECT_EQ(notifications[0].value, 40u);
+    EXPECT_EQ(notifications[1].value, 41u);
+}
+
+TEST(ActionslinkNotifications, HeldBackForTheWindowOnly)
+{
+    ChipSim chip(chip_config);
+    run(chip, WINDOW_MS, {{0, ACTIONSLINK_NOTIFICATION_ECO_MODE, 1}});
+    ASSERT_EQ(actionslink_send_eco_mode_state(false), 0);
+
+    chip.advance_us((WINDOW_MS - 1) * 1000ull);
+    actionslink_tick();
+    EXPECT_TRUE(actionslink_needs_tick());
+    EXPECT_EQ(received().size(), 1u);
+
+    chip.advance_us(1000);
+    actionslink_tick();
+    EXPECT_FALSE(actionslink_needs_tick());
+    ASSERT_EQ(received().size(), 2u);
+    EXPECT_EQ(received().back().value, 0u);
+}
+
+// The Actions module sees the state changes before a request that follows them, e.g. the battery level and the
+// charger status before the power on
+TEST(ActionslinkNotifications, RequestFlushesPendingNotifications)
+{
+    ChipSim chip(chip_config);
+    start(chip, WINDOW_MS);
+    const size_t before = chip.received().size();
+
+    ASSERT_EQ(actionslink_send_battery_level(42), 0);
+    ASSERT_EQ(actionslink_send_charger_status(ACTIONSLINK_CHARGER_STATUS_ACTIVE), 0);
+    ASSERT_EQ(actionslink_send_battery_level(43), 0);
+    EXPECT_TRUE(actionslink_needs_tick());
+
+    EXPECT_EQ(actionslink_set_power_state(ACTIONSLINK_POWER_STATE_ON), 0);
+    EXPECT_FALSE(actionslink_needs_tick());
+
+    const auto &messages = chip.received();
+    ASSERT_EQ(messages.size(), before + 3);
+    EXPECT_EQ(messages[before].payload_tag, (uint32_t) ActionsLink_FromMcu_event_tag);
+    EXPECT_EQ(messages[before].tag, (uint32_t) ActionsLink_FromMcuEvent_notify_battery_level_tag);
+    EXPECT_EQ(messages[before].value, 43u);
+    EXPECT_EQ(messages[before + 1].payload_tag, (uint32_t) ActionsLink_FromMcu_event_tag);
+    EXPECT_EQ(messages[before + 1].tag, (uint32_t) ActionsLink_FromMcuEvent_notify_charger_status_tag);
+    EXPECT_EQ(messages[before + 2].payload_tag, (uint32_t) ActionsLink_FromMcu_request_tag);
+    EXPECT_EQ(messages[before + 2].tag, (uint32_t) ActionsLink_FromMcuRequest_set_power_state_tag);
+
+    // Nothing is left for the window to send
+    chip.advance_us(2 * WINDOW_MS * 1000ull);
+    actionslink_tick();
+    EXPECT_EQ(chip.received().size(), before + 3);
+    EXPECT_TRUE(chip.is_idle());
+}
+
+TEST(ActionslinkNotifications, Bursts)
+{
+    const auto posts = make_bursts(500);
+    ChipSim    immediate_chip(chip_config);
+    const auto immediate = run(immediate_chip, 0, posts);
+    ChipSim    batched_chip(chip_config);
+    const auto batched = run(batched_chip, WINDOW_MS, posts);
+
+    printf("%zu notifications in 500 bursts\r\n", posts.size());
+    printf("no window:   %5u round trips, latency [us] p50 %6u  p99 %6u  max %6u\r\n", immediate.frames,
+           percentile(immediate.latencies_us, 0.5), percentile(immediate.latencies_us, 0.99),
+           immediate.latencies_us.back());
+    printf("%2u ms window: %5u round trips, latency [us] p50 %6u  p99 %6u  max %6u\r\n", WINDOW_MS, batched.frames,
+           percentile(batched.latencies_us, 0.5), percentile(batched.latencies_us, 0.99),
+           batched.latencies_us.back());
+
+    EXPECT_LT(batched.frames, immediate.frames);
+    // The window, the idle period and a burst of round trips on top
+    EXPECT_LT(batched.latencies_us.back(), 100000u);
+    for (int kind = 0; kind < ACTIONSLINK_NOTIFICATION_COUNT; kind++)
+    {
+        EXPECT_EQ(batched.final_values[kind], immediate.final_values[kind]);
+    }
+}
+
+} // namespace
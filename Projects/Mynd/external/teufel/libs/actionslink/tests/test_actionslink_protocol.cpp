@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "actionslink.h"
+#include "actionslink_chip_sim.h"
+#include "message.pb.h"
+
+// Protocol benchmark of the whole library against the simulated Actions chip: back-to-back requests through the
+// public API while the chip sends events, on a clean link and on links with slow responses, CRC errors and lost
+// frames. Throughput and latency are in simulated time, as the UART and the chip set them on the device.
+
+namespace
+{
+
+using actionslink_sim::ChipConfig;
+using actionslink_sim::ChipSim;
+using actionslink_sim::ChipStats;
+using actionslink_sim::IDLE_US;
+using actionslink_sim::make_config;
+using actionslink_sim::percentile;
+using actionslink_sim::start;
+
+constexpr uint32_t REQUESTS        = 2000;
+constexpr uint64_t EVENT_PERIOD_US = 50000; // The chip reports a volume or stream state change this often
+constexpr uint64_t DRAIN_US        = 2000000;
+
+const char *const BUILD_STRING = "1.2.3-sim";
+
+struct Counters
+{
+    uint32_t system_ready;
+    uint32_t volume;
+    uint32_t stream_state;
+};
+
+Counters counters;
+
+void on_system_ready()
+{
+    counters.system_ready++;
+}
+
+void on_volume(const actionslink_volume_t *)
+{
+    counters.volume++;
+}
+
+void on_stream_state(bool)
+{
+    counters.stream_state++;
+}
+
+const actionslink_event_handlers_t event_handlers = {
+    .on_notify_system_ready = on_system_ready,
+    .on_notify_volume       = on_volume,
+    .on_notify_stream_state = on_stream_state,
+};
+
+const actionslink_request_handlers_t request_handlers = {};
+
+const actionslink_config_t config = make_config();
+
+std::vector<uint8_t> firmware_version_body()
+{
+    std::vector<uint8_t> body;
+    for (uint32_t field = 1; field <= 3; field++)
+    {
+        auto version = ChipSim::varint_field(field, field);
+        body.insert(body.end(), version.begin(), version.end());
+    }
+    auto build = ChipSim::bytes_field(4, std::vector<uint8_t>(BUILD_STRING, BUILD_STRING + strlen(BUILD_STRING)));
+    body.insert(body.end(), build.begin(), build.end());
+    return body;
+}
+
+// A mix of requests with short and longer messages, sent through direct encoding and through nanopb, and a response
+// with a string decoded by a callback
+int send_request(uint32_t index)
+{
+    switch (index % 4)
+    {
+        case 0:
+            return actionslink_increase_volume();
+        case 1:
+            return actionslink_play_sound_icon(ACTIONSLINK_SOUND_ICON_BT_CONNECTED,
+                                               ACTIONSLINK_SOUND_ICON_PLAYBACK_MODE_PLAY_IMMEDIATELY, false);
+        case 2:
+            return actionslink_set_power_state(ACTIONSLINK_POWER_STATE_ON);
+        default:
+        {
+            uint8_t                        build[16]     = {};
+            actionslink_buffer_dsc_t       build_dsc     = {build, sizeof(build)};
+            actionslink_firmware_version_t version       = {0, 0, 0, &build_dsc};
+            int                            ret_val       = actionslink_get_firmware_version(&version);
+            bool                           is_version_ok = (version.major == 1) && (version.minor == 2) &&
+                                 (version.patch == 3) && (strcmp((const char *) build, BUILD_STRING) == 0);
+            return ((ret_val == 0) && is_version_ok) ? 0 : -1;
+        }
+    }
+}
+
+struct Result
+{
+    uint32_t              succeeded;
+    uint32_t              failed;
+    std::vector<uint32_t> latencies_us;
+    uint64_t              elapsed_us;
+    double                host_ns_per_request;
+    uint32_t              events_sent;
+    uint32_t              events_handled;
+    ChipStats             stats;
+};
+
+Result run(const ChipConfig &chip_config, uint32_t count = REQUESTS)
+{
+    ChipSim chip(chip_config);
+    counters = {};
+    chip.set_response_body(ActionsLink_FromMcuRequest_get_firmware_version_tag, firmware_version_body());
+
+    EXPECT_TRUE(start(chip, &config, &event_handlers, &request_handlers));
+
+    Result   result        = {};
+    uint64_t start_us      = chip.now_us();
+    uint64_t next_event_us = start_us;
+    auto     host_start    = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        // Events are queued ahead of time, the chip sends them whenever it gets to it
+        while (next_event_us <= chip.now_us() + EVENT_PERIOD_US)
+        {
+            if (result.events_sent % 2)
+            {
+                auto volume = ChipSim::varint_field(1, i % 100);
+                chip.emit_event(ChipSim::bytes_field(ActionsLink_ToMcuEvent_notify_volume_tag, volume), next_event_us);
+            }
+            else
+            {
+                chip.emit_event(ChipSim::varint_field(ActionsLink_ToMcuEvent_notify_stream_state_tag, i % 2),
+                                next_event_us);
+            }
+            result.events_sent++;
+            next_event_us += EVENT_PERIOD_US;
+        }
+
+        uint64_t sent_us = chip.now_us();
+        if (send_request(i) == 0)
+        {
+            result.succeeded++;
+        }
+        else
+        {
+            result.failed++;
+        }
+        result.latencies_us.push_back((uint32_t) (chip.now_us() - sent_us));
+
+        // Anything that arrived after the response
+        actionslink_tick();
+    }
+
+    result.elapsed_us          = chip.now_us() - start_us;
+    result.host_ns_per_request = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() -
+                                                                          host_start).count() / count;
+
+    uint64_t drain_until_us = chip.now_us() + DRAIN_US;
+    while (!chip.is_idle() && (chip.now_us() < drain_until_us))
+    {
+        chip.advance_us(IDLE_US);
+        actionslink_tick();
+    }
+
+    result.events_handled = counters.volume + counters.stream_state;
+    result.stats          = chip.stats();
+    std::sort(result.latencies_us.begin(), result.latencies_us.end());
+    return result;
+}
+
+void report(const char *name, const Result &result)
+{
+    uint32_t count = result.succeeded + result.failed;
+    printf("%-12s %5u requests %6.1f req/s  latency [us] p50 %6u  p99 %6u  max %6u  failed %3u\r\n", name, count,
+           count * 1e6 / result.elapsed_us, percentile(result.latencies_us, 0.5),
+           percentile(result.latencies_us, 0.99), result.latencies_us.back(), result.failed);
+    printf("%-12s retransmitted by the MCU %5.2f%%, by the chip %5.2f%%  events %u/%u  host %.0f ns/request\r\n", "",
+           100.0 * (result.stats.messages_from_mcu - count) / count,
+           100.0 * result.stats.retransmissions / (result.stats.frames_to_mcu - result.stats.retransmissions),
+           result.events_handled, result.events_sent, result.host_ns_per_request);
+}
+
+TEST(ActionslinkProtocol, CleanLink)
+{
+    const auto result = run({});
+    report("clean", result);
+
+    EXPECT_EQ(result.failed, 0u);
+    EXPECT_EQ(result.stats.messages_from_mcu, REQUESTS);
+    EXPECT_EQ(result.stats.repeated_requests, 0u);
+    EXPECT_EQ(result.stats.retransmissions, 0u);
+    EXPECT_EQ(result.stats.nacks_from_mcu, 0u);
+    EXPECT_EQ(result.stats.nacks_to_mcu, 0u);
+    EXPECT_EQ(result.events_handled, result.events_sent);
+    EXPECT_EQ(counters.system_ready, 1u);
+}
+
+TEST(ActionslinkProtocol, SlowChip)
+{
+    ChipConfig chip_config         = {};
+    chip_config.response_delay_us  = 20000;
+    chip_config.response_jitter_us = 200000;
+    const auto result              = run(chip_config, REQUESTS / 4);
+    report("slow chip", result);
+
+    // Responses up to the timeout of 300 ms after the ACK are fine
+    EXPECT_EQ(result.failed, 0u);
+    EXPECT_EQ(result.stats.repeated_requests, 0u);
+    EXPECT_EQ(result.events_handled, result.events_sent);
+}
+
+TEST(ActionslinkProtocol, CrcErrors)
+{
+    ChipConfig chip_config     = {};
+    chip_config.crc_error_rate = 0.01;
+    const auto result          = run(chip_config);
+    report("crc errors", result);
+
+    EXPECT_GT(result.stats.corrupted, 0u);
+    EXPECT_GT(result.stats.repeated_requests, 0u);
+    EXPECT_LE(result.failed, REQUESTS / 100);
+    EXPECT_GE(result.events_handled, result.events_sent * 99 / 100);
+}
+
+TEST(ActionslinkProtocol, LostFrames)
+{
+    ChipConfig chip_config = {};
+    chip_config.drop_rate  = 0.01;
+    const auto result      = run(chip_config);
+    report("lost frames", result);
+
+    EXPECT_GT(result.stats.dropped, 0u);
+    EXPECT_GT(result.stats.repeated_requests, 0u);
+    EXPECT_LE(result.failed, REQUESTS / 100);
+    EXPECT_GE(result.events_handled, result.events_sent * 99 / 100);
+}
+
+TEST(ActionslinkProtocol, NackOfTransactionZero)
+{
+    ChipSim chip({});
+    counters = {};
+
+    ASSERT_TRUE(start(chip, &config, &event_handlers, &request_handlers));
+
+    // The first request has transaction ID 0 like the NACK of the broken frame
+    chip.corrupt_next_frame_from_mcu();
+    uint64_t sent_us = chip.now_us();
+    EXPECT_EQ(actionslink_increase_volume(), 0);
+
+    EXPECT_EQ(chip.stats().nacks_to_mcu, 1u);
+    EXPECT_EQ(chip.stats().requests, 1u);
+    EXPECT_EQ(chip.stats().messages_from_mcu, 2u);
+    // Sent again right after the NACK, not after waiting for the response to a request the chip never got
+    EXPECT_LT(chip.now_us() - sent_us, 100000u);
+}
+
+TEST(ActionslinkProtocol, NoisyLink)
+{
+    ChipConfig chip_config         = {};
+    chip_config.response_jitter_us = 20000;
+    chip_config.crc_error_rate     = 0.03;
+    chip_config.drop_rate          = 0.03;
+    chip_config.seed               = 46;
+    const auto result              = run(chip_config);
+    report("noisy link", result);
+
+    // Any broken frame ends the attempt of the request in progress, even if it was an event, so a link this bad
+    // fails a good share of the requests. The link must keep working though.
+    EXPECT_GE(result.succeeded, REQUESTS * 3 / 4);
+    EXPECT_GE(result.events_handled, result.events_sent * 9 / 10);
+}
+
+} // namespace
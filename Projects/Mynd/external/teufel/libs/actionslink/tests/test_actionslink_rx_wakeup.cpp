@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "actionslink.h"
+#include "actionslink_chip_sim.h"
+#include "message.pb.h"
+#include "src/bsp/bluetooth_uart/bsp_bluetooth_uart_frame.h"
+#include "src/tasks/bluetooth/bluetooth_wakeup.h"
+
+// Wake ups of the Bluetooth task against the simulated Actions chip: the task either polls actionslink_tick() every
+// 10 ms, or sleeps until the UART interrupt reports the end of a frame and only wakes up periodically while the
+// library needs ticks. Events come at random with some bursts, and the MCU sends notifications every now and then.
+// The time from an event being sent until its handler runs and the task wake ups per second are compared. The frame
+// end detection of the RX interrupt, the guard of the message it posts and the idle periods are the application's.
+
+namespace
+{
+
+using actionslink_sim::ChipSim;
+using actionslink_sim::make_config;
+using actionslink_sim::percentile;
+using actionslink_sim::start;
+using Teufel::Task::Bluetooth::c_chip_idle_period_ms;
+using Teufel::Task::Bluetooth::c_idle_never;
+using Teufel::Task::Bluetooth::c_idle_period_ms;
+using Teufel::Task::Bluetooth::FramePostGuard;
+using Teufel::Task::Bluetooth::idle_period_ms;
+using Teufel::Task::Bluetooth::IdleState;
+
+constexpr uint64_t STEP_US                = 100;
+constexpr uint64_t DURATION_US            = 60000000;
+constexpr uint64_t POLL_US                = c_idle_period_ms * 1000;
+constexpr uint64_t EVENT_MEAN_US          = 300000;
+constexpr uint64_t NOTIFICATION_PERIOD_US = 2000000;
+constexpr uint8_t  MAX_FRAMES_PER_WAKEUP  = 8;   // c_max_frames_per_wakeup of the task
+constexpr size_t   RX_BUFFER_SIZE         = 128; // Stream buffer of the UART
+constexpr uint16_t NOTIFICATION_WINDOW_MS = 20;
+constexpr uint32_t BURST_EVERY_NTH_EVENT  = 8;
+constexpr uint32_t EVENTS_PER_BURST       = 4;
+constexpr uint64_t DRAIN_US               = 200000;
+
+ChipSim              *p_chip = nullptr;
+std::deque<uint64_t>  pending_events_us; // Events sent by the chip, in order
+std::vector<uint32_t> latencies_us;
+
+void on_volume(const actionslink_volume_t *)
+{
+    // A clean link delivers the events in order
+    latencies_us.push_back((uint32_t) (p_chip->now_us() - pending_events_us.front()));
+    pending_events_us.pop_front();
+}
+
+const actionslink_event_handlers_t event_handlers = {
+    .on_notify_volume = on_volume,
+};
+
+const actionslink_request_handlers_t request_handlers = {};
+
+const actionslink_config_t config = make_config(NOTIFICATION_WINDOW_MS);
+
+enum class Wakeup
+{
+    Polling,
+    FrameEnd,
+};
+
+struct Result
+{
+    uint32_t              wakeups;
+    uint32_t              ticks;
+    uint32_t              events_sent;
+    uint32_t              notifications;
+    std::vector<uint32_t> latencies_us;
+};
+
+void tick(Result &result)
+{
+    actionslink_tick();
+    result.ticks++;
+}
+
+Result run(Wakeup wakeup)
+{
+    ChipSim chip({});
+    p_chip = &chip;
+    pending_events_us.clear();
+    latencies_us.clear();
+
+    EXPECT_TRUE(start(chip, &config, &event_handlers, &request_handlers));
+
+    Result                                result   = {};
+    std::mt19937                          rng(48);
+    std::exponential_distribution<double> gap(1.0 / EVENT_MEAN_US);
+    uint64_t                              event_us = chip.now_us();
+    while (event_us < DURATION_US)
+    {
+        uint32_t count = (result.events_sent % BURST_EVERY_NTH_EVENT) ? 1 : EVENTS_PER_BURST;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            auto volume = ChipSim::varint_field(1, (result.events_sent + i) % 100);
+            chip.emit_event(ChipSim::bytes_field(ActionsLink_ToMcuEvent_notify_volume_tag, volume), event_us);
+            pending_events_us.push_back(event_us);
+        }
+        result.events_sent += count;
+        event_us += (uint64_t) gap(rng);
+    }
+
+    bsp_bluetooth_uart_frame_detector_t frame_detector = BSP_BLUETOOTH_UART_FRAME_DETECTOR_INIT;
+    FramePostGuard                      frame_post_guard;
+    bool                                is_frame_received_queued = false;
+
+    uint64_t wakeup_us       = chip.now_us() + POLL_US;
+    uint64_t notification_us = chip.now_us() + NOTIFICATION_PERIOD_US;
+    while (chip.now_us() < DURATION_US + DRAIN_US)
+    {
+        chip.advance_us(STEP_US);
+
+        if (wakeup == Wakeup::FrameEnd)
+        {
+            for (uint8_t byte : chip.rx_interrupts())
+            {
+                if (bsp_bluetooth_uart_frame_detector_push(&frame_detector, byte,
+                                                           chip.rx_available() >= RX_BUFFER_SIZE))
+                {
+                    frame_post_guard.post(
+                        [&]()
+                        {
+                            is_frame_received_queued = true;
+                            return 0;
+                        });
+                }
+            }
+        }
+
+        // A message from another task wakes the task up in either case
+        bool woken_by_message = chip.now_us() >= notification_us;
+        if (woken_by_message)
+        {
+            EXPECT_EQ(actionslink_send_aux_connection_notification(result.notifications % 2), 0);
+            result.notifications++;
+            notification_us += NOTIFICATION_PERIOD_US;
+        }
+
+        if (is_frame_received_queued)
+        {
+            is_frame_received_queued = false;
+            frame_post_guard.clear();
+            uint8_t frames = 0;
+            do
+            {
+                tick(result);
+            } while ((chip.rx_available() > 0) && (++frames < MAX_FRAMES_PER_WAKEUP));
+        }
+        else if (chip.now_us() >= wakeup_us)
+        {
+            tick(result);
+        }
+        else if (!woken_by_message)
+        {
+            continue;
+        }
+
+        result.wakeups++;
+        if (wakeup == Wakeup::Polling)
+        {
+            wakeup_us = std::max(wakeup_us, chip.now_us() - chip.now_us() % POLL_US) + POLL_US;
+        }
+        else
+        {
+            const IdleState state = {
+                .is_chip_active     = true,
+                .needs_ticks        = actionslink_needs_tick() || (chip.rx_available() > 0),
+                .has_pending_work   = false,
+                .sound_icons_due_ms = UINT32_MAX,
+            };
+            const uint32_t idle_ms = idle_period_ms(state);
+            wakeup_us              = (idle_ms == c_idle_never) ? UINT64_MAX : chip.now_us() + idle_ms * 1000ull;
+        }
+    }
+
+    EXPECT_TRUE(chip.is_idle());
+    EXPECT_EQ(chip.stats().events_from_mcu, result.notifications);
+    result.latencies_us = latencies_us;
+    std::sort(result.latencies_us.begin(), result.latencies_us.end());
+    p_chip = nullptr;
+    return result;
+}
+
+void report(const char *name, const Result &result)
+{
+    printf("%-10s %5.1f wakeups/s %6.1f ticks/s  event latency [us] p50 %6u  p99 %6u  max %6u  events %u/%u\r\n",
+           name, result.wakeups * 1e6 / DURATION_US, result.ticks * 1e6 / DURATION_US,
+           percentile(result.latencies_us, 0.5), percentile(result.latencies_us, 0.99), result.latencies_us.back(),
+           (uint32_t) result.latencies_us.size(), result.events_sent);
+}
+
+TEST(ActionslinkRxWakeup, FrameEndAgainstPolling)
+{
+    const auto polling = run(Wakeup::Polling);
+    report("polling", polling);
+    const auto frame_end = run(Wakeup::FrameEnd);
+    report("frame end", frame_end);
+
+    EXPECT_EQ(polling.latencies_us.size(), polling.events_sent);
+    EXPECT_EQ(frame_end.latencies_us.size(), frame_end.events_sent);
+
+    EXPECT_LT(frame_end.wakeups * 10, polling.wakeups);
+    EXPECT_LT(percentile(frame_end.latencies_us, 0.5), percentile(polling.latencies_us, 0.5));
+    EXPECT_LT(percentile(frame_end.latencies_us, 0.99), percentile(polling.latencies_us, 0.99));
+}
+
+TEST(ActionslinkRxWakeup, FrameEndDetector)
+{
+    bsp_bluetooth_uart_frame_detector_t detector = BSP_BLUETOOTH_UART_FRAME_DETECTOR_INIT;
+
+    // Each frame opens and closes with a delimiter, only the closing one ends it. 0x7D 0x5E is an escaped 0x7E.
+    const uint8_t bytes[]    = {0x7E, 0x55, 0x7D, 0x5E, 0x7E, 0x7E, 0x01, 0x7E, 0x7E};
+    const bool    expected[] = {false, false, false, false, true, false, false, true, false};
+    for (size_t i = 0; i < sizeof(bytes); i++)
+    {
+        EXPECT_EQ(bsp_bluetooth_uart_frame_detector_push(&detector, bytes[i], false), expected[i]) << "byte " << i;
+    }
+
+    // A full buffer needs the task whether a frame ended or not
+    EXPECT_TRUE(bsp_bluetooth_uart_frame_detector_push(&detector, 0x02, true));
+    EXPECT_TRUE(bsp_bluetooth_uart_frame_detector_push(&detector, 0x7E, false));
+}
+
+TEST(ActionslinkRxWakeup, FramePostGuard)
+{
+    FramePostGuard guard;
+    uint32_t       posts    = 0;
+    int            post_ret = 0;
+    auto           post     = [&]()
+    {
+        posts++;
+        return post_ret;
+    };
+
+    // A burst of frames posts one message until the task takes it
+    guard.post(post);
+    guard.post(post);
+    EXPECT_EQ(posts, 1u);
+    guard.clear();
+    guard.post(post);
+    EXPECT_EQ(posts, 2u);
+
+    // A full queue doesn't leave the guard set
+    guard.clear();
+    post_ret = -1;
+    guard.post(post);
+    post_ret = 0;
+    guard.post(post);
+    guard.post(post);
+    EXPECT_EQ(posts, 4u);
+}
+
+TEST(ActionslinkRxWakeup, IdlePeriod)
+{
+    EXPECT_EQ(idle_period_ms({true, true, false, UINT32_MAX}), c_idle_period_ms);
+    EXPECT_EQ(idle_period_ms({true, false, true, UINT32_MAX}), c_idle_period_ms);
+    EXPECT_EQ(idle_period_ms({true, false, false, UINT32_MAX}), c_chip_idle_period_ms);
+    EXPECT_EQ(idle_period_ms({true, false, false, 300}), 300u);
+    EXPECT_EQ(idle_period_ms({true, true, false, 0}), 1u);
+
+    // With the chip off only the task's own work and messages wake it up
+    EXPECT_EQ(idle_period_ms({false, true, false, 300}), c_idle_never);
+    EXPECT_EQ(idle_period_ms({false, false, true, UINT32_MAX}), c_idle_period_ms);
+}
+
+} // namespace
@@ -0,0 +1,509 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "actionslink.h"
+#include "actionslink_chip_sim.h"
+#include "message.pb.h"
+
+// Sound icons requested through the scheduling against the simulated Actions chip: the order they are played in,
+// merged and cancelled requests, and the time from a UX event until its sound icon is started. Before, the
+// Bluetooth task sent every request to the chip as it came.
+
+namespace
+{
+
+using actionslink_sim::ChipSim;
+using actionslink_sim::make_config;
+using actionslink_sim::McuMessage;
+using actionslink_sim::percentile;
+
+constexpr uint64_t MS = 1000;
+
+// Same as the Bluetooth task
+const actionslink_sound_icon_info_t sound_icons[] = {
+    {ACTIONSLINK_SOUND_ICON_POWER_OFF, ACTIONSLINK_SOUND_ICON_PRIORITY_CRITICAL, 1832},
+    {ACTIONSLINK_SOUND_ICON_POWER_ON, ACTIONSLINK_SOUND_ICON_PRIORITY_CRITICAL, 1670},
+    {ACTIONSLINK_SOUND_ICON_BATTERY_LOW, ACTIONSLINK_SOUND_ICON_PRIORITY_HIGH, 910},
+    {ACTIONSLINK_SOUND_ICON_ERROR, ACTIONSLINK_SOUND_ICON_PRIORITY_HIGH, 0},
+    {ACTIONSLINK_SOUND_ICON_CHARGING, ACTIONSLINK_SOUND_ICON_PRIORITY_NORMAL, 1440},
+    {ACTIONSLINK_SOUND_ICON_POSITIVE_FEEDBACK, ACTIONSLINK_SOUND_ICON_PRIORITY_NORMAL, 180},
+    {ACTIONSLINK_SOUND_ICON_MULTISPEAKER_CHAIN_MASTER_ENTERED, ACTIONSLINK_SOUND_ICON_PRIORITY_NORMAL, 4570},
+    {ACTIONSLINK_SOUND_ICON_BT_PAIRING, ACTIONSLINK_SOUND_ICON_PRIORITY_LOW, 4570},
+    {ACTIONSLINK_SOUND_ICON_MULTISPEAKER_CHAIN_SLAVE_PAIRING, ACTIONSLINK_SOUND_ICON_PRIORITY_LOW, 4570},
+};
+
+const actionslink_sound_icons_config_t sound_icons_config = {
+    .p_sound_icons     = sound_icons,
+    .sound_icons_count = sizeof(sound_icons) / sizeof(sound_icons[0]),
+    .default_length_ms = 1000,
+};
+
+const actionslink_event_handlers_t   event_handlers   = {};
+const actionslink_request_handlers_t request_handlers = {};
+
+actionslink_config_t scheduled_config()
+{
+    actionslink_config_t scheduled = make_config();
+    scheduled.p_sound_icons_config = &sound_icons_config;
+    return scheduled;
+}
+
+const actionslink_config_t config = scheduled_config();
+
+// The Bluetooth task before, every request is sent right away
+const actionslink_config_t legacy_config = make_config();
+
+void start(ChipSim &chip, const actionslink_config_t *p_config)
+{
+    ASSERT_TRUE(actionslink_sim::start(chip, p_config, &event_handlers, &request_handlers));
+}
+
+// Sleeps like the Bluetooth task, which wakes up when the next sound icon is due
+void run_until(ChipSim &chip, uint64_t until_us)
+{
+    while (chip.now_us() < until_us)
+    {
+        uint32_t due_ms  = actionslink_get_sound_icons_due_ms();
+        uint64_t wake_us = until_us;
+        if (due_ms != UINT32_MAX)
+        {
+            wake_us = std::min(until_us, chip.now_us() + std::max<uint64_t>(due_ms, 1) * MS);
+        }
+        chip.advance_us(wake_us - chip.now_us());
+        actionslink_tick();
+    }
+}
+
+void run_for(ChipSim &chip, uint64_t us)
+{
+    run_until(chip, chip.now_us() + us);
+}
+
+std::vector<McuMessage> requests_of(const ChipSim &chip, uint32_t tag)
+{
+    std::vector<McuMessage> requests;
+    for (const McuMessage &message : chip.received())
+    {
+        if ((message.payload_tag == ActionsLink_FromMcu_request_tag) && (message.tag == tag))
+        {
+            requests.push_back(message);
+        }
+    }
+    return requests;
+}
+
+std::vector<McuMessage> plays(const ChipSim &chip)
+{
+    return requests_of(chip, ActionsLink_FromMcuRequest_play_sound_icon_tag);
+}
+
+std::vector<McuMessage> stops(const ChipSim &chip)
+{
+    return requests_of(chip, ActionsLink_FromMcuRequest_stop_sound_icon_tag);
+}
+
+int request(actionslink_sound_icon_t sound_icon, bool after_current = false, bool loop_forever = false)
+{
+    return actionslink_request_sound_icon(sound_icon,
+                                          after_current ? ACTIONSLINK_SOUND_ICON_PLAYBACK_MODE_PLAY_AFTER_CURRENT
+                                                        : ACTIONSLINK_SOUND_ICON_PLAYBACK_MODE_PLAY_IMMEDIATELY,
+                                          loop_forever);
+}
+
+TEST(ActionslinkSoundIcons, WaitsForThePlayingOneByPriority)
+{
+    ChipSim chip({});
+    start(chip, &config);
+
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_CHARGING, true), 0);
+    run_for(chip, 100 * MS);
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_POSITIVE_FEEDBACK), 0);
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_BT_CONNECTED), 0);
+    // Only a request to play immediately interrupts one of lower priority
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_BATTERY_LOW, true), 0);
+    EXPECT_EQ(actionslink_get_current_sound_icon(nullptr), ACTIONSLINK_SOUND_ICON_CHARGING);
+    run_for(chip, 5000 * MS);
+
+    auto played = plays(chip);
+    ASSERT_EQ(played.size(), 4u);
+    EXPECT_EQ(played[0].value, (uint32_t) ActionsLink_Audio_SoundIcon_CHARGING);
+    EXPECT_EQ(played[1].value, (uint32_t) ActionsLink_Audio_SoundIcon_BATTERY_LOW);
+    EXPECT_EQ(played[2].value, (uint32_t) ActionsLink_Audio_SoundIcon_POSITIVE_FEEDBACK);
+    EXPECT_EQ(played[3].value, (uint32_t) ActionsLink_Audio_SoundIcon_BT_CONNECTED);
+    EXPECT_GE(played[1].at_us - played[0].at_us, 1440 * MS);
+    EXPECT_GE(played[2].at_us - played[1].at_us, 910 * MS);
+    EXPECT_GE(played[3].at_us - played[2].at_us, 180 * MS);
+    // Each one as soon as the one before is done
+    EXPECT_LT(played[3].at_us - played[0].at_us, (1440 + 910 + 180 + 3 * 10) * MS);
+    EXPECT_EQ(actionslink_get_current_sound_icon(nullptr), ACTIONSLINK_SOUND_ICON_NONE);
+}
+
+TEST(ActionslinkSoundIcons, MergesIdenticalPendingRequests)
+{
+    ChipSim chip({});
+    start(chip, &config);
+
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_BATTERY_LOW), 0);
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        run_for(chip, 50 * MS);
+        EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_POSITIVE_FEEDBACK), 0);
+    }
+    run_for(chip, 2000 * MS);
+
+    auto played = plays(chip);
+    ASSERT_EQ(played.size(), 2u);
+    EXPECT_EQ(played[1].value, (uint32_t) ActionsLink_Audio_SoundIcon_POSITIVE_FEEDBACK);
+
+    actionslink_sound_icons_stats_t stats;
+    actionslink_get_sound_icons_stats(&stats);
+    EXPECT_EQ(stats.requested, 6u);
+    EXPECT_EQ(stats.merged, 4u);
+    EXPECT_EQ(stats.played, 2u);
+    EXPECT_EQ(chip.stats().requests, 2u);
+}
+
+TEST(ActionslinkSoundIcons, PreemptsLessImportantOnes)
+{
+    ChipSim chip({});
+    start(chip, &config);
+
+    // A looping sound icon carries on after a more important one
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_BT_PAIRING, false, true), 0);
+    run_for(chip, 1000 * MS);
+    uint64_t feedback_us = chip.now_us();
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_POSITIVE_FEEDBACK), 0);
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_BT_PAIRING, false, true), 0);
+    run_for(chip, 1000 * MS);
+
+    auto played = plays(chip);
+    ASSERT_EQ(played.size(), 3u);
+    EXPECT_EQ(played[1].value, (uint32_t) ActionsLink_Audio_SoundIcon_POSITIVE_FEEDBACK);
+    EXPECT_LT(played[1].at_us - feedback_us, 10 * MS);
+    EXPECT_EQ(played[2].value, (uint32_t) ActionsLink_Audio_SoundIcon_BT_PAIRING);
+    EXPECT_GE(played[2].at_us - played[1].at_us, 180 * MS);
+    EXPECT_EQ(actionslink_get_current_sound_icon(nullptr), ACTIONSLINK_SOUND_ICON_BT_PAIRING);
+
+    // Another looping one of the same priority replaces it
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_MULTISPEAKER_CHAIN_SLAVE_PAIRING, false, true), 0);
+    run_for(chip, 10000 * MS);
+    played = plays(chip);
+    ASSERT_EQ(played.size(), 4u);
+    EXPECT_EQ(played[3].value, (uint32_t) ActionsLink_Audio_SoundIcon_MULTISPEAKER_CHAIN_PAIRING);
+    EXPECT_FALSE(actionslink_is_sound_icon_scheduled(ACTIONSLINK_SOUND_ICON_BT_PAIRING));
+
+    // Power off interrupts anything, what was waiting plays afterwards
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_BATTERY_LOW), 0);
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_CHARGING), 0);
+    uint64_t power_off_us = chip.now_us();
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_POWER_OFF), 0);
+    EXPECT_EQ(actionslink_get_current_sound_icon(nullptr), ACTIONSLINK_SOUND_ICON_POWER_OFF);
+    played = plays(chip);
+    ASSERT_EQ(played.size(), 6u);
+    EXPECT_EQ(played[5].value, (uint32_t) ActionsLink_Audio_SoundIcon_POWER_OFF);
+    EXPECT_LT(played[5].at_us - power_off_us, 10 * MS);
+
+    run_for(chip, 5000 * MS);
+    played = plays(chip);
+    ASSERT_EQ(played.size(), 8u);
+    EXPECT_EQ(played[6].value, (uint32_t) ActionsLink_Audio_SoundIcon_CHARGING);
+    EXPECT_EQ(played[7].value, (uint32_t) ActionsLink_Audio_SoundIcon_MULTISPEAKER_CHAIN_PAIRING);
+    EXPECT_GE(played[6].at_us - played[5].at_us, 1832 * MS);
+    EXPECT_TRUE(stops(chip).empty());
+
+    actionslink_sound_icons_stats_t stats;
+    actionslink_get_sound_icons_stats(&stats);
+    EXPECT_EQ(stats.preempted, 4u);
+    EXPECT_EQ(stats.merged, 1u);
+}
+
+// Both are critical, power off waits for the power on sound icon. The Bluetooth task keeps the amps unmuted until it's
+// played, which it finds out from what is scheduled.
+TEST(ActionslinkSoundIcons, PowerOffWaitsForPowerOn)
+{
+    ChipSim chip({});
+    start(chip, &config);
+
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_POWER_ON), 0);
+    run_for(chip, 500 * MS);
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_POWER_OFF), 0);
+    EXPECT_EQ(actionslink_get_current_sound_icon(nullptr), ACTIONSLINK_SOUND_ICON_POWER_ON);
+    EXPECT_TRUE(actionslink_is_sound_icon_scheduled(ACTIONSLINK_SOUND_ICON_POWER_OFF));
+    EXPECT_NEAR(actionslink_get_sound_icons_due_ms(), 1670 - 500, 10);
+
+    run_for(chip, 2000 * MS);
+    uint32_t played_ms = 0;
+    EXPECT_EQ(actionslink_get_current_sound_icon(&played_ms), ACTIONSLINK_SOUND_ICON_POWER_OFF);
+    EXPECT_LT(played_ms, 1832u);
+
+    auto played = plays(chip);
+    ASSERT_EQ(played.size(), 2u);
+    EXPECT_EQ(played[1].value, (uint32_t) ActionsLink_Audio_SoundIcon_POWER_OFF);
+    EXPECT_GE(played[1].at_us - played[0].at_us, 1670 * MS);
+    EXPECT_LT(played[1].at_us - played[0].at_us, (1670 + 10) * MS);
+}
+
+TEST(ActionslinkSoundIcons, CancelsPendingAndPlayingOnes)
+{
+    ChipSim chip({});
+    start(chip, &config);
+
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_BATTERY_LOW), 0);
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_CHARGING), 0);
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_POSITIVE_FEEDBACK), 0);
+    EXPECT_TRUE(actionslink_is_sound_icon_scheduled(ACTIONSLINK_SOUND_ICON_CHARGING));
+
+    // A pending one goes without a request to the chip
+    EXPECT_EQ(actionslink_cancel_sound_icon(ACTIONSLINK_SOUND_ICON_CHARGING), 0);
+    EXPECT_FALSE(actionslink_is_sound_icon_scheduled(ACTIONSLINK_SOUND_ICON_CHARGING));
+    EXPECT_EQ(chip.stats().requests, 1u);
+
+    // A playing one is stopped and the next one starts right away
+    run_for(chip, 100 * MS);
+    EXPECT_EQ(actionslink_cancel_sound_icon(ACTIONSLINK_SOUND_ICON_BATTERY_LOW), 0);
+    EXPECT_EQ(actionslink_get_current_sound_icon(nullptr), ACTIONSLINK_SOUND_ICON_POSITIVE_FEEDBACK);
+    ASSERT_EQ(stops(chip).size(), 1u);
+    EXPECT_EQ(stops(chip)[0].value, (uint32_t) ActionsLink_Audio_SoundIcon_BATTERY_LOW);
+    ASSERT_EQ(plays(chip).size(), 2u);
+    EXPECT_LT(plays(chip)[1].at_us - stops(chip)[0].at_us, 10 * MS);
+
+    // One that is done doesn't need a stop request
+    run_for(chip, 1000 * MS);
+    EXPECT_EQ(actionslink_cancel_sound_icon(ACTIONSLINK_SOUND_ICON_POSITIVE_FEEDBACK), 0);
+    EXPECT_EQ(stops(chip).size(), 1u);
+
+    // Everything at once
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_BT_PAIRING, false, true), 0);
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_CHARGING, true), 0);
+    EXPECT_EQ(request(ACTIONSLINK_SOUND_ICON_BT_CONNECTED, true), 0);
+    EXPECT_EQ(actionslink_cancel_sound_icon(ACTIONSLINK_SOUND_ICON_NONE), 0);
+    EXPECT_EQ(actionslink_get_current_sound_icon(nullptr), ACTIONSLINK_SOUND_ICON_NONE);
+    run_for(chip, 3000 * MS);
+    EXPECT_EQ(plays(chip).size(), 4u);
+    ASSERT_EQ(stops(chip).size(), 2u);
+    EXPECT_EQ(stops(chip)[1].value, (uint32_t) ActionsLink_Audio_SoundIcon_NONE);
+
+    actionslink_sound_icons_stats_t stats;
+    actionslink_get_sound_icons_stats(&stats);
+    EXPECT_EQ(stats.cancelled, 3u);
+    EXPECT_EQ(stats.stopped, 2u);
+}
+
+// UX events as the other tasks post them: volume feedback in bursts of key presses, and the other sound icons now and
+// then, often back to back with others, e.g. a charger plugged in as the battery runs low
+struct UxEvent
+{
+    uint64_t                 at_us;
+    actionslink_sound_icon_t sound_icon;
+    bool                     after_current;
+};
+
+struct Result
+{
+    std::vector<uint64_t> latencies_us;         // Event until its sound icon was started, 0 if it was playing
+    std::vector<uint64_t> warning_latencies_us; // Same for high priority sound icons
+    uint32_t              missed;               // Events whose sound icon wasn't started
+    uint32_t              warnings_cut_short;   // High priority sound icons interrupted by a less important one
+    uint32_t              requests;             // Requests sent to the chip
+};
+
+constexpr uint64_t UX_DURATION_US  = 600000000;
+constexpr uint64_t UX_EVENT_MEAN_US = 2000000;
+
+std::vector<UxEvent> random_ux_events(uint32_t seed)
+{
+    struct Kind
+    {
+        actionslink_sound_icon_t sound_icon;
+        bool                     after_current;
+        double                   weight;
+    };
+    const Kind kinds[] = {
+        {ACTIONSLINK_SOUND_ICON_POSITIVE_FEEDBACK, false, 6},
+        {ACTIONSLINK_SOUND_ICON_BATTERY_LOW, false, 2},
+        {ACTIONSLINK_SOUND_ICON_CHARGING, true, 1},
+        {ACTIONSLINK_SOUND_ICON_BT_CONNECTED, false, 1},
+        {ACTIONSLINK_SOUND_ICON_BT_DISCONNECTED, false, 1},
+    };
+
+    std::vector<double> weights;
+    for (const Kind &kind : kinds)
+    {
+        weights.push_back(kind.weight);
+    }
+
+    std::mt19937                            rng(seed);
+    std::exponential_distribution<double>   gap(1.0 / UX_EVENT_MEAN_US);
+    std::discrete_distribution<size_t>      kind_of(weights.begin(), weights.end());
+    std::uniform_int_distribution<uint32_t> presses(1, 6);
+    std::uniform_int_distribution<uint64_t> press_gap(60000, 150000);
+    std::uniform_int_distribution<uint64_t> back_to_back_gap(0, 20000);
+    std::bernoulli_distribution             back_to_back(0.3);
+
+    std::vector<UxEvent> events;
+    uint64_t             at_us = 0;
+    while (at_us < UX_DURATION_US)
+    {
+        const Kind &kind = kinds[kind_of(rng)];
+        uint32_t    count = (kind.sound_icon == ACTIONSLINK_SOUND_ICON_POSITIVE_FEEDBACK) ? presses(rng) : 1;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            events.push_back({at_us, kind.sound_icon, kind.after_current});
+            at_us += (i + 1 < count) ? press_gap(rng) : 0;
+        }
+        if (back_to_back(rng))
+        {
+            const Kind &other = kinds[kind_of(rng)];
+            at_us += back_to_back_gap(rng);
+            events.push_back({at_us, other.sound_icon, other.after_current});
+        }
+        at_us += (uint64_t) gap(rng);
+    }
+    return events;
+}
+
+const actionslink_sound_icon_info_t *info_of(actionslink_sound_icon_t sound_icon)
+{
+    for (const actionslink_sound_icon_info_t &info : sound_icons)
+    {
+        if (info.sound_icon == sound_icon)
+        {
+            return &info;
+        }
+    }
+    return nullptr;
+}
+
+bool is_warning(actionslink_sound_icon_t sound_icon)
+{
+    const actionslink_sound_icon_info_t *p_info = info_of(sound_icon);
+    return p_info && (p_info->priority >= ACTIONSLINK_SOUND_ICON_PRIORITY_HIGH);
+}
+
+uint32_t pb_of(actionslink_sound_icon_t sound_icon)
+{
+    switch (sound_icon)
+    {
+        case ACTIONSLINK_SOUND_ICON_POSITIVE_FEEDBACK:
+            return ActionsLink_Audio_SoundIcon_POSITIVE_FEEDBACK;
+        case ACTIONSLINK_SOUND_ICON_BATTERY_LOW:
+            return ActionsLink_Audio_SoundIcon_BATTERY_LOW;
+        case ACTIONSLINK_SOUND_ICON_CHARGING:
+            return ActionsLink_Audio_SoundIcon_CHARGING;
+        case ACTIONSLINK_SOUND_ICON_BT_CONNECTED:
+            return ActionsLink_Audio_SoundIcon_BT_CONNECTED;
+        case ACTIONSLINK_SOUND_ICON_BT_DISCONNECTED:
+            return ActionsLink_Audio_SoundIcon_BT_DISCONNECTED;
+        default:
+            return ActionsLink_Audio_SoundIcon_NONE;
+    }
+}
+
+uint64_t length_us(actionslink_sound_icon_t sound_icon)
+{
+    const actionslink_sound_icon_info_t *p_info = info_of(sound_icon);
+    return ((p_info && p_info->length_ms) ? p_info->length_ms : sound_icons_config.default_length_ms) * MS;
+}
+
+// The task handles the events one after the other, each as soon as it's posted and the one before is done
+Result run_ux(const std::vector<UxEvent> &events, const actionslink_config_t *p_config)
+{
+    ChipSim chip({});
+    start(chip, p_config);
+    const uint64_t start_us  = chip.now_us();
+    const bool     scheduled = p_config->p_sound_icons_config != nullptr;
+
+    for (const UxEvent &event : events)
+    {
+        run_until(chip, start_us + event.at_us);
+        EXPECT_EQ(request(event.sound_icon, event.after_current), 0);
+    }
+    run_for(chip, 10000 * MS);
+
+    auto                  played = plays(chip);
+    Result                result = {};
+    std::vector<uint64_t> started_us(events.size(), UINT64_MAX);
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        const uint64_t event_us   = start_us + events[i].at_us;
+        const uint32_t sound_icon = pb_of(events[i].sound_icon);
+        const uint64_t length     = length_us(events[i].sound_icon);
+        auto           playing    = std::find_if(played.begin(), played.end(), [&](const McuMessage &message) {
+            return (message.value == sound_icon) && (message.at_us <= event_us) && (event_us < message.at_us + length);
+        });
+        auto           it         = std::find_if(played.begin(), played.end(), [&](const McuMessage &message) {
+            return (message.value == sound_icon) && (message.at_us >= event_us);
+        });
+        if ((playing == played.end()) && (it == played.end()))
+        {
+            result.missed++;
+            continue;
+        }
+
+        uint64_t latency_us = 0;
+        if (playing == played.end())
+        {
+            started_us[i] = it->at_us;
+            latency_us    = it->at_us - event_us;
+        }
+        result.latencies_us.push_back(latency_us);
+        if (is_warning(events[i].sound_icon))
+        {
+            result.warning_latencies_us.push_back(latency_us);
+        }
+    }
+
+    // Requests to play after the current one never cut it short, with the scheduling any request might
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        if (!is_warning(events[i].sound_icon) || (started_us[i] == UINT64_MAX))
+        {
+            continue;
+        }
+        for (size_t j = 0; j < events.size(); j++)
+        {
+            if ((started_us[j] > started_us[i]) && (started_us[j] < started_us[i] + length_us(events[i].sound_icon)) &&
+                !is_warning(events[j].sound_icon) && (scheduled || !events[j].after_current))
+            {
+                result.warnings_cut_short++;
+                break;
+            }
+        }
+    }
+
+    result.requests = chip.stats().requests;
+    std::sort(result.latencies_us.begin(), result.latencies_us.end());
+    std::sort(result.warning_latencies_us.begin(), result.warning_latencies_us.end());
+    return result;
+}
+
+void report(const char *name, const Result &result)
+{
+    printf("%-11s all [ms] p50 %6.1f p99 %7.1f  warnings [ms] p50 %5.1f p99 %5.1f max %5.1f  cut short %3u  "
+           "requests %4u  missed %u\r\n",
+           name, percentile(result.latencies_us, 0.5) / 1e3, percentile(result.latencies_us, 0.99) / 1e3,
+           percentile(result.warning_latencies_us, 0.5) / 1e3, percentile(result.warning_latencies_us, 0.99) / 1e3,
+           result.warning_latencies_us.back() / 1e3, result.warnings_cut_short, result.requests, result.missed);
+}
+
+TEST(ActionslinkSoundIcons, UxEventToSoundIconLatency)
+{
+    const auto events    = random_ux_events(50);
+    const auto legacy    = run_ux(events, &legacy_config);
+    const auto scheduled = run_ux(events, &config);
+    report("before", legacy);
+    report("scheduled", scheduled);
+
+    EXPECT_EQ(legacy.missed, 0u);
+    EXPECT_EQ(scheduled.missed, 0u);
+    EXPECT_GT(legacy.warnings_cut_short, 0u);
+    EXPECT_EQ(scheduled.warnings_cut_short, 0u);
+    EXPECT_LE(percentile(scheduled.warning_latencies_us, 0.99), percentile(legacy.warning_latencies_us, 0.99));
+    EXPECT_LT(scheduled.requests, legacy.requests);
+}
+
+} // namespace
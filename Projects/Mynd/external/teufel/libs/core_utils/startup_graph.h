@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// One step of a startup sequence
+struct StartupStep
+{
+    const char *name;
+    uint32_t    prerequisites; // mask of the steps which have to be completed before this one starts
+    uint32_t    timeout_ms;    // longest wait for the completion signal of this step, 0 if it doesn't wait
+};
+
+// Dependency graph of a startup sequence. Steps are identified by their index in the step table and complete once,
+// either by their completion signal or by their timeout. Completion times are recorded, so that the critical path,
+// the chain of steps which delayed the last one, can be reported afterwards.
+//
+// The graph itself doesn't wait for anything. Steps run in the tasks they belong to and complete the graph from
+// there, access from several tasks has to be serialized by the caller.
+template <typename Step, std::size_t N>
+class StartupGraph
+{
+    static_assert(N <= 32, "Steps are tracked in a 32 bit mask");
+
+  public:
+    explicit constexpr StartupGraph(const StartupStep (&steps)[N])
+      : m_steps(steps)
+    {
+    }
+
+    static constexpr uint32_t mask(Step step) { return 1u << static_cast<std::size_t>(step); }
+
+    template <typename... Steps>
+    static constexpr uint32_t mask(Step step, Steps... steps)
+    {
+        return mask(step) | mask(steps...);
+    }
+
+    const StartupStep &step(Step step) const { return m_steps[index(step)]; }
+
+    void start(Step step, uint32_t now_ms) { m_start_ms[index(step)] = now_ms; }
+
+    // Returns false if the step was already completed
+    bool complete(Step step, uint32_t now_ms, bool timed_out = false)
+    {
+        if (is_done(step))
+            return false;
+
+        m_done_ms[index(step)] = now_ms;
+        m_done |= mask(step);
+        if (timed_out)
+            m_timed_out |= mask(step);
+        return true;
+    }
+
+    bool is_done(Step step) const { return (m_done & mask(step)) != 0; }
+
+    bool has_timed_out(Step step) const { return (m_timed_out & mask(step)) != 0; }
+
+    // Prerequisites of a step which aren't completed yet
+    uint32_t missing(Step step) const { return m_steps[index(step)].prerequisites & ~m_done; }
+
+    bool is_ready(Step step) const { return missing(step) == 0; }
+
+    uint32_t start_ms(Step step) const { return m_start_ms[index(step)]; }
+
+    uint32_t done_ms(Step step) const { return m_done_ms[index(step)]; }
+
+    /**
+     * @brief Follows the prerequisites which completed last back from the given step.
+     *
+     * @param[in] last              step the path ends with
+     * @param[out] p_path           steps of the path, the first step of the startup first
+     * @param[in] max_length        capacity of p_path
+     *
+     * @return number of steps in the path
+     */
+    std::size_t critical_path(Step last, Step *p_path, std::size_t max_length) const
+    {
+        std::size_t length = 0;
+        Step        step   = last;
+
+        while (length < max_length)
+        {
+            p_path[length++] = step;
+
+            uint32_t    prerequisites = m_steps[index(step)].prerequisites & m_done;
+            bool        found         = false;
+            std::size_t latest        = 0;
+            for (std::size_t i = 0; i < N; i++)
+            {
+                if ((prerequisites & (1u << i)) && (!found || m_done_ms[i] >= m_done_ms[latest]))
+                {
+                    latest = i;
+                    found  = true;
+                }
+            }
+
+            if (!found)
+                break;
+            step = static_cast<Step>(latest);
+        }
+
+        for (std::size_t i = 0; i < length / 2; i++)
+        {
+            Step tmp               = p_path[i];
+            p_path[i]              = p_path[length - 1 - i];
+            p_path[length - 1 - i] = tmp;
+        }
+
+        return length;
+    }
+
+  private:
+    static constexpr std::size_t index(Step step) { return static_cast<std::size_t>(step); }
+
+    const StartupStep (&m_steps)[N];
+    uint32_t           m_done        = 0;
+    uint32_t           m_timed_out   = 0;
+    uint32_t           m_start_ms[N] = {};
+    uint32_t           m_done_ms[N]  = {};
+};
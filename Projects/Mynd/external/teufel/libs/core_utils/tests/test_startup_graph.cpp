@@ -0,0 +1,251 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "src/tasks/startup_steps.h"
+
+// Startup of the Mynd application from reset to the power on sound icon, powered on by the power button. The step
+// table is the one of the application, the previous sequence is the one with fixed delays it replaced.
+using Teufel::Task::Startup::Graph;
+using Teufel::Task::Startup::Step;
+using Teufel::Task::Startup::steps;
+
+constexpr std::size_t STEPS = static_cast<std::size_t>(Step::Count);
+
+// clang-format off
+// Tasks started one after the other, the BT chip only booted after the amps were enabled
+static const StartupStep sequential_steps[] = {
+    {"power decision",      0,                                                 0},
+    {"audio init",          Graph::mask(Step::PowerDecision),                  0},
+    {"PD ready",            Graph::mask(Step::AudioInit),                      UINT32_MAX},
+    {"battery",             Graph::mask(Step::PdReady),                        0},
+    {"BT init",             Graph::mask(Step::Battery),                        0},
+    {"BT chip ready",       Graph::mask(Step::BtInit, Step::AmpsEnabled),      UINT32_MAX},
+    {"amps enabled",        Graph::mask(Step::Battery, Step::BtInit),          0},
+    {"BT power on",         Graph::mask(Step::BtChipReady),                    UINT32_MAX},
+    {"amps configured",     Graph::mask(Step::BtPowerOn),                      0},
+    {"power on sound icon", Graph::mask(Step::AmpsConfigured),                 0},
+};
+// clang-format on
+
+// Fake peripherals, times in ms
+struct Peripherals
+{
+    uint32_t pd_firmware_loaded = 1100; // since reset, UINT32_MAX if never
+    uint32_t bt_boot            = 850;  // from power to ready
+    uint32_t bt_power_on        = 350;  // from the power on request to the audio source
+};
+
+enum class Task
+{
+    System,
+    Audio,
+    Bluetooth,
+};
+
+struct SimStep
+{
+    Step     step;
+    Task     task;
+    uint32_t work_ms; // fixed delays and work before the completion signal is waited for
+    // Time of the completion signal for the given time the wait starts, nullptr if there's nothing to wait for
+    std::function<uint32_t(const Graph &, uint32_t)> signal;
+};
+
+// Steps of each task run in the given order, a step starts once its task is free and its prerequisites are done
+static uint32_t simulate(Graph &graph, const std::vector<SimStep> &sim_steps)
+{
+    uint32_t         task_free_ms[3] = {};
+    std::vector<int> done(sim_steps.size(), 0);
+
+    for (bool progress = true; progress;)
+    {
+        progress = false;
+        for (std::size_t i = 0; i < sim_steps.size(); i++)
+        {
+            const SimStep &s = sim_steps[i];
+
+            bool earlier_pending = false;
+            for (std::size_t j = 0; j < i; j++)
+                earlier_pending |= (sim_steps[j].task == s.task) && !done[j];
+            if (done[i] || earlier_pending || !graph.is_ready(s.step))
+                continue;
+
+            uint32_t start = task_free_ms[static_cast<int>(s.task)];
+            for (std::size_t p = 0; p < STEPS; p++)
+            {
+                if (graph.step(s.step).prerequisites & (1u << p))
+                    start = std::max(start, graph.done_ms(static_cast<Step>(p)));
+            }
+            graph.start(s.step, start);
+
+            uint32_t end       = start + s.work_ms;
+            bool     timed_out = false;
+            if (s.signal)
+            {
+                uint32_t signal  = s.signal(graph, end);
+                uint32_t timeout = graph.step(s.step).timeout_ms;
+                if (signal - end > timeout)
+                {
+                    end += timeout;
+                    timed_out = true;
+                }
+                else
+                {
+                    end = std::max(end, signal);
+                }
+            }
+
+            graph.complete(s.step, end, timed_out);
+            task_free_ms[static_cast<int>(s.task)] = end;
+            done[i]                                = 1;
+            progress                               = true;
+        }
+    }
+
+    return graph.done_ms(Step::PowerOnSoundIcon);
+}
+
+// The power button is checked 500 ms after reset
+static std::vector<SimStep> event_driven_sequence(const Peripherals &hw)
+{
+    return {
+        {Step::PowerDecision, Task::System, 500, nullptr},
+        {Step::AudioInit, Task::Audio, 20, nullptr},
+        {Step::PdReady, Task::Audio, 0, [hw](const Graph &, uint32_t t) { return std::max(t, hw.pd_firmware_loaded); }},
+        {Step::Battery, Task::Audio, 60, nullptr},
+        {Step::AmpsEnabled, Task::Audio, 15, nullptr},
+        {Step::AmpsConfigured, Task::Audio, 40, nullptr},
+        {Step::BtInit, Task::Bluetooth, 5, nullptr},
+        {Step::BtChipReady, Task::Bluetooth, 0, [hw](const Graph &, uint32_t t) { return t + hw.bt_boot; }},
+        // Power on is requested 200 ms after the chip got ready at the earliest
+        {Step::BtPowerOn, Task::Bluetooth, 0,
+         [hw](const Graph &g, uint32_t t)
+         { return std::max(t, g.done_ms(Step::BtChipReady) + 200) + hw.bt_power_on; }},
+        {Step::PowerOnSoundIcon, Task::System, 0, nullptr},
+    };
+}
+
+static std::vector<SimStep> sequential_sequence(const Peripherals &hw)
+{
+    return {
+        {Step::PowerDecision, Task::System, 500, nullptr},
+        {Step::AudioInit, Task::Audio, 20, nullptr},
+        // Fixed 1 s for the PD firmware, then polled
+        {Step::PdReady, Task::Audio, 1000, [hw](const Graph &, uint32_t t) { return std::max(t, hw.pd_firmware_loaded); }},
+        {Step::Battery, Task::Audio, 60, nullptr},
+        {Step::AmpsEnabled, Task::Audio, 15, nullptr},
+        {Step::AmpsConfigured, Task::Audio, 40, nullptr},
+        {Step::BtInit, Task::Bluetooth, 5, nullptr},
+        {Step::BtChipReady, Task::Bluetooth, 0, [hw](const Graph &, uint32_t t) { return t + hw.bt_boot; }},
+        // Fixed 200 ms after the chip got ready
+        {Step::BtPowerOn, Task::Bluetooth, 200, [hw](const Graph &, uint32_t t) { return t + hw.bt_power_on; }},
+        {Step::PowerOnSoundIcon, Task::System, 0, nullptr},
+    };
+}
+
+static void print_report(const char *name, const Graph &graph)
+{
+    Step        path[STEPS];
+    std::size_t length = graph.critical_path(Step::PowerOnSoundIcon, path, STEPS);
+
+    printf("%s: %u ms to the power on sound icon, critical path:\r\n", name, graph.done_ms(Step::PowerOnSoundIcon));
+    for (std::size_t i = 0; i < length; i++)
+    {
+        printf("  %-20s %5u .. %5u ms%s\r\n", graph.step(path[i]).name, graph.start_ms(path[i]),
+               graph.done_ms(path[i]), graph.has_timed_out(path[i]) ? " (timed out)" : "");
+    }
+}
+
+TEST(StartupGraphTest, PrerequisitesAndCompletion)
+{
+    Graph graph{steps};
+
+    ASSERT_TRUE(graph.is_ready(Step::PowerDecision));
+    ASSERT_FALSE(graph.is_ready(Step::AudioInit));
+    ASSERT_EQ(graph.missing(Step::BtPowerOn), Graph::mask(Step::BtChipReady, Step::AmpsEnabled));
+
+    ASSERT_TRUE(graph.complete(Step::PowerDecision, 500));
+    ASSERT_TRUE(graph.is_ready(Step::AudioInit));
+    ASSERT_TRUE(graph.is_ready(Step::BtInit));
+
+    // Steps complete once, e.g. not again on the next power on
+    ASSERT_FALSE(graph.complete(Step::PowerDecision, 9000));
+    ASSERT_EQ(graph.done_ms(Step::PowerDecision), 500u);
+}
+
+TEST(StartupGraphTest, CriticalPathFollowsLatestPrerequisite)
+{
+    Graph graph{steps};
+    Step  path[STEPS];
+
+    graph.complete(Step::PowerDecision, 0);
+    graph.complete(Step::BtInit, 5);
+    graph.complete(Step::BtChipReady, 900);
+    graph.complete(Step::AudioInit, 20);
+    graph.complete(Step::PdReady, 1100);
+    graph.complete(Step::Battery, 1160);
+    graph.complete(Step::AmpsEnabled, 1175);
+    graph.complete(Step::BtPowerOn, 1500);
+
+    const Step expected[] = {Step::PowerDecision, Step::AudioInit, Step::PdReady,
+                             Step::Battery,       Step::AmpsEnabled, Step::BtPowerOn};
+    ASSERT_EQ(graph.critical_path(Step::BtPowerOn, path, STEPS), sizeof(expected) / sizeof(expected[0]));
+    for (std::size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++)
+        EXPECT_EQ(path[i], expected[i]);
+
+    // Bounded by the capacity, still ending with the given step
+    ASSERT_EQ(graph.critical_path(Step::BtPowerOn, path, 2), 2u);
+    EXPECT_EQ(path[0], Step::AmpsEnabled);
+    EXPECT_EQ(path[1], Step::BtPowerOn);
+}
+
+TEST(StartupGraphTest, SimulatedBootToSound)
+{
+    Peripherals hw;
+
+    Graph    sequential{sequential_steps};
+    uint32_t sequential_ms = simulate(sequential, sequential_sequence(hw));
+    print_report("sequential", sequential);
+
+    Graph    event_driven{steps};
+    uint32_t event_driven_ms = simulate(event_driven, event_driven_sequence(hw));
+    print_report("event driven", event_driven);
+
+    ASSERT_TRUE(sequential.is_done(Step::PowerOnSoundIcon));
+    ASSERT_TRUE(event_driven.is_done(Step::PowerOnSoundIcon));
+
+    // The BT chip boots while the PD controller loads its firmware
+    EXPECT_LT(event_driven.start_ms(Step::BtChipReady), event_driven.done_ms(Step::PdReady));
+    EXPECT_EQ(event_driven.done_ms(Step::PdReady), hw.pd_firmware_loaded);
+    EXPECT_LT(event_driven_ms + 1000, sequential_ms);
+
+    // With these peripherals the BT chip is the critical path, not the PD controller anymore
+    Step        path[STEPS];
+    std::size_t length = event_driven.critical_path(Step::PowerOnSoundIcon, path, STEPS);
+    for (std::size_t i = 0; i < length; i++)
+        EXPECT_NE(path[i], Step::PdReady);
+
+    length = sequential.critical_path(Step::PowerOnSoundIcon, path, STEPS);
+    EXPECT_NE(std::find(path, path + length, Step::PdReady), path + length);
+}
+
+TEST(StartupGraphTest, SimulatedPdControllerNeverReady)
+{
+    Peripherals hw;
+    hw.pd_firmware_loaded = UINT32_MAX;
+
+    // The startup carries on after the timeout instead of hanging
+    Graph    graph{steps};
+    uint32_t total_ms = simulate(graph, event_driven_sequence(hw));
+    print_report("PD never ready", graph);
+
+    ASSERT_TRUE(graph.is_done(Step::PowerOnSoundIcon));
+    EXPECT_TRUE(graph.has_timed_out(Step::PdReady));
+    EXPECT_FALSE(graph.has_timed_out(Step::BtChipReady));
+    EXPECT_EQ(graph.done_ms(Step::PdReady), graph.start_ms(Step::PdReady) + 5000);
+    EXPECT_GT(total_ms, 5000u);
+}
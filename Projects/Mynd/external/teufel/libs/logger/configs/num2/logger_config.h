@@ -8,13 +8,15 @@
 // Logger w/FreeRTOS configuration
 // - Add FreeRTOS must be defined as compile-time definitions of the build
 // - The Client must define LOGGER_USE_EXTERNAL_THREAD flag from the build system
-// - The Client must call logger_init function to explicitly pass stream buffer handle
+// - The Client must call logger_init function to explicitly pass the log ring storage
 // ---------------------------------------------------------------------------------
 
 #if defined(FreeRTOS) && defined(LOGGER_USE_EXTERNAL_THREAD)
-#define LOGGER_MUTEX_LOCK_TIMEOUT_MS                10u
+// Space reserved in the log ring for one line, the unused part is handed back once the line is formatted
+#define LOGGER_RECORD_SIZE                          (LOGGER_FORMATTING_BUFFER_SIZE + 64u)
 
-#define LOGGER_STREAM_BUFFER_TIMEOUT_MS             0u
+// Task notification index the logger task waits on for new lines
+#define LOGGER_NOTIFICATION_INDEX                   1u
 #endif
 
 // Choose one of the backends defined above
@@ -1,30 +1,56 @@
 #pragma once
+#include <stddef.h>
 #include <stdint.h>
 
+#include "logger_ring.h"
+
 #if defined(__cplusplus)
 extern "C"
 {
 #endif
 
+#if defined(FreeRTOS) && defined(LOGGER_USE_EXTERNAL_THREAD)
+
 /**
  * @brief Initializes the logger.
+ * @param p_storage log ring storage, 4-byte aligned
+ * @param size power of two, see logger_ring_init()
+ * @return 0 on success, -1 otherwise
  */
-#if defined(FreeRTOS) && defined(LOGGER_USE_EXTERNAL_THREAD)
-
-#include "FreeRTOS.h"
-#include "semphr.h"
-#include "stream_buffer.h"
+int logger_init(uint8_t *p_storage, size_t size);
 
-int logger_init(StreamBufferHandle_t sbuf);
+/**
+ * @brief Blocks until log lines are available and copies up to max_length bytes of them, logger task only.
+ * @return number of bytes copied to p_data
+ */
+size_t logger_receive(uint8_t *p_data, size_t max_length);
 #else
+/**
+ * @brief Initializes the logger.
+ */
 void logger_init(void);
 #endif
 
+/**
+ * @brief One log line while it is being formatted.
+ */
+typedef struct
+{
+    logger_ring_slot_t slot;
+    uint32_t           length;
+} logger_record_t;
+
 /**
  * @brief Flushes the logger.
  */
 void logger_flush(void);
 
+/**
+ * @brief Gets the number of log bytes dropped because the output buffer was full.
+ * @return total count since start-up, wraps around
+ */
+uint32_t logger_get_dropped_bytes(void);
+
 /**
  * @brief Gets a system timestamp.
  * @return timestamp
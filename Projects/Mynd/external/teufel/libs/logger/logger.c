@@ -10,7 +10,7 @@
 #error "Logger formatting buffer must have a size of at least 32 bytes"
 #endif
 
-#if LOGGER_USE_STATIC_FORMATTING_BUFFER == 1
+#if LOGGER_USE_STATIC_FORMATTING_BUFFER == 1 && !(defined(FreeRTOS) && defined(LOGGER_USE_EXTERNAL_THREAD))
 static char logger_buffer[LOGGER_FORMATTING_BUFFER_SIZE];
 #endif
 
@@ -31,239 +31,239 @@ static const char *const logger_log_color_strings[8] = {
     [LOG_LEVEL_TRACE]     = LOG_TRACE_COLOR,
 };
 
-static void print_buffer(char *p_data, size_t length);
+static int  print_formatted(logger_record_t *p_record, size_t max_length, const char *format_string, ...);
+static int  vprint_formatted(logger_record_t *p_record, size_t max_length, const char *format_string, va_list vArgs);
 static void print_encoding_error(void);
 static void print_buffer_full_error(void);
 
 #if defined(FreeRTOS) && defined(LOGGER_USE_EXTERNAL_THREAD)
 
 #include "FreeRTOS.h"
-#include "semphr.h"
-#include "stream_buffer.h"
+#include "task.h"
 
-static StreamBufferHandle_t sbuffer_logger_h = NULL;
-static SemaphoreHandle_t    mutex;
+#if LOGGER_RECORD_SIZE < LOGGER_FORMATTING_BUFFER_SIZE
+#error "Logger record must have room for at least one formatting buffer"
+#endif
+
+static logger_ring_t         ring;
+static volatile TaskHandle_t consumer_task_h = NULL;
+static volatile uint32_t     dropped_bytes   = 0;
 
-int logger_init(StreamBufferHandle_t sbuf)
+static inline uint32_t get_ipsr(void)
 {
-    if (!sbuf)
-        return -1;
+    uint32_t IPSR_register = 0U;
 
-    sbuffer_logger_h = sbuf;
-#if defined(configSUPPORT_DYNAMIC_ALLOCATION) && (configSUPPORT_DYNAMIC_ALLOCATION == 1)
-    mutex            = xSemaphoreCreateMutex();
-#else
-    static StaticSemaphore_t mutex_buffer;
-    mutex = xSemaphoreCreateMutexStatic(&mutex_buffer);
-#endif
-    if (mutex == NULL)
-    {
-        return -1;
-    }
+    __asm volatile("MRS %0, ipsr" : "=r"(IPSR_register));
 
-    return 0;
+    return IPSR_register;
 }
-#endif
 
-int logger_internal_lock(void)
+int logger_init(uint8_t *p_storage, size_t size)
 {
-#if defined(FreeRTOS) && defined(LOGGER_USE_EXTERNAL_THREAD)
-    uint32_t IPSR_register = 0U;
+    if (!p_storage)
+        return -1;
 
-    __asm volatile("MRS %0, ipsr" : "=r"(IPSR_register));
+    return logger_ring_init(&ring, p_storage, size);
+}
 
-    if (0U == IPSR_register)
-    {
-        if (xSemaphoreTake(mutex, pdMS_TO_TICKS(LOGGER_MUTEX_LOCK_TIMEOUT_MS)) != pdTRUE)
-        {
-            return -1;
-        }
-    }
-    else
+size_t logger_receive(uint8_t *p_data, size_t max_length)
+{
+    consumer_task_h = xTaskGetCurrentTaskHandle();
+
+    for (;;)
     {
-        if (xSemaphoreTakeFromISR(mutex, NULL) != pdTRUE)
+        size_t length = logger_ring_read(&ring, p_data, max_length);
+        if (length != 0)
         {
-            return -1;
+            return length;
         }
+
+        // Every committed line notifies, a line committed after the read above is not missed
+        ulTaskNotifyTakeIndexed(LOGGER_NOTIFICATION_INDEX, pdTRUE, portMAX_DELAY);
     }
-#endif
-    return 0;
 }
+#endif
 
-void logger_internal_unlock(void)
+uint32_t logger_get_dropped_bytes(void)
 {
 #if defined(FreeRTOS) && defined(LOGGER_USE_EXTERNAL_THREAD)
+    return dropped_bytes;
+#else
+    return 0;
+#endif
+}
 
-    uint32_t IPSR_register = 0U;
-
-    __asm volatile("MRS %0, ipsr" : "=r"(IPSR_register));
+int logger_internal_begin(logger_record_t *p_record)
+{
+    p_record->length = 0;
 
-    if (0U == IPSR_register)
-    {
-        xSemaphoreGive(mutex);
-    }
-    else
+#if defined(FreeRTOS) && defined(LOGGER_USE_EXTERNAL_THREAD)
+    // The line is formatted straight into its slot in the ring. Without room for it, the line is
+    // still formatted without output to count the bytes that were dropped.
+    if (logger_ring_reserve(&ring, &p_record->slot, LOGGER_RECORD_SIZE) != 0)
     {
-        xSemaphoreGiveFromISR(mutex, NULL);
+        p_record->slot.p_data   = NULL;
+        p_record->slot.capacity = 0;
     }
-
 #endif
+    return 0;
 }
 
-void logger_internal_print_color(logger_log_level_t level)
+void logger_internal_end(logger_record_t *p_record)
 {
-#if LOGGER_USE_STATIC_FORMATTING_BUFFER == 0
-    char logger_buffer[LOGGER_FORMATTING_BUFFER_SIZE];
-#endif
+#if defined(FreeRTOS) && defined(LOGGER_USE_EXTERNAL_THREAD)
+    uint32_t IPSR_register = get_ipsr();
 
-    int string_length = snprintf(logger_buffer, LOGGER_FORMATTING_BUFFER_SIZE, "%s", logger_log_color_strings[level]);
-    if (string_length >= 0)
+    if (p_record->slot.p_data != NULL)
     {
-        print_buffer(logger_buffer, string_length);
+        logger_ring_commit(&ring, &p_record->slot, p_record->length);
+
+        TaskHandle_t task_h = consumer_task_h;
+        if (task_h != NULL)
+        {
+            if (0U == IPSR_register)
+                xTaskNotifyGiveIndexed(task_h, LOGGER_NOTIFICATION_INDEX);
+            else
+                vTaskNotifyGiveIndexedFromISR(task_h, LOGGER_NOTIFICATION_INDEX, NULL);
+        }
+    }
+    // Not much to do about a full ring, the drain task reports the count in the output
+    else if (0U == IPSR_register)
+    {
+        taskENTER_CRITICAL();
+        dropped_bytes += p_record->length;
+        taskEXIT_CRITICAL();
     }
     else
     {
-        print_encoding_error();
+        UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+        dropped_bytes += p_record->length;
+        taskEXIT_CRITICAL_FROM_ISR(mask);
     }
+#else
+    (void) p_record;
+#endif
 }
 
-void logger_internal_reset_color(void)
+void logger_internal_print_color(logger_record_t *p_record, logger_log_level_t level)
 {
-#if LOGGER_USE_STATIC_FORMATTING_BUFFER == 0
-    char logger_buffer[LOGGER_FORMATTING_BUFFER_SIZE];
-#endif
-
-    print_buffer(LOG_COLOR_DEFAULT, strlen(LOG_COLOR_DEFAULT));
+    print_formatted(p_record, LOGGER_FORMATTING_BUFFER_SIZE, "%s", logger_log_color_strings[level]);
 }
 
-void logger_internal_print_log_level(logger_log_level_t level)
+void logger_internal_reset_color(logger_record_t *p_record)
 {
-#if LOGGER_USE_STATIC_FORMATTING_BUFFER == 0
-    char logger_buffer[LOGGER_FORMATTING_BUFFER_SIZE];
-#endif
-
-    int string_length =
-        snprintf(logger_buffer, LOGGER_FORMATTING_BUFFER_SIZE, "[%-5s] ", logger_log_level_strings[level]);
-    if (string_length >= 0)
-    {
-        print_buffer(logger_buffer, string_length);
-    }
-    else
-    {
-        print_encoding_error();
-    }
+    print_formatted(p_record, LOGGER_FORMATTING_BUFFER_SIZE, "%s", LOG_COLOR_DEFAULT);
 }
 
-void logger_internal_print_timestamp(void)
+void logger_internal_print_log_level(logger_record_t *p_record, logger_log_level_t level)
 {
-#if LOGGER_USE_STATIC_FORMATTING_BUFFER == 0
-    char logger_buffer[LOGGER_FORMATTING_BUFFER_SIZE];
-#endif
-
-    int string_length = snprintf(logger_buffer, LOGGER_FORMATTING_BUFFER_SIZE, "T%08lu: ", logger_get_timestamp());
-    if (string_length >= 0)
-    {
-        print_buffer(logger_buffer, string_length);
-    }
-    else
-    {
-        print_encoding_error();
-    }
+    print_formatted(p_record, LOGGER_FORMATTING_BUFFER_SIZE, "[%-5s] ", logger_log_level_strings[level]);
 }
 
-void logger_internal_print_log_location(const char *module_name, size_t line_number, uint8_t module_name_string_width)
+void logger_internal_print_timestamp(logger_record_t *p_record)
 {
-#if LOGGER_USE_STATIC_FORMATTING_BUFFER == 0
-    char logger_buffer[LOGGER_FORMATTING_BUFFER_SIZE];
-#endif
+    print_formatted(p_record, LOGGER_FORMATTING_BUFFER_SIZE, "T%08lu: ", logger_get_timestamp());
+}
 
-    int string_length = snprintf(logger_buffer, LOGGER_FORMATTING_BUFFER_SIZE, "%s:", module_name);
-    if (string_length >= 0)
-    {
-        print_buffer(logger_buffer, string_length);
-    }
-    else
-    {
-        print_encoding_error();
-    }
+void logger_internal_print_log_location(logger_record_t *p_record, const char *module_name, size_t line_number,
+                                        uint8_t module_name_string_width)
+{
+    int string_length = print_formatted(p_record, LOGGER_FORMATTING_BUFFER_SIZE, "%s:", module_name);
 
     // Negative numbers are handled fine, printf will just not add any trailing spaces
     // This keeps the log aligned to the right of the log location
     int string_width = module_name_string_width - string_length;
 
-    string_length = snprintf(logger_buffer, LOGGER_FORMATTING_BUFFER_SIZE, "%-*u ", string_width, line_number);
-    if (string_length >= 0)
-    {
-        print_buffer(logger_buffer, string_length);
-    }
-    else
+    print_formatted(p_record, LOGGER_FORMATTING_BUFFER_SIZE, "%-*u ", string_width, line_number);
+}
+
+void logger_internal_print_log(logger_record_t *p_record, const char *format_string, ...)
+{
+    va_list vArgs;
+
+    va_start(vArgs, format_string);
+    int string_length = vprint_formatted(p_record, LOGGER_FORMATTING_BUFFER_SIZE, format_string, vArgs);
+    va_end(vArgs);
+
+    if (string_length >= LOGGER_FORMATTING_BUFFER_SIZE)
     {
-        print_encoding_error();
+        print_buffer_full_error();
     }
 }
 
-void logger_internal_print_log(const char *format_string, ...)
+void logger_internal_print_new_line(logger_record_t *p_record, const char *new_line_string)
+{
+    print_formatted(p_record, LOGGER_FORMATTING_BUFFER_SIZE, "%s", new_line_string);
+}
+
+static int print_formatted(logger_record_t *p_record, size_t max_length, const char *format_string, ...)
 {
-#if LOGGER_USE_STATIC_FORMATTING_BUFFER == 0
-    char logger_buffer[LOGGER_FORMATTING_BUFFER_SIZE];
-#endif
     va_list vArgs;
 
     va_start(vArgs, format_string);
-    int string_length = vsnprintf(logger_buffer, LOGGER_FORMATTING_BUFFER_SIZE, format_string, vArgs);
+    int string_length = vprint_formatted(p_record, max_length, format_string, vArgs);
     va_end(vArgs);
 
-    if (string_length >= 0)
+    return string_length;
+}
+
+/**
+ * @brief Formats up to max_length - 1 characters into the record.
+ * @return length of the complete formatted string, which may exceed what was printed
+ */
+static int vprint_formatted(logger_record_t *p_record, size_t max_length, const char *format_string, va_list vArgs)
+{
+#if defined(FreeRTOS) && defined(LOGGER_USE_EXTERNAL_THREAD)
+    char  *p_data     = NULL;
+    size_t free_space = 0;
+
+    if (p_record->slot.p_data != NULL)
     {
-        print_buffer(logger_buffer, string_length);
-        if (string_length > LOGGER_FORMATTING_BUFFER_SIZE)
+        p_data     = p_record->slot.p_data + p_record->length;
+        free_space = p_record->slot.capacity - p_record->length;
+        if (free_space > max_length)
         {
-            print_buffer_full_error();
+            free_space = max_length;
         }
     }
-    else
+
+    int string_length = vsnprintf(p_data, free_space, format_string, vArgs);
+    if (string_length < 0)
     {
         print_encoding_error();
     }
-}
+    else if (p_data == NULL || (size_t) string_length < free_space)
+    {
+        p_record->length += string_length;
+    }
+    else if (free_space > 0)
+    {
+        p_record->length += free_space - 1;
+    }
 
-void logger_internal_print_new_line(const char *new_line_string)
-{
+    return string_length;
+#else
 #if LOGGER_USE_STATIC_FORMATTING_BUFFER == 0
     char logger_buffer[LOGGER_FORMATTING_BUFFER_SIZE];
 #endif
+    (void) p_record;
 
-    int string_length = snprintf(logger_buffer, LOGGER_FORMATTING_BUFFER_SIZE, "%s", new_line_string);
+    if (max_length > LOGGER_FORMATTING_BUFFER_SIZE)
+    {
+        max_length = LOGGER_FORMATTING_BUFFER_SIZE;
+    }
+
+    int string_length = vsnprintf(logger_buffer, max_length, format_string, vArgs);
     if (string_length >= 0)
     {
-        print_buffer(logger_buffer, string_length);
+        printf("%s", logger_buffer);
     }
     else
     {
         print_encoding_error();
     }
-}
 
-static void print_buffer(char *p_data, size_t length)
-{
-#if defined(FreeRTOS) && defined(LOGGER_USE_EXTERNAL_THREAD)
-
-    uint32_t IPSR_register = 0U;
-
-    __asm volatile("MRS %0, ipsr" : "=r"(IPSR_register));
-
-    if (xStreamBufferIsFull(sbuffer_logger_h) == pdFALSE)
-    {
-        // We intentionally do not check what xStreamBufferSend functions return,
-        // because not much to do to handle the errors.
-        if (0U == IPSR_register)
-            xStreamBufferSend(sbuffer_logger_h, p_data, length, pdMS_TO_TICKS(LOGGER_STREAM_BUFFER_TIMEOUT_MS));
-        else
-            xStreamBufferSendFromISR(sbuffer_logger_h, p_data, length, NULL);
-    }
-#else
-    (void) length;
-    printf("%s", p_data);
+    return string_length;
 #endif
 }
 
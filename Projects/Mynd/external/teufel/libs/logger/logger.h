@@ -55,23 +55,23 @@ extern "C"
 {
 #endif
 
-    void logger_internal_print_color(logger_log_level_t level);
+    void logger_internal_print_color(logger_record_t *p_record, logger_log_level_t level);
 
-    void logger_internal_reset_color(void);
+    void logger_internal_reset_color(logger_record_t *p_record);
 
-    void logger_internal_print_log_level(logger_log_level_t level);
+    void logger_internal_print_log_level(logger_record_t *p_record, logger_log_level_t level);
 
-    void logger_internal_print_timestamp();
+    void logger_internal_print_timestamp(logger_record_t *p_record);
 
-    void logger_internal_print_log_location(const char *module_name, size_t line_number,
+    void logger_internal_print_log_location(logger_record_t *p_record, const char *module_name, size_t line_number,
                                             uint8_t module_name_string_width);
 
-    void logger_internal_print_log(const char *format_string, ...);
+    void logger_internal_print_log(logger_record_t *p_record, const char *format_string, ...);
 
-    void logger_internal_print_new_line(const char *new_line_string);
+    void logger_internal_print_new_line(logger_record_t *p_record, const char *new_line_string);
 
-    int logger_internal_lock(void);
-    void logger_internal_unlock(void);
+    int  logger_internal_begin(logger_record_t *p_record);
+    void logger_internal_end(logger_record_t *p_record);
 
 #include "outputs/logger_any.h"
 
@@ -0,0 +1,79 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "logger_drain.h"
+#include "include/logger_impl.h"
+
+// Returns false if the chunk didn't make it out completely
+static bool send(logger_drain_t *p_drain, size_t length)
+{
+    if (p_drain->p_port->transmit(p_drain->p_chunk, length) != 0)
+    {
+        return false;
+    }
+    return p_drain->p_port->wait_tx_done() == 0;
+}
+
+// Formats the dropped bytes note without printf, the logger task runs on a small stack
+static size_t format_dropped(char *p_buffer, size_t size, uint32_t count)
+{
+    static const char prefix[] = "\r\n<dropped ";
+    static const char suffix[] = " log bytes>\r\n";
+    char              digits[10];
+    size_t            n_digits = 0;
+    size_t            length   = 0;
+
+    do
+    {
+        digits[n_digits++] = (char) ('0' + count % 10u);
+        count /= 10u;
+    } while (count > 0u);
+
+    if (sizeof(prefix) - 1 + n_digits + sizeof(suffix) - 1 > size)
+    {
+        return 0;
+    }
+
+    memcpy(p_buffer, prefix, sizeof(prefix) - 1);
+    length += sizeof(prefix) - 1;
+    while (n_digits > 0)
+    {
+        p_buffer[length++] = digits[--n_digits];
+    }
+    memcpy(&p_buffer[length], suffix, sizeof(suffix) - 1);
+    length += sizeof(suffix) - 1;
+
+    return length;
+}
+
+void logger_drain_init(logger_drain_t *p_drain, const logger_drain_port_t *p_port, uint8_t *p_chunk,
+                       size_t chunk_size)
+{
+    p_drain->p_port           = p_port;
+    p_drain->p_chunk          = p_chunk;
+    p_drain->chunk_size       = chunk_size;
+    p_drain->dropped_reported = logger_get_dropped_bytes();
+    p_drain->lost             = 0;
+}
+
+void logger_drain_process(logger_drain_t *p_drain)
+{
+    size_t length = p_drain->p_port->receive(p_drain->p_chunk, p_drain->chunk_size);
+    if (length > 0 && !send(p_drain, length))
+    {
+        p_drain->lost += length;
+    }
+
+    // A note that doesn't get out either is retried with the next chunk
+    uint32_t dropped = logger_get_dropped_bytes();
+    if (dropped != p_drain->dropped_reported || p_drain->lost > 0)
+    {
+        length = format_dropped((char *) p_drain->p_chunk, p_drain->chunk_size,
+                                dropped - p_drain->dropped_reported + p_drain->lost);
+        if (length == 0 || send(p_drain, length))
+        {
+            p_drain->dropped_reported = dropped;
+            p_drain->lost             = 0;
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Output backend of the logger drain.
+     */
+    typedef struct
+    {
+        /**
+         * @brief Blocks until log data is available and copies up to max_length bytes of it.
+         * @return number of bytes copied to p_data
+         */
+        size_t (*receive)(uint8_t *p_data, size_t max_length);
+
+        /**
+         * @brief Starts sending length bytes. p_data is not touched until wait_tx_done() returned.
+         * @return 0 if the transfer was started, -1 otherwise
+         */
+        int (*transmit)(const uint8_t *p_data, size_t length);
+
+        /**
+         * @brief Blocks until the transfer started by transmit() has completed.
+         * @return 0 if the transfer completed, -1 otherwise, e.g. aborted after a timeout
+         */
+        int (*wait_tx_done)(void);
+    } logger_drain_port_t;
+
+    typedef struct
+    {
+        const logger_drain_port_t *p_port;
+        uint8_t                   *p_chunk;
+        size_t                     chunk_size;
+        uint32_t                   dropped_reported;
+        uint32_t                   lost; // Bytes the port failed to send, reported like the dropped ones
+    } logger_drain_t;
+
+    /**
+     * @brief Initializes a drain that moves the logger output to the port in chunks of up to chunk_size bytes.
+     */
+    void logger_drain_init(logger_drain_t *p_drain, const logger_drain_port_t *p_port, uint8_t *p_chunk,
+                           size_t chunk_size);
+
+    /**
+     * @brief Sends the next chunk of log data, to be called in a loop from the logger task.
+     * @details Bytes the logger had to drop since the last call are reported in the output, together with the ones
+     *          of chunks the port failed to send.
+     */
+    void logger_drain_process(logger_drain_t *p_drain);
+
+#if defined(__cplusplus)
+}
+#endif
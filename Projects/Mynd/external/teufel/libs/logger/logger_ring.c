@@ -0,0 +1,164 @@
+#include <string.h>
+
+#include "logger_ring.h"
+
+// Every record starts with a 32-bit header, written once when the record is committed:
+// bit 31 committed, bits 16..30 payload length, bits 0..15 record size including the header.
+// Free space is kept zeroed, so a header that has not been written yet reads as not committed.
+#define RECORD_HEADER_SIZE 4u
+#define RECORD_COMMITTED   0x80000000u
+#define RECORD_MAX_SIZE    0x8000u
+
+#define RECORD_HEADER(length, size) (RECORD_COMMITTED | ((uint32_t) (length) << 16) | (uint32_t) (size))
+#define RECORD_LENGTH(header)       (((header) >> 16) & 0x7FFFu)
+#define RECORD_SIZE(header)         ((header) & 0xFFFFu)
+
+static inline uint32_t align4(uint32_t value)
+{
+    return (value + 3u) & ~3u;
+}
+
+static inline uint32_t load_acquire(volatile uint32_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void store_release(volatile uint32_t *p, uint32_t value)
+{
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+// Cortex-M0 has no exclusive load/store, a compare-and-swap of the head is a few instructions with the
+// interrupts masked instead. Other targets and the host tests use the compiler's atomic builtin.
+static inline int compare_and_swap(volatile uint32_t *p, uint32_t expected, uint32_t desired)
+{
+#if defined(__ARM_ARCH_6M__)
+    uint32_t primask;
+    int      swapped = 0;
+
+    __asm volatile("MRS %0, primask" : "=r"(primask));
+    __asm volatile("cpsid i" ::: "memory");
+    if (*p == expected)
+    {
+        *p      = desired;
+        swapped = 1;
+    }
+    __asm volatile("MSR primask, %0" ::"r"(primask) : "memory");
+
+    return swapped;
+#else
+    return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+#endif
+}
+
+static inline volatile uint32_t *record_header(logger_ring_t *p_ring, uint32_t position)
+{
+    return (volatile uint32_t *) (p_ring->p_buffer + (position & (p_ring->size - 1u)));
+}
+
+int logger_ring_init(logger_ring_t *p_ring, uint8_t *p_buffer, uint32_t size)
+{
+    if (size < 64u || size > RECORD_MAX_SIZE || (size & (size - 1u)) != 0u || ((uintptr_t) p_buffer & 3u) != 0u)
+    {
+        return -1;
+    }
+
+    memset(p_buffer, 0, size);
+    p_ring->p_buffer    = p_buffer;
+    p_ring->size        = size;
+    p_ring->head        = 0;
+    p_ring->tail        = 0;
+    p_ring->read_offset = 0;
+
+    return 0;
+}
+
+int logger_ring_reserve(logger_ring_t *p_ring, logger_ring_slot_t *p_slot, uint32_t max_length)
+{
+    uint32_t record_size = align4(RECORD_HEADER_SIZE + max_length);
+    uint32_t head, padding;
+
+    if (record_size > p_ring->size / 2u)
+    {
+        return -1;
+    }
+
+    do
+    {
+        head = load_acquire(&p_ring->head);
+
+        // A record never wraps around, the rest of the buffer is skipped with a padding record instead
+        uint32_t index = head & (p_ring->size - 1u);
+        padding        = (p_ring->size - index < record_size) ? p_ring->size - index : 0u;
+
+        if (head + padding + record_size - load_acquire(&p_ring->tail) > p_ring->size)
+        {
+            return -1;
+        }
+    } while (!compare_and_swap(&p_ring->head, head, head + padding + record_size));
+
+    if (padding != 0u)
+    {
+        store_release(record_header(p_ring, head), RECORD_HEADER(0u, padding));
+    }
+
+    p_slot->position = head + padding;
+    p_slot->p_data   = (char *) record_header(p_ring, p_slot->position) + RECORD_HEADER_SIZE;
+    p_slot->capacity = record_size - RECORD_HEADER_SIZE;
+
+    return 0;
+}
+
+void logger_ring_commit(logger_ring_t *p_ring, const logger_ring_slot_t *p_slot, uint32_t length)
+{
+    uint32_t reserved = RECORD_HEADER_SIZE + p_slot->capacity;
+    uint32_t used     = align4(RECORD_HEADER_SIZE + length);
+
+    if (used < reserved)
+    {
+        // Only the newest reservation can shrink, the free space it hands back has to be zeroed again
+        uint8_t *p_record = (uint8_t *) record_header(p_ring, p_slot->position);
+        memset(p_record + used, 0, reserved - used);
+        if (!compare_and_swap(&p_ring->head, p_slot->position + reserved, p_slot->position + used))
+        {
+            used = reserved;
+        }
+    }
+
+    store_release(record_header(p_ring, p_slot->position), RECORD_HEADER(length, used));
+}
+
+size_t logger_ring_read(logger_ring_t *p_ring, uint8_t *p_data, size_t max_length)
+{
+    size_t copied = 0;
+
+    while (copied < max_length)
+    {
+        volatile uint32_t *p_header = record_header(p_ring, p_ring->tail);
+        uint32_t           header   = load_acquire(p_header);
+
+        if ((header & RECORD_COMMITTED) == 0u)
+        {
+            break;
+        }
+
+        uint32_t length = RECORD_LENGTH(header) - p_ring->read_offset;
+        if (length > max_length - copied)
+        {
+            length = max_length - copied;
+        }
+        memcpy(p_data + copied, (uint8_t *) p_header + RECORD_HEADER_SIZE + p_ring->read_offset, length);
+        copied += length;
+        p_ring->read_offset += length;
+
+        if (p_ring->read_offset == RECORD_LENGTH(header))
+        {
+            // Zeroed before the producers can reserve the space again
+            memset((uint8_t *) p_header, 0, RECORD_SIZE(header));
+            p_ring->read_offset = 0;
+            store_release(&p_ring->tail, p_ring->tail + RECORD_SIZE(header));
+        }
+    }
+
+    return copied;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Multi-producer, single-consumer ring of log records.
+     * @details Producers reserve a contiguous slot with a single compare-and-swap on the head, format directly
+     *          into it and commit it by writing the record header. Tasks and ISRs can produce concurrently
+     *          without a lock. The consumer reads the records in reservation order and stops at the first
+     *          one that is not committed yet.
+     */
+    typedef struct
+    {
+        uint8_t          *p_buffer;
+        uint32_t          size;
+        volatile uint32_t head;        // End of the newest reservation, written by the producers
+        volatile uint32_t tail;        // Start of the oldest record, written by the consumer
+        uint32_t          read_offset; // Bytes of the oldest record already read by the consumer
+    } logger_ring_t;
+
+    typedef struct
+    {
+        char    *p_data;
+        uint32_t capacity;
+        uint32_t position;
+    } logger_ring_slot_t;
+
+    /**
+     * @brief Initializes the ring.
+     * @param p_buffer storage, 4-byte aligned
+     * @param size a power of two between 64 and 32768 bytes
+     * @return 0 on success, -1 if the size is not supported
+     */
+    int logger_ring_init(logger_ring_t *p_ring, uint8_t *p_buffer, uint32_t size);
+
+    /**
+     * @brief Reserves a slot for a record of up to max_length bytes. Safe to call from tasks and ISRs.
+     * @return 0 on success, -1 if the ring has no room for the record
+     */
+    int logger_ring_reserve(logger_ring_t *p_ring, logger_ring_slot_t *p_slot, uint32_t max_length);
+
+    /**
+     * @brief Publishes the first length bytes of a reserved slot to the consumer.
+     * @details The unused end of the slot is handed back if no other producer has reserved after it.
+     */
+    void logger_ring_commit(logger_ring_t *p_ring, const logger_ring_slot_t *p_slot, uint32_t length);
+
+    /**
+     * @brief Copies up to max_length bytes of committed records to p_data, single consumer only.
+     * @return number of bytes copied, 0 if the oldest record is not committed yet
+     */
+    size_t logger_ring_read(logger_ring_t *p_ring, uint8_t *p_data, size_t max_length);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -2,7 +2,7 @@
 
 #if defined(LOGGER_USE_COLOR) && LOGGER_USE_COLOR == 1
 #define logger_any_print_color(...) logger_internal_print_color(__VA_ARGS__)
-#define logger_any_reset_color(...) logger_internal_reset_color()
+#define logger_any_reset_color(...) logger_internal_reset_color(__VA_ARGS__)
 #else
 #define logger_any_print_color(...)
 #define logger_any_reset_color(...)
@@ -53,7 +53,11 @@
     {                                                                                                                  \
         if (LOG_LEVEL >= level)                                                                                        \
         {                                                                                                              \
-            logger_internal_print_log(__VA_ARGS__);                                                                    \
+            logger_record_t logger_record;                                                                             \
+            if (logger_internal_begin(&logger_record) != 0)                                                            \
+                break;                                                                                                 \
+            logger_internal_print_log(&logger_record, __VA_ARGS__);                                                    \
+            logger_internal_end(&logger_record);                                                                       \
         }                                                                                                              \
     } while (0)
 
@@ -63,17 +67,18 @@
     {                                                                                                                  \
         if (LOG_LEVEL >= level)                                                                                        \
         {                                                                                                              \
-            if (logger_internal_lock() != 0)                                                                           \
+            logger_record_t logger_record;                                                                             \
+            if (logger_internal_begin(&logger_record) != 0)                                                            \
                 break;                                                                                                 \
-            logger_any_print_timestamp_before_log_level();                                                             \
-            logger_any_print_color(level);                                                                             \
-            logger_any_print_log_level(level);                                                                         \
-            logger_any_reset_color_after_log_level(level);                                                             \
-            logger_any_print_timestamp_after_log_level();                                                              \
-            logger_any_print_log_location(LOG_MODULE_NAME, __LINE__, LOGGER_LOG_LOCATION_WIDTH);                       \
-            logger_internal_print_log(__VA_ARGS__);                                                                    \
-            logger_any_print_new_line(LOGGER_NEW_LINE_STRING);                                                         \
-            logger_any_reset_color_at_end_of_line(level);                                                              \
-            logger_internal_unlock();                                                                                  \
+            logger_any_print_timestamp_before_log_level(&logger_record);                                               \
+            logger_any_print_color(&logger_record, level);                                                             \
+            logger_any_print_log_level(&logger_record, level);                                                         \
+            logger_any_reset_color_after_log_level(&logger_record);                                                    \
+            logger_any_print_timestamp_after_log_level(&logger_record);                                                \
+            logger_any_print_log_location(&logger_record, LOG_MODULE_NAME, __LINE__, LOGGER_LOG_LOCATION_WIDTH);       \
+            logger_internal_print_log(&logger_record, __VA_ARGS__);                                                    \
+            logger_any_print_new_line(&logger_record, LOGGER_NEW_LINE_STRING);                                         \
+            logger_any_reset_color_at_end_of_line(&logger_record);                                                     \
+            logger_internal_end(&logger_record);                                                                       \
         }                                                                                                              \
     } while (0)
@@ -0,0 +1,264 @@
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "logger_drain.h"
+
+// Discrete time simulation of the logger task draining the log record ring into the debug UART,
+// while the other tasks log in bursts.
+
+namespace
+{
+
+constexpr uint64_t BYTE_TIME_NS       = 86806; // 10 bits at 115200 baud
+constexpr uint64_t CALL_OVERHEAD_NS = 5000;  // ring read, DMA setup, context switch
+constexpr size_t   RING_SIZE        = 512;
+constexpr size_t   LINE_LENGTH      = 48;
+
+struct Simulation
+{
+    uint64_t now_ns      = 0;
+    uint64_t cpu_ns      = 0;
+    uint64_t burst_at_ns = 0;
+    uint64_t end_ns      = 0;
+    uint64_t period_ns   = 0;
+    uint32_t burst_lines = 0;
+    uint32_t next_line   = 0;
+    uint32_t dropped     = 0;
+    uint32_t transfers   = 0;
+    uint32_t lost        = 0;
+
+    std::deque<uint8_t>  ring;
+    std::vector<uint8_t> accepted;
+    std::vector<uint8_t> wire;
+    std::vector<uint8_t> in_flight;
+};
+
+Simulation sim;
+
+// Higher priority tasks log whenever they are due, a line the ring has no room for is dropped as a whole
+// like in logger_internal_end()
+void produce_until(uint64_t t_ns)
+{
+    while (sim.burst_at_ns <= t_ns && sim.burst_at_ns < sim.end_ns)
+    {
+        for (uint32_t i = 0; i < sim.burst_lines; i++)
+        {
+            char line[LINE_LENGTH + 1];
+            snprintf(line, sizeof(line), "L%06u %-*s\r\n", sim.next_line++, (int) (LINE_LENGTH - 10), "burst");
+
+            if (sim.ring.size() + LINE_LENGTH <= RING_SIZE)
+            {
+                sim.ring.insert(sim.ring.end(), line, line + LINE_LENGTH);
+                sim.accepted.insert(sim.accepted.end(), line, line + LINE_LENGTH);
+            }
+            else
+            {
+                sim.dropped += LINE_LENGTH;
+            }
+        }
+        sim.burst_at_ns += sim.period_ns;
+    }
+}
+
+size_t ring_receive(uint8_t *p_data, size_t max_length)
+{
+    produce_until(sim.now_ns);
+
+    // Blocks until the next burst
+    if (sim.ring.empty())
+    {
+        if (sim.burst_at_ns >= sim.end_ns)
+        {
+            return 0;
+        }
+        sim.now_ns = sim.burst_at_ns;
+        produce_until(sim.now_ns);
+    }
+
+    size_t length = std::min(max_length, sim.ring.size());
+    for (size_t i = 0; i < length; i++)
+    {
+        p_data[i] = sim.ring.front();
+        sim.ring.pop_front();
+    }
+
+    sim.cpu_ns += CALL_OVERHEAD_NS;
+    sim.now_ns += CALL_OVERHEAD_NS;
+    return length;
+}
+
+// DMA: the CPU only sets the transfer up and sleeps until the completion notification
+int dma_transmit(const uint8_t *p_data, size_t length)
+{
+    sim.in_flight.assign(p_data, p_data + length);
+    sim.transfers++;
+    return 0;
+}
+
+int dma_wait_tx_done(void)
+{
+    sim.now_ns += sim.in_flight.size() * BYTE_TIME_NS;
+    produce_until(sim.now_ns);
+    sim.wire.insert(sim.wire.end(), sim.in_flight.begin(), sim.in_flight.end());
+    sim.in_flight.clear();
+    return 0;
+}
+
+// Every 4th chunk of log data gets stuck, the logger task aborts it after its timeout
+constexpr uint64_t TX_TIMEOUT_NS = 50'000'000;
+
+int flaky_wait_tx_done(void)
+{
+    const bool is_drop_report = sim.in_flight.size() > 2 && sim.in_flight[2] == '<';
+    if (not is_drop_report && sim.transfers % 4 == 0)
+    {
+        sim.now_ns += TX_TIMEOUT_NS;
+        produce_until(sim.now_ns);
+        sim.lost += sim.in_flight.size();
+        sim.in_flight.clear();
+        return -1;
+    }
+    return dma_wait_tx_done();
+}
+
+// Blocking HAL_UART_Transmit: the CPU polls the UART until every byte is out
+int blocking_transmit(const uint8_t *p_data, size_t length)
+{
+    sim.now_ns += length * BYTE_TIME_NS;
+    sim.cpu_ns += length * BYTE_TIME_NS;
+    sim.wire.insert(sim.wire.end(), p_data, p_data + length);
+    sim.transfers++;
+    return 0;
+}
+
+int blocking_wait_tx_done(void)
+{
+    return 0;
+}
+
+const logger_drain_port_t dma_port      = {ring_receive, dma_transmit, dma_wait_tx_done};
+const logger_drain_port_t blocking_port = {ring_receive, blocking_transmit, blocking_wait_tx_done};
+const logger_drain_port_t flaky_port    = {ring_receive, dma_transmit, flaky_wait_tx_done};
+
+struct Result
+{
+    double   cpu_load;
+    double   bytes_per_s;
+    uint32_t transfers;
+};
+
+Result run(const logger_drain_port_t *p_port, size_t chunk_size, uint32_t burst_lines, uint64_t period_ns,
+           uint64_t duration_ns)
+{
+    logger_drain_t       drain;
+    std::vector<uint8_t> chunk(chunk_size);
+
+    sim             = Simulation{};
+    sim.burst_lines = burst_lines;
+    sim.period_ns   = period_ns;
+    sim.end_ns      = duration_ns;
+
+    logger_drain_init(&drain, p_port, chunk.data(), chunk.size());
+    while (sim.burst_at_ns < sim.end_ns || not sim.ring.empty())
+    {
+        logger_drain_process(&drain);
+    }
+
+    return Result{(double) sim.cpu_ns / sim.now_ns, sim.wire.size() * 1e9 / sim.now_ns, sim.transfers};
+}
+
+// Splits the wire into log data and the reported dropped byte counts
+std::vector<uint8_t> strip_drop_reports(const std::vector<uint8_t> &wire, uint32_t *p_reported)
+{
+    const std::string    prefix = "\r\n<dropped ";
+    const std::string    data(wire.begin(), wire.end());
+    std::vector<uint8_t> out;
+    size_t               pos = 0;
+
+    *p_reported = 0;
+    while (pos < data.size())
+    {
+        size_t next = data.find(prefix, pos);
+        if (next == std::string::npos)
+        {
+            next = data.size();
+        }
+        out.insert(out.end(), data.begin() + pos, data.begin() + next);
+        if (next == data.size())
+        {
+            break;
+        }
+
+        const std::string suffix = " log bytes>\r\n";
+        size_t            end    = data.find(suffix, next);
+        EXPECT_NE(end, std::string::npos);
+        *p_reported += std::stoul(data.substr(next + prefix.size(), end - next - prefix.size()));
+        pos = end + suffix.size();
+    }
+
+    return out;
+}
+
+} // namespace
+
+extern "C" uint32_t logger_get_dropped_bytes(void)
+{
+    return sim.dropped;
+}
+
+TEST(LoggerDrainTest, BurstWithinBufferIsNeitherDroppedNorReordered)
+{
+    // 10 lines every 50 ms: 480 bytes, about 80% of the UART bandwidth
+    run(&dma_port, 64, 10, 50'000'000, 2'000'000'000);
+
+    EXPECT_EQ(sim.dropped, 0);
+    EXPECT_EQ(sim.accepted.size(), sim.next_line * LINE_LENGTH);
+    EXPECT_EQ(sim.wire, sim.accepted);
+}
+
+TEST(LoggerDrainTest, OverloadIsCountedAndReported)
+{
+    uint32_t reported = 0;
+
+    // 40 lines every 100 ms: 1920 bytes, more than the UART can send
+    run(&dma_port, 64, 40, 100'000'000, 2'000'000'000);
+
+    EXPECT_GT(sim.dropped, 0);
+    EXPECT_EQ(strip_drop_reports(sim.wire, &reported), sim.accepted);
+    EXPECT_EQ(reported, sim.dropped);
+}
+
+TEST(LoggerDrainTest, FailedTransfersAreReportedAsDropped)
+{
+    uint32_t reported = 0;
+
+    run(&flaky_port, 64, 10, 50'000'000, 2'000'000'000);
+
+    EXPECT_GT(sim.lost, 0);
+    EXPECT_EQ(strip_drop_reports(sim.wire, &reported).size() + sim.lost, sim.accepted.size());
+    EXPECT_EQ(reported, sim.dropped + sim.lost);
+}
+
+TEST(LoggerDrainTest, DmaFreesTheCpuAtFullThroughput)
+{
+    // Verbose logging: a full buffer's worth of lines every 50 ms keeps the UART busy
+    const Result blocking = run(&blocking_port, 1, 10, 50'000'000, 5'000'000'000);
+    const auto   blocking_wire = sim.wire;
+    const Result dma           = run(&dma_port, 64, 10, 50'000'000, 5'000'000'000);
+
+    printf("blocking per byte: %.0f bytes/s, cpu load %.1f%%, %u transfers\r\n", blocking.bytes_per_s,
+           blocking.cpu_load * 100, blocking.transfers);
+    printf("dma chunks:        %.0f bytes/s, cpu load %.1f%%, %u transfers\r\n", dma.bytes_per_s, dma.cpu_load * 100,
+           dma.transfers);
+
+    EXPECT_EQ(sim.wire, blocking_wire);
+    EXPECT_GE(dma.bytes_per_s, blocking.bytes_per_s * 0.95);
+    EXPECT_GT(blocking.cpu_load, 0.5);
+    EXPECT_LT(dma.cpu_load, 0.05);
+    EXPECT_LT(dma.transfers * 8, blocking.transfers);
+}
@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "logger_ring.h"
+
+namespace
+{
+
+constexpr uint32_t RING_SIZE   = 1024;
+constexpr uint32_t RECORD_SIZE = 96;
+constexpr size_t   CHUNK_SIZE  = 64;
+
+alignas(4) uint8_t ring_storage[RING_SIZE];
+
+// Formats a line the way the logger does: header, then a payload whose length depends on the sequence number
+int format_line(char *p_data, size_t size, unsigned producer, unsigned seq)
+{
+    return snprintf(p_data, size, "P%02u:%06u:%.*s\n", producer, seq, (int) (seq * 7 % 60),
+                    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789");
+}
+
+// Checks that every line arrived intact and in order per producer, returns the number of lines
+size_t check_lines(const std::string &output, unsigned producers, unsigned lines_per_producer, bool allow_gaps)
+{
+    std::vector<int> last_seq(producers, -1);
+    size_t           count = 0;
+    size_t           pos   = 0;
+
+    while (pos < output.size())
+    {
+        size_t end = output.find('\n', pos);
+        EXPECT_NE(end, std::string::npos);
+        if (end == std::string::npos)
+        {
+            break;
+        }
+
+        unsigned producer = 0, seq = 0;
+        EXPECT_EQ(sscanf(output.c_str() + pos, "P%2u:%6u:", &producer, &seq), 2);
+        EXPECT_LT(producer, producers);
+        if (producer >= producers)
+        {
+            break;
+        }
+
+        char expected[RECORD_SIZE];
+        int  length = format_line(expected, sizeof(expected), producer, seq);
+        EXPECT_EQ(output.compare(pos, end + 1 - pos, expected, length), 0) << output.substr(pos, end + 1 - pos);
+
+        if (allow_gaps)
+        {
+            EXPECT_GT((int) seq, last_seq[producer]);
+        }
+        else
+        {
+            EXPECT_EQ((int) seq, last_seq[producer] + 1);
+        }
+        last_seq[producer] = seq;
+        count++;
+        pos = end + 1;
+    }
+
+    if (!allow_gaps)
+    {
+        for (unsigned p = 0; p < producers; p++)
+        {
+            EXPECT_EQ(last_seq[p], (int) lines_per_producer - 1);
+        }
+    }
+    return count;
+}
+
+// Drains the ring in chunks like the logger task until the producers are done and the ring is empty
+std::string consume(logger_ring_t *p_ring, std::atomic<unsigned> &running)
+{
+    std::string output;
+    uint8_t     chunk[CHUNK_SIZE];
+
+    for (;;)
+    {
+        bool   done   = running.load() == 0;
+        size_t length = logger_ring_read(p_ring, chunk, sizeof(chunk));
+        output.append((const char *) chunk, length);
+        if (length == 0)
+        {
+            if (done)
+            {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+    return output;
+}
+
+} // namespace
+
+TEST(LoggerRingTest, RejectsUnsupportedSizes)
+{
+    logger_ring_t ring;
+
+    EXPECT_EQ(logger_ring_init(&ring, ring_storage, 1000), -1);
+    EXPECT_EQ(logger_ring_init(&ring, ring_storage, 32), -1);
+    EXPECT_EQ(logger_ring_init(&ring, ring_storage + 1, 256), -1);
+    EXPECT_EQ(logger_ring_init(&ring, ring_storage, 256), 0);
+}
+
+TEST(LoggerRingTest, RecordsAreReadInReservationOrderOnceCommitted)
+{
+    logger_ring_t      ring;
+    logger_ring_slot_t first, second;
+    uint8_t            out[32];
+
+    ASSERT_EQ(logger_ring_init(&ring, ring_storage, 256), 0);
+    ASSERT_EQ(logger_ring_reserve(&ring, &first, 16), 0);
+    ASSERT_EQ(logger_ring_reserve(&ring, &second, 16), 0);
+
+    // The second producer is done first, its record waits for the first one
+    memcpy(second.p_data, "second", 6);
+    logger_ring_commit(&ring, &second, 6);
+    EXPECT_EQ(logger_ring_read(&ring, out, sizeof(out)), 0u);
+
+    memcpy(first.p_data, "first", 5);
+    logger_ring_commit(&ring, &first, 5);
+    ASSERT_EQ(logger_ring_read(&ring, out, sizeof(out)), 11u);
+    EXPECT_EQ(std::string((const char *) out, 11), "firstsecond");
+}
+
+TEST(LoggerRingTest, UnusedEndOfTheNewestSlotIsHandedBack)
+{
+    logger_ring_t      ring;
+    logger_ring_slot_t slot;
+    uint8_t            out[8];
+
+    ASSERT_EQ(logger_ring_init(&ring, ring_storage, 256), 0);
+
+    // Lines much shorter than the reservation fill the ring, not the reservation size
+    int records = 0;
+    while (logger_ring_reserve(&ring, &slot, 100) == 0)
+    {
+        memcpy(slot.p_data, "abc", 3);
+        logger_ring_commit(&ring, &slot, 3);
+        records++;
+    }
+    EXPECT_GE(records, (256 - 104) / 8 + 1);
+
+    // Partial reads keep the position inside a record
+    ASSERT_EQ(logger_ring_read(&ring, out, 2), 2u);
+    ASSERT_EQ(logger_ring_read(&ring, out + 2, 5), 5u);
+    EXPECT_EQ(std::string((const char *) out, 7), "abcabca");
+}
+
+TEST(LoggerRingTest, ManyProducersKeepLinesIntactAndInOrder)
+{
+    constexpr unsigned PRODUCERS = 8;
+    constexpr unsigned LINES     = 5000;
+
+    logger_ring_t         ring;
+    std::atomic<unsigned> running{PRODUCERS};
+    std::atomic<uint64_t> full{0};
+    std::vector<std::thread> producers;
+
+    ASSERT_EQ(logger_ring_init(&ring, ring_storage, RING_SIZE), 0);
+
+    for (unsigned p = 0; p < PRODUCERS; p++)
+    {
+        producers.emplace_back(
+            [&, p]()
+            {
+                for (unsigned seq = 0; seq < LINES; seq++)
+                {
+                    logger_ring_slot_t slot;
+                    while (logger_ring_reserve(&ring, &slot, RECORD_SIZE) != 0)
+                    {
+                        full++;
+                        std::this_thread::yield();
+                    }
+                    int length = format_line(slot.p_data, slot.capacity, p, seq);
+                    logger_ring_commit(&ring, &slot, (uint32_t) length);
+                }
+                running--;
+            });
+    }
+
+    std::string output = consume(&ring, running);
+    for (auto &t : producers)
+    {
+        t.join();
+    }
+
+    EXPECT_EQ(check_lines(output, PRODUCERS, LINES, false), PRODUCERS * LINES);
+    printf("%u lines through a %u byte ring, %llu reservations found it full\r\n", PRODUCERS * LINES, RING_SIZE,
+           (unsigned long long) full.load());
+}
+
+TEST(LoggerRingTest, DroppedLinesLeaveNoTraceInTheOutput)
+{
+    constexpr unsigned PRODUCERS = 6;
+    constexpr unsigned LINES     = 20000;
+
+    logger_ring_t         ring;
+    std::atomic<unsigned> running{PRODUCERS};
+    std::atomic<unsigned> dropped{0};
+    std::vector<std::thread> producers;
+
+    ASSERT_EQ(logger_ring_init(&ring, ring_storage, 256), 0);
+
+    // A ring this small is full most of the time, lines that find no room are dropped like in the logger
+    for (unsigned p = 0; p < PRODUCERS; p++)
+    {
+        producers.emplace_back(
+            [&, p]()
+            {
+                for (unsigned seq = 0; seq < LINES; seq++)
+                {
+                    logger_ring_slot_t slot;
+                    if (logger_ring_reserve(&ring, &slot, RECORD_SIZE) != 0)
+                    {
+                        dropped++;
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    int length = format_line(slot.p_data, slot.capacity, p, seq);
+                    logger_ring_commit(&ring, &slot, (uint32_t) length);
+                }
+                running--;
+            });
+    }
+
+    std::string output = consume(&ring, running);
+    for (auto &t : producers)
+    {
+        t.join();
+    }
+
+    EXPECT_EQ(check_lines(output, PRODUCERS, LINES, true) + dropped.load(), PRODUCERS * LINES);
+}
+
+TEST(LoggerRingTest, LatencyComparedToLocking)
+{
+    constexpr unsigned PRODUCERS = 4;
+    constexpr unsigned LINES     = 50000;
+
+    // Same ring, serialized by a mutex held while the line is formatted, like logger_internal_lock()
+    std::mutex lock;
+
+    auto run = [&](bool locked) -> std::vector<uint32_t>
+    {
+        logger_ring_t            ring;
+        std::atomic<unsigned>    running{PRODUCERS};
+        std::vector<std::thread> producers;
+        std::vector<std::vector<uint32_t>> latencies(PRODUCERS);
+
+        EXPECT_EQ(logger_ring_init(&ring, ring_storage, RING_SIZE), 0);
+        for (unsigned p = 0; p < PRODUCERS; p++)
+        {
+            producers.emplace_back(
+                [&, p]()
+                {
+                    latencies[p].reserve(LINES);
+                    for (unsigned seq = 0; seq < LINES; seq++)
+                    {
+                        auto               start = std::chrono::steady_clock::now();
+                        logger_ring_slot_t slot;
+                        {
+                            std::unique_lock<std::mutex> guard(lock, std::defer_lock);
+                            if (locked)
+                            {
+                                guard.lock();
+                            }
+                            if (logger_ring_reserve(&ring, &slot, RECORD_SIZE) == 0)
+                            {
+                                int length = format_line(slot.p_data, slot.capacity, p, seq);
+                                logger_ring_commit(&ring, &slot, (uint32_t) length);
+                            }
+                        }
+                        latencies[p].push_back((uint32_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                   std::chrono::steady_clock::now() - start)
+                                                   .count());
+                    }
+                    running--;
+                });
+        }
+
+        consume(&ring, running);
+        for (auto &t : producers)
+        {
+            t.join();
+        }
+
+        std::vector<uint32_t> all;
+        for (auto &l : latencies)
+        {
+            all.insert(all.end(), l.begin(), l.end());
+        }
+        std::sort(all.begin(), all.end());
+        return all;
+    };
+
+    const auto locking   = run(true);
+    const auto lock_free = run(false);
+
+    auto percentile = [](const std::vector<uint32_t> &v, double p) { return v[(size_t) (p * (v.size() - 1))]; };
+
+    printf("log line latency [ns]  p50 %6u  p99 %6u  p99.9 %7u  max %8u  (locking)\r\n", percentile(locking, 0.5),
+           percentile(locking, 0.99), percentile(locking, 0.999), locking.back());
+    printf("log line latency [ns]  p50 %6u  p99 %6u  p99.9 %7u  max %8u  (lock-free)\r\n", percentile(lock_free, 0.5),
+           percentile(lock_free, 0.99), percentile(lock_free, 0.999), lock_free.back());
+
+    ASSERT_EQ(locking.size(), lock_free.size());
+}
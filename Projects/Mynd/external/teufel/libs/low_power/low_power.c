@@ -0,0 +1,35 @@
+#include <stddef.h>
+
+#include "low_power.h"
+
+low_power_decision_t low_power_decide(const low_power_config_t *p_config, uint32_t expected_idle_ticks,
+                                      uint32_t stop_locks)
+{
+    low_power_decision_t decision = {LOW_POWER_MODE_RUN, 0};
+
+    if (p_config == NULL || expected_idle_ticks < p_config->min_sleep_ticks)
+        return decision;
+
+    if (stop_locks == 0 && expected_idle_ticks >= p_config->min_stop_ticks)
+    {
+        decision.mode  = LOW_POWER_MODE_STOP;
+        decision.ticks = expected_idle_ticks < p_config->max_stop_ticks ? expected_idle_ticks : p_config->max_stop_ticks;
+        return decision;
+    }
+
+    decision.mode  = LOW_POWER_MODE_SLEEP;
+    decision.ticks = expected_idle_ticks < p_config->max_sleep_ticks ? expected_idle_ticks : p_config->max_sleep_ticks;
+    return decision;
+}
+
+void low_power_stats_add(low_power_stats_t *p_stats, low_power_mode_t mode, uint32_t slept_ticks)
+{
+    if (mode == LOW_POWER_MODE_RUN)
+        return;
+
+    p_stats->wakeups++;
+    if (mode == LOW_POWER_MODE_STOP)
+        p_stats->stop_ticks += slept_ticks;
+    else
+        p_stats->sleep_ticks += slept_ticks;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+    /**
+     * @brief How the MCU waits for the next wakeup when the scheduler has nothing to run.
+     */
+    typedef enum
+    {
+        LOW_POWER_MODE_RUN,   // idle time too short to be worth stopping the tick, the kernel ticks on
+        LOW_POWER_MODE_SLEEP, // core clock gated, peripherals, DMA and their interrupts keep running
+        LOW_POWER_MODE_STOP,  // all clocks but the low speed ones stopped, only EXTI wakes up the MCU
+    } low_power_mode_t;
+
+    /**
+     * @brief Limits in kernel ticks, given by the hardware timers used to wake up from each mode.
+     */
+    typedef struct
+    {
+        uint32_t min_sleep_ticks;
+        uint32_t max_sleep_ticks; // the tick timer reload range
+        uint32_t min_stop_ticks;  // below this the time to restart the clocks isn't paid off
+        uint32_t max_stop_ticks;  // the wakeup timer range
+    } low_power_config_t;
+
+    typedef struct
+    {
+        low_power_mode_t mode;
+        uint32_t         ticks; // ticks to wait for, at most the expected idle time
+    } low_power_decision_t;
+
+    /**
+     * @brief Picks the low power mode for the time until the next task is due.
+     * @param expected_idle_ticks as passed by the kernel to portSUPPRESS_TICKS_AND_SLEEP
+     * @param stop_locks number of drivers which need their clocks right now, e.g. a running DMA transfer
+     */
+    low_power_decision_t low_power_decide(const low_power_config_t *p_config, uint32_t expected_idle_ticks,
+                                          uint32_t stop_locks);
+
+    /**
+     * @brief Where the idle time went, for the "lp" shell command and the simulation.
+     */
+    typedef struct
+    {
+        uint32_t wakeups;
+        uint32_t sleep_ticks;
+        uint32_t stop_ticks;
+    } low_power_stats_t;
+
+    void low_power_stats_add(low_power_stats_t *p_stats, low_power_mode_t mode, uint32_t slept_ticks);
+
+#if defined(__cplusplus)
+}
+#endif
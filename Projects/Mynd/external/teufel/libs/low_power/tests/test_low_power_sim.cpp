@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "low_power.h"
+
+namespace
+{
+
+// The limits of the Mynd board, see board_low_power.c: SysTick reload range at 48 MHz and the RTC wakeup timer
+const low_power_config_t config = {
+    .min_sleep_ticks = 2,
+    .max_sleep_ticks = 349,
+    .min_stop_ticks  = 5,
+    .max_stop_ticks  = 26000,
+};
+
+// Rough STM32F072 figures at 48 MHz, only the relation between the scenarios is of interest
+constexpr double   run_ma       = 20.0;
+constexpr double   sleep_ma     = 6.0;
+constexpr double   stop_ma      = 0.012;
+constexpr double   tick_run_us  = 5.0;
+constexpr double   irq_run_us   = 10.0;
+constexpr double   task_run_us  = 100.0;
+constexpr double   stop_exit_us = 20.0;
+constexpr uint64_t duration_us  = 10'000'000;
+constexpr uint64_t tick_us      = 1000;
+constexpr uint64_t no_event     = UINT64_MAX;
+// One ADC scan of 72 conversions
+constexpr uint64_t adc_scan_us = 1515;
+
+struct Source
+{
+    const char *name;
+    uint64_t    period_us;
+};
+
+struct Scenario
+{
+    bool                tickless;
+    std::vector<Source> timers;     // task idle periods and software timers, known to the kernel
+    std::vector<Source> interrupts; // peripheral interrupts, unknown to the kernel
+    bool                adc_lock;   // the continuous ADC scan holds the STOP lock
+    bool                adc_on_demand = false; // the audio task starts a single scan, which holds the lock meanwhile
+};
+
+struct Result
+{
+    double            wakeups_per_s;
+    double            average_ma;
+    uint32_t          stop_with_lock;
+    low_power_stats_t stats;
+};
+
+uint64_t next_due(const std::vector<Source> &sources, const std::vector<uint64_t> &due)
+{
+    uint64_t next = no_event;
+    for (size_t i = 0; i < sources.size(); i++)
+        next = std::min(next, due[i]);
+    return next;
+}
+
+// Runs every source that is due at time t, returns the time spent running
+double serve(const std::vector<Source> &sources, std::vector<uint64_t> &due, uint64_t t, double cost_us)
+{
+    double run_us = 0;
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        while (due[i] <= t)
+        {
+            due[i] += sources[i].period_us;
+            run_us += cost_us;
+        }
+    }
+    return run_us;
+}
+
+Result simulate(const Scenario &scenario)
+{
+    std::vector<uint64_t> timer_due, irq_due;
+    for (const auto &s : scenario.timers)
+        timer_due.push_back(s.period_us);
+    for (const auto &s : scenario.interrupts)
+        irq_due.push_back(s.period_us);
+
+    Result   result     = {};
+    uint32_t wakeups    = 0;
+    double   run_us     = 0;
+    double   sleep_us   = 0;
+    double   stop_us    = 0;
+    uint64_t t          = 0;
+    uint32_t stop_locks = scenario.adc_lock ? 1 : 0;
+    uint64_t adc_done   = no_event;
+    size_t   audio      = 0;
+    while (audio < scenario.timers.size() && strcmp(scenario.timers[audio].name, "audio") != 0)
+        audio++;
+
+    while (t < duration_us)
+    {
+        const uint64_t next_timer = next_due(scenario.timers, timer_due);
+        const uint64_t next_irq   = std::min(next_due(scenario.interrupts, irq_due), adc_done);
+        uint64_t       wake       = std::min(next_timer, next_irq);
+
+        if (!scenario.tickless)
+        {
+            // The idle hook waits for the next interrupt, the tick being the latest one
+            wake = std::min(wake, (t / tick_us + 1) * tick_us);
+            sleep_us += wake - t;
+            run_us += tick_run_us;
+        }
+        else
+        {
+            const uint32_t       expected_idle_ticks = (next_timer - t) / tick_us;
+            low_power_decision_t decision            = low_power_decide(&config, expected_idle_ticks, stop_locks);
+
+            if (decision.mode == LOW_POWER_MODE_RUN)
+            {
+                // The kernel ticks on until the next timer is due
+                wake = std::min(wake, (t / tick_us + 1) * tick_us);
+                sleep_us += wake - t;
+                run_us += tick_run_us;
+            }
+            else
+            {
+                wake = std::min(wake, t + decision.ticks * tick_us);
+                if (decision.mode == LOW_POWER_MODE_STOP)
+                {
+                    if (next_irq < wake)
+                        result.stop_with_lock++; // a DMA interrupt can't wake the MCU up from STOP
+                    stop_us += wake - t;
+                    run_us += stop_exit_us;
+                }
+                else
+                {
+                    sleep_us += wake - t;
+                }
+                low_power_stats_add(&result.stats, decision.mode, (wake - t) / tick_us);
+            }
+        }
+
+        wakeups++;
+        t = wake;
+        run_us += serve(scenario.interrupts, irq_due, t, irq_run_us);
+        if (adc_done <= t)
+        {
+            adc_done   = no_event;
+            stop_locks = 0;
+            run_us += irq_run_us;
+        }
+        if (scenario.adc_on_demand && audio < scenario.timers.size() && timer_due[audio] <= t)
+        {
+            adc_done   = t + adc_scan_us;
+            stop_locks = 1;
+        }
+        run_us += serve(scenario.timers, timer_due, t, task_run_us);
+    }
+
+    const double total_us = run_us + sleep_us + stop_us;
+    result.wakeups_per_s  = wakeups / (duration_us / 1e6);
+    result.average_ma     = (run_us * run_ma + sleep_us * sleep_ma + stop_us * stop_ma) / total_us;
+    return result;
+}
+
+void print(const char *name, const Result &result)
+{
+    printf("%-28s %8.0f wakeups/s %7.2f mA  sleep %6u ticks  stop %6u ticks\n", name, result.wakeups_per_s,
+           result.average_ma, (unsigned) result.stats.sleep_ticks, (unsigned) result.stats.stop_ticks);
+}
+
+// The task periods before the tickless idle: audio and system every 25 ms, BT every 10 ms even with the chip off
+const std::vector<Source> fixed_periods = {
+    {"audio", 25'000}, {"system", 25'000}, {"bluetooth", 10'000}, {"soc", 10'000}};
+// Standby: nothing animated, no console input, BT chip off
+const std::vector<Source> standby_periods = {{"audio", 200'000}, {"system", 500'000}, {"soc", 10'000}};
+// Playback: BT chip on, LEDs idle
+const std::vector<Source> playback_periods = {
+    {"audio", 200'000}, {"system", 500'000}, {"bluetooth", 10'000}, {"soc", 10'000}};
+
+// A continuous ADC scan, the DMA interrupted on half and full transfer before
+const std::vector<Source> adc_half_and_full = {{"adc", adc_scan_us / 2}};
+const std::vector<Source> adc_full_only     = {{"adc", adc_scan_us}};
+
+TEST(LowPowerDecide, RunsBelowTheMinimumSleepTime)
+{
+    EXPECT_EQ(low_power_decide(&config, 1, 0).mode, LOW_POWER_MODE_RUN);
+    EXPECT_EQ(low_power_decide(nullptr, 100, 0).mode, LOW_POWER_MODE_RUN);
+}
+
+TEST(LowPowerDecide, SleepsWhileLockedOrShort)
+{
+    auto decision = low_power_decide(&config, 1000, 1);
+    EXPECT_EQ(decision.mode, LOW_POWER_MODE_SLEEP);
+    EXPECT_EQ(decision.ticks, config.max_sleep_ticks);
+
+    decision = low_power_decide(&config, 4, 0);
+    EXPECT_EQ(decision.mode, LOW_POWER_MODE_SLEEP);
+    EXPECT_EQ(decision.ticks, 4u);
+}
+
+TEST(LowPowerDecide, StopsWhenUnlocked)
+{
+    auto decision = low_power_decide(&config, 5, 0);
+    EXPECT_EQ(decision.mode, LOW_POWER_MODE_STOP);
+    EXPECT_EQ(decision.ticks, 5u);
+
+    decision = low_power_decide(&config, UINT32_MAX, 0);
+    EXPECT_EQ(decision.mode, LOW_POWER_MODE_STOP);
+    EXPECT_EQ(decision.ticks, config.max_stop_ticks);
+}
+
+TEST(LowPowerStats, IgnoresRun)
+{
+    low_power_stats_t stats = {};
+    low_power_stats_add(&stats, LOW_POWER_MODE_RUN, 3);
+    low_power_stats_add(&stats, LOW_POWER_MODE_SLEEP, 4);
+    low_power_stats_add(&stats, LOW_POWER_MODE_STOP, 5);
+    EXPECT_EQ(stats.wakeups, 2u);
+    EXPECT_EQ(stats.sleep_ticks, 4u);
+    EXPECT_EQ(stats.stop_ticks, 5u);
+}
+
+TEST(LowPowerSim, Standby)
+{
+    const Result before = simulate({false, fixed_periods, adc_half_and_full, true});
+    const Result continuous = simulate({true, standby_periods, adc_full_only, true});
+    // Off, the battery samples the ADC on demand once per audio task wakeup
+    const Result after = simulate({true, standby_periods, {}, false, true});
+
+    print("standby, 1 kHz tick", before);
+    print("standby, tickless, ADC scan", continuous);
+    print("standby, tickless", after);
+
+    EXPECT_LT(continuous.wakeups_per_s, before.wakeups_per_s * 0.4);
+    EXPECT_LT(continuous.average_ma, before.average_ma);
+    EXPECT_EQ(continuous.stats.stop_ticks, 0u);
+    EXPECT_GT(after.stats.stop_ticks, 0u);
+    EXPECT_LT(after.average_ma, continuous.average_ma / 10);
+    EXPECT_EQ(continuous.stop_with_lock, 0u);
+    EXPECT_EQ(after.stop_with_lock, 0u);
+}
+
+TEST(LowPowerSim, Playback)
+{
+    const Result before = simulate({false, fixed_periods, adc_half_and_full, true});
+    const Result after  = simulate({true, playback_periods, adc_full_only, true});
+
+    print("playback, 1 kHz tick", before);
+    print("playback, tickless", after);
+
+    EXPECT_LT(after.wakeups_per_s, before.wakeups_per_s);
+    EXPECT_LE(after.average_ma, before.average_ma);
+    EXPECT_EQ(after.stop_with_lock, 0u);
+}
+
+} // namespace
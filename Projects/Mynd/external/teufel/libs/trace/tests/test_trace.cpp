@@ -0,0 +1,220 @@
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "trace.h"
+
+namespace
+{
+
+constexpr uint32_t RECORDS = 16;
+
+trace_record_t        records[RECORDS];
+std::atomic<uint32_t> fake_time{0};
+
+uint32_t get_time()
+{
+    return fake_time.fetch_add(10);
+}
+
+std::vector<trace_record_t> read_all(uint32_t *p_seq)
+{
+    std::vector<trace_record_t> result;
+    trace_record_t              chunk[5];
+    uint32_t                    count;
+
+    while ((count = trace_read(p_seq, chunk, 5)) != 0)
+    {
+        result.insert(result.end(), chunk, chunk + count);
+    }
+    return result;
+}
+
+std::string dump_output;
+
+int capture_dump(const char *p_format, ...)
+{
+    char    line[64];
+    va_list args;
+    va_start(args, p_format);
+    int length = vsnprintf(line, sizeof(line), p_format, args);
+    va_end(args);
+    dump_output += line;
+    return length;
+}
+
+class TraceTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        fake_time = 0;
+        ASSERT_EQ(trace_init(records, RECORDS, get_time), 0);
+    }
+};
+
+} // namespace
+
+TEST_F(TraceTest, RejectsUnsupportedCount)
+{
+    trace_record_t storage[12];
+    EXPECT_EQ(trace_init(storage, 12, get_time), -1);
+    EXPECT_EQ(trace_init(storage, 1, get_time), -1);
+    EXPECT_EQ(trace_init(storage, 8, nullptr), -1);
+}
+
+TEST_F(TraceTest, RecordsInOrder)
+{
+    for (uint16_t i = 0; i < 5; i++)
+        TRACE(i + 1, i * 100);
+
+    uint32_t seq    = 0;
+    auto     result = read_all(&seq);
+
+    ASSERT_EQ(result.size(), 5u);
+    for (uint16_t i = 0; i < 5; i++)
+    {
+        EXPECT_EQ(result[i].seq, i + 1u);
+        EXPECT_EQ(result[i].timestamp, i * 10u);
+        EXPECT_EQ(result[i].event, i + 1);
+        EXPECT_EQ(result[i].arg, i * 100);
+    }
+    EXPECT_EQ(seq, 6u);
+
+    // Only new records are read next time
+    TRACE(9, 9);
+    result = read_all(&seq);
+    ASSERT_EQ(result.size(), 1u);
+    EXPECT_EQ(result[0].seq, 6u);
+}
+
+TEST_F(TraceTest, WrapsAroundKeepingTheNewestRecords)
+{
+    for (uint16_t i = 0; i < 3 * RECORDS + 5; i++)
+        TRACE(1, i);
+
+    uint32_t seq    = 0;
+    auto     result = read_all(&seq);
+
+    ASSERT_EQ(result.size(), RECORDS);
+    for (uint32_t i = 0; i < RECORDS; i++)
+    {
+        EXPECT_EQ(result[i].seq, 2 * RECORDS + 6 + i);
+        EXPECT_EQ(result[i].arg, 2 * RECORDS + 5 + i);
+    }
+
+    // A reader which fell behind skips the overwritten records
+    seq = 3;
+    TRACE(2, 0);
+    result = read_all(&seq);
+    ASSERT_EQ(result.size(), RECORDS);
+    EXPECT_EQ(result.front().seq, 2 * RECORDS + 7);
+    EXPECT_EQ(result.back().event, 2);
+}
+
+TEST_F(TraceTest, StopsAtRecordStillWritten)
+{
+    TRACE(1, 1);
+    TRACE(1, 2);
+    TRACE(1, 3);
+
+    // Second record reserved but not committed yet, as if its writer was preempted
+    records[2].seq = 0;
+
+    uint32_t seq    = 0;
+    auto     result = read_all(&seq);
+    ASSERT_EQ(result.size(), 1u);
+    EXPECT_EQ(seq, 2u);
+
+    records[2].seq = 2;
+    result         = read_all(&seq);
+    ASSERT_EQ(result.size(), 2u);
+    EXPECT_EQ(result[0].arg, 2);
+}
+
+TEST_F(TraceTest, ClearAndDump)
+{
+    TRACE(1, 1);
+    TRACE(1, 2);
+    trace_clear();
+    TRACE(3, 7);
+
+    dump_output.clear();
+    uint32_t printed = trace_dump(capture_dump);
+
+    EXPECT_EQ(printed, 1u);
+    EXPECT_EQ(dump_output, "T 3 20 3 7\r\n");
+}
+
+TEST_F(TraceTest, ConcurrentWritersAndReader)
+{
+    constexpr unsigned WRITERS = 4;
+    constexpr unsigned EVENTS  = 50000;
+
+    std::atomic<bool> done{false};
+    size_t            read_records = 0;
+
+    // Per writer the arguments have to increase, a torn record would mix event and argument of two writers
+    std::thread reader(
+        [&]()
+        {
+            std::vector<int> last_arg(WRITERS, -1);
+            uint32_t         seq       = 0;
+            uint32_t         last_seq  = 0;
+            trace_record_t   chunk[8];
+
+            while (!done || trace_get_next_seq() != seq)
+            {
+                uint32_t count = trace_read(&seq, chunk, 8);
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    ASSERT_LT(chunk[i].event, WRITERS);
+                    ASSERT_GT((int) chunk[i].arg, last_arg[chunk[i].event]);
+                    ASSERT_GT(chunk[i].seq, last_seq);
+                    last_arg[chunk[i].event] = chunk[i].arg;
+                    last_seq                 = chunk[i].seq;
+                }
+                read_records += count;
+                if (done && count == 0)
+                    break;
+            }
+        });
+
+    std::vector<std::thread> writers;
+    for (unsigned w = 0; w < WRITERS; w++)
+    {
+        writers.emplace_back(
+            [&, w]()
+            {
+                for (unsigned i = 0; i < EVENTS; i++)
+                {
+                    TRACE(w, i & 0xFFFF);
+                    // Lets the reader keep up now and then, otherwise it mostly sees overwritten records
+                    if ((i % 64) == 0)
+                        std::this_thread::yield();
+                }
+            });
+    }
+
+    for (auto &writer : writers)
+        writer.join();
+    done = true;
+    reader.join();
+
+    EXPECT_EQ(trace_get_next_seq(), WRITERS * EVENTS + 1);
+    EXPECT_GT(read_records, 0u);
+
+    // After the writers are done the ring holds the newest records, all of them readable
+    uint32_t seq    = 0;
+    auto     result = read_all(&seq);
+    EXPECT_EQ(result.size(), RECORDS);
+    EXPECT_EQ(result.back().seq, WRITERS * EVENTS);
+
+    printf("%u writers, %u events, %zu read concurrently through %u records\r\n", WRITERS, WRITERS * EVENTS,
+           read_records, RECORDS);
+}
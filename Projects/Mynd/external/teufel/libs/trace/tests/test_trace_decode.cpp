@@ -0,0 +1,100 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "trace_decode.h"
+
+namespace
+{
+
+std::vector<trace_decode_record_t> decode(const std::vector<std::string> &lines)
+{
+    std::vector<trace_decode_record_t> records;
+    for (const auto &line : lines)
+    {
+        trace_decode_record_t record;
+        if (trace_decode_line(line.c_str(), &record) == 0)
+            records.push_back(record);
+    }
+    records.resize(trace_decode_sort(records.data(), records.size()));
+    return records;
+}
+
+std::string print(const std::vector<trace_decode_record_t> &records, const char *const *p_names, size_t names_count,
+                  uint32_t us_per_tick)
+{
+    char  *p_buffer = nullptr;
+    size_t size     = 0;
+    FILE  *p_file   = open_memstream(&p_buffer, &size);
+
+    trace_decode_print(p_file, records.data(), records.size(), p_names, names_count, us_per_tick);
+    fclose(p_file);
+
+    std::string output(p_buffer, size);
+    free(p_buffer);
+    return output;
+}
+
+} // namespace
+
+TEST(TraceDecodeTest, ParsesDumpLinesOutOfConsoleLog)
+{
+    trace_decode_record_t record;
+
+    EXPECT_EQ(trace_decode_line("T 12 345678 3 65535\r\n", &record), 0);
+    EXPECT_EQ(record.seq, 12u);
+    EXPECT_EQ(record.timestamp, 345678u);
+    EXPECT_EQ(record.event, 3);
+    EXPECT_EQ(record.arg, 65535);
+
+    EXPECT_EQ(trace_decode_line("[12:00:01.123] T 13 4294967295 1 0", &record), 0);
+    EXPECT_EQ(record.seq, 13u);
+    EXPECT_EQ(record.timestamp, 4294967295u);
+
+    EXPECT_EQ(trace_decode_line("[Sys] INFO: Turning on", &record), -1);
+    EXPECT_EQ(trace_decode_line("T 0 10 1 1", &record), -1);
+    EXPECT_EQ(trace_decode_line("T 1 10 65536 1", &record), -1);
+    EXPECT_EQ(trace_decode_line("T 1 10", &record), -1);
+}
+
+TEST(TraceDecodeTest, MergesOverlappingDumps)
+{
+    auto records = decode({"T 3 300 1 0", "T 4 400 1 0", "some log", "T 1 100 1 0", "T 2 200 1 0", "T 3 300 1 0",
+                           "T 4 400 1 0", "T 5 500 1 0"});
+
+    ASSERT_EQ(records.size(), 5u);
+    for (uint32_t i = 0; i < 5; i++)
+        EXPECT_EQ(records[i].seq, i + 1);
+}
+
+TEST(TraceDecodeTest, TimelineAcrossTimestampWrapAndLostRecords)
+{
+    auto records = decode({"T 10 4294967000 0 0", "T 11 200 0 0", "T 15 1200 0 0", "T 16 1150 0 0"});
+
+    std::vector<trace_decode_time_t> times(records.size());
+    trace_decode_times(records.data(), records.size(), times.data());
+
+    EXPECT_EQ(times[0].time, 0);
+    EXPECT_EQ(times[0].lost, 0u);
+    EXPECT_EQ(times[1].delta, 496);
+    EXPECT_EQ(times[1].time, 496);
+    EXPECT_EQ(times[2].delta, 1000);
+    EXPECT_EQ(times[2].lost, 3u);
+    EXPECT_EQ(times[3].delta, -50);
+    EXPECT_EQ(times[3].time, 1446);
+}
+
+TEST(TraceDecodeTest, PrintsNamedTimeline)
+{
+    static const char *const names[] = {"POWER_ON_BEGIN", "POWER_ON_DONE"};
+
+    auto records = decode({"T 1 1000 0 0", "T 2 1500 7 4", "T 4 3000 1 2"});
+
+    EXPECT_EQ(print(records, names, 2, 1000), "       0.000 ms      +0.000 ms  POWER_ON_BEGIN               0\n"
+                                              "     500.000 ms    +500.000 ms  event 7                      4\n"
+                                              "                         ... 1 records lost\n"
+                                              "    2000.000 ms   +1500.000 ms  POWER_ON_DONE                2\n");
+}
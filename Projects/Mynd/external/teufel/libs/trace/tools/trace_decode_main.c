@@ -0,0 +1,55 @@
+// Decodes trace dumps from a console log into a timeline:
+//
+//   trace_decode [us per tick] < console.log
+//
+// Event names come from the TRACE_EVENTS(X) list of the header given by TRACE_EVENTS_HEADER at build time.
+
+#include <stdlib.h>
+
+#include "trace_decode.h"
+
+#if defined(TRACE_EVENTS_HEADER)
+#include TRACE_EVENTS_HEADER
+#define TRACE_EVENT_NAME(name) #name,
+static const char *const event_names[] = {TRACE_EVENTS(TRACE_EVENT_NAME)};
+#define EVENT_NAMES_COUNT (sizeof(event_names) / sizeof(event_names[0]))
+#else
+static const char *const *const event_names = NULL;
+#define EVENT_NAMES_COUNT 0u
+#endif
+
+int main(int argc, char **argv)
+{
+    uint32_t               us_per_tick = (argc > 1) ? (uint32_t) strtoul(argv[1], NULL, 0) : 1u;
+    trace_decode_record_t *p_records   = NULL;
+    size_t                 count       = 0;
+    size_t                 capacity    = 0;
+    char                   line[256];
+
+    while (fgets(line, sizeof(line), stdin) != NULL)
+    {
+        trace_decode_record_t record;
+        if (trace_decode_line(line, &record) != 0)
+        {
+            continue;
+        }
+
+        if (count == capacity)
+        {
+            capacity  = (capacity != 0) ? capacity * 2 : 256;
+            p_records = realloc(p_records, capacity * sizeof(p_records[0]));
+            if (p_records == NULL)
+            {
+                fprintf(stderr, "Out of memory\n");
+                return 1;
+            }
+        }
+        p_records[count++] = record;
+    }
+
+    count = trace_decode_sort(p_records, count);
+    trace_decode_print(stdout, p_records, count, event_names, EVENT_NAMES_COUNT, us_per_tick);
+
+    free(p_records);
+    return 0;
+}
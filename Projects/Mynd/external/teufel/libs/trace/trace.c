@@ -0,0 +1,177 @@
+#include <stddef.h>
+
+#include "trace.h"
+
+#define DUMP_CHUNK 8u
+
+static struct
+{
+    trace_record_t     *p_records;
+    uint32_t            count;
+    volatile uint32_t   next_seq;  // Sequence number of the next record, counted from 1
+    volatile uint32_t   first_seq; // Oldest record which was not cleared
+    trace_get_time_fn_t get_time_fn;
+} s_trace;
+
+static inline uint32_t load_acquire(volatile uint32_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void store_release(volatile uint32_t *p, uint32_t value)
+{
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+// Cortex-M0 has no exclusive load/store. The timestamp is taken together with the sequence number while the
+// interrupts are masked for a few instructions, so that the records are ordered by both. Other targets and the
+// host tests use the compiler's atomic builtin, concurrent records may be slightly out of order by timestamp there.
+static inline uint32_t reserve(uint32_t *p_timestamp)
+{
+#if defined(__ARM_ARCH_6M__)
+    uint32_t primask;
+    uint32_t seq;
+
+    __asm volatile("MRS %0, primask" : "=r"(primask));
+    __asm volatile("cpsid i" ::: "memory");
+    *p_timestamp     = s_trace.get_time_fn();
+    seq              = s_trace.next_seq;
+    s_trace.next_seq = seq + 1u;
+    __asm volatile("MSR primask, %0" ::"r"(primask) : "memory");
+
+    return seq;
+#else
+    *p_timestamp = s_trace.get_time_fn();
+    return __atomic_fetch_add(&s_trace.next_seq, 1u, __ATOMIC_ACQ_REL);
+#endif
+}
+
+static inline int is_overwritten(uint32_t seq)
+{
+    return load_acquire(&s_trace.next_seq) - seq > s_trace.count;
+}
+
+int trace_init(trace_record_t *p_records, uint32_t count, trace_get_time_fn_t get_time_fn)
+{
+    if (count < 2u || (count & (count - 1u)) != 0u || get_time_fn == NULL)
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        p_records[i].seq = 0;
+    }
+
+    s_trace.count       = count;
+    s_trace.next_seq    = 1;
+    s_trace.first_seq   = 1;
+    s_trace.get_time_fn = get_time_fn;
+    __atomic_store_n(&s_trace.p_records, p_records, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+void trace_event(uint16_t event, uint16_t arg)
+{
+    trace_record_t *p_records = __atomic_load_n(&s_trace.p_records, __ATOMIC_ACQUIRE);
+    uint32_t        timestamp;
+
+    if (p_records == NULL)
+    {
+        return;
+    }
+
+    uint32_t        seq      = reserve(&timestamp);
+    trace_record_t *p_record = &p_records[seq & (s_trace.count - 1u)];
+
+    // Readers discard the record from here until it is committed
+    store_release(&p_record->seq, 0);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    p_record->timestamp = timestamp;
+    p_record->event     = event;
+    p_record->arg       = arg;
+
+    store_release(&p_record->seq, seq);
+}
+
+uint32_t trace_read(uint32_t *p_seq, trace_record_t *p_records, uint32_t max_count)
+{
+    uint32_t next_seq = load_acquire(&s_trace.next_seq);
+    uint32_t seq      = *p_seq;
+    uint32_t copied   = 0;
+
+    if (s_trace.p_records == NULL)
+    {
+        return 0;
+    }
+
+    if (seq < load_acquire(&s_trace.first_seq))
+    {
+        seq = load_acquire(&s_trace.first_seq);
+    }
+    if (next_seq - seq > s_trace.count)
+    {
+        seq = next_seq - s_trace.count;
+    }
+
+    while (copied < max_count && seq != next_seq)
+    {
+        trace_record_t *p_record = &s_trace.p_records[seq & (s_trace.count - 1u)];
+
+        uint32_t before             = load_acquire(&p_record->seq);
+        p_records[copied].timestamp = p_record->timestamp;
+        p_records[copied].event     = p_record->event;
+        p_records[copied].arg       = p_record->arg;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        uint32_t after = load_acquire(&p_record->seq);
+
+        if (before == seq && after == seq)
+        {
+            p_records[copied].seq = seq;
+            copied++;
+        }
+        else if (!is_overwritten(seq))
+        {
+            // Still written, the records after it are read next time
+            break;
+        }
+        seq++;
+    }
+
+    *p_seq = seq;
+    return copied;
+}
+
+uint32_t trace_get_next_seq(void)
+{
+    return load_acquire(&s_trace.next_seq);
+}
+
+void trace_clear(void)
+{
+    store_release(&s_trace.first_seq, load_acquire(&s_trace.next_seq));
+}
+
+uint32_t trace_dump(trace_print_fn_t print_fn)
+{
+    trace_record_t records[DUMP_CHUNK];
+    uint32_t       seq     = 0;
+    uint32_t       end_seq = trace_get_next_seq();
+    uint32_t       printed = 0;
+    uint32_t       count;
+
+    // Records added while dumping are left for the next dump
+    while ((int32_t) (end_seq - seq) > 0 && (count = trace_read(&seq, records, DUMP_CHUNK)) != 0)
+    {
+        for (uint32_t i = 0; i < count && (int32_t) (end_seq - records[i].seq) > 0; i++)
+        {
+            print_fn("T %lu %lu %u %u\r\n", (unsigned long) records[i].seq, (unsigned long) records[i].timestamp,
+                     (unsigned) records[i].event, (unsigned) records[i].arg);
+            printed++;
+        }
+    }
+
+    return printed;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+// Set to 0 to compile out the TRACE() calls
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+    /**
+     * @brief One trace record, 12 bytes.
+     * @details seq is 0 while the record is written and its sequence number, counted from 1, once it is committed.
+     *          A reader copies the record between two reads of seq and discards it if they differ.
+     */
+    typedef struct
+    {
+        volatile uint32_t seq;
+        uint32_t          timestamp; // as returned by the time function, e.g. microseconds
+        uint16_t          event;
+        uint16_t          arg;
+    } trace_record_t;
+
+    typedef uint32_t (*trace_get_time_fn_t)(void);
+    typedef int (*trace_print_fn_t)(const char *p_format, ...);
+
+    /**
+     * @brief Initializes the trace ring, records are overwritten oldest first once it is full.
+     * @param p_records storage for the records
+     * @param count number of records, a power of two
+     * @param get_time_fn timestamp of a record, callable from tasks and ISRs
+     * @return 0 on success, -1 if the count is not supported
+     */
+    int trace_init(trace_record_t *p_records, uint32_t count, trace_get_time_fn_t get_time_fn);
+
+    /**
+     * @brief Records an event. Safe to call from tasks and ISRs, doesn't do anything before trace_init().
+     */
+    void trace_event(uint16_t event, uint16_t arg);
+
+    /**
+     * @brief Copies committed records starting with sequence number *p_seq.
+     * @details Records which were overwritten already are skipped, *p_seq is advanced past the last copied record.
+     *          Copying stops at a record which is still written.
+     * @return number of records copied
+     */
+    uint32_t trace_read(uint32_t *p_seq, trace_record_t *p_records, uint32_t max_count);
+
+    /**
+     * @brief Sequence number the next record gets.
+     */
+    uint32_t trace_get_next_seq(void);
+
+    /**
+     * @brief Discards all records.
+     */
+    void trace_clear(void);
+
+    /**
+     * @brief Prints all records, one "T <seq> <timestamp> <event> <arg>" line each, for trace_decode on the host.
+     * @return number of records printed
+     */
+    uint32_t trace_dump(trace_print_fn_t print_fn);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#if TRACE_ENABLED
+#define TRACE(event, arg) trace_event((uint16_t) (event), (uint16_t) (arg))
+#else
+#define TRACE(event, arg) ((void) 0)
+#endif
@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace_decode.h"
+
+static int compare_seq(const void *p_a, const void *p_b)
+{
+    uint32_t a = ((const trace_decode_record_t *) p_a)->seq;
+    uint32_t b = ((const trace_decode_record_t *) p_b)->seq;
+
+    return (a > b) - (a < b);
+}
+
+int trace_decode_line(const char *p_line, trace_decode_record_t *p_record)
+{
+    unsigned long seq, timestamp;
+    unsigned      event, arg;
+    char          end;
+
+    // The line may carry a prefix of the console, e.g. a terminal timestamp
+    const char *p_start = p_line;
+    while ((p_start = strchr(p_start, 'T')) != NULL)
+    {
+        if (sscanf(p_start, "T %lu %lu %u %u%c", &seq, &timestamp, &event, &arg, &end) >= 4 && seq != 0 &&
+            seq <= UINT32_MAX && timestamp <= UINT32_MAX && event <= UINT16_MAX && arg <= UINT16_MAX)
+        {
+            p_record->seq       = (uint32_t) seq;
+            p_record->timestamp = (uint32_t) timestamp;
+            p_record->event     = (uint16_t) event;
+            p_record->arg       = (uint16_t) arg;
+            return 0;
+        }
+        p_start++;
+    }
+
+    return -1;
+}
+
+size_t trace_decode_sort(trace_decode_record_t *p_records, size_t count)
+{
+    size_t kept = 0;
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    qsort(p_records, count, sizeof(p_records[0]), compare_seq);
+
+    for (size_t i = 1; i < count; i++)
+    {
+        if (p_records[i].seq != p_records[kept].seq)
+        {
+            p_records[++kept] = p_records[i];
+        }
+    }
+
+    return kept + 1;
+}
+
+// Signed, records of concurrent writers may be slightly out of order by timestamp
+static trace_decode_time_t next_time(const trace_decode_record_t *p_previous, const trace_decode_record_t *p_record,
+                                     const trace_decode_time_t *p_previous_time)
+{
+    trace_decode_time_t entry = {0, 0, 0};
+
+    if (p_previous != NULL)
+    {
+        entry.delta = (int32_t) (p_record->timestamp - p_previous->timestamp);
+        entry.time  = p_previous_time->time + entry.delta;
+        entry.lost  = p_record->seq - p_previous->seq - 1u;
+    }
+
+    return entry;
+}
+
+void trace_decode_times(const trace_decode_record_t *p_records, size_t count, trace_decode_time_t *p_times)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        p_times[i] = next_time((i > 0) ? &p_records[i - 1] : NULL, &p_records[i], (i > 0) ? &p_times[i - 1] : NULL);
+    }
+}
+
+void trace_decode_print(FILE *p_file, const trace_decode_record_t *p_records, size_t count,
+                        const char *const *p_names, size_t names_count, uint32_t us_per_tick)
+{
+    trace_decode_time_t entry = {0, 0, 0};
+
+    for (size_t i = 0; i < count; i++)
+    {
+        entry = next_time((i > 0) ? &p_records[i - 1] : NULL, &p_records[i], &entry);
+
+        if (entry.lost != 0)
+        {
+            fprintf(p_file, "%28s %lu records lost\n", "...", (unsigned long) entry.lost);
+        }
+
+        fprintf(p_file, "%12.3f ms %+11.3f ms  ", (double) entry.time * us_per_tick / 1000.0,
+                (double) entry.delta * us_per_tick / 1000.0);
+
+        uint16_t event = p_records[i].event;
+        if (event < names_count && p_names[event] != NULL)
+        {
+            fprintf(p_file, "%-28s %u\n", p_names[event], (unsigned) p_records[i].arg);
+        }
+        else
+        {
+            fprintf(p_file, "event %-22u %u\n", (unsigned) event, (unsigned) p_records[i].arg);
+        }
+    }
+}
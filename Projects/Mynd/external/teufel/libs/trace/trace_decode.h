@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Host side decoder of trace_dump() output.
+     * @details Dumps are picked out of a captured console log, merged, ordered by sequence number and printed as a
+     *          timeline with the time since the first record and since the previous one.
+     */
+    typedef struct
+    {
+        uint32_t seq;
+        uint32_t timestamp;
+        uint16_t event;
+        uint16_t arg;
+    } trace_decode_record_t;
+
+    typedef struct
+    {
+        int64_t  time;  // since the first record, in timestamp units
+        int32_t  delta; // since the previous record
+        uint32_t lost;  // records missing before this one, overwritten before they were dumped
+    } trace_decode_time_t;
+
+    /**
+     * @brief Parses one line of a dump, other lines of the console log are ignored.
+     * @return 0 if the line is a trace record, -1 otherwise
+     */
+    int trace_decode_line(const char *p_line, trace_decode_record_t *p_record);
+
+    /**
+     * @brief Orders records by sequence number and removes duplicates, e.g. from overlapping dumps.
+     * @return number of records left
+     */
+    size_t trace_decode_sort(trace_decode_record_t *p_records, size_t count);
+
+    /**
+     * @brief Computes the timeline of sorted records. Timestamps may wrap around between records.
+     */
+    void trace_decode_times(const trace_decode_record_t *p_records, size_t count, trace_decode_time_t *p_times);
+
+    /**
+     * @brief Prints the timeline of sorted records.
+     * @param p_names event names indexed by event ID, events without a name are printed by ID
+     * @param us_per_tick timestamp resolution, e.g. 1 for microseconds or 1000 for milliseconds
+     */
+    void trace_decode_print(FILE *p_file, const trace_decode_record_t *p_records, size_t count,
+                            const char *const *p_names, size_t names_count, uint32_t us_per_tick);
+
+#if defined(__cplusplus)
+}
+#endif
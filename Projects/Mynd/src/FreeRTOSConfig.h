@@ -6,7 +6,7 @@ extern uint32_t SystemCoreClock;
 #define portREMOVE_STATIC_QUALIFIER
 
 #define configUSE_PREEMPTION                  1
-#define configUSE_TICKLESS_IDLE               0
+#define configUSE_TICKLESS_IDLE               2
 #define configSUPPORT_STATIC_ALLOCATION       1
 #define configSUPPORT_DYNAMIC_ALLOCATION      0
 #define configCPU_CLOCK_HZ                    (SystemCoreClock)
@@ -115,3 +115,12 @@ standard names. */
 /* IMPORTANT: This define MUST be commented when used with STM32Cube firmware,
               to prevent overwriting SysTick_Handler defined within STM32Cube HAL */
 #define xPortSysTickHandler SysTick_Handler
+
+/* Tickless idle with SLEEP and STOP mode, see board_low_power.c. Idle times of a single tick are slept by the idle
+   hook until the next interrupt, 2 is the minimum the kernel accepts. */
+#define configEXPECTED_IDLE_TIME_BEFORE_SLEEP 2
+#ifdef __cplusplus
+extern "C"
+#endif
+    void board_low_power_sleep(uint32_t expected_idle_ticks);
+#define portSUPPRESS_TICKS_AND_SLEEP(expected_idle_ticks) board_low_power_sleep(expected_idle_ticks)
@@ -73,10 +73,18 @@ PROPERTY_ENUM_SET(Tus::ChargeType, m_charge_type)
 
 // The buffer of ADC values needs to be uint16_t because the DMA transfers 16 bits at a time
 // because the ADC is configured to 12 bits resolution
-static uint16_t __attribute__((aligned(4))) s_adc_buffer[12 * 6];
+static constexpr auto c_adc_number_of_samples_per_conversion = 12u;
+static constexpr auto c_adc_number_of_sampled_channels       = 6u;
+static constexpr auto c_adc_buffer_size = c_adc_number_of_samples_per_conversion * c_adc_number_of_sampled_channels;
+static uint16_t __attribute__((aligned(4))) s_adc_buffer[c_adc_buffer_size];
+
+// The continuous scan keeps the MCU out of STOP mode. While the speaker is off, one scan per battery voltage reading
+// is enough for the temperature and the battery level, the current hardly changes then.
+static constexpr uint32_t c_adc_sample_period_ms = 200;
 
 static float              calculate_battery_current_milliamps(uint32_t vcc_mv, int32_t isns_ref, int32_t isns);
 static std::optional<int> get_battery_current();
+static void               start_adc_scan();
 
 static SemaphoreHandle_t sys_adc_buffer_mutex = nullptr;
 static StaticSemaphore_t sys_adc_buffer_mutex_buffer;
@@ -155,13 +163,6 @@ void init()
 
     xTimerStart(soc_timer, 0);
 
-    constexpr auto c_adc_number_of_samples_per_conversion = 12u;
-    static auto    adc_number_of_sampled_channels         = 6u;
-    static auto    adc_buffer_size = c_adc_number_of_samples_per_conversion * adc_number_of_sampled_channels;
-
-    APP_ASSERT(adc_buffer_size <= sizeof(s_adc_buffer) / sizeof(uint16_t),
-               "s_adc_buffer is too small to hold the samples");
-
     sys_adc_buffer_mutex = xSemaphoreCreateMutexStatic(&sys_adc_buffer_mutex_buffer);
 
     APP_ASSERT(sys_adc_buffer_mutex != nullptr, "Failed to create mutex");
@@ -177,7 +178,12 @@ void init()
         s_battery.is_charger_initialized = true;
     }
 
-    bsp_adc_start((uint32_t *) s_adc_buffer, adc_buffer_size,
+    start_adc_scan();
+}
+
+static void start_adc_scan()
+{
+    bsp_adc_start((uint32_t *) s_adc_buffer, c_adc_buffer_size,
                   +[]()
                   {
                       if (xSemaphoreTakeFromISR(sys_adc_buffer_mutex, NULL) == pdFALSE)
@@ -189,7 +195,7 @@ void init()
                       s_sample_tick_last = std::exchange(tick, get_systick());
 
                       // TODO: drop it, after PP samples are not used anymore
-                      for (uint32_t i = 0; i < adc_buffer_size; i += adc_number_of_sampled_channels)
+                      for (uint32_t i = 0; i < c_adc_buffer_size; i += c_adc_number_of_sampled_channels)
                       {
                           bat_voltage_smoother(s_adc_buffer[i]);
                           isens_ref_smoother(s_adc_buffer[i + 1]);
@@ -203,6 +209,27 @@ void init()
                   });
 }
 
+static void sample_adc()
+{
+    static bool     is_scanning    = true;
+    static uint32_t last_sample_ts = 0;
+
+    if (const bool scan = not isProperty(Tus::PowerState::Off); scan != is_scanning)
+    {
+        is_scanning = scan;
+        if (scan)
+            start_adc_scan();
+        else
+            bsp_adc_stop();
+    }
+
+    if (not is_scanning && board_get_ms_since(last_sample_ts) >= c_adc_sample_period_ms)
+    {
+        last_sample_ts = get_systick();
+        bsp_adc_sample_once();
+    }
+}
+
 static BatteryIndicator battery_indicator{
     +[]() { Teufel::Task::Audio::postMessage(Tus::Task::Audio, Tus::BatteryLowLevelState::Below5Percent); },
     +[]() { Teufel::Task::Audio::postMessage(Tus::Task::Audio, Tus::BatteryLowLevelState::Below10Percent); }};
@@ -214,6 +241,7 @@ void set_power_state(const Tus::PowerState &state)
         // This call cover the case when the system starts while the phone is plugged. In this case, it keeps
         // drawing power from the phone. We want to switch to source mode to avoid this.
         board_link_usb_pd_controller_swap_to_srouce();
+        board_link_charger_invalidate_cache();
 
         // The previous call (swap_to_source) will "reset" the charger configuration, therefore
         // we need to re-enable the charger according to the current charger state.
@@ -417,26 +445,21 @@ static void update_battery_temperature()
 
 static void check_charger_status_to_play_sound_icon()
 {
-    static bool     is_charger_connected          = false;
-    static uint32_t last_charger_status_update_ts = 0u;
-    if (board_get_ms_since(last_charger_status_update_ts) > 1000)
+    static bool is_charger_connected = false;
+
+    auto charger_connected_status = CHARGER_STATUS_UNDEFINED;
+    auto ec                       = board_link_charger_get_status(&charger_connected_status);
+    if (ec == 0)
     {
-        auto charger_connected_status = CHARGER_STATUS_UNDEFINED;
-        auto ec                       = board_link_charger_get_status(&charger_connected_status);
-        if (ec == 0)
+        if (charger_connected_status == CHARGER_STATUS_CONNECTED && !is_charger_connected)
         {
-            if (charger_connected_status == CHARGER_STATUS_CONNECTED && !is_charger_connected)
-            {
-                Teufel::Task::Bluetooth::postMessage(
-                    Teufel::Ux::System::Task::Audio,
-                    Teufel::Ux::Audio::RequestSoundIcon{ACTIONSLINK_SOUND_ICON_CHARGING,
-                                                        ACTIONSLINK_SOUND_ICON_PLAYBACK_MODE_PLAY_AFTER_CURRENT,
-                                                        false});
-            }
+            Teufel::Task::Bluetooth::postMessage(
+                Teufel::Ux::System::Task::Audio,
+                Teufel::Ux::Audio::RequestSoundIcon{ACTIONSLINK_SOUND_ICON_CHARGING,
+                                                    ACTIONSLINK_SOUND_ICON_PLAYBACK_MODE_PLAY_AFTER_CURRENT, false});
         }
-        is_charger_connected          = (ec == 0) ? (charger_connected_status == CHARGER_STATUS_CONNECTED) : false;
-        last_charger_status_update_ts = get_systick();
     }
+    is_charger_connected = (ec == 0) ? (charger_connected_status == CHARGER_STATUS_CONNECTED) : false;
 }
 
 static auto power_bank_in_low_battery_mode =
@@ -464,6 +487,8 @@ static void monitor_power_bank_mode()
 
 void poll()
 {
+    sample_adc();
+
     // Calculate NTC temperature
     update_battery_temperature();
 
@@ -492,7 +517,7 @@ void poll()
     // Retry setup if it failed before
     if (not s_battery.is_charger_initialized)
     {
-        s_battery.is_charger_initialized = board_link_charger_setup();
+        s_battery.is_charger_initialized = board_link_charger_setup() == 0;
 
         // If it still fails, don't do anything and try again on next poll
         if (not s_battery.is_charger_initialized)
@@ -504,8 +529,6 @@ void poll()
         set_charge_type(charge_type);
     }
 
-    check_charger_status_to_play_sound_icon();
-
     if (s_battery.is_battery_voltage_stable)
     {
         Teufel::Core::callOnce([]() { soc_estimator.init(s_battery.last_battery_voltage_mv); });
@@ -521,9 +544,15 @@ void poll()
     }
 #endif // INCLUDE_PRODUCTION_TESTS
 
-    static int cnt = 1;
-    if (cnt++ % 40 == 0)
+    // Once a second, poll() runs at different rates depending on the audio task's idle period. Both read the charger
+    // status, back to back they share the read.
+    static uint32_t last_charger_status_ts = 0;
+    if (board_get_ms_since(last_charger_status_ts) >= 1000)
+    {
+        last_charger_status_ts = get_systick();
+        check_charger_status_to_play_sound_icon();
         monitor_charger_status();
+    }
 
     monitor_battery_level();
 
@@ -113,9 +113,12 @@ void SocEstimator::save_persistent_parameters()
 #ifndef BOARD_CONFIG_BATTERY_LEVEL_ESTIMATOR_SIMPLE
     log_info("soc: saving persistent parameters...");
     stat();
-    Storage::save(Teufel::Ux::System::BatterySocAccumulatedCharge{m_integrated_charge});
-    Storage::save(Teufel::Ux::System::BatterySocCapacity{m_capacity});
-    Storage::save(m_algo_state);
+    // The algorithm state is only meaningful together with the charge and capacity it was saved with
+    Storage::Batch()
+        .add(Teufel::Ux::System::BatterySocAccumulatedCharge{m_integrated_charge})
+        .add(Teufel::Ux::System::BatterySocCapacity{m_capacity})
+        .add(m_algo_state)
+        .commit();
 #endif
 }
 
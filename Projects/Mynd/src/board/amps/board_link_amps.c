@@ -2,6 +2,7 @@
 #include "logger.h"
 
 #include "config.h"
+#include "trace_events.h"
 #include "board_link_amps.h"
 #include "board_hw.h"
 #include "bsp_shared_i2c.h"
@@ -90,6 +91,7 @@ void board_link_amps_init(void)
 
 void board_link_amps_enable(bool enable)
 {
+    TRACE(TRACE_AMPS_ENABLE, enable);
     HAL_GPIO_WritePin(AMPS_POWER_DOWN_GPIO_PORT, AMPS_POWER_DOWN_GPIO_PIN, (enable) ? GPIO_PIN_SET : GPIO_PIN_RESET);
     log_info("Amps power %s", enable ? "enabled" : "disabled");
 }
@@ -98,6 +100,8 @@ int board_link_amps_setup_woofer(board_link_amps_mode_t mode)
 {
     int result = 0;
 
+    TRACE(TRACE_AMPS_WOOFER_SETUP, mode);
+
     if (tas5825p_set_state(s_amps.tas5825p, TAS5825P_DEVICE_STATE_HI_Z) != 0)
     {
         log_error("Failed to set woofer amp to Hi-Z state");
@@ -151,12 +155,15 @@ int board_link_amps_setup_woofer(board_link_amps_mode_t mode)
         result = -1;
     }
 
+    TRACE(TRACE_AMPS_WOOFER_READY, result == 0);
     return result;
 }
 
 int board_link_amps_setup_tweeter(board_link_amps_mode_t mode)
 {
     int result = 0;
+
+    TRACE(TRACE_AMPS_TWEETER_SETUP, mode);
     if (tas5805m_set_state(s_amps.tas5805m, TAS5805M_DEVICE_STATE_HI_Z) != 0)
     {
         log_error("Failed to set tweeter amp to Hi-Z state");
@@ -214,6 +221,7 @@ int board_link_amps_setup_tweeter(board_link_amps_mode_t mode)
         result = -1;
     }
 
+    TRACE(TRACE_AMPS_TWEETER_READY, result == 0);
     return result;
 }
 
@@ -433,6 +441,7 @@ int8_t board_link_amps_get_woofer_volume(void)
 
 void board_link_amps_mute(bool enable)
 {
+    TRACE(TRACE_AMPS_MUTE, enable);
     if (tas5805m_mute(s_amps.tas5805m, enable) == 0)
     {
         log_debug("Tweeter amp %s", enable ? "muted" : "unmuted");
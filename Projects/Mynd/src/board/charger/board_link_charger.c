@@ -9,6 +9,7 @@
 #include "board_link_charger.h"
 #include "board_link_usb_pd_controller.h"
 #include "board_hw.h"
+#include "board.h"
 #include "bq25713.h"
 #include <string.h>
 #include "logger.h"
@@ -21,6 +22,10 @@
 #define SLOW_CHARGE_VOLTAGE_MV (8200U)
 #define FAST_CHARGE_VOLTAGE_MV (8400U)
 
+// Every read of the charger is a 4CC command round trip through the PD controller, the connected and the AC plugged
+// status share one read of the status registers as long as it's this recent
+#define STATUS_MAX_AGE_MS (500U)
+
 static const bq25713_config_t bq25713_config = {
     .i2c_device_address = BQ25713_I2C_ADDRESS,
     .i2c_write_fn       = board_link_usb_pd_controller_i2c_write,
@@ -29,9 +34,30 @@ static const bq25713_config_t bq25713_config = {
 
 static struct
 {
-    bq25713_handler_t *bq25713;
+    bq25713_handler_t       *bq25713;
+    bq25713_charger_status_t status;
+    uint32_t                 status_ts;
+    bool                     is_status_valid;
 } s_charger;
 
+static int read_charger_status(bq25713_charger_status_t *p_status)
+{
+    if (!s_charger.is_status_valid || board_get_ms_since(s_charger.status_ts) >= STATUS_MAX_AGE_MS)
+    {
+        bq25713_fault_status_t fault_status;
+        if (bq25713_get_charger_status(s_charger.bq25713, &s_charger.status, &fault_status) != 0)
+        {
+            s_charger.is_status_valid = false;
+            return -1;
+        }
+        s_charger.status_ts       = get_systick();
+        s_charger.is_status_valid = true;
+    }
+
+    *p_status = s_charger.status;
+    return 0;
+}
+
 void board_link_charger_init(void)
 {
     s_charger.bq25713 = bq25713_init(&bq25713_config);
@@ -69,6 +95,8 @@ int board_link_charger_setup(void)
         return -1;
     }
 
+    board_link_charger_invalidate_cache();
+
     // Disable low power mode
     board_link_charger_enable_low_power_mode(false);
 
@@ -135,8 +163,7 @@ int board_link_charger_get_status(board_link_charger_status_t *p_charger_status)
     // is fully charged, the charger status is still "charging" because the IN_FCHRG bit is set to 1.
 
     bq25713_charger_status_t status;
-    bq25713_fault_status_t   fault_status;
-    if (bq25713_get_charger_status(s_charger.bq25713, &status, &fault_status) != 0)
+    if (read_charger_status(&status) != 0)
     {
         *p_charger_status = CHARGER_STATUS_UNDEFINED;
         return -1;
@@ -167,8 +194,7 @@ int board_link_charger_get_status(board_link_charger_status_t *p_charger_status)
 int board_link_charger_get_ac_plugged_status(bool *p_ac_plugged)
 {
     bq25713_charger_status_t status;
-    bq25713_fault_status_t   fault_status;
-    if (bq25713_get_charger_status(s_charger.bq25713, &status, &fault_status) != 0)
+    if (read_charger_status(&status) != 0)
     {
         return -1;
     }
@@ -177,6 +203,12 @@ int board_link_charger_get_ac_plugged_status(bool *p_ac_plugged)
     return 0;
 }
 
+void board_link_charger_invalidate_cache(void)
+{
+    s_charger.is_status_valid = false;
+    bq25713_invalidate_shadow(s_charger.bq25713);
+}
+
 int board_link_charger_disable_charging(bool disable)
 {
     uint8_t charge_inhibit = (disable) ? 1 : 0;
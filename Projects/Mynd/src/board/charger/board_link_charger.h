@@ -83,6 +83,11 @@ extern "C"
      */
     int board_link_charger_disable_charging(bool disable);
 
+    /**
+     * @brief Drops the cached status and register copies, e.g. after the charger configuration was reset.
+     */
+    void board_link_charger_invalidate_cache(void);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -2,6 +2,9 @@
 #include "board_hw.h"
 #include "logger.h"
 
+static board_link_power_supply_button_handler_t s_button_handler = NULL;
+static board_link_power_supply_ac_ok_handler_t  s_ac_ok_handler  = NULL;
+
 void board_link_power_supply_init(void)
 {
     GPIO_InitTypeDef GPIO_InitStruct;
@@ -31,6 +34,32 @@ void board_link_power_supply_init(void)
     HAL_GPIO_Init(AC_OK_GPIO_PORT, &GPIO_InitStruct);
 }
 
+void board_link_power_supply_attach_button_interrupt_handler(board_link_power_supply_button_handler_t handler)
+{
+    s_button_handler = handler;
+}
+
+void board_link_power_supply_on_button_interrupt(void)
+{
+    if (s_button_handler != NULL)
+    {
+        s_button_handler();
+    }
+}
+
+void board_link_power_supply_attach_ac_ok_interrupt_handler(board_link_power_supply_ac_ok_handler_t handler)
+{
+    s_ac_ok_handler = handler;
+}
+
+void board_link_power_supply_on_ac_ok_interrupt(void)
+{
+    if (s_ac_ok_handler != NULL)
+    {
+        s_ac_ok_handler();
+    }
+}
+
 bool board_link_power_supply_is_ac_ok(void)
 {
     return HAL_GPIO_ReadPin(AC_OK_GPIO_PORT, AC_OK_GPIO_PIN) == GPIO_PIN_SET;
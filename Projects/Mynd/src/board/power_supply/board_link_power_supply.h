@@ -7,8 +7,26 @@ extern "C"
 {
 #endif
 
+    /**
+     * @brief Called from the EXTI interrupt on every edge of the power button.
+     */
+    typedef void (*board_link_power_supply_button_handler_t)(void);
+
+    /**
+     * @brief Called from the EXTI interrupt on every edge of AC OK, i.e. when VBUS comes or goes.
+     */
+    typedef void (*board_link_power_supply_ac_ok_handler_t)(void);
+
     void board_link_power_supply_init(void);
 
+    void board_link_power_supply_attach_button_interrupt_handler(board_link_power_supply_button_handler_t handler);
+
+    void board_link_power_supply_on_button_interrupt(void);
+
+    void board_link_power_supply_attach_ac_ok_interrupt_handler(board_link_power_supply_ac_ok_handler_t handler);
+
+    void board_link_power_supply_on_ac_ok_interrupt(void);
+
     bool board_link_power_supply_is_ac_ok(void);
 
     bool board_link_power_supply_button_is_pressed(void);
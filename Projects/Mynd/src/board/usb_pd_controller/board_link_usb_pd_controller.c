@@ -11,11 +11,9 @@
 static struct
 {
     tps25751_handler_t *tps25751;
+    tps25751_port_t     port;
     bool                is_ready;
-    bool                is_plug_connection_present;
-    bool                is_power_connection_present;
     bool                is_dead_battery_indicated;
-    bool                is_pd_port_role_source; // false = sink, true = source
 } s_usb_pd;
 
 static void thread_sleep_ms(uint32_t ms);
@@ -38,6 +36,17 @@ void board_link_usb_pd_controller_init(void)
     tps25751_clear_dead_battery_flag(s_usb_pd.tps25751);
 }
 
+// The events and status of the port are tracked by the driver, the board only adds the device mode
+static tps25751_port_callbacks_t port_callbacks(const board_link_usb_pd_controller_callbacks_t *p_callbacks)
+{
+    tps25751_port_callbacks_t callbacks = {
+        .plug_connection_change_cb  = p_callbacks->plug_connection_change_cb,
+        .power_connection_change_cb = p_callbacks->power_connection_change_cb,
+        .pd_role_change_cb          = p_callbacks->pd_port_role_change_cb,
+    };
+    return callbacks;
+}
+
 void board_link_usb_pd_controller_poll_status(const board_link_usb_pd_controller_callbacks_t *p_callbacks)
 {
     APP_ASSERT(p_callbacks != NULL, "Callbacks are NULL");
@@ -45,60 +54,8 @@ void board_link_usb_pd_controller_poll_status(const board_link_usb_pd_controller
     // Device and power status are only available if the device is ready
     if (s_usb_pd.is_ready)
     {
-        tps25751_status_t device_status;
-        if (tps25751_get_device_status(s_usb_pd.tps25751, &device_status) == 0)
-        {
-            if (s_usb_pd.is_plug_connection_present != device_status.is_plug_connected)
-            {
-                s_usb_pd.is_plug_connection_present = device_status.is_plug_connected;
-                if (p_callbacks->plug_connection_change_cb)
-                {
-                    p_callbacks->plug_connection_change_cb(s_usb_pd.is_plug_connection_present);
-                }
-            }
-        }
-        else
-        {
-            log_error("Failed to get status");
-        }
-
-        tps25751_power_status_t power_status;
-        if (tps25751_get_power_status(s_usb_pd.tps25751, &power_status) == 0)
-        {
-            if (s_usb_pd.is_power_connection_present != power_status.connection_present)
-            {
-                s_usb_pd.is_power_connection_present = power_status.connection_present;
-                if (p_callbacks->power_connection_change_cb)
-                {
-                    p_callbacks->power_connection_change_cb(s_usb_pd.is_power_connection_present);
-                }
-            }
-        }
-        else
-        {
-            log_error("Failed to get power status");
-        }
-
-#if 0
-        // TODO: add PD role change callback (maybe will be needed for power bank mode)
-        // Get power delivery status
-        tps25751_pd_status_t power_delivery_status;
-        if (tps25751_get_pd_status(s_usb_pd.tps25751, &power_delivery_status) == 0)
-        {
-            if (s_usb_pd.is_pd_port_role_source != (power_delivery_status.pd_role == TPS25751_PD_ROLE_SOURCE))
-            {
-                s_usb_pd.is_pd_port_role_source = (power_delivery_status.pd_role == TPS25751_PD_ROLE_SOURCE);
-                if (p_callbacks->pd_port_role_change_cb)
-                {
-                    p_callbacks->pd_port_role_change_cb(s_usb_pd.is_pd_port_role_source);
-                }
-            }
-        }
-        else
-        {
-            log_error("Failed to get pd status");
-        }
-#endif
+        tps25751_port_callbacks_t callbacks = port_callbacks(p_callbacks);
+        tps25751_port_poll(s_usb_pd.tps25751, &s_usb_pd.port, &callbacks);
     }
     else
     {
@@ -127,6 +84,21 @@ void board_link_usb_pd_controller_poll_status(const board_link_usb_pd_controller
     }
 }
 
+bool board_link_usb_pd_controller_process_events(const board_link_usb_pd_controller_callbacks_t *p_callbacks,
+                                                 bool                                            is_vbus_edge)
+{
+    APP_ASSERT(p_callbacks != NULL, "Callbacks are NULL");
+
+    if (!s_usb_pd.is_ready)
+    {
+        board_link_usb_pd_controller_poll_status(p_callbacks);
+        return s_usb_pd.port.are_events_enabled;
+    }
+
+    tps25751_port_callbacks_t callbacks = port_callbacks(p_callbacks);
+    return tps25751_port_process_events(s_usb_pd.tps25751, &s_usb_pd.port, &callbacks, is_vbus_edge);
+}
+
 int board_link_usb_pd_controller_i2c_read(uint8_t i2c_address, uint8_t register_address, uint8_t *p_data,
                                           uint32_t length)
 {
@@ -183,12 +155,12 @@ bool board_link_usb_pd_controller_is_ready(void)
 
 bool board_link_usb_pd_controller_is_plug_connected(void)
 {
-    return s_usb_pd.is_plug_connection_present;
+    return s_usb_pd.port.is_plug_connected;
 }
 
 bool board_link_usb_pd_controller_is_power_connected(void)
 {
-    return s_usb_pd.is_power_connection_present;
+    return s_usb_pd.port.is_power_connected;
 }
 
 bool board_link_usb_pd_controller_is_battery_dead(void)
@@ -51,14 +51,30 @@ extern "C"
     /**
      * @brief Polls the status of the USB PD controller.
      *
-     * @details This function is meant to be called periodically.
-     *          The user-provided callback functions will be called when
-     *          the USB status changes.
+     * @details This function is meant to be called periodically, until the controller is ready and from then
+     *          on as a slow safety net for board_link_usb_pd_controller_process_events(). It reads the complete
+     *          status. The user-provided callback functions will be called when the USB status changes.
      *
      * @param[in] p_callbacks           pointer to callbacks struct
      */
     void board_link_usb_pd_controller_poll_status(const board_link_usb_pd_controller_callbacks_t *p_callbacks);
 
+    /**
+     * @brief Reads the pending events of the USB PD controller and only the status they flag.
+     *
+     * @details Meant to be called when the USB connection may have changed. Without pending events this is a single
+     *          register read. A VBUS edge without any pending event means the PD controller was reset and forgot the
+     *          event mask, the complete status is polled then. The user-provided callback functions will be called
+     *          when the USB status changes.
+     *
+     * @param[in] p_callbacks           pointer to callbacks struct
+     * @param[in] is_vbus_edge          true if called for a VBUS edge, e.g. the AC OK interrupt of the charger
+     *
+     * @return true if events were pending, more are likely to follow (e.g. the power contract after a plug)
+     */
+    bool board_link_usb_pd_controller_process_events(const board_link_usb_pd_controller_callbacks_t *p_callbacks,
+                                                     bool                                            is_vbus_edge);
+
     /**
      * @brief Instructs the USB PD controller to execute a read from a specified slave address and
      *        register offset using an I2C read transaction on the I2Cm bus.
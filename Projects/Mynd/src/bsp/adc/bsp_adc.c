@@ -1,5 +1,6 @@
 #include "bsp_adc.h"
 #include "board_hw.h"
+#include "board_low_power.h"
 #include "board_link_hw_revision.h"
 #include "stm32f0xx_hal.h"
 
@@ -11,6 +12,23 @@ ADC_HandleTypeDef        Adc1Handle;
 static DMA_HandleTypeDef DmaHandle;
 
 static bsp_adc_conversion_complete_callback_t s_user_callback;
+static uint32_t                              *s_buffer;
+static uint32_t                               s_buffer_size;
+static volatile bool                          s_is_running;
+static volatile bool                          s_is_single_scan;
+
+// The continuous conversions stop in STOP mode, so the MCU only sleeps while they run
+static void set_running(bool running)
+{
+    if (running == s_is_running)
+        return;
+
+    s_is_running = running;
+    if (running)
+        board_low_power_lock(BOARD_LOW_POWER_LOCK_ADC);
+    else
+        board_low_power_unlock(BOARD_LOW_POWER_LOCK_ADC);
+}
 
 void bsp_bat_voltage_enable_init(void)
 {
@@ -136,6 +154,7 @@ void bsp_adc_deinit(void)
     if (Adc1Handle.State != HAL_ADC_STATE_RESET)
     {
         HAL_ADC_Stop_DMA(&Adc1Handle);
+        set_running(false);
 
         ADC_ChannelConfTypeDef channel_config;
         channel_config.Channel      = ISENS_ADC_CHANNEL;
@@ -150,7 +169,10 @@ void bsp_adc_start(uint32_t *buffer, uint32_t buffer_size, bsp_adc_conversion_co
 {
     HAL_StatusTypeDef      status;
     ADC_ChannelConfTypeDef sConfig;
-    s_user_callback = callback;
+    s_user_callback  = callback;
+    s_buffer         = buffer;
+    s_buffer_size    = buffer_size;
+    s_is_single_scan = false;
 
     HAL_ADC_Stop_DMA(&Adc1Handle);
 
@@ -197,17 +219,43 @@ void bsp_adc_start(uint32_t *buffer, uint32_t buffer_size, bsp_adc_conversion_co
     status          = HAL_ADC_ConfigChannel(&Adc1Handle, &sConfig);
     APP_ASSERT(status == HAL_OK);
 
-    HAL_ADC_Start_DMA(&Adc1Handle, buffer, buffer_size);
+    if (HAL_ADC_Start_DMA(&Adc1Handle, buffer, buffer_size) == HAL_OK)
+    {
+        // Only the complete buffer is used, this halves the DMA interrupts
+        __HAL_DMA_DISABLE_IT(Adc1Handle.DMA_Handle, DMA_IT_HT);
+        set_running(true);
+    }
 }
 
 void bsp_adc_stop(void)
 {
     HAL_ADC_Stop_DMA(&Adc1Handle);
+    set_running(false);
+}
+
+// The channels stay selected after HAL_ADC_Stop_DMA(), the scan starts over from the first one
+void bsp_adc_sample_once(void)
+{
+    if (s_is_running || s_buffer == NULL)
+        return;
+
+    s_is_single_scan = true;
+    if (HAL_ADC_Start_DMA(&Adc1Handle, s_buffer, s_buffer_size) == HAL_OK)
+    {
+        __HAL_DMA_DISABLE_IT(Adc1Handle.DMA_Handle, DMA_IT_HT);
+        set_running(true);
+    }
 }
 
 void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
 {
     (void) hadc;
+    if (s_is_single_scan)
+    {
+        s_is_single_scan = false;
+        bsp_adc_stop();
+    }
+
     if (s_user_callback != NULL)
     {
         s_user_callback();
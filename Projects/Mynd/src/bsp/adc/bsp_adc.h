@@ -17,6 +17,12 @@ extern "C"
     void bsp_adc_start(uint32_t *buffer, uint32_t buffer_size, bsp_adc_conversion_complete_callback_t callback);
     void bsp_adc_stop(void);
 
+    /**
+     * @brief Fills the buffer of bsp_adc_start() once more, stops and calls the callback. Meant for sampling on
+     *        demand after bsp_adc_stop(), does nothing while the conversions run.
+     */
+    void bsp_adc_sample_once(void);
+
 #if defined(__cplusplus)
 }
 #endif
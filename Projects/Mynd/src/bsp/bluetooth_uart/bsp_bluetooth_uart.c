@@ -1,4 +1,5 @@
 #include "bsp_bluetooth_uart.h"
+#include "bsp_bluetooth_uart_frame.h"
 #include "board_hw.h"
 #include "FreeRTOS.h"
 #include "stream_buffer.h"
@@ -13,6 +14,9 @@ static StreamBufferHandle_t sbuffer_handle_rx;
 static volatile uint8_t     irq_rx_data[1] = {};
 static volatile bool        missed_rx_data = false;
 
+static volatile bsp_bluetooth_uart_frame_handler_t frame_handler  = NULL;
+static bsp_bluetooth_uart_frame_detector_t         frame_detector = BSP_BLUETOOTH_UART_FRAME_DETECTOR_INIT;
+
 #define STORAGE_SIZE_BYTES 128u
 static uint8_t              sbuffer_storage[STORAGE_SIZE_BYTES];
 static StaticStreamBuffer_t StreamBufferStruct;
@@ -39,6 +43,11 @@ void bsp_bluetooth_uart_init(void)
 
     HAL_UART_Init(&UART1_Handle);
 
+    // Data from the chip wakes the MCU up from STOP mode
+    UART_WakeUpTypeDef wakeup = {.WakeUpEvent = UART_WAKEUP_ON_READDATA_NONEMPTY};
+    HAL_UARTEx_StopModeWakeUpSourceConfig(&UART1_Handle, wakeup);
+    HAL_UARTEx_EnableStopMode(&UART1_Handle);
+
     // Trigger receiving
     HAL_UART_Receive_IT(&UART1_Handle, (uint8_t *) irq_rx_data, 1);
 }
@@ -100,6 +109,7 @@ void bsp_bluetooth_uart_msp_deinit(void)
 
 void bsp_bluetooth_uart_clear_buffer(void)
 {
+    frame_detector = (bsp_bluetooth_uart_frame_detector_t) BSP_BLUETOOTH_UART_FRAME_DETECTOR_INIT;
     if (xStreamBufferReset(sbuffer_handle_rx) != pdPASS)
     {
         log_error("Failed to reset BT UART buffer");
@@ -112,6 +122,16 @@ int bsp_bluetooth_uart_tx(const uint8_t *p_data, size_t length)
     return 0;
 }
 
+size_t bsp_bluetooth_uart_rx_available(void)
+{
+    return xStreamBufferBytesAvailable(sbuffer_handle_rx);
+}
+
+void bsp_bluetooth_uart_attach_frame_handler(bsp_bluetooth_uart_frame_handler_t handler)
+{
+    frame_handler = handler;
+}
+
 int bsp_bluetooth_uart_rx(uint8_t *p_data, size_t length)
 {
     if (xStreamBufferBytesAvailable(sbuffer_handle_rx) < length)
@@ -137,6 +157,8 @@ int bsp_bluetooth_uart_rx(uint8_t *p_data, size_t length)
 
 void bsp_bluetooth_uart_isr_rx_complete_callback(void)
 {
+    const uint8_t byte = irq_rx_data[0];
+
     if (xStreamBufferIsFull(sbuffer_handle_rx) == pdFALSE)
     {
         if (xStreamBufferSendFromISR(sbuffer_handle_rx, (uint8_t *) irq_rx_data, (size_t) 1, (BaseType_t *) pdFALSE) !=
@@ -152,4 +174,13 @@ void bsp_bluetooth_uart_isr_rx_complete_callback(void)
 
     // Start receiving
     HAL_UART_Receive_IT(&UART1_Handle, (uint8_t *) irq_rx_data, 1);
+
+    const bool is_handler_due =
+        bsp_bluetooth_uart_frame_detector_push(&frame_detector, byte, xStreamBufferIsFull(sbuffer_handle_rx) == pdTRUE);
+
+    bsp_bluetooth_uart_frame_handler_t handler = frame_handler;
+    if ((handler != NULL) && is_handler_due)
+    {
+        handler();
+    }
 }
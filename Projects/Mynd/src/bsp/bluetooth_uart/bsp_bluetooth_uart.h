@@ -8,6 +8,8 @@ extern "C"
 {
 #endif
 
+    typedef void (*bsp_bluetooth_uart_frame_handler_t)(void);
+
     /**
      * @brief Initializes the UART hardware needed to interface with the Bluetooth module.
      */
@@ -45,6 +47,21 @@ extern "C"
      */
     int bsp_bluetooth_uart_rx(uint8_t *p_data, size_t length);
 
+    /**
+     * @brief Gets the number of bytes received and not read yet.
+     *
+     * @return number of bytes in the UART RX buffer
+     */
+    size_t bsp_bluetooth_uart_rx_available(void);
+
+    /**
+     * @brief Attaches a handler that is called from the RX interrupt when a frame from the Bluetooth module is
+     *        complete, i.e. its closing delimiter was received, or when the RX buffer is full.
+     *
+     * @param[in] handler   handler to call, NULL to detach it
+     */
+    void bsp_bluetooth_uart_attach_frame_handler(bsp_bluetooth_uart_frame_handler_t handler);
+
 #if defined(__cplusplus)
 }
 #endif
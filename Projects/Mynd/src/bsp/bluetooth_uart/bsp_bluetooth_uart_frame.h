@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Frame end detection of the RX interrupt, without hardware dependencies so that the host tests run it on the bytes of
+// the simulated chip
+
+// The Actions chip frames its messages with HDLC, a delimiter following other data ends a frame
+#define BSP_BLUETOOTH_UART_FRAME_DELIMITER 0x7Eu
+
+typedef struct
+{
+    bool is_last_byte_delimiter;
+} bsp_bluetooth_uart_frame_detector_t;
+
+// Between frames, as after the RX buffer was cleared
+#define BSP_BLUETOOTH_UART_FRAME_DETECTOR_INIT {.is_last_byte_delimiter = true}
+
+/**
+ * @brief Takes the next received byte.
+ *
+ * @param[in] p_detector        state of the detector
+ * @param[in] byte              received byte
+ * @param[in] is_rx_buffer_full whether the RX buffer is full with the byte
+ *
+ * @return true if the frame handler is due: the byte closes a frame, or the task has to make room in the RX buffer
+ */
+static inline bool bsp_bluetooth_uart_frame_detector_push(bsp_bluetooth_uart_frame_detector_t *p_detector,
+                                                          uint8_t byte, bool is_rx_buffer_full)
+{
+    const bool is_delimiter            = (byte == BSP_BLUETOOTH_UART_FRAME_DELIMITER);
+    const bool is_frame_end            = is_delimiter && !p_detector->is_last_byte_delimiter;
+    p_detector->is_last_byte_delimiter = is_delimiter;
+    return is_frame_end || is_rx_buffer_full;
+}
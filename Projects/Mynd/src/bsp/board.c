@@ -8,6 +8,8 @@ extern I2C_HandleTypeDef I2C2_Handle;
 void board_init(void)
 {
     /* EXTI interrupt init*/
+    HAL_NVIC_SetPriority(EXTI0_1_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(EXTI0_1_IRQn);
     HAL_NVIC_SetPriority(EXTI2_3_IRQn, 3, 0);
     HAL_NVIC_EnableIRQ(EXTI2_3_IRQn);
 
@@ -54,3 +56,26 @@ uint32_t board_get_ms_since(uint32_t tick_ms)
         return current_tick_ms - tick_ms;
     }
 }
+
+uint32_t board_get_time_us(void)
+{
+    uint32_t tick, value;
+
+    // The tick may be incremented between reading it and the SysTick counter
+    do
+    {
+        tick  = get_systick();
+        value = SysTick->VAL;
+    } while (tick != get_systick());
+
+    // SysTick counts down and the tick interrupt may be pending while interrupts are masked. After a tickless sleep the
+    // counter runs from a shorter reload for the rest of the tick, LOAD already holds the one of a full tick then and
+    // only that one gives the time within the tick.
+    uint32_t load = SystemCoreClock / configTICK_RATE_HZ - 1u;
+    if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0 && value > load / 2)
+    {
+        tick++;
+    }
+
+    return tick * 1000u + (load - value) / (SystemCoreClock / 1000000u);
+}
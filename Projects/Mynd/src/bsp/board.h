@@ -11,6 +11,12 @@ extern "C"
     uint32_t get_systick(void);
     uint32_t board_get_ms_since(uint32_t tick_ms);
 
+    /**
+     * @brief Microseconds since the scheduler started, from the tick count and the SysTick counter. Wraps around after
+     *        about 71 minutes. Callable from tasks and ISRs.
+     */
+    uint32_t board_get_time_us(void);
+
 #if defined(__cplusplus)
 }
 #endif
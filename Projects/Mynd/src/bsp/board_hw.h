@@ -145,6 +145,8 @@
 #define DEBUG_UART                          USART2
 #define DEBUG_UART_BAUDRATE                 115200
 #define DEBUG_UART_IRQn                     USART2_IRQn
+#define DEBUG_UART_TX_DMA_CHANNEL           DMA1_Channel4
+#define DEBUG_UART_TX_DMA_IRQn              DMA1_Channel4_5_6_7_IRQn
 
 // Amps power down pin
 #define AMPS_POWER_DOWN_GPIO_CLK_ENABLE()   __HAL_RCC_GPIOC_CLK_ENABLE()
@@ -238,7 +240,7 @@
 #define AC_OK_GPIO_CLK_ENABLE()             __HAL_RCC_GPIOC_CLK_ENABLE()
 #define AC_OK_GPIO_PIN                      GPIO_PIN_3
 #define AC_OK_GPIO_PORT                     GPIOC
-#define AC_OK_GPIO_MODE                     GPIO_MODE_INPUT
+#define AC_OK_GPIO_MODE                     GPIO_MODE_IT_RISING_FALLING
 #define AC_OK_GPIO_PULL                     GPIO_NOPULL
 #define AC_OK_GPIO_SPEED                    GPIO_SPEED_FREQ_LOW
 
@@ -246,7 +248,7 @@
 #define POWER_BUTTON_GPIO_CLK_ENABLE()      __HAL_RCC_GPIOA_CLK_ENABLE()
 #define POWER_BUTTON_GPIO_PIN               GPIO_PIN_0
 #define POWER_BUTTON_GPIO_PORT              GPIOA
-#define POWER_BUTTON_GPIO_MODE              GPIO_MODE_INPUT
+#define POWER_BUTTON_GPIO_MODE              GPIO_MODE_IT_RISING_FALLING
 #define POWER_BUTTON_GPIO_PULL              GPIO_NOPULL
 #define POWER_BUTTON_GPIO_SPEED             GPIO_SPEED_FREQ_LOW
 
@@ -0,0 +1,426 @@
+#include <stdbool.h>
+
+#include "board_low_power.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "stm32f0xx_hal.h"
+
+#define LOG_LEVEL LOG_LEVEL_INFO
+#include "logger.h"
+
+// The kernel ticks are counted by the RTC in STOP mode, the calendar is only read for the subseconds and isn't used
+// otherwise. With LSI at about 40 kHz one RTC count is 50 us.
+#define RTC_PREDIV_A     1u
+#define RTC_PREDIV_S     0x7FFFu
+#define RTC_COUNTS_WRAP  (3600u * (RTC_PREDIV_S + 1u))
+#define RTC_WUT_DIVIDER  16u
+#define RTC_WUT_MAX      0xFFFFu
+#define RTC_WPR_UNLOCK_1 0xCAu
+#define RTC_WPR_UNLOCK_2 0x53u
+#define RTC_WPR_LOCK     0xFFu
+
+// LSI is anything between 30 and 50 kHz, it's measured against HSI48 with TIM14 capturing every 8th RTC clock
+#define LSI_CAPTURE_PRESCALER 8u
+#define LSI_CAPTURES          16u
+#define LSI_CAPTURE_TIMEOUT   100000u
+
+// Restarting HSI48 and the wakeup timer setup take some tens of microseconds, STOP is only worth it for longer waits
+#define MIN_STOP_TICKS 5u
+
+// SysTick counts lost while it's stopped for reprogramming, as in the FreeRTOS Cortex-M0 port
+#define SYSTICK_STOPPED_COMPENSATION 45u
+
+static low_power_config_t s_config;
+static uint32_t           s_counts_per_tick;
+static uint32_t           s_lsi_hz;
+static volatile uint8_t   s_locks[BOARD_LOW_POWER_LOCK_COUNT];
+static low_power_stats_t  s_stats;
+static bool               s_was_tickless;
+
+static uint32_t count_locks(void)
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < BOARD_LOW_POWER_LOCK_COUNT; i++)
+        count += s_locks[i];
+    return count;
+}
+
+static int rtc_init(void)
+{
+    RCC->CSR |= RCC_CSR_LSION;
+    while ((RCC->CSR & RCC_CSR_LSIRDY) == 0)
+    {
+    }
+
+    HAL_PWR_EnableBkUpAccess();
+
+    // Changing the RTC clock would need a backup domain reset, which clears BKP0R
+    uint32_t rtcsel = RCC->BDCR & RCC_BDCR_RTCSEL;
+    if (rtcsel != 0 && rtcsel != RCC_BDCR_RTCSEL_LSI)
+        return -1;
+
+    RCC->BDCR |= RCC_BDCR_RTCSEL_LSI | RCC_BDCR_RTCEN;
+
+    RTC->WPR = RTC_WPR_UNLOCK_1;
+    RTC->WPR = RTC_WPR_UNLOCK_2;
+
+    RTC->ISR |= RTC_ISR_INIT;
+    while ((RTC->ISR & RTC_ISR_INITF) == 0)
+    {
+    }
+    // Two separate writes, synchronous prescaler first
+    RTC->PRER = RTC_PREDIV_S;
+    RTC->PRER = (RTC_PREDIV_A << RTC_PRER_PREDIV_A_Pos) | RTC_PREDIV_S;
+    RTC->ISR &= ~RTC_ISR_INIT;
+
+    // The subseconds are read right after waking up, before the shadow registers are synchronized
+    RTC->CR |= RTC_CR_BYPSHAD;
+
+    // Wakeup timer clocked by RTC/16
+    RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+    while ((RTC->ISR & RTC_ISR_WUTWF) == 0)
+    {
+    }
+    RTC->CR &= ~RTC_CR_WUCKSEL;
+    RTC->ISR &= ~RTC_ISR_WUTF;
+
+    RTC->WPR = RTC_WPR_LOCK;
+
+    // The wakeup timer event reaches the NVIC through EXTI line 20
+    EXTI->IMR |= EXTI_IMR_MR20;
+    EXTI->RTSR |= EXTI_RTSR_TR20;
+    HAL_NVIC_SetPriority(RTC_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(RTC_IRQn);
+
+    return 0;
+}
+
+static uint32_t measure_lsi_hz(void)
+{
+    uint32_t total_counts = 0;
+    uint16_t previous     = 0;
+
+    __HAL_RCC_TIM14_CLK_ENABLE();
+
+    TIM14->OR    = TIM14_OR_TI1_RMP_0; // TI1 is the RTC clock
+    TIM14->PSC   = 0;
+    TIM14->ARR   = 0xFFFF;
+    TIM14->CCMR1 = TIM_CCMR1_CC1S_0 | TIM_CCMR1_IC1PSC; // TI1 input, capture every 8 events
+    TIM14->CCER  = TIM_CCER_CC1E;
+    TIM14->SR    = 0;
+    TIM14->CR1   = TIM_CR1_CEN;
+
+    // The first capture is only the reference for the next one
+    for (uint32_t i = 0; i <= LSI_CAPTURES; i++)
+    {
+        uint32_t timeout = LSI_CAPTURE_TIMEOUT;
+        while ((TIM14->SR & TIM_SR_CC1IF) == 0)
+        {
+            if (--timeout == 0)
+            {
+                total_counts = 0;
+                goto done;
+            }
+        }
+
+        // Reading the capture clears the flag
+        uint16_t capture = (uint16_t) TIM14->CCR1;
+        if (i > 0)
+            total_counts += (uint16_t) (capture - previous);
+        previous = capture;
+    }
+
+done:
+    TIM14->CR1  = 0;
+    TIM14->CCER = 0;
+    __HAL_RCC_TIM14_CLK_DISABLE();
+
+    if (total_counts == 0)
+        return 0;
+
+    return (uint32_t) (((uint64_t) SystemCoreClock * LSI_CAPTURE_PRESCALER * LSI_CAPTURES) / total_counts);
+}
+
+// RTC counts within the current hour of the calendar
+static uint32_t rtc_get_counts(void)
+{
+    uint32_t ssr, tr;
+
+    // Without the shadow registers the subseconds may roll over between the two reads
+    do
+    {
+        ssr = RTC->SSR;
+        tr  = RTC->TR;
+    } while (ssr != RTC->SSR);
+
+    uint32_t seconds = ((tr & RTC_TR_MNT) >> RTC_TR_MNT_Pos) * 600u + ((tr & RTC_TR_MNU) >> RTC_TR_MNU_Pos) * 60u +
+                       ((tr & RTC_TR_ST) >> RTC_TR_ST_Pos) * 10u + ((tr & RTC_TR_SU) >> RTC_TR_SU_Pos);
+
+    return seconds * (RTC_PREDIV_S + 1u) + (RTC_PREDIV_S - ssr);
+}
+
+static void rtc_start_wakeup(uint32_t us)
+{
+    // Rounded down, the rest of the last tick is counted by the SysTick after waking up
+    uint32_t wut = (uint32_t) (((uint64_t) us * s_lsi_hz) / (RTC_WUT_DIVIDER * 1000000ull));
+    if (wut > 0)
+        wut--; // fires after WUT + 1 periods
+    if (wut > RTC_WUT_MAX)
+        wut = RTC_WUT_MAX;
+
+    RTC->WPR = RTC_WPR_UNLOCK_1;
+    RTC->WPR = RTC_WPR_UNLOCK_2;
+    RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+    while ((RTC->ISR & RTC_ISR_WUTWF) == 0)
+    {
+    }
+    RTC->WUTR = wut;
+    RTC->ISR &= ~RTC_ISR_WUTF;
+    EXTI->PR = EXTI_PR_PR20;
+    RTC->CR |= RTC_CR_WUTE | RTC_CR_WUTIE;
+    RTC->WPR = RTC_WPR_LOCK;
+}
+
+static void rtc_stop_wakeup(void)
+{
+    RTC->WPR = RTC_WPR_UNLOCK_1;
+    RTC->WPR = RTC_WPR_UNLOCK_2;
+    RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+    RTC->WPR = RTC_WPR_LOCK;
+
+    RTC->ISR &= ~RTC_ISR_WUTF;
+    EXTI->PR = EXTI_PR_PR20;
+    NVIC_ClearPendingIRQ(RTC_IRQn);
+}
+
+// HSI is the system clock after STOP, the flash latency is still the one for 48 MHz
+static void restore_system_clock(void)
+{
+    RCC->CR2 |= RCC_CR2_HSI48ON;
+    while ((RCC->CR2 & RCC_CR2_HSI48RDY) == 0)
+    {
+    }
+
+    RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_HSI48;
+    while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_HSI48)
+    {
+    }
+}
+
+// The SysTick interrupt is moved to the end of the idle time and the core sleeps until then or until an interrupt,
+// the same as vPortSuppressTicksAndSleep() of the FreeRTOS Cortex-M0 port
+static uint32_t sleep_with_systick(uint32_t ticks)
+{
+    uint32_t reload, complete_ticks;
+
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+
+    reload = SysTick->VAL + (s_counts_per_tick * (ticks - 1u));
+    if (reload > SYSTICK_STOPPED_COMPENSATION)
+        reload -= SYSTICK_STOPPED_COMPENSATION;
+
+    __disable_irq();
+    __DSB();
+    __ISB();
+
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep)
+    {
+        SysTick->LOAD = SysTick->VAL;
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        SysTick->LOAD = s_counts_per_tick - 1u;
+        __enable_irq();
+        return 0;
+    }
+
+    SysTick->LOAD = reload;
+    SysTick->VAL  = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+    __DSB();
+    __WFI();
+    __ISB();
+
+    // Unlike in the FreeRTOS port the interrupt which woke up the core only runs once the SysTick is back to counting
+    // ticks, board_get_time_us() doesn't know the reload of the sleep
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk;
+
+    if ((SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) != 0)
+    {
+        // Woken up by the SysTick, its pending interrupt accounts for one tick
+        uint32_t load = (s_counts_per_tick - 1u) - (reload - SysTick->VAL);
+        if (load < SYSTICK_STOPPED_COMPENSATION || load > s_counts_per_tick)
+            load = s_counts_per_tick - 1u;
+        SysTick->LOAD  = load;
+        complete_ticks = ticks - 1u;
+    }
+    else
+    {
+        uint32_t counted = (ticks * s_counts_per_tick) - SysTick->VAL;
+        complete_ticks   = counted / s_counts_per_tick;
+        SysTick->LOAD    = ((complete_ticks + 1u) * s_counts_per_tick) - counted;
+    }
+
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    vTaskStepTick(complete_ticks);
+    SysTick->LOAD = s_counts_per_tick - 1u;
+
+    __enable_irq();
+    return complete_ticks;
+}
+
+static uint32_t sleep_in_stop(uint32_t ticks)
+{
+    const uint32_t us_per_tick    = 1000000u / configTICK_RATE_HZ;
+    const uint32_t counts_per_us  = SystemCoreClock / 1000000u;
+    uint32_t       complete_ticks = 0;
+
+    __disable_irq();
+    __DSB();
+    __ISB();
+
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+
+    // A task was woken up or the tick became due since the kernel decided to sleep, or a driver took its lock
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0 ||
+        count_locks() != 0)
+    {
+        SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        __enable_irq();
+        return 0;
+    }
+
+    // The part of the current tick which has already passed
+    uint32_t elapsed_us = (SysTick->LOAD - SysTick->VAL) / counts_per_us;
+    uint32_t start      = rtc_get_counts();
+
+    rtc_start_wakeup(ticks * us_per_tick - elapsed_us);
+
+    HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+    restore_system_clock();
+    uint32_t end = rtc_get_counts();
+    rtc_stop_wakeup();
+
+    uint32_t counts   = (end + RTC_COUNTS_WRAP - start) % RTC_COUNTS_WRAP;
+    uint32_t slept_us = (uint32_t) (((uint64_t) counts * (RTC_PREDIV_A + 1u) * 1000000u) / s_lsi_hz);
+    uint32_t total_us = elapsed_us + slept_us;
+
+    complete_ticks = total_us / us_per_tick;
+    if (complete_ticks >= ticks)
+    {
+        // The tick the kernel waits for is due, the SysTick interrupt handles it as soon as the interrupts are enabled
+        complete_ticks = ticks - 1u;
+        SysTick->LOAD  = s_counts_per_tick - 1u;
+        SCB->ICSR      = SCB_ICSR_PENDSTSET_Msk;
+    }
+    else
+    {
+        // The rest of the current tick first, the full reload value is taken over at the end of it
+        SysTick->LOAD = (us_per_tick - (total_us % us_per_tick)) * counts_per_us - 1u;
+    }
+
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    vTaskStepTick(complete_ticks);
+    SysTick->LOAD = s_counts_per_tick - 1u;
+
+    __enable_irq();
+    return complete_ticks;
+}
+
+void board_low_power_init(void)
+{
+    s_counts_per_tick        = SystemCoreClock / configTICK_RATE_HZ;
+    s_config.min_sleep_ticks = configEXPECTED_IDLE_TIME_BEFORE_SLEEP;
+    s_config.max_sleep_ticks = SysTick_LOAD_RELOAD_Msk / s_counts_per_tick;
+    s_config.min_stop_ticks  = MIN_STOP_TICKS;
+    s_config.max_stop_ticks  = 0;
+
+    if (rtc_init() != 0)
+    {
+        log_warn("RTC clock taken, no STOP mode");
+        return;
+    }
+
+    s_lsi_hz = measure_lsi_hz();
+    if (s_lsi_hz == 0)
+    {
+        log_error("LSI not measurable, no STOP mode");
+        return;
+    }
+
+    // STOP is picked with any max_stop_ticks above min_stop_ticks
+    s_config.max_stop_ticks =
+        (uint32_t) (((uint64_t) RTC_WUT_MAX * RTC_WUT_DIVIDER * configTICK_RATE_HZ) / s_lsi_hz);
+    log_info("Low power: LSI %lu Hz, STOP up to %lu ms", (unsigned long) s_lsi_hz,
+             (unsigned long) s_config.max_stop_ticks);
+}
+
+void board_low_power_lock(board_low_power_lock_t lock)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_locks[lock]++;
+    __set_PRIMASK(primask);
+}
+
+void board_low_power_unlock(board_low_power_lock_t lock)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (s_locks[lock] > 0)
+        s_locks[lock]--;
+    __set_PRIMASK(primask);
+}
+
+void board_low_power_sleep(uint32_t expected_idle_ticks)
+{
+    // The idle task may run before board_low_power_init()
+    if (s_counts_per_tick == 0)
+        return;
+
+    low_power_decision_t decision = low_power_decide(&s_config, expected_idle_ticks, count_locks());
+    uint32_t             slept    = 0;
+
+    switch (decision.mode)
+    {
+        case LOW_POWER_MODE_STOP:
+            slept = sleep_in_stop(decision.ticks);
+            break;
+        case LOW_POWER_MODE_SLEEP:
+            slept = sleep_with_systick(decision.ticks);
+            break;
+        default:
+            return;
+    }
+
+    low_power_stats_add(&s_stats, decision.mode, slept);
+    s_was_tickless = slept > 0;
+}
+
+void board_low_power_idle(void)
+{
+    // The hook runs before the kernel checks the idle time, right after a tickless sleep it's likely long again
+    if (s_was_tickless)
+    {
+        s_was_tickless = false;
+        return;
+    }
+
+    __WFI();
+}
+
+void board_low_power_get_stats(low_power_stats_t *p_stats)
+{
+    __disable_irq();
+    *p_stats = s_stats;
+    __enable_irq();
+}
+
+void board_low_power_clear_stats(void)
+{
+    __disable_irq();
+    s_stats = (low_power_stats_t){0};
+    __enable_irq();
+}
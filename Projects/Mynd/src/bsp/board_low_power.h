@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "external/teufel/libs/low_power/low_power.h"
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Drivers which need the high speed clocks while the scheduler is idle, e.g. for a running DMA transfer.
+     *        STOP mode is only entered while none of them holds its lock, otherwise the MCU only sleeps.
+     */
+    typedef enum
+    {
+        BOARD_LOW_POWER_LOCK_ADC,
+        BOARD_LOW_POWER_LOCK_DEBUG_UART_TX,
+        BOARD_LOW_POWER_LOCK_I2C,
+        BOARD_LOW_POWER_LOCK_COUNT,
+    } board_low_power_lock_t;
+
+    /**
+     * @brief Sets up the RTC wakeup timer on LSI and measures the LSI frequency. STOP mode stays disabled if the RTC
+     *        clock is already taken by another source, the backup domain isn't reset as it holds the update flag.
+     */
+    void board_low_power_init(void);
+
+    /**
+     * @brief Locks are counted, every lock needs an unlock. Callable from tasks and ISRs.
+     */
+    void board_low_power_lock(board_low_power_lock_t lock);
+    void board_low_power_unlock(board_low_power_lock_t lock);
+
+    /**
+     * @brief Tickless idle of the kernel, see portSUPPRESS_TICKS_AND_SLEEP in FreeRTOSConfig.h.
+     */
+    void board_low_power_sleep(uint32_t expected_idle_ticks);
+
+    /**
+     * @brief Idle hook, sleeps until the next interrupt unless the last pass of the idle task suppressed the tick.
+     *        Covers the idle times board_low_power_sleep() doesn't sleep through, e.g. the ones of a single tick.
+     */
+    void board_low_power_idle(void);
+
+    void board_low_power_get_stats(low_power_stats_t *p_stats);
+    void board_low_power_clear_stats(void);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -1,5 +1,6 @@
 #include "bsp_debug_uart.h"
 #include "board_hw.h"
+#include "board_low_power.h"
 #include "FreeRTOS.h"
 #include "stream_buffer.h"
 #include "task.h"
@@ -9,14 +10,43 @@
 #include <stdbool.h>
 
 UART_HandleTypeDef          UART2_Handle;
+static DMA_HandleTypeDef    DmaTxHandle;
+static void (*tx_done_callback)(void) = NULL;
 static StreamBufferHandle_t sbuffer_handle_rx;
 static uint8_t              irq_rx_data[1] = {};
 static volatile bool        missed_rx_data = false;
+static volatile bool        tx_dma_active  = false;
+
+// Polls of the UART state, some 10 ms at 48 MHz. A 64 byte DMA transfer of the logger takes 6 ms at 115200 baud.
+#define TX_DMA_BUSY_TIMEOUT_LOOPS 100000u
 
 #define STORAGE_SIZE_BYTES 32
 static uint8_t              sbuffer_storage[STORAGE_SIZE_BYTES];
 static StaticStreamBuffer_t StreamBufferStruct;
 
+// TX DMA, used by the logger task. Not part of the MSP init, which also runs on UART error recovery
+static void debug_uart_tx_dma_init(void)
+{
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    DmaTxHandle.Instance                 = DEBUG_UART_TX_DMA_CHANNEL;
+    DmaTxHandle.Init.Direction           = DMA_MEMORY_TO_PERIPH;
+    DmaTxHandle.Init.PeriphInc           = DMA_PINC_DISABLE;
+    DmaTxHandle.Init.MemInc              = DMA_MINC_ENABLE;
+    DmaTxHandle.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    DmaTxHandle.Init.MemDataAlignment    = DMA_MDATAALIGN_BYTE;
+    DmaTxHandle.Init.Mode                = DMA_NORMAL;
+    DmaTxHandle.Init.Priority            = DMA_PRIORITY_LOW;
+
+    HAL_DMA_DeInit(&DmaTxHandle);
+    HAL_DMA_Init(&DmaTxHandle);
+
+    __HAL_LINKDMA(&UART2_Handle, hdmatx, DmaTxHandle);
+
+    HAL_NVIC_SetPriority(DEBUG_UART_TX_DMA_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(DEBUG_UART_TX_DMA_IRQn);
+}
+
 void bsp_debug_uart_init(void)
 {
     UART2_Handle.Instance                    = DEBUG_UART;
@@ -31,6 +61,12 @@ void bsp_debug_uart_init(void)
     UART2_Handle.AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_NO_INIT;
 
     HAL_UART_Init(&UART2_Handle);
+    debug_uart_tx_dma_init();
+
+    // Console input wakes the MCU up from STOP mode
+    UART_WakeUpTypeDef wakeup = {.WakeUpEvent = UART_WAKEUP_ON_READDATA_NONEMPTY};
+    HAL_UARTEx_StopModeWakeUpSourceConfig(&UART2_Handle, wakeup);
+    HAL_UARTEx_EnableStopMode(&UART2_Handle);
 
     sbuffer_handle_rx = xStreamBufferCreateStatic(sizeof(sbuffer_storage), 0u, sbuffer_storage, &StreamBufferStruct);
     if (sbuffer_handle_rx == NULL)
@@ -76,7 +112,52 @@ void bsp_debug_uart_msp_init(void)
 
 int bsp_debug_uart_tx(const uint8_t *p_data, size_t length)
 {
-    HAL_UART_Transmit(&UART2_Handle, (uint8_t *) p_data, length, HAL_MAX_DELAY);
+    // Let a DMA transfer of the logger finish, the UART would reject the data otherwise. Called with the interrupts
+    // masked, e.g. from a fault handler, the transfer never completes and is cut short instead.
+    uint32_t timeout = TX_DMA_BUSY_TIMEOUT_LOOPS;
+    while (UART2_Handle.gState == HAL_UART_STATE_BUSY_TX)
+    {
+        if (--timeout == 0)
+        {
+            bsp_debug_uart_tx_dma_abort();
+            break;
+        }
+    }
+
+    if (HAL_UART_Transmit(&UART2_Handle, (uint8_t *) p_data, length, HAL_MAX_DELAY) != HAL_OK)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+// Called by the logger task on abort and by the TX complete interrupt, only one of them releases the lock
+static void tx_dma_unlock(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (tx_dma_active)
+    {
+        tx_dma_active = false;
+        board_low_power_unlock(BOARD_LOW_POWER_LOCK_DEBUG_UART_TX);
+    }
+    __set_PRIMASK(primask);
+}
+
+int bsp_debug_uart_tx_dma(const uint8_t *p_data, size_t length, void (*done_callback)(void))
+{
+    tx_done_callback = done_callback;
+
+    // The DMA stops in STOP mode, the lock is released when the transfer is complete or aborted
+    tx_dma_active = true;
+    board_low_power_lock(BOARD_LOW_POWER_LOCK_DEBUG_UART_TX);
+
+    if (HAL_UART_Transmit_DMA(&UART2_Handle, (uint8_t *) p_data, length) != HAL_OK)
+    {
+        tx_dma_unlock();
+        return -1;
+    }
+
     return 0;
 }
 
@@ -103,6 +184,22 @@ int bsp_debug_uart_rx(uint8_t *p_data, size_t length)
     return 0;
 }
 
+void bsp_debug_uart_tx_dma_abort(void)
+{
+    HAL_UART_AbortTransmit(&UART2_Handle);
+    tx_dma_unlock();
+}
+
+void bsp_debug_uart_isr_tx_complete_callback(void)
+{
+    tx_dma_unlock();
+
+    if (tx_done_callback)
+    {
+        tx_done_callback();
+    }
+}
+
 void bsp_debug_uart_isr_rx_complete_callback(void)
 {
     if (xStreamBufferIsFull(sbuffer_handle_rx) == pdFALSE)
@@ -27,6 +27,24 @@ extern "C"
      */
     int bsp_debug_uart_tx(const uint8_t *p_data, size_t length);
 
+    /**
+     * @brief Sends data over UART using DMA.
+     * @note  This function returns immediately, done_callback is called from the interrupt
+     *        context when the transfer completed. p_data must stay valid until then.
+     *
+     * @param[in] p_data        pointer to data to send
+     * @param[in] length        length of data to send
+     * @param[in] done_callback called when the transfer completed
+     *
+     * @return 0 if the transfer was started, -1 otherwise
+     */
+    int bsp_debug_uart_tx_dma(const uint8_t *p_data, size_t length, void (*done_callback)(void));
+
+    /**
+     * @brief Aborts a DMA transfer that did not complete in time.
+     */
+    void bsp_debug_uart_tx_dma_abort(void);
+
     /**
      * @brief Reads data from the UART RX buffer.
      *
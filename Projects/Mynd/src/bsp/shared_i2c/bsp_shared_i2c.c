@@ -2,6 +2,7 @@
 #include "bsp_shared_i2c.h"
 #include "platform/stm32/i2c_freertos.h"
 #include "board_hw.h"
+#include "board_low_power.h"
 #include "logger.h"
 #include "app_assert/app_assert.h"
 
@@ -110,6 +111,9 @@ int bsp_shared_i2c_write(uint8_t i2c_address, uint8_t register_address, const ui
         return -1;
     }
 
+    // The transfer runs on interrupts while the task waits, the I2C clock must keep running
+    board_low_power_lock(BOARD_LOW_POWER_LOCK_I2C);
+
     do
     {
         // Write the data
@@ -123,6 +127,9 @@ int bsp_shared_i2c_write(uint8_t i2c_address, uint8_t register_address, const ui
 
         retries--;
     } while (error < 0 && retries > 0);
+
+    board_low_power_unlock(BOARD_LOW_POWER_LOCK_I2C);
+
     return error;
 }
 
@@ -137,6 +144,8 @@ int bsp_shared_i2c_read(uint8_t i2c_address, uint8_t register_address, uint8_t *
         return -1;
     }
 
+    board_low_power_lock(BOARD_LOW_POWER_LOCK_I2C);
+
     do
     {
         error = i2c_rtos_read_data(i2c_rtos_h, i2c_address, register_address, 1, p_buffer, length);
@@ -149,5 +158,8 @@ int bsp_shared_i2c_read(uint8_t i2c_address, uint8_t register_address, uint8_t *
 
         retries--;
     } while (error < 0 && retries > 0);
+
+    board_low_power_unlock(BOARD_LOW_POWER_LOCK_I2C);
+
     return error;
 }
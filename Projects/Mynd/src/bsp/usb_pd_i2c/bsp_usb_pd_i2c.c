@@ -3,6 +3,7 @@
 #include "app_assert/app_assert.h"
 #include "bsp_usb_pd_i2c.h"
 #include "board_hw.h"
+#include "board_low_power.h"
 #include "logger.h"
 
 I2C_HandleTypeDef          I2C1_Handle;
@@ -60,6 +61,9 @@ int bsp_usb_pd_i2c_write(uint8_t i2c_address, uint8_t register_address, const ui
     int error;
     int retries = 3;
 
+    // Keeps the MCU out of STOP mode while the interrupt driven transfer runs
+    board_low_power_lock(BOARD_LOW_POWER_LOCK_I2C);
+
     do
     {
         // Write the data
@@ -72,6 +76,9 @@ int bsp_usb_pd_i2c_write(uint8_t i2c_address, uint8_t register_address, const ui
 
         retries--;
     } while (error < 0 && retries > 0);
+
+    board_low_power_unlock(BOARD_LOW_POWER_LOCK_I2C);
+
     return error;
 }
 
@@ -80,6 +87,8 @@ int bsp_usb_pd_i2c_read(uint8_t i2c_address, uint8_t register_address, uint8_t *
     int error;
     int retries = 3;
 
+    board_low_power_lock(BOARD_LOW_POWER_LOCK_I2C);
+
     do
     {
         error = i2c_rtos_read_data(i2c_rtos_h, i2c_address, register_address, 1, p_buffer, length);
@@ -92,5 +101,7 @@ int bsp_usb_pd_i2c_read(uint8_t i2c_address, uint8_t register_address, uint8_t *
         retries--;
     } while (error < 0 && retries > 0);
 
+    board_low_power_unlock(BOARD_LOW_POWER_LOCK_I2C);
+
     return error;
 }
@@ -473,6 +473,7 @@ SHELL_CMD_ARG_REGISTER(AT00, NULL, "t: Write Speaker Color To Black", +[]()
     {
         auto color = Teufel::Ux::System::Color{Teufel::Ux::System::Color::Black};
         Storage::save(color);
+        Storage::flush();
         Teufel::Task::Bluetooth::postMessage(Teufel::Ux::System::Task::Audio, color);
         printf("Color=00\r\n");
     }
@@ -484,6 +485,7 @@ SHELL_CMD_ARG_REGISTER(AT01, NULL, "t: Write Speaker Color To White", +[]()
     {
         auto color = Teufel::Ux::System::Color{Teufel::Ux::System::Color::White};
         Storage::save(color);
+        Storage::flush();
         Teufel::Task::Bluetooth::postMessage(Teufel::Ux::System::Task::Audio, color);
         printf("Color=01\r\n");
     }
@@ -495,6 +497,7 @@ SHELL_CMD_ARG_REGISTER(AT02, NULL, "t: Write Speaker Color To Wild Berry", +[]()
     {
         auto color = Teufel::Ux::System::Color{Teufel::Ux::System::Color::Berry};
         Storage::save(color);
+        Storage::flush();
         Teufel::Task::Bluetooth::postMessage(Teufel::Ux::System::Task::Audio, color);
         printf("Color=02\r\n");
     }
@@ -506,6 +509,7 @@ SHELL_CMD_ARG_REGISTER(AT03, NULL, "t: Write Speaker Color To Light Mint", +[]()
     {
         auto color = Teufel::Ux::System::Color{Teufel::Ux::System::Color::Mint};
         Storage::save(color);
+        Storage::flush();
         Teufel::Task::Bluetooth::postMessage(Teufel::Ux::System::Task::Audio, color);
         printf("Color=03\r\n");
     }
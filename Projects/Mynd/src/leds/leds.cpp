@@ -395,6 +395,11 @@ class DimmingController
         }
     }
 
+    bool is_dimming() const
+    {
+        return m_cur_brightness != UINT8_MAX && m_cur_brightness > m_dimmed_brightness;
+    }
+
   private:
     static constexpr uint8_t m_dimmed_brightness = CONFIG_BRIGHTNESS_DIMMED;
     uint8_t                  m_cur_brightness    = UINT8_MAX;
@@ -530,6 +535,16 @@ void tick()
     update_infinite_patterns();
 }
 
+bool is_engine_running(Led led)
+{
+    return led == Led::Status ? s_status_led_engine.is_running() : s_source_led_engine.is_running();
+}
+
+bool is_animating()
+{
+    return is_engine_running(Led::Status) || is_engine_running(Led::Source) || dimming_controller.is_dimming();
+}
+
 void run_engines()
 {
     // Do not run the engines if no patterns are running
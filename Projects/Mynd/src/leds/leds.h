@@ -73,6 +73,8 @@ inline auto getDesc(const SourcePattern &value)
 
 void tick();
 bool is_engine_running(Led led);
+// A pattern or the dimming is running, tick() and run_engines() have to be called periodically
+bool is_animating();
 void run_engines();
 void set_solid_color(Led led, Color color);
 void set_source_pattern(SourcePattern pattern);
@@ -2,19 +2,25 @@
 
 #include "board.h"
 #include "board_hw.h"
+#include "board_low_power.h"
 #include "board_link.h"
 #include "bsp_debug_uart.h"
 
 #include "FreeRTOS.h"
 #include "task.h"
 #include "task_system.h"
+#include "trace_events.h"
 
 #if defined(SEGGER_RTT)
 #include "SEGGER_RTT.h"
 #endif
 #include "logger.h"
+#include "logger_drain.h"
 #include "external/teufel/libs/greeting/greeting.h"
 #include "external/teufel/libs/app_assert/app_assert.h"
+#ifndef BOOTLOADER
+#include "external/teufel/libs/tshell/tshell.h"
+#endif
 
 static void SystemClock_Config();
 
@@ -23,26 +29,69 @@ static StaticTask_t logger_task_buffer;
 static StackType_t  logger_task_stack[TASK_LOGGER_STACK_SIZE];
 
 #define LOGGER_STORAGE_SIZE_BYTES 512
-static uint8_t              logger_sbuffer_storage[LOGGER_STORAGE_SIZE_BYTES];
-static StaticStreamBuffer_t LoggerStreamBufferStruct;
+alignas(4) static uint8_t logger_ring_storage[LOGGER_STORAGE_SIZE_BYTES];
+
+// Chunks are sent by DMA while the log ring keeps taking new logs
+#define LOGGER_CHUNK_SIZE_BYTES 64
+#define LOGGER_TX_TIMEOUT_MS    50
+static uint8_t        logger_chunk[LOGGER_CHUNK_SIZE_BYTES];
+static logger_drain_t logger_drain;
+static TaskHandle_t   logger_task_h = nullptr;
+
+#if TRACE_ENABLED
+// Holds a power on and a power off sequence
+#define TRACE_RECORDS_COUNT 64
+static trace_record_t trace_records[TRACE_RECORDS_COUNT];
+#endif
+
+static const logger_drain_port_t logger_drain_port = {
+    .receive = logger_receive,
+#if defined(SEGGER_RTT)
+    .transmit = [](const uint8_t *p_data, size_t length) -> int
+    {
+        SEGGER_RTT_Write(0, p_data, length);
+        return 0;
+    },
+    .wait_tx_done = []() -> int { return 0; },
+#else
+    .transmit = [](const uint8_t *p_data, size_t length) -> int
+    {
+        return bsp_debug_uart_tx_dma(p_data, length,
+                                     []()
+                                     {
+                                         BaseType_t woken = pdFALSE;
+                                         vTaskNotifyGiveFromISR(logger_task_h, &woken);
+                                         portYIELD_FROM_ISR(woken);
+                                     });
+    },
+    .wait_tx_done = []() -> int
+    {
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOGGER_TX_TIMEOUT_MS)) == 0)
+        {
+            bsp_debug_uart_tx_dma_abort();
+            // A completion which raced the abort would end the wait for the next transfer early
+            (void) ulTaskNotifyTake(pdTRUE, 0);
+            return -1;
+        }
+        return 0;
+    },
+#endif
+};
 
 #if defined(__cplusplus)
 extern "C"
 {
 #endif
 
-    extern UART_HandleTypeDef UART2_Handle;
-
     int __io_putchar(int ch)
     {
-        HAL_UART_Transmit(&UART2_Handle, (uint8_t *) &ch, 1, HAL_MAX_DELAY);
+        bsp_debug_uart_tx((uint8_t *) &ch, 1);
         return ch;
     }
 
     void vApplicationIdleHook(void)
     {
-        // "Low-power mode"
-        __WFI();
+        board_low_power_idle();
     }
 
     void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName)
@@ -57,6 +106,7 @@ extern "C"
         char buffer[24];
 
         board_init();
+        board_low_power_init();
         bsp_debug_uart_init();
 
         snprintf(buffer, sizeof(buffer), "MYND (rev%d)", read_hw_revision());
@@ -119,34 +169,28 @@ int main()
     // Later we can call this function again and it returns the cached value.
     read_hw_revision();
 
+#if TRACE_ENABLED
+    trace_init(trace_records, TRACE_RECORDS_COUNT, board_get_time_us);
+#endif
+
 #if defined(SEGGER_RTT)
     SEGGER_RTT_Init();
 #endif
 
 #ifdef LOGGER_USE_EXTERNAL_THREAD
-    static auto sbuffer_logger_h = xStreamBufferCreateStatic(sizeof(logger_sbuffer_storage), 1u, logger_sbuffer_storage,
-                                                             &LoggerStreamBufferStruct);
+    logger_init(logger_ring_storage, sizeof(logger_ring_storage));
+    logger_drain_init(&logger_drain, &logger_drain_port, logger_chunk, sizeof(logger_chunk));
 
-    logger_init(sbuffer_logger_h);
-
-    TaskHandle_t status = nullptr;
-    status              = xTaskCreateStatic(
-                     +[](void *)
-                     {
+    logger_task_h = xTaskCreateStatic(
+        +[](void *)
+        {
             for (;;)
             {
-                if (uint8_t data; xStreamBufferReceive(sbuffer_logger_h, &data, 1, portMAX_DELAY) > 0)
-                {
-#if defined(SEGGER_RTT)
-                    SEGGER_RTT_PutChar(0, data);
-#else
-                    __io_putchar(data);
-#endif
-                }
+                logger_drain_process(&logger_drain);
             }
         },
         "Logger", TASK_LOGGER_STACK_SIZE, nullptr, 2, logger_task_stack, &logger_task_buffer);
-    APP_ASSERT(status);
+    APP_ASSERT(logger_task_h);
 
 #endif // LOGGER_USE_EXTERNAL_THREAD
 
@@ -160,6 +204,34 @@ int main()
     return 0;
 }
 
+#ifndef BOOTLOADER
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    sub_trace,
+    SHELL_CMD_NO_ARGS(dump, "print the trace records",
+                      []() { printf("%lu trace records\r\n", (unsigned long) trace_dump(printf)); }),
+    SHELL_CMD_NO_ARGS(clear, "discard the trace records", []() { trace_clear(); }),
+    SHELL_SUBCMD_SET_END /* Array terminated. */
+);
+
+SHELL_CMD_ARG_REGISTER(trace, &sub_trace, "trace", NULL, 2, 0);
+
+SHELL_STATIC_SUBCMD_SET_CREATE(
+    sub_lp,
+    SHELL_CMD_NO_ARGS(stats, "wakeups and idle time in SLEEP and STOP mode since the last clear",
+                      []()
+                      {
+                          low_power_stats_t stats;
+                          board_low_power_get_stats(&stats);
+                          printf("wakeups: %lu, sleep: %lu ms, stop: %lu ms\r\n", (unsigned long) stats.wakeups,
+                                 (unsigned long) stats.sleep_ticks, (unsigned long) stats.stop_ticks);
+                      }),
+    SHELL_CMD_NO_ARGS(clear, "reset the statistics", []() { board_low_power_clear_stats(); }),
+    SHELL_SUBCMD_SET_END /* Array terminated. */
+);
+
+SHELL_CMD_ARG_REGISTER(lp, &sub_lp, "low power statistics", NULL, 2, 0);
+#endif
+
 static void SystemClock_Config()
 {
     RCC_OscInitTypeDef       RCC_OscInitStruct = {0};
@@ -184,8 +256,9 @@ static void SystemClock_Config()
     APP_ASSERT(hal_stat == HAL_OK);
 
     PeriphClkInit.PeriphClockSelection = RCC_PERIPHCLK_USART1 | RCC_PERIPHCLK_USART2 | RCC_PERIPHCLK_I2C1;
-    PeriphClkInit.Usart1ClockSelection = RCC_USART1CLKSOURCE_PCLK1;
-    PeriphClkInit.Usart2ClockSelection = RCC_USART2CLKSOURCE_PCLK1;
+    // HSI keeps clocking the UARTs in STOP mode, so that received data wakes the MCU up
+    PeriphClkInit.Usart1ClockSelection = RCC_USART1CLKSOURCE_HSI;
+    PeriphClkInit.Usart2ClockSelection = RCC_USART2CLKSOURCE_HSI;
     PeriphClkInit.I2c1ClockSelection   = RCC_I2C1CLKSOURCE_SYSCLK;
 
     hal_stat = HAL_RCCEx_PeriphCLKConfig(&PeriphClkInit);
@@ -201,6 +274,16 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
             board_link_io_expander_on_interrupt();
             break;
         }
+        case POWER_BUTTON_GPIO_PIN:
+        {
+            board_link_power_supply_on_button_interrupt();
+            break;
+        }
+        case AC_OK_GPIO_PIN:
+        {
+            board_link_power_supply_on_ac_ok_interrupt();
+            break;
+        }
     }
 }
 
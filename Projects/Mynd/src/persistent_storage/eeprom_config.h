@@ -1,6 +1,7 @@
 #pragma once
 
 #define EEPROM_FLASH_PAGE0 ((uint32_t) ADDR_FLASH_PAGE_62)
-#define EEPROM_FLASH_PAGE1 ((uint32_t) ADDR_FLASH_PAGE_63)
+// The last two pages, kept by the bootloader when it erases the application area on an update
+#define EEPROM_PAGES 2
 
 #define EEPROM_ELEMENTS 13
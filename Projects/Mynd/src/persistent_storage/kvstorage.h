@@ -12,6 +12,7 @@
 #include "ux/audio/audio.h"
 #include "ux/bluetooth/bluetooth.h"
 #include "external/teufel/libs/app_assert/app_assert.h"
+#include "board.h"
 
 #include "virtual_eeprom.h"
 #include "eeprom_config.h"
@@ -51,7 +52,21 @@ constexpr uint16_t getTypeIdx()
 
 inline void init()
 {
-    vEEPROM_Init();
+    vEEPROM_Init(get_systick);
+}
+
+// Flushes cached writes and moves the EEPROM page transfer out of the write path, to be called
+// from a low priority context
+inline void maintain()
+{
+    vEEPROM_Maintain();
+}
+
+// Writes are cached in RAM until maintain() flushes them, flush() has to be called before the
+// power is cut or the MCU is reset
+inline int flush()
+{
+    return vEEPROM_Flush();
 }
 
 template <typename T>
@@ -105,47 +120,105 @@ constexpr std::optional<T> load()
     return std::nullopt;
 }
 
+namespace detail
+{
+// Flash cells a persistable is stored in, multi-halfword values span several cells
+struct Cells
+{
+    uint16_t addr[2];
+    uint16_t value[2];
+    uint16_t count;
+};
+
 template <typename T>
-constexpr void save(T v)
+constexpr Cells encode(T v)
 {
     using BaseT = std::decay_t<T>;
-    auto key    = getTypeIdx<BaseT>();
 
-    if constexpr (std::is_same_v<T, Teufel::Ux::System::BatterySoCAlgoState>)
+    if constexpr (std::is_same_v<BaseT, Teufel::Ux::System::BatterySoCAlgoState>)
     {
-        auto cell_value = static_cast<uint16_t>(v);
-        vEEPROM_AddressWrite(0x70, cell_value);
-
-        return;
+        return Cells{.addr = {0x70}, .value = {static_cast<uint16_t>(v)}, .count = 1};
     }
-
-    if constexpr (std::is_same_v<T, Teufel::Ux::System::BatterySocAccumulatedCharge>)
+    else if constexpr (std::is_same_v<BaseT, Teufel::Ux::System::BatterySocAccumulatedCharge>)
+    {
+        uint32_t c = *(uint32_t *) &v.value;
+        return Cells{.addr = {0x71, 0x72}, .value = {uint16_t((c >> 16) & 0xFFFF), uint16_t(c & 0xFFFF)}, .count = 2};
+    }
+    else if constexpr (std::is_same_v<BaseT, Teufel::Ux::System::BatterySocCapacity>)
+    {
+        uint32_t c = *(uint32_t *) &v.value;
+        return Cells{.addr = {0x73, 0x74}, .value = {uint16_t((c >> 16) & 0xFFFF), uint16_t(c & 0xFFFF)}, .count = 2};
+    }
+    else if constexpr (std::is_enum_v<BaseT>)
+    {
+        return Cells{.addr = {getTypeIdx<BaseT>()}, .value = {static_cast<uint16_t>(v)}, .count = 1};
+    }
+    else
     {
-        uint32_t c              = *(uint32_t *) &v.value;
-        uint16_t cell_value_msb = (c >> 16) & 0xFFFF;
-        uint16_t cell_value_lsb = c & 0xFFFF;
+        return Cells{.addr = {getTypeIdx<BaseT>()}, .value = {static_cast<uint16_t>(v.value)}, .count = 1};
+    }
+}
+}
+
+template <typename T>
+constexpr void save(T v)
+{
+    auto cells = detail::encode(v);
 
-        vEEPROM_AddressWrite(0x71, cell_value_msb);
-        vEEPROM_AddressWrite(0x72, cell_value_lsb);
+    // Both halves of a multi-halfword value are committed together
+    if (cells.count == 1)
+        vEEPROM_AddressWrite(cells.addr[0], cells.value[0]);
+    else
+        vEEPROM_AddressWriteBatch(cells.addr, cells.value, cells.count);
+}
 
-        return;
+/**
+ * @brief Collects several persistables and commits them as one transaction.
+ * commit() queues them in the write cache, after a power loss during the following flush
+ * either all of them or none of them are updated.
+ */
+class Batch
+{
+  public:
+    template <typename T>
+    Batch &add(T v)
+    {
+        auto cells = detail::encode(v);
+        for (uint16_t i = 0; i < cells.count; i++)
+            put(cells.addr[i], cells.value[i]);
+        return *this;
     }
 
-    if constexpr (std::is_same_v<T, Teufel::Ux::System::BatterySocCapacity>)
+    int commit()
     {
-        uint32_t c              = *(uint32_t *) &v.value;
-        uint16_t cell_value_msb = (c >> 16) & 0xFFFF;
-        uint16_t cell_value_lsb = c & 0xFFFF;
+        auto err = vEEPROM_AddressWriteBatch(m_addr, m_value, m_count);
+        m_count  = 0;
+        return err;
+    }
 
-        vEEPROM_AddressWrite(0x73, cell_value_msb);
-        vEEPROM_AddressWrite(0x74, cell_value_lsb);
+  private:
+    void put(uint16_t addr, uint16_t value)
+    {
+        // Last value wins if a cell is added twice
+        for (uint16_t i = 0; i < m_count; i++)
+        {
+            if (m_addr[i] == addr)
+            {
+                m_value[i] = value;
+                return;
+            }
+        }
+
+        APP_ASSERT(m_count < VEEPROM_BATCH_MAX_SIZE, "Storage batch overflow");
+        m_addr[m_count]  = addr;
+        m_value[m_count] = value;
+        m_count++;
     }
 
-    if constexpr (std::is_enum_v<BaseT>)
-        vEEPROM_AddressWrite(key, static_cast<uint32_t>(v));
-    else
-        vEEPROM_AddressWrite(key, static_cast<uint32_t>(v.value));
-}
+    uint16_t m_addr[VEEPROM_BATCH_MAX_SIZE]  = {};
+    uint16_t m_value[VEEPROM_BATCH_MAX_SIZE] = {};
+    uint16_t m_count                         = 0;
+};
 
 static inline void test_helper(const Teufel::Ux::System::BatterySocAccumulatedCharge &v)
 {
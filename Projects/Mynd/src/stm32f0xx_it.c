@@ -19,10 +19,25 @@ void HardFault_Handler(void)
     NVIC_SystemReset();
 }
 
+void EXTI0_1_IRQHandler(void)
+{
+    // Power button
+    HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_0);
+}
+
 void EXTI2_3_IRQHandler(void)
 {
     // IO expander interrupt pin
     HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_2);
+    // AC OK of the charger
+    HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_3);
+}
+
+void RTC_IRQHandler(void)
+{
+    // Wakeup timer of the tickless idle, the time spent in STOP mode is read from the RTC by board_low_power_sleep()
+    RTC->ISR &= ~RTC_ISR_WUTF;
+    EXTI->PR = EXTI_PR_PR20;
 }
 
 void I2C1_IRQHandler(void)
@@ -47,6 +62,12 @@ void DMA1_Channel1_IRQHandler(void)
     HAL_DMA_IRQHandler(Adc1Handle.DMA_Handle);
 }
 
+void DMA1_Channel4_5_6_7_IRQHandler(void)
+{
+    // Debug UART TX
+    HAL_DMA_IRQHandler(UART2_Handle.hdmatx);
+}
+
 void USART1_IRQHandler(void)
 {
     HAL_UART_IRQHandler(&UART1_Handle);
@@ -59,6 +80,15 @@ void USART2_IRQHandler(void)
 
 void bsp_bluetooth_uart_isr_rx_complete_callback(void);
 void bsp_debug_uart_isr_rx_complete_callback(void);
+void bsp_debug_uart_isr_tx_complete_callback(void);
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance == USART2)
+    {
+        bsp_debug_uart_isr_tx_complete_callback();
+    }
+}
 
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
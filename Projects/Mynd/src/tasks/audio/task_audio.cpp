@@ -27,6 +27,7 @@
 #include "task_bluetooth.h"
 #include "task_system.h"
 #include "task_priorities.h"
+#include "startup.h"
 #include "tests.h"
 
 #include "external/teufel/libs/tshell/tshell.h"
@@ -99,8 +100,28 @@ static auto pwr_ac_debouncer = Debouncer<bool, 2000>{true, get_systick, board_ge
 // static auto volume_debouncer = Debouncer<bool, 200>{false, get_systick, board_get_ms_since};
 
 static void read_io_expander_inputs();
+static void read_power_button();
+static void service_usb_pd(bool interrupt);
+static void update_idle_period();
 static void disable_amps();
 
+// The idle callback ticks the LEDs and polls the buttons, the battery and the PD controller. While nothing is animated
+// or pressed it only has to keep up with the battery voltage sampling every 200 ms.
+static constexpr uint32_t c_idle_period_active_ms = 25;
+static constexpr uint32_t c_idle_period_quiet_ms  = 200;
+
+// The interrupt line of the PD controller isn't connected to the MCU, its events are read on every VBUS change instead
+// (AC OK of the charger), then again while more keep coming. Changes without a VBUS edge, e.g. an unplug while
+// sourcing, are found by the watchdog no later than by the 500 ms poll it replaces, a reset of the PD controller which
+// lost the event mask by the full poll.
+static constexpr uint32_t c_usb_pd_follow_up_ms = 100;
+static constexpr uint32_t c_usb_pd_watchdog_ms  = 500;
+static constexpr uint32_t c_usb_pd_full_poll_ms = 10000;
+static uint32_t           s_usb_pd_events_ts    = 0;
+static uint32_t           s_usb_pd_full_poll_ts = 0;
+static bool               s_usb_pd_follow_up    = false;
+static bool               s_usb_pd_poll_due     = true;
+
 static Tus::Task                                           ot_id                      = Tus::Task::Audio;
 static Teufel::GenericThread::GenericThread<AudioMessage> *task_handler               = nullptr;
 static button_handler_t                                   *s_button_handler           = nullptr;
@@ -131,7 +152,7 @@ static const board_link_usb_pd_controller_callbacks_t usb_callbacks = {
         },
     .power_connection_change_cb =
         +[](bool connected) { log_info("Power connection change: %s", connected ? "connected" : "disconnected"); },
-    .pd_port_role_change_cb = +[](bool source) { log_err("PD port role changed: %s", source ? "source" : "sink"); },
+    .pd_port_role_change_cb = +[](bool source) { log_info("PD port role changed: %s", source ? "source" : "sink"); },
 };
 
 static Leds::SourcePattern get_connected_source_pattern()
@@ -453,6 +474,7 @@ TS_KEY_VALUE_CONST_MAP(EventHandlerMapper, uint32_t, button_event_handler_fn_t,
             // Set the backup register to a magic value that will trigger a bootloader jump
             RTC->BKP0R = 0xCAFEBEEF;
 
+            Storage::flush();
             NVIC_SystemReset();
         }
     }},
@@ -562,7 +584,7 @@ static const GenericThread::Config<AudioMessage> threadConfig = {
     .Name      = "Audio",
     .StackSize = TASK_AUDIO_STACK_SIZE,
     .Priority  = TASK_AUDIO_PRIORITY,
-    .IdleMs    = 25,
+    .IdleMs    = c_idle_period_active_ms,
     .Callback_Idle = []() {
         // Checking if (not isProperty(Tus::PowerState::Off) is unnecessary here. It prevented charging indication from playing while in pseudo off state and
         // the s_source_led_engine has logic in update_infinite_patterns() to ensure it does not run while in a power-off state.
@@ -576,18 +598,14 @@ static const GenericThread::Config<AudioMessage> threadConfig = {
             Leds::run_engines();
         }
 
-        if (board_link_power_supply_button_is_pressed()) {
-            s_buttons_state |= BUTTON_ID_POWER;
-        } else {
-            s_buttons_state &= ~BUTTON_ID_POWER;
-        }
-
-        button_handler_process(s_button_handler, s_buttons_state);
+        read_power_button();
 
         // TODO: Rework/de-duplicate conditions for polling USB PD controller and battery
         //       once we add support for polling them in off mode (with USB power supply connected)
 
-        // Poll the USB PD controller/charger/plug detection every 500 ms
+        service_usb_pd(false);
+
+        // Poll the plug detection every 500 ms
         // Only do it until the speaker is completely powered on, otherwise we will send events
         // before the Bluetooth task is ready to handle them
         if ((board_get_ms_since(s_connection_poll_ts) >= 500) &&
@@ -597,8 +615,6 @@ static const GenericThread::Config<AudioMessage> threadConfig = {
             (isProperty(Tus::PowerState::On))) {
             s_connection_poll_ts = get_systick();
 
-            board_link_usb_pd_controller_poll_status(&usb_callbacks);
-
             if (board_link_plug_detection_is_jack_connected() != s_is_aux_jack_connected) {
                 s_is_aux_jack_connected = board_link_plug_detection_is_jack_connected();
                 log_info("Audio jack %s", s_is_aux_jack_connected ? "connected" : "disconnected");
@@ -631,6 +647,7 @@ static const GenericThread::Config<AudioMessage> threadConfig = {
             vTaskDelay(pdMS_TO_TICKS(1000));
 
             // The MCU will lose power shortly after this
+            Storage::flush();
             board_link_power_supply_hold_on(false);
         }
 
@@ -640,6 +657,8 @@ static const GenericThread::Config<AudioMessage> threadConfig = {
         }
 
         factory_test_key_process();
+
+        update_idle_period();
     },
     .Callback_Init = []() {
         bsp_shared_i2c_init();
@@ -663,6 +682,10 @@ static const GenericThread::Config<AudioMessage> threadConfig = {
 
         board_link_io_expander_setup_for_normal_operation();
 
+        // The power button is only polled while a button is active, its edges wake up the task otherwise
+        board_link_power_supply_attach_button_interrupt_handler(+[]() { postMessage(ot_id, PowerButtonInterrupt{}); });
+        board_link_power_supply_attach_ac_ok_interrupt_handler(+[]() { postMessage(ot_id, UsbPdInterrupt{}); });
+
         // If the power supply button is still pressed, wait for the release before processing new inputs
         // if it's not pressed anymore that means that it was already released and we can process inputs
         if (board_link_power_supply_button_is_pressed()) {
@@ -675,27 +698,32 @@ static const GenericThread::Config<AudioMessage> threadConfig = {
         auto brightness = getProperty<Tus::LedBrightness>();
         Leds::set_brightness(brightness.value);
 
-        // PD controller needs some time to load firmware from the EEPROM.
-        // It's 1s now, and might be increased in the future.
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        Startup::complete(Startup::Step::AudioInit);
 
+        // PD controller needs some time to load firmware from the EEPROM, about 1 s now. It reports the
+        // application mode once it's done, which is polled for instead of waiting for the worst case.
         log_info("Waiting for USB PD ready");
         board_link_usb_pd_controller_init();
-        board_link_usb_pd_controller_poll_status(&usb_callbacks);
 
-        // TODO: Figure out how to handle the case where the USB PD controller is never ready
-        //       At the very least the user should be able to power cycle the speaker
-        while (not board_link_usb_pd_controller_is_ready())
+        // If the USB PD controller is never ready, the battery management is started anyway, so that
+        // at least the user is able to power cycle the speaker
+        if (Startup::wait_for(
+                Startup::Step::PdReady,
+                +[]()
+                {
+                    board_link_usb_pd_controller_poll_status(&usb_callbacks);
+                    return board_link_usb_pd_controller_is_ready();
+                },
+                50) == 0)
         {
-            vTaskDelay(pdMS_TO_TICKS(50));
-            board_link_usb_pd_controller_poll_status(&usb_callbacks);
+            log_info("USB PD ready");
         }
-        log_info("USB PD ready");
 
         // Battery management depends on the successful initialization of the USB PD controller
         Battery::init();
         load_persistent_parameters();
 
+        Startup::complete(Startup::Step::Battery);
         SyncPrimitive::notify(ot_id);
     },
     .QueueSize = QUEUE_SIZE,
@@ -708,14 +736,16 @@ static const GenericThread::Config<AudioMessage> threadConfig = {
                         case Tus::PowerState::PreOff: {
 
                             log_info("Saving persistent parameters");
-                            Storage::save(getProperty<Tus::LedBrightness>());
-                            Storage::save(getProperty<Tua::BassLevel>());
-                            Storage::save(getProperty<Tua::TrebleLevel>());
-                            Storage::save(getProperty<Tua::EcoMode>());
-                            Storage::save(getProperty<Tua::SoundIconsActive>());
-                            Storage::save(getProperty<Tua::VolumeLevel>());
-                            Storage::save(getProperty<Tus::OffTimer>());
-                            Storage::save(getProperty<Tus::OffTimerEnabled>());
+                            Storage::Batch()
+                                .add(getProperty<Tus::LedBrightness>())
+                                .add(getProperty<Tua::BassLevel>())
+                                .add(getProperty<Tua::TrebleLevel>())
+                                .add(getProperty<Tua::EcoMode>())
+                                .add(getProperty<Tua::SoundIconsActive>())
+                                .add(getProperty<Tua::VolumeLevel>())
+                                .add(getProperty<Tus::OffTimer>())
+                                .add(getProperty<Tus::OffTimerEnabled>())
+                                .commit();
                             Battery::save_persistent_parameters();
 
                             // Exit no I2C mode to prepare for shutdown
@@ -785,6 +815,7 @@ static const GenericThread::Config<AudioMessage> threadConfig = {
                             // Likely not necessary considering all the stuff that needs to happen
                             // before the amps are initialized when we get PowerState::On
                             vTaskDelay(pdMS_TO_TICKS(5));
+                            Startup::complete(Startup::Step::AmpsEnabled);
 
                             if (s_audio.bypass_mode)
                             {
@@ -829,6 +860,7 @@ static const GenericThread::Config<AudioMessage> threadConfig = {
 
                             Battery::set_power_state(p.to);
 
+                            Startup::complete(Startup::Step::AmpsConfigured);
                             break;
                         }
 
@@ -841,6 +873,12 @@ static const GenericThread::Config<AudioMessage> threadConfig = {
                     log_debug("IO expander interrupt");
                     read_io_expander_inputs();
                 },
+                [](const PowerButtonInterrupt &) {
+                    read_power_button();
+                },
+                [](const UsbPdInterrupt &) {
+                    service_usb_pd(true);
+                },
                 [](const Tus::LedBrightness &p) {
                     setProperty(p);
                     Leds::set_brightness(p.value);
@@ -947,11 +985,15 @@ static const GenericThread::Config<AudioMessage> threadConfig = {
                 },
                 [](const Tus::HardReset &) {
                     disable_amps();
+                    Storage::flush();
                     vPortEnterCritical();
                     NVIC_DisableIRQ(SysTick_IRQn);
                     NVIC_SystemReset();
                 },
             }, msg);
+
+        // Patterns following a status change are started by Leds::tick(), the idle callback decides again after that
+        GenericThread::SetIdleMs(task_handler, c_idle_period_active_ms);
     },
     .StackBuffer = audio_task_stack,
     .StaticTask = &audio_task_buffer,
@@ -998,6 +1040,53 @@ static void read_io_expander_inputs() {
     button_handler_process(s_button_handler, s_buttons_state);
 }
 
+static void read_power_button()
+{
+    if (board_link_power_supply_button_is_pressed()) {
+        s_buttons_state |= BUTTON_ID_POWER;
+    } else {
+        s_buttons_state &= ~BUTTON_ID_POWER;
+    }
+
+    button_handler_process(s_button_handler, s_buttons_state);
+}
+
+static void service_usb_pd(bool interrupt)
+{
+    // Only once the speaker is completely powered on, otherwise we will send events before the Bluetooth task is ready
+    // to handle them. Whatever changed in the meantime is caught up with a complete poll.
+    if (
+#ifdef BOARD_CONFIG_HAS_NO_I2C_MODE
+        s_audio.no_i2c_mode ||
+#endif
+        not isProperty(Tus::PowerState::On)) {
+        s_usb_pd_poll_due = true;
+        return;
+    }
+
+    if (s_usb_pd_poll_due || board_get_ms_since(s_usb_pd_full_poll_ts) >= c_usb_pd_full_poll_ms) {
+        s_usb_pd_poll_due     = false;
+        s_usb_pd_full_poll_ts = get_systick();
+        s_usb_pd_events_ts    = s_usb_pd_full_poll_ts;
+        board_link_usb_pd_controller_poll_status(&usb_callbacks);
+        return;
+    }
+
+    const uint32_t period_ms = s_usb_pd_follow_up ? c_usb_pd_follow_up_ms : c_usb_pd_watchdog_ms;
+    if (interrupt || board_get_ms_since(s_usb_pd_events_ts) >= period_ms) {
+        s_usb_pd_events_ts = get_systick();
+        s_usb_pd_follow_up = board_link_usb_pd_controller_process_events(&usb_callbacks, interrupt);
+    }
+}
+
+static void update_idle_period()
+{
+    bool is_active = Leds::is_animating() || s_buttons_state != 0 || !button_handler_is_idle(s_button_handler) ||
+                     s_usb_pd_follow_up || is_test_mode_activated();
+
+    GenericThread::SetIdleMs(task_handler, is_active ? c_idle_period_active_ms : c_idle_period_quiet_ms);
+}
+
 static void disable_amps()
 {
     // Mute the amps and wait for them to mute before power down
@@ -12,6 +12,8 @@ namespace Teufel::Task::Audio
 
 // clang-format off
 struct IoExpanderInterrupt {};
+struct PowerButtonInterrupt {};
+struct UsbPdInterrupt {};
 
 using AudioMessage = std::variant<
     Teufel::Ux::System::SetPowerState,
@@ -19,6 +21,8 @@ using AudioMessage = std::variant<
     Teufel::Ux::Audio::UpdateVolume,
     Teufel::Ux::Bluetooth::Status,
     IoExpanderInterrupt,
+    PowerButtonInterrupt,
+    UsbPdInterrupt,
     Teufel::Ux::System::FactoryReset,
     Teufel::Ux::System::HardReset,
     Teufel::Ux::Audio::SoundIconsActive,
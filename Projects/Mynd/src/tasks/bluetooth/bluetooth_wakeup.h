@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+// When the Bluetooth task wakes up for the chip, shared with the host test of the RX wake ups
+
+namespace Teufel::Task::Bluetooth
+{
+
+constexpr uint32_t c_idle_period_ms = 10;
+// Received frames wake the task up on their own, with the chip powered and nothing else to do it only checks in this
+// often in case a frame end was missed
+constexpr uint32_t c_chip_idle_period_ms = 1000;
+// GenericThread::IdleNever, the task only wakes up for messages
+constexpr uint32_t c_idle_never = UINT32_MAX;
+
+struct IdleState
+{
+    bool     is_chip_active;
+    bool     needs_ticks;        // The library, bytes left in the RX buffer or a repeating sound icon, with the chip active
+    bool     has_pending_work;   // Work of the task that doesn't need the chip, e.g. a debounced state update
+    uint32_t sound_icons_due_ms; // UINT32_MAX if none is scheduled
+};
+
+// Polls while anything is due, waits for frames with the chip active and idle, and for messages alone with the chip
+// off. A sound icon waiting for the playing one wakes the task up once that one is done.
+constexpr uint32_t idle_period_ms(const IdleState &state)
+{
+    uint32_t idle_ms = c_idle_never;
+    if ((state.is_chip_active && state.needs_ticks) || state.has_pending_work)
+    {
+        idle_ms = c_idle_period_ms;
+    }
+    else if (state.is_chip_active)
+    {
+        idle_ms = c_chip_idle_period_ms;
+    }
+
+    const uint32_t sound_icons_due_ms = state.is_chip_active ? state.sound_icons_due_ms : UINT32_MAX;
+    if (sound_icons_due_ms < idle_ms)
+    {
+        idle_ms = std::max<uint32_t>(sound_icons_due_ms, 1u);
+    }
+    return idle_ms;
+}
+
+// Set by the UART interrupt while a ChipFrameReceived is in the queue, so a burst of frames posts only one
+class FramePostGuard
+{
+  public:
+    // From the interrupt, post_fn returns 0 once the message is queued
+    template <typename PostFn>
+    void post(PostFn post_fn)
+    {
+        if (not m_is_pending)
+        {
+            m_is_pending = true;
+            if (post_fn() != 0)
+                m_is_pending = false;
+        }
+    }
+
+    // From the task taking the message, frames received from then on post another one
+    void clear() { m_is_pending = false; }
+
+  private:
+    volatile bool m_is_pending = false;
+};
+
+}
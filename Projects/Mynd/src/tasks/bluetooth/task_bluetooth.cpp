@@ -17,6 +17,8 @@
 #include "bsp_bluetooth_uart.h"
 #include "actionslink.h"
 #include "task_priorities.h"
+#include "startup.h"
+#include "trace_events.h"
 #include "logger.h"
 
 #include "ux/audio/audio.h"
@@ -24,6 +26,7 @@
 #include "external/teufel/libs/GenericThread/GenericThread++.h"
 #include "task_audio.h"
 #include "task_bluetooth.h"
+#include "bluetooth_wakeup.h"
 #include "task_system.h"
 
 #include "external/teufel/libs/property/property.h"
@@ -83,21 +86,56 @@ static struct
     // Timestamp of the power on sound icon. This is used to prevent other sound icons from playing.
     // It is some sort of a simple lock mechanism to prevent other sound icons from playing while the power on sound
     // icon is playing.
-    uint32_t                 power_on_sound_icon_ts   = 0u;
-    actionslink_sound_icon_t curr_sound_icon          = ACTIONSLINK_SOUND_ICON_NONE;
-    uint32_t                 curr_sound_icon_begin_ts = 0u;
+    uint32_t power_on_sound_icon_ts = 0u;
+    // Set once the chip is powered on until the power on sound icon is requested, see is_power_on_sound_icon_due()
+    std::optional<uint32_t> power_on_ts = std::nullopt;
+    // A device connected before the power on sound icon was requested, its sound icon plays after that one
+    bool is_bt_connected_sound_icon_deferred = false;
+
+    // The chip is booted ahead of PowerState::On during the startup
+    bool is_chip_booted = false;
 } s_bluetooth;
 
+static FramePostGuard s_frame_post_guard;
+
 // clang-format off
-TS_KEY_VALUE_CONST_MAP(SoundIconToLengthMapper, actionslink_sound_icon_t, uint16_t,
-                       {ACTIONSLINK_SOUND_ICON_POSITIVE_FEEDBACK, 180},
-                       {ACTIONSLINK_SOUND_ICON_CHARGING, 1440},
-                       {ACTIONSLINK_SOUND_ICON_BATTERY_LOW, 910},
-                       {ACTIONSLINK_SOUND_ICON_BT_PAIRING, 4570},
-                       {ACTIONSLINK_SOUND_ICON_MULTISPEAKER_CHAIN_MASTER_ENTERED, 4570},
-                       {ACTIONSLINK_SOUND_ICON_MULTISPEAKER_CHAIN_SLAVE_PAIRING, 4570},
-                       {ACTIONSLINK_SOUND_ICON_POWER_ON, 1670}, )
+constexpr uint16_t c_power_on_sound_icon_ms = 1670;
+// Sound icons interrupt playing ones of lower priority and wait for the others, see actionslink_request_sound_icon().
+// The lengths tell when the next one may start, UX spec says that the power off sound icon is 1.832 seconds long.
+static const actionslink_sound_icon_info_t c_sound_icons[] = {
+    {ACTIONSLINK_SOUND_ICON_POWER_OFF, ACTIONSLINK_SOUND_ICON_PRIORITY_CRITICAL, 1832},
+    {ACTIONSLINK_SOUND_ICON_POWER_ON, ACTIONSLINK_SOUND_ICON_PRIORITY_CRITICAL, c_power_on_sound_icon_ms},
+    {ACTIONSLINK_SOUND_ICON_BATTERY_LOW, ACTIONSLINK_SOUND_ICON_PRIORITY_HIGH, 910},
+    {ACTIONSLINK_SOUND_ICON_ERROR, ACTIONSLINK_SOUND_ICON_PRIORITY_HIGH, 0},
+    {ACTIONSLINK_SOUND_ICON_CHARGING, ACTIONSLINK_SOUND_ICON_PRIORITY_NORMAL, 1440},
+    {ACTIONSLINK_SOUND_ICON_POSITIVE_FEEDBACK, ACTIONSLINK_SOUND_ICON_PRIORITY_NORMAL, 180},
+    {ACTIONSLINK_SOUND_ICON_MULTISPEAKER_CHAIN_MASTER_ENTERED, ACTIONSLINK_SOUND_ICON_PRIORITY_NORMAL, 4570},
+    {ACTIONSLINK_SOUND_ICON_BT_PAIRING, ACTIONSLINK_SOUND_ICON_PRIORITY_LOW, 4570},
+    {ACTIONSLINK_SOUND_ICON_MULTISPEAKER_CHAIN_SLAVE_PAIRING, ACTIONSLINK_SOUND_ICON_PRIORITY_LOW, 4570},
+};
+static const actionslink_sound_icons_config_t c_sound_icons_config = {
+    .p_sound_icons     = c_sound_icons,
+    .sound_icons_count = sizeof(c_sound_icons) / sizeof(c_sound_icons[0]),
+    .default_length_ms = 1000,
+};
 constexpr uint32_t c_update_bt_state_ts_duration = 200;
+static_assert(c_idle_never == GenericThread::IdleNever);
+// Frames handled per wake up, bounds the time spent in the task if the chip keeps sending
+constexpr uint8_t c_max_frames_per_wakeup = 8;
+// Most of the power off sound icon, see PowerState::PreOff
+constexpr uint32_t c_power_off_sound_icon_wait_ms = 1780;
+// The system task requests the power on sound icon once the amps are configured, which it waits up to 3 s for
+constexpr uint32_t c_power_on_sound_icon_due_ms = 3500;
+// State changes come in bursts (charger plugged in, power on), within this window only the latest value of each kind
+// is sent to the chip
+constexpr uint16_t c_notification_window_ms = 20;
+// The chip is ready for the power on request once it answers requests. Booting takes up to about 1.5 s until the
+// first frame, the steps add up to the timeout of Startup::Step::BtChipReady.
+static const actionslink_bringup_config_t c_bringup_config = {
+    .step_timeout_ms    = {1800, 400, 800},
+    .probe_delay_ms     = 10,
+    .max_probe_delay_ms = 160,
+};
 // clang-format on
 
 static void actionslink_print_log(actionslink_log_level_t level, const char *dsc);
@@ -194,6 +232,24 @@ static bool power_on_sound_icon_played()
     return s_bluetooth.power_on_sound_icon_ts == UINT32_MAX;
 }
 
+// The power on sound icon is about to be requested, it isn't if the power on was cut short or sound icons are off
+static bool is_power_on_sound_icon_due()
+{
+    return s_bluetooth.power_on_ts.has_value() &&
+           board_get_ms_since(s_bluetooth.power_on_ts.value()) < c_power_on_sound_icon_due_ms;
+}
+
+static void request_deferred_bt_connected_sound_icon()
+{
+    s_bluetooth.is_bt_connected_sound_icon_deferred = false;
+    if (getProperty<Ux::Audio::SoundIconsActive>().value &&
+        actionslink_request_sound_icon(ACTIONSLINK_SOUND_ICON_BT_CONNECTED,
+                                       ACTIONSLINK_SOUND_ICON_PLAYBACK_MODE_PLAY_IMMEDIATELY, false) != 0)
+    {
+        log_error("Sound icon (si: %d) request failed", ACTIONSLINK_SOUND_ICON_BT_CONNECTED);
+    }
+}
+
 static void handle_new_bt_state()
 {
     // Can't make decisions about BT state until audio source is known
@@ -294,18 +350,16 @@ static void update_infinite_sound_icons()
          []() { return isProperty(Ux::Bluetooth::Status::SlavePairing); }},
     };
 
+    // The pairing sound icons are of the lowest priority, they wait until the playing sound icon is done
     for (auto [icon, condition] : infinite_sound_icons)
     {
-        if (s_bluetooth.curr_sound_icon != icon && condition())
+        const bool is_scheduled = actionslink_is_sound_icon_scheduled(icon);
+        if (not is_scheduled && condition())
         {
-            if (board_get_ms_since(s_bluetooth.curr_sound_icon_begin_ts) >=
-                Teufel::Core::mapValue(SoundIconToLengthMapper, s_bluetooth.curr_sound_icon).value_or(0))
-            {
-                postMessage(ot_id,
-                            Tua::RequestSoundIcon{icon, ACTIONSLINK_SOUND_ICON_PLAYBACK_MODE_PLAY_IMMEDIATELY, true});
-            }
+            postMessage(ot_id,
+                        Tua::RequestSoundIcon{icon, ACTIONSLINK_SOUND_ICON_PLAYBACK_MODE_PLAY_IMMEDIATELY, true});
         }
-        else if (s_bluetooth.curr_sound_icon == icon && not condition())
+        else if (is_scheduled && not condition())
         {
             postMessage(ot_id, Tua::StopPlayingSoundIcon{icon});
         }
@@ -473,6 +527,7 @@ static const actionslink_event_handlers_t actionslink_event_handlers = {
             {
                 case ACTIONSLINK_POWER_STATE_OFF:
                     log_info("Actions power: OFF");
+                    TRACE(TRACE_BT_POWER_OFF_CONFIRMED, 0);
                     s_bluetooth.has_received_power_off_confirmation = true;
                     break;
                 case ACTIONSLINK_POWER_STATE_ON:
@@ -494,6 +549,7 @@ static const actionslink_event_handlers_t actionslink_event_handlers = {
         }
 
         log_info("Audio source changed to %d", audio_source);
+        TRACE(TRACE_BT_AUDIO_SOURCE, audio_source);
         s_bluetooth.audio_source       = audio_source;
         s_bluetooth.update_bt_state    = true;
         s_bluetooth.update_bt_state_ts = get_systick();
@@ -632,24 +688,120 @@ static const actionslink_event_handlers_t actionslink_event_handlers = {
 };
 
 static const actionslink_config_t actionslink_configuration = {
-    .write_buffer_fn = actionslink_write_buffer,
-    .read_buffer_fn  = actionslink_read_buffer,
-    .get_tick_ms_fn  = get_systick,
-    .msp_init_fn     = nullptr,
-    .msp_deinit_fn   = nullptr,
-    .task_yield_fn   = +[]() { vTaskDelay(pdMS_TO_TICKS(2)); },
-    .log_fn          = actionslink_print_log,
-    .p_rx_buffer     = actionslink_rx_buffer,
-    .p_tx_buffer     = actionslink_tx_buffer,
-    .rx_buffer_size  = ACTIONSLINK_RX_BUFFER_SIZE,
-    .tx_buffer_size  = ACTIONSLINK_TX_BUFFER_SIZE,
+    .write_buffer_fn        = actionslink_write_buffer,
+    .read_buffer_fn         = actionslink_read_buffer,
+    .get_tick_ms_fn         = get_systick,
+    .msp_init_fn            = nullptr,
+    .msp_deinit_fn          = nullptr,
+    .task_yield_fn          = +[]() { vTaskDelay(pdMS_TO_TICKS(2)); },
+    .log_fn                 = actionslink_print_log,
+    .p_rx_buffer            = actionslink_rx_buffer,
+    .p_tx_buffer            = actionslink_tx_buffer,
+    .rx_buffer_size         = ACTIONSLINK_RX_BUFFER_SIZE,
+    .tx_buffer_size         = ACTIONSLINK_TX_BUFFER_SIZE,
+    .notification_window_ms = c_notification_window_ms,
+    .p_sound_icons_config   = &c_sound_icons_config,
 };
 
+// Powers the chip and waits until it's ready. The I2S clocks only start with the power on request, so this doesn't
+// depend on the amps and runs while the rest of the system is still starting. A chip that doesn't get ready is powered
+// off again, the next power on boots it anew.
+static bool boot_chip()
+{
+    TRACE(TRACE_BT_CHIP_BOOT, 0);
+    board_link_bluetooth_reset(false);
+    board_link_bluetooth_set_power(true);
+
+    bsp_bluetooth_uart_clear_buffer();
+    actionslink_init(&actionslink_configuration, &actionslink_event_handlers, &actionslink_request_handlers);
+
+    // The firmware version is read by the probes of the bring up
+    uint8_t                        build_str_buffer[32] = {0};
+    actionslink_buffer_dsc_t       build_str = {.p_buffer = build_str_buffer, .buffer_size = sizeof(build_str_buffer)};
+    actionslink_firmware_version_t version   = {.p_build_string = &build_str};
+    actionslink_start_bringup(&c_bringup_config, &version);
+
+    // The step timeouts of the bring up bound the wait
+    Startup::start(Startup::Step::BtChipReady);
+    actionslink_bringup_state_t state;
+    while ((state = actionslink_process_bringup()) == ACTIONSLINK_BRINGUP_STATE_WAITING)
+    {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    const bool is_ready = state == ACTIONSLINK_BRINGUP_STATE_READY;
+    Startup::complete(Startup::Step::BtChipReady, not is_ready);
+    TRACE(TRACE_BT_CHIP_READY, is_ready);
+
+    actionslink_bringup_stats_t stats;
+    actionslink_get_bringup_stats(&stats);
+    log_info("BT chip up in %u ms: first frame %u ms, ready %u ms, responding %u ms (%u probes)", stats.total_ms,
+             stats.step_ms[ACTIONSLINK_BRINGUP_STEP_FIRST_FRAME], stats.step_ms[ACTIONSLINK_BRINGUP_STEP_SYSTEM_READY],
+             stats.step_ms[ACTIONSLINK_BRINGUP_STEP_RESPONDING], stats.probes);
+    if (not is_ready)
+    {
+        log_error("BT chip not ready, powering it off");
+        actionslink_deinit();
+        board_link_bluetooth_reset(true);
+        board_link_bluetooth_set_power(false);
+        return false;
+    }
+
+    s_bluetooth.is_chip_booted = true;
+    log_warn("Actions FW version: %d.%d.%d%s", version.major, version.minor, version.patch, build_str_buffer);
+    return true;
+}
+
+// Only boot_chip() initializes the driver, a chip that didn't get ready is off even with the power state on
+static bool is_chip_active()
+{
+    return s_bluetooth.is_chip_booted;
+}
+
+// Handles the frames received so far, one actionslink_tick() takes at most one frame
+static void handle_chip_frames()
+{
+    uint8_t frames = 0;
+    do
+    {
+        actionslink_tick();
+    } while (bsp_bluetooth_uart_rx_available() > 0u && ++frames < c_max_frames_per_wakeup);
+}
+
+// Pairing sound icons repeat until the pairing ends, see update_infinite_sound_icons()
+static bool is_infinite_sound_icon_pending()
+{
+    return isProperty(Tub::Status::BluetoothPairing) || isProperty(Tub::Status::SlavePairing) ||
+           actionslink_is_sound_icon_scheduled(ACTIONSLINK_SOUND_ICON_BT_PAIRING) ||
+           actionslink_is_sound_icon_scheduled(ACTIONSLINK_SOUND_ICON_MULTISPEAKER_CHAIN_SLAVE_PAIRING);
+}
+
+// Frames from the chip wake the task up through ChipFrameReceived, it's only woken up periodically while something
+// is due: notifications held back, a frame partly received, frames left over by handle_chip_frames(), a debounced
+// state update or a sound icon to follow up on, see idle_period_ms().
+static void update_idle_period()
+{
+    const bool chip_active = is_chip_active();
+    const bool power_on_sound_icon_pending =
+        s_bluetooth.power_on_sound_icon_ts != 0u && s_bluetooth.power_on_sound_icon_ts != UINT32_MAX;
+
+    // The frame handler only posts on a new frame end, frames left over after c_max_frames_per_wakeup wait for a tick
+    const IdleState state = {
+        .is_chip_active     = chip_active,
+        .needs_ticks        = chip_active && (actionslink_needs_tick() || bsp_bluetooth_uart_rx_available() > 0u ||
+                                              is_infinite_sound_icon_pending()),
+        .has_pending_work   = s_bluetooth.update_bt_state || power_on_sound_icon_pending ||
+                              s_bluetooth.is_bt_connected_sound_icon_deferred,
+        .sound_icons_due_ms = chip_active ? actionslink_get_sound_icons_due_ms() : UINT32_MAX,
+    };
+    GenericThread::SetIdleMs(task_handler, idle_period_ms(state));
+}
+
 static const GenericThread::Config<BluetoothMessage> threadConfig = {
     .Name      = "Bluetooth",
     .StackSize = TASK_BLUETOOTH_STACK_SIZE,
     .Priority  = TASK_BLUETOOTH_PRIORITY,
-    .IdleMs    = 10,
+    .IdleMs    = c_idle_period_ms,
     .Callback_Idle =
         []()
     {
@@ -657,8 +809,7 @@ static const GenericThread::Config<BluetoothMessage> threadConfig = {
         // and we need to check the BT status (e.g. to check pairing state, and run the next sound icon).
         if (s_bluetooth.power_on_sound_icon_ts != 0u && s_bluetooth.power_on_sound_icon_ts != UINT32_MAX)
         {
-            if (board_get_ms_since(s_bluetooth.power_on_sound_icon_ts) >
-                Teufel::Core::mapValue(SoundIconToLengthMapper, ACTIONSLINK_SOUND_ICON_POWER_ON))
+            if (board_get_ms_since(s_bluetooth.power_on_sound_icon_ts) > c_power_on_sound_icon_ms)
             {
                 s_bluetooth.power_on_sound_icon_ts = UINT32_MAX;
                 s_bluetooth.update_bt_state        = true;
@@ -666,6 +817,13 @@ static const GenericThread::Config<BluetoothMessage> threadConfig = {
             }
         }
 
+        // Nothing to wait for anymore if the power on sound icon didn't come in time
+        if (s_bluetooth.is_bt_connected_sound_icon_deferred && not is_power_on_sound_icon_due())
+        {
+            s_bluetooth.power_on_ts = std::nullopt;
+            request_deferred_bt_connected_sound_icon();
+        }
+
         // Must be called before handle_new_bt_state changes bt status
         update_infinite_sound_icons();
 
@@ -679,21 +837,27 @@ static const GenericThread::Config<BluetoothMessage> threadConfig = {
             }
         }
 
-        if (isProperty(Tus::PowerState::On))
+        if (is_chip_active())
         {
-            actionslink_tick();
+            handle_chip_frames();
         }
+
+        update_idle_period();
     },
     .Callback_Init =
         []()
     {
         bsp_bluetooth_uart_init();
+        bsp_bluetooth_uart_attach_frame_handler(
+            +[]() { s_frame_post_guard.post([]() { return postMessage(ot_id, ChipFrameReceived{}); }); });
         board_link_bluetooth_init();
         board_link_bluetooth_set_power(false);
         board_link_bluetooth_reset(true);
 
         board_link_usb_switch_init();
         board_link_usb_switch_to_bluetooth();
+
+        Startup::complete(Startup::Step::BtInit);
         SyncPrimitive::notify(ot_id);
     },
     .QueueSize = QUEUE_SIZE,
@@ -710,14 +874,32 @@ static const GenericThread::Config<BluetoothMessage> threadConfig = {
                         case Tus::PowerState::PreOff:
                         {
                             // Wait until the sound icon is played completely
-                            // UX spec says that the power off sound icon is 1.832 seconds long
                             // We need to mute the amps immediately after playing the power off sound icon to prevent
                             // music from playing after the sound icon is played (can't send a command to pause in AUX
                             // source) There is some delay between here and the audio task receiving the power off
                             // command, so we need consider that the sound icon is played completely a bit before it's
                             // actually done
                             // TODO: Investigate this delay, it seems suspiciously and unnecessarily long (50-70 ms)
-                            vTaskDelay(pdMS_TO_TICKS(1780));
+                            // Only the rest of the sound icon is waited for, and nothing if it isn't played at all
+                            // (off timer, sound icons disabled). Requested while the power on sound icon plays, it
+                            // waits for that one, the queue only moves on with the ticks.
+                            const auto ts        = get_systick();
+                            uint32_t   played_ms = 0u;
+                            while (board_get_ms_since(ts) < c_power_on_sound_icon_ms + c_power_off_sound_icon_wait_ms)
+                            {
+                                if (actionslink_get_current_sound_icon(&played_ms) == ACTIONSLINK_SOUND_ICON_POWER_OFF)
+                                {
+                                    if (played_ms < c_power_off_sound_icon_wait_ms)
+                                        vTaskDelay(pdMS_TO_TICKS(c_power_off_sound_icon_wait_ms - played_ms));
+                                    break;
+                                }
+                                if (not actionslink_is_sound_icon_scheduled(ACTIONSLINK_SOUND_ICON_POWER_OFF))
+                                    break;
+
+                                vTaskDelay(pdMS_TO_TICKS(std::clamp<uint32_t>(actionslink_get_sound_icons_due_ms(), 1u,
+                                                                              c_idle_period_ms)));
+                                actionslink_tick();
+                            }
                             break;
                         }
 
@@ -726,6 +908,7 @@ static const GenericThread::Config<BluetoothMessage> threadConfig = {
                             s_bluetooth.has_received_power_off_confirmation = false;
                             s_bluetooth.power_on_sound_icon_ts =
                                 0u; // IMPORTANT! needs to be reset when charger is connected
+                            TRACE(TRACE_BT_POWER_OFF_REQUEST, 0);
                             if (actionslink_set_power_state(ACTIONSLINK_POWER_STATE_OFF) != 0)
                             {
                                 log_error("BT power off request failed");
@@ -745,32 +928,30 @@ static const GenericThread::Config<BluetoothMessage> threadConfig = {
                             actionslink_deinit();
                             board_link_bluetooth_reset(true);
                             board_link_bluetooth_set_power(false);
+                            s_bluetooth.is_chip_booted = false;
 
-                            s_bluetooth.power_on_sound_icon_ts = 0u;
+                            s_bluetooth.power_on_sound_icon_ts              = 0u;
+                            s_bluetooth.power_on_ts                         = std::nullopt;
+                            s_bluetooth.is_bt_connected_sound_icon_deferred = false;
 
                             break;
                         }
 
                         case Tus::PowerState::On:
                         {
-                            board_link_bluetooth_reset(false);
-                            board_link_bluetooth_set_power(true);
-
-                            bsp_bluetooth_uart_clear_buffer();
-                            actionslink_init(&actionslink_configuration, &actionslink_event_handlers,
-                                             &actionslink_request_handlers);
-
-                            while (not actionslink_is_ready())
+                            if (not s_bluetooth.is_chip_booted)
                             {
-                                vTaskDelay(pdMS_TO_TICKS(10));
-                                actionslink_tick();
+                                if (not boot_chip())
+                                {
+                                    // Not waited for, the power on goes on without Bluetooth audio
+                                    Startup::complete(Startup::Step::BtPowerOn, true);
+                                    break;
+                                }
                             }
-
-                            actionslink_firmware_version_t version = {0};
-                            if (get_bt_fw_version(&version) == 0)
+                            else
                             {
-                                log_warn("Actions FW version: %d.%d.%d%s", version.major, version.minor, version.patch,
-                                         version.p_build_string->p_buffer);
+                                // The battery level reported when the chip got ready predates the battery management
+                                actionslink_send_battery_level(getProperty<Tus::BatteryLevel>().value);
                             }
 
                             uint8_t pd_version = 0x00;
@@ -779,18 +960,22 @@ static const GenericThread::Config<BluetoothMessage> threadConfig = {
                                 log_warn("PD controller FW version: %d.%d", pd_version >> 4, pd_version & 0x0F);
                             }
 
-                            vTaskDelay(pdMS_TO_TICKS(200));
-
+                            // No wait needed here, the chip answered a request at the end of its bring up
+                            TRACE(TRACE_BT_POWER_ON_REQUEST, 0);
                             if (actionslink_set_power_state(ACTIONSLINK_POWER_STATE_ON) != 0)
                             {
                                 log_error("Failed to request power on");
                             }
 
-                            while (not s_bluetooth.audio_source.has_value())
-                            {
-                                vTaskDelay(pdMS_TO_TICKS(10));
-                                actionslink_tick();
-                            }
+                            Startup::wait_for(
+                                Startup::Step::BtPowerOn,
+                                +[]()
+                                {
+                                    actionslink_tick();
+                                    return s_bluetooth.audio_source.has_value();
+                                },
+                                10);
+                            s_bluetooth.power_on_ts = get_systick();
                             break;
                         }
                         default:
@@ -823,6 +1008,23 @@ static const GenericThread::Config<BluetoothMessage> threadConfig = {
                         // log_error("Failed to send color");
                     }
                 },
+                [](const BootChip &)
+                {
+                    if (not s_bluetooth.is_chip_booted)
+                    {
+                        log_info("Booting BT chip ahead of power on");
+                        boot_chip();
+                    }
+                },
+                [](const ChipFrameReceived &)
+                {
+                    // Cleared first, frames received from here on post another message
+                    s_frame_post_guard.clear();
+                    if (is_chip_active())
+                    {
+                        handle_chip_frames();
+                    }
+                },
                 [](const ActionsReady &)
                 {
                     log_info("Actions is ready");
@@ -1038,32 +1240,40 @@ static const GenericThread::Config<BluetoothMessage> threadConfig = {
                 },
                 [](const Tua::RequestSoundIcon &p)
                 {
+                    const bool is_deferred_released = p.sound_icon == ACTIONSLINK_SOUND_ICON_POWER_ON &&
+                                                      s_bluetooth.is_bt_connected_sound_icon_deferred;
+                    if (p.sound_icon == ACTIONSLINK_SOUND_ICON_POWER_ON)
+                    {
+                        s_bluetooth.power_on_ts                         = std::nullopt;
+                        s_bluetooth.is_bt_connected_sound_icon_deferred = false;
+                    }
+
                     if (getProperty<Ux::Audio::SoundIconsActive>().value)
                     {
-                        // If the sound icon is BT connected, we need to play it immediately after the BT connection,
-                        // except if the BT connection is established during(or before) the power on sound icon.
-                        // In this case we need to wait for the power on sound icon to finish before playing the BT.
-                        if (p.sound_icon == ACTIONSLINK_SOUND_ICON_BT_CONNECTED &&
-                            (s_bluetooth.power_on_sound_icon_ts == 0 ||
-                             board_get_ms_since(s_bluetooth.power_on_sound_icon_ts) < 500))
+                        // The BT connected sound icon waits for the power on sound icon, which it can't do before
+                        // that one is requested. A connection during the power on sound icon is queued behind it.
+                        if (p.sound_icon == ACTIONSLINK_SOUND_ICON_BT_CONNECTED && is_power_on_sound_icon_due())
                         {
-                            vTaskDelay(50);
-                            postMessage(ot_id, Tua::RequestSoundIcon{
-                                                   ACTIONSLINK_SOUND_ICON_BT_CONNECTED,
-                                                   ACTIONSLINK_SOUND_ICON_PLAYBACK_MODE_PLAY_IMMEDIATELY, false});
+                            s_bluetooth.is_bt_connected_sound_icon_deferred = true;
+                            return;
                         }
 
-                        if (p.sound_icon == ACTIONSLINK_SOUND_ICON_POWER_ON)
-                        {
-                            s_bluetooth.power_on_sound_icon_ts = get_systick();
-                        }
 #if not defined(BOOTLOADER)
                         log_high("Sound icon (request) (si: %d)", p.sound_icon);
 #endif
-                        actionslink_play_sound_icon(p.sound_icon, p.playback_mode, p.loop_forever);
+                        if (actionslink_request_sound_icon(p.sound_icon, p.playback_mode, p.loop_forever) != 0)
+                        {
+                            log_error("Sound icon (si: %d) request failed", p.sound_icon);
+                        }
 
-                        s_bluetooth.curr_sound_icon          = p.sound_icon;
-                        s_bluetooth.curr_sound_icon_begin_ts = get_systick();
+                        if (p.sound_icon == ACTIONSLINK_SOUND_ICON_POWER_ON)
+                        {
+                            s_bluetooth.power_on_sound_icon_ts = get_systick();
+                            if (is_deferred_released)
+                            {
+                                request_deferred_bt_connected_sound_icon();
+                            }
+                        }
                     }
                     else
                     {
@@ -1077,12 +1287,11 @@ static const GenericThread::Config<BluetoothMessage> threadConfig = {
 #if not defined(BOOTLOADER)
                         log_high("Stop sound icon request (%u)", static_cast<uint8_t>(p.sound_icon));
 #endif
-                        int ret = actionslink_stop_sound_icon(p.sound_icon);
+                        int ret = actionslink_cancel_sound_icon(p.sound_icon);
                         if (ret < 0)
                         {
                             log_err("stop sound icon status: %d", ret);
                         }
-                        s_bluetooth.curr_sound_icon = ACTIONSLINK_SOUND_ICON_NONE;
                     }
                     else
                     {
@@ -1192,6 +1401,8 @@ static const GenericThread::Config<BluetoothMessage> threadConfig = {
 #endif // INCLUDE_PRODUCTION_TESTS
             },
             msg);
+
+        update_idle_period();
     },
     .StackBuffer = bluetooth_task_stack,
     .StaticTask  = &bluetooth_task_buffer,
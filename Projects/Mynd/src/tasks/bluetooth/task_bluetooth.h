@@ -12,6 +12,10 @@ namespace Teufel::Task::Bluetooth
 
 // clang-format off
 struct ActionsReady{};
+// Boots the Actions chip ahead of the first PowerState::On, see startup.h
+struct BootChip{};
+// Posted from the UART interrupt when a frame from the Actions chip is complete
+struct ChipFrameReceived{};
 
 using BluetoothMessage = std::variant<
     Teufel::Ux::System::SetPowerState,
@@ -20,6 +24,8 @@ using BluetoothMessage = std::variant<
     Teufel::Ux::System::ChargeType,
     Teufel::Ux::System::Color,
     ActionsReady,
+    BootChip,
+    ChipFrameReceived,
     Teufel::Ux::Bluetooth::BtWakeUp,
     Teufel::Ux::Bluetooth::StartPairing,
 #ifdef INCLUDE_TWS_MODE
@@ -0,0 +1,95 @@
+// Due to the flash size limit, only the WARNING level is available
+// for use in the complete firmware (including the bootloader).
+#if defined(BOOTLOADER)
+#define LOG_LEVEL LOG_LEVEL_WARNING
+#else
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "board.h"
+#include "logger.h"
+#include "startup.h"
+#include "startup_steps.h"
+#include "trace_events.h"
+
+namespace Teufel::Task::Startup
+{
+
+static Graph graph{steps};
+
+void start(Step step)
+{
+    const uint32_t now_ms = get_systick();
+
+    taskENTER_CRITICAL();
+    graph.start(step, now_ms);
+    taskEXIT_CRITICAL();
+}
+
+void complete(Step step, bool timed_out)
+{
+    taskENTER_CRITICAL();
+    uint32_t missing   = graph.missing(step);
+    bool     completed = graph.complete(step, get_systick(), timed_out);
+    taskEXIT_CRITICAL();
+
+    if (completed)
+    {
+        TRACE(TRACE_STARTUP_STEP, static_cast<uint16_t>(step));
+    }
+
+    if (completed && missing != 0)
+    {
+        log_warn("Startup step %s completed before its prerequisites (0x%02X)", graph.step(step).name, missing);
+    }
+}
+
+int wait_for(Step step, bool (*is_signaled)(), uint32_t period_ms)
+{
+    const uint32_t timeout_ms = graph.step(step).timeout_ms;
+    const uint32_t start_ms   = get_systick();
+
+    start(step);
+
+    while (not is_signaled())
+    {
+        if (board_get_ms_since(start_ms) >= timeout_ms)
+        {
+            log_error("Startup step %s timed out after %u ms", graph.step(step).name, timeout_ms);
+            complete(step, true);
+            return -1;
+        }
+        vTaskDelay(pdMS_TO_TICKS(period_ms));
+    }
+
+    complete(step);
+    return 0;
+}
+
+bool is_done(Step step)
+{
+    return graph.is_done(step);
+}
+
+uint32_t get_ms_since(Step step)
+{
+    return board_get_ms_since(graph.done_ms(step));
+}
+
+void report()
+{
+    Step        path[static_cast<std::size_t>(Step::Count)];
+    std::size_t length = graph.critical_path(Step::PowerOnSoundIcon, path, static_cast<std::size_t>(Step::Count));
+
+    log_info("Startup critical path, %u ms to the power on sound icon:", graph.done_ms(Step::PowerOnSoundIcon));
+    for (std::size_t i = 0; i < length; i++)
+    {
+        log_info("  %-20s %5u ms%s", graph.step(path[i]).name, graph.done_ms(path[i]),
+                 graph.has_timed_out(path[i]) ? " (timed out)" : "");
+    }
+}
+
+}
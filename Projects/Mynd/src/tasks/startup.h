@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Teufel::Task::Startup
+{
+
+// Steps from reset to the power on sound icon. The tasks start concurrently, each step runs in the task it belongs
+// to, waits for its completion signal with a timeout instead of a fixed delay and is checked against its
+// prerequisites, see the step table in startup_steps.h.
+enum class Step : uint8_t
+{
+    PowerDecision,    // System: power button read, power on after an update
+    AudioInit,        // Audio: I2C, IO expander, amps and boost converter GPIOs
+    PdReady,          // Audio: PD controller has loaded its firmware and runs in application mode
+    Battery,          // Audio: battery management and persistent parameters
+    BtInit,           // Bluetooth: UART, GPIOs, USB switch
+    BtChipReady,      // Bluetooth: Actions chip powered and ready, booted early if power on was decided
+    AmpsEnabled,      // Audio: PVDD and PDN, 5 ms before the I2S clocks start
+    BtPowerOn,        // Bluetooth: Actions chip powered on, I2S clocks running, audio source known
+    AmpsConfigured,   // Audio: amps configured on running I2S clocks
+    PowerOnSoundIcon, // System: power on sound icon requested
+    Count,
+};
+
+/**
+ * @brief Marks the start of a step whose completion signal is waited for by the caller, see complete().
+ */
+void start(Step step);
+
+/**
+ * @brief Marks a step as completed and warns if its prerequisites aren't.
+ *
+ * Steps complete once, later calls, e.g. on the next power on, are ignored.
+ */
+void complete(Step step, bool timed_out = false);
+
+/**
+ * @brief Polls for the completion signal of a step until it's there or the step times out.
+ *
+ * @param[in] step              step to wait for
+ * @param[in] is_signaled       polled for the completion signal
+ * @param[in] period_ms         time between polls
+ *
+ * @return 0 if the step was signaled, -1 if it timed out
+ */
+int wait_for(Step step, bool (*is_signaled)(), uint32_t period_ms);
+
+bool is_done(Step step);
+
+uint32_t get_ms_since(Step step);
+
+// Logs when each step completed and the critical path to the power on sound icon
+void report();
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "startup.h"
+#include "external/teufel/libs/core_utils/startup_graph.h"
+
+namespace Teufel::Task::Startup
+{
+
+using Graph = StartupGraph<Step, static_cast<std::size_t>(Step::Count)>;
+
+// clang-format off
+// In the order of Step, shared with the host test of the startup graph
+inline constexpr StartupStep steps[] = {
+    {"power decision",      0,                                                 0},
+    {"audio init",          Graph::mask(Step::PowerDecision),                  0},
+    // The PD firmware loads from the EEPROM in about 1 s, the rest of the startup doesn't wait for it
+    {"PD ready",            Graph::mask(Step::AudioInit),                      5000},
+    {"battery",             Graph::mask(Step::PdReady),                        0},
+    {"BT init",             Graph::mask(Step::PowerDecision),                  0},
+    {"BT chip ready",       Graph::mask(Step::BtInit),                         3000},
+    {"amps enabled",        Graph::mask(Step::Battery),                        0},
+    // The BT chip starts the I2S clocks on power on, which the amps need to be enabled for
+    {"BT power on",         Graph::mask(Step::BtChipReady, Step::AmpsEnabled), 3000},
+    {"amps configured",     Graph::mask(Step::BtPowerOn),                      0},
+    {"power on sound icon", Graph::mask(Step::AmpsConfigured),                 0},
+};
+// clang-format on
+
+static_assert(sizeof(steps) / sizeof(steps[0]) == static_cast<std::size_t>(Step::Count));
+
+}
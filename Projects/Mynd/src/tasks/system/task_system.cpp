@@ -24,6 +24,8 @@
 #include "task_bluetooth.h"
 #include "task_system.h"
 #include "task_priorities.h"
+#include "startup.h"
+#include "trace_events.h"
 #include "external/teufel/libs/property/property.h"
 #include "external/teufel/libs/core_utils/overload.h"
 #include "external/teufel/libs/core_utils/sync.h"
@@ -87,7 +89,10 @@ static bool power_on_after_update()
     uint32_t bkup_0 = RTC->BKP0R;
     bool     result = false;
     if (bkup_0 == 0xBEEFBEEF)
+    {
         result = true;
+        TRACE(TRACE_UPDATE_COMPLETE, 0);
+    }
     RTC->BKP0R = 0;
     HAL_PWR_DisableBkUpAccess();
     return result;
@@ -110,6 +115,7 @@ static power_state_fn_t power_state_on(const Tus::PowerState &p, const Ux::Syste
         case Tus::PowerState::Off:
         {
             log_highlight("Powering off (%s)", getDesc(reason));
+            TRACE(TRACE_POWER_OFF_BEGIN, static_cast<uint16_t>(reason));
 
             // MCU needs to explicitly exit active csb mode if charger is connected when unit is powered off
             // otherwise, the unit powers back on into CSB mode
@@ -127,6 +133,7 @@ static power_state_fn_t power_state_on(const Tus::PowerState &p, const Ux::Syste
             // Tell the audio task to prepare for power off (start LED animations, etc.)
             Teufel::Task::Audio::postMessage(ot_id, set_power_msg);
             SyncPrimitive::await(Tus::Task::Audio, 6000, "power off prep done");
+            TRACE(TRACE_POWER_OFF_PREPARED, 0);
 
             vTaskDelay(pdMS_TO_TICKS(1000)); // Wait once the battery low sound icon is played
             if (reason != Tus::PowerStateChangeReason::OffTimer)
@@ -140,12 +147,14 @@ static power_state_fn_t power_state_on(const Tus::PowerState &p, const Ux::Syste
             // It should synchronize once the whole sound icon has played
             Teufel::Task::Bluetooth::postMessage(ot_id, set_power_msg);
             SyncPrimitive::await(Tus::Task::Bluetooth, 4000, "played off sound icon");
+            TRACE(TRACE_POWER_OFF_SOUND_ICON_PLAYED, 0);
 
             set_power_msg = p_power_state.setTransition(Tus::PowerState::Off, reason, getDesc(Tus::PowerState::Off));
 
             // Once the power off sound icon has played, we can turn off the amps
             Teufel::Task::Audio::postMessage(ot_id, set_power_msg);
             SyncPrimitive::await(Tus::Task::Audio, 3000, "completed power off");
+            TRACE(TRACE_POWER_OFF_AMPS_OFF, 0);
 
             // Once the amps are off, we can turn off the BT module
             Teufel::Task::Bluetooth::postMessage(ot_id, set_power_msg);
@@ -154,8 +163,11 @@ static power_state_fn_t power_state_on(const Tus::PowerState &p, const Ux::Syste
             if (not isProperty(Tus::ChargerStatus::Active))
                 board_link_charger_enable_low_power_mode(true);
 
+            // Settings saved during the power off sequence are still in the write cache
+            Storage::flush();
             board_link_power_supply_hold_on(false);
             p_power_state.set(Tus::PowerState::Off, getDesc(Tus::PowerState::Off));
+            TRACE(TRACE_POWER_OFF_DONE, 0);
 
             return reinterpret_cast<power_state_fn_t>(power_state_off);
         }
@@ -173,6 +185,7 @@ static power_state_fn_t power_state_off(const Tus::PowerState &p, const Ux::Syst
         case Tus::PowerState::On:
         {
             log_highlight("Powering on");
+            TRACE(TRACE_POWER_ON_BEGIN, static_cast<uint16_t>(reason));
 
             auto set_power_msg =
                 p_power_state.setTransition(Tus::PowerState::PreOn, reason, getDesc(Tus::PowerState::PreOn));
@@ -180,6 +193,7 @@ static power_state_fn_t power_state_off(const Tus::PowerState &p, const Ux::Syst
 
             Teufel::Task::Audio::postMessage(ot_id, set_power_msg);
             SyncPrimitive::await(Tus::Task::Audio, 200, "enabled amps");
+            TRACE(TRACE_POWER_ON_AMPS_ENABLED, 0);
 
             // Bluetooth task does not need a PreOn state as of now, so we skip it
 
@@ -187,23 +201,28 @@ static power_state_fn_t power_state_off(const Tus::PowerState &p, const Ux::Syst
 
             Teufel::Task::Bluetooth::postMessage(ot_id, set_power_msg);
             SyncPrimitive::await(Tus::Task::Bluetooth, 4000, "enabled BT");
+            TRACE(TRACE_POWER_ON_BT_ON, 0);
 
-            // Delay enough for the BT module to power on and start I2S
-            // The amps need the I2S BCLK to be stable before they can be configured
-            // TODO: make it synchronous with BT ActionsReady
-            // TODO: keep it until we clarify power on sequence with BT team
-            // vTaskDelay(pdMS_TO_TICKS(1000));
-
+            // The amps need the I2S BCLK to be stable before they can be configured, the BT task synchronizes once
+            // the BT module is powered on and has reported its audio source
             log_dbg("Assuming I2S active, configuring amps");
             Teufel::Task::Audio::postMessage(ot_id, set_power_msg);
 
             SyncPrimitive::await(Tus::Task::Audio, 3000, "completed power on");
+            TRACE(TRACE_POWER_ON_AMPS_CONFIGURED, 0);
 
             Teufel::Task::Bluetooth::postMessage(
                 ot_id, Tua::RequestSoundIcon{ACTIONSLINK_SOUND_ICON_POWER_ON,
                                              ACTIONSLINK_SOUND_ICON_PLAYBACK_MODE_PLAY_IMMEDIATELY, false});
 
+            if (not Startup::is_done(Startup::Step::PowerOnSoundIcon))
+            {
+                Startup::complete(Startup::Step::PowerOnSoundIcon);
+                Startup::report();
+            }
+
             p_power_state.set(Tus::PowerState::On, getDesc(Tus::PowerState::On));
+            TRACE(TRACE_POWER_ON_DONE, 0);
 
             return reinterpret_cast<power_state_fn_t>(power_state_on);
         }
@@ -255,21 +274,33 @@ void check_idle_timeout()
     }
 }
 
+// The console is polled fast while someone types, the off timer and the EEPROM cache are fine with the slow period
+static constexpr uint32_t c_idle_period_console_ms = 25;
+static constexpr uint32_t c_idle_period_quiet_ms   = 500;
+static uint32_t           s_console_input_ts       = 0;
+
 static const GenericThread::Config<SystemMessage> threadConfig = {
     .Name      = "System",
     .StackSize = TASK_SYSTEM_STACK_SIZE,
     .Priority  = TASK_SYSTEM_PRIORITY,
-    .IdleMs    = 25,
+    .IdleMs    = c_idle_period_console_ms,
     .Callback_Idle =
         []()
     {
         uint8_t uart_rx_data = 0;
-        if (bsp_debug_uart_rx(&uart_rx_data, 1) == 0)
+        while (bsp_debug_uart_rx(&uart_rx_data, 1) == 0)
         {
             tshell_process_char(uart_rx_data);
+            s_console_input_ts = get_systick();
         }
 
         check_idle_timeout();
+
+        Storage::maintain();
+
+        // The console echoes typed characters, keep polling fast for a while after the last input
+        const bool console_active = s_console_input_ts != 0 && board_get_ms_since(s_console_input_ts) < 10000;
+        GenericThread::SetIdleMs(task_handler, console_active ? c_idle_period_console_ms : c_idle_period_quiet_ms);
     },
     .Callback_Init =
         []()
@@ -295,16 +326,27 @@ static const GenericThread::Config<SystemMessage> threadConfig = {
 
         board_link_moisture_detection_init();
 
-        Teufel::Task::Audio::start();
-        SyncPrimitive::await(Tus::Task::Audio, 2000, "started");
+        // If the bootloader wrote the magic # to the RTC->BKP0R reg, then an update was performed and device must power
+        // on or If the power supply is already held on that means that the speaker should be powered on because the
+        // system task detected a power button press early during the boot up process
+        const bool power_on = power_on_after_update() || board_link_power_supply_is_held_on();
+        Startup::complete(Startup::Step::PowerDecision);
 
+        // The tasks initialize concurrently, see startup.h for the dependencies between their steps
+        Teufel::Task::Audio::start();
         Teufel::Task::Bluetooth::start();
+
+        // The BT chip boots while the PD controller loads its firmware
+        if (power_on)
+        {
+            Teufel::Task::Bluetooth::postMessage(ot_id, Teufel::Task::Bluetooth::BootChip{});
+        }
+
+        // The audio task waits up to 5 s for the PD controller
+        SyncPrimitive::await(Tus::Task::Audio, 6000, "started");
         SyncPrimitive::await(Tus::Task::Bluetooth, 2000, "started");
 
-        // If the bootloader wrote the magic # to the RTC->BKP0R reg, then an update was performed and device must power
-        // on or If the power supply is already held on that means that the speaker should be powered on because the
-        // system task detected a power button press early during the boot up process
-        if (power_on_after_update() || board_link_power_supply_is_held_on())
+        if (power_on)
         {
             Task::System::postMessage(ot_id, Tus::SetPowerState{Tus::PowerState::On, Tus::PowerState::Off});
         }
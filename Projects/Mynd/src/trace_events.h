@@ -0,0 +1,46 @@
+#pragma once
+
+// Trace events of the boot and power sequences, dump them with "trace dump" and decode the console log on the host
+// with trace_decode (see external/teufel/libs/trace/README.md).
+
+// The update firmware has no room to spare
+#if defined(BOOTLOADER)
+#define TRACE_ENABLED 0
+#endif
+
+#include "trace.h"
+
+// clang-format off
+#define TRACE_EVENTS(X)                 \
+    X(STARTUP_STEP)                     \
+    X(UPDATE_COMPLETE)                  \
+    X(POWER_ON_BEGIN)                   \
+    X(POWER_ON_AMPS_ENABLED)            \
+    X(POWER_ON_BT_ON)                   \
+    X(POWER_ON_AMPS_CONFIGURED)         \
+    X(POWER_ON_DONE)                    \
+    X(POWER_OFF_BEGIN)                  \
+    X(POWER_OFF_PREPARED)               \
+    X(POWER_OFF_SOUND_ICON_PLAYED)      \
+    X(POWER_OFF_AMPS_OFF)               \
+    X(POWER_OFF_DONE)                   \
+    X(BT_CHIP_BOOT)                     \
+    X(BT_CHIP_READY)                    \
+    X(BT_POWER_ON_REQUEST)              \
+    X(BT_AUDIO_SOURCE)                  \
+    X(BT_POWER_OFF_REQUEST)             \
+    X(BT_POWER_OFF_CONFIRMED)           \
+    X(AMPS_ENABLE)                      \
+    X(AMPS_WOOFER_SETUP)                \
+    X(AMPS_WOOFER_READY)                \
+    X(AMPS_TWEETER_SETUP)               \
+    X(AMPS_TWEETER_READY)               \
+    X(AMPS_MUTE)
+// clang-format on
+
+#define TRACE_EVENT_ENUM(name) TRACE_##name,
+enum
+{
+    TRACE_EVENTS(TRACE_EVENT_ENUM)
+};
+#undef TRACE_EVENT_ENUM
@@ -2,7 +2,9 @@
 #include "bsp/board_hw.h"
 #include "logger.h"
 #include "dfu_mcu.h"
+#include "t_boot_delta.h"
 #include <stdbool.h>
+#include <string.h>
 
 static struct
 {
@@ -73,10 +75,148 @@ int dfu_mcu_write(const uint8_t *buf, uint32_t len, uint32_t offset)
         }
         if (*(uint32_t *) (addr) != *data)
         {
+            // Checkpoints rely on every written word being verified
             log_err("Error verifying flash(addr: 0x%08x)", addr);
+
+            HAL_FLASH_Lock();
+            return -1;
         }
     }
     HAL_FLASH_Lock();
 
     return 0;
 }
+
+int dfu_mcu_read(uint8_t *buf, uint32_t len, uint32_t offset)
+{
+    if (offset + len > APPLICATION_FLASH_SIZE)
+    {
+        return -1;
+    }
+
+    // The flash is memory mapped
+    memcpy(buf, (const uint8_t *) (APPLICATION_FLASH_ADDRESS + offset), len);
+    return 0;
+}
+
+uint32_t dfu_mcu_resume(uint32_t offset)
+{
+    // Pages are erased as a whole, the page the checkpoint points into is written again
+    uint32_t keep = offset - (offset % FLASH_PAGE_SIZE);
+
+    if (keep < APPLICATION_FLASH_SIZE)
+    {
+        FLASH_EraseInitTypeDef EraseInitStruct;
+        uint32_t               PageError;
+        EraseInitStruct.TypeErase   = FLASH_TYPEERASE_PAGES;
+        EraseInitStruct.PageAddress = APPLICATION_FLASH_ADDRESS + keep;
+        EraseInitStruct.NbPages     = (APPLICATION_FLASH_SIZE - keep) / FLASH_PAGE_SIZE;
+
+        log_info("Resuming update, erasing from 0x%08x pages %d", EraseInitStruct.PageAddress,
+                 EraseInitStruct.NbPages);
+
+        HAL_FLASH_Unlock();
+        HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&EraseInitStruct, &PageError);
+        HAL_FLASH_Lock();
+
+        if (status != HAL_OK)
+        {
+            // The first write erases the entire application area again
+            log_err("Error erasing flash");
+            s_dfu_mcu.flash_was_erased = false;
+            return 0;
+        }
+    }
+
+    s_dfu_mcu.flash_was_erased = true;
+    return keep;
+}
+
+static int delta_erase_page(uint32_t offset)
+{
+    FLASH_EraseInitTypeDef EraseInitStruct;
+    uint32_t               PageError;
+    EraseInitStruct.TypeErase   = FLASH_TYPEERASE_PAGES;
+    EraseInitStruct.PageAddress = APPLICATION_FLASH_ADDRESS + offset;
+    EraseInitStruct.NbPages     = 1;
+
+    HAL_FLASH_Unlock();
+    HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&EraseInitStruct, &PageError);
+    HAL_FLASH_Lock();
+
+    return (status == HAL_OK) ? 0 : -1;
+}
+
+static int delta_program(const uint8_t *buf, uint32_t len, uint32_t offset)
+{
+    uint32_t addr = APPLICATION_FLASH_ADDRESS + offset;
+
+    HAL_FLASH_Unlock();
+    for (uint32_t i = 0; i < len; i += 2, addr += 2)
+    {
+        uint16_t half_word = (uint16_t) (buf[i] | (buf[i + 1] << 8));
+        if ((HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, addr, half_word) != HAL_OK) ||
+            (*(uint16_t *) addr != half_word))
+        {
+            log_err("Error writing to flash(addr: 0x%08x)", addr);
+
+            HAL_FLASH_Lock();
+            return -1;
+        }
+    }
+    HAL_FLASH_Lock();
+
+    return 0;
+}
+
+// Old content of the page being rewritten
+static uint8_t delta_page_buffer[FLASH_PAGE_SIZE];
+
+static const t_boot_delta_flash_t delta_flash = {
+    .read          = dfu_mcu_read,
+    .erase_page    = delta_erase_page,
+    .program       = delta_program,
+    .p_page_buffer = delta_page_buffer,
+    .page_size     = FLASH_PAGE_SIZE,
+    .flash_size    = APPLICATION_FLASH_SIZE,
+};
+
+static struct
+{
+    t_boot_delta_t delta;
+    uint32_t       next_offset;
+} s_dfu_mcu_delta;
+
+int dfu_mcu_delta_init(void)
+{
+    t_boot_delta_start(&s_dfu_mcu_delta.delta, &delta_flash);
+    s_dfu_mcu_delta.next_offset = 0;
+    return 0;
+}
+
+int dfu_mcu_delta_prepare(uint32_t fw_size, uint32_t crc32)
+{
+    // Nothing is erased up front, the delta rewrites the pages one by one
+    (void) fw_size;
+    (void) crc32;
+    return 0;
+}
+
+int dfu_mcu_delta_write(const uint8_t *data, uint32_t len, uint32_t offset)
+{
+    // The delta is a stream of operations, it can only be applied in order. The bootloader runs t-boot in
+    // non-sequential mode, so every chunk carries its offset.
+    if (offset != s_dfu_mcu_delta.next_offset)
+    {
+        log_err("Delta chunk at 0x%x out of order, expected 0x%x", offset, s_dfu_mcu_delta.next_offset);
+        return -1;
+    }
+    s_dfu_mcu_delta.next_offset += len;
+
+    return t_boot_delta_write(&s_dfu_mcu_delta.delta, data, len);
+}
+
+int dfu_mcu_delta_verify(void)
+{
+    return t_boot_delta_is_done(&s_dfu_mcu_delta.delta) ? 0 : -1;
+}
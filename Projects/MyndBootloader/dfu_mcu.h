@@ -5,3 +5,10 @@
 int dfu_mcu_init(void);
 int dfu_mcu_prepare(uint32_t fw_size, uint32_t crc32);
 int dfu_mcu_write(const uint8_t *data, uint32_t len, uint32_t offset);
+int dfu_mcu_read(uint8_t *data, uint32_t len, uint32_t offset);
+uint32_t dfu_mcu_resume(uint32_t offset);
+
+int dfu_mcu_delta_init(void);
+int dfu_mcu_delta_prepare(uint32_t fw_size, uint32_t crc32);
+int dfu_mcu_delta_write(const uint8_t *data, uint32_t len, uint32_t offset);
+int dfu_mcu_delta_verify(void);
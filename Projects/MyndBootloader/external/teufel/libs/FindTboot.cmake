@@ -11,9 +11,23 @@ if(NOT (TARGET Tboot))
         "${Tboot_PATH}/src/bootloader/dfu/t_boot_dfu.c"
         "${Tboot_PATH}/src/bootloader/dfu/t_boot_dfu.h"
         "${Tboot_PATH}/src/bootloader/encryption/t_boot_encryption.c"
-        "${Tboot_PATH}/src/bootloader/encryption/t_boot_encryption.h")
+        "${Tboot_PATH}/src/bootloader/encryption/t_boot_encryption.h"
+        "${Tboot_PATH}/src/bootloader/signature/t_boot_sha256.c"
+        "${Tboot_PATH}/src/bootloader/signature/t_boot_sha256.h"
+        "${Tboot_PATH}/src/bootloader/signature/t_boot_signature.c"
+        "${Tboot_PATH}/src/bootloader/signature/t_boot_signature.h"
+        "${Tboot_PATH}/src/bootloader/delta/t_boot_delta.c"
+        "${Tboot_PATH}/src/bootloader/delta/t_boot_delta.h"
+        "${Tboot_PATH}/src/bootloader/compression/t_boot_compression.c"
+        "${Tboot_PATH}/src/bootloader/compression/t_boot_compression.h"
+        "${Tboot_PATH}/src/bootloader/app/t_boot_app.c"
+        "${Tboot_PATH}/src/bootloader/app/t_boot_app.h")
     target_include_directories(Tboot INTERFACE "${Tboot_PATH}/src/bootloader/dfu")
     target_include_directories(Tboot INTERFACE "${Tboot_PATH}/src/bootloader/encryption")
+    target_include_directories(Tboot INTERFACE "${Tboot_PATH}/src/bootloader/signature")
+    target_include_directories(Tboot INTERFACE "${Tboot_PATH}/src/bootloader/delta")
+    target_include_directories(Tboot INTERFACE "${Tboot_PATH}/src/bootloader/compression")
+    target_include_directories(Tboot INTERFACE "${Tboot_PATH}/src/bootloader/app")
     target_include_directories(Tboot INTERFACE "${Tboot_PATH}/src/logger_config")
 endif()
 
@@ -41,6 +55,15 @@ if(NOT (TARGET Tboot::Platform::Stm32::Crc))
         "${Tboot_PATH}/src/device_specific/stm32f0/crc/t_boot_crc.h")
 endif()
 
+if(NOT (TARGET Tboot::Platform::Stm32::Signature))
+    add_library(Tboot::Platform::Stm32::Signature INTERFACE IMPORTED)
+    target_include_directories(Tboot::Platform::Stm32::Signature INTERFACE "${Tboot_PATH}/src/device_specific/stm32f0/signature")
+    target_link_libraries(Tboot::Platform::Stm32::Signature INTERFACE Tboot::Platform::Stm32)
+    target_sources(Tboot::Platform::Stm32::Signature INTERFACE
+        "${Tboot_PATH}/src/device_specific/stm32f0/signature/t_boot_signature_rsa.c"
+        "${Tboot_PATH}/src/device_specific/stm32f0/signature/t_boot_signature_rsa.h")
+endif()
+
 if(NOT (TARGET Tboot::Platform::Stm32::Usb))
     add_library(Tboot::Platform::Stm32::Usb INTERFACE IMPORTED)
     target_include_directories(Tboot::Platform::Stm32::Usb INTERFACE "${Tboot_PATH}/src/device_specific/stm32f0/usbd")
@@ -87,8 +110,16 @@ if(NOT (TARGET Tboot::Tests))
     target_include_directories(Tboot::Tests INTERFACE "${Tboot_PATH}/tests")
     target_sources(Tboot::Tests INTERFACE
             "${Tboot_PATH}/tests/test_parse_dfu_packets.c"
-            "${Tboot_PATH}/tests/test_generate_crc.c")
-    target_link_libraries(Tboot::Tests INTERFACE Tboot)
+            "${Tboot_PATH}/tests/test_generate_crc.c"
+            "${Tboot_PATH}/tests/test_dfu_pipeline.c"
+            "${Tboot_PATH}/tests/test_signature.c"
+            "${Tboot_PATH}/tests/test_delta.c"
+            "${Tboot_PATH}/tests/test_compression.c"
+            "${Tboot_PATH}/tests/test_dfu_resume.c"
+            "${Tboot_PATH}/tests/test_app.c"
+            "${Tboot_PATH}/tests/test_ram_disk.c"
+            "${Tboot_PATH}/tests/t_boot_sim.c")
+    target_link_libraries(Tboot::Tests INTERFACE Tboot Tboot::RamDisk)
 endif()
 
 include(FindPackageHandleStandardArgs)
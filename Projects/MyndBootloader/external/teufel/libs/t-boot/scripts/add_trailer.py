@@ -0,0 +1,37 @@
+#!/usr/bin/env python3
+
+import sys
+import zlib
+import struct
+import argparse
+
+TRAILER_MAGIC = 0x4C525454  # 'TTRL'
+
+
+def add_trailer(data: bytes) -> bytes:
+    """Appends the trailer checked by t_boot_app.c, see t_boot_app.h for the format."""
+    image = data + b"\xff" * (-len(data) % 4)
+
+    return image + struct.pack("<III", len(image), zlib.crc32(image), TRAILER_MAGIC)
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(
+        description="""Append the CRC trailer to a firmware. Example: python3 ./add_trailer.py -i app.bin -o mcu.bin""")
+    parser.add_argument('-i', '--input', help='Firmware', required=True)
+    parser.add_argument('-o', '--output', type=str, default='mcu.bin', help='Output file name', required=False)
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+
+    image = add_trailer(data)
+
+    with open(args.output, "wb") as f:
+        f.write(image)
+
+    print("trailer added: {} bytes, CRC32 0x{:08x}".format(len(image), zlib.crc32(image[:-12])))
+
+
+if __name__ == "__main__":
+    main(sys.argv)
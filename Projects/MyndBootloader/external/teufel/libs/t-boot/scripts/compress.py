@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+
+import sys
+import struct
+import argparse
+
+COMPRESSION_MAGIC = 0x535A4C54  # 'TLZS'
+
+# Must not exceed T_BOOT_COMPRESSION_WINDOW_BITS of the bootloader
+WINDOW_BITS = 10
+LENGTH_BITS = 4
+MIN_MATCH = 2
+
+# Bytes hashed to find match candidates, and candidates tried per position
+KEY_SIZE = 3
+MAX_CANDIDATES = 16
+
+
+class BitWriter:
+
+    def __init__(self):
+        self.__data = bytearray()
+        self.__value = 0
+        self.__count = 0
+
+    def write(self, value: int, bits: int) -> None:
+        self.__value = (self.__value << bits) | value
+        self.__count += bits
+        while self.__count >= 8:
+            self.__count -= 8
+            self.__data.append((self.__value >> self.__count) & 0xFF)
+        self.__value &= (1 << self.__count) - 1
+
+    def data(self) -> bytes:
+        if self.__count:
+            return bytes(self.__data) + bytes([(self.__value << (8 - self.__count)) & 0xFF])
+        return bytes(self.__data)
+
+
+def compress(data: bytes, window_bits: int = WINDOW_BITS, length_bits: int = LENGTH_BITS) -> bytes:
+    """Compresses a payload for t-boot, see t_boot_compression.h for the format.
+
+    Greedy LZSS: at every position the longest match within the window is taken.
+    """
+    window = 1 << window_bits
+    max_match = (1 << length_bits) - 1 + MIN_MATCH
+    index = {}
+    out = BitWriter()
+    pos = 0
+
+    def add_to_index(p: int) -> None:
+        if p + KEY_SIZE <= len(data):
+            candidates = index.setdefault(data[p:p + KEY_SIZE], [])
+            candidates.append(p)
+            if len(candidates) > MAX_CANDIDATES:
+                del candidates[0]
+
+    while pos < len(data):
+        best_len, best_dist = 0, 0
+
+        # Most recent candidates first, they are the closest
+        for candidate in reversed(index.get(data[pos:pos + KEY_SIZE], [])):
+            if pos - candidate > window:
+                break
+            n = 0
+            while n < max_match and pos + n < len(data) and data[candidate + n] == data[pos + n]:
+                n += 1
+            if n > best_len:
+                best_len, best_dist = n, pos - candidate
+                if n == max_match:
+                    break
+
+        if best_len >= MIN_MATCH:
+            out.write(0, 1)
+            out.write(best_dist - 1, window_bits)
+            out.write(best_len - MIN_MATCH, length_bits)
+            for p in range(pos, pos + best_len):
+                add_to_index(p)
+            pos += best_len
+        else:
+            out.write(1, 1)
+            out.write(data[pos], 8)
+            add_to_index(pos)
+            pos += 1
+
+    header = struct.pack("<IIBBH", COMPRESSION_MAGIC, len(data), window_bits, length_bits, 0)
+
+    return header + out.data()
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(
+        description="""Compress a firmware for t-boot. Example: python3 ./compress.py -i mcu.bin -o mcu.lzs""")
+    parser.add_argument('-i', '--input', help='Firmware', required=True)
+    parser.add_argument('-o', '--output', type=str, default='mcu.lzs', help='Output file name', required=False)
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        data = f.read()
+
+    compressed = compress(data)
+
+    with open(args.output, "wb") as f:
+        f.write(compressed)
+
+    print("compressed: {} bytes, firmware: {} bytes ({:.1f}%)".format(
+        len(compressed), len(data), 100.0 * len(compressed) / len(data)))
+
+
+if __name__ == "__main__":
+    main(sys.argv)
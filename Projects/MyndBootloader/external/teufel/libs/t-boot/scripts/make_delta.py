@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+
+import sys
+import struct
+import hashlib
+import argparse
+
+DELTA_MAGIC = 0x544C4454  # 'TDLT'
+DELTA_VERSION = 1
+
+OP_COPY = 0x01
+OP_INSERT = 0x02
+
+# Shortest match worth a COPY, the operation itself takes 9 bytes
+MIN_COPY = 16
+MAX_INSERT = 0xFFFF
+# Candidate positions kept per key of the installed image
+MAX_CANDIDATES = 8
+
+
+class DeltaGenerator:
+    """Creates a t-boot delta image which turns old into new.
+
+    t-boot writes the new image in place, page by page, and only keeps the old content of the page it is
+    writing. A COPY can therefore only read the installed image from the start of the page that the copied
+    byte is written to onwards; everything else is sent as INSERT.
+    """
+
+    def __init__(self, old: bytes, new: bytes, page_size: int = 2048):
+        self.__old = old
+        self.__new = new
+        self.__page_size = page_size
+        self.__index = {}
+
+        for pos in range(len(old) - MIN_COPY + 1):
+            candidates = self.__index.setdefault(old[pos:pos + MIN_COPY], [])
+            if len(candidates) < MAX_CANDIDATES:
+                candidates.append(pos)
+
+    def __match_length(self, src: int, dst: int) -> int:
+        old, new, page = self.__old, self.__new, self.__page_size
+        n = 0
+        while dst + n < len(new) and src + n < len(old) and old[src + n] == new[dst + n]:
+            # The source has to survive until the byte is written
+            if src + n < ((dst + n) // page) * page:
+                break
+            n += 1
+        return n
+
+    def __best_match(self, dst: int, last_delta: int):
+        best_src, best_len = 0, 0
+
+        # Continuing at the same displacement is the common case after a small change
+        if last_delta is not None and 0 <= dst + last_delta < len(self.__old):
+            best_src, best_len = dst + last_delta, self.__match_length(dst + last_delta, dst)
+
+        for src in self.__index.get(self.__new[dst:dst + MIN_COPY], []):
+            n = self.__match_length(src, dst)
+            if n > best_len:
+                best_src, best_len = src, n
+
+        return best_src, best_len
+
+    def create(self) -> bytes:
+        old, new = self.__old, self.__new
+        ops = bytearray()
+        literal = bytearray()
+        last_delta = None
+        dst = 0
+
+        def flush_literal():
+            for i in range(0, len(literal), MAX_INSERT):
+                part = literal[i:i + MAX_INSERT]
+                ops.extend(struct.pack("<BH", OP_INSERT, len(part)))
+                ops.extend(part)
+            literal.clear()
+
+        while dst < len(new):
+            src, n = self.__best_match(dst, last_delta)
+            if n >= MIN_COPY:
+                flush_literal()
+                ops.extend(struct.pack("<BII", OP_COPY, src, n))
+                last_delta = src - dst
+                dst += n
+            else:
+                literal.append(new[dst])
+                dst += 1
+        flush_literal()
+
+        header = struct.pack("<IBBHII", DELTA_MAGIC, DELTA_VERSION, 0, self.__page_size, len(old), len(new))
+        header += hashlib.sha256(old).digest()
+        header += hashlib.sha256(new).digest()
+
+        return header + ops
+
+
+def make_delta(old: bytes, new: bytes, page_size: int = 2048) -> bytes:
+    return DeltaGenerator(old, new, page_size).create()
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(
+        description="""Create a t-boot delta image. Example: python3 ./make_delta.py --old installed.bin --new mcu.bin -o mcu.delta""")
+    parser.add_argument('--old', help='Installed firmware', required=True)
+    parser.add_argument('--new', help='New firmware', required=True)
+    parser.add_argument('-o', '--output', type=str, default='mcu.delta', help='Output file name', required=False)
+    parser.add_argument('--page-size', type=int, default=2048, help='Flash page size of the target', required=False)
+    args = parser.parse_args()
+
+    with open(args.old, "rb") as f:
+        old = f.read()
+    with open(args.new, "rb") as f:
+        new = f.read()
+
+    delta = make_delta(old, new, args.page_size)
+
+    with open(args.output, "wb") as f:
+        f.write(delta)
+
+    print("delta: {} bytes, full image: {} bytes ({:.1f}%)".format(len(delta), len(new), 100.0 * len(delta) / len(new)))
+
+
+if __name__ == "__main__":
+    main(sys.argv)
@@ -8,6 +8,9 @@ import struct
 import math
 import crcmod
 
+from make_delta import make_delta
+from compress import compress
+
 from typing import List
 
 # import pdb
@@ -29,6 +32,10 @@ COMPONENT_ID_MCU_BANK1 = 7 # Alternative MCU component ID for banks(slots)
 
 COMPONENT_ID_DAB = 8
 
+COMPONENT_ID_MCU_DELTA = 9 # Delta image against the installed MCU firmware, see make_delta.py
+
+COMPONENT_COMPRESSED = 0x80 # Flag in the component id, the payload is compressed with compress.py
+
 MAGIC = 0xBEEFCAFE
 
 ENCODING_KEY = "TEUFELDEV"
@@ -387,6 +394,7 @@ def main(argv):
     parser.add_argument(
         '-o', '--output', type=str, default='update.bin', help='Output file name', required=False)
     parser.add_argument('--mcu', help='MCU firmware', required=False)
+    parser.add_argument('--mcu-base', help='Installed MCU firmware, --mcu is sent as delta against it', required=False)
     parser.add_argument('--dsp', help='DSP firmware', required=False)
     parser.add_argument(
         '--bluetooth', help='Bluetooth firmware', required=False)
@@ -405,6 +413,9 @@ def main(argv):
                         help='Forcing update component even with the same CRC sum', required=False)
     parser.add_argument('--no-encryption', default=False,
                         help='Disable encryption', required=False, action='store_true')
+    parser.add_argument('--compress', default=False,
+                        help='Compress the components, needs T_BOOT_DFU_COMPRESSION in the bootloader',
+                        required=False, action='store_true')
     parser.add_argument('-k', '--pem-key',
                         help='Certificate for signature', required=True)
 
@@ -432,77 +443,136 @@ def main(argv):
     upd = FirmwareUpdater(
         args.project_id, chunk_size=args.chunk_size, encryption=(not args.no_encryption))
 
-    if args.mcu is not None:
+    compressed_files = []
+
+    def payload(component_id: int, fname: str):
+        """Returns the component id and the file to send, the signature covers what is sent"""
+        if not args.compress:
+            return component_id, fname
+
+        with open(fname, "rb") as f:
+            data = f.read()
+
+        compressed = compress(data)
+        print("{}: {} -> {} bytes".format(fname, len(data), len(compressed)))
+
+        out = "./{}.lzs".format(os.path.basename(fname))
+        with open(out, "wb") as f:
+            f.write(compressed)
+        compressed_files.append(out)
+
+        return component_id | COMPONENT_COMPRESSED, out
+
+    if args.mcu is not None and args.mcu_base is not None:
+        with open(args.mcu_base, "rb") as f:
+            base = f.read()
+        with open(args.mcu, "rb") as f:
+            fw = f.read()
+        with open("./mcu.delta", "wb") as f:
+            f.write(make_delta(base, fw))
+
+        component_id, fname = payload(COMPONENT_ID_MCU_DELTA, "./mcu.delta")
+
+        # The signature covers the delta, which carries the digests of both images
+        os.system(
+            "openssl dgst -sha256 -sign {} -out ./sign.sha256 {}".format(args.pem_key, fname))
+
+        # Add mcu delta
+        upd.add_firmware(component_id, fname, "./sign.sha256")
+
+    elif args.mcu is not None:
         # Signature for mcu firmware
         # os.system(
-        #     "openssl dgst -sha1 -sign ../support/keys/teufel_dev_private.pem -out ./sign.sha1 {}".format(args.mcu))
+        #     "openssl dgst -sha256 -sign ../support/keys/teufel_dev_private.pem -out ./sign.sha256 {}".format(args.mcu))
+
+        component_id, fname = payload(COMPONENT_ID_MCU, args.mcu)
 
         os.system(
-            "openssl dgst -sha1 -sign {} -out ./sign.sha1 {}".format(args.pem_key, args.mcu))
+            "openssl dgst -sha256 -sign {} -out ./sign.sha256 {}".format(args.pem_key, fname))
 
         # Add mcu firmware
-        upd.add_firmware(COMPONENT_ID_MCU, args.mcu, "./sign.sha1")
+        upd.add_firmware(component_id, fname, "./sign.sha256")
 
     if args.dsp is not None:
+        component_id, fname = payload(COMPONENT_ID_DSP, args.dsp)
+
         # Signature for dsp firmware
         os.system(
-            "openssl dgst -sha1 -sign {} -out ./sign.sha1 {}".format(args.pem_key, args.dsp))
+            "openssl dgst -sha256 -sign {} -out ./sign.sha256 {}".format(args.pem_key, fname))
 
         # Add dsp firmware
-        upd.add_firmware(COMPONENT_ID_DSP, args.dsp, "./sign.sha1")
+        upd.add_firmware(component_id, fname, "./sign.sha256")
 
     if args.bluetooth is not None:
+        component_id, fname = payload(COMPONENT_ID_BLUETOOTH, args.bluetooth)
+
         # Signature for bluetooth firmware
         os.system(
-            "openssl dgst -sha1 -sign {} -out ./sign.sha1 {}".format(args.pem_key, args.bluetooth))
+            "openssl dgst -sha256 -sign {} -out ./sign.sha256 {}".format(args.pem_key, fname))
 
         # Add bluetooth firmware
-        upd.add_firmware(COMPONENT_ID_BLUETOOTH, args.bluetooth, "./sign.sha1")
+        upd.add_firmware(component_id, fname, "./sign.sha256")
 
     if args.hdmi is not None:
+        component_id, fname = payload(COMPONENT_ID_HDMI, args.hdmi)
+
         # Signature for hdmi firmware
         os.system(
-            "openssl dgst -sha1 -sign {} -out ./sign.sha1 {}".format(args.pem_key, args.hdmi))
+            "openssl dgst -sha256 -sign {} -out ./sign.sha256 {}".format(args.pem_key, fname))
 
         # Add hdmi firmware
-        upd.add_firmware(COMPONENT_ID_HDMI, args.hdmi, "./sign.sha1")
+        upd.add_firmware(component_id, fname, "./sign.sha256")
 
     if args.swatx is not None:
+        component_id, fname = payload(COMPONENT_ID_SWATX, args.swatx)
+
         # Signature for swatx firmware
         os.system(
-            "openssl dgst -sha1 -sign {} -out ./sign.sha1 {}".format(args.pem_key, args.swatx))
+            "openssl dgst -sha256 -sign {} -out ./sign.sha256 {}".format(args.pem_key, fname))
 
         # Add swatx firmware
-        upd.add_firmware(COMPONENT_ID_SWATX, args.swatx, "./sign.sha1")
+        upd.add_firmware(component_id, fname, "./sign.sha256")
 
     if args.mcu_bank0 is not None:
+        component_id, fname = payload(COMPONENT_ID_MCU_BANK0, args.mcu_bank0)
+
         # Signature for mcu bank0 firmware
         os.system(
-            "openssl dgst -sha1 -sign {} -out ./sign.sha1 {}".format(args.pem_key, args.mcu_bank0))
+            "openssl dgst -sha256 -sign {} -out ./sign.sha256 {}".format(args.pem_key, fname))
 
         # Add mcu bank0 firmware
-        upd.add_firmware(COMPONENT_ID_MCU_BANK0, args.mcu_bank0, "./sign.sha1")
+        upd.add_firmware(component_id, fname, "./sign.sha256")
 
     if args.mcu_bank1 is not None:
+        component_id, fname = payload(COMPONENT_ID_MCU_BANK1, args.mcu_bank1)
+
         # Signature for mcu bank1 firmware
         os.system(
-            "openssl dgst -sha1 -sign {} -out ./sign.sha1 {}".format(args.pem_key, args.mcu_bank1))
+            "openssl dgst -sha256 -sign {} -out ./sign.sha256 {}".format(args.pem_key, fname))
 
         # Add mcu bank1 firmware
-        upd.add_firmware(COMPONENT_ID_MCU_BANK1, args.mcu_bank1, "./sign.sha1")
+        upd.add_firmware(component_id, fname, "./sign.sha256")
 
     if args.dab is not None:
+        component_id, fname = payload(COMPONENT_ID_DAB, args.dab)
+
         # Signature for dab firmware
         os.system(
-            "openssl dgst -sha1 -sign {} -out ./sign.sha1 {}".format(args.pem_key, args.dab))
+            "openssl dgst -sha256 -sign {} -out ./sign.sha256 {}".format(args.pem_key, fname))
 
         # Add dab firmware
-        upd.add_firmware(COMPONENT_ID_DAB, args.dab, "./sign.sha1")
+        upd.add_firmware(component_id, fname, "./sign.sha256")
 
     upd.create(args.output)
 
-    if os.path.exists("./sign.sha1"):
-        os.remove("./sign.sha1")
+    if os.path.exists("./mcu.delta"):
+        os.remove("./mcu.delta")
+
+    for fname in compressed_files:
+        os.remove(fname)
+
+    if os.path.exists("./sign.sha256"):
+        os.remove("./sign.sha256")
 
 
 if __name__ == "__main__":
@@ -0,0 +1,148 @@
+#include "t_boot_app.h"
+#include "t_boot_crc.h"
+
+#define ERASED_WORD 0xFFFFFFFFu
+#define TRAILER_WORDS (sizeof(t_boot_app_trailer_t) / sizeof(uint32_t))
+
+static uint32_t get_time_us(const t_boot_app_state_t *p_state)
+{
+    return p_state->get_time_us ? p_state->get_time_us() : 0;
+}
+
+static bool is_bootloader_requested(const t_boot_app_state_t *p_state)
+{
+    if ((p_state->reset != T_BOOT_APP_RESET_SOFTWARE) || (p_state->p_boot_request == NULL))
+    {
+        return false;
+    }
+
+    uint32_t request = *p_state->p_boot_request;
+    if (request == T_BOOT_APP_REQUEST_BOOTLOADER)
+    {
+        *p_state->p_boot_request = 0;
+        return true;
+    }
+
+    // Other values are messages of the bootloader to the application, e.g. that an update was done
+    return false;
+}
+
+static bool are_vectors_valid(const t_boot_app_state_t *p_state)
+{
+    uint32_t stack_pointer = p_state->p_image[0];
+    uint32_t app_entry     = p_state->p_image[1];
+
+    if ((stack_pointer & T_BOOT_APP_STACK_MASK) != T_BOOT_APP_STACK_BASE)
+    {
+        return false;
+    }
+
+    return (app_entry >= p_state->image_address) && (app_entry - p_state->image_address < p_state->image_max_size);
+}
+
+static bool find_trailer(const t_boot_app_state_t *p_state, t_boot_app_trailer_t *p_trailer)
+{
+    uint32_t words = p_state->image_max_size / sizeof(uint32_t);
+
+    // Reads at most the erased part of the application area, less than the CRC of the image costs
+    while ((words > 0) && (p_state->p_image[words - 1] == ERASED_WORD))
+    {
+        words--;
+    }
+
+    if (words < TRAILER_WORDS + 2)
+    {
+        return false;
+    }
+
+    p_trailer->size  = p_state->p_image[words - 3];
+    p_trailer->crc32 = p_state->p_image[words - 2];
+    p_trailer->magic = p_state->p_image[words - 1];
+
+    // The trailer directly follows the image
+    return (p_trailer->magic == T_BOOT_APP_TRAILER_MAGIC) &&
+           (p_trailer->size == (words - TRAILER_WORDS) * sizeof(uint32_t));
+}
+
+static t_boot_app_decision_t check_image(const t_boot_app_state_t *p_state, t_boot_app_timing_t *p_timing)
+{
+    t_boot_app_trailer_t trailer;
+
+    if (!find_trailer(p_state, &trailer))
+    {
+        return (T_BOOT_APP_CRC_CHECK == 2) ? T_BOOT_APP_STAY_NO_TRAILER : T_BOOT_APP_START;
+    }
+
+    uint32_t start_us = get_time_us(p_state);
+
+    // One pass through the CRC unit, bounded by the size of the application area
+    t_boot_crc_init();
+    uint32_t crc32 = t_boot_crc_compute(p_state->p_image, trailer.size);
+
+    p_timing->crc_us    = get_time_us(p_state) - start_us;
+    p_timing->crc_bytes = trailer.size;
+
+    return (crc32 == trailer.crc32) ? T_BOOT_APP_START : T_BOOT_APP_STAY_INVALID_CRC;
+}
+
+static t_boot_app_decision_t decide(const t_boot_app_state_t *p_state, t_boot_app_timing_t *p_timing)
+{
+    if (is_bootloader_requested(p_state))
+    {
+        return T_BOOT_APP_STAY_REQUESTED;
+    }
+
+    if (p_state->update_pending)
+    {
+        return T_BOOT_APP_STAY_UPDATE_PENDING;
+    }
+
+    if (!are_vectors_valid(p_state))
+    {
+        return T_BOOT_APP_STAY_INVALID_VECTORS;
+    }
+
+    if (T_BOOT_APP_CRC_CHECK == 0)
+    {
+        return T_BOOT_APP_START;
+    }
+
+    return check_image(p_state, p_timing);
+}
+
+t_boot_app_decision_t t_boot_app_decide(const t_boot_app_state_t *p_state, t_boot_app_timing_t *p_timing)
+{
+    t_boot_app_timing_t timing   = {0};
+    uint32_t            start_us = get_time_us(p_state);
+
+    t_boot_app_decision_t decision = decide(p_state, &timing);
+
+    if (p_timing != NULL)
+    {
+        *p_timing           = timing;
+        p_timing->checks_us = get_time_us(p_state) - start_us - timing.crc_us;
+    }
+
+    return decision;
+}
+
+const char *t_boot_app_get_decision_desc(t_boot_app_decision_t decision)
+{
+    switch (decision)
+    {
+        case T_BOOT_APP_START:
+            return "Start application";
+        case T_BOOT_APP_STAY_REQUESTED:
+            return "Requested by application";
+        case T_BOOT_APP_STAY_UPDATE_PENDING:
+            return "Update pending";
+        case T_BOOT_APP_STAY_INVALID_VECTORS:
+            return "Invalid vector table";
+        case T_BOOT_APP_STAY_NO_TRAILER:
+            return "No image trailer";
+        case T_BOOT_APP_STAY_INVALID_CRC:
+            return "Invalid image CRC";
+        default:
+            return "Unknown";
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Application specific configuration options
+#include "t_boot_config.h"
+
+// Decides right after reset whether the application is started or the bootloader stays, before anything else is
+// initialized. The checks run cheapest first: boot request, pending update, vector table, then the image CRC.
+//
+// Image trailer, appended by scripts/add_trailer.py, little endian:
+//
+//   image    padded with 0xFF to a multiple of 4 bytes
+//   trailer  size of the padded image, CRC32 of the padded image, magic 'TTRL'
+//
+// The trailer is found as the last word in the application area which isn't erased, which works because every
+// update erases the application area up to its end.
+#define T_BOOT_APP_TRAILER_MAGIC 0x4C525454
+
+// Image CRC check: 0 off, 1 only images with a trailer are checked, 2 images without a trailer aren't started
+#ifndef T_BOOT_APP_CRC_CHECK
+#define T_BOOT_APP_CRC_CHECK 0
+#endif
+
+// Written to the boot request register by the application to enter the bootloader
+#ifndef T_BOOT_APP_REQUEST_BOOTLOADER
+#define T_BOOT_APP_REQUEST_BOOTLOADER 0xCAFEBEEF
+#endif
+
+// The initial stack pointer has to point into RAM
+#ifndef T_BOOT_APP_STACK_MASK
+#define T_BOOT_APP_STACK_MASK 0x2FFE0000
+#endif
+
+#ifndef T_BOOT_APP_STACK_BASE
+#define T_BOOT_APP_STACK_BASE 0x20000000
+#endif
+
+typedef struct __attribute__((__packed__))
+{
+    uint32_t size;
+    uint32_t crc32;
+    uint32_t magic;
+} t_boot_app_trailer_t;
+
+typedef enum
+{
+    T_BOOT_APP_RESET_POWER_ON = 0,
+    T_BOOT_APP_RESET_SOFTWARE,
+    T_BOOT_APP_RESET_WATCHDOG,
+    T_BOOT_APP_RESET_OTHER,
+} t_boot_app_reset_t;
+
+typedef enum
+{
+    T_BOOT_APP_START = 0,
+    T_BOOT_APP_STAY_REQUESTED,      // the application asked for the bootloader
+    T_BOOT_APP_STAY_UPDATE_PENDING, // an interrupted update can be resumed
+    T_BOOT_APP_STAY_INVALID_VECTORS,
+    T_BOOT_APP_STAY_NO_TRAILER,
+    T_BOOT_APP_STAY_INVALID_CRC,
+} t_boot_app_decision_t;
+
+// What the decision is based on, read from the registers right after reset
+typedef struct
+{
+    t_boot_app_reset_t  reset;
+    volatile uint32_t  *p_boot_request; // backup register, a bootloader request is cleared
+    bool                update_pending;
+    const uint32_t     *p_image;        // application area as mapped for the CPU
+    uint32_t            image_address;  // address of the application area for the application itself
+    uint32_t            image_max_size; // size of the application area, a multiple of 4
+    uint32_t (*get_time_us)(void);      // optional, for t_boot_app_timing_t
+} t_boot_app_state_t;
+
+typedef struct
+{
+    uint32_t checks_us; // boot request, pending update, vector table and trailer
+    uint32_t crc_us;
+    uint32_t crc_bytes;
+} t_boot_app_timing_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Decides whether the application is started.
+ *
+ * A bootloader request is only honoured after a software reset and is cleared then. Other values are left for the
+ * application, e.g. the note that an update was done.
+ *
+ * @param[in] p_state           pointer to the state after reset
+ * @param[out] p_timing         optional, time spent on the checks
+ *
+ * @return T_BOOT_APP_START if the application can be started, the reason to stay in the bootloader otherwise
+ */
+t_boot_app_decision_t t_boot_app_decide(const t_boot_app_state_t *p_state, t_boot_app_timing_t *p_timing);
+
+/**
+ * @brief Gets a printable description of a decision.
+ */
+const char *t_boot_app_get_decision_desc(t_boot_app_decision_t decision);
+
+#if defined(__cplusplus)
+}
+#endif
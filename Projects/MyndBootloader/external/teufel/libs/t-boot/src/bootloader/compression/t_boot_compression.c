@@ -0,0 +1,206 @@
+#include <string.h>
+
+#include "t_boot_compression.h"
+
+#define LOG_MODULE_NAME "t_boot_compression.c"
+#define LOG_LEVEL       T_BOOT_LOG_LEVEL
+#include "t_boot_logger.h"
+
+#define HALF_WINDOW (T_BOOT_COMPRESSION_WINDOW_SIZE / 2u)
+#define WINDOW_MASK (T_BOOT_COMPRESSION_WINDOW_SIZE - 1u)
+
+static int flush(t_boot_compression_t *p_ctx)
+{
+    uint32_t length = p_ctx->out_offset - p_ctx->written;
+
+    if (length == 0)
+    {
+        return 0;
+    }
+
+    // Never wraps: blocks start at a multiple of half the window and are at most half of it
+    if (p_ctx->write(&p_ctx->window[p_ctx->written & WINDOW_MASK], length, p_ctx->written) != 0)
+    {
+        log_error("Writing 0x%x failed", p_ctx->written);
+        return -1;
+    }
+    p_ctx->written = p_ctx->out_offset;
+
+    return 0;
+}
+
+static inline int put_byte(t_boot_compression_t *p_ctx, uint8_t value)
+{
+    p_ctx->window[p_ctx->out_offset & WINDOW_MASK] = value;
+    p_ctx->out_offset++;
+
+    if ((p_ctx->out_offset % HALF_WINDOW) == 0)
+    {
+        return flush(p_ctx);
+    }
+
+    return 0;
+}
+
+static inline uint32_t take_bits(t_boot_compression_t *p_ctx, uint8_t count)
+{
+    uint32_t value = p_ctx->bits >> (32u - count);
+    p_ctx->bits <<= count;
+    p_ctx->bit_count -= count;
+    return value;
+}
+
+static int check_header(const t_boot_compression_t *p_ctx)
+{
+    const t_boot_compression_header_t *p_header = &p_ctx->header;
+
+    if (p_header->magic != T_BOOT_COMPRESSION_MAGIC)
+    {
+        log_error("Not a compressed payload");
+        return -1;
+    }
+
+    // Any symbol has to fit in the bit buffer next to a partial byte
+    if ((p_header->window_bits == 0) || (p_header->window_bits > T_BOOT_COMPRESSION_WINDOW_BITS) ||
+        (p_header->length_bits == 0) || (p_header->length_bits > 8))
+    {
+        log_error("Compression window %d/%d not supported", p_header->window_bits, p_header->length_bits);
+        return -1;
+    }
+
+    log_debug("Compressed payload, %d bytes", p_header->size);
+    return 0;
+}
+
+static int decode(t_boot_compression_t *p_ctx, const uint8_t *p_data, uint32_t length)
+{
+    const uint8_t window_bits = p_ctx->header.window_bits;
+    const uint8_t length_bits = p_ctx->header.length_bits;
+
+    while (p_ctx->out_offset < p_ctx->header.size)
+    {
+        while ((p_ctx->bit_count <= 24) && (length > 0))
+        {
+            p_ctx->bits |= (uint32_t) *p_data++ << (24u - p_ctx->bit_count);
+            p_ctx->bit_count += 8;
+            p_ctx->in_offset++;
+            length--;
+        }
+
+        uint8_t needed = (p_ctx->bits & 0x80000000u) ? 9 : 1 + window_bits + length_bits;
+        if ((p_ctx->bit_count == 0) || (p_ctx->bit_count < needed))
+        {
+            // Waiting for the next part
+            return 0;
+        }
+
+        if (take_bits(p_ctx, 1))
+        {
+            if (put_byte(p_ctx, (uint8_t) take_bits(p_ctx, 8)) != 0)
+            {
+                return -1;
+            }
+            continue;
+        }
+
+        uint32_t distance = take_bits(p_ctx, window_bits) + 1u;
+        uint32_t count    = take_bits(p_ctx, length_bits) + T_BOOT_COMPRESSION_MIN_MATCH;
+
+        if ((distance > p_ctx->out_offset) || (count > p_ctx->header.size - p_ctx->out_offset))
+        {
+            log_error("Invalid copy of %d bytes from %d back at 0x%x", count, distance, p_ctx->out_offset);
+            return -1;
+        }
+
+        while (count-- > 0)
+        {
+            if (put_byte(p_ctx, p_ctx->window[(p_ctx->out_offset - distance) & WINDOW_MASK]) != 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    // Only the padding of the last byte may be left
+    if ((length > 0) || (p_ctx->bit_count >= 8))
+    {
+        log_error("Data after the end of the compressed payload");
+        return -1;
+    }
+
+    if (flush(p_ctx) != 0)
+    {
+        return -1;
+    }
+
+    log_info("Payload decompressed, %d -> %d bytes", p_ctx->in_offset + sizeof(p_ctx->header), p_ctx->out_offset);
+    p_ctx->done = true;
+    return 0;
+}
+
+static int decode_data(t_boot_compression_t *p_ctx, const uint8_t *p_data, uint32_t length)
+{
+    if (p_ctx->header_received < sizeof(p_ctx->header))
+    {
+        uint32_t n = sizeof(p_ctx->header) - p_ctx->header_received;
+        if (n > length)
+        {
+            n = length;
+        }
+        memcpy((uint8_t *) &p_ctx->header + p_ctx->header_received, p_data, n);
+        p_ctx->header_received += n;
+        p_data += n;
+        length -= n;
+
+        if (p_ctx->header_received < sizeof(p_ctx->header))
+        {
+            return 0;
+        }
+
+        if (check_header(p_ctx) != 0)
+        {
+            return -1;
+        }
+    }
+    else if (p_ctx->done)
+    {
+        log_error("Data after the end of the compressed payload");
+        return -1;
+    }
+
+    return decode(p_ctx, p_data, length);
+}
+
+void t_boot_compression_start(t_boot_compression_t *p_ctx, t_boot_compression_write_fn_t write)
+{
+    p_ctx->write           = write;
+    p_ctx->header_received = 0;
+    p_ctx->bits            = 0;
+    p_ctx->bit_count       = 0;
+    p_ctx->in_offset       = 0;
+    p_ctx->out_offset      = 0;
+    p_ctx->written         = 0;
+    p_ctx->done            = false;
+    p_ctx->failed          = false;
+}
+
+int t_boot_compression_decode(t_boot_compression_t *p_ctx, const uint8_t *p_data, uint32_t length)
+{
+    if (p_ctx->failed)
+    {
+        return -1;
+    }
+
+    if (decode_data(p_ctx, p_data, length) != 0)
+    {
+        p_ctx->failed = true;
+        return -1;
+    }
+
+    return 0;
+}
+
+bool t_boot_compression_is_done(const t_boot_compression_t *p_ctx)
+{
+    return p_ctx->done;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Application specific configuration options
+#include "t_boot_config.h"
+
+// Compressed payload, as created by scripts/compress.py:
+//
+//   header   magic 'TLZS', size of the decompressed payload, window bits, length bits, reserved
+//   data     LZSS bit stream, most significant bit first, the last byte is padded with zeros
+//              1, 8 bits                          literal byte
+//              0, window bits, length bits        copy (length bits + 2) bytes from (window bits + 1) bytes back
+//
+// Decompression needs a RAM window of 2^T_BOOT_COMPRESSION_WINDOW_BITS bytes, payloads compressed with a larger
+// window are refused. The window doubles as output buffer: it is written to the target one half at a time.
+#define T_BOOT_COMPRESSION_MAGIC 0x535A4C54
+
+#ifndef T_BOOT_COMPRESSION_WINDOW_BITS
+#define T_BOOT_COMPRESSION_WINDOW_BITS 10
+#endif
+
+#define T_BOOT_COMPRESSION_WINDOW_SIZE (1u << T_BOOT_COMPRESSION_WINDOW_BITS)
+#define T_BOOT_COMPRESSION_MIN_MATCH   2
+
+typedef struct __attribute__((__packed__))
+{
+    uint32_t magic;
+    uint32_t size;
+    uint8_t  window_bits;
+    uint8_t  length_bits;
+    uint16_t reserved;
+} t_boot_compression_header_t;
+
+/**
+ * @brief Receives decompressed data, in order and in blocks of half the window except for the last one.
+ *
+ * @return 0 if successful, -1 otherwise
+ */
+typedef int (*t_boot_compression_write_fn_t)(const uint8_t *p_data, uint32_t length, uint32_t offset);
+
+typedef struct
+{
+    t_boot_compression_write_fn_t write;
+    t_boot_compression_header_t   header;
+    uint32_t                      header_received;
+    uint32_t                      bits; // left aligned
+    uint8_t                       bit_count;
+    uint32_t                      in_offset;  // compressed bytes received
+    uint32_t                      out_offset; // decompressed bytes produced
+    uint32_t                      written;    // decompressed bytes passed to write
+    uint8_t                       window[T_BOOT_COMPRESSION_WINDOW_SIZE];
+    bool                          done;
+    bool                          failed;
+} t_boot_compression_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Prepares decompressing a payload.
+ *
+ * @param[out] p_ctx            pointer to decompression context
+ * @param[in] write             function which receives the decompressed data
+ */
+void t_boot_compression_start(t_boot_compression_t *p_ctx, t_boot_compression_write_fn_t write);
+
+/**
+ * @brief Decompresses the next part of the payload, the parts have to arrive in order but can have any length.
+ *
+ * @param[inout] p_ctx          pointer to decompression context
+ * @param[in] p_data            pointer to compressed data
+ * @param[in] length            length of compressed data
+ *
+ * @return 0 if successful, -1 if the payload is invalid or writing failed
+ */
+int t_boot_compression_decode(t_boot_compression_t *p_ctx, const uint8_t *p_data, uint32_t length);
+
+/**
+ * @brief Checks if the whole payload was decompressed and written.
+ *
+ * @return true if done, false otherwise
+ */
+bool t_boot_compression_is_done(const t_boot_compression_t *p_ctx);
+
+#if defined(__cplusplus)
+}
+#endif
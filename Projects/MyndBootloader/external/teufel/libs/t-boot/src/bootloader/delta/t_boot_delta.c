@@ -0,0 +1,459 @@
+#include <string.h>
+
+#include "t_boot_config.h"
+#include "t_boot_delta.h"
+
+#define LOG_MODULE_NAME "t_boot_delta.c"
+#define LOG_LEVEL       T_BOOT_LOG_LEVEL
+#include "t_boot_logger.h"
+
+#define COPY_OP_LENGTH   9
+#define INSERT_OP_LENGTH 3
+
+// Bytes read from flash per step, for the digests and COPY operations beyond the buffered page
+#define READ_SIZE 64
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static int hash_flash(t_boot_delta_t *p_delta, uint32_t size, uint8_t *p_digest)
+{
+    t_boot_sha256_ctx_t ctx;
+    uint8_t             buffer[READ_SIZE];
+
+    t_boot_sha256_init(&ctx);
+    for (uint32_t offset = 0; offset < size; offset += sizeof(buffer))
+    {
+        uint32_t length = (size - offset < sizeof(buffer)) ? size - offset : sizeof(buffer);
+        if (p_delta->p_flash->read(buffer, length, offset) != 0)
+        {
+            return -1;
+        }
+        t_boot_sha256_update(&ctx, buffer, length);
+    }
+    t_boot_sha256_final(&ctx, p_digest);
+
+    return 0;
+}
+
+static int flush(t_boot_delta_t *p_delta)
+{
+    uint32_t length = p_delta->staged_length;
+    uint32_t offset = p_delta->out_offset - length;
+
+    if (length == 0)
+    {
+        return 0;
+    }
+
+    // Only the end of an odd sized image is padded, with the erased value
+    if (length & 1u)
+    {
+        p_delta->staged[length++] = 0xFF;
+    }
+
+    p_delta->staged_length = 0;
+    return p_delta->p_flash->program(p_delta->staged, length, offset);
+}
+
+// Saves the old content of the page the output has reached, the page is only erased once the output differs
+static int ensure_page(t_boot_delta_t *p_delta)
+{
+    const t_boot_delta_flash_t *p_flash = p_delta->p_flash;
+    uint32_t                    page    = p_delta->out_offset / p_flash->page_size;
+
+    if ((p_delta->out_offset % p_flash->page_size) != 0)
+    {
+        return 0;
+    }
+
+    if ((flush(p_delta) != 0) || (p_flash->read(p_flash->p_page_buffer, p_flash->page_size, page * p_flash->page_size) != 0))
+    {
+        log_error("Page %d could not be prepared", page);
+        return -1;
+    }
+
+    p_delta->page_erased = false;
+    return 0;
+}
+
+// Erases the page of the output and programs the output so far again, which is the old content
+static int rewrite_page(t_boot_delta_t *p_delta)
+{
+    const t_boot_delta_flash_t *p_flash    = p_delta->p_flash;
+    uint32_t                    in_page    = p_delta->out_offset % p_flash->page_size;
+    uint32_t                    page_start = p_delta->out_offset - in_page;
+    uint32_t                    even       = in_page & ~1u;
+
+    if ((p_flash->erase_page(page_start) != 0) ||
+        ((even > 0) && (p_flash->program(p_flash->p_page_buffer, even, page_start) != 0)))
+    {
+        log_error("Page %d could not be rewritten", page_start / p_flash->page_size);
+        return -1;
+    }
+
+    // An odd byte is programmed together with the next one
+    p_delta->staged_length = 0;
+    if (in_page & 1u)
+    {
+        p_delta->staged[p_delta->staged_length++] = p_flash->p_page_buffer[even];
+    }
+
+    p_delta->page_erased = true;
+    return 0;
+}
+
+// Data for the current page, never crosses the end of the page
+static int emit(t_boot_delta_t *p_delta, const uint8_t *p_data, uint32_t length)
+{
+    while (!p_delta->page_erased && (length > 0))
+    {
+        // Output matching the old content leaves the page as it is
+        const uint8_t *p_old = &p_delta->p_flash->p_page_buffer[p_delta->out_offset % p_delta->p_flash->page_size];
+        if (*p_data != *p_old)
+        {
+            if (rewrite_page(p_delta) != 0)
+            {
+                return -1;
+            }
+            break;
+        }
+
+        p_delta->out_offset++;
+        p_delta->op_remaining--;
+        p_data++;
+        length--;
+    }
+
+    while (length > 0)
+    {
+        uint32_t n = sizeof(p_delta->staged) - p_delta->staged_length;
+        if (n > length)
+        {
+            n = length;
+        }
+
+        memcpy(&p_delta->staged[p_delta->staged_length], p_data, n);
+        p_delta->staged_length += n;
+        p_delta->out_offset += n;
+        p_delta->op_remaining -= n;
+        p_data += n;
+        length -= n;
+
+        if ((p_delta->staged_length == sizeof(p_delta->staged)) && (flush(p_delta) != 0))
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static uint32_t page_left(const t_boot_delta_t *p_delta)
+{
+    return p_delta->p_flash->page_size - (p_delta->out_offset % p_delta->p_flash->page_size);
+}
+
+static int copy(t_boot_delta_t *p_delta)
+{
+    const t_boot_delta_flash_t *p_flash = p_delta->p_flash;
+
+    while (p_delta->op_remaining > 0)
+    {
+        if (ensure_page(p_delta) != 0)
+        {
+            return -1;
+        }
+
+        uint32_t page_start = p_delta->out_offset - (p_delta->out_offset % p_flash->page_size);
+        uint32_t source     = p_delta->copy_offset;
+        uint32_t n          = page_left(p_delta);
+        if (n > p_delta->op_remaining)
+        {
+            n = p_delta->op_remaining;
+        }
+
+        if (source < page_start)
+        {
+            log_error("COPY from 0x%x, already overwritten", source);
+            return -1;
+        }
+
+        if (source < page_start + p_flash->page_size)
+        {
+            // Old content of the current page
+            if (n > page_start + p_flash->page_size - source)
+            {
+                n = page_start + p_flash->page_size - source;
+            }
+            if (emit(p_delta, &p_flash->p_page_buffer[source - page_start], n) != 0)
+            {
+                return -1;
+            }
+        }
+        else
+        {
+            // Pages ahead of the output are still untouched
+            uint8_t buffer[READ_SIZE];
+            if (n > sizeof(buffer))
+            {
+                n = sizeof(buffer);
+            }
+            if ((p_flash->read(buffer, n, source) != 0) || (emit(p_delta, buffer, n) != 0))
+            {
+                return -1;
+            }
+        }
+
+        p_delta->copy_offset += n;
+    }
+
+    return 0;
+}
+
+static int insert(t_boot_delta_t *p_delta, const uint8_t *p_data, uint32_t length)
+{
+    while (length > 0)
+    {
+        if (ensure_page(p_delta) != 0)
+        {
+            return -1;
+        }
+
+        uint32_t n = page_left(p_delta);
+        if (n > length)
+        {
+            n = length;
+        }
+        if (emit(p_delta, p_data, n) != 0)
+        {
+            return -1;
+        }
+        p_data += n;
+        length -= n;
+    }
+
+    return 0;
+}
+
+static int check_header(t_boot_delta_t *p_delta)
+{
+    const t_boot_delta_header_t *p_header = &p_delta->header;
+    uint8_t                      digest[T_BOOT_SHA256_DIGEST_SIZE];
+
+    if ((p_header->magic != T_BOOT_DELTA_MAGIC) || (p_header->version != T_BOOT_DELTA_VERSION) ||
+        (p_header->page_size != p_delta->p_flash->page_size))
+    {
+        log_error("Unsupported delta image");
+        return -1;
+    }
+
+    if ((p_header->old_size > p_delta->p_flash->flash_size) || (p_header->new_size > p_delta->p_flash->flash_size) ||
+        (p_header->new_size == 0))
+    {
+        log_error("Delta image sizes don't fit");
+        return -1;
+    }
+
+    // Nothing has been erased yet, a delta for another installed version is refused without harm
+    if ((hash_flash(p_delta, p_header->old_size, digest) != 0) ||
+        (memcmp(digest, p_header->old_sha256, sizeof(digest)) != 0))
+    {
+        log_error("Delta image doesn't match the installed firmware");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int parse_op(t_boot_delta_t *p_delta)
+{
+    const t_boot_delta_header_t *p_header = &p_delta->header;
+    uint32_t                     length;
+
+    if (p_delta->op[0] == T_BOOT_DELTA_OP_COPY)
+    {
+        p_delta->copy_offset = get_u32(&p_delta->op[1]);
+        length               = get_u32(&p_delta->op[5]);
+        if ((p_delta->copy_offset > p_header->old_size) || (length > p_header->old_size - p_delta->copy_offset))
+        {
+            log_error("COPY beyond the installed image");
+            return -1;
+        }
+    }
+    else
+    {
+        length = (uint32_t) p_delta->op[1] | ((uint32_t) p_delta->op[2] << 8);
+    }
+
+    if ((length == 0) || (length > p_header->new_size - p_delta->out_offset))
+    {
+        log_error("Operation beyond the new image");
+        return -1;
+    }
+
+    p_delta->op_remaining = length;
+    p_delta->op_received  = 0;
+    return 0;
+}
+
+// The application trailer is found as the last word which isn't erased, so the rest of the last page and the pages
+// of a longer old image are erased
+static int erase_tail(t_boot_delta_t *p_delta)
+{
+    const t_boot_delta_flash_t *p_flash = p_delta->p_flash;
+    uint32_t                    in_page = p_delta->out_offset % p_flash->page_size;
+    uint32_t                    end     = p_delta->out_offset - in_page;
+
+    if (in_page > 0)
+    {
+        end += p_flash->page_size;
+        for (uint32_t i = in_page; !p_delta->page_erased && (i < p_flash->page_size); i++)
+        {
+            if ((p_flash->p_page_buffer[i] != 0xFF) && (rewrite_page(p_delta) != 0))
+            {
+                return -1;
+            }
+        }
+    }
+
+    if (flush(p_delta) != 0)
+    {
+        return -1;
+    }
+
+    for (uint32_t offset = end; offset < p_delta->header.old_size; offset += p_flash->page_size)
+    {
+        if (p_flash->erase_page(offset) != 0)
+        {
+            log_error("Page %d could not be erased", offset / p_flash->page_size);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int finish(t_boot_delta_t *p_delta)
+{
+    uint8_t digest[T_BOOT_SHA256_DIGEST_SIZE];
+
+    if ((erase_tail(p_delta) != 0) || (hash_flash(p_delta, p_delta->header.new_size, digest) != 0) ||
+        (memcmp(digest, p_delta->header.new_sha256, sizeof(digest)) != 0))
+    {
+        log_error("Written image doesn't match the delta image");
+        return -1;
+    }
+
+    log_info("Delta image applied");
+    p_delta->done = true;
+    return 0;
+}
+
+static int write_data(t_boot_delta_t *p_delta, const uint8_t *p_data, uint32_t length)
+{
+    while (length > 0)
+    {
+        if (p_delta->done)
+        {
+            log_error("Data after the end of the delta image");
+            return -1;
+        }
+
+        if (p_delta->header_received < sizeof(p_delta->header))
+        {
+            uint32_t n = sizeof(p_delta->header) - p_delta->header_received;
+            if (n > length)
+            {
+                n = length;
+            }
+            memcpy((uint8_t *) &p_delta->header + p_delta->header_received, p_data, n);
+            p_delta->header_received += n;
+            p_data += n;
+            length -= n;
+
+            if ((p_delta->header_received == sizeof(p_delta->header)) && (check_header(p_delta) != 0))
+            {
+                return -1;
+            }
+            continue;
+        }
+
+        if (p_delta->op_remaining == 0)
+        {
+            // Collect the operation, it can be split across chunks
+            p_delta->op[p_delta->op_received++] = *p_data++;
+            length--;
+
+            if ((p_delta->op[0] != T_BOOT_DELTA_OP_COPY) && (p_delta->op[0] != T_BOOT_DELTA_OP_INSERT))
+            {
+                log_error("Unknown delta operation 0x%02x", p_delta->op[0]);
+                return -1;
+            }
+
+            uint32_t op_length = (p_delta->op[0] == T_BOOT_DELTA_OP_COPY) ? COPY_OP_LENGTH : INSERT_OP_LENGTH;
+            if (p_delta->op_received < op_length)
+            {
+                continue;
+            }
+
+            if (parse_op(p_delta) != 0)
+            {
+                return -1;
+            }
+
+            if ((p_delta->op[0] == T_BOOT_DELTA_OP_COPY) && (copy(p_delta) != 0))
+            {
+                return -1;
+            }
+        }
+        else
+        {
+            // INSERT data
+            uint32_t n = (length < p_delta->op_remaining) ? length : p_delta->op_remaining;
+            if (insert(p_delta, p_data, n) != 0)
+            {
+                return -1;
+            }
+            p_data += n;
+            length -= n;
+        }
+
+        if ((p_delta->op_remaining == 0) && (p_delta->out_offset == p_delta->header.new_size) &&
+            (finish(p_delta) != 0))
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void t_boot_delta_start(t_boot_delta_t *p_delta, const t_boot_delta_flash_t *p_flash)
+{
+    memset(p_delta, 0, sizeof(*p_delta));
+    p_delta->p_flash = p_flash;
+}
+
+int t_boot_delta_write(t_boot_delta_t *p_delta, const uint8_t *p_data, uint32_t length)
+{
+    if (p_delta->failed)
+    {
+        return -1;
+    }
+
+    if (write_data(p_delta, p_data, length) != 0)
+    {
+        p_delta->failed = true;
+        return -1;
+    }
+
+    return 0;
+}
+
+bool t_boot_delta_is_done(const t_boot_delta_t *p_delta)
+{
+    return p_delta->done;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "t_boot_sha256.h"
+
+// Delta image, little endian, as created by scripts/make_delta.py:
+//
+//   header   magic 'TDLT', version, reserved, page size, old size, new size,
+//            SHA-256 of the installed image, SHA-256 of the resulting image
+//   COPY     0x01, u32 offset in the installed image, u32 length
+//   INSERT   0x02, u16 length, length bytes of data
+//
+// The new image is written in place, page by page. The old content of a page is saved in the page buffer when the
+// output reaches it, so a COPY can only read the installed image from the start of the page being written onwards.
+// A page is only erased and programmed once its output differs from the old content, unchanged pages are left alone.
+//
+// An interrupted apply leaves pages of both images behind. The installed image no longer matches the header, so the
+// same delta is refused before anything is erased and the device needs the full image. t_boot_app_decide() keeps the
+// bootloader for it: the checkpoint of the interrupted transfer is pending and the image CRC doesn't match.
+#define T_BOOT_DELTA_MAGIC   0x544C4454
+#define T_BOOT_DELTA_VERSION 1
+
+#define T_BOOT_DELTA_OP_COPY   0x01
+#define T_BOOT_DELTA_OP_INSERT 0x02
+
+typedef struct __attribute__((__packed__))
+{
+    uint32_t magic;
+    uint8_t  version;
+    uint8_t  reserved;
+    uint16_t page_size;
+    uint32_t old_size;
+    uint32_t new_size;
+    uint8_t  old_sha256[T_BOOT_SHA256_DIGEST_SIZE];
+    uint8_t  new_sha256[T_BOOT_SHA256_DIGEST_SIZE];
+} t_boot_delta_header_t;
+
+typedef struct
+{
+    int (*read)(uint8_t *p_data, uint32_t length, uint32_t offset);          // installed/written image
+    int (*erase_page)(uint32_t offset);                                      // offset of the page
+    int (*program)(const uint8_t *p_data, uint32_t length, uint32_t offset); // even length and offset
+    uint8_t *p_page_buffer;                                                  // page_size bytes
+    uint32_t page_size;
+    uint32_t flash_size;
+} t_boot_delta_flash_t;
+
+typedef struct
+{
+    const t_boot_delta_flash_t *p_flash;
+    t_boot_delta_header_t       header;
+    uint32_t                    header_received;
+    uint8_t                     op[9]; // opcode and its fields
+    uint8_t                     op_received;
+    uint32_t                    op_remaining; // bytes of the current COPY/INSERT left to output
+    uint32_t                    copy_offset;
+    uint32_t                    out_offset;
+    uint8_t                     staged[64]; // output not programmed yet
+    uint8_t                     staged_length;
+    bool                        page_erased; // the page of the output, nothing is staged until it is
+    bool                        done;
+    bool                        failed;
+} t_boot_delta_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Prepares applying a delta image.
+ *
+ * @param[out] p_delta          pointer to delta context
+ * @param[in] p_flash           flash access of the application area
+ */
+void t_boot_delta_start(t_boot_delta_t *p_delta, const t_boot_delta_flash_t *p_flash);
+
+/**
+ * @brief Applies the next part of the delta image, the parts have to arrive in order but can have any length.
+ * @note  The installed image is checked against the header before the first page is erased. The part which
+ *        completes the image also reads the written image back and checks it against the header.
+ *
+ * @param[inout] p_delta        pointer to delta context
+ * @param[in] p_data            pointer to delta data
+ * @param[in] length            length of delta data
+ *
+ * @return 0 if successful, -1 if the delta doesn't apply or the result doesn't match
+ */
+int t_boot_delta_write(t_boot_delta_t *p_delta, const uint8_t *p_data, uint32_t length);
+
+/**
+ * @brief Checks if the whole new image was written and verified.
+ *
+ * @return true if done, false otherwise
+ */
+bool t_boot_delta_is_done(const t_boot_delta_t *p_delta);
+
+#if defined(__cplusplus)
+}
+#endif
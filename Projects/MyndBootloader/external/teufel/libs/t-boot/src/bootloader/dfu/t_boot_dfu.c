@@ -22,34 +22,18 @@
 static const uint8_t key[] = T_BOOT_ENCRYPTION_KEY;
 
 #if T_BOOT_DFU_SKIP_SIGNATURE == 0
-
-#include "crypto.h"
-
-/* buffer required for internal allocation of memory */
-static uint8_t preallocated_buffer[1024];
-
-/* Inject RSA private key here */
-extern const uint8_t T1_Modulus[128];
-extern const uint8_t T1_pubExp[3];
-
-static const RSApubKey_stt PubKey_st = {
-    .mExponentSize = sizeof(T1_pubExp),
-    .mModulusSize  = sizeof(T1_Modulus),
-    .pmExponent    = (uint8_t *) T1_pubExp,
-    .pmModulus     = (uint8_t *) T1_Modulus,
-};
-
-static uint8_t signature[128]; /* Buffer that will contain the signature */
-
-/* The SHA1 context */
-static SHA1ctx_stt SHA1ctx_st;
-/* Buffer that will contain the SHA-1 digest of the message */
-static uint8_t Digest[CRL_SHA1_SIZE];
-/* structure that will contain the preallocated buffer */
-static membuf_stt mb_st;
-
+// The firmware is hashed with SHA-256 chunk by chunk as it arrives, at the end only the signature is checked
+static uint8_t            signature[T_BOOT_DFU_SIGNATURE_SIZE];
+static t_boot_signature_t m_signature;
 #endif /* T_BOOT_DFU_SKIP_SIGNATURE == 0 */
 
+#if T_BOOT_DFU_COMPRESSION
+// One compressed component is decompressed at a time, its chunks have to arrive in order
+static t_boot_compression_t m_compression;
+static uint8_t              m_compression_component_id;
+static uint32_t             m_compression_next_offset;
+#endif /* T_BOOT_DFU_COMPRESSION */
+
 typedef struct __attribute__((__packed__))
 {
     uint32_t magic; // 0xBEEFCAFE
@@ -115,6 +99,7 @@ typedef struct
     uint16_t                   number_of_chunks;
     uint8_t                    dfu_components_left;
     uint8_t                    encryption_type;
+    bool                       compressed;
     dfu_process_state_t        state;
 } t_boot_context_sequential_t;
 
@@ -124,6 +109,12 @@ typedef struct
 {
     t_boot_dfu_fw_header_t fw_header;
     uint32_t               bytes_written;
+    uint32_t               resume_offset;   // programmed before an interruption, only compared
+    uint32_t               verified_offset; // programmed in order up to here
+#if T_BOOT_DFU_SKIP_SIGNATURE == 0
+    uint8_t            signature[T_BOOT_DFU_SIGNATURE_SIZE];
+    t_boot_signature_t sign;
+#endif
 } t_boot_dfu_fw_status_t;
 
 typedef struct
@@ -188,6 +179,14 @@ int t_boot_dfu_init(const t_boot_config_t *p_config)
         }
     }
 
+#if T_BOOT_DFU_SKIP_SIGNATURE == 0
+    if (p_config->verify_signature_fn == NULL)
+    {
+        log_error("Signature verification fn not set");
+        return -1;
+    }
+#endif
+
 #ifdef T_BOOT_DFU_NON_SEQUENTIAL_MODE
     // In non-sequential mode we have to store *all* fw headers which we receiving, to track the progress.
     uint32_t fw_status_alloc_size;
@@ -201,6 +200,7 @@ int t_boot_dfu_init(const t_boot_config_t *p_config)
     }
 
     memset(t_boot_ctx.fw_status, 0, fw_status_alloc_size);
+    t_boot_ctx.bytes_in_chunk = 0;
 
     // TODO: redunduncy!
     t_boot_ctx.fw_status_len = p_config->dfu_target_list_size;
@@ -210,6 +210,10 @@ int t_boot_dfu_init(const t_boot_config_t *p_config)
     for (int i = 0; i < p_config->dfu_target_list_size; ++i)
     {
         t_boot_ctx.fw_status[i].fw_header.component_id = p_config->p_dfu_target_list[i].component_id;
+#if T_BOOT_DFU_SKIP_SIGNATURE == 0
+        // Chunks can arrive before the FW header, so hashing starts right away
+        t_boot_signature_start(&t_boot_ctx.fw_status[i].sign);
+#endif
     }
 #endif
 
@@ -279,11 +283,163 @@ static void save_received_fw_header(t_boot_context_non_sequential_t *ctx, t_boot
         if (ctx->fw_status[i].fw_header.component_id == p_fw_header->component_id)
         {
             memcpy(&ctx->fw_status[i].fw_header, p_fw_header, sizeof(t_boot_dfu_fw_header_t));
+#if T_BOOT_DFU_SKIP_SIGNATURE == 0
+            // The signature follows the FW header
+            memcpy(ctx->fw_status[i].signature, (uint8_t *) p_fw_header + DFU_HEADER_LEN, T_BOOT_DFU_SIGNATURE_SIZE);
+#endif
             dump_fw_header(&ctx->fw_status[i].fw_header);
         }
     }
 }
 
+static t_boot_dfu_fw_status_t *get_fw_status(t_boot_context_non_sequential_t *ctx, uint8_t component_id)
+{
+    for (uint8_t i = 0; i < ctx->fw_status_len; ++i)
+    {
+        if (ctx->fw_status[i].fw_header.component_id == component_id)
+        {
+            return &ctx->fw_status[i];
+        }
+    }
+    return NULL;
+}
+
+static const t_boot_dfu_target_t *get_dfu_target(uint8_t component_id)
+{
+    for (int i = 0; i < m_boot.p_config->dfu_target_list_size; i++)
+    {
+        if (m_boot.p_config->p_dfu_target_list[i].component_id == component_id)
+        {
+            return &m_boot.p_config->p_dfu_target_list[i];
+        }
+    }
+    return NULL;
+}
+
+static void save_checkpoint(const t_boot_dfu_fw_status_t *p_fw_status, uint32_t offset)
+{
+    if (m_boot.p_config->checkpoint_save_fn == NULL)
+    {
+        return;
+    }
+
+    t_boot_dfu_checkpoint_t checkpoint = {
+        .component_id = p_fw_status->fw_header.component_id,
+        .fw_size      = p_fw_status->fw_header.size,
+        .fw_crc32     = p_fw_status->fw_header.fw_crc32,
+        .offset       = offset,
+    };
+    m_boot.p_config->checkpoint_save_fn(&checkpoint);
+}
+
+// Continues where an interrupted transfer of the same firmware has stopped
+static void resume_fw(t_boot_dfu_fw_status_t *p_fw_status)
+{
+    const t_boot_dfu_target_t *p_dfu_target = get_dfu_target(p_fw_status->fw_header.component_id);
+    t_boot_dfu_checkpoint_t    checkpoint;
+
+    if ((m_boot.p_config->checkpoint_load_fn == NULL) || (p_dfu_target == NULL) || (p_dfu_target->resume == NULL) ||
+        (p_dfu_target->read == NULL) || !m_boot.p_config->checkpoint_load_fn(&checkpoint))
+    {
+        return;
+    }
+
+    if ((checkpoint.offset == 0) || (checkpoint.component_id != p_fw_status->fw_header.component_id) ||
+        (checkpoint.fw_size != p_fw_status->fw_header.size) ||
+        (checkpoint.fw_crc32 != p_fw_status->fw_header.fw_crc32) || (checkpoint.offset > checkpoint.fw_size))
+    {
+        // Another firmware, whatever it left behind is overwritten
+        save_checkpoint(p_fw_status, 0);
+        return;
+    }
+
+    p_fw_status->resume_offset = p_dfu_target->resume(checkpoint.offset);
+    log_info("Resuming %s at 0x%x", p_dfu_target->name, p_fw_status->resume_offset);
+}
+
+// The host (re)starts sending a component, e.g. after the cable was pulled
+static void start_fw(t_boot_dfu_fw_status_t *p_fw_status, bool compressed)
+{
+    p_fw_status->bytes_written   = 0;
+    p_fw_status->resume_offset   = 0;
+    p_fw_status->verified_offset = 0;
+#if T_BOOT_DFU_SKIP_SIGNATURE == 0
+    t_boot_signature_start(&p_fw_status->sign);
+#endif
+
+    // The decompressor can't pick up in the middle of a payload
+    if (!compressed)
+    {
+        resume_fw(p_fw_status);
+    }
+}
+
+static int compare_with_target(const t_boot_dfu_target_t *p_dfu_target, const uint8_t *p_data, uint32_t length,
+                               uint32_t offset)
+{
+    uint8_t buffer[64];
+
+    while (length > 0)
+    {
+        uint32_t n = (length < sizeof(buffer)) ? length : sizeof(buffer);
+        if ((p_dfu_target->read(buffer, n, offset) != 0) || (memcmp(buffer, p_data, n) != 0))
+        {
+            return -1;
+        }
+        p_data += n;
+        offset += n;
+        length -= n;
+    }
+
+    return 0;
+}
+
+// Data below the resume offset was programmed before the interruption, it only has to match
+static int write_resumed(t_boot_dfu_fw_status_t *p_fw_status, const t_boot_dfu_target_t *p_dfu_target,
+                         const uint8_t *p_data, uint32_t length, uint32_t offset)
+{
+    uint32_t programmed = 0;
+
+    if (offset < p_fw_status->resume_offset)
+    {
+        programmed = p_fw_status->resume_offset - offset;
+        if (programmed > length)
+        {
+            programmed = length;
+        }
+
+        if (compare_with_target(p_dfu_target, p_data, programmed, offset) != 0)
+        {
+            log_error("Resumed firmware differs at 0x%x", offset);
+            save_checkpoint(p_fw_status, 0);
+            return -1;
+        }
+    }
+
+    if (programmed == length)
+    {
+        return 0;
+    }
+
+    return p_dfu_target->write(&p_data[programmed], length - programmed, offset + programmed);
+}
+
+static void update_checkpoint(t_boot_dfu_fw_status_t *p_fw_status, uint32_t offset, uint32_t length)
+{
+    if (offset != p_fw_status->verified_offset)
+    {
+        return;
+    }
+
+    p_fw_status->verified_offset += length;
+
+    // The checkpoint is only meaningful together with the size and CRC of the firmware
+    if (p_fw_status->fw_header.magic == 0xBEEFCAFE)
+    {
+        save_checkpoint(p_fw_status, p_fw_status->verified_offset);
+    }
+}
+
 static bool is_fw_complete(const t_boot_context_non_sequential_t *ctx, uint8_t component_id)
 {
     for (uint8_t i = 0; i < ctx->fw_status_len; ++i)
@@ -301,6 +457,33 @@ static bool is_fw_complete(const t_boot_context_non_sequential_t *ctx, uint8_t c
     return false;
 }
 
+static int write_payload(const t_boot_dfu_target_t *p_dfu_target, bool compressed, const uint8_t *p_data,
+                         uint32_t length, uint32_t offset)
+{
+#if T_BOOT_DFU_COMPRESSION
+    if (compressed)
+    {
+        return t_boot_compression_decode(&m_compression, p_data, length);
+    }
+#else
+    (void) compressed;
+#endif
+    return p_dfu_target->write(p_data, length, offset);
+}
+
+static bool is_payload_complete(bool compressed)
+{
+#if T_BOOT_DFU_COMPRESSION
+    if (compressed)
+    {
+        return t_boot_compression_is_done(&m_compression);
+    }
+#else
+    (void) compressed;
+#endif
+    return true;
+}
+
 int t_boot_dfu_non_sequential_process_chunk(uint8_t *p_buffer, uint16_t length)
 {
     static t_boot_dfu_header_t dfu_header;
@@ -343,14 +526,26 @@ int t_boot_dfu_non_sequential_process_chunk(uint8_t *p_buffer, uint16_t length)
     if (is_fw_header(p_buffer, length))
     {
         t_boot_dfu_fw_header_t *p_fw_header = (t_boot_dfu_fw_header_t *) p_buffer;
+        // The chunks tell whether the payload is compressed, the status is kept per component
+        bool compressed = (p_fw_header->component_id & T_BOOT_DFU_COMPONENT_COMPRESSED) != 0;
+        p_fw_header->component_id &= ~T_BOOT_DFU_COMPONENT_COMPRESSED;
         // log_info("%s FW header received", m_boot.p_current_dfu_target->name);
         log_debug(" - Component ID: %d", p_fw_header->component_id);
         log_debug(" - Size: %d", p_fw_header->size);
         log_debug(" - Chunks: %d", p_fw_header->chunks);
         log_debug(" - CRC: 0x%08x", p_fw_header->fw_crc32);
 
+        t_boot_dfu_fw_status_t *p_fw_status = get_fw_status(&t_boot_ctx, p_fw_header->component_id);
+        bool restarted = (p_fw_status != NULL) && (p_fw_status->fw_header.magic == 0xBEEFCAFE);
+
         save_received_fw_header(&t_boot_ctx, p_fw_header);
 
+        // A header seen before means the host starts over, otherwise chunks may have arrived ahead of it
+        if ((p_fw_status != NULL) && (restarted || (p_fw_status->bytes_written == 0)))
+        {
+            start_fw(p_fw_status, compressed);
+        }
+
         return 0;
     }
 
@@ -363,6 +558,9 @@ int t_boot_dfu_non_sequential_process_chunk(uint8_t *p_buffer, uint16_t length)
         goto error_failed;
     }
 
+    bool compressed = (p_chunk_header->component_id & T_BOOT_DFU_COMPONENT_COMPRESSED) != 0;
+    p_chunk_header->component_id &= ~T_BOOT_DFU_COMPONENT_COMPRESSED;
+
     // Look up dfp from the list of pre-defined dfus
     for (int i = 0; i < m_boot.p_config->dfu_target_list_size; i++)
     {
@@ -398,21 +596,91 @@ int t_boot_dfu_non_sequential_process_chunk(uint8_t *p_buffer, uint16_t length)
     // Offset in bytes
     uint32_t offset = t_boot_ctx.bytes_in_chunk * (p_chunk_header->chunk_number - 1);
 
+#if T_BOOT_DFU_COMPRESSION
+    if (compressed)
+    {
+        // The decompressor needs the stream in order, the first chunk starts it
+        if (offset == 0)
+        {
+            t_boot_compression_start(&m_compression, m_boot.p_current_dfu_target->write);
+            m_compression_component_id = p_chunk_header->component_id;
+            m_compression_next_offset  = 0;
+        }
+
+        if ((m_compression_component_id != p_chunk_header->component_id) || (offset != m_compression_next_offset))
+        {
+            error_code = T_BOOT_DFU_ERROR_CHUNK_NUM;
+            goto error_failed;
+        }
+        m_compression_next_offset += p_chunk_header->length;
+    }
+#else
+    if (compressed)
+    {
+        error_code = T_BOOT_DFU_ERROR_COMPRESSION;
+        goto error_failed;
+    }
+#endif
+
+    t_boot_dfu_fw_status_t *p_fw_status = get_fw_status(&t_boot_ctx, p_chunk_header->component_id);
+
     log_debug("Writing %d bytes to offset 0x%x, chunk num: %u", p_chunk_header->length, offset,
               p_chunk_header->chunk_number);
-    if (m_boot.p_current_dfu_target->write(&p_buffer[DFU_HEADER_LEN], p_chunk_header->length, offset) != 0)
+    if (compressed || (p_fw_status == NULL))
     {
-        error_code = T_BOOT_DFU_ERROR_WRITE;
-        goto error_failed;
+        if (write_payload(m_boot.p_current_dfu_target, compressed, &p_buffer[DFU_HEADER_LEN],
+                          p_chunk_header->length, offset) != 0)
+        {
+            error_code = T_BOOT_DFU_ERROR_WRITE;
+            goto error_failed;
+        }
+    }
+    else
+    {
+        if (write_resumed(p_fw_status, m_boot.p_current_dfu_target, &p_buffer[DFU_HEADER_LEN],
+                          p_chunk_header->length, offset) != 0)
+        {
+            error_code = T_BOOT_DFU_ERROR_WRITE;
+            goto error_failed;
+        }
+        update_checkpoint(p_fw_status, offset, p_chunk_header->length);
     }
 
     set_fw_bytes_written(&t_boot_ctx, p_chunk_header->component_id, p_chunk_header->length);
 
+#if T_BOOT_DFU_SKIP_SIGNATURE == 0
+    if (p_fw_status)
+    {
+        t_boot_signature_update(&p_fw_status->sign, &p_buffer[DFU_HEADER_LEN], p_chunk_header->length, offset);
+    }
+#endif
+
     // Once FW header received we can start track the progress, since now we know the fw size, amount of chunks, etc.
     if (is_fw_header_received(&t_boot_ctx, p_chunk_header->component_id))
     {
         if (is_fw_complete(&t_boot_ctx, p_chunk_header->component_id))
         {
+            if (!is_payload_complete(compressed))
+            {
+                error_code = T_BOOT_DFU_ERROR_COMPRESSION;
+                goto error_failed;
+            }
+
+#if T_BOOT_DFU_SKIP_SIGNATURE == 0
+            // Chunks written out of order are read back from the target, everything else is hashed already.
+            // The signature covers the compressed payload, which always arrives in order.
+            if (t_boot_signature_finish(&p_fw_status->sign, p_fw_status->signature, p_fw_status->fw_header.size,
+                                        compressed ? NULL : m_boot.p_current_dfu_target->read,
+                                        m_boot.p_config->verify_signature_fn) != 0)
+            {
+                error_code = T_BOOT_DFU_ERROR_SIGNATURE;
+                goto error_failed;
+            }
+#endif
+
+            // Nothing left to resume
+            save_checkpoint(p_fw_status, 0);
+
             if (m_boot.p_config->update_component_done_fn)
             {
                 m_boot.p_config->update_component_done_fn(p_chunk_header->component_id);
@@ -506,6 +774,8 @@ int t_boot_dfu_sequential_process_chunk(uint8_t *p_buffer, uint16_t length)
             }
 
             m_boot.p_current_dfu_target = NULL;
+            m_boot.compressed           = (p_fw_header->component_id & T_BOOT_DFU_COMPONENT_COMPRESSED) != 0;
+            p_fw_header->component_id &= ~T_BOOT_DFU_COMPONENT_COMPRESSED;
 
             // Look up dfp from the list of pre-defined dfus
             for (int i = 0; i < m_boot.p_config->dfu_target_list_size; i++)
@@ -539,29 +809,24 @@ int t_boot_dfu_sequential_process_chunk(uint8_t *p_buffer, uint16_t length)
             m_boot.number_of_chunks = p_fw_header->chunks;
             m_boot.fw_size          = p_fw_header->size;
 
-            if (m_boot.p_current_dfu_target->prepare)
+            if (m_boot.compressed)
             {
-                m_boot.p_current_dfu_target->prepare(p_fw_header->size, p_fw_header->fw_crc32);
+#if T_BOOT_DFU_COMPRESSION
+                t_boot_compression_start(&m_compression, m_boot.p_current_dfu_target->write);
+#else
+                error_code = T_BOOT_DFU_ERROR_COMPRESSION;
+                goto error_failed;
+#endif
             }
 
-#if T_BOOT_DFU_SKIP_SIGNATURE == 0
-            memcpy(&signature[0], &buf[DFU_HEADER_LEN], 128);
-
-            /* Initialize it the SHA-1 Context */
-            /* Default Flags */
-            SHA1ctx_st.mFlags = E_HASH_DEFAULT;
-            /* 20 byte of output */
-            SHA1ctx_st.mTagSize = CRL_SHA1_SIZE;
-            /* Init SHA-1 */
-            if (SHA1_Init(&SHA1ctx_st))
+            if (m_boot.p_current_dfu_target->prepare)
             {
-                error_code = T_BOOT_DFU_ERROR_SIGNATURE;
-                goto error_failed;
+                m_boot.p_current_dfu_target->prepare(p_fw_header->size, p_fw_header->fw_crc32);
             }
 
-            mb_st.mSize = sizeof(preallocated_buffer);
-            mb_st.mUsed = 0;
-            mb_st.pmBuf = preallocated_buffer;
+#if T_BOOT_DFU_SKIP_SIGNATURE == 0
+            memcpy(signature, &p_buffer[DFU_HEADER_LEN], T_BOOT_DFU_SIGNATURE_SIZE);
+            t_boot_signature_start(&m_signature);
 #endif
             break;
         }
@@ -616,39 +881,23 @@ int t_boot_dfu_sequential_process_chunk(uint8_t *p_buffer, uint16_t length)
             }
 
 #if T_BOOT_DFU_SKIP_SIGNATURE == 0
-            // Verify signature
-            if (SHA1_Append(&SHA1ctx_st, &buf[DFU_HEADER_LEN], ch_h->len))
-            {
-                error_code = T_BOOT_DFU_ERROR_SIGNATURE;
-                goto error_failed;
-            }
+            t_boot_signature_update(&m_signature, &p_buffer[DFU_HEADER_LEN], p_chunk_header->length,
+                                    m_boot.bytes_written);
 
-            if (next_chunk > chunks)
+            // The last chunk is only written when the signature of the whole component is valid
+            if (m_boot.next_chunk == m_boot.number_of_chunks)
             {
-                /* If this is the las chunk, verification should be calculated first */
-                int32_t outputSize;
-                if (SHA1_Finish(&SHA1ctx_st, Digest, &outputSize))
-                {
-                    error_code = T_BOOT_DFU_ERROR_SIGNATURE;
-                    goto error_failed;
-                }
-
-                log_info("\r\n Verifying Hash ... sha1+ ");
-                uint32_t status = RSA_PKCS1v15_Verify(&PubKey_st, Digest, E_SHA1, signature, &mb_st);
-                if (status != SIGNATURE_VALID)
+                if (t_boot_signature_finish(&m_signature, signature, m_boot.fw_size, NULL,
+                                            m_boot.p_config->verify_signature_fn) != 0)
                 {
-                    log_info("FAILED");
                     error_code = T_BOOT_DFU_ERROR_SIGNATURE;
                     goto error_failed;
                 }
-                else
-                {
-                    log_info("OK ");
-                }
             }
 #endif
 
-            if (m_boot.p_current_dfu_target->write(&p_buffer[DFU_HEADER_LEN], p_chunk_header->length, 0u) != 0)
+            if (write_payload(m_boot.p_current_dfu_target, m_boot.compressed, &p_buffer[DFU_HEADER_LEN],
+                              p_chunk_header->length, 0u) != 0)
             {
                 error_code = T_BOOT_DFU_ERROR_WRITE;
                 goto error_failed;
@@ -666,6 +915,12 @@ int t_boot_dfu_sequential_process_chunk(uint8_t *p_buffer, uint16_t length)
             if (m_boot.next_chunk > m_boot.number_of_chunks)
             {
                 log_debug("All FW chunks received");
+                if (!is_payload_complete(m_boot.compressed))
+                {
+                    error_code = T_BOOT_DFU_ERROR_COMPRESSION;
+                    goto error_failed;
+                }
+
                 if (m_boot.p_current_dfu_target->verify)
                 {
                     if (m_boot.p_current_dfu_target->verify())
@@ -767,6 +1022,8 @@ const char *t_boot_dfu_get_error_desc(int error_code)
             return "Invalid file";
         case -T_BOOT_DFU_ERROR_WRITE:
             return "Write error";
+        case -T_BOOT_DFU_ERROR_COMPRESSION:
+            return "Compression";
         default:
             return "Unknown";
     }
@@ -7,6 +7,17 @@
 // Application specific configuration options
 #include "t_boot_config.h"
 
+#include "t_boot_signature.h"
+
+// Decompression of compressed components, needs a window of T_BOOT_COMPRESSION_WINDOW_SIZE bytes of RAM
+#ifndef T_BOOT_DFU_COMPRESSION
+#define T_BOOT_DFU_COMPRESSION 0
+#endif
+
+#if T_BOOT_DFU_COMPRESSION
+#include "t_boot_compression.h"
+#endif
+
 #ifndef T_BOOT_DFU_CHUNK_SIZE
 #define T_BOOT_DFU_CHUNK_SIZE 512
 #endif
@@ -28,8 +39,13 @@ typedef enum
     T_BOOT_DFU_COMPONENT_ID_MCU_BANK0 = 6,
     T_BOOT_DFU_COMPONENT_ID_MCU_BANK1 = 7,
     T_BOOT_DFU_COMPONENT_ID_DAB       = 8,
+    T_BOOT_DFU_COMPONENT_ID_MCU_DELTA = 9, // Delta image against the installed MCU firmware
 } t_boot_dfu_component_id_t;
 
+// Set in the component ID of the FW header and of the chunks when the payload is compressed
+// with scripts/compress.py, the DFU target receives the decompressed firmware
+#define T_BOOT_DFU_COMPONENT_COMPRESSED 0x80
+
 // clang-format off
 #define T_BOOT_DFU_ERROR_PACKET_LEN             (1)
 #define T_BOOT_DFU_ERROR_PRODUCT_ID             (2)
@@ -43,6 +59,7 @@ typedef enum
 #define T_BOOT_DFU_ERROR_VERIFICATION           (10)
 #define T_BOOT_DFU_ERROR_INVALID_FILE           (11)
 #define T_BOOT_DFU_ERROR_WRITE                  (12)
+#define T_BOOT_DFU_ERROR_COMPRESSION            (13)
 // clang-format on
 
 typedef struct
@@ -55,8 +72,21 @@ typedef struct
     int (*init)(void);              // Optional field (can be NULL)
     int (*verify)(void);            // Optional field (can be NULL)
     uint32_t (*get_crc32)(void);    // Optional field (can be NULL)
+    int (*read)(uint8_t *data, uint32_t len, uint32_t offset); // Optional field (can be NULL)
+    // Optional field (can be NULL), needs read: continues an interrupted update. Keeps the firmware below the
+    // returned offset (at most offset), erases the rest and returns the offset writing continues from.
+    uint32_t (*resume)(uint32_t offset);
 } t_boot_dfu_target_t;
 
+// Progress of an update which survives a reset, only in non-sequential mode
+typedef struct
+{
+    uint8_t  component_id;
+    uint32_t fw_size;
+    uint32_t fw_crc32; // from the FW header, identifies the firmware
+    uint32_t offset;   // everything below is programmed and verified, 0 if there is no checkpoint
+} t_boot_dfu_checkpoint_t;
+
 /**
  * @brief Function to call when an update starts.
  *
@@ -84,6 +114,19 @@ typedef void (*t_boot_update_progress_callback_t)(t_boot_dfu_component_id_t comp
  */
 typedef void (*t_boot_update_component_done_callback_t)(t_boot_dfu_component_id_t component_id);
 
+/**
+ * @brief Function to call to store a checkpoint persistently, called for every chunk which extends the programmed
+ *        part of a component. A checkpoint with offset 0 clears it.
+ */
+typedef void (*t_boot_checkpoint_save_callback_t)(const t_boot_dfu_checkpoint_t *p_checkpoint);
+
+/**
+ * @brief Function to call to get the stored checkpoint.
+ *
+ * @return true if there is a checkpoint, false otherwise
+ */
+typedef bool (*t_boot_checkpoint_load_callback_t)(t_boot_dfu_checkpoint_t *p_checkpoint);
+
 typedef struct
 {
     const t_boot_dfu_target_t *p_dfu_target_list;
@@ -93,6 +136,9 @@ typedef struct
     t_boot_update_error_callback_t update_error_fn;
     t_boot_update_progress_callback_t update_progress_fn;
     t_boot_update_component_done_callback_t update_component_done_fn;
+    t_boot_verify_signature_callback_t verify_signature_fn; // Mandatory unless T_BOOT_DFU_SKIP_SIGNATURE is set
+    t_boot_checkpoint_save_callback_t checkpoint_save_fn;   // Optional, resuming needs both checkpoint fns
+    t_boot_checkpoint_load_callback_t checkpoint_load_fn;
 } t_boot_config_t;
 
 #if defined(__cplusplus)
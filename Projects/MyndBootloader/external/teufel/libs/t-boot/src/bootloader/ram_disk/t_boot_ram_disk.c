@@ -23,7 +23,12 @@
 #define ROOT_ENTRY_LENGTH       32
 #define FILEDATA_START_CLUSTER  2
 
-#define DATA_REGION_SECTOR      (RESERVED_SECTORS + (FAT_COPIES * 127) + \
+#define FAT_SECTORS             127
+#define FAT1_START_SECTOR       RESERVED_SECTORS
+#define FAT2_START_SECTOR       (FAT1_START_SECTOR + FAT_SECTORS)
+#define ROOT_DIR_START_SECTOR   (RESERVED_SECTORS + (FAT_COPIES * FAT_SECTORS))
+
+#define DATA_REGION_SECTOR      (ROOT_DIR_START_SECTOR + \
                                 (ROOT_ENTRIES * ROOT_ENTRY_LENGTH) / SECTOR_SIZE)
 
 #define FILEDATA_START_SECTOR   (DATA_REGION_SECTOR + \
@@ -124,6 +129,29 @@ typedef struct __attribute__((__packed__))
 
 static uint8_t ramdata[T_BOOT_RAM_DISK_SIZE];
 
+// Double buffer between the USB interrupt (producer) and the main loop (consumer): a chunk is copied
+// into a free buffer and acknowledged to the host right away, while the previous one is programmed.
+#define SECTOR_BUFFER_COUNT 2
+
+static struct
+{
+    uint8_t           data[SECTOR_BUFFER_COUNT][SECTOR_SIZE] __attribute__((aligned(4)));
+    volatile uint8_t  head; // Written by the USB interrupt only
+    volatile uint8_t  tail; // Written by the main loop only
+} sector_buffers;
+
+// Boot, FAT and directory sectors written by the host. They are read back by some hosts, e.g. to check a
+// directory entry after creating the file, and the generated content would undo the write.
+#if T_BOOT_RAM_DISK_CACHE_SECTORS > 0
+static struct
+{
+    uint8_t  data[T_BOOT_RAM_DISK_CACHE_SECTORS][SECTOR_SIZE];
+    uint32_t sector[T_BOOT_RAM_DISK_CACHE_SECTORS];
+    uint32_t last_use[T_BOOT_RAM_DISK_CACHE_SECTORS]; // 0 if unused
+    uint32_t use_count;
+} metadata_cache;
+#endif
+
 // The size of root dir always 512 bytes for all these projects.
 // This reference was created by mkfs.fat util.
 // clang-format off
@@ -180,63 +208,197 @@ int t_boot_ram_disk_add_file(const char *name, const char *extension, const uint
     return 0;
 }
 
-int t_boot_ram_disk_read_block(uint8_t *p_buffer, uint32_t block_address, uint16_t block_length)
+// Both FAT copies are kept the same, so the second one is cached as the first
+static uint32_t get_metadata_sector(uint32_t block_address)
+{
+    if ((block_address >= FAT2_START_SECTOR) && (block_address < ROOT_DIR_START_SECTOR))
+    {
+        return block_address - FAT_SECTORS;
+    }
+
+    return block_address;
+}
+
+#if T_BOOT_RAM_DISK_CACHE_SECTORS > 0
+static uint8_t *find_cached(uint32_t block_address)
+{
+    uint32_t sector = get_metadata_sector(block_address);
+
+    for (uint8_t i = 0; i < T_BOOT_RAM_DISK_CACHE_SECTORS; i++)
+    {
+        if ((metadata_cache.last_use[i] != 0) && (metadata_cache.sector[i] == sector))
+        {
+            metadata_cache.last_use[i] = ++metadata_cache.use_count;
+            return metadata_cache.data[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void cache_metadata(const uint8_t *p_buffer, uint32_t block_address)
 {
-    // TODO: We should be using block_length here
-    (void) block_length;
+    uint8_t *p_cached = find_cached(block_address);
+
+    if (p_cached == NULL)
+    {
+        // Unused entries have the oldest use
+        uint8_t lru = 0;
+        for (uint8_t i = 1; i < T_BOOT_RAM_DISK_CACHE_SECTORS; i++)
+        {
+            if (metadata_cache.last_use[i] < metadata_cache.last_use[lru])
+            {
+                lru = i;
+            }
+        }
+
+        metadata_cache.sector[lru]   = get_metadata_sector(block_address);
+        metadata_cache.last_use[lru] = ++metadata_cache.use_count;
+        p_cached                     = metadata_cache.data[lru];
+    }
+
+    memcpy(p_cached, p_buffer, SECTOR_SIZE);
+}
+#endif
+
+static void read_sector(uint8_t *p_buffer, uint32_t block_address)
+{
+#if T_BOOT_RAM_DISK_CACHE_SECTORS > 0
+    if (block_address < DATA_REGION_SECTOR)
+    {
+        const uint8_t *p_cached = find_cached(block_address);
+        if (p_cached != NULL)
+        {
+            memcpy(p_buffer, p_cached, SECTOR_SIZE);
+            return;
+        }
+    }
+#endif
+
+    // Filesystem data access: reads outside the files give zeros
+    if ((block_address >= FILEDATA_START_SECTOR) && (block_address < FILEDATA_START_SECTOR + FILEDATA_SECTOR_COUNT))
+    {
+        memcpy(p_buffer, ramdata + (block_address - FILEDATA_START_SECTOR) * SECTOR_SIZE, SECTOR_SIZE);
+        return;
+    }
 
-    // TODO: Make sure that the buffer is at least SECTOR_SIZE bytes long
-    memset(p_buffer, 0, SECTOR_SIZE);
     switch (block_address)
     {
-        case 0:   // sector 0 is the boot sector
+        case 0: // the boot sector
             memcpy(p_buffer, BootSector, sizeof(BootSector));
+            memset(p_buffer + sizeof(BootSector), 0, SECTOR_SIZE - sizeof(BootSector));
             p_buffer[SECTOR_SIZE - 2] = 0x55;
             p_buffer[SECTOR_SIZE - 1] = 0xAA;
             break;
-        case 1:   // sector 1 is FAT 1st copy
-        case 127: // sector 2 is FAT 2nd copy
+        case FAT1_START_SECTOR:
+        case FAT2_START_SECTOR:
             memcpy(p_buffer, FatSector, sizeof(FatSector));
+            memset(p_buffer + sizeof(FatSector), 0, SECTOR_SIZE - sizeof(FatSector));
             break;
-        case 255: // sector 3 is the directory entry
+        case ROOT_DIR_START_SECTOR:
             memcpy(p_buffer, DirSector, sizeof(DirSector));
             break;
         default:
-            // Filesystem data access: ignore reads outside the data section
-            if (block_address >= FILEDATA_START_SECTOR && block_address < FILEDATA_START_SECTOR + FILEDATA_SECTOR_COUNT)
-            {
-                memcpy(p_buffer, ramdata + (block_address - FILEDATA_START_SECTOR) * SECTOR_SIZE, SECTOR_SIZE);
-            }
+            memset(p_buffer, 0, SECTOR_SIZE);
             break;
     }
+}
+
+int t_boot_ram_disk_read_block(uint8_t *p_buffer, uint32_t block_address, uint16_t block_length)
+{
+    for (uint16_t i = 0; i < block_length; i++)
+    {
+        read_sector(p_buffer + i * SECTOR_SIZE, block_address + i);
+    }
 
     return 0;
 }
 
+// Firmware file data is recognized by the chunk magic, chunks sent again while an update runs are skipped
+static bool is_dfu_chunk(const uint8_t *p_buffer, uint32_t block_address, uint32_t *p_last_address)
+{
+    uint32_t magic;
+    memcpy(&magic, p_buffer, sizeof(magic));
+
+    if (magic != 0xbeefcafe)
+    {
+        return false;
+    }
+
+    if (t_boot_dfu_is_busy() && (block_address <= *p_last_address))
+    {
+        return false;
+    }
+
+    *p_last_address = block_address;
+    return true;
+}
+
 int t_boot_ram_disk_write_block(uint8_t *p_buffer, uint32_t block_address, uint16_t block_length)
 {
     static uint32_t saved_addr = 0;
 
-    if (t_boot_dfu_is_busy())
+    uint32_t last_address = saved_addr;
+    uint8_t  chunks       = 0;
+
+    // All or none of the chunks of a block are taken, the host repeats a failed write as a whole
+    for (uint16_t i = 0; i < block_length; i++)
     {
-        if (block_address <= saved_addr)
+        if ((block_address + i >= DATA_REGION_SECTOR) &&
+            is_dfu_chunk(p_buffer + i * SECTOR_SIZE, block_address + i, &last_address))
         {
-            return 0;
+            chunks++;
         }
+    }
 
-        saved_addr = block_address;
+    // The USB driver holds the host back before all buffers are taken, see t_boot_ram_disk_can_receive()
+    if (chunks > (uint8_t) (SECTOR_BUFFER_COUNT - (uint8_t) (sector_buffers.head - sector_buffers.tail)))
+    {
+        return -1;
     }
 
-    uint32_t magic = *((uint32_t *)p_buffer);
-    if (magic != 0xbeefcafe)
+    for (uint16_t i = 0; i < block_length; i++)
     {
-        return 0;
+        const uint8_t *p_sector = p_buffer + i * SECTOR_SIZE;
+
+        if (block_address + i < DATA_REGION_SECTOR)
+        {
+#if T_BOOT_RAM_DISK_CACHE_SECTORS > 0
+            cache_metadata(p_sector, block_address + i);
+#endif
+            continue;
+        }
+
+        // The one copy out of the buffer of the MSC class, it is reused for the next block
+        if (is_dfu_chunk(p_sector, block_address + i, &saved_addr))
+        {
+            memcpy(sector_buffers.data[sector_buffers.head % SECTOR_BUFFER_COUNT], p_sector, SECTOR_SIZE);
+            sector_buffers.head++;
+        }
     }
 
-    t_boot_dfu_process_chunk(p_buffer, block_length);
     return 0;
 }
 
+bool t_boot_ram_disk_can_receive(void)
+{
+    return (uint8_t) (sector_buffers.head - sector_buffers.tail) < SECTOR_BUFFER_COUNT;
+}
+
+int t_boot_ram_disk_process(void)
+{
+    if (sector_buffers.head == sector_buffers.tail)
+    {
+        return 0;
+    }
+
+    uint8_t index = sector_buffers.tail % SECTOR_BUFFER_COUNT;
+    t_boot_dfu_process_chunk(sector_buffers.data[index], SECTOR_SIZE);
+    sector_buffers.tail++;
+
+    return 1;
+}
+
 void t_boot_ram_disk_get_capacity(uint32_t *p_number_of_blocks, uint16_t *p_block_size)
 {
     // BLOCK_SIZE equals to SECTOR_SIZE
@@ -1,8 +1,14 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "t_boot_config.h"
 
+// Boot, FAT and directory sectors written by the host which are kept to be read back, 0 disables the cache
+#ifndef T_BOOT_RAM_DISK_CACHE_SECTORS
+#define T_BOOT_RAM_DISK_CACHE_SECTORS 2
+#endif
+
 /**
  * @brief Creates a file in dynamic area with a given name and extension.
  * @note  Name and extension must be given in capital letters.
@@ -17,6 +23,41 @@
  */
 int t_boot_ram_disk_add_file(const char *name, const char *extension, const uint8_t *p_data, uint32_t length);
 
+/**
+ * @brief Reads sectors of the disk.
+ *
+ * @param[out] p_buffer         pointer to block_length * 512 bytes
+ * @param[in] block_address     first sector
+ * @param[in] block_length      number of sectors
+ *
+ * @return 0 if successful, -1 otherwise
+ */
 int t_boot_ram_disk_read_block(uint8_t *p_buffer, uint32_t block_address, uint16_t block_length);
+
+/**
+ * @brief Takes sectors written by the host.
+ * @note  Called from the USB interrupt. DFU chunks are only copied into a free sector buffer and
+ *        processed later by t_boot_ram_disk_process(), so the host can send the next block while
+ *        the previous one is being programmed. Boot, FAT and directory sectors go to the cache,
+ *        other data is dropped.
+ *
+ * @return 0 if successful, -1 if not enough sector buffers were free for the chunks
+ */
 int t_boot_ram_disk_write_block(uint8_t *p_buffer, uint32_t block_address, uint16_t block_length);
+
+/**
+ * @brief Checks if a sector buffer is free for the next block.
+ * @note  The USB driver stops receiving from the host (NAK) while this returns false.
+ *
+ * @return true if the next block can be received, false otherwise
+ */
+bool t_boot_ram_disk_can_receive(void);
+
+/**
+ * @brief Processes the oldest DFU chunk received, to be called from the main loop.
+ *
+ * @return 1 if a chunk was processed, 0 if there was nothing to do
+ */
+int t_boot_ram_disk_process(void);
+
 void t_boot_ram_disk_get_capacity(uint32_t *p_number_of_blocks, uint16_t *p_block_size);
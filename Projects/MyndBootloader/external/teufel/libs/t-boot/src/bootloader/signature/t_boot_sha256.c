@@ -0,0 +1,147 @@
+#include <string.h>
+
+#include "t_boot_sha256.h"
+
+// Sized for Cortex-M0: the rounds are not unrolled and the message schedule is kept in a 16 word
+// window instead of the full 64 words. The constants stay in flash, RAM use is the 64 byte window
+// plus the working variables.
+
+static const uint32_t k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+// Compiles to a single ROR on Thumb
+__attribute__((always_inline)) static inline uint32_t ror(uint32_t x, uint32_t n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+static void process_block(uint32_t *p_state, const uint8_t *p_block)
+{
+    uint32_t w[16];
+    uint32_t a = p_state[0], b = p_state[1], c = p_state[2], d = p_state[3];
+    uint32_t e = p_state[4], f = p_state[5], g = p_state[6], h = p_state[7];
+
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        uint32_t wi;
+        if (i < 16)
+        {
+            wi = ((uint32_t) p_block[4 * i] << 24) | ((uint32_t) p_block[4 * i + 1] << 16) |
+                 ((uint32_t) p_block[4 * i + 2] << 8) | (uint32_t) p_block[4 * i + 3];
+        }
+        else
+        {
+            uint32_t w15 = w[(i - 15) & 15];
+            uint32_t w2  = w[(i - 2) & 15];
+            wi           = w[i & 15] + (ror(w15, 7) ^ ror(w15, 18) ^ (w15 >> 3)) + w[(i - 7) & 15] +
+                 (ror(w2, 17) ^ ror(w2, 19) ^ (w2 >> 10));
+        }
+        w[i & 15] = wi;
+
+        uint32_t t1 = h + (ror(e, 6) ^ ror(e, 11) ^ ror(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + wi;
+        uint32_t t2 = (ror(a, 2) ^ ror(a, 13) ^ ror(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    p_state[0] += a;
+    p_state[1] += b;
+    p_state[2] += c;
+    p_state[3] += d;
+    p_state[4] += e;
+    p_state[5] += f;
+    p_state[6] += g;
+    p_state[7] += h;
+}
+
+void t_boot_sha256_init(t_boot_sha256_ctx_t *p_ctx)
+{
+    p_ctx->state[0] = 0x6a09e667;
+    p_ctx->state[1] = 0xbb67ae85;
+    p_ctx->state[2] = 0x3c6ef372;
+    p_ctx->state[3] = 0xa54ff53a;
+    p_ctx->state[4] = 0x510e527f;
+    p_ctx->state[5] = 0x9b05688c;
+    p_ctx->state[6] = 0x1f83d9ab;
+    p_ctx->state[7] = 0x5be0cd19;
+    p_ctx->length   = 0;
+}
+
+void t_boot_sha256_update(t_boot_sha256_ctx_t *p_ctx, const uint8_t *p_data, size_t length)
+{
+    uint32_t used = p_ctx->length % T_BOOT_SHA256_BLOCK_SIZE;
+
+    p_ctx->length += length;
+
+    // Fill up a partial block first
+    if (used != 0)
+    {
+        uint32_t n = T_BOOT_SHA256_BLOCK_SIZE - used;
+        if (n > length)
+        {
+            n = length;
+        }
+        memcpy(&p_ctx->block[used], p_data, n);
+        p_data += n;
+        length -= n;
+        if (used + n < T_BOOT_SHA256_BLOCK_SIZE)
+        {
+            return;
+        }
+        process_block(p_ctx->state, p_ctx->block);
+    }
+
+    // Whole blocks are hashed straight from the input without copying
+    for (; length >= T_BOOT_SHA256_BLOCK_SIZE; length -= T_BOOT_SHA256_BLOCK_SIZE, p_data += T_BOOT_SHA256_BLOCK_SIZE)
+    {
+        process_block(p_ctx->state, p_data);
+    }
+
+    memcpy(p_ctx->block, p_data, length);
+}
+
+void t_boot_sha256_final(t_boot_sha256_ctx_t *p_ctx, uint8_t *p_digest)
+{
+    uint32_t used = p_ctx->length % T_BOOT_SHA256_BLOCK_SIZE;
+    uint32_t bits_high = p_ctx->length >> 29;
+    uint32_t bits_low  = p_ctx->length << 3;
+
+    p_ctx->block[used++] = 0x80;
+    if (used > T_BOOT_SHA256_BLOCK_SIZE - 8)
+    {
+        memset(&p_ctx->block[used], 0, T_BOOT_SHA256_BLOCK_SIZE - used);
+        process_block(p_ctx->state, p_ctx->block);
+        used = 0;
+    }
+    memset(&p_ctx->block[used], 0, T_BOOT_SHA256_BLOCK_SIZE - 8 - used);
+
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        p_ctx->block[56 + i] = (uint8_t) (bits_high >> (24 - 8 * i));
+        p_ctx->block[60 + i] = (uint8_t) (bits_low >> (24 - 8 * i));
+    }
+    process_block(p_ctx->state, p_ctx->block);
+
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        p_digest[4 * i]     = (uint8_t) (p_ctx->state[i] >> 24);
+        p_digest[4 * i + 1] = (uint8_t) (p_ctx->state[i] >> 16);
+        p_digest[4 * i + 2] = (uint8_t) (p_ctx->state[i] >> 8);
+        p_digest[4 * i + 3] = (uint8_t) p_ctx->state[i];
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define T_BOOT_SHA256_DIGEST_SIZE 32
+#define T_BOOT_SHA256_BLOCK_SIZE  64
+
+typedef struct
+{
+    uint32_t state[8];
+    uint32_t length; // total bytes hashed, images are far below 4 GB
+    uint8_t  block[T_BOOT_SHA256_BLOCK_SIZE];
+} t_boot_sha256_ctx_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Starts a new SHA-256 computation.
+ *
+ * @param[out] p_ctx            pointer to context
+ */
+void t_boot_sha256_init(t_boot_sha256_ctx_t *p_ctx);
+
+/**
+ * @brief Hashes the next part of the message, the parts can have any length.
+ *
+ * @param[inout] p_ctx          pointer to context
+ * @param[in] p_data            pointer to data
+ * @param[in] length            length of data
+ */
+void t_boot_sha256_update(t_boot_sha256_ctx_t *p_ctx, const uint8_t *p_data, size_t length);
+
+/**
+ * @brief Finishes the computation, the context has to be initialized again before it's reused.
+ *
+ * @param[inout] p_ctx          pointer to context
+ * @param[out] p_digest         pointer to T_BOOT_SHA256_DIGEST_SIZE bytes
+ */
+void t_boot_sha256_final(t_boot_sha256_ctx_t *p_ctx, uint8_t *p_digest);
+
+#if defined(__cplusplus)
+}
+#endif
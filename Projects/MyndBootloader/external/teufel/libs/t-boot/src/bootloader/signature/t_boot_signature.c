@@ -0,0 +1,54 @@
+#include "t_boot_signature.h"
+
+// Bytes read back from the target per step when chunks arrived out of order
+#define READ_BACK_SIZE 64
+
+void t_boot_signature_start(t_boot_signature_t *p_sign)
+{
+    t_boot_sha256_init(&p_sign->sha256);
+    p_sign->bytes_hashed = 0;
+}
+
+void t_boot_signature_update(t_boot_signature_t *p_sign, const uint8_t *p_data, uint32_t length, uint32_t offset)
+{
+    if (offset != p_sign->bytes_hashed)
+    {
+        return;
+    }
+
+    t_boot_sha256_update(&p_sign->sha256, p_data, length);
+    p_sign->bytes_hashed += length;
+}
+
+int t_boot_signature_finish(t_boot_signature_t *p_sign, const uint8_t *p_signature, uint32_t fw_size,
+                            t_boot_signature_read_fn_t read_fn, t_boot_verify_signature_callback_t verify_fn)
+{
+    uint8_t digest[T_BOOT_SHA256_DIGEST_SIZE];
+
+    if (verify_fn == NULL)
+    {
+        return -1;
+    }
+
+    // Catch up with the part behind the first gap, only needed if the host wrote out of order
+    while (p_sign->bytes_hashed < fw_size)
+    {
+        uint8_t  buffer[READ_BACK_SIZE];
+        uint32_t length = fw_size - p_sign->bytes_hashed;
+        if (length > sizeof(buffer))
+        {
+            length = sizeof(buffer);
+        }
+
+        if ((read_fn == NULL) || (read_fn(buffer, length, p_sign->bytes_hashed) != 0))
+        {
+            return -1;
+        }
+        t_boot_sha256_update(&p_sign->sha256, buffer, length);
+        p_sign->bytes_hashed += length;
+    }
+
+    t_boot_sha256_final(&p_sign->sha256, digest);
+
+    return verify_fn(digest, p_signature, T_BOOT_DFU_SIGNATURE_SIZE) == 0 ? 0 : -1;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "t_boot_sha256.h"
+
+// RSA-1024 signature, as stored behind the FW header
+#ifndef T_BOOT_DFU_SIGNATURE_SIZE
+#define T_BOOT_DFU_SIGNATURE_SIZE 128
+#endif
+
+/**
+ * @brief Checks a firmware signature against the SHA-256 digest of the firmware.
+ *
+ * @param[in] p_digest          pointer to T_BOOT_SHA256_DIGEST_SIZE bytes
+ * @param[in] p_signature       pointer to signature
+ * @param[in] signature_length  length of signature
+ *
+ * @return 0 if the signature is valid, -1 otherwise
+ */
+typedef int (*t_boot_verify_signature_callback_t)(const uint8_t *p_digest, const uint8_t *p_signature,
+                                                  size_t signature_length);
+
+/**
+ * @brief Reads back already written firmware data from a DFU target.
+ *
+ * @return 0 if successful, -1 otherwise
+ */
+typedef int (*t_boot_signature_read_fn_t)(uint8_t *p_data, uint32_t length, uint32_t offset);
+
+typedef struct
+{
+    t_boot_sha256_ctx_t sha256;
+    uint32_t            bytes_hashed;
+} t_boot_signature_t;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Starts the verification of a firmware component.
+ *
+ * @param[out] p_sign           pointer to verification context
+ */
+void t_boot_signature_start(t_boot_signature_t *p_sign);
+
+/**
+ * @brief Hashes a chunk of plain firmware data as it arrives.
+ * @note  Chunks which arrive ahead of the hashed part are skipped and read back from the target in
+ *        t_boot_signature_finish(), chunks in order are never touched again.
+ *
+ * @param[inout] p_sign         pointer to verification context
+ * @param[in] p_data            pointer to chunk data
+ * @param[in] length            length of chunk data
+ * @param[in] offset            offset of the chunk in the firmware
+ */
+void t_boot_signature_update(t_boot_signature_t *p_sign, const uint8_t *p_data, uint32_t length, uint32_t offset);
+
+/**
+ * @brief Finishes the digest and checks the signature.
+ *
+ * @param[inout] p_sign         pointer to verification context
+ * @param[in] p_signature       pointer to T_BOOT_DFU_SIGNATURE_SIZE bytes of signature
+ * @param[in] fw_size           size of the firmware component
+ * @param[in] read_fn           reads back chunks which were not hashed in order, can be NULL
+ * @param[in] verify_fn         signature check
+ *
+ * @return 0 if the signature is valid, -1 otherwise
+ */
+int t_boot_signature_finish(t_boot_signature_t *p_sign, const uint8_t *p_signature, uint32_t fw_size,
+                            t_boot_signature_read_fn_t read_fn, t_boot_verify_signature_callback_t verify_fn);
+
+#if defined(__cplusplus)
+}
+#endif
@@ -0,0 +1,37 @@
+#include "crypto.h"
+#include "t_boot_signature_rsa.h"
+
+/* buffer required for internal allocation of memory */
+static uint8_t preallocated_buffer[1024];
+
+/* Inject RSA public key here */
+extern const uint8_t T1_Modulus[128];
+extern const uint8_t T1_pubExp[3];
+
+static const RSApubKey_stt PubKey_st = {
+    .mExponentSize = sizeof(T1_pubExp),
+    .mModulusSize  = sizeof(T1_Modulus),
+    .pmExponent    = (uint8_t *) T1_pubExp,
+    .pmModulus     = (uint8_t *) T1_Modulus,
+};
+
+int t_boot_signature_rsa_verify(const uint8_t *p_digest, const uint8_t *p_signature, size_t signature_length)
+{
+    membuf_stt mb_st = {
+        .pmBuf = preallocated_buffer,
+        .mSize = sizeof(preallocated_buffer),
+        .mUsed = 0,
+    };
+
+    if (signature_length != sizeof(T1_Modulus))
+    {
+        return -1;
+    }
+
+    if (RSA_PKCS1v15_Verify(&PubKey_st, p_digest, E_SHA256, p_signature, &mb_st) != SIGNATURE_VALID)
+    {
+        return -1;
+    }
+
+    return 0;
+}
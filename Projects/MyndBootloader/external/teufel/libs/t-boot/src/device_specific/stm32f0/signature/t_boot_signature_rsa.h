@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/**
+ * @brief Checks an RSA PKCS#1 v1.5 signature over a SHA-256 digest with the ST crypto library.
+ *        Can be used as verify_signature_fn of the t-boot configuration.
+ *
+ * @param[in] p_digest          pointer to SHA-256 digest
+ * @param[in] p_signature       pointer to signature
+ * @param[in] signature_length  length of signature, the size of the modulus
+ *
+ * @return 0 if the signature is valid, -1 otherwise
+ */
+int t_boot_signature_rsa_verify(const uint8_t *p_digest, const uint8_t *p_signature, size_t signature_length);
+
+#if defined(__cplusplus)
+}
+#endif
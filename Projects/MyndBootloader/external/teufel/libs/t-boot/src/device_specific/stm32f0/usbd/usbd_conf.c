@@ -1,6 +1,7 @@
 #include "stm32f0xx_hal.h"
 #include "usbd_core.h"
 #include "usbd_msc.h"
+#include "usbd_storage.h"
 
 PCD_HandleTypeDef hpcd;
 
@@ -301,6 +302,12 @@ USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev, uint8_t ep_addr, u
  */
 USBD_StatusTypeDef USBD_LL_PrepareReceive(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *pbuf, uint16_t size)
 {
+    // Back-pressure: the endpoint keeps NAKing while both sector buffers wait to be programmed
+    if (usbd_storage_hold_receive(pdev, ep_addr, pbuf, size))
+    {
+        return USBD_OK;
+    }
+
     HAL_PCD_EP_Receive((PCD_HandleTypeDef *) pdev->pData, ep_addr, pbuf, size);
     return USBD_OK;
 }
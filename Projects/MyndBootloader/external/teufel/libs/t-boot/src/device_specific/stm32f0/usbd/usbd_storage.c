@@ -30,6 +30,16 @@ USBD_StorageTypeDef USBD_DISK_fops = {
     STORAGE_Init, STORAGE_GetCapacity, STORAGE_IsReady,   STORAGE_IsWriteProtected,
     STORAGE_Read, STORAGE_Write,       STORAGE_GetMaxLun, STORAGE_Inquirydata,
 };
+
+/* Reception of the next block held back until the RAM disk has a free sector buffer */
+static struct
+{
+    USBD_HandleTypeDef *pdev;
+    uint8_t            *pbuf;
+    uint16_t            size;
+    uint8_t             ep_addr;
+    bool                held;
+} rx_hold;
 /* Private functions ---------------------------------------------------------*/
 
 /**
@@ -126,3 +136,35 @@ int8_t STORAGE_GetMaxLun(void)
 {
     return (STORAGE_LUN_NBR - 1);
 }
+
+bool usbd_storage_hold_receive(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *pbuf, uint16_t size)
+{
+    if (ep_addr != MSC_EPOUT_ADDR || t_boot_ram_disk_can_receive())
+    {
+        return false;
+    }
+
+    rx_hold.pdev    = pdev;
+    rx_hold.ep_addr = ep_addr;
+    rx_hold.pbuf    = pbuf;
+    rx_hold.size    = size;
+    rx_hold.held    = true;
+    return true;
+}
+
+void usbd_storage_process(void)
+{
+    if (t_boot_ram_disk_process() == 0)
+    {
+        return;
+    }
+
+    // The USB interrupt must not hold the reception between the check and the resume
+    __disable_irq();
+    if (rx_hold.held)
+    {
+        rx_hold.held = false;
+        USBD_LL_PrepareReceive(rx_hold.pdev, rx_hold.ep_addr, rx_hold.pbuf, rx_hold.size);
+    }
+    __enable_irq();
+}
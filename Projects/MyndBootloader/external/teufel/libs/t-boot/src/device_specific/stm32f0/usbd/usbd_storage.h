@@ -1,8 +1,24 @@
 #ifndef __USBD_STORAGE_H__
 #define __USBD_STORAGE_H__
 
+#include <stdbool.h>
+
 #include "usbd_msc.h"
 
 extern USBD_StorageTypeDef USBD_DISK_fops;
 
+/**
+ * @brief  Holds back the reception of the next MSC block while the RAM disk has no free sector buffer.
+ * @note   Called by USBD_LL_PrepareReceive(), the endpoint NAKs the host until usbd_storage_process() arms it.
+ * @retval true if the reception was held back, false if the endpoint can be armed
+ */
+bool usbd_storage_hold_receive(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *pbuf, uint16_t size);
+
+/**
+ * @brief  Processes the blocks received by the RAM disk and resumes a held back reception.
+ * @note   To be called from the main loop.
+ * @retval None
+ */
+void usbd_storage_process(void);
+
 #endif /* __USBD_STORAGE_H__ */
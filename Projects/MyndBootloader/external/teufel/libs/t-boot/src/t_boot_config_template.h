@@ -17,3 +17,6 @@
 
 // Encryption key
 #define T_BOOT_ENCRYPTION_KEY           "TEUFELDEV"
+
+// Image CRC check before the application is started: 0 off, 1 images with a trailer, 2 all images
+#define T_BOOT_APP_CRC_CHECK            0
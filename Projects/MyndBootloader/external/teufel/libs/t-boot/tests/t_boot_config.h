@@ -17,4 +17,10 @@
 #define T_BOOT_ENCRYPTION_KEY           "TEUFELDEV"
 
 // Non-sequential mode
-#define T_BOOT_DFU_NON_SEQUENTIAL_MODE  1
\ No newline at end of file
+#define T_BOOT_DFU_NON_SEQUENTIAL_MODE  1
+
+// Decompression of compressed components
+#define T_BOOT_DFU_COMPRESSION          1
+
+// Image CRC check of the application, only for images with a trailer
+#define T_BOOT_APP_CRC_CHECK            1
@@ -0,0 +1,185 @@
+#include <string.h>
+
+#include "t_boot_crc.h"
+#include "t_boot_sim.h"
+
+typedef struct __attribute__((__packed__))
+{
+    uint32_t magic;
+    uint8_t  packet_type;
+    uint8_t  number_of_dfu_components;
+    uint8_t  reserved;
+    uint8_t  flags;
+    uint32_t product_type;
+    uint32_t product_id;
+} dfu_header_t;
+
+typedef struct __attribute__((__packed__))
+{
+    uint32_t magic;
+    uint8_t  packet_type;
+    uint8_t  component_id;
+    uint16_t chunks;
+    uint32_t size;
+    uint32_t fw_crc32;
+} fw_header_t;
+
+typedef struct __attribute__((__packed__))
+{
+    uint32_t magic;
+    uint8_t  packet_type;
+    uint8_t  component_id;
+    uint16_t chunk_number;
+    uint32_t length;
+    uint32_t chunk_crc32;
+} chunk_header_t;
+
+t_boot_sim_t t_boot_sim;
+uint8_t      t_boot_sim_flash[APP_FLASH_SIZE];
+
+static void (*m_flash_busy_fn)(void);
+
+static void flash_advance(uint64_t ns)
+{
+    t_boot_sim.now_ns += ns;
+    if (m_flash_busy_fn != NULL)
+    {
+        m_flash_busy_fn();
+    }
+}
+
+static void erase_from(uint32_t offset)
+{
+    for (uint32_t page = offset / FLASH_PAGE_SIZE; page < APP_FLASH_SIZE / FLASH_PAGE_SIZE; page++)
+    {
+        memset(&t_boot_sim_flash[page * FLASH_PAGE_SIZE], 0xFF, FLASH_PAGE_SIZE);
+        flash_advance(FLASH_ERASE_PAGE_NS);
+    }
+}
+
+void t_boot_sim_init(void (*flash_busy_fn)(void))
+{
+    memset(&t_boot_sim, 0, sizeof(t_boot_sim));
+    memset(t_boot_sim_flash, 0, sizeof(t_boot_sim_flash));
+    m_flash_busy_fn = flash_busy_fn;
+}
+
+uint32_t t_boot_sim_file_chunks(const t_boot_sim_file_t *p_file)
+{
+    return (p_file->size + DATA_PER_CHUNK - 1) / DATA_PER_CHUNK;
+}
+
+void t_boot_sim_make_sector(const t_boot_sim_file_t *p_file, uint32_t n, uint8_t *p_sector)
+{
+    memset(p_sector, 0, SECTOR_SIZE);
+    if (n == 0)
+    {
+        dfu_header_t h = {.magic                    = 0xBEEFCAFE,
+                          .packet_type              = 0,
+                          .number_of_dfu_components = 1,
+                          .product_type             = T_BOOT_DFU_PRODUCT_TYPE_U32,
+                          .product_id               = T_BOOT_DFU_PRODUCT_ID_U32};
+        memcpy(p_sector, &h, sizeof(h));
+    }
+    else if (n == 1)
+    {
+        t_boot_crc_init();
+        fw_header_t h = {.magic        = 0xBEEFCAFE,
+                         .packet_type  = 1,
+                         .component_id = p_file->component_id,
+                         .chunks       = (uint16_t) t_boot_sim_file_chunks(p_file),
+                         .size         = p_file->size,
+                         .fw_crc32     = t_boot_crc_compute((uint32_t *) p_file->p_payload, p_file->size)};
+        memcpy(p_sector, &h, sizeof(h));
+    }
+    else
+    {
+        uint32_t chunk  = n - 1;
+        uint32_t offset = (chunk - 1) * DATA_PER_CHUNK;
+        uint32_t length = p_file->size - offset < DATA_PER_CHUNK ? p_file->size - offset : DATA_PER_CHUNK;
+
+        memcpy(p_sector + sizeof(chunk_header_t), &p_file->p_payload[offset], length);
+
+        t_boot_crc_init();
+        chunk_header_t h = {
+            .magic        = 0xBEEFCAFE,
+            .packet_type  = 2,
+            .component_id = p_file->component_id,
+            .chunk_number = (uint16_t) chunk,
+            .length       = length,
+            .chunk_crc32  = t_boot_crc_compute((uint32_t *) (p_sector + sizeof(chunk_header_t)), length)};
+        memcpy(p_sector, &h, sizeof(h));
+    }
+}
+
+int t_boot_sim_target_init(void)
+{
+    t_boot_sim.flash_erased = false;
+    return 0;
+}
+
+int t_boot_sim_target_prepare(uint32_t fw_size, uint32_t crc32)
+{
+    (void) fw_size;
+    (void) crc32;
+    return 0;
+}
+
+int t_boot_sim_target_write(const uint8_t *data, uint32_t len, uint32_t offset)
+{
+    if (!t_boot_sim.flash_erased)
+    {
+        erase_from(0);
+        t_boot_sim.flash_erased = true;
+    }
+
+    if (offset + len > APP_FLASH_SIZE)
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < len; i += 2)
+    {
+        // A half-word can only be programmed once after the erase
+        if (t_boot_sim_flash[offset + i] != 0xFF || t_boot_sim_flash[offset + i + 1] != 0xFF)
+        {
+            return -1;
+        }
+        t_boot_sim_flash[offset + i]     = data[i];
+        t_boot_sim_flash[offset + i + 1] = data[i + 1];
+        flash_advance(FLASH_PROGRAM_HALF_WORD_NS);
+    }
+
+    return 0;
+}
+
+int t_boot_sim_target_read(uint8_t *data, uint32_t len, uint32_t offset)
+{
+    if (offset + len > APP_FLASH_SIZE)
+    {
+        return -1;
+    }
+    memcpy(data, &t_boot_sim_flash[offset], len);
+    t_boot_sim.now_ns += (uint64_t) len * FLASH_COMPARE_BYTE_NS;
+    return 0;
+}
+
+uint32_t t_boot_sim_target_resume(uint32_t offset)
+{
+    uint32_t keep = offset - (offset % FLASH_PAGE_SIZE);
+    erase_from(keep);
+    t_boot_sim.flash_erased = true;
+    return keep;
+}
+
+void t_boot_sim_on_complete(void)
+{
+    t_boot_sim.complete = true;
+}
+
+void t_boot_sim_on_error(t_boot_dfu_component_id_t component_id, int error_code)
+{
+    (void) component_id;
+    (void) error_code;
+    t_boot_sim.failed = true;
+}
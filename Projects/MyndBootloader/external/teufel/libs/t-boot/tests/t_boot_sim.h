@@ -0,0 +1,62 @@
+#pragma once
+
+// Host model of the STM32F072 application flash as programmed by the MCU DFU target, and of the update file the host
+// copies to the disk. Time passes with the flash operations, the suites add the time of the transfer.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "t_boot_dfu.h"
+
+// STM32F072 datasheet: half-word programming 53.5 us, page erase 20..40 ms
+#define FLASH_PROGRAM_HALF_WORD_NS 53500u
+#define FLASH_ERASE_PAGE_NS        30000000u
+#define FLASH_PAGE_SIZE            2048u
+#define APP_FLASH_SIZE             (104u * 1024u)
+
+// Comparing resent data with the flash, a few cycles per byte at 48 MHz
+#define FLASH_COMPARE_BYTE_NS 125u
+
+// Full speed bulk endpoint at about 1 MB/s, one chunk per 512 byte sector
+#define USB_SECTOR_NS  512000u
+#define SECTOR_SIZE    512u
+#define DATA_PER_CHUNK 256u
+
+typedef struct
+{
+    uint64_t now_ns;
+    bool     flash_erased; // like dfu_mcu.c, reset with the device
+    bool     complete;
+    bool     failed;
+} t_boot_sim_t;
+
+extern t_boot_sim_t t_boot_sim;
+extern uint8_t      t_boot_sim_flash[APP_FLASH_SIZE];
+
+// Component of the update file
+typedef struct
+{
+    const uint8_t *p_payload;
+    uint32_t       size;
+    uint8_t        component_id; // with T_BOOT_DFU_COMPONENT_COMPRESSED for a compressed payload
+} t_boot_sim_file_t;
+
+// Clears the flash and the state, flash_busy_fn is called after every flash operation, e.g. for the USB interrupt that
+// gets to run in between. NULL if nothing runs.
+void t_boot_sim_init(void (*flash_busy_fn)(void));
+
+uint32_t t_boot_sim_file_chunks(const t_boot_sim_file_t *p_file);
+
+// Sector n of the update file: DFU header, FW header, then the payload in 256 byte chunks, the last one may be short
+void t_boot_sim_make_sector(const t_boot_sim_file_t *p_file, uint32_t n, uint8_t *p_sector);
+
+// Functions of the MCU target, erasing the whole application area before the first write like dfu_mcu.c
+int      t_boot_sim_target_init(void);
+int      t_boot_sim_target_prepare(uint32_t fw_size, uint32_t crc32);
+int      t_boot_sim_target_write(const uint8_t *data, uint32_t len, uint32_t offset);
+int      t_boot_sim_target_read(uint8_t *data, uint32_t len, uint32_t offset);
+uint32_t t_boot_sim_target_resume(uint32_t offset);
+
+// Callbacks for t_boot_config_t, setting complete and failed
+void t_boot_sim_on_complete(void);
+void t_boot_sim_on_error(t_boot_dfu_component_id_t component_id, int error_code);
@@ -0,0 +1,216 @@
+#include <string.h>
+#include <time.h>
+
+#include "t_boot_app.h"
+#include "t_boot_crc.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+// Application area of the Mynd bootloader
+#define APP_ADDRESS 0x08005000u
+#define APP_SIZE    (104u * 1024u)
+
+#define REQUEST_BOOTLOADER 0xCAFEBEEFu
+#define UPDATE_DONE        0xBEEFBEEFu
+
+static uint32_t app_area[APP_SIZE / sizeof(uint32_t)];
+
+// Backup register
+static volatile uint32_t boot_request;
+
+static t_boot_app_state_t state;
+
+static uint32_t host_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) (ts.tv_sec * 1000000u + ts.tv_nsec / 1000u);
+}
+
+static void write_vectors(uint32_t stack_pointer, uint32_t app_entry)
+{
+    app_area[0] = stack_pointer;
+    app_area[1] = app_entry;
+}
+
+// Image of the given size, with the trailer of scripts/add_trailer.py
+static void write_image_with_trailer(uint32_t size)
+{
+    uint8_t *p_image = (uint8_t *) app_area;
+
+    for (uint32_t i = 8; i < size; i++)
+    {
+        p_image[i] = (uint8_t) (i * 13u + (i >> 9));
+    }
+    write_vectors(0x20003000, APP_ADDRESS + 0xC1);
+
+    t_boot_crc_init();
+    t_boot_app_trailer_t trailer = {
+        .size = size, .crc32 = t_boot_crc_compute(app_area, size), .magic = T_BOOT_APP_TRAILER_MAGIC};
+    memcpy(&p_image[size], &trailer, sizeof(trailer));
+}
+
+TEST_GROUP(TbootApp);
+
+TEST_SETUP(TbootApp)
+{
+    memset(app_area, 0xFF, sizeof(app_area));
+    write_vectors(0x20003000, APP_ADDRESS + 0xC1);
+    boot_request = 0;
+
+    state = (t_boot_app_state_t){
+        .reset          = T_BOOT_APP_RESET_POWER_ON,
+        .p_boot_request = &boot_request,
+        .update_pending = false,
+        .p_image        = app_area,
+        .image_address  = APP_ADDRESS,
+        .image_max_size = APP_SIZE,
+        .get_time_us    = host_time_us,
+    };
+}
+
+TEST_TEAR_DOWN(TbootApp) {}
+
+TEST(TbootApp, test_all_boot_request_values_and_resets)
+{
+    const uint32_t values[] = {0, REQUEST_BOOTLOADER, UPDATE_DONE, 0xDEADBEEF, 0xFFFFFFFF, 0xCAFEBEEE};
+    const t_boot_app_reset_t resets[] = {T_BOOT_APP_RESET_POWER_ON, T_BOOT_APP_RESET_SOFTWARE,
+                                         T_BOOT_APP_RESET_WATCHDOG, T_BOOT_APP_RESET_OTHER};
+
+    for (uint32_t v = 0; v < sizeof(values) / sizeof(values[0]); v++)
+    {
+        for (uint32_t r = 0; r < sizeof(resets) / sizeof(resets[0]); r++)
+        {
+            bool requested = (values[v] == REQUEST_BOOTLOADER) && (resets[r] == T_BOOT_APP_RESET_SOFTWARE);
+
+            state.reset  = resets[r];
+            boot_request = values[v];
+
+            TEST_ASSERT_EQUAL(requested ? T_BOOT_APP_STAY_REQUESTED : T_BOOT_APP_START,
+                              t_boot_app_decide(&state, NULL));
+
+            // Only the request itself is consumed, the rest is left for the application
+            TEST_ASSERT_EQUAL_HEX32(requested ? 0 : values[v], boot_request);
+        }
+    }
+}
+
+TEST(TbootApp, test_request_without_valid_application)
+{
+    memset(app_area, 0xFF, sizeof(app_area));
+
+    state.reset  = T_BOOT_APP_RESET_SOFTWARE;
+    boot_request = REQUEST_BOOTLOADER;
+    TEST_ASSERT_EQUAL(T_BOOT_APP_STAY_REQUESTED, t_boot_app_decide(&state, NULL));
+    TEST_ASSERT_EQUAL_HEX32(0, boot_request);
+
+    TEST_ASSERT_EQUAL(T_BOOT_APP_STAY_INVALID_VECTORS, t_boot_app_decide(&state, NULL));
+
+    state.p_boot_request = NULL;
+    TEST_ASSERT_EQUAL(T_BOOT_APP_STAY_INVALID_VECTORS, t_boot_app_decide(&state, NULL));
+}
+
+TEST(TbootApp, test_pending_update_stays)
+{
+    state.update_pending = true;
+    TEST_ASSERT_EQUAL(T_BOOT_APP_STAY_UPDATE_PENDING, t_boot_app_decide(&state, NULL));
+
+    state.reset  = T_BOOT_APP_RESET_SOFTWARE;
+    boot_request = UPDATE_DONE;
+    TEST_ASSERT_EQUAL(T_BOOT_APP_STAY_UPDATE_PENDING, t_boot_app_decide(&state, NULL));
+    TEST_ASSERT_EQUAL_HEX32(UPDATE_DONE, boot_request);
+}
+
+TEST(TbootApp, test_invalid_vectors)
+{
+    write_vectors(0x10003000, APP_ADDRESS + 0xC1);
+    TEST_ASSERT_EQUAL(T_BOOT_APP_STAY_INVALID_VECTORS, t_boot_app_decide(&state, NULL));
+
+    write_vectors(0xFFFFFFFF, 0xFFFFFFFF);
+    TEST_ASSERT_EQUAL(T_BOOT_APP_STAY_INVALID_VECTORS, t_boot_app_decide(&state, NULL));
+
+    write_vectors(0x20003000, APP_ADDRESS - 0x100);
+    TEST_ASSERT_EQUAL(T_BOOT_APP_STAY_INVALID_VECTORS, t_boot_app_decide(&state, NULL));
+
+    write_vectors(0x20003000, APP_ADDRESS + APP_SIZE);
+    TEST_ASSERT_EQUAL(T_BOOT_APP_STAY_INVALID_VECTORS, t_boot_app_decide(&state, NULL));
+
+    write_vectors(0x20003000, APP_ADDRESS + APP_SIZE - 1);
+    TEST_ASSERT_EQUAL(T_BOOT_APP_START, t_boot_app_decide(&state, NULL));
+}
+
+TEST(TbootApp, test_trailer_from_script)
+{
+    // scripts/add_trailer.py: vectors 0x20003000, 0x080050C1, then bytes 8..61
+    static const uint8_t script_trailer[] = {0x40, 0x00, 0x00, 0x00, 0xe8, 0x67, 0x79, 0x29, 0x54, 0x54, 0x52, 0x4c};
+    uint8_t             *p_image          = (uint8_t *) app_area;
+    t_boot_app_timing_t  timing;
+
+    for (uint32_t i = 8; i < 62; i++)
+    {
+        p_image[i] = (uint8_t) i;
+    }
+    memcpy(&p_image[64], script_trailer, sizeof(script_trailer));
+
+    TEST_ASSERT_EQUAL(T_BOOT_APP_START, t_boot_app_decide(&state, &timing));
+    TEST_ASSERT_EQUAL(64, timing.crc_bytes);
+
+    p_image[30] ^= 0x10;
+    TEST_ASSERT_EQUAL(T_BOOT_APP_STAY_INVALID_CRC, t_boot_app_decide(&state, NULL));
+}
+
+TEST(TbootApp, test_image_without_trailer)
+{
+    t_boot_app_timing_t timing;
+
+    // Not checked with T_BOOT_APP_CRC_CHECK 1, e.g. an image built before trailers were added
+    memset(&app_area[2], 0x5A, 4000);
+    TEST_ASSERT_EQUAL(T_BOOT_APP_START, t_boot_app_decide(&state, &timing));
+    TEST_ASSERT_EQUAL(0, timing.crc_bytes);
+
+    // A trailer which doesn't directly follow the image isn't one
+    write_image_with_trailer(4000);
+    app_area[4000 / 4] += 4;
+    TEST_ASSERT_EQUAL(T_BOOT_APP_START, t_boot_app_decide(&state, &timing));
+    TEST_ASSERT_EQUAL(0, timing.crc_bytes);
+}
+
+TEST(TbootApp, test_checks_of_full_sized_image)
+{
+    t_boot_app_timing_t timing;
+    uint32_t            size = APP_SIZE - sizeof(t_boot_app_trailer_t);
+
+    write_image_with_trailer(size);
+    TEST_ASSERT_EQUAL(T_BOOT_APP_START, t_boot_app_decide(&state, &timing));
+    TEST_ASSERT_EQUAL(size, timing.crc_bytes);
+
+    TEST_PRINTF("%u byte image: checks %u us, CRC %u us on the host\r\n", size, timing.checks_us, timing.crc_us);
+
+    // The last word of the image is covered
+    app_area[size / 4 - 1] ^= 0x80000000;
+    TEST_ASSERT_EQUAL(T_BOOT_APP_STAY_INVALID_CRC, t_boot_app_decide(&state, &timing));
+
+    // The CRC isn't computed when the bootloader stays anyway
+    state.reset  = T_BOOT_APP_RESET_SOFTWARE;
+    boot_request = REQUEST_BOOTLOADER;
+    TEST_ASSERT_EQUAL(T_BOOT_APP_STAY_REQUESTED, t_boot_app_decide(&state, &timing));
+    TEST_ASSERT_EQUAL(0, timing.crc_bytes);
+    TEST_ASSERT_EQUAL(0, timing.crc_us);
+}
+
+TEST_GROUP_RUNNER(TbootApp)
+{
+    RUN_TEST_CASE(TbootApp, test_all_boot_request_values_and_resets);
+
+    RUN_TEST_CASE(TbootApp, test_request_without_valid_application);
+
+    RUN_TEST_CASE(TbootApp, test_pending_update_stays);
+
+    RUN_TEST_CASE(TbootApp, test_invalid_vectors);
+
+    RUN_TEST_CASE(TbootApp, test_trailer_from_script);
+
+    RUN_TEST_CASE(TbootApp, test_image_without_trailer);
+
+    RUN_TEST_CASE(TbootApp, test_checks_of_full_sized_image);
+}
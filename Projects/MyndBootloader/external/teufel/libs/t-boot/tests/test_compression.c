@@ -0,0 +1,515 @@
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "t_boot_compression.h"
+#include "t_boot_dfu.h"
+#include "t_boot_sim.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#define IMAGE_SIZE (104u * 1024u)
+
+// Same parameters as scripts/compress.py
+#define WINDOW_BITS    10u
+#define LENGTH_BITS    4u
+#define KEY_SIZE       3u
+#define MAX_CANDIDATES 16u
+
+static uint8_t  image[IMAGE_SIZE];
+static uint8_t  compressed[IMAGE_SIZE + IMAGE_SIZE / 8 + 64];
+static uint8_t  flash[IMAGE_SIZE];
+static uint32_t flash_written;
+static bool     write_failed;
+
+static uint32_t rng_state;
+
+static uint32_t rng(void)
+{
+    rng_state = rng_state * 1103515245u + 12345u;
+    return rng_state >> 8;
+}
+
+static uint16_t random_instruction(void)
+{
+    static const uint16_t opcodes[][2] = {
+        {0x2000, 0x07FF}, // movs rd, #imm
+        {0x6800, 0x01FF}, // ldr rt, [rn, #imm]
+        {0x6000, 0x01FF}, // str rt, [rn, #imm]
+        {0x1800, 0x01FF}, // adds rd, rn, rm
+        {0x4280, 0x003F}, // cmp rn, rm
+        {0xD000, 0x01FF}, // beq/bne
+        {0xE000, 0x00FF}, // b
+        {0x4800, 0x070F}, // ldr rt, [pc, #imm]
+        {0x4600, 0x003F}, // mov rd, rm
+        {0x7800, 0x01FF}, // ldrb rt, [rn, #imm]
+        {0x3000, 0x071F}, // adds rd, #imm
+    };
+
+    // Few registers and small immediates are used most of the time
+    uint32_t op     = rng() % (sizeof(opcodes) / sizeof(opcodes[0]));
+    uint16_t fields = (uint16_t) ((rng() % 7u) * (rng() % 7u) * 0x49u);
+    return (uint16_t) (opcodes[op][0] | (fields & opcodes[op][1]));
+}
+
+// Firmware-like content: Thumb functions made of recurring compiler idioms and other instructions, literal
+// pools and log strings
+static void make_firmware(uint8_t *p_image, uint32_t size)
+{
+    static const char *words[] = {"dfu",   "flash", "error", "write",  "usb", "chunk", "done",   "%d",
+                                  "0x%08x", "bt",   "power", "state",  "init", "failed", "timeout", "ok"};
+    static uint16_t    idioms[64][6];
+
+    uint32_t pos       = 0;
+    uint32_t code_size = size * 8u / 10u;
+
+    rng_state = 0xC0FFEE;
+
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        for (uint32_t j = 0; j < 6; j++)
+        {
+            idioms[i][j] = random_instruction();
+        }
+    }
+
+    // Vector table
+    for (; pos < 48u * 4u; pos += 4)
+    {
+        uint32_t vector = 0x08005000u + (rng() % (code_size / 2u)) * 2u + 1u;
+        memcpy(&p_image[pos], &vector, 4);
+    }
+
+    while (pos + 64u < code_size)
+    {
+        uint16_t registers = (uint16_t) (0x10u | (rng() & 0xF0u));
+        uint16_t push      = (uint16_t) (0xB500u | registers);
+        memcpy(&p_image[pos], &push, 2);
+        pos += 2;
+
+        for (uint32_t n = 4u + rng() % 16u; n > 0 && pos + 16u < code_size; n--)
+        {
+            uint32_t r = rng() % 8u;
+            if (r == 0)
+            {
+                // bl, the offset depends on the call site
+                uint16_t bl[2] = {(uint16_t) (0xF000u | (rng() & 0x7FFu)), (uint16_t) (0xF800u | (rng() & 0x7FFu))};
+                memcpy(&p_image[pos], bl, 4);
+                pos += 4;
+            }
+            else if (r < 4)
+            {
+                // The idioms are skewed towards the first ones
+                uint32_t idiom  = (rng() % 8u) * (rng() % 8u);
+                uint32_t length = 2u + rng() % 5u;
+                memcpy(&p_image[pos], idioms[idiom], length * 2u);
+                pos += length * 2u;
+            }
+            else
+            {
+                uint16_t instruction = random_instruction();
+                memcpy(&p_image[pos], &instruction, 2);
+                pos += 2;
+            }
+        }
+
+        uint16_t pop = (uint16_t) (0xBD00u | registers);
+        memcpy(&p_image[pos], &pop, 2);
+        pos += 2;
+        pos = (pos + 3u) & ~3u;
+
+        // Literal pool
+        for (uint32_t n = rng() % 4u; n > 0 && pos + 4u < code_size; n--)
+        {
+            static const uint32_t bases[] = {0x08005000u, 0x20000000u, 0x40010000u, 0x48000000u};
+            uint32_t              literal = bases[rng() % 4u] + (rng() % 256u) * 4u;
+            memcpy(&p_image[pos], &literal, 4);
+            pos += 4;
+        }
+    }
+
+    // Log strings
+    while (pos < size)
+    {
+        for (uint32_t n = 2u + rng() % 5u; n > 0 && pos < size; n--)
+        {
+            const char *p_word = words[rng() % (sizeof(words) / sizeof(words[0]))];
+            for (size_t i = 0; p_word[i] != '\0' && pos < size; i++)
+            {
+                p_image[pos++] = (uint8_t) p_word[i];
+            }
+            if (pos < size)
+            {
+                p_image[pos++] = (n > 1) ? ' ' : '\0';
+            }
+        }
+    }
+}
+
+typedef struct
+{
+    uint8_t *p_data;
+    uint32_t length;
+    uint32_t value;
+    uint8_t  count;
+} bit_writer_t;
+
+static void put_bits(bit_writer_t *p_writer, uint32_t value, uint32_t bits)
+{
+    p_writer->value = (p_writer->value << bits) | value;
+    p_writer->count += bits;
+    while (p_writer->count >= 8)
+    {
+        p_writer->count -= 8;
+        p_writer->p_data[p_writer->length++] = (uint8_t) (p_writer->value >> p_writer->count);
+    }
+    p_writer->value &= (1u << p_writer->count) - 1u;
+}
+
+// Greedy LZSS like scripts/compress.py
+static uint32_t compress(const uint8_t *p_data, uint32_t size, uint8_t *p_out)
+{
+    static int32_t candidates[1u << 16][MAX_CANDIDATES];
+    static uint8_t candidate_count[1u << 16];
+
+    const uint32_t window    = 1u << WINDOW_BITS;
+    const uint32_t max_match = (1u << LENGTH_BITS) - 1u + T_BOOT_COMPRESSION_MIN_MATCH;
+
+    t_boot_compression_header_t header = {
+        .magic       = T_BOOT_COMPRESSION_MAGIC,
+        .size        = size,
+        .window_bits = WINDOW_BITS,
+        .length_bits = LENGTH_BITS,
+    };
+    bit_writer_t writer = {.p_data = p_out + sizeof(header)};
+
+    memcpy(p_out, &header, sizeof(header));
+    memset(candidate_count, 0, sizeof(candidate_count));
+
+    for (uint32_t pos = 0; pos < size;)
+    {
+        uint32_t best_len = 0, best_distance = 0;
+
+        if (pos + KEY_SIZE <= size)
+        {
+            uint32_t key = ((uint32_t) p_data[pos] << 8 ^ p_data[pos + 1] << 4 ^ p_data[pos + 2]) & 0xFFFFu;
+            for (int32_t i = candidate_count[key] - 1; i >= 0; i--)
+            {
+                uint32_t candidate = (uint32_t) candidates[key][i];
+                if (pos - candidate > window)
+                {
+                    break;
+                }
+                if (memcmp(&p_data[candidate], &p_data[pos], KEY_SIZE) != 0)
+                {
+                    continue;
+                }
+
+                uint32_t n = 0;
+                while (n < max_match && pos + n < size && p_data[candidate + n] == p_data[pos + n])
+                {
+                    n++;
+                }
+                if (n > best_len)
+                {
+                    best_len      = n;
+                    best_distance = pos - candidate;
+                }
+            }
+        }
+
+        uint32_t step = 1;
+        if (best_len >= T_BOOT_COMPRESSION_MIN_MATCH)
+        {
+            put_bits(&writer, 0, 1);
+            put_bits(&writer, best_distance - 1u, WINDOW_BITS);
+            put_bits(&writer, best_len - T_BOOT_COMPRESSION_MIN_MATCH, LENGTH_BITS);
+            step = best_len;
+        }
+        else
+        {
+            put_bits(&writer, 0x100u | p_data[pos], 9);
+        }
+
+        for (uint32_t end = pos + step; pos < end; pos++)
+        {
+            if (pos + KEY_SIZE <= size)
+            {
+                uint32_t key = ((uint32_t) p_data[pos] << 8 ^ p_data[pos + 1] << 4 ^ p_data[pos + 2]) & 0xFFFFu;
+                if (candidate_count[key] == MAX_CANDIDATES)
+                {
+                    memmove(&candidates[key][0], &candidates[key][1], (MAX_CANDIDATES - 1u) * sizeof(int32_t));
+                    candidate_count[key]--;
+                }
+                candidates[key][candidate_count[key]++] = (int32_t) pos;
+            }
+        }
+    }
+
+    if (writer.count > 0)
+    {
+        put_bits(&writer, 0, 8u - writer.count);
+    }
+
+    return sizeof(header) + writer.length;
+}
+
+static uint32_t expected_size;
+
+static int flash_write(const uint8_t *p_data, uint32_t length, uint32_t offset)
+{
+    // The firmware arrives in order, in blocks of half the window except for the last one
+    if ((offset != flash_written) || (offset + length > expected_size) ||
+        ((length != T_BOOT_COMPRESSION_WINDOW_SIZE / 2u) && (offset + length != expected_size)))
+    {
+        write_failed = true;
+        return -1;
+    }
+
+    memcpy(&flash[offset], p_data, length);
+    flash_written += length;
+    return 0;
+}
+
+// Feeds the payload in pieces of piece_size bytes
+static int decompress(const uint8_t *p_payload, uint32_t payload_size, uint32_t piece_size, uint32_t size)
+{
+    t_boot_compression_t ctx;
+
+    expected_size = size;
+    flash_written = 0;
+    write_failed  = false;
+    memset(flash, 0, sizeof(flash));
+
+    t_boot_compression_start(&ctx, flash_write);
+    for (uint32_t offset = 0; offset < payload_size; offset += piece_size)
+    {
+        uint32_t n = payload_size - offset < piece_size ? payload_size - offset : piece_size;
+        if (t_boot_compression_decode(&ctx, &p_payload[offset], n) != 0)
+        {
+            return -1;
+        }
+    }
+
+    return (t_boot_compression_is_done(&ctx) && !write_failed && flash_written == size) ? 0 : -1;
+}
+
+static uint64_t elapsed_ns(const struct timespec *p_start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (uint64_t) (end.tv_sec - p_start->tv_sec) * 1000000000u + (uint64_t) end.tv_nsec - (uint64_t) p_start->tv_nsec;
+}
+
+TEST_GROUP(TbootCompression);
+
+TEST_SETUP(TbootCompression)
+{
+    make_firmware(image, sizeof(image));
+}
+
+TEST_TEAR_DOWN(TbootCompression) {}
+
+TEST(TbootCompression, test_payload_from_script)
+{
+    // scripts/compress.py: "The quick brown fox jumps over the lazy dog. " * 4, bytes 0..39, 37 zeros and
+    // "The quick brown fox!"
+    static const uint8_t payload[] = {
+        0x54, 0x4c, 0x5a, 0x53, 0x15, 0x01, 0x00, 0x00, 0x0a, 0x04, 0x00, 0x00, 0xaa, 0x5a, 0x2c, 0xb2,
+        0x0b, 0x8d, 0xd6, 0xd3, 0x63, 0xb5, 0xc8, 0x2c, 0x57, 0x2b, 0x7d, 0xde, 0xdd, 0x20, 0xb3, 0x5b,
+        0xef, 0x12, 0x0b, 0x55, 0xd6, 0xdb, 0x70, 0xb9, 0xc8, 0x2d, 0xf7, 0x6b, 0x2d, 0xca, 0x41, 0x74,
+        0x03, 0xc3, 0x6c, 0xb0, 0xde, 0xaf, 0x32, 0x0b, 0x25, 0xbe, 0xcf, 0x2e, 0x90, 0x02, 0xcf, 0x05,
+        0x9e, 0x0b, 0x3c, 0x16, 0x78, 0x2c, 0xf0, 0x59, 0xe0, 0xb3, 0xc1, 0x67, 0x40, 0x20, 0x30, 0x28,
+        0x1c, 0x12, 0x0b, 0x06, 0x83, 0xc2, 0x21, 0x30, 0xa8, 0x5c, 0x32, 0x1b, 0x0e, 0x87, 0xc4, 0x22,
+        0x31, 0x28, 0x9c, 0x52, 0x2b, 0x16, 0x8b, 0xc6, 0x23, 0x31, 0xa8, 0xdc, 0x72, 0x3b, 0x1e, 0x8f,
+        0xc8, 0x24, 0x32, 0x29, 0x1c, 0x92, 0x4b, 0x26, 0x93, 0xc0, 0x00, 0x07, 0x80, 0x0f, 0x80, 0x40,
+        0x03, 0xcf, 0xdb, 0xef, 0x12, 0x10,
+    };
+    const char *p_text = "The quick brown fox jumps over the lazy dog. ";
+    uint8_t     expected[277];
+    uint32_t    length = 0;
+
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        memcpy(&expected[length], p_text, strlen(p_text));
+        length += strlen(p_text);
+    }
+    for (uint32_t i = 0; i < 40; i++)
+    {
+        expected[length++] = (uint8_t) i;
+    }
+    memset(&expected[length], 0, 37);
+    length += 37;
+    memcpy(&expected[length], "The quick brown fox!", 20);
+    length += 20;
+
+    TEST_ASSERT_EQUAL(sizeof(expected), length);
+    TEST_ASSERT_EQUAL(0, decompress(payload, sizeof(payload), sizeof(payload), length));
+    TEST_ASSERT_EQUAL_MEMORY(expected, flash, length);
+}
+
+TEST(TbootCompression, test_real_sized_images_round_trip)
+{
+    const uint32_t sizes[]  = {IMAGE_SIZE, IMAGE_SIZE - 3u, 48u * 1024u + 1u};
+    const uint32_t pieces[] = {DATA_PER_CHUNK, 1, 7, 500};
+
+    for (uint32_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        uint32_t payload_size = compress(image, sizes[i], compressed);
+
+        for (uint32_t j = 0; j < sizeof(pieces) / sizeof(pieces[0]); j++)
+        {
+            TEST_ASSERT_EQUAL(0, decompress(compressed, payload_size, pieces[j], sizes[i]));
+            TEST_ASSERT_EQUAL_MEMORY(image, flash, sizes[i]);
+        }
+    }
+}
+
+TEST(TbootCompression, test_invalid_payloads_are_refused)
+{
+    t_boot_compression_header_t header = {
+        .magic       = T_BOOT_COMPRESSION_MAGIC,
+        .size        = 16,
+        .window_bits = T_BOOT_COMPRESSION_WINDOW_BITS + 1u,
+        .length_bits = LENGTH_BITS,
+    };
+    uint8_t payload[sizeof(header) + 4];
+
+    // A window larger than the bootloader has
+    memcpy(payload, &header, sizeof(header));
+    memset(&payload[sizeof(header)], 0xFF, 4);
+    TEST_ASSERT_EQUAL(-1, decompress(payload, sizeof(payload), sizeof(payload), 16));
+
+    // A copy before the start of the payload
+    header.window_bits = WINDOW_BITS;
+    memcpy(payload, &header, sizeof(header));
+    memset(&payload[sizeof(header)], 0x00, 4);
+    TEST_ASSERT_EQUAL(-1, decompress(payload, sizeof(payload), sizeof(payload), 16));
+
+    // Not compressed at all
+    TEST_ASSERT_EQUAL(-1, decompress(image, 64, 64, 64));
+}
+
+TEST(TbootCompression, test_truncated_and_overlong_payloads_fail)
+{
+    uint32_t payload_size = compress(image, 8u * 1024u, compressed);
+
+    TEST_ASSERT_EQUAL(-1, decompress(compressed, payload_size - 1u, DATA_PER_CHUNK, 8u * 1024u));
+    TEST_ASSERT_LESS_THAN_UINT32(8u * 1024u, flash_written);
+
+    compressed[payload_size] = 0;
+    TEST_ASSERT_EQUAL(-1, decompress(compressed, payload_size + 1u, DATA_PER_CHUNK, 8u * 1024u));
+}
+
+static const t_boot_dfu_target_t dfu_targets[] = {{
+    .name         = "MCU",
+    .component_id = T_BOOT_DFU_COMPONENT_ID_MCU,
+    .prepare      = t_boot_sim_target_prepare,
+    .write        = flash_write,
+}};
+
+static const t_boot_config_t dfu_config = {
+    .p_dfu_target_list    = dfu_targets,
+    .dfu_target_list_size = 1,
+    .update_successful_fn = t_boot_sim_on_complete,
+    .update_error_fn      = t_boot_sim_on_error,
+};
+
+static t_boot_sim_file_t compressed_file = {
+    .p_payload    = compressed,
+    .component_id = T_BOOT_DFU_COMPONENT_ID_MCU | T_BOOT_DFU_COMPONENT_COMPRESSED,
+};
+
+// Compresses the image into the update file and starts the DFU
+static void dfu_start(void)
+{
+    compressed_file.size = compress(image, IMAGE_SIZE, compressed);
+    expected_size        = IMAGE_SIZE;
+    flash_written        = 0;
+    write_failed         = false;
+
+    t_boot_sim_init(NULL);
+    TEST_ASSERT_EQUAL(0, t_boot_dfu_init(&dfu_config));
+}
+
+static int send_sector(uint32_t n)
+{
+    uint8_t sector[SECTOR_SIZE];
+
+    t_boot_sim_make_sector(&compressed_file, n, sector);
+    return t_boot_dfu_process_chunk(sector, SECTOR_SIZE);
+}
+
+TEST(TbootCompression, test_compressed_component_through_dfu)
+{
+    int result = 0;
+
+    dfu_start();
+    for (uint32_t n = 0; n < 2 + t_boot_sim_file_chunks(&compressed_file) && result == 0; n++)
+    {
+        result = send_sector(n);
+    }
+
+    TEST_ASSERT_EQUAL(1, result);
+    TEST_ASSERT_TRUE(t_boot_sim.complete);
+    TEST_ASSERT_FALSE(t_boot_sim.failed);
+    TEST_ASSERT_EQUAL_MEMORY(image, flash, IMAGE_SIZE);
+}
+
+TEST(TbootCompression, test_compressed_chunks_out_of_order_fail)
+{
+    dfu_start();
+    TEST_ASSERT_EQUAL(0, send_sector(0));
+    TEST_ASSERT_EQUAL(0, send_sector(1));
+    TEST_ASSERT_EQUAL(0, send_sector(2));
+
+    // Chunk 3 instead of chunk 2
+    TEST_ASSERT_EQUAL(-T_BOOT_DFU_ERROR_CHUNK_NUM, send_sector(4));
+    TEST_ASSERT_TRUE(t_boot_sim.failed);
+}
+
+TEST(TbootCompression, test_decompression_speed_and_transfer_savings)
+{
+    const uint32_t runs         = 20;
+    uint32_t       payload_size = compress(image, IMAGE_SIZE, compressed);
+    uint64_t       total_ns     = 0;
+
+    for (uint32_t run = 0; run < runs; run++)
+    {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        TEST_ASSERT_EQUAL(0, decompress(compressed, payload_size, DATA_PER_CHUNK, IMAGE_SIZE));
+        total_ns += elapsed_ns(&start);
+    }
+
+    uint32_t full_chunks       = (IMAGE_SIZE + DATA_PER_CHUNK - 1u) / DATA_PER_CHUNK;
+    uint32_t compressed_chunks = (payload_size + DATA_PER_CHUNK - 1u) / DATA_PER_CHUNK;
+    uint32_t full_ms           = full_chunks * (USB_SECTOR_NS / 1000u) / 1000u;
+    uint32_t compressed_ms     = compressed_chunks * (USB_SECTOR_NS / 1000u) / 1000u;
+    uint32_t kb_per_s          = (uint32_t) ((uint64_t) IMAGE_SIZE * runs * 1000000u / 1024u / total_ns * 1000u);
+
+    TEST_PRINTF("%u bytes compressed to %u (%u%%), decompression on the host: %u.%02u MB/s with a %u byte window\r\n",
+                IMAGE_SIZE, payload_size, payload_size * 100u / IMAGE_SIZE, kb_per_s / 1024u,
+                kb_per_s % 1024u * 100u / 1024u, T_BOOT_COMPRESSION_WINDOW_SIZE);
+    TEST_PRINTF("USB transfer: %u chunks in %u ms instead of %u chunks in %u ms, %u ms saved\r\n", compressed_chunks,
+                compressed_ms, full_chunks, full_ms, full_ms - compressed_ms);
+
+    TEST_ASSERT_LESS_THAN_UINT32(full_chunks * 8u / 10u, compressed_chunks);
+}
+
+TEST_GROUP_RUNNER(TbootCompression)
+{
+    RUN_TEST_CASE(TbootCompression, test_payload_from_script);
+
+    RUN_TEST_CASE(TbootCompression, test_real_sized_images_round_trip);
+
+    RUN_TEST_CASE(TbootCompression, test_invalid_payloads_are_refused);
+
+    RUN_TEST_CASE(TbootCompression, test_truncated_and_overlong_payloads_fail);
+
+    RUN_TEST_CASE(TbootCompression, test_compressed_component_through_dfu);
+
+    RUN_TEST_CASE(TbootCompression, test_compressed_chunks_out_of_order_fail);
+
+    RUN_TEST_CASE(TbootCompression, test_decompression_speed_and_transfer_savings);
+}
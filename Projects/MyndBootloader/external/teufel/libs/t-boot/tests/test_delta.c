@@ -0,0 +1,522 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "t_boot_delta.h"
+#include "t_boot_sha256.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+#define PAGE_SIZE  2048u
+#define FLASH_SIZE (104u * 1024u)
+
+// Payload of a DFU data chunk
+#define CHUNK_DATA_SIZE 256u
+
+// Simulated application flash: erase sets a whole page to 0xFF, programming needs erased half-words
+static uint8_t  flash[FLASH_SIZE];
+static uint8_t  page_buffer[PAGE_SIZE];
+static uint32_t pages_erased;
+
+static int flash_read(uint8_t *p_data, uint32_t length, uint32_t offset)
+{
+    if (offset + length > FLASH_SIZE)
+    {
+        return -1;
+    }
+    memcpy(p_data, &flash[offset], length);
+    return 0;
+}
+
+static int flash_erase_page(uint32_t offset)
+{
+    if ((offset % PAGE_SIZE) != 0)
+    {
+        return -1;
+    }
+    memset(&flash[offset], 0xFF, PAGE_SIZE);
+    pages_erased++;
+    return 0;
+}
+
+static int flash_program(const uint8_t *p_data, uint32_t length, uint32_t offset)
+{
+    if (((offset | length) & 1u) != 0 || offset + length > FLASH_SIZE)
+    {
+        return -1;
+    }
+    for (uint32_t i = 0; i < length; i++)
+    {
+        if (flash[offset + i] != 0xFF)
+        {
+            return -1;
+        }
+        flash[offset + i] = p_data[i];
+    }
+    return 0;
+}
+
+static const t_boot_delta_flash_t sim_flash = {
+    .read          = flash_read,
+    .erase_page    = flash_erase_page,
+    .program       = flash_program,
+    .p_page_buffer = page_buffer,
+    .page_size     = PAGE_SIZE,
+    .flash_size    = FLASH_SIZE,
+};
+
+// Same rules as scripts/make_delta.py: greedy longest match, a COPY may only read the installed image from the
+// start of the page the byte is written to onwards
+#define MIN_COPY    16u
+#define BUCKETS     (1u << 16)
+#define BUCKET_SIZE 4u
+
+static int32_t index_table[BUCKETS][BUCKET_SIZE];
+
+static uint32_t key_hash(const uint8_t *p)
+{
+    uint32_t h = 2166136261u;
+    for (uint32_t i = 0; i < MIN_COPY; i++)
+    {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h & (BUCKETS - 1u);
+}
+
+static uint32_t match_length(const uint8_t *p_old, uint32_t old_size, const uint8_t *p_new, uint32_t new_size,
+                             uint32_t src, uint32_t dst)
+{
+    uint32_t n = 0;
+    while (dst + n < new_size && src + n < old_size && p_old[src + n] == p_new[dst + n] &&
+           src + n >= ((dst + n) / PAGE_SIZE) * PAGE_SIZE)
+    {
+        n++;
+    }
+    return n;
+}
+
+static void put_u32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t) value;
+    p[1] = (uint8_t) (value >> 8);
+    p[2] = (uint8_t) (value >> 16);
+    p[3] = (uint8_t) (value >> 24);
+}
+
+static uint32_t flush_literal(uint8_t *p_out, const uint8_t *p_literal, uint32_t length)
+{
+    uint32_t written = 0;
+    while (length > 0)
+    {
+        uint32_t n         = length > 0xFFFFu ? 0xFFFFu : length;
+        p_out[written]     = T_BOOT_DELTA_OP_INSERT;
+        p_out[written + 1] = (uint8_t) n;
+        p_out[written + 2] = (uint8_t) (n >> 8);
+        memcpy(&p_out[written + 3], p_literal, n);
+        written += 3 + n;
+        p_literal += n;
+        length -= n;
+    }
+    return written;
+}
+
+static uint32_t make_delta(const uint8_t *p_old, uint32_t old_size, const uint8_t *p_new, uint32_t new_size,
+                           uint8_t *p_out)
+{
+    t_boot_delta_header_t header = {
+        .magic     = T_BOOT_DELTA_MAGIC,
+        .version   = T_BOOT_DELTA_VERSION,
+        .page_size = PAGE_SIZE,
+        .old_size  = old_size,
+        .new_size  = new_size,
+    };
+    t_boot_sha256_ctx_t ctx;
+
+    t_boot_sha256_init(&ctx);
+    t_boot_sha256_update(&ctx, p_old, old_size);
+    t_boot_sha256_final(&ctx, header.old_sha256);
+    t_boot_sha256_init(&ctx);
+    t_boot_sha256_update(&ctx, p_new, new_size);
+    t_boot_sha256_final(&ctx, header.new_sha256);
+
+    memset(index_table, 0xFF, sizeof(index_table));
+    for (uint32_t pos = 0; pos + MIN_COPY <= old_size; pos++)
+    {
+        int32_t *p_bucket = index_table[key_hash(&p_old[pos])];
+        for (uint32_t i = 0; i < BUCKET_SIZE; i++)
+        {
+            if (p_bucket[i] < 0)
+            {
+                p_bucket[i] = (int32_t) pos;
+                break;
+            }
+        }
+    }
+
+    uint32_t length        = sizeof(header);
+    uint32_t literal_start = 0;
+    int64_t  last_delta    = INT64_MIN;
+    uint32_t dst           = 0;
+
+    memcpy(p_out, &header, sizeof(header));
+    while (dst < new_size)
+    {
+        uint32_t best_src = 0, best_len = 0;
+
+        if (last_delta != INT64_MIN && (int64_t) dst + last_delta >= 0 && (int64_t) dst + last_delta < old_size)
+        {
+            best_src = (uint32_t) ((int64_t) dst + last_delta);
+            best_len = match_length(p_old, old_size, p_new, new_size, best_src, dst);
+        }
+        if (dst + MIN_COPY <= new_size)
+        {
+            int32_t *p_bucket = index_table[key_hash(&p_new[dst])];
+            for (uint32_t i = 0; i < BUCKET_SIZE && p_bucket[i] >= 0; i++)
+            {
+                uint32_t n = match_length(p_old, old_size, p_new, new_size, (uint32_t) p_bucket[i], dst);
+                if (n > best_len)
+                {
+                    best_src = (uint32_t) p_bucket[i];
+                    best_len = n;
+                }
+            }
+        }
+
+        if (best_len >= MIN_COPY)
+        {
+            length += flush_literal(&p_out[length], &p_new[literal_start], dst - literal_start);
+            p_out[length] = T_BOOT_DELTA_OP_COPY;
+            put_u32(&p_out[length + 1], best_src);
+            put_u32(&p_out[length + 5], best_len);
+            length += 9;
+            last_delta    = (int64_t) best_src - dst;
+            dst           += best_len;
+            literal_start = dst;
+        }
+        else
+        {
+            dst++;
+        }
+    }
+    length += flush_literal(&p_out[length], &p_new[literal_start], dst - literal_start);
+
+    return length;
+}
+
+// Sends the delta in pieces of piece_size bytes, like the DFU data chunks
+static int apply(const uint8_t *p_delta, uint32_t delta_size, uint32_t piece_size)
+{
+    t_boot_delta_t delta;
+
+    pages_erased = 0;
+    t_boot_delta_start(&delta, &sim_flash);
+    for (uint32_t offset = 0; offset < delta_size; offset += piece_size)
+    {
+        uint32_t n = delta_size - offset < piece_size ? delta_size - offset : piece_size;
+        if (t_boot_delta_write(&delta, &p_delta[offset], n) != 0)
+        {
+            return -1;
+        }
+    }
+    return t_boot_delta_is_done(&delta) ? 0 : -1;
+}
+
+static uint8_t old_image[FLASH_SIZE];
+static uint8_t new_image[FLASH_SIZE];
+static uint8_t delta_image[FLASH_SIZE + FLASH_SIZE / 8];
+
+// Firmware-like content: code made of a small set of repeating instruction patterns
+static void make_firmware(uint8_t *p_image, uint32_t size, uint32_t seed)
+{
+    for (uint32_t i = 0; i < size; i += 4)
+    {
+        seed = seed * 1103515245u + 12345u;
+        uint32_t word = (seed >> 16) % 97u * 0x01000193u;
+        memcpy(&p_image[i], &word, (size - i < 4) ? size - i : 4);
+    }
+}
+
+static void install(const uint8_t *p_image, uint32_t size)
+{
+    memset(flash, 0xFF, sizeof(flash));
+    memcpy(flash, p_image, size);
+}
+
+// The application trailer is found as the last word which isn't erased
+static bool is_erased_after(uint32_t offset)
+{
+    for (uint32_t i = offset; i < FLASH_SIZE; i++)
+    {
+        if (flash[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_GROUP(TbootDelta);
+
+TEST_SETUP(TbootDelta) {}
+
+TEST_TEAR_DOWN(TbootDelta) {}
+
+TEST(TbootDelta, test_delta_from_script_applies)
+{
+    // scripts/make_delta.py: 6000 bytes, byte 100 inverted and 10 bytes inserted at 3000
+    static const uint8_t script_delta[] = {
+        0x54, 0x44, 0x4c, 0x54, 0x01, 0x00, 0x00, 0x08, 0x70, 0x17, 0x00, 0x00, 0x7a, 0x17, 0x00, 0x00,
+        0x3a, 0x56, 0x27, 0xd3, 0x2a, 0x56, 0xe5, 0x73, 0x19, 0xb0, 0xaa, 0xd9, 0xef, 0x73, 0x44, 0x00,
+        0x02, 0x0d, 0x53, 0xab, 0xde, 0x14, 0xca, 0x0f, 0x74, 0x4a, 0x81, 0x0e, 0x6d, 0x94, 0x76, 0x1d,
+        0xe3, 0x04, 0x96, 0xed, 0x68, 0x8b, 0x3a, 0x9d, 0xcd, 0x8d, 0x66, 0x4f, 0xf8, 0x16, 0x9e, 0xa2,
+        0xa3, 0xd4, 0x0c, 0x16, 0xe1, 0x8d, 0xd0, 0xc7, 0xa5, 0xd1, 0x38, 0xc3, 0x65, 0x95, 0xb9, 0x9a,
+        0x01, 0x00, 0x00, 0x00, 0x00, 0x64, 0x00, 0x00, 0x00, 0x02, 0x01, 0x00, 0x0d, 0x01, 0x65, 0x00,
+        0x00, 0x00, 0x53, 0x0b, 0x00, 0x00, 0x02, 0x0a, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+        0x07, 0x08, 0x09, 0x01, 0xb8, 0x0b, 0x00, 0x00, 0x3e, 0x04, 0x00, 0x00, 0x02, 0x0a, 0x00, 0xc9,
+        0x99, 0xe5, 0xbb, 0x64, 0xde, 0xdb, 0x54, 0x1d, 0x15, 0x01, 0x00, 0x10, 0x00, 0x00, 0x70, 0x07,
+        0x00, 0x00,
+    };
+
+    uint32_t seed = 0x12345678;
+    for (uint32_t i = 0; i < 6000; i++)
+    {
+        seed         = seed * 1103515245u + 12345u;
+        old_image[i] = (uint8_t) (seed >> 16);
+    }
+    memcpy(new_image, old_image, 3000);
+    new_image[100] ^= 0xFF;
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        new_image[3000 + i] = (uint8_t) i;
+    }
+    memcpy(&new_image[3010], &old_image[3000], 3000);
+
+    install(old_image, 6000);
+    TEST_ASSERT_EQUAL(0, apply(script_delta, sizeof(script_delta), CHUNK_DATA_SIZE));
+    TEST_ASSERT_EQUAL_MEMORY(new_image, flash, 6010);
+}
+
+TEST(TbootDelta, test_synthetic_pairs_are_bit_exact)
+{
+    static const char *names[] = {"identical", "constant patched", "40 bytes inserted", "100 bytes removed",
+                                  "3 kB appended", "unrelated build"};
+    const uint32_t     old_size = 90u * 1024u + 122u;
+
+    for (uint32_t pair = 0; pair < sizeof(names) / sizeof(names[0]); pair++)
+    {
+        uint32_t new_size = old_size;
+
+        make_firmware(old_image, old_size, 1);
+        memcpy(new_image, old_image, old_size);
+        switch (pair)
+        {
+            case 1:
+                new_image[1000] ^= 0x5A;
+                new_image[47000] ^= 0x01;
+                new_image[88000] ^= 0x80;
+                break;
+            case 2:
+                memmove(&new_image[10040], &new_image[10000], old_size - 10000);
+                memset(&new_image[10000], 0x42, 40);
+                new_size += 40;
+                break;
+            case 3:
+                memmove(&new_image[20000], &new_image[20100], old_size - 20100);
+                new_size -= 100;
+                break;
+            case 4:
+                make_firmware(&new_image[old_size], 3072, 7);
+                new_size += 3072;
+                break;
+            case 5:
+                make_firmware(new_image, new_size, 2);
+                break;
+            default:
+                break;
+        }
+
+        uint32_t delta_size = make_delta(old_image, old_size, new_image, new_size, delta_image);
+
+        install(old_image, old_size);
+        TEST_ASSERT_EQUAL(0, apply(delta_image, delta_size, CHUNK_DATA_SIZE));
+        TEST_ASSERT_EQUAL_MEMORY(new_image, flash, new_size);
+        TEST_ASSERT_TRUE(is_erased_after(new_size));
+
+        uint32_t full_chunks  = (new_size + CHUNK_DATA_SIZE - 1) / CHUNK_DATA_SIZE;
+        uint32_t delta_chunks = (delta_size + CHUNK_DATA_SIZE - 1) / CHUNK_DATA_SIZE;
+        TEST_PRINTF("%-18s delta %6u bytes, %3u of %3u chunks transferred (%u%%), %2u pages erased\r\n", names[pair],
+                    delta_size, delta_chunks, full_chunks, delta_chunks * 100u / full_chunks, pages_erased);
+
+        if (pair <= 4)
+        {
+            // A few changed spots only cost a few chunks
+            TEST_ASSERT_LESS_THAN_UINT32(full_chunks / 10u, delta_chunks);
+        }
+    }
+}
+
+TEST(TbootDelta, test_unchanged_pages_are_not_erased)
+{
+    const uint32_t size = 20u * PAGE_SIZE + 100u;
+
+    make_firmware(old_image, size, 8);
+    memcpy(new_image, old_image, size);
+    uint32_t delta_size = make_delta(old_image, size, new_image, size, delta_image);
+
+    install(old_image, size);
+    TEST_ASSERT_EQUAL(0, apply(delta_image, delta_size, CHUNK_DATA_SIZE));
+    TEST_ASSERT_EQUAL(0, pages_erased);
+
+    // A byte at an odd offset in the middle of a page and the last byte of another one
+    new_image[3u * PAGE_SIZE + 1001u] ^= 0x5A;
+    new_image[12u * PAGE_SIZE - 1u] ^= 0x01;
+    delta_size = make_delta(old_image, size, new_image, size, delta_image);
+
+    install(old_image, size);
+    TEST_ASSERT_EQUAL(0, apply(delta_image, delta_size, CHUNK_DATA_SIZE));
+    TEST_ASSERT_EQUAL_MEMORY(new_image, flash, size);
+    TEST_ASSERT_EQUAL(2, pages_erased);
+}
+
+TEST(TbootDelta, test_shorter_image_leaves_no_old_data_behind)
+{
+    const uint32_t old_size = 10u * PAGE_SIZE;
+    const uint32_t new_size = 6u * PAGE_SIZE + 301u;
+
+    // The new image is the start of the old one, its pages all stay as they are up to the last one
+    make_firmware(old_image, old_size, 9);
+    memcpy(new_image, old_image, new_size);
+    uint32_t delta_size = make_delta(old_image, old_size, new_image, new_size, delta_image);
+
+    install(old_image, old_size);
+    TEST_ASSERT_EQUAL(0, apply(delta_image, delta_size, CHUNK_DATA_SIZE));
+    TEST_ASSERT_EQUAL_MEMORY(new_image, flash, new_size);
+    TEST_ASSERT_TRUE(is_erased_after(new_size));
+    TEST_ASSERT_EQUAL(4, pages_erased);
+}
+
+TEST(TbootDelta, test_interrupted_apply_is_refused_again)
+{
+    const uint32_t size = 8u * PAGE_SIZE;
+    t_boot_delta_t delta;
+
+    make_firmware(old_image, size, 10);
+    make_firmware(new_image, size, 11);
+    uint32_t delta_size = make_delta(old_image, size, new_image, size, delta_image);
+
+    // Power lost after half of the delta, the flash holds pages of both images
+    install(old_image, size);
+    t_boot_delta_start(&delta, &sim_flash);
+    TEST_ASSERT_EQUAL(0, t_boot_delta_write(&delta, delta_image, delta_size / 2));
+    TEST_ASSERT_FALSE(t_boot_delta_is_done(&delta));
+
+    // The same delta no longer fits the installed image and leaves it for the full image
+    uint8_t interrupted[8u * PAGE_SIZE];
+    memcpy(interrupted, flash, size);
+    TEST_ASSERT_EQUAL(-1, apply(delta_image, delta_size, CHUNK_DATA_SIZE));
+    TEST_ASSERT_EQUAL(0, pages_erased);
+    TEST_ASSERT_EQUAL_MEMORY(interrupted, flash, size);
+}
+
+TEST(TbootDelta, test_any_split_of_the_stream)
+{
+    const uint32_t old_size = 20u * 1024u;
+    const uint32_t pieces[] = {1, 7, 9, 64, 511};
+
+    make_firmware(old_image, old_size, 3);
+    memcpy(new_image, old_image, old_size);
+    memmove(&new_image[5010], &new_image[5000], old_size - 5000);
+    memset(&new_image[5000], 0x11, 10);
+    new_image[15000] ^= 0xFF;
+
+    uint32_t delta_size = make_delta(old_image, old_size, new_image, old_size + 10, delta_image);
+
+    for (uint32_t i = 0; i < sizeof(pieces) / sizeof(pieces[0]); i++)
+    {
+        install(old_image, old_size);
+        TEST_ASSERT_EQUAL(0, apply(delta_image, delta_size, pieces[i]));
+        TEST_ASSERT_EQUAL_MEMORY(new_image, flash, old_size + 10);
+    }
+}
+
+TEST(TbootDelta, test_other_installed_version_is_refused_before_erasing)
+{
+    const uint32_t size = 8u * 1024u;
+
+    make_firmware(old_image, size, 4);
+    memcpy(new_image, old_image, size);
+    new_image[100] ^= 0xFF;
+    uint32_t delta_size = make_delta(old_image, size, new_image, size, delta_image);
+
+    // The device runs another build than the delta was made for
+    old_image[5000] ^= 0x01;
+    install(old_image, size);
+
+    TEST_ASSERT_EQUAL(-1, apply(delta_image, delta_size, CHUNK_DATA_SIZE));
+    TEST_ASSERT_EQUAL(0, pages_erased);
+    TEST_ASSERT_EQUAL_MEMORY(old_image, flash, size);
+}
+
+TEST(TbootDelta, test_corrupted_delta_fails_verification)
+{
+    const uint32_t size = 8u * 1024u;
+
+    make_firmware(old_image, size, 5);
+    memcpy(new_image, old_image, size);
+    memset(&new_image[4000], 0x77, 100);
+    uint32_t delta_size = make_delta(old_image, size, new_image, size, delta_image);
+
+    // Flip a byte of the INSERT data, the operations still parse
+    for (uint32_t i = sizeof(t_boot_delta_header_t); i < delta_size; i++)
+    {
+        if (delta_image[i] == T_BOOT_DELTA_OP_INSERT)
+        {
+            delta_image[i + 3] ^= 0x01;
+            break;
+        }
+    }
+
+    install(old_image, size);
+    TEST_ASSERT_EQUAL(-1, apply(delta_image, delta_size, CHUNK_DATA_SIZE));
+}
+
+TEST(TbootDelta, test_copy_from_overwritten_page_is_refused)
+{
+    const uint32_t size = 4u * PAGE_SIZE;
+    uint8_t        delta[sizeof(t_boot_delta_header_t) + 18];
+
+    make_firmware(old_image, size, 6);
+    memcpy(new_image, old_image, size);
+    uint32_t length = make_delta(old_image, size, new_image, size, delta);
+
+    // A valid single COPY of everything, rewritten into two: page 0 and then page 1 from old page 0
+    TEST_ASSERT_EQUAL(sizeof(t_boot_delta_header_t) + 9, length);
+    put_u32(&delta[sizeof(t_boot_delta_header_t) + 5], PAGE_SIZE);
+    delta[sizeof(t_boot_delta_header_t) + 9] = T_BOOT_DELTA_OP_COPY;
+    put_u32(&delta[sizeof(t_boot_delta_header_t) + 10], 0);
+    put_u32(&delta[sizeof(t_boot_delta_header_t) + 14], 3 * PAGE_SIZE);
+
+    install(old_image, size);
+    TEST_ASSERT_EQUAL(-1, apply(delta, sizeof(delta), CHUNK_DATA_SIZE));
+}
+
+TEST_GROUP_RUNNER(TbootDelta)
+{
+    RUN_TEST_CASE(TbootDelta, test_delta_from_script_applies);
+
+    RUN_TEST_CASE(TbootDelta, test_synthetic_pairs_are_bit_exact);
+
+    RUN_TEST_CASE(TbootDelta, test_unchanged_pages_are_not_erased);
+
+    RUN_TEST_CASE(TbootDelta, test_shorter_image_leaves_no_old_data_behind);
+
+    RUN_TEST_CASE(TbootDelta, test_any_split_of_the_stream);
+
+    RUN_TEST_CASE(TbootDelta, test_other_installed_version_is_refused_before_erasing);
+
+    RUN_TEST_CASE(TbootDelta, test_interrupted_apply_is_refused_again);
+
+    RUN_TEST_CASE(TbootDelta, test_corrupted_delta_fails_verification);
+
+    RUN_TEST_CASE(TbootDelta, test_copy_from_overwritten_page_is_refused);
+}
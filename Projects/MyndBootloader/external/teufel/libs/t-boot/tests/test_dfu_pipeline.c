@@ -0,0 +1,240 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "t_boot_dfu.h"
+#include "t_boot_ram_disk.h"
+#include "t_boot_sim.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+// Host harness for the MSC write path: a scripted host writes an update image sector by sector
+// into the RAM disk, the DFU target programs a simulated STM32F072 flash.
+
+// A WRITE(10) command of 64 kB costs one more frame for CBW/CSW
+#define USB_COMMAND_SECTORS     128u
+#define USB_COMMAND_OVERHEAD_NS 1000000u
+
+// Copying a sector into the double buffer in the USB interrupt
+#define SECTOR_COPY_NS 11000u
+
+// First data sector of the RAM disk, where the host puts the update file
+#define FILE_SECTOR 287u
+
+static struct
+{
+    uint64_t next_arrival_ns;
+    uint32_t next_sector;
+    uint32_t sectors;
+    uint32_t holds;
+    bool     armed;
+    bool     held;
+    bool     pipelined;
+} host;
+
+static uint8_t image[APP_FLASH_SIZE];
+
+static t_boot_sim_file_t file = {
+    .p_payload    = image,
+    .component_id = T_BOOT_DFU_COMPONENT_ID_MCU,
+};
+
+static const t_boot_dfu_target_t sim_targets[] = {{
+    .name         = "MCU",
+    .component_id = T_BOOT_DFU_COMPONENT_ID_MCU,
+    .prepare      = t_boot_sim_target_prepare,
+    .write        = t_boot_sim_target_write,
+}};
+
+static const t_boot_config_t sim_config = {
+    .p_dfu_target_list    = sim_targets,
+    .dfu_target_list_size = 1,
+    .update_successful_fn = t_boot_sim_on_complete,
+    .update_error_fn      = t_boot_sim_on_error,
+};
+
+static void host_arm(void)
+{
+    host.armed           = true;
+    host.next_arrival_ns = t_boot_sim.now_ns + USB_SECTOR_NS;
+    if (host.next_sector % USB_COMMAND_SECTORS == 0)
+    {
+        host.next_arrival_ns += USB_COMMAND_OVERHEAD_NS;
+    }
+}
+
+// USB interrupt: a complete sector was received into the MSC buffer
+static void host_deliver_due(void)
+{
+    while (host.armed && host.next_sector < host.sectors && host.next_arrival_ns <= t_boot_sim.now_ns)
+    {
+        uint8_t sector[SECTOR_SIZE];
+
+        t_boot_sim_make_sector(&file, host.next_sector, sector);
+        host.next_sector++;
+        host.armed = false;
+
+        if (host.pipelined)
+        {
+            TEST_ASSERT_EQUAL(0, t_boot_ram_disk_write_block(sector, FILE_SECTOR + host.next_sector, 1));
+            t_boot_sim.now_ns += SECTOR_COPY_NS;
+
+            // usbd_storage_hold_receive(): NAK the host until a sector buffer is free again
+            if (t_boot_ram_disk_can_receive())
+            {
+                host_arm();
+            }
+            else
+            {
+                host.held = true;
+                host.holds++;
+            }
+        }
+        else
+        {
+            // Before: the chunk was programmed inside the MSC write callback
+            t_boot_dfu_process_chunk(sector, 1);
+            host_arm();
+        }
+    }
+}
+
+static uint64_t run_update(uint32_t image_size, bool pipelined)
+{
+    // The USB interrupt gets to run between two flash operations
+    t_boot_sim_init(host_deliver_due);
+    memset(&host, 0, sizeof(host));
+    file.size      = image_size;
+    host.sectors   = 2 + t_boot_sim_file_chunks(&file);
+    host.pipelined = pipelined;
+
+    if (t_boot_dfu_init(&sim_config) != 0)
+    {
+        t_boot_sim.failed = true;
+        return 0;
+    }
+    host_arm();
+
+    // Main loop
+    while (!t_boot_sim.complete && !t_boot_sim.failed)
+    {
+        if (pipelined && t_boot_ram_disk_process())
+        {
+            // usbd_storage_process(): resume the held back reception
+            if (host.held && t_boot_ram_disk_can_receive())
+            {
+                host.held = false;
+                host_arm();
+            }
+            continue;
+        }
+
+        if (!host.armed || host.next_sector >= host.sectors)
+        {
+            break;
+        }
+
+        // Idle until the next sector arrives
+        if (t_boot_sim.now_ns < host.next_arrival_ns)
+        {
+            t_boot_sim.now_ns = host.next_arrival_ns;
+        }
+        host_deliver_due();
+    }
+
+    return t_boot_sim.now_ns;
+}
+
+TEST_GROUP(TbootDfuPipeline);
+
+TEST_SETUP(TbootDfuPipeline)
+{
+    uint32_t seed = 0x12345678;
+    for (uint32_t i = 0; i < sizeof(image); i++)
+    {
+        seed     = seed * 1103515245u + 12345u;
+        image[i] = (uint8_t) (seed >> 16);
+    }
+}
+
+TEST_TEAR_DOWN(TbootDfuPipeline) {}
+
+TEST(TbootDfuPipeline, test_image_is_programmed_bit_exact)
+{
+    // Not a multiple of the chunk size, the last chunk is short
+    const uint32_t size = 100u * 1024u + 130u;
+
+    run_update(size, true);
+
+    TEST_ASSERT_TRUE(t_boot_sim.complete);
+    TEST_ASSERT_FALSE(t_boot_sim.failed);
+    TEST_ASSERT_EQUAL(host.sectors, host.next_sector);
+    TEST_ASSERT_EQUAL_MEMORY(image, t_boot_sim_flash, size);
+    TEST_ASSERT_GREATER_THAN(0, host.holds);
+
+    // Nothing left behind in the sector buffers
+    TEST_ASSERT_EQUAL(0, t_boot_ram_disk_process());
+    TEST_ASSERT_TRUE(t_boot_ram_disk_can_receive());
+}
+
+TEST(TbootDfuPipeline, test_full_buffers_hold_the_host_back)
+{
+    uint8_t sector[SECTOR_SIZE];
+
+    file.size = 4 * DATA_PER_CHUNK;
+    TEST_ASSERT_EQUAL(0, t_boot_dfu_init(&sim_config));
+
+    t_boot_sim_make_sector(&file, 0, sector);
+    TEST_ASSERT_EQUAL(0, t_boot_ram_disk_write_block(sector, FILE_SECTOR + 1, 1));
+    TEST_ASSERT_TRUE(t_boot_ram_disk_can_receive());
+
+    t_boot_sim_make_sector(&file, 1, sector);
+    TEST_ASSERT_EQUAL(0, t_boot_ram_disk_write_block(sector, FILE_SECTOR + 2, 1));
+    TEST_ASSERT_FALSE(t_boot_ram_disk_can_receive());
+
+    // The USB driver does not arm the endpoint anymore, a block that still arrives is refused
+    t_boot_sim_make_sector(&file, 2, sector);
+    TEST_ASSERT_EQUAL(-1, t_boot_ram_disk_write_block(sector, FILE_SECTOR + 3, 1));
+
+    // Other writes of the host (FAT, directory) are not DFU chunks and never take a buffer
+    memset(sector, 0, sizeof(sector));
+    TEST_ASSERT_EQUAL(0, t_boot_ram_disk_write_block(sector, FILE_SECTOR + 4, 1));
+
+    TEST_ASSERT_EQUAL(1, t_boot_ram_disk_process());
+    TEST_ASSERT_TRUE(t_boot_ram_disk_can_receive());
+    TEST_ASSERT_EQUAL(1, t_boot_ram_disk_process());
+    TEST_ASSERT_EQUAL(0, t_boot_ram_disk_process());
+}
+
+TEST(TbootDfuPipeline, test_update_time_compared_to_synchronous_programming)
+{
+    const uint32_t size = APP_FLASH_SIZE;
+
+    uint64_t synchronous_ns = run_update(size, false);
+    TEST_ASSERT_TRUE(t_boot_sim.complete);
+    TEST_ASSERT_EQUAL_MEMORY(image, t_boot_sim_flash, size);
+
+    uint64_t pipelined_ns = run_update(size, true);
+    TEST_ASSERT_TRUE(t_boot_sim.complete);
+    TEST_ASSERT_EQUAL_MEMORY(image, t_boot_sim_flash, size);
+
+    TEST_PRINTF("update of %u bytes: synchronous %u ms, pipelined %u ms (%u%% faster)\r\n", size,
+                (unsigned) (synchronous_ns / 1000000u), (unsigned) (pipelined_ns / 1000000u),
+                (unsigned) ((synchronous_ns - pipelined_ns) * 100u / synchronous_ns));
+
+    // Programming a chunk takes far longer than receiving it: the transfer of every chunk is hidden behind the
+    // programming of the previous one, what is left is the erase and the programming itself
+    uint32_t transfer_us    = (host.sectors - 2) * (USB_SECTOR_NS / 1000u);
+    uint32_t synchronous_us = (uint32_t) (synchronous_ns / 1000u);
+    uint32_t pipelined_us   = (uint32_t) (pipelined_ns / 1000u);
+    TEST_ASSERT_LESS_THAN_UINT32(synchronous_us, pipelined_us);
+    TEST_ASSERT_GREATER_THAN_UINT32(transfer_us * 8u / 10u, synchronous_us - pipelined_us);
+}
+
+TEST_GROUP_RUNNER(TbootDfuPipeline)
+{
+    RUN_TEST_CASE(TbootDfuPipeline, test_image_is_programmed_bit_exact);
+
+    RUN_TEST_CASE(TbootDfuPipeline, test_full_buffers_hold_the_host_back);
+
+    RUN_TEST_CASE(TbootDfuPipeline, test_update_time_compared_to_synchronous_programming);
+}
@@ -0,0 +1,214 @@
+#include <stdbool.h>
+#include <string.h>
+
+#include "t_boot_dfu.h"
+#include "t_boot_sim.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+// Host harness for interrupted updates: the host sends the update file sector by sector and is cut off at
+// random points, then the device restarts and the host sends the whole file again.
+
+static uint8_t image[APP_FLASH_SIZE];
+
+static const t_boot_sim_file_t file = {
+    .p_payload    = image,
+    .size         = APP_FLASH_SIZE,
+    .component_id = T_BOOT_DFU_COMPONENT_ID_MCU,
+};
+
+// Backup registers, they survive the reset
+static struct
+{
+    bool                    valid;
+    t_boot_dfu_checkpoint_t checkpoint;
+    uint32_t                saves;
+} backup;
+
+static uint32_t rng_state;
+
+static uint32_t rng(void)
+{
+    rng_state = rng_state * 1103515245u + 12345u;
+    return rng_state >> 8;
+}
+
+static void checkpoint_save(const t_boot_dfu_checkpoint_t *p_checkpoint)
+{
+    backup.valid      = p_checkpoint->offset != 0;
+    backup.checkpoint = *p_checkpoint;
+    backup.saves++;
+}
+
+static bool checkpoint_load(t_boot_dfu_checkpoint_t *p_checkpoint)
+{
+    *p_checkpoint = backup.checkpoint;
+    return backup.valid;
+}
+
+static const t_boot_dfu_target_t sim_targets[] = {{
+    .name         = "MCU",
+    .component_id = T_BOOT_DFU_COMPONENT_ID_MCU,
+    .init         = t_boot_sim_target_init,
+    .prepare      = t_boot_sim_target_prepare,
+    .write        = t_boot_sim_target_write,
+    .read         = t_boot_sim_target_read,
+    .resume       = t_boot_sim_target_resume,
+}};
+
+static const t_boot_config_t resume_config = {
+    .p_dfu_target_list    = sim_targets,
+    .dfu_target_list_size = 1,
+    .update_successful_fn = t_boot_sim_on_complete,
+    .update_error_fn      = t_boot_sim_on_error,
+    .checkpoint_save_fn   = checkpoint_save,
+    .checkpoint_load_fn   = checkpoint_load,
+};
+
+static const t_boot_config_t restart_config = {
+    .p_dfu_target_list    = sim_targets,
+    .dfu_target_list_size = 1,
+    .update_successful_fn = t_boot_sim_on_complete,
+    .update_error_fn      = t_boot_sim_on_error,
+};
+
+// Power on or reset of the device
+static void device_start(const t_boot_config_t *p_config)
+{
+    t_boot_sim.complete = false;
+    t_boot_sim.failed   = false;
+    TEST_ASSERT_EQUAL(0, t_boot_dfu_init(p_config));
+}
+
+// The host sends the update file, up to the given number of sectors
+static int host_send(uint32_t sectors)
+{
+    uint8_t sector[SECTOR_SIZE];
+    int     result = 0;
+
+    for (uint32_t n = 0; n < sectors && result == 0; n++)
+    {
+        t_boot_sim_make_sector(&file, n, sector);
+        t_boot_sim.now_ns += USB_SECTOR_NS;
+        result = t_boot_dfu_process_chunk(sector, SECTOR_SIZE);
+    }
+
+    return result;
+}
+
+// Cut after the given number of chunks, restart the device and send the whole file again
+static uint64_t interrupted_update(const t_boot_config_t *p_config, uint32_t cut_chunks)
+{
+    t_boot_sim.now_ns = 0;
+
+    device_start(p_config);
+    TEST_ASSERT_EQUAL(0, host_send(2 + cut_chunks));
+
+    device_start(p_config);
+    TEST_ASSERT_EQUAL(1, host_send(2 + t_boot_sim_file_chunks(&file)));
+    TEST_ASSERT_TRUE(t_boot_sim.complete);
+    TEST_ASSERT_FALSE(t_boot_sim.failed);
+
+    return t_boot_sim.now_ns;
+}
+
+TEST_GROUP(TbootDfuResume);
+
+TEST_SETUP(TbootDfuResume)
+{
+    rng_state = 0x2468ACE;
+    for (uint32_t i = 0; i < sizeof(image); i++)
+    {
+        image[i] = (uint8_t) rng();
+    }
+
+    // The previous firmware
+    t_boot_sim_init(NULL);
+    for (uint32_t i = 0; i < sizeof(t_boot_sim_flash); i++)
+    {
+        t_boot_sim_flash[i] = (uint8_t) (i * 7u);
+    }
+    memset(&backup, 0, sizeof(backup));
+}
+
+TEST_TEAR_DOWN(TbootDfuResume) {}
+
+TEST(TbootDfuResume, test_resumed_updates_are_bit_exact_and_faster)
+{
+    const uint32_t runs      = 8;
+    uint64_t       resume_ns = 0, restart_ns = 0;
+
+    for (uint32_t run = 0; run < runs; run++)
+    {
+        uint32_t cut = 1 + rng() % (t_boot_sim_file_chunks(&file) - 1);
+
+        memset(&backup, 0, sizeof(backup));
+        resume_ns += interrupted_update(&resume_config, cut);
+        TEST_ASSERT_EQUAL_MEMORY(image, t_boot_sim_flash, APP_FLASH_SIZE);
+        TEST_ASSERT_FALSE(backup.valid);
+
+        restart_ns += interrupted_update(&restart_config, cut);
+        TEST_ASSERT_EQUAL_MEMORY(image, t_boot_sim_flash, APP_FLASH_SIZE);
+    }
+
+    TEST_PRINTF("interrupted update of %u bytes: %u ms with resuming, %u ms starting over\r\n", APP_FLASH_SIZE,
+                (unsigned) (resume_ns / runs / 1000000u), (unsigned) (restart_ns / runs / 1000000u));
+
+    // The programmed part isn't erased and programmed again
+    TEST_ASSERT_LESS_THAN_UINT32((uint32_t) (restart_ns / runs / 1000u), (uint32_t) (resume_ns / runs / 1000u));
+}
+
+TEST(TbootDfuResume, test_host_starts_over_without_reset)
+{
+    // The cable is pulled and plugged again, the device keeps running
+    device_start(&resume_config);
+    TEST_ASSERT_EQUAL(0, host_send(2 + 150));
+    TEST_ASSERT_EQUAL(1, host_send(2 + t_boot_sim_file_chunks(&file)));
+
+    TEST_ASSERT_TRUE(t_boot_sim.complete);
+    TEST_ASSERT_EQUAL_MEMORY(image, t_boot_sim_flash, APP_FLASH_SIZE);
+}
+
+TEST(TbootDfuResume, test_checkpoint_of_other_firmware_is_ignored)
+{
+    device_start(&resume_config);
+    TEST_ASSERT_EQUAL(0, host_send(2 + 200));
+    TEST_ASSERT_TRUE(backup.valid);
+
+    // A different firmware is sent after the reset
+    image[0] ^= 0xFF;
+    device_start(&resume_config);
+    TEST_ASSERT_EQUAL(1, host_send(2 + t_boot_sim_file_chunks(&file)));
+
+    TEST_ASSERT_TRUE(t_boot_sim.complete);
+    TEST_ASSERT_EQUAL_MEMORY(image, t_boot_sim_flash, APP_FLASH_SIZE);
+}
+
+TEST(TbootDfuResume, test_changed_flash_fails_and_next_update_starts_over)
+{
+    device_start(&resume_config);
+    TEST_ASSERT_EQUAL(0, host_send(2 + 200));
+
+    // The programmed part doesn't hold what the checkpoint claims
+    t_boot_sim_flash[1000] ^= 0x01;
+
+    device_start(&resume_config);
+    TEST_ASSERT_EQUAL(-T_BOOT_DFU_ERROR_WRITE, host_send(2 + t_boot_sim_file_chunks(&file)));
+    TEST_ASSERT_TRUE(t_boot_sim.failed);
+    TEST_ASSERT_FALSE(backup.valid);
+
+    device_start(&resume_config);
+    TEST_ASSERT_EQUAL(1, host_send(2 + t_boot_sim_file_chunks(&file)));
+    TEST_ASSERT_EQUAL_MEMORY(image, t_boot_sim_flash, APP_FLASH_SIZE);
+}
+
+TEST_GROUP_RUNNER(TbootDfuResume)
+{
+    RUN_TEST_CASE(TbootDfuResume, test_resumed_updates_are_bit_exact_and_faster);
+
+    RUN_TEST_CASE(TbootDfuResume, test_host_starts_over_without_reset);
+
+    RUN_TEST_CASE(TbootDfuResume, test_checkpoint_of_other_firmware_is_ignored);
+
+    RUN_TEST_CASE(TbootDfuResume, test_changed_flash_fails_and_next_update_starts_over);
+}
@@ -0,0 +1,326 @@
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "t_boot_dfu.h"
+#include "t_boot_ram_disk.h"
+#include "t_boot_sim.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+// Host harness for the RAM disk: the sector sequences of Linux, macOS and Windows copying the update file to the
+// disk, as passed to the storage callbacks one sector at a time by the MSC class.
+
+#define IMAGE_SIZE   (16u * 1024u)
+#define FILE_SECTORS (2u + IMAGE_SIZE / DATA_PER_CHUNK)
+
+// Layout of the FAT16 disk, see t_boot_ram_disk.c
+#define FAT1_SECTOR      1u
+#define FAT2_SECTOR      128u
+#define ROOT_DIR_SECTOR  255u
+#define DATA_SECTOR      287u
+
+typedef enum
+{
+    READ,
+    WRITE_METADATA, // boot, FAT or directory sector, read back later
+    WRITE_FILE,     // the update file, from its first sector on
+    WRITE_OTHER,    // data of other files, e.g. .fseventsd or System Volume Information
+    CHECK_METADATA, // read back, expects the last write to this sector
+} step_type_t;
+
+typedef struct
+{
+    step_type_t type;
+    uint32_t    sector;
+    uint32_t    count;
+} step_t;
+
+// clang-format off
+// Linux vfat, cp and umount: the data is written back first, then the FAT copies and the directory
+static const step_t linux_trace[] = {
+    {READ, 0, 1}, {READ, FAT1_SECTOR, 1}, {READ, ROOT_DIR_SECTOR, 1},
+    {WRITE_FILE, DATA_SECTOR, FILE_SECTORS},
+    {WRITE_METADATA, FAT1_SECTOR, 1}, {WRITE_METADATA, FAT2_SECTOR, 1}, {WRITE_METADATA, ROOT_DIR_SECTOR, 1},
+};
+
+// macOS Finder: .fseventsd is created first, the directory and FAT are written after every step, the
+// AppleDouble file ._ follows the data and the directory is read back
+static const step_t macos_trace[] = {
+    {READ, 0, 1}, {READ, FAT1_SECTOR, 1}, {READ, ROOT_DIR_SECTOR, 4},
+    {WRITE_METADATA, ROOT_DIR_SECTOR, 1}, {WRITE_METADATA, FAT1_SECTOR, 1}, {WRITE_METADATA, FAT2_SECTOR, 1},
+    {WRITE_OTHER, DATA_SECTOR, 1},
+    {WRITE_METADATA, ROOT_DIR_SECTOR, 1}, {WRITE_METADATA, FAT1_SECTOR, 1}, {WRITE_METADATA, FAT2_SECTOR, 1},
+    {CHECK_METADATA, ROOT_DIR_SECTOR, 1},
+    {WRITE_FILE, DATA_SECTOR + 1, FILE_SECTORS},
+    {WRITE_METADATA, ROOT_DIR_SECTOR, 1}, {WRITE_METADATA, FAT1_SECTOR, 1}, {WRITE_METADATA, FAT2_SECTOR, 1},
+    {WRITE_OTHER, DATA_SECTOR + 1 + FILE_SECTORS, 8},
+    {WRITE_METADATA, ROOT_DIR_SECTOR, 1}, {WRITE_METADATA, FAT1_SECTOR, 1}, {WRITE_METADATA, FAT2_SECTOR, 1},
+    {CHECK_METADATA, ROOT_DIR_SECTOR, 1}, {CHECK_METADATA, FAT1_SECTOR, 1}, {CHECK_METADATA, FAT2_SECTOR, 1},
+};
+
+// Windows Explorer: System Volume Information is created on the first mount, the directory entry is created
+// before the data and updated after it
+static const step_t windows_trace[] = {
+    {READ, 0, 1}, {READ, FAT1_SECTOR, 1}, {READ, ROOT_DIR_SECTOR, 1},
+    {WRITE_METADATA, ROOT_DIR_SECTOR, 1}, {WRITE_METADATA, FAT1_SECTOR, 1}, {WRITE_METADATA, FAT2_SECTOR, 1},
+    {WRITE_OTHER, DATA_SECTOR, 2},
+    {WRITE_METADATA, ROOT_DIR_SECTOR, 1}, {WRITE_METADATA, FAT1_SECTOR, 1}, {WRITE_METADATA, FAT2_SECTOR, 1},
+    {WRITE_FILE, DATA_SECTOR + 2, FILE_SECTORS},
+    {WRITE_METADATA, FAT1_SECTOR, 1}, {WRITE_METADATA, FAT2_SECTOR, 1}, {WRITE_METADATA, ROOT_DIR_SECTOR, 1},
+    {CHECK_METADATA, ROOT_DIR_SECTOR, 1}, {CHECK_METADATA, FAT2_SECTOR, 1},
+};
+// clang-format on
+
+static uint8_t image[IMAGE_SIZE];
+
+static const t_boot_sim_file_t file = {
+    .p_payload    = image,
+    .size         = IMAGE_SIZE,
+    .component_id = T_BOOT_DFU_COMPONENT_ID_MCU,
+};
+
+static struct
+{
+    uint32_t sectors;
+    uint32_t chunks;
+    uint32_t checks;
+    uint64_t handling_ns;
+    uint8_t  written[3][SECTOR_SIZE]; // last FAT, FAT copy and directory sector written
+} host;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static const t_boot_dfu_target_t sim_targets[] = {{
+    .name         = "MCU",
+    .component_id = T_BOOT_DFU_COMPONENT_ID_MCU,
+    .prepare      = t_boot_sim_target_prepare,
+    .write        = t_boot_sim_target_write,
+}};
+
+static const t_boot_config_t sim_config = {
+    .p_dfu_target_list    = sim_targets,
+    .dfu_target_list_size = 1,
+    .update_successful_fn = t_boot_sim_on_complete,
+    .update_error_fn      = t_boot_sim_on_error,
+};
+
+static uint8_t *last_written(uint32_t sector)
+{
+    return host.written[sector == FAT1_SECTOR ? 0 : sector == FAT2_SECTOR ? 1 : 2];
+}
+
+static void host_write(const uint8_t *p_sector, uint32_t sector)
+{
+    uint64_t start = now_ns();
+    TEST_ASSERT_EQUAL(0, t_boot_ram_disk_write_block((uint8_t *) p_sector, sector, 1));
+    host.handling_ns += now_ns() - start;
+    host.sectors++;
+
+    // The main loop catches up before the MSC class passes the next sector
+    while (t_boot_ram_disk_process())
+    {
+        host.chunks++;
+    }
+}
+
+static void host_read(uint8_t *p_sector, uint32_t sector)
+{
+    uint64_t start = now_ns();
+    TEST_ASSERT_EQUAL(0, t_boot_ram_disk_read_block(p_sector, sector, 1));
+    host.handling_ns += now_ns() - start;
+    host.sectors++;
+}
+
+static void run_step(const step_t *p_step, uint32_t index)
+{
+    uint8_t sector[SECTOR_SIZE];
+
+    for (uint32_t i = 0; i < p_step->count; i++)
+    {
+        switch (p_step->type)
+        {
+            case READ:
+                host_read(sector, p_step->sector + i);
+                break;
+            case WRITE_METADATA:
+                // Different content for every write, the FAT copies are the same
+                memset(sector, (uint8_t) (index & ~1u), SECTOR_SIZE);
+                memcpy(sector, &index, sizeof(index));
+                sector[4] = 0xF8;
+                if (p_step->sector == FAT2_SECTOR)
+                {
+                    memcpy(sector, last_written(FAT1_SECTOR), SECTOR_SIZE);
+                }
+                memcpy(last_written(p_step->sector), sector, SECTOR_SIZE);
+                host_write(sector, p_step->sector);
+                break;
+            case WRITE_FILE:
+                t_boot_sim_make_sector(&file, i, sector);
+                host_write(sector, p_step->sector + i);
+                break;
+            case WRITE_OTHER:
+                memset(sector, 0, SECTOR_SIZE);
+                sector[0] = (i == 0) ? 0x00 : 0x2E; // AppleDouble or directory entries
+                sector[1] = 0x05;
+                sector[2] = 0x16;
+                sector[3] = 0x07;
+                host_write(sector, p_step->sector + i);
+                break;
+            case CHECK_METADATA:
+                host_read(sector, p_step->sector);
+                TEST_ASSERT_EQUAL_MEMORY(last_written(p_step->sector), sector, SECTOR_SIZE);
+                host.checks++;
+                break;
+        }
+    }
+}
+
+static void run_trace(const char *name, const step_t *p_trace, uint32_t steps)
+{
+    t_boot_sim_init(NULL);
+    memset(&host, 0, sizeof(host));
+    TEST_ASSERT_EQUAL(0, t_boot_dfu_init(&sim_config));
+
+    for (uint32_t i = 0; i < steps; i++)
+    {
+        run_step(&p_trace[i], i);
+    }
+
+    TEST_ASSERT_TRUE(t_boot_sim.complete);
+    TEST_ASSERT_FALSE(t_boot_sim.failed);
+    TEST_ASSERT_EQUAL(FILE_SECTORS, host.chunks);
+    TEST_ASSERT_EQUAL_MEMORY(image, t_boot_sim_flash, IMAGE_SIZE);
+
+    TEST_PRINTF("%-8s %3u sectors, %u chunks, %u read back, %u ns per sector\r\n", name, host.sectors, host.chunks,
+                host.checks, (unsigned) (host.handling_ns / host.sectors));
+}
+
+TEST_GROUP(TbootRamDisk);
+
+TEST_SETUP(TbootRamDisk)
+{
+    for (uint32_t i = 0; i < sizeof(image); i++)
+    {
+        image[i] = (uint8_t) (i * 31u + (i >> 8));
+    }
+}
+
+TEST_TEAR_DOWN(TbootRamDisk) {}
+
+TEST(TbootRamDisk, test_multi_block_reads)
+{
+    static uint8_t blocks[40 * SECTOR_SIZE];
+    uint8_t        sector[SECTOR_SIZE];
+
+    for (uint32_t first = 0; first < DATA_SECTOR + 20; first += 20)
+    {
+        memset(blocks, 0xA5, sizeof(blocks));
+        TEST_ASSERT_EQUAL(0, t_boot_ram_disk_read_block(blocks, first, 40));
+
+        for (uint32_t i = 0; i < 40; i++)
+        {
+            TEST_ASSERT_EQUAL(0, t_boot_ram_disk_read_block(sector, first + i, 1));
+            TEST_ASSERT_EQUAL_MEMORY(sector, &blocks[i * SECTOR_SIZE], SECTOR_SIZE);
+        }
+    }
+
+    // Both FAT copies start the same
+    uint8_t fat[2][SECTOR_SIZE];
+    TEST_ASSERT_EQUAL(0, t_boot_ram_disk_read_block(fat[0], FAT1_SECTOR, 1));
+    TEST_ASSERT_EQUAL(0, t_boot_ram_disk_read_block(fat[1], FAT2_SECTOR, 1));
+    TEST_ASSERT_EQUAL_MEMORY(fat[0], fat[1], SECTOR_SIZE);
+    TEST_ASSERT_EQUAL_HEX8(0xF8, fat[1][0]);
+
+    TEST_ASSERT_EQUAL(0, t_boot_ram_disk_read_block(sector, 0, 1));
+    TEST_ASSERT_EQUAL_HEX8(0x55, sector[SECTOR_SIZE - 2]);
+    TEST_ASSERT_EQUAL_HEX8(0xAA, sector[SECTOR_SIZE - 1]);
+}
+
+TEST(TbootRamDisk, test_multi_block_write_of_chunks)
+{
+    uint8_t blocks[2 * SECTOR_SIZE];
+
+    t_boot_sim_init(NULL);
+    TEST_ASSERT_EQUAL(0, t_boot_dfu_init(&sim_config));
+
+    t_boot_sim_make_sector(&file, 0, &blocks[0]);
+    t_boot_sim_make_sector(&file, 1, &blocks[SECTOR_SIZE]);
+    TEST_ASSERT_EQUAL(0, t_boot_ram_disk_write_block(blocks, DATA_SECTOR, 2));
+    TEST_ASSERT_FALSE(t_boot_ram_disk_can_receive());
+
+    // Not taken at all if not every chunk fits
+    t_boot_sim_make_sector(&file, 2, &blocks[0]);
+    TEST_ASSERT_EQUAL(-1, t_boot_ram_disk_write_block(blocks, DATA_SECTOR + 2, 1));
+
+    TEST_ASSERT_EQUAL(1, t_boot_ram_disk_process());
+    t_boot_sim_make_sector(&file, 3, &blocks[SECTOR_SIZE]);
+    TEST_ASSERT_EQUAL(-1, t_boot_ram_disk_write_block(blocks, DATA_SECTOR + 2, 2));
+    TEST_ASSERT_EQUAL(1, t_boot_ram_disk_process());
+    TEST_ASSERT_EQUAL(0, t_boot_ram_disk_write_block(blocks, DATA_SECTOR + 2, 2));
+
+    for (uint32_t n = 4; n < FILE_SECTORS; n++)
+    {
+        while (t_boot_ram_disk_process())
+        {
+        }
+        t_boot_sim_make_sector(&file, n, blocks);
+        TEST_ASSERT_EQUAL(0, t_boot_ram_disk_write_block(blocks, DATA_SECTOR + n, 1));
+    }
+    while (t_boot_ram_disk_process())
+    {
+    }
+
+    TEST_ASSERT_TRUE(t_boot_sim.complete);
+    TEST_ASSERT_EQUAL_MEMORY(image, t_boot_sim_flash, IMAGE_SIZE);
+}
+
+TEST(TbootRamDisk, test_metadata_cache_keeps_recent_sectors)
+{
+    uint8_t sector[SECTOR_SIZE], read[SECTOR_SIZE];
+
+    // More directory sectors than the cache holds, the least recently used one is dropped
+    for (uint32_t i = 0; i <= T_BOOT_RAM_DISK_CACHE_SECTORS; i++)
+    {
+        memset(sector, 0x40 + i, sizeof(sector));
+        TEST_ASSERT_EQUAL(0, t_boot_ram_disk_write_block(sector, ROOT_DIR_SECTOR + 1 + i, 1));
+    }
+
+    TEST_ASSERT_EQUAL(0, t_boot_ram_disk_read_block(read, ROOT_DIR_SECTOR + 1, 1));
+    memset(sector, 0, sizeof(sector));
+    TEST_ASSERT_EQUAL_MEMORY(sector, read, SECTOR_SIZE);
+
+    for (uint32_t i = 1; i <= T_BOOT_RAM_DISK_CACHE_SECTORS; i++)
+    {
+        TEST_ASSERT_EQUAL(0, t_boot_ram_disk_read_block(read, ROOT_DIR_SECTOR + 1 + i, 1));
+        memset(sector, 0x40 + i, sizeof(sector));
+        TEST_ASSERT_EQUAL_MEMORY(sector, read, SECTOR_SIZE);
+    }
+
+    // Metadata never reaches the DFU
+    TEST_ASSERT_TRUE(t_boot_ram_disk_can_receive());
+    TEST_ASSERT_EQUAL(0, t_boot_ram_disk_process());
+}
+
+TEST(TbootRamDisk, test_host_traces)
+{
+    run_trace("Linux", linux_trace, sizeof(linux_trace) / sizeof(linux_trace[0]));
+    run_trace("macOS", macos_trace, sizeof(macos_trace) / sizeof(macos_trace[0]));
+    run_trace("Windows", windows_trace, sizeof(windows_trace) / sizeof(windows_trace[0]));
+}
+
+TEST_GROUP_RUNNER(TbootRamDisk)
+{
+    RUN_TEST_CASE(TbootRamDisk, test_multi_block_reads);
+
+    RUN_TEST_CASE(TbootRamDisk, test_multi_block_write_of_chunks);
+
+    RUN_TEST_CASE(TbootRamDisk, test_metadata_cache_keeps_recent_sectors);
+
+    RUN_TEST_CASE(TbootRamDisk, test_host_traces);
+}
@@ -0,0 +1,319 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "t_boot_config.h"
+#include "t_boot_encryption.h"
+#include "t_boot_sha256.h"
+#include "t_boot_signature.h"
+#include "unity.h"
+#include "unity_fixture.h"
+
+static void sha256(const uint8_t *p_data, size_t length, uint8_t *p_digest)
+{
+    t_boot_sha256_ctx_t ctx;
+    t_boot_sha256_init(&ctx);
+    t_boot_sha256_update(&ctx, p_data, length);
+    t_boot_sha256_final(&ctx, p_digest);
+}
+
+static void hex_to_bytes(const char *p_hex, uint8_t *p_bytes)
+{
+    for (size_t i = 0; p_hex[2 * i] != '\0'; i++)
+    {
+        unsigned int byte;
+        sscanf(&p_hex[2 * i], "%2x", &byte);
+        p_bytes[i] = (uint8_t) byte;
+    }
+}
+
+TEST_GROUP(TbootSha256);
+
+TEST_SETUP(TbootSha256) {}
+
+TEST_TEAR_DOWN(TbootSha256) {}
+
+// FIPS 180-2 / NIST CSRC example vectors
+TEST(TbootSha256, test_nist_vectors)
+{
+    static const struct
+    {
+        const char *p_message;
+        const char *p_digest;
+    } vectors[] = {
+        {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+        {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+        {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+         "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+        {"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+         "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1"},
+    };
+
+    for (size_t i = 0; i < sizeof(vectors) / sizeof(vectors[0]); i++)
+    {
+        uint8_t expected[T_BOOT_SHA256_DIGEST_SIZE];
+        uint8_t digest[T_BOOT_SHA256_DIGEST_SIZE];
+
+        hex_to_bytes(vectors[i].p_digest, expected);
+        sha256((const uint8_t *) vectors[i].p_message, strlen(vectors[i].p_message), digest);
+        TEST_ASSERT_EQUAL_MEMORY(expected, digest, sizeof(digest));
+    }
+}
+
+TEST(TbootSha256, test_nist_million_a)
+{
+    uint8_t             expected[T_BOOT_SHA256_DIGEST_SIZE];
+    uint8_t             digest[T_BOOT_SHA256_DIGEST_SIZE];
+    uint8_t             block[1000];
+    t_boot_sha256_ctx_t ctx;
+
+    memset(block, 'a', sizeof(block));
+    t_boot_sha256_init(&ctx);
+    for (int i = 0; i < 1000; i++)
+    {
+        t_boot_sha256_update(&ctx, block, sizeof(block));
+    }
+    t_boot_sha256_final(&ctx, digest);
+
+    hex_to_bytes("cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0", expected);
+    TEST_ASSERT_EQUAL_MEMORY(expected, digest, sizeof(digest));
+}
+
+TEST(TbootSha256, test_split_updates_match_one_shot)
+{
+    uint8_t message[300];
+    uint8_t expected[T_BOOT_SHA256_DIGEST_SIZE];
+
+    for (size_t i = 0; i < sizeof(message); i++)
+    {
+        message[i] = (uint8_t) (i * 7);
+    }
+    sha256(message, sizeof(message), expected);
+
+    // Every split point around the block and padding boundaries
+    for (size_t split = 0; split <= sizeof(message); split++)
+    {
+        uint8_t             digest[T_BOOT_SHA256_DIGEST_SIZE];
+        t_boot_sha256_ctx_t ctx;
+
+        t_boot_sha256_init(&ctx);
+        t_boot_sha256_update(&ctx, message, split);
+        t_boot_sha256_update(&ctx, message + split, sizeof(message) - split);
+        t_boot_sha256_final(&ctx, digest);
+        TEST_ASSERT_EQUAL_MEMORY(expected, digest, sizeof(digest));
+    }
+}
+
+TEST_GROUP_RUNNER(TbootSha256)
+{
+    RUN_TEST_CASE(TbootSha256, test_nist_vectors);
+
+    RUN_TEST_CASE(TbootSha256, test_nist_million_a);
+
+    RUN_TEST_CASE(TbootSha256, test_split_updates_match_one_shot);
+}
+
+// Sample image, signed with a stand-in for the RSA check: the "signature" holds the SHA-256 digest of the image
+// computed on the host (python3 hashlib), the verify callback compares it with the digest t-boot computed.
+#define IMAGE_SIZE (8u * 1024u + 77u)
+#define CHUNK_SIZE 256u
+
+static const uint8_t image_digest[T_BOOT_SHA256_DIGEST_SIZE] = {
+    0x54, 0x3c, 0x40, 0x69, 0x43, 0x68, 0x96, 0x45, 0xfc, 0xaa, 0x31, 0xdf, 0xe8, 0x1c, 0x54, 0xbc,
+    0x91, 0x83, 0xde, 0x0d, 0xdb, 0x37, 0xe0, 0xfe, 0x4f, 0x42, 0x31, 0xf8, 0x66, 0xdf, 0x36, 0x88,
+};
+
+static uint8_t image[104u * 1024u];
+static uint8_t flash[104u * 1024u];
+static uint8_t signature[T_BOOT_DFU_SIGNATURE_SIZE];
+
+static void make_image(uint32_t size)
+{
+    uint32_t seed = 0x12345678;
+    for (uint32_t i = 0; i < size; i++)
+    {
+        seed     = seed * 1103515245u + 12345u;
+        image[i] = (uint8_t) (seed >> 16);
+    }
+}
+
+static int digest_signature_verify(const uint8_t *p_digest, const uint8_t *p_signature, size_t signature_length)
+{
+    if (signature_length != T_BOOT_DFU_SIGNATURE_SIZE)
+    {
+        return -1;
+    }
+    return memcmp(p_digest, p_signature, T_BOOT_SHA256_DIGEST_SIZE) == 0 ? 0 : -1;
+}
+
+static int flash_read(uint8_t *p_data, uint32_t length, uint32_t offset)
+{
+    memcpy(p_data, &flash[offset], length);
+    return 0;
+}
+
+// Writes chunk n to the simulated flash and hands it to the verifier, like t_boot_dfu_process_chunk()
+static void receive_chunk(t_boot_signature_t *p_sign, uint32_t n, uint32_t size)
+{
+    uint32_t offset = n * CHUNK_SIZE;
+    uint32_t length = size - offset < CHUNK_SIZE ? size - offset : CHUNK_SIZE;
+
+    memcpy(&flash[offset], &image[offset], length);
+    t_boot_signature_update(p_sign, &image[offset], length, offset);
+}
+
+TEST_GROUP(TbootSignature);
+
+TEST_SETUP(TbootSignature)
+{
+    make_image(sizeof(image));
+    memset(flash, 0xFF, sizeof(flash));
+    memset(signature, 0, sizeof(signature));
+    memcpy(signature, image_digest, sizeof(image_digest));
+}
+
+TEST_TEAR_DOWN(TbootSignature) {}
+
+TEST(TbootSignature, test_signed_image_in_order)
+{
+    t_boot_signature_t sign;
+    uint32_t           chunks = (IMAGE_SIZE + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    t_boot_signature_start(&sign);
+    for (uint32_t n = 0; n < chunks; n++)
+    {
+        receive_chunk(&sign, n, IMAGE_SIZE);
+    }
+
+    // Nothing is read back when the chunks arrive in order
+    TEST_ASSERT_EQUAL(IMAGE_SIZE, sign.bytes_hashed);
+    TEST_ASSERT_EQUAL(0, t_boot_signature_finish(&sign, signature, IMAGE_SIZE, NULL, digest_signature_verify));
+}
+
+TEST(TbootSignature, test_tampered_image_is_rejected)
+{
+    t_boot_signature_t sign;
+    uint32_t           chunks = (IMAGE_SIZE + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    image[5000] ^= 0x01;
+
+    t_boot_signature_start(&sign);
+    for (uint32_t n = 0; n < chunks; n++)
+    {
+        receive_chunk(&sign, n, IMAGE_SIZE);
+    }
+
+    TEST_ASSERT_EQUAL(-1, t_boot_signature_finish(&sign, signature, IMAGE_SIZE, NULL, digest_signature_verify));
+}
+
+TEST(TbootSignature, test_out_of_order_chunks_are_read_back)
+{
+    t_boot_signature_t sign;
+    uint32_t           chunks = (IMAGE_SIZE + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+    // The host writes the second half first
+    t_boot_signature_start(&sign);
+    for (uint32_t n = chunks / 2; n < chunks; n++)
+    {
+        receive_chunk(&sign, n, IMAGE_SIZE);
+    }
+    for (uint32_t n = 0; n < chunks / 2; n++)
+    {
+        receive_chunk(&sign, n, IMAGE_SIZE);
+    }
+
+    TEST_ASSERT_EQUAL((chunks / 2) * CHUNK_SIZE, sign.bytes_hashed);
+    TEST_ASSERT_EQUAL(0, t_boot_signature_finish(&sign, signature, IMAGE_SIZE, flash_read, digest_signature_verify));
+}
+
+TEST(TbootSignature, test_out_of_order_without_read_back_fails)
+{
+    t_boot_signature_t sign;
+
+    t_boot_signature_start(&sign);
+    receive_chunk(&sign, 1, IMAGE_SIZE);
+    receive_chunk(&sign, 0, IMAGE_SIZE);
+
+    TEST_ASSERT_EQUAL(-1, t_boot_signature_finish(&sign, signature, IMAGE_SIZE, NULL, digest_signature_verify));
+    TEST_ASSERT_EQUAL(-1, t_boot_signature_finish(&sign, signature, IMAGE_SIZE, flash_read, NULL));
+}
+
+static uint64_t elapsed_ns(const struct timespec *p_start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (uint64_t) (end.tv_sec - p_start->tv_sec) * 1000000000u + (uint64_t) end.tv_nsec - (uint64_t) p_start->tv_nsec;
+}
+
+TEST(TbootSignature, test_verification_time_compared_to_separate_passes)
+{
+    static const uint8_t key[] = T_BOOT_ENCRYPTION_KEY;
+    const uint32_t       size  = sizeof(image);
+    const uint32_t       runs  = 20;
+    uint8_t              expected[T_BOOT_SHA256_DIGEST_SIZE];
+    uint64_t             streaming_ns = 0, streaming_end_ns = 0, passes_end_ns = 0;
+
+    sha256(image, size, expected);
+    memcpy(signature, expected, sizeof(expected));
+    memcpy(flash, image, size);
+
+    for (uint32_t run = 0; run < runs; run++)
+    {
+        t_boot_signature_t sign;
+        struct timespec    start;
+        uint8_t            digest[T_BOOT_SHA256_DIGEST_SIZE];
+        uint8_t            chunk[CHUNK_SIZE];
+
+        // Streaming: every chunk is hashed while it is in the buffer, the end is the signature check
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        t_boot_signature_start(&sign);
+        for (uint32_t offset = 0; offset < size; offset += CHUNK_SIZE)
+        {
+            t_boot_signature_update(&sign, &image[offset], CHUNK_SIZE, offset);
+        }
+        streaming_ns += elapsed_ns(&start);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        TEST_ASSERT_EQUAL(0, t_boot_signature_finish(&sign, signature, size, NULL, digest_signature_verify));
+        streaming_end_ns += elapsed_ns(&start);
+
+        // Separate passes: the written image is walked again at the end, first to undo the obfuscation
+        // and then for the digest
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        t_boot_sha256_ctx_t ctx;
+        t_boot_sha256_init(&ctx);
+        for (uint32_t offset = 0; offset < size; offset += CHUNK_SIZE)
+        {
+            flash_read(chunk, CHUNK_SIZE, offset);
+            t_boot_encryption_decode_in_place(chunk, CHUNK_SIZE, key, sizeof(key) - 1);
+        }
+        for (uint32_t offset = 0; offset < size; offset += CHUNK_SIZE)
+        {
+            flash_read(chunk, CHUNK_SIZE, offset);
+            t_boot_sha256_update(&ctx, chunk, CHUNK_SIZE);
+        }
+        t_boot_sha256_final(&ctx, digest);
+        passes_end_ns += elapsed_ns(&start);
+    }
+
+    TEST_PRINTF("verification of %u bytes, streaming: %u us spread over the chunks + %u us at the end, "
+                "separate passes: %u us at the end\r\n",
+                size, (unsigned) (streaming_ns / runs / 1000u), (unsigned) (streaming_end_ns / runs / 1000u),
+                (unsigned) (passes_end_ns / runs / 1000u));
+
+    // The update finishes with a single block and the signature check instead of two walks over the image
+    TEST_ASSERT_LESS_THAN_UINT32((uint32_t) (passes_end_ns / runs / 100u), (uint32_t) (streaming_end_ns / runs));
+}
+
+TEST_GROUP_RUNNER(TbootSignature)
+{
+    RUN_TEST_CASE(TbootSignature, test_signed_image_in_order);
+
+    RUN_TEST_CASE(TbootSignature, test_tampered_image_is_rejected);
+
+    RUN_TEST_CASE(TbootSignature, test_out_of_order_chunks_are_read_back);
+
+    RUN_TEST_CASE(TbootSignature, test_out_of_order_without_read_back_fails);
+
+    RUN_TEST_CASE(TbootSignature, test_verification_time_compared_to_separate_passes);
+}
@@ -8,6 +8,7 @@
 #include "logger.h"
 
 #include "dfu_mcu.h"
+#include "t_boot_app.h"
 #include "t_boot_dfu.h"
 
 #include "usbd_core.h"
@@ -49,15 +50,10 @@ void jump_to_application(const uint32_t address)
 {
     typedef void (*p_function)(void);
 
-    uint32_t   stack_pointer;
     p_function app_entry;
 
-    stack_pointer = (uint32_t) * ((__IO uint32_t *) address);
-    app_entry     = (p_function) * ((__IO uint32_t *) (address + 4));
-
-    log_err("jump address: 0x%x", address);
-    log_err("stack pointer: 0x%x", stack_pointer);
-    HAL_Delay(10);
+    // Nothing is logged here, the debug UART isn't initialized on the fast path
+    app_entry = (p_function) * ((__IO uint32_t *) (address + 4));
 
     if (((*(__IO uint32_t *) address) & 0x2FFE0000) == 0x20000000)
     {
@@ -91,8 +87,6 @@ void jump_to_application(const uint32_t address)
     }
     else
     {
-        log_err("Firmware has no valid start entry");
-
         while (1)
             ;
     }
@@ -104,8 +98,19 @@ static const t_boot_dfu_target_t t_boot_dfu_target_list[] = {{
     .init         = dfu_mcu_init,
     .prepare      = dfu_mcu_prepare,
     .write        = dfu_mcu_write,
+    .read         = dfu_mcu_read,
+    .resume       = dfu_mcu_resume,
     .verify       = NULL,
     .get_crc32    = NULL,
+},
+{
+    .name         = "MCU delta",
+    .component_id = T_BOOT_DFU_COMPONENT_ID_MCU_DELTA,
+    .init         = dfu_mcu_delta_init,
+    .prepare      = dfu_mcu_delta_prepare,
+    .write        = dfu_mcu_delta_write,
+    .verify       = dfu_mcu_delta_verify,
+    .get_crc32    = NULL,
 }};
 
 static void on_dfu_start(uint8_t number_of_components)
@@ -137,6 +142,40 @@ static void on_dfu_failure(t_boot_dfu_component_id_t component_id, int error_cod
     update_state = UPDATE_STATE_FAIL;
 }
 
+// The checkpoint of an interrupted update is kept in the RTC backup registers, BKP0R is the boot request
+#define DFU_CHECKPOINT_MAGIC 0x7B0C4B00u
+
+static void on_dfu_checkpoint_save(const t_boot_dfu_checkpoint_t *p_checkpoint)
+{
+    // Invalid while the registers are updated
+    RTC->BKP1R = 0;
+    if (p_checkpoint->offset == 0)
+    {
+        return;
+    }
+
+    RTC->BKP2R = p_checkpoint->fw_size;
+    RTC->BKP3R = p_checkpoint->fw_crc32;
+    RTC->BKP4R = p_checkpoint->offset;
+    RTC->BKP1R = DFU_CHECKPOINT_MAGIC | p_checkpoint->component_id;
+}
+
+static bool on_dfu_checkpoint_load(t_boot_dfu_checkpoint_t *p_checkpoint)
+{
+    uint32_t bkup_1 = RTC->BKP1R;
+
+    if ((bkup_1 & 0xFFFFFF00u) != DFU_CHECKPOINT_MAGIC)
+    {
+        return false;
+    }
+
+    p_checkpoint->component_id = (uint8_t) bkup_1;
+    p_checkpoint->fw_size      = RTC->BKP2R;
+    p_checkpoint->fw_crc32     = RTC->BKP3R;
+    p_checkpoint->offset       = RTC->BKP4R;
+    return true;
+}
+
 static const t_boot_config_t t_boot_config = {
     .p_dfu_target_list        = t_boot_dfu_target_list,
     .dfu_target_list_size     = sizeof(t_boot_dfu_target_list) / sizeof(t_boot_dfu_target_t),
@@ -145,6 +184,8 @@ static const t_boot_config_t t_boot_config = {
     .update_component_done_fn = on_dfu_component_done,
     .update_successful_fn     = on_dfu_complete,
     .update_error_fn          = on_dfu_failure,
+    .checkpoint_save_fn       = on_dfu_checkpoint_save,
+    .checkpoint_load_fn       = on_dfu_checkpoint_load,
 };
 
 #define LEDS_OFF   0x00, 0x00, 0x00
@@ -235,6 +276,10 @@ static void run_bootloader(void)
 
     board_link_io_expander_setup_for_normal_operation();
 
+    // Also needed when the application is invalid, e.g. after an interrupted update
+    __HAL_RCC_PWR_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+
     t_boot_dfu_init(&t_boot_config);
 
     board_link_usb_switch_init();
@@ -262,6 +307,9 @@ static void run_bootloader(void)
 
     while (1)
     {
+        // Programs the DFU chunks the USB interrupt has queued, while the host sends the next one
+        usbd_storage_process();
+
         static uint32_t tick = 0;
         if (get_systick() - tick > 10)
         {
@@ -275,80 +323,65 @@ usb_err:
     APP_ASSERT(false);
 }
 
-static bool is_application_valid(void)
+static struct
 {
-    volatile const uint32_t *app_vector    = (volatile const uint32_t *) APPLICATION_FLASH_ADDRESS;
-    uint32_t                 stack_pointer = app_vector[0];
-    uint32_t                 app_entry     = app_vector[1];
+    uint32_t              clock_us;   // HAL and clock initialized
+    t_boot_app_timing_t   checks;     // see t_boot_app_decide
+    t_boot_app_decision_t decision;
+} boot_timing;
 
-    log_trace("app addr 0x%x - 0x%x", APPLICATION_FLASH_ADDRESS, APPLICATION_FLASH_ADDRESS + APPLICATION_FLASH_SIZE);
-    log_trace("stack pointer: 0x%x, app_entry: 0x%x", stack_pointer, app_entry);
-
-    // Stack pointer should be in RAM region
-    if (((*(__IO uint32_t *) APPLICATION_FLASH_ADDRESS) & 0x2FFE0000) != 0x20000000)
-    {
-        return false;
-    }
+// Time since HAL_Init, the startup code before it isn't included
+static uint32_t get_boot_time_us(void)
+{
+    uint32_t ms, value;
 
-    if ((app_entry < APPLICATION_FLASH_ADDRESS) || (app_entry >= APPLICATION_FLASH_ADDRESS + APPLICATION_FLASH_SIZE))
+    do
     {
-        log_error("Invalid app entry point 0x%08X", app_entry);
-        return false;
-    }
+        ms    = HAL_GetTick();
+        value = SysTick->VAL;
+    } while (ms != HAL_GetTick());
 
-    log_highlight("Application valid: App entry 0x%08X", app_entry);
-    return true;
+    return ms * 1000u + (SysTick->LOAD - value) / (SystemCoreClock / 1000000u);
 }
 
-bool should_start_bootloader(void)
+static t_boot_app_reset_t get_reset_reason(void)
 {
-    if (is_application_valid() == false)
-    {
-        log_err("Application invalid");
-        return true;
-    }
-
-    // Enable backup registers to examine the reset reason
-    __HAL_RCC_PWR_CLK_ENABLE();
-    HAL_PWR_EnableBkUpAccess();
-
     if (__HAL_RCC_GET_FLAG(RCC_FLAG_PORRST))
     {
-        // Power on reset
+        return T_BOOT_APP_RESET_POWER_ON;
     }
-    else if (__HAL_RCC_GET_FLAG(RCC_FLAG_SFTRST))
+    if (__HAL_RCC_GET_FLAG(RCC_FLAG_SFTRST))
     {
-        // Check Softreset reason in Backup registers
-        uint32_t bkup_0 = RTC->BKP0R;
-        log_high("backup register: 0x%x", bkup_0);
-        if (bkup_0 == 0xCAFEBEEF)
-        {
-            log_debug("Application requested bootloader");
-            RTC->BKP0R = 0;
-            return true;
-        }
-        else if (bkup_0 == 0x0)
-        {
-            RTC->BKP0R = 0;
-            return false;
-        }
+        return T_BOOT_APP_RESET_SOFTWARE;
     }
-    else if (__HAL_RCC_GET_FLAG(RCC_FLAG_IWDGRST))
+    if (__HAL_RCC_GET_FLAG(RCC_FLAG_IWDGRST) || __HAL_RCC_GET_FLAG(RCC_FLAG_WWDGRST))
     {
-        // Independent watchdog reset
-    }
-    else if (__HAL_RCC_GET_FLAG(RCC_FLAG_LPWRRST))
-    {
-        // Low power reset
-    }
-    else if (__HAL_RCC_GET_FLAG(RCC_FLAG_WWDGRST))
-    {
-        // Window watchdog reset
+        return T_BOOT_APP_RESET_WATCHDOG;
     }
+    return T_BOOT_APP_RESET_OTHER;
+}
+
+static bool should_start_bootloader(void)
+{
+    // Enable backup registers to examine the reset reason
+    __HAL_RCC_PWR_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+
+    const t_boot_app_state_t state = {
+        .reset          = get_reset_reason(),
+        .p_boot_request = &RTC->BKP0R,
+        .update_pending = (RTC->BKP1R & 0xFFFFFF00u) == DFU_CHECKPOINT_MAGIC,
+        .p_image        = (const uint32_t *) APPLICATION_FLASH_ADDRESS,
+        .image_address  = APPLICATION_FLASH_ADDRESS,
+        .image_max_size = APPLICATION_FLASH_SIZE,
+        .get_time_us    = get_boot_time_us,
+    };
+
+    boot_timing.decision = t_boot_app_decide(&state, &boot_timing.checks);
 
     __HAL_RCC_CLEAR_RESET_FLAGS();
 
-    return false;
+    return boot_timing.decision != T_BOOT_APP_START;
 }
 
 uint32_t logger_get_timestamp()
@@ -362,8 +395,17 @@ int main(void)
 
     __HAL_RCC_SYSCFG_CLK_ENABLE();
 
+    // Also speeds up the image CRC check
     SystemClock_Config();
 
+    boot_timing.clock_us = get_boot_time_us();
+
+    // Decided before anything the application doesn't need is initialized
+    if (!should_start_bootloader())
+    {
+        jump_to_application(APPLICATION_FLASH_ADDRESS);
+    }
+
     bsp_debug_uart_init();
 
     const char *version = "\r\nMYNDBootloader - v" VERSION_FIRMWARE_STRING "\r\n";
@@ -373,15 +415,11 @@ int main(void)
         __io_putchar(version[i]);
     }
 
-    if (should_start_bootloader())
-    {
-        run_bootloader();
-    }
-    else
-    {
-        log_info("Starting application...");
-        jump_to_application(APPLICATION_FLASH_ADDRESS);
-    }
+    log_info("Staying in bootloader: %s", t_boot_app_get_decision_desc(boot_timing.decision));
+    log_info("Boot timing: clock %d us, checks %d us, CRC %d bytes in %d us", boot_timing.clock_us,
+             boot_timing.checks.checks_us, boot_timing.checks.crc_bytes, boot_timing.checks.crc_us);
+
+    run_bootloader();
 }
 
 /**
@@ -15,4 +15,9 @@
 #define T_BOOT_ENCRYPTION_KEY           "TEUFELDEV"
 
 #define T_BOOT_DFU_NON_SEQUENTIAL_MODE  1
+
+#define T_BOOT_DFU_COMPRESSION          1
+
+// Images with a trailer from add_trailer.py are checked before they are started
+#define T_BOOT_APP_CRC_CHECK            1
 // clang-format on
\ No newline at end of file